@@ -26,6 +26,7 @@ bool firstCall = true;
 Ptr<OutputStreamWrapper> rttStream;
 Ptr<OutputStreamWrapper> cwndStream;
 Ptr<OutputStreamWrapper> thputStream;
+Ptr<OutputStreamWrapper> migrationStream;
 
 // graph plotting
 void
@@ -85,6 +86,13 @@ TraceCwnd (std::string cwnd_tr_file_name)
 	}
 }
 
+// for data-plane stall logging of UE contexts migrated by PGW scaling
+void
+MigrationTracer (uint64_t imsi, Time stall, uint32_t released)
+{
+	*migrationStream->GetStream() << Simulator::Now().GetSeconds() << ", " << imsi << ", " << stall.GetSeconds() << ", " << released << std::endl;
+}
+
 // for throughput logging of each connection
 void
 CalcThroughput (Ptr<Application> sinkApp, int lastTotalRx, int node)
@@ -92,27 +100,8 @@ CalcThroughput (Ptr<Application> sinkApp, int lastTotalRx, int node)
 	Ptr<PacketSink> sink = DynamicCast<PacketSink> (sinkApp);
 	Time currTime = Simulator::Now();
 	
-	DoubleValue doubleValue;
-	GlobalValue::GetValueByName ("scalingDelay", doubleValue);
-	double scalingDelay = doubleValue.Get();
-	double delay = 1;
-
-	if (scalingDelay > 0) {
-		Time t_delay = Time(std::to_string(scalingDelay) + "s");
-		TimeValue timeValue;
-		GlobalValue::GetValueByName ("scalingTime", timeValue);
-
-		Time scalingTime = timeValue.Get();
-		Time endTime = scalingTime + t_delay;
-
-		
-		if ((currTime >= scalingTime) && (currTime < endTime)) {
-			Time addedDelay = (endTime - currTime);
-			delay += addedDelay.GetSeconds();
-		}
-	}
-	
-	double throughput = ((sink->GetTotalRx() - lastTotalRx) / delay) * (double)(8/1e6);
+	// scaling stalls the PGW data plane itself, so the goodput is measured as is
+	double throughput = (sink->GetTotalRx() - lastTotalRx) * (double)(8/1e6);
 	lastTotalRx = sink->GetTotalRx();
 
 	if (firstCall) {
@@ -125,18 +114,6 @@ CalcThroughput (Ptr<Application> sinkApp, int lastTotalRx, int node)
 	Simulator::Schedule(Seconds(1), &CalcThroughput, sinkApp, lastTotalRx, node);
 }
 
-void setFlowWeight(void)
-{
-  std::string filePath = "ovs_weight.txt";
-
-  std::ofstream writeFile(filePath.data());
-  if (writeFile.is_open()) {
-    writeFile << "10\n";
-    writeFile << "10\n";
-    writeFile.close();
-  }
-}
-
 int
 main (int argc, char *argv[])
 {
@@ -158,8 +135,6 @@ main (int argc, char *argv[])
   std::string topoInput ("input/virt-5gc-toposample.input");
   std::string vmInput ("input/virt-5gc-vminput-heavy.input");
 
-  setFlowWeight();
-  
   Virt5gcHelper virt5gcHelp;
   virt5gcHelp.SetFileType (format);
   virt5gcHelp.SetTopoFile (topoInput);
@@ -188,6 +163,11 @@ main (int argc, char *argv[])
   Ptr<OvsPointToPointEpcHelper> epcHelper = virt5gcHelper->GetEpcHelper();
   Ptr<Node> pgw = epcHelper->GetPgwNode ();
 
+  AsciiTraceHelper migrationAscii;
+  migrationStream = migrationAscii.CreateFileStream ("Virt5gc-migration.data");
+  *migrationStream->GetStream() << "# Time Imsi Stall Released" << std::endl;
+  epcHelper->GetSgwPgwApplication ()->TraceConnectWithoutContext ("MigrationStall", MakeCallback (&MigrationTracer));
+
    // Create a single RemoteHost
   NodeContainer remoteHostContainer;
   remoteHostContainer.Create (1);
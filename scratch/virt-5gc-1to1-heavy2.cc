@@ -43,6 +43,7 @@ bool firstCall = true;
 Ptr<OutputStreamWrapper> rttStream;
 Ptr<OutputStreamWrapper> cwndStream;
 Ptr<OutputStreamWrapper> thputStream;
+Ptr<OutputStreamWrapper> migrationStream;
 
 /*
 static void
@@ -239,33 +240,21 @@ TraceCwnd (std::string cwnd_tr_file_name)
 	}
 }
 
+// for data-plane stall logging of UE contexts migrated by PGW scaling
+void
+MigrationTracer (uint64_t imsi, Time stall, uint32_t released)
+{
+	*migrationStream->GetStream() << Simulator::Now().GetSeconds() << ", " << imsi << ", " << stall.GetSeconds() << ", " << released << std::endl;
+}
+
 void
 CalcThroughput (Ptr<Application> sinkApp, int lastTotalRx, int node)
 {
 	Ptr<PacketSink> sink = DynamicCast<PacketSink> (sinkApp);
 	Time currTime = Simulator::Now();
 	
-	DoubleValue doubleValue;
-	GlobalValue::GetValueByName ("scalingDelay", doubleValue);
-	double scalingDelay = doubleValue.Get();
-	double delay = 1;
-
-	if (scalingDelay > 0) {
-		Time t_delay = Time(std::to_string(scalingDelay) + "s");
-		TimeValue timeValue;
-		GlobalValue::GetValueByName ("scalingTime", timeValue);
-
-		Time scalingTime = timeValue.Get();
-		Time endTime = scalingTime + t_delay;
-
-		
-		if ((currTime >= scalingTime) && (currTime < endTime)) {
-			Time addedDelay = (endTime - currTime);
-			delay += addedDelay.GetSeconds();
-		}
-	}
-	
-	double throughput = ((sink->GetTotalRx() - lastTotalRx) / delay) * (double)(8/1e6);
+	// scaling stalls the PGW data plane itself, so the goodput is measured as is
+	double throughput = (sink->GetTotalRx() - lastTotalRx) * (double)(8/1e6);
 	lastTotalRx = sink->GetTotalRx();
 
 /*
@@ -279,18 +268,6 @@ CalcThroughput (Ptr<Application> sinkApp, int lastTotalRx, int node)
 	Simulator::Schedule(MilliSeconds(1000), &CalcThroughput, sinkApp, lastTotalRx, node);
 }
 
-void setFlowWeight(void)
-{
-  std::string filePath = "ovs_weight.txt";
-
-  std::ofstream writeFile(filePath.data());
-  if (writeFile.is_open()) {
-    writeFile << "10\n";
-    writeFile << "10\n";
-    writeFile.close();
-  }
-}
-
 int
 main (int argc, char *argv[])
 {
@@ -315,8 +292,6 @@ main (int argc, char *argv[])
   std::string topoInput ("input/virt-5gc-toposample.input");
   std::string vmInput ("input/virt-5gc-vminput-heavy.input");
 
-  setFlowWeight();
-  
   Virt5gcHelper virt5gcHelp;
   virt5gcHelp.SetFileType (format);
   virt5gcHelp.SetTopoFile (topoInput);
@@ -346,6 +321,11 @@ main (int argc, char *argv[])
   Ptr<OvsPointToPointEpcHelper> epcHelper = virt5gcHelper->GetEpcHelper();
   Ptr<Node> pgw = epcHelper->GetPgwNode ();
 
+  AsciiTraceHelper migrationAscii;
+  migrationStream = migrationAscii.CreateFileStream ("Virt5gc-migration.data");
+  *migrationStream->GetStream() << "# Time Imsi Stall Released" << std::endl;
+  epcHelper->GetSgwPgwApplication ()->TraceConnectWithoutContext ("MigrationStall", MakeCallback (&MigrationTracer));
+
    // Create a single RemoteHost
   NodeContainer remoteHostContainer;
   remoteHostContainer.Create (1);
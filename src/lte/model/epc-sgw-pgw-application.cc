@@ -31,6 +31,11 @@
 #include "ns3/inet-socket-address.h"
 #include "ns3/epc-gtpu-header.h"
 #include "ns3/abort.h"
+#include "ns3/udp-l4-protocol.h"
+#include "ns3/tcp-l4-protocol.h"
+#include "ns3/simulator.h"
+#include "ns3/enum.h"
+#include "ns3/uinteger.h"
 
 namespace ns3 {
 
@@ -42,8 +47,12 @@ NS_LOG_COMPONENT_DEFINE ("EpcSgwPgwApplication");
 
 
 EpcSgwPgwApplication::UeInfo::UeInfo ()
+  : m_flowCacheHits (0),
+    m_imsi (0),
+    m_workerId (0)
 {
   NS_LOG_FUNCTION (this);
+  FlushFlowCache ();
 }
 
 void
@@ -51,24 +60,63 @@ EpcSgwPgwApplication::UeInfo::AddBearer (Ptr<EpcTft> tft, uint8_t bearerId, uint
 {
   NS_LOG_FUNCTION (this << tft << teid);
   m_teidByBearerIdMap[bearerId] = teid;
+  FlushFlowCache ();
   return m_tftClassifier.Add (tft, teid);
 }
 
-void
+uint32_t
 EpcSgwPgwApplication::UeInfo::RemoveBearer (uint8_t bearerId)
 {
   NS_LOG_FUNCTION (this << bearerId);
-  m_teidByBearerIdMap.erase (bearerId);
+  std::map<uint8_t, uint32_t>::iterator it = m_teidByBearerIdMap.find (bearerId);
+  if (it == m_teidByBearerIdMap.end ())
+    {
+      return 0;
+    }
+  uint32_t teid = it->second;
+  m_teidByBearerIdMap.erase (it);
+  // the TEID may be reused by another bearer
+  m_tftClassifier.Delete (teid);
+  FlushFlowCache ();
+  return teid;
 }
 
 uint32_t
-EpcSgwPgwApplication::UeInfo::Classify (Ptr<Packet> p)
+EpcSgwPgwApplication::UeInfo::Classify (const EpcTftClassifier::FiveTuple &tuple)
 {
-  NS_LOG_FUNCTION (this << p);
+  NS_LOG_FUNCTION (this);
   // we hardcode DOWNLINK direction since the PGW is espected to
   // classify only downlink packets (uplink packets will go to the
   // internet without any classification). 
-  return m_tftClassifier.Classify (p, EpcTft::DOWNLINK);
+  uint32_t hash = tuple.source ^ tuple.destination
+    ^ ((uint32_t) tuple.sourcePort << 16 | tuple.destinationPort) ^ ((uint32_t) tuple.protocol << 8 | tuple.tos);
+  FlowCacheEntry &entry = m_flowCache[((hash * 2654435761u) >> 16) % FLOW_CACHE_SIZE];
+  if (entry.valid && entry.tuple == tuple)
+    {
+      NS_LOG_LOGIC ("flow cache hit, TEID " << entry.teid);
+      m_flowCacheHits++;
+      return entry.teid;
+    }
+
+  entry.tuple = tuple;
+  entry.valid = true;
+  entry.teid = m_tftClassifier.Classify (tuple, EpcTft::DOWNLINK);
+  return entry.teid;
+}
+
+uint64_t
+EpcSgwPgwApplication::UeInfo::GetFlowCacheHits () const
+{
+  return m_flowCacheHits;
+}
+
+void
+EpcSgwPgwApplication::UeInfo::FlushFlowCache ()
+{
+  for (uint32_t i = 0; i < FLOW_CACHE_SIZE; i++)
+    {
+      m_flowCache[i].valid = false;
+    }
 }
 
 Ipv4Address 
@@ -95,6 +143,50 @@ EpcSgwPgwApplication::UeInfo::SetUeAddr (Ipv4Address ueAddr)
   m_ueAddr = ueAddr;
 }
 
+uint64_t
+EpcSgwPgwApplication::UeInfo::GetImsi ()
+{
+  return m_imsi;
+}
+
+void
+EpcSgwPgwApplication::UeInfo::SetImsi (uint64_t imsi)
+{
+  m_imsi = imsi;
+}
+
+uint32_t
+EpcSgwPgwApplication::UeInfo::GetWorkerId ()
+{
+  return m_workerId;
+}
+
+void
+EpcSgwPgwApplication::UeInfo::SetWorkerId (uint32_t workerId)
+{
+  m_workerId = workerId;
+}
+
+uint32_t
+EpcSgwPgwApplication::UeInfo::GetSerializedSize () const
+{
+  // IMSI, UE IPv4 address, eNB S1-U IPv4 address
+  uint32_t size = 8 + 4 + 4;
+  for (std::map<uint8_t, uint32_t>::const_iterator it = m_teidByBearerIdMap.begin ();
+       it != m_teidByBearerIdMap.end ();
+       ++it)
+    {
+      // EPS bearer ID, F-TEID (TEID and IPv4 address), bearer QoS IE (TS 29.274)
+      size += 1 + 8 + 22;
+      Ptr<EpcTft> tft = m_tftClassifier.GetTft (it->second);
+      if (tft != 0)
+        {
+          size += tft->GetSerializedSize ();
+        }
+    }
+  return size;
+}
+
 /////////////////////////
 // EpcSgwPgwApplication
 /////////////////////////
@@ -105,7 +197,49 @@ EpcSgwPgwApplication::GetTypeId (void)
 {
   static TypeId tid = TypeId ("ns3::EpcSgwPgwApplication")
     .SetParent<Object> ()
-    .SetGroupName("Lte");
+    .SetGroupName("Lte")
+    .AddAttribute ("MigrationPolicy",
+                   "Treatment of the packets of a UE whose context is being migrated "
+                   "to another SGW/PGW instance",
+                   EnumValue (MIGRATION_BUFFER),
+                   MakeEnumAccessor (&EpcSgwPgwApplication::m_migrationPolicy),
+                   MakeEnumChecker (MIGRATION_BUFFER, "Buffer",
+                                    MIGRATION_DROP, "Drop"))
+    .AddAttribute ("MaxMigrationBufferSize",
+                   "Maximum number of packets held for each migrating UE "
+                   "(packets beyond this limit are dropped)",
+                   UintegerValue (1000),
+                   MakeUintegerAccessor (&EpcSgwPgwApplication::m_maxMigrationBufferSize),
+                   MakeUintegerChecker<uint32_t> ())
+    .AddTraceSource ("MigrationQueueDepth",
+                     "Number of packets held for migrating UEs",
+                     MakeTraceSourceAccessor (&EpcSgwPgwApplication::m_migrationQueueDepth),
+                     "ns3::TracedValueCallback::Uint32")
+    .AddTraceSource ("MigrationStall",
+                     "The migration of a UE context ended",
+                     MakeTraceSourceAccessor (&EpcSgwPgwApplication::m_migrationStallTrace),
+                     "ns3::EpcSgwPgwApplication::MigrationStallTracedCallback")
+    .AddTraceSource ("MigrationDrop",
+                     "A packet of a migrating UE was dropped",
+                     MakeTraceSourceAccessor (&EpcSgwPgwApplication::m_migrationDropTrace),
+                     "ns3::EpcSgwPgwApplication::MigrationDropTracedCallback")
+    .AddTraceSource ("WorkerQueue",
+                     "The number of packets at a worker instance changed",
+                     MakeTraceSourceAccessor (&EpcSgwPgwApplication::m_workerQueueTrace),
+                     "ns3::EpcSgwPgwApplication::WorkerQueueTracedCallback")
+    .AddTraceSource ("WorkerDelay",
+                     "A worker instance processed a packet",
+                     MakeTraceSourceAccessor (&EpcSgwPgwApplication::m_workerDelayTrace),
+                     "ns3::EpcSgwPgwApplication::WorkerDelayTracedCallback")
+    .AddTraceSource ("WorkerDrop",
+                     "A packet was dropped at a full worker instance",
+                     MakeTraceSourceAccessor (&EpcSgwPgwApplication::m_workerDropTrace),
+                     "ns3::EpcSgwPgwApplication::WorkerDropTracedCallback")
+    .AddTraceSource ("WorkerChange",
+                     "A UE was moved to another worker instance",
+                     MakeTraceSourceAccessor (&EpcSgwPgwApplication::m_workerChangeTrace),
+                     "ns3::EpcSgwPgwApplication::WorkerChangeTracedCallback")
+    ;
   return tid;
 }
 
@@ -115,6 +249,21 @@ EpcSgwPgwApplication::DoDispose ()
   NS_LOG_FUNCTION (this);
   m_s1uSocket->SetRecvCallback (MakeNullCallback<void, Ptr<Socket> > ());
   m_s1uSocket = 0;
+  for (std::map<uint64_t, MigrationInfo>::iterator it = m_migrationByImsiMap.begin ();
+       it != m_migrationByImsiMap.end ();
+       ++it)
+    {
+      it->second.endEvent.Cancel ();
+    }
+  m_migrationByImsiMap.clear ();
+  for (std::map<uint32_t, Worker>::iterator it = m_workers.begin ();
+       it != m_workers.end ();
+       ++it)
+    {
+      it->second.serviceEvent.Cancel ();
+    }
+  m_workers.clear ();
+  m_orphanPackets.clear ();
   delete (m_s11SapSgw);
 }
 
@@ -125,7 +274,9 @@ EpcSgwPgwApplication::EpcSgwPgwApplication (const Ptr<VirtualNetDevice> tunDevic
     m_tunDevice (tunDevice),
     m_gtpuUdpPort (2152), // fixed by the standard
     m_teidCount (0),
-    m_s11SapMme (0)
+    m_s11SapMme (0),
+    m_migrationQueueDepth (0),
+    m_lastWorkerId (0)
 {
   NS_LOG_FUNCTION (this << tunDevice << s1uSocket);
   m_s1uSocket->SetRecvCallback (MakeCallback (&EpcSgwPgwApplication::RecvFromS1uSocket, this));
@@ -144,11 +295,15 @@ EpcSgwPgwApplication::RecvFromTunDevice (Ptr<Packet> packet, const Address& sour
 {
   NS_LOG_FUNCTION (this << source << dest << packet << packet->GetSize ());
 
-  // get IP address of UE
-  Ptr<Packet> pCopy = packet->Copy ();
-  Ipv4Header ipv4Header;
-  pCopy->RemoveHeader (ipv4Header);
-  Ipv4Address ueAddr =  ipv4Header.GetDestination ();
+  // get IP address of UE, reading the headers in place once for the
+  // lookup of the UE and the classification
+  EpcTftClassifier::FiveTuple tuple;
+  if (!EpcTftClassifier::ReadFiveTuple (packet, tuple))
+    {
+      NS_LOG_WARN ("packet too short for its IPv4 and transport headers");
+      return true;
+    }
+  Ipv4Address ueAddr (tuple.destination);
   NS_LOG_LOGIC ("packet addressed to UE " << ueAddr);
 
   // find corresponding UeInfo address
@@ -156,19 +311,20 @@ EpcSgwPgwApplication::RecvFromTunDevice (Ptr<Packet> packet, const Address& sour
   if (it == m_ueInfoByAddrMap.end ())
     {        
       NS_LOG_WARN ("unknown UE address " << ueAddr);
+      return true;
+    }
+  uint32_t teid = it->second->Classify (tuple);
+  if (teid == 0)
+    {
+      NS_LOG_WARN ("no matching bearer for this packet");
+    }
+  else if (!m_migrationByImsiMap.empty () && IsMigrating (it->second->GetImsi ()))
+    {
+      EnqueueMigrating (packet, it->second->GetImsi (), EpcTft::DOWNLINK, teid);
     }
   else
     {
-      Ipv4Address enbAddr = it->second->GetEnbAddr ();      
-      uint32_t teid = it->second->Classify (packet);   
-      if (teid == 0)
-        {
-          NS_LOG_WARN ("no matching bearer for this packet");                   
-        }
-      else
-        {
-          SendToS1uSocket (packet, enbAddr, teid);
-        }
+      Dispatch (packet, it->second, EpcTft::DOWNLINK, teid);
     }
   // there is no reason why we should notify the TUN
   // VirtualNetDevice that he failed to send the packet: if we receive
@@ -192,7 +348,26 @@ EpcSgwPgwApplication::RecvFromS1uSocket (Ptr<Socket> socket)
   //SocketAddressTag tag;
   //packet->RemovePacketTag (tag);
 
-  SendToTunDevice (packet, teid);
+  if (m_migrationByImsiMap.empty () && m_workers.empty ())
+    {
+      SendToTunDevice (packet, teid);
+      return;
+    }
+
+  std::map<uint32_t, Ptr<UeInfo> >::iterator it = m_ueInfoByTeidMap.find (teid);
+  if (it == m_ueInfoByTeidMap.end ())
+    {
+      NS_LOG_WARN ("unknown TEID " << teid);
+      SendToTunDevice (packet, teid);
+    }
+  else if (IsMigrating (it->second->GetImsi ()))
+    {
+      EnqueueMigrating (packet, it->second->GetImsi (), EpcTft::UPLINK, teid);
+    }
+  else
+    {
+      Dispatch (packet, it->second, EpcTft::UPLINK, teid);
+    }
 }
 
 void 
@@ -246,6 +421,13 @@ EpcSgwPgwApplication::AddUe (uint64_t imsi)
 {
   NS_LOG_FUNCTION (this << imsi);
   Ptr<UeInfo> ueInfo = Create<UeInfo> ();
+  ueInfo->SetImsi (imsi);
+  if (!m_workers.empty ())
+    {
+      uint32_t workerId = GetLeastLoadedWorker ();
+      ueInfo->SetWorkerId (workerId);
+      m_workers[workerId].nUes++;
+    }
   m_ueInfoByImsiMap[imsi] = ueInfo;
 }
 
@@ -259,6 +441,428 @@ EpcSgwPgwApplication::SetUeAddress (uint64_t imsi, Ipv4Address ueAddr)
   ueit->second->SetUeAddr (ueAddr);
 }
 
+std::list<uint64_t>
+EpcSgwPgwApplication::GetUeImsis () const
+{
+  std::list<uint64_t> imsis;
+  for (std::map<uint64_t, Ptr<UeInfo> >::const_iterator it = m_ueInfoByImsiMap.begin ();
+       it != m_ueInfoByImsiMap.end ();
+       ++it)
+    {
+      imsis.push_back (it->first);
+    }
+  return imsis;
+}
+
+bool
+EpcSgwPgwApplication::IsMigrating (uint64_t imsi) const
+{
+  return m_migrationByImsiMap.find (imsi) != m_migrationByImsiMap.end ();
+}
+
+void
+EpcSgwPgwApplication::StartMigration (std::list<uint64_t> imsiList, Time duration)
+{
+  NS_LOG_FUNCTION (this << imsiList.size () << duration);
+  for (std::list<uint64_t>::iterator imsiIt = imsiList.begin ();
+       imsiIt != imsiList.end ();
+       ++imsiIt)
+    {
+      StartMigration (*imsiIt, duration);
+    }
+}
+
+void
+EpcSgwPgwApplication::StartMigration (uint64_t imsi, Time duration)
+{
+  NS_LOG_FUNCTION (this << imsi << duration);
+  NS_ASSERT_MSG (m_ueInfoByImsiMap.find (imsi) != m_ueInfoByImsiMap.end (), "unknown IMSI " << imsi);
+  std::map<uint64_t, MigrationInfo>::iterator it = m_migrationByImsiMap.find (imsi);
+  if (it == m_migrationByImsiMap.end ())
+    {
+      NS_LOG_LOGIC ("stalling UE " << imsi << " for " << duration.GetSeconds () << " s");
+      MigrationInfo info;
+      info.start = Simulator::Now ();
+      info.endEvent = Simulator::Schedule (duration, &EpcSgwPgwApplication::EndMigration, this, imsi);
+      m_migrationByImsiMap[imsi] = info;
+    }
+  else if (Simulator::GetDelayLeft (it->second.endEvent) < duration)
+    {
+      // the UE is already migrating: extend its migration window
+      NS_LOG_LOGIC ("extending the migration of UE " << imsi);
+      it->second.endEvent.Cancel ();
+      it->second.endEvent = Simulator::Schedule (duration, &EpcSgwPgwApplication::EndMigration, this, imsi);
+    }
+}
+
+uint32_t
+EpcSgwPgwApplication::GetUeContextSize (uint64_t imsi) const
+{
+  std::map<uint64_t, Ptr<UeInfo> >::const_iterator it = m_ueInfoByImsiMap.find (imsi);
+  if (it == m_ueInfoByImsiMap.end ())
+    {
+      NS_LOG_WARN ("unknown IMSI " << imsi);
+      return 0;
+    }
+  return it->second->GetSerializedSize ();
+}
+
+uint64_t
+EpcSgwPgwApplication::GetFlowCacheHits (uint64_t imsi) const
+{
+  std::map<uint64_t, Ptr<UeInfo> >::const_iterator it = m_ueInfoByImsiMap.find (imsi);
+  if (it == m_ueInfoByImsiMap.end ())
+    {
+      return 0;
+    }
+  return it->second->GetFlowCacheHits ();
+}
+
+void
+EpcSgwPgwApplication::EnqueueMigrating (Ptr<Packet> packet, uint64_t imsi, EpcTft::Direction direction,
+                                        uint32_t teid, bool atFront)
+{
+  NS_LOG_FUNCTION (this << packet << imsi << direction << teid << atFront);
+  std::map<uint64_t, MigrationInfo>::iterator it = m_migrationByImsiMap.find (imsi);
+  NS_ASSERT (it != m_migrationByImsiMap.end ());
+  if (m_migrationPolicy == MIGRATION_DROP
+      || it->second.buffer.size () >= m_maxMigrationBufferSize)
+    {
+      NS_LOG_LOGIC ("dropping packet of migrating UE " << imsi);
+      m_migrationDropTrace (packet, imsi);
+      return;
+    }
+  MigratingPacket mp;
+  mp.packet = packet;
+  mp.direction = direction;
+  mp.teid = teid;
+  if (atFront)
+    {
+      it->second.buffer.push_front (mp);
+    }
+  else
+    {
+      it->second.buffer.push_back (mp);
+    }
+  m_migrationQueueDepth++;
+}
+
+void
+EpcSgwPgwApplication::EndMigration (uint64_t imsi)
+{
+  NS_LOG_FUNCTION (this << imsi);
+  std::map<uint64_t, MigrationInfo>::iterator it = m_migrationByImsiMap.find (imsi);
+  NS_ASSERT (it != m_migrationByImsiMap.end ());
+  Time stall = Simulator::Now () - it->second.start;
+  std::list<MigratingPacket> buffer;
+  buffer.swap (it->second.buffer);
+  m_migrationByImsiMap.erase (it);
+  uint32_t released = buffer.size ();
+  m_migrationQueueDepth -= released;
+
+  // the UE context is now served again: release the held packets in
+  // their arrival order
+  std::map<uint64_t, Ptr<UeInfo> >::iterator ueit = m_ueInfoByImsiMap.find (imsi);
+  NS_ASSERT_MSG (ueit != m_ueInfoByImsiMap.end (), "unknown IMSI " << imsi);
+  for (std::list<MigratingPacket>::iterator pit = buffer.begin (); pit != buffer.end (); ++pit)
+    {
+      Dispatch (pit->packet, ueit->second, pit->direction, pit->teid);
+    }
+  m_migrationStallTrace (imsi, stall, released);
+}
+
+void
+EpcSgwPgwApplication::Forward (Ptr<Packet> packet, Ptr<UeInfo> ueInfo, EpcTft::Direction direction,
+                               uint32_t teid)
+{
+  if (direction == EpcTft::DOWNLINK)
+    {
+      SendToS1uSocket (packet, ueInfo->GetEnbAddr (), teid);
+    }
+  else
+    {
+      SendToTunDevice (packet, teid);
+    }
+}
+
+void
+EpcSgwPgwApplication::Dispatch (Ptr<Packet> packet, Ptr<UeInfo> ueInfo, EpcTft::Direction direction,
+                                uint32_t teid)
+{
+  NS_LOG_FUNCTION (this << packet << ueInfo->GetImsi () << direction << teid);
+  if (m_workers.empty ())
+    {
+      Forward (packet, ueInfo, direction, teid);
+      return;
+    }
+
+  std::map<uint32_t, Worker>::iterator wit = m_workers.find (ueInfo->GetWorkerId ());
+  if (wit == m_workers.end ())
+    {
+      uint32_t workerId = GetLeastLoadedWorker ();
+      NS_LOG_LOGIC ("assigning UE " << ueInfo->GetImsi () << " to worker " << workerId);
+      ueInfo->SetWorkerId (workerId);
+      wit = m_workers.find (workerId);
+      wit->second.nUes++;
+    }
+
+  Worker &worker = wit->second;
+  // the packet at the head of the queue is the one being processed
+  if (!worker.queue.empty () && worker.queue.size () - 1 >= worker.maxQueueSize)
+    {
+      NS_LOG_LOGIC ("worker " << wit->first << " full, dropping packet");
+      m_workerDropTrace (packet, wit->first);
+      return;
+    }
+
+  WorkerPacket wp;
+  wp.packet = packet;
+  wp.ueInfo = ueInfo;
+  wp.direction = direction;
+  wp.teid = teid;
+  wp.arrival = Simulator::Now ();
+  worker.queue.push_back (wp);
+  m_workerQueueTrace (wit->first, worker.queue.size ());
+  if (worker.queue.size () == 1)
+    {
+      StartWorkerService (wit->first);
+    }
+}
+
+void
+EpcSgwPgwApplication::StartWorkerService (uint32_t workerId)
+{
+  std::map<uint32_t, Worker>::iterator wit = m_workers.find (workerId);
+  NS_ASSERT (wit != m_workers.end () && !wit->second.queue.empty ());
+  Time serviceTime = wit->second.processingRate.CalculateBytesTxTime (wit->second.queue.front ().packet->GetSize ());
+  wit->second.serviceEvent = Simulator::Schedule (serviceTime, &EpcSgwPgwApplication::EndWorkerService, this, workerId);
+}
+
+void
+EpcSgwPgwApplication::EndWorkerService (uint32_t workerId)
+{
+  NS_LOG_FUNCTION (this << workerId);
+  std::map<uint32_t, Worker>::iterator wit = m_workers.find (workerId);
+  NS_ASSERT (wit != m_workers.end () && !wit->second.queue.empty ());
+  WorkerPacket wp = wit->second.queue.front ();
+  wit->second.queue.pop_front ();
+  m_workerDelayTrace (workerId, Simulator::Now () - wp.arrival);
+  m_workerQueueTrace (workerId, wit->second.queue.size ());
+  Time forwardingDelay = wit->second.forwardingDelay;
+  if (!wit->second.queue.empty ())
+    {
+      StartWorkerService (workerId);
+    }
+  // the way to the worker and back in one go: the delay is the same for
+  // all the packets of the worker, so they stay in order, and a packet
+  // already processed is forwarded even if the worker is removed meanwhile
+  if (forwardingDelay.IsZero ())
+    {
+      Forward (wp.packet, wp.ueInfo, wp.direction, wp.teid);
+    }
+  else
+    {
+      Simulator::Schedule (forwardingDelay, &EpcSgwPgwApplication::Forward, this,
+                           wp.packet, wp.ueInfo, wp.direction, wp.teid);
+    }
+}
+
+uint32_t
+EpcSgwPgwApplication::GetLeastLoadedWorker () const
+{
+  NS_ASSERT (!m_workers.empty ());
+  std::map<uint32_t, Worker>::const_iterator best = m_workers.begin ();
+  for (std::map<uint32_t, Worker>::const_iterator it = m_workers.begin ();
+       it != m_workers.end ();
+       ++it)
+    {
+      if (it->second.nUes < best->second.nUes)
+        {
+          best = it;
+        }
+    }
+  return best->first;
+}
+
+uint32_t
+EpcSgwPgwApplication::AddWorker (DataRate processingRate, uint32_t maxQueueSize)
+{
+  NS_LOG_FUNCTION (this << processingRate << maxQueueSize);
+  uint32_t workerId = ++m_lastWorkerId;
+  Worker worker;
+  worker.processingRate = processingRate;
+  worker.maxQueueSize = maxQueueSize;
+  worker.forwardingDelay = Seconds (0);
+  worker.nUes = 0;
+  m_workers[workerId] = worker;
+  return workerId;
+}
+
+void
+EpcSgwPgwApplication::SetWorkerForwardingDelay (uint32_t workerId, Time delay)
+{
+  NS_LOG_FUNCTION (this << workerId << delay);
+  std::map<uint32_t, Worker>::iterator wit = m_workers.find (workerId);
+  NS_ASSERT_MSG (wit != m_workers.end (), "unknown worker " << workerId);
+  wit->second.forwardingDelay = delay;
+}
+
+std::list<uint64_t>
+EpcSgwPgwApplication::RemoveWorker (uint32_t workerId)
+{
+  NS_LOG_FUNCTION (this << workerId);
+  std::map<uint32_t, Worker>::iterator wit = m_workers.find (workerId);
+  NS_ASSERT_MSG (wit != m_workers.end (), "unknown worker " << workerId);
+  wit->second.serviceEvent.Cancel ();
+
+  // the packets waiting at the removed worker (including the one being
+  // processed) are handed over after the caller had the chance to stall
+  // the moved UEs
+  if (m_orphanPackets.empty () && !wit->second.queue.empty ())
+    {
+      Simulator::ScheduleNow (&EpcSgwPgwApplication::HandOverOrphanPackets, this);
+    }
+  m_orphanPackets.insert (m_orphanPackets.end (), wit->second.queue.begin (), wit->second.queue.end ());
+  m_workers.erase (wit);
+
+  return RebalanceWorkers ();
+}
+
+void
+EpcSgwPgwApplication::HandOverOrphanPackets ()
+{
+  NS_LOG_FUNCTION (this << m_orphanPackets.size ());
+  std::deque<WorkerPacket> queue;
+  queue.swap (m_orphanPackets);
+
+  // the packets of a migrating UE go ahead of the ones it received since
+  // the removal, so they are held from the last one
+  std::list<WorkerPacket> dispatched;
+  for (std::deque<WorkerPacket>::reverse_iterator pit = queue.rbegin (); pit != queue.rend (); ++pit)
+    {
+      if (IsMigrating (pit->ueInfo->GetImsi ()))
+        {
+          EnqueueMigrating (pit->packet, pit->ueInfo->GetImsi (), pit->direction, pit->teid, true);
+        }
+      else
+        {
+          dispatched.push_front (*pit);
+        }
+    }
+  for (std::list<WorkerPacket>::iterator pit = dispatched.begin (); pit != dispatched.end (); ++pit)
+    {
+      Dispatch (pit->packet, pit->ueInfo, pit->direction, pit->teid);
+    }
+}
+
+std::list<uint64_t>
+EpcSgwPgwApplication::RebalanceWorkers ()
+{
+  NS_LOG_FUNCTION (this);
+  std::list<uint64_t> moved;
+  if (m_workers.empty ())
+    {
+      for (std::map<uint64_t, Ptr<UeInfo> >::iterator it = m_ueInfoByImsiMap.begin ();
+           it != m_ueInfoByImsiMap.end ();
+           ++it)
+        {
+          uint32_t workerId = it->second->GetWorkerId ();
+          if (workerId != 0)
+            {
+              it->second->SetWorkerId (0);
+              moved.push_back (it->first);
+              m_workerChangeTrace (it->first, workerId, 0);
+            }
+        }
+      return moved;
+    }
+
+  // keep the UEs on their current worker, then place the orphaned ones
+  std::map<uint32_t, std::list<Ptr<UeInfo> > > uesByWorker;
+  std::list<Ptr<UeInfo> > orphans;
+  std::map<uint64_t, uint32_t> previousWorker;
+  for (std::map<uint32_t, Worker>::iterator wit = m_workers.begin (); wit != m_workers.end (); ++wit)
+    {
+      uesByWorker[wit->first];
+      wit->second.nUes = 0;
+    }
+  for (std::map<uint64_t, Ptr<UeInfo> >::iterator it = m_ueInfoByImsiMap.begin ();
+       it != m_ueInfoByImsiMap.end ();
+       ++it)
+    {
+      uint32_t workerId = it->second->GetWorkerId ();
+      previousWorker[it->first] = workerId;
+      if (m_workers.find (workerId) != m_workers.end ())
+        {
+          uesByWorker[workerId].push_back (it->second);
+          m_workers[workerId].nUes++;
+        }
+      else
+        {
+          orphans.push_back (it->second);
+        }
+    }
+  for (std::list<Ptr<UeInfo> >::iterator it = orphans.begin (); it != orphans.end (); ++it)
+    {
+      uint32_t workerId = GetLeastLoadedWorker ();
+      (*it)->SetWorkerId (workerId);
+      uesByWorker[workerId].push_back (*it);
+      m_workers[workerId].nUes++;
+    }
+
+  // move UEs from the most to the least loaded worker until balanced
+  while (true)
+    {
+      uint32_t minId = GetLeastLoadedWorker ();
+      uint32_t maxId = minId;
+      for (std::map<uint32_t, Worker>::iterator wit = m_workers.begin (); wit != m_workers.end (); ++wit)
+        {
+          if (wit->second.nUes > m_workers[maxId].nUes)
+            {
+              maxId = wit->first;
+            }
+        }
+      if (m_workers[maxId].nUes <= m_workers[minId].nUes + 1)
+        {
+          break;
+        }
+      Ptr<UeInfo> ueInfo = uesByWorker[maxId].back ();
+      uesByWorker[maxId].pop_back ();
+      m_workers[maxId].nUes--;
+      ueInfo->SetWorkerId (minId);
+      uesByWorker[minId].push_back (ueInfo);
+      m_workers[minId].nUes++;
+    }
+
+  for (std::map<uint64_t, Ptr<UeInfo> >::iterator it = m_ueInfoByImsiMap.begin ();
+       it != m_ueInfoByImsiMap.end ();
+       ++it)
+    {
+      uint32_t from = previousWorker[it->first];
+      if (it->second->GetWorkerId () != from)
+        {
+          moved.push_back (it->first);
+          m_workerChangeTrace (it->first, from, it->second->GetWorkerId ());
+        }
+    }
+  NS_LOG_LOGIC (moved.size () << " UEs moved over " << m_workers.size () << " workers");
+  return moved;
+}
+
+uint32_t
+EpcSgwPgwApplication::GetNWorkers () const
+{
+  return m_workers.size ();
+}
+
+uint32_t
+EpcSgwPgwApplication::GetWorkerOfUe (uint64_t imsi) const
+{
+  std::map<uint64_t, Ptr<UeInfo> >::const_iterator it = m_ueInfoByImsiMap.find (imsi);
+  NS_ASSERT_MSG (it != m_ueInfoByImsiMap.end (), "unknown IMSI " << imsi);
+  return it->second->GetWorkerId ();
+}
+
 void 
 EpcSgwPgwApplication::DoCreateSessionRequest (EpcS11SapSgw::CreateSessionRequestMessage req)
 {
@@ -284,6 +888,7 @@ EpcSgwPgwApplication::DoCreateSessionRequest (EpcS11SapSgw::CreateSessionRequest
       NS_ABORT_IF (m_teidCount == 0xFFFFFFFF);
       uint32_t teid = ++m_teidCount;  
       ueit->second->AddBearer (bit->tft, bit->epsBearerId, teid);
+      m_ueInfoByTeidMap[teid] = ueit->second;
 
       EpcS11SapMme::BearerContextCreated bearerContext;
       bearerContext.sgwFteid.teid = teid;
@@ -352,7 +957,8 @@ EpcSgwPgwApplication::DoDeleteBearerResponse (EpcS11SapSgw::DeleteBearerResponse
        ++bit)
     {
       //Function to remove de-activated bearer contexts from S-Gw and P-Gw side
-      ueit->second->RemoveBearer (bit->epsBearerId);
+      uint32_t teid = ueit->second->RemoveBearer (bit->epsBearerId);
+      m_ueInfoByTeidMap.erase (teid);
     }
 }
 
@@ -36,7 +36,13 @@
 #include <ns3/application.h>
 #include <ns3/epc-s1ap-sap.h>
 #include <ns3/epc-s11-sap.h>
+#include <ns3/nstime.h>
+#include <ns3/event-id.h>
+#include <ns3/traced-value.h>
+#include <ns3/data-rate.h>
 #include <map>
+#include <list>
+#include <deque>
 
 namespace ns3 {
 
@@ -51,6 +57,16 @@ class EpcSgwPgwApplication : public Application
 
 public:
 
+  /**
+   * Treatment of the user-plane packets of a UE context while the
+   * context is being migrated to another SGW/PGW instance.
+   */
+  enum MigrationPolicy
+  {
+    MIGRATION_BUFFER = 0, ///< hold the packets and release them when the migration ends
+    MIGRATION_DROP = 1    ///< discard the packets received during the migration
+  };
+
   // inherited from Object
   static TypeId GetTypeId (void);
   virtual void DoDispose ();
@@ -150,6 +166,169 @@ public:
    */
   void SetUeAddress (uint64_t imsi, Ipv4Address ueAddr);
 
+  /**
+   * Stall the data plane of a set of UE contexts while they are migrated
+   * to another SGW/PGW instance (e.g., upon a scale-in/scale-out of the
+   * virtualized core). Until the migration ends, uplink and downlink
+   * packets of these UEs are buffered or dropped according to the
+   * MigrationPolicy attribute. If a UE is already migrating, its
+   * migration window is extended.
+   *
+   * \param imsiList the IMSIs of the migrating UE contexts
+   * \param duration the duration of the migration
+   */
+  void StartMigration (std::list<uint64_t> imsiList, Time duration);
+
+  /**
+   * Stall the data plane of a single UE context while it is migrated.
+   *
+   * \param imsi the IMSI of the migrating UE context
+   * \param duration the duration of the migration
+   */
+  void StartMigration (uint64_t imsi, Time duration);
+
+  /**
+   * \param imsi the unique identifier of the UE
+   * \return the size in bytes of the session state of the UE (identity,
+   * addresses, and the F-TEID, bearer QoS and TFT of each bearer), as it
+   * would be serialized to move the UE to another SGW/PGW instance, or 0
+   * if the UE is unknown to this SGW/PGW
+   */
+  uint32_t GetUeContextSize (uint64_t imsi) const;
+
+  /**
+   * \param imsi the unique identifier of the UE
+   * \return the number of downlink packets of the UE classified from the
+   * cache of its flows, or 0 if the UE is unknown to this SGW/PGW
+   */
+  uint64_t GetFlowCacheHits (uint64_t imsi) const;
+
+  /**
+   * \param imsi the unique identifier of the UE
+   * \return true if the context of the UE is currently being migrated
+   */
+  bool IsMigrating (uint64_t imsi) const;
+
+  /**
+   * \return the IMSIs of all the UEs known to this SGW/PGW
+   */
+  std::list<uint64_t> GetUeImsis () const;
+
+  /**
+   * TracedCallback signature for the end of a migration.
+   *
+   * \param [in] imsi the IMSI of the migrated UE
+   * \param [in] stall the time the UE data plane was stalled
+   * \param [in] released the number of buffered packets released
+   */
+  typedef void (* MigrationStallTracedCallback)
+    (uint64_t imsi, Time stall, uint32_t released);
+
+  /**
+   * TracedCallback signature for packets dropped during a migration.
+   *
+   * \param [in] packet the dropped packet
+   * \param [in] imsi the IMSI of the migrating UE
+   */
+  typedef void (* MigrationDropTracedCallback)
+    (Ptr<const Packet> packet, uint64_t imsi);
+
+  /**
+   * Add a worker instance to this SGW/PGW (e.g., one per VM of a
+   * horizontally scaled PGW). Once at least one worker exists, each UE is
+   * served by one worker, which processes the UE packets one at a time at
+   * its processing rate and holds the waiting ones in a bounded FIFO
+   * queue. Without workers the packets are forwarded instantaneously.
+   * New UEs are assigned to the least loaded worker, while the existing
+   * ones are moved only by RebalanceWorkers.
+   *
+   * \param processingRate the packet processing rate of the worker
+   * \param maxQueueSize the maximum number of packets waiting at the worker
+   * \return the identifier of the new worker
+   */
+  uint32_t AddWorker (DataRate processingRate, uint32_t maxQueueSize);
+
+  /**
+   * Set the time the packets of a worker instance take to reach it and
+   * come back, e.g., through the aggregation switches when the VM of the
+   * worker is on another rack than the one of the S1-U and SGi links. It
+   * delays the forwarding of the packets the worker processed, and is
+   * zero for a new worker.
+   *
+   * \param workerId the identifier of the worker
+   * \param delay the forwarding delay of the worker
+   */
+  void SetWorkerForwardingDelay (uint32_t workerId, Time delay);
+
+  /**
+   * Remove a worker instance. Its UEs are redistributed over the
+   * remaining workers, which also take over its waiting packets. The
+   * packets are handed over once the calling event ends, so that the
+   * migration the caller starts for the moved UEs holds them too, ahead of
+   * the packets received during the migration.
+   *
+   * \param workerId the identifier of the worker
+   * \return the IMSIs of the UEs moved to another worker
+   */
+  std::list<uint64_t> RemoveWorker (uint32_t workerId);
+
+  /**
+   * Evenly redistribute the UEs over the workers, moving as few UEs as
+   * possible.
+   *
+   * \return the IMSIs of the UEs moved to another worker
+   */
+  std::list<uint64_t> RebalanceWorkers ();
+
+  /**
+   * \return the number of worker instances
+   */
+  uint32_t GetNWorkers () const;
+
+  /**
+   * \param imsi the unique identifier of the UE
+   * \return the identifier of the worker serving the UE, 0 if none
+   */
+  uint32_t GetWorkerOfUe (uint64_t imsi) const;
+
+  /**
+   * TracedCallback signature for the queue of a worker instance.
+   *
+   * \param [in] workerId the identifier of the worker
+   * \param [in] depth the number of packets waiting at the worker
+   */
+  typedef void (* WorkerQueueTracedCallback)
+    (uint32_t workerId, uint32_t depth);
+
+  /**
+   * TracedCallback signature for the sojourn time of a packet at a worker.
+   *
+   * \param [in] workerId the identifier of the worker
+   * \param [in] delay the queueing plus processing delay of the packet,
+   *                   without the forwarding delay of the worker
+   */
+  typedef void (* WorkerDelayTracedCallback)
+    (uint32_t workerId, Time delay);
+
+  /**
+   * TracedCallback signature for packets dropped at a full worker.
+   *
+   * \param [in] packet the dropped packet
+   * \param [in] workerId the identifier of the worker
+   */
+  typedef void (* WorkerDropTracedCallback)
+    (Ptr<const Packet> packet, uint32_t workerId);
+
+  /**
+   * TracedCallback signature for a UE moved to another worker.
+   *
+   * \param [in] imsi the IMSI of the UE
+   * \param [in] from the identifier of the previous worker, 0 if none
+   * \param [in] to the identifier of the new worker, 0 if none
+   */
+  typedef void (* WorkerChangeTracedCallback)
+    (uint64_t imsi, uint32_t from, uint32_t to);
+
 private:
 
   // S11 SAP SGW methods
@@ -179,19 +358,29 @@ public:
     /** 
      * \brief Function, deletes contexts of bearer on SGW and PGW side
      * \param bearerId, the Bearer Id whose contexts to be removed
+     * \return the TEID of the removed bearer, 0 if the bearer is unknown
      */
-    void RemoveBearer (uint8_t bearerId);
+    uint32_t RemoveBearer (uint8_t bearerId);
 
     /**
      * 
      * 
-     * \param p the IP packet from the internet to be classified
+     * \param tuple the fields of the IP packet from the internet to be
+     * classified, as read by EpcTftClassifier::ReadFiveTuple
      * 
      * \return the corresponding bearer ID > 0 identifying the bearer
      * among all the bearers of this UE;  returns 0 if no bearers
      * matches with the previously declared TFTs
+     *
+     * The result is cached for the flow of the packet (addresses,
+     * protocol, ports and TOS) until the bearers of the UE change.
+     */
+    uint32_t Classify (const EpcTftClassifier::FiveTuple &tuple);
+
+    /**
+     * \return the number of packets classified from the flow cache
      */
-    uint32_t Classify (Ptr<Packet> p);
+    uint64_t GetFlowCacheHits () const;
 
     /** 
      * \return the address of the eNB to which the UE is connected
@@ -217,15 +406,131 @@ public:
      */
     void SetUeAddr (Ipv4Address addr);
 
+    /**
+     * \return the IMSI of the UE
+     */
+    uint64_t GetImsi ();
+
+    /**
+     * set the IMSI of the UE
+     *
+     * \param imsi the unique identifier of the UE
+     */
+    void SetImsi (uint64_t imsi);
+
+    /**
+     * \return the identifier of the worker serving the UE, 0 if none
+     */
+    uint32_t GetWorkerId ();
+
+    /**
+     * set the worker serving the UE
+     *
+     * \param workerId the identifier of the worker
+     */
+    void SetWorkerId (uint32_t workerId);
+
+    /**
+     * \return the size in bytes of the serialized session state of the UE
+     */
+    uint32_t GetSerializedSize () const;
+
 
   private:
+    /**
+     * Invalidate the cached classification of the flows of the UE
+     */
+    void FlushFlowCache ();
+
+    /// a downlink flow of the UE and the TEID of its bearer
+    struct FlowCacheEntry
+    {
+      EpcTftClassifier::FiveTuple tuple;
+      bool valid;
+      uint32_t teid;
+    };
+
+    /// number of entries of the direct mapped flow cache
+    static const uint32_t FLOW_CACHE_SIZE = 16;
+
     EpcTftClassifier m_tftClassifier;
+    FlowCacheEntry m_flowCache[FLOW_CACHE_SIZE];
+    uint64_t m_flowCacheHits;
     Ipv4Address m_enbAddr;
     Ipv4Address m_ueAddr;
+    uint64_t m_imsi;
+    uint32_t m_workerId;
     std::map<uint8_t, uint32_t> m_teidByBearerIdMap;
   };
 
 
+  /**
+   * Hold (or drop) a packet of a migrating UE
+   *
+   * \param packet the packet
+   * \param imsi the IMSI of the migrating UE
+   * \param direction the direction of the packet
+   * \param teid the TEID of the bearer of the packet
+   * \param atFront hold the packet ahead of the packets already held
+   */
+  void EnqueueMigrating (Ptr<Packet> packet, uint64_t imsi, EpcTft::Direction direction,
+                         uint32_t teid, bool atFront = false);
+
+  /**
+   * End the migration of a UE context and release its buffered packets
+   *
+   * \param imsi the IMSI of the migrated UE
+   */
+  void EndMigration (uint64_t imsi);
+
+  /**
+   * Forward a packet, through the worker serving its UE if any
+   *
+   * \param packet the packet
+   * \param ueInfo the context of the UE
+   * \param direction the direction of the packet
+   * \param teid the TEID of the bearer of the packet
+   */
+  void Dispatch (Ptr<Packet> packet, Ptr<UeInfo> ueInfo, EpcTft::Direction direction,
+                 uint32_t teid);
+
+  /**
+   * Forward a packet without going through a worker: an uplink packet
+   * to the TUN device, a downlink packet to the eNB serving the UE
+   *
+   * \param packet the packet
+   * \param ueInfo the context of the UE
+   * \param direction the direction of the packet
+   * \param teid the TEID of the bearer of the packet
+   */
+  void Forward (Ptr<Packet> packet, Ptr<UeInfo> ueInfo, EpcTft::Direction direction,
+                uint32_t teid);
+
+  /**
+   * Start processing the packet at the head of the queue of a worker
+   *
+   * \param workerId the identifier of the worker
+   */
+  void StartWorkerService (uint32_t workerId);
+
+  /**
+   * Forward the packet processed by a worker and serve the next one
+   *
+   * \param workerId the identifier of the worker
+   */
+  void EndWorkerService (uint32_t workerId);
+
+  /**
+   * Hand the packets of the removed workers over to the workers of their
+   * UEs, or hold them ahead of the other packets of a migrating UE
+   */
+  void HandOverOrphanPackets ();
+
+  /**
+   * \return the identifier of the worker serving the fewest UEs
+   */
+  uint32_t GetLeastLoadedWorker () const;
+
  /**
   * UDP socket to send and receive GTP-U packets to and from the S1-U interface
   */
@@ -273,6 +578,114 @@ public:
   };
 
   std::map<uint16_t, EnbInfo> m_enbInfoByCellId;
+
+  /**
+   * Map telling for each S1-U TEID the info of the UE owning the bearer
+   */
+  std::map<uint32_t, Ptr<UeInfo> > m_ueInfoByTeidMap;
+
+  /**
+   * A packet held while the context of its UE is migrated
+   */
+  struct MigratingPacket
+  {
+    Ptr<Packet> packet;           ///< the packet
+    EpcTft::Direction direction;  ///< the direction of the packet
+    uint32_t teid;                ///< the TEID of its bearer
+  };
+
+  /**
+   * State of a UE context being migrated
+   */
+  struct MigrationInfo
+  {
+    Time start;                         ///< time the data plane was stalled
+    EventId endEvent;                   ///< event ending the migration
+    std::list<MigratingPacket> buffer;  ///< packets held during the migration
+  };
+
+  /**
+   * Map telling for each migrating IMSI its migration state
+   */
+  std::map<uint64_t, MigrationInfo> m_migrationByImsiMap;
+
+  MigrationPolicy m_migrationPolicy; ///< the MigrationPolicy attribute
+  uint32_t m_maxMigrationBufferSize; ///< the MaxMigrationBufferSize attribute
+
+  /**
+   * Number of packets currently held for migrating UEs
+   */
+  TracedValue<uint32_t> m_migrationQueueDepth;
+
+  /**
+   * Trace fired when the migration of a UE context ends
+   */
+  TracedCallback<uint64_t, Time, uint32_t> m_migrationStallTrace;
+
+  /**
+   * Trace fired when a packet of a migrating UE is dropped
+   */
+  TracedCallback<Ptr<const Packet>, uint64_t> m_migrationDropTrace;
+
+  /**
+   * A packet waiting at (or processed by) a worker instance
+   */
+  struct WorkerPacket
+  {
+    Ptr<Packet> packet;  ///< the packet
+    Ptr<UeInfo> ueInfo;           ///< the context of the UE
+    EpcTft::Direction direction;  ///< the direction of the packet
+    uint32_t teid;                ///< the TEID of its bearer
+    Time arrival;                 ///< time the packet reached the worker
+  };
+
+  /**
+   * A SGW/PGW worker instance with a finite processing rate
+   */
+  struct Worker
+  {
+    DataRate processingRate;         ///< packet processing rate
+    uint32_t maxQueueSize;           ///< maximum number of waiting packets
+    Time forwardingDelay;            ///< time to reach the worker and back
+    uint32_t nUes;                   ///< number of UEs served
+    std::deque<WorkerPacket> queue;  ///< waiting packets, head is in service
+    EventId serviceEvent;            ///< end of the current service
+  };
+
+  /**
+   * Map telling for each worker identifier the worker state
+   */
+  std::map<uint32_t, Worker> m_workers;
+
+  /**
+   * identifier of the last worker created
+   */
+  uint32_t m_lastWorkerId;
+
+  /**
+   * Packets of the removed workers, waiting to be handed over
+   */
+  std::deque<WorkerPacket> m_orphanPackets;
+
+  /**
+   * Trace fired when the queue of a worker changes
+   */
+  TracedCallback<uint32_t, uint32_t> m_workerQueueTrace;
+
+  /**
+   * Trace fired when a worker has processed a packet
+   */
+  TracedCallback<uint32_t, Time> m_workerDelayTrace;
+
+  /**
+   * Trace fired when a packet is dropped at a full worker
+   */
+  TracedCallback<Ptr<const Packet>, uint32_t> m_workerDropTrace;
+
+  /**
+   * Trace fired when a UE is moved to another worker
+   */
+  TracedCallback<uint64_t, uint32_t, uint32_t> m_workerChangeTrace;
 };
 
 } //namespace ns3
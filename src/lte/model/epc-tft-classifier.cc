@@ -30,9 +30,6 @@
 #include "epc-tft.h"
 #include "ns3/log.h"
 #include "ns3/packet.h"
-#include "ns3/ipv4-header.h"
-#include "ns3/udp-header.h"
-#include "ns3/tcp-header.h"
 #include "ns3/udp-l4-protocol.h"
 #include "ns3/tcp-l4-protocol.h"
 
@@ -40,6 +37,41 @@ namespace ns3 {
 
 NS_LOG_COMPONENT_DEFINE ("EpcTftClassifier");
 
+EpcTftClassifier::CompiledFilter::CompiledFilter (uint32_t id, const EpcTft::PacketFilter &f)
+  : tftId (id),
+    remoteAddress (f.remoteAddress.Get () & f.remoteMask.Get ()),
+    remoteMask (f.remoteMask.Get ()),
+    localAddress (f.localAddress.Get () & f.localMask.Get ()),
+    localMask (f.localMask.Get ()),
+    remotePortStart (f.remotePortStart),
+    remotePortEnd (f.remotePortEnd),
+    localPortStart (f.localPortStart),
+    localPortEnd (f.localPortEnd),
+    typeOfService (f.typeOfService & f.typeOfServiceMask),
+    typeOfServiceMask (f.typeOfServiceMask)
+{
+}
+
+bool
+EpcTftClassifier::CompiledFilter::Matches (uint32_t ra, uint32_t la, uint16_t rp, uint16_t lp, uint8_t tos) const
+{
+  return (ra & remoteMask) == remoteAddress
+         && (la & localMask) == localAddress
+         && rp >= remotePortStart && rp <= remotePortEnd
+         && lp >= localPortStart && lp <= localPortEnd
+         && (tos & typeOfServiceMask) == typeOfService;
+}
+
+
+bool
+EpcTftClassifier::FiveTuple::operator== (const FiveTuple &other) const
+{
+  return source == other.source && destination == other.destination
+         && sourcePort == other.sourcePort && destinationPort == other.destinationPort
+         && protocol == other.protocol && tos == other.tos;
+}
+
+
 EpcTftClassifier::EpcTftClassifier ()
 {
   NS_LOG_FUNCTION (this);
@@ -51,6 +83,8 @@ EpcTftClassifier::Add (Ptr<EpcTft> tft, uint32_t id)
   NS_LOG_FUNCTION (this << tft);
   
   m_tftMap[id] = tft;  
+  RemoveFilters (id);
+  InsertFilters (tft, id);
   
   // simple sanity check: there shouldn't be more than 16 bearers (hence TFTs) per UE
   NS_ASSERT (m_tftMap.size () <= 16);
@@ -61,6 +95,65 @@ EpcTftClassifier::Delete (uint32_t id)
 {
   NS_LOG_FUNCTION (this << id);
   m_tftMap.erase (id);
+  RemoveFilters (id);
+}
+
+Ptr<EpcTft>
+EpcTftClassifier::GetTft (uint32_t id) const
+{
+  std::map <uint32_t, Ptr<EpcTft> >::const_iterator it = m_tftMap.find (id);
+  if (it == m_tftMap.end ())
+    {
+      return 0;
+    }
+  return it->second;
+}
+
+void
+EpcTftClassifier::InsertFilters (Ptr<EpcTft> tft, uint32_t id)
+{
+  std::list<EpcTft::PacketFilter> filters = tft->GetPacketFilters ();
+  std::vector<CompiledFilter> *lists[2] = { &m_uplinkFilters, &m_downlinkFilters };
+  EpcTft::Direction directions[2] = { EpcTft::UPLINK, EpcTft::DOWNLINK };
+  for (uint32_t i = 0; i < 2; i++)
+    {
+      // the filters of a TFT go before those of the TFTs with lower ids
+      std::vector<CompiledFilter>::iterator pos = lists[i]->begin ();
+      while (pos != lists[i]->end () && pos->tftId > id)
+        {
+          ++pos;
+        }
+      std::vector<CompiledFilter> compiled;
+      for (std::list<EpcTft::PacketFilter>::const_iterator it = filters.begin (); it != filters.end (); ++it)
+        {
+          if (it->direction & directions[i])
+            {
+              compiled.push_back (CompiledFilter (id, *it));
+            }
+        }
+      lists[i]->insert (pos, compiled.begin (), compiled.end ());
+    }
+}
+
+void
+EpcTftClassifier::RemoveFilters (uint32_t id)
+{
+  std::vector<CompiledFilter> *lists[2] = { &m_uplinkFilters, &m_downlinkFilters };
+  for (uint32_t i = 0; i < 2; i++)
+    {
+      std::vector<CompiledFilter>::iterator it = lists[i]->begin ();
+      while (it != lists[i]->end ())
+        {
+          if (it->tftId == id)
+            {
+              it = lists[i]->erase (it);
+            }
+          else
+            {
+              ++it;
+            }
+        }
+    }
 }
 
  
@@ -68,94 +161,95 @@ uint32_t
 EpcTftClassifier::Classify (Ptr<Packet> p, EpcTft::Direction direction)
 {
   NS_LOG_FUNCTION (this << p << direction);
+  FiveTuple tuple;
+  if (!ReadFiveTuple (p, tuple))
+    {
+      return 0;
+    }
+  return Classify (tuple, direction);
+}
 
-  Ptr<Packet> pCopy = p->Copy ();
-
-  Ipv4Header ipv4Header;
-  pCopy->RemoveHeader (ipv4Header);
-
-  Ipv4Address localAddress;
-  Ipv4Address remoteAddress;
-
-  
-  if (direction ==  EpcTft::UPLINK)
+bool
+EpcTftClassifier::ReadFiveTuple (Ptr<const Packet> p, FiveTuple &tuple)
+{
+  uint8_t buf[64];
+  uint32_t size = p->CopyData (buf, sizeof (buf));
+  uint32_t ihl = (size > 0) ? (buf[0] & 0x0f) * 4 : 0;
+  if (size < 20 || ihl < 20)
     {
-      localAddress = ipv4Header.GetSource ();
-      remoteAddress = ipv4Header.GetDestination ();
+      NS_LOG_INFO ("Packet too short: " << size);
+      return false;
     }
-  else
-    { 
-      NS_ASSERT (direction ==  EpcTft::DOWNLINK);
-      remoteAddress = ipv4Header.GetSource ();
-      localAddress = ipv4Header.GetDestination ();      
+  tuple.tos = buf[1];
+  tuple.protocol = buf[9];
+  tuple.source = ((uint32_t) buf[12] << 24) | (buf[13] << 16) | (buf[14] << 8) | buf[15];
+  tuple.destination = ((uint32_t) buf[16] << 24) | (buf[17] << 16) | (buf[18] << 8) | buf[19];
+  tuple.sourcePort = 0;
+  tuple.destinationPort = 0;
+  if (tuple.protocol == UdpL4Protocol::PROT_NUMBER || tuple.protocol == TcpL4Protocol::PROT_NUMBER)
+    {
+      if (size < ihl + 4)
+        {
+          NS_LOG_INFO ("Packet too short: " << size);
+          return false;
+        }
+      // UDP and TCP both start with the source and destination ports
+      tuple.sourcePort = (buf[ihl] << 8) | buf[ihl + 1];
+      tuple.destinationPort = (buf[ihl + 2] << 8) | buf[ihl + 3];
     }
-  
-  uint8_t protocol = ipv4Header.GetProtocol ();
-
-  uint8_t tos = ipv4Header.GetTos ();
-
-  uint16_t localPort = 0;
-  uint16_t remotePort = 0;
+  return true;
+}
 
-  if (protocol == UdpL4Protocol::PROT_NUMBER)
+uint32_t
+EpcTftClassifier::Classify (const FiveTuple &tuple, EpcTft::Direction direction) const
+{
+  if (tuple.protocol != UdpL4Protocol::PROT_NUMBER && tuple.protocol != TcpL4Protocol::PROT_NUMBER)
     {
-      UdpHeader udpHeader;
-      pCopy->RemoveHeader (udpHeader);
-
-      if (direction ==  EpcTft::UPLINK)
-	{
-	  localPort = udpHeader.GetSourcePort ();
-	  remotePort = udpHeader.GetDestinationPort ();
-	}
-      else
-	{
-	  remotePort = udpHeader.GetSourcePort ();
-	  localPort = udpHeader.GetDestinationPort ();
-	}
+      NS_LOG_INFO ("Unknown protocol: " << (uint16_t) tuple.protocol);
+      return 0;  // no match
     }
-  else if (protocol == TcpL4Protocol::PROT_NUMBER)
+
+  uint32_t localAddress;
+  uint32_t remoteAddress;
+  uint16_t localPort;
+  uint16_t remotePort;
+  const std::vector<CompiledFilter> *filters;
+  if (direction ==  EpcTft::UPLINK)
     {
-      TcpHeader tcpHeader;
-      pCopy->RemoveHeader (tcpHeader);
-      if (direction ==  EpcTft::UPLINK)
-	{
-	  localPort = tcpHeader.GetSourcePort ();
-	  remotePort = tcpHeader.GetDestinationPort ();
-	}
-      else
-	{
-	  remotePort = tcpHeader.GetSourcePort ();
-	  localPort = tcpHeader.GetDestinationPort ();
-	}
+      localAddress = tuple.source;
+      remoteAddress = tuple.destination;
+      localPort = tuple.sourcePort;
+      remotePort = tuple.destinationPort;
+      filters = &m_uplinkFilters;
     }
   else
-    {
-      NS_LOG_INFO ("Unknown protocol: " << protocol);
-      return 0;  // no match
+    { 
+      NS_ASSERT (direction ==  EpcTft::DOWNLINK);
+      remoteAddress = tuple.source;
+      localAddress = tuple.destination;
+      remotePort = tuple.sourcePort;
+      localPort = tuple.destinationPort;
+      filters = &m_downlinkFilters;
     }
 
   NS_LOG_INFO ("Classifing packet:"
-	       << " localAddr="  << localAddress 
-	       << " remoteAddr=" << remoteAddress 
+	       << " localAddr="  << Ipv4Address (localAddress) 
+	       << " remoteAddr=" << Ipv4Address (remoteAddress) 
 	       << " localPort="  << localPort 
 	       << " remotePort=" << remotePort 
-	       << " tos=0x" << (uint16_t) tos );
+	       << " tos=0x" << (uint16_t) tuple.tos );
 
   // now it is possible to classify the packet!
-  // we use a reverse iterator since filter priority is not implemented properly.
-  // This way, since the default bearer is expected to be added first, it will be evaluated last.
-  std::map <uint32_t, Ptr<EpcTft> >::const_reverse_iterator it;
-  NS_LOG_LOGIC ("TFT MAP size: " << m_tftMap.size ());
-
-  for (it = m_tftMap.rbegin (); it != m_tftMap.rend (); ++it)
+  // The filters are sorted by decreasing TFT id, since filter priority is not
+  // implemented properly: the default bearer is expected to be added first,
+  // so it will be evaluated last.
+  NS_LOG_LOGIC ("TFT MAP size: " << m_tftMap.size () << ", filters: " << filters->size ());
+  for (std::vector<CompiledFilter>::const_iterator it = filters->begin (); it != filters->end (); ++it)
     {
-      NS_LOG_LOGIC ("TFT id: " << it->first );
-      NS_LOG_LOGIC (" Ptr<EpcTft>: " << it->second);
-      Ptr<EpcTft> tft = it->second;         
-      if (tft->Matches (direction, remoteAddress, localAddress, remotePort, localPort, tos))
+      if (it->Matches (remoteAddress, localAddress, remotePort, localPort, tuple.tos))
         {
-	  NS_LOG_LOGIC ("matches with TFT ID = " << it->first);
-	  return it->first; // the id of the matching TFT
+	  NS_LOG_LOGIC ("matches with TFT ID = " << it->tftId);
+	  return it->tftId; // the id of the matching TFT
         }
     }
   NS_LOG_LOGIC ("no match");
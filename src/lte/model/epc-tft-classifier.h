@@ -28,6 +28,7 @@
 #include "ns3/epc-tft.h"
 
 #include <map>
+#include <vector>
 
 
 namespace ns3 {
@@ -37,7 +38,12 @@ class Packet;
 
 /**
  * \brief classifies IP packets accoding to Traffic Flow Templates (TFTs)
- * 
+ *
+ * The packet filters of the TFTs are compiled when the TFTs are added,
+ * into one flat list per direction in the order of evaluation, and the
+ * packets are classified by reading their IPv4 and transport headers in
+ * place.
+ *
  * \note this implementation works with IPv4 only.
  */
 class EpcTftClassifier : public SimpleRefCount<EpcTftClassifier>
@@ -49,8 +55,10 @@ public:
   /** 
    * add a TFT to the Classifier
    * 
-   * \param tft the TFT to be added
-   * 
+   * \param tft the TFT to be added. Its packet filters are compiled now,
+   *        filters added to it afterwards are not seen by the classifier.
+   * \param id the identifier of the TFT. If a TFT is already added with
+   *        this identifier, it is replaced.
    */
   void Add (Ptr<EpcTft> tft, uint32_t id);
 
@@ -70,11 +78,99 @@ public:
    * \return the identifier (>0) of the first TFT that matches with the IP packet; 0 if no TFT matched.
    */
   uint32_t Classify (Ptr<Packet> p, EpcTft::Direction direction);
+
+  /**
+   * The fields of an IPv4 packet the packet filters match on
+   */
+  struct FiveTuple
+  {
+    uint32_t source;
+    uint32_t destination;
+    uint16_t sourcePort;       ///< 0 if neither UDP nor TCP
+    uint16_t destinationPort;  ///< 0 if neither UDP nor TCP
+    uint8_t protocol;
+    uint8_t tos;
+
+    bool operator== (const FiveTuple &other) const;
+  };
+
+  /**
+   * read the IPv4 header and the transport ports of an IP packet in
+   * place, without copying the packet
+   *
+   * \param p the IP packet. It is assumed that the outmost header is an IPv4 header.
+   * \param tuple the fields of the packet
+   *
+   * eturn false if the packet is too short for its IPv4 header, or for
+   * the ports of its UDP or TCP header
+   */
+  static bool ReadFiveTuple (Ptr<const Packet> p, FiveTuple &tuple);
+
+  /**
+   * classify an IP packet whose headers were already read
+   *
+   * \param tuple the fields of the packet, read by ReadFiveTuple
+   * \param direction the direction of the packet
+   *
+   * eturn the identifier (>0) of the first TFT that matches with the IP packet; 0 if no TFT matched.
+   */
+  uint32_t Classify (const FiveTuple &tuple, EpcTft::Direction direction) const;
+
+  /**
+   * \param id the identifier of the TFT
+   * \return the TFT, or 0 if no TFT has this identifier
+   */
+  Ptr<EpcTft> GetTft (uint32_t id) const;
   
 protected:
-  
+
+  /**
+   * A packet filter of a TFT, ready for matching: the addresses are
+   * masked and the filters are sorted in the order of evaluation
+   */
+  struct CompiledFilter
+  {
+    /**
+     * \param tftId the identifier of the TFT of the filter
+     * \param f the filter
+     */
+    CompiledFilter (uint32_t tftId, const EpcTft::PacketFilter &f);
+
+    /**
+     * \return true if the filter matches a packet with these fields
+     */
+    bool Matches (uint32_t ra, uint32_t la, uint16_t rp, uint16_t lp, uint8_t tos) const;
+
+    uint32_t tftId;
+    uint32_t remoteAddress;
+    uint32_t remoteMask;
+    uint32_t localAddress;
+    uint32_t localMask;
+    uint16_t remotePortStart;
+    uint16_t remotePortEnd;
+    uint16_t localPortStart;
+    uint16_t localPortEnd;
+    uint8_t typeOfService;
+    uint8_t typeOfServiceMask;
+  };
+
+  /**
+   * Insert the filters of a TFT in the filter lists
+   */
+  void InsertFilters (Ptr<EpcTft> tft, uint32_t id);
+
+  /**
+   * Remove the filters of a TFT from the filter lists
+   */
+  void RemoveFilters (uint32_t id);
+
   std::map <uint32_t, Ptr<EpcTft> > m_tftMap;
-  
+
+  // the filters by decreasing TFT id, since the default bearer is
+  // expected to be added first (filter priority is not implemented
+  // across TFTs), then in the order of the TFT
+  std::vector<CompiledFilter> m_uplinkFilters;
+  std::vector<CompiledFilter> m_downlinkFilters;
 };
 
 
@@ -191,5 +191,49 @@ EpcTft::Matches (Direction direction,
   return false;
 }
 
+uint32_t
+EpcTft::GetSerializedSize () const
+{
+  // IEI, length of the TFT IE, TFT operation code/E bit/number of filters
+  uint32_t size = 3;
+  for (std::list<PacketFilter>::const_iterator it = m_filters.begin ();
+       it != m_filters.end ();
+       ++it)
+    {
+      // packet filter identifier/direction, precedence, length of the contents
+      size += 3;
+      if (it->remoteMask.Get () != 0)
+        {
+          // component type, IPv4 address and mask
+          size += 9;
+        }
+      if (it->localMask.Get () != 0)
+        {
+          size += 9;
+        }
+      if (it->remotePortStart != 0 || it->remotePortEnd != 65535)
+        {
+          // component type and single port or port range
+          size += (it->remotePortStart == it->remotePortEnd) ? 3 : 5;
+        }
+      if (it->localPortStart != 0 || it->localPortEnd != 65535)
+        {
+          size += (it->localPortStart == it->localPortEnd) ? 3 : 5;
+        }
+      if (it->typeOfServiceMask != 0)
+        {
+          // component type, type of service and mask
+          size += 3;
+        }
+    }
+  return size;
+}
+
+std::list<EpcTft::PacketFilter>
+EpcTft::GetPacketFilters () const
+{
+  return m_filters;
+}
+
 
 } // namespace ns3
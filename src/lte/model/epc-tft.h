@@ -150,6 +150,18 @@ public:
 		  uint16_t localPort,
 		  uint8_t typeOfService);
 
+  /**
+   * \return the size of this TFT encoded as the Traffic Flow Template
+   * information element of 3GPP TS 24.008 (10.5.6.12), with only the
+   * packet filter components that are not wildcards
+   */
+  uint32_t GetSerializedSize () const;
+
+  /**
+   * \return the packet filters of this TFT, by increasing precedence
+   */
+  std::list<PacketFilter> GetPacketFilters () const;
+
 
 private:
 
@@ -2827,7 +2827,13 @@ UeManager::SetDuplicationMode(bool isEnableDupli){
 	for (std::map <uint8_t, Ptr<LteDataRadioBearerInfo> >::iterator it = m_drbMap.begin ();
 		        		       it != m_drbMap.end ();
 		        		       ++it)
-		      DynamicCast<McEnbPdcp>(it->second->m_pdcp)->SetPacketDuplicateMode(isEnableDupli); //sjkang0714
+		{
+		  Ptr<McEnbPdcp> pdcp = DynamicCast<McEnbPdcp> (it->second->m_pdcp);
+		  if (pdcp != 0)
+		    {
+		      pdcp->SetPacketDuplicateMode (isEnableDupli); //sjkang0714
+		    }
+		}
 }
 void
 UeManager::SetRlcBufferForwardMode(uint16_t targetCellID, bool option){
@@ -3008,6 +3014,18 @@ LteEnbRrc::GetTypeId (void)
                    DoubleValue (-25.0), /// original value is -5  sjkang1117
                    MakeDoubleAccessor (&LteEnbRrc::m_outageThreshold),
                    MakeDoubleChecker<long double> (-10000.0, 10.0))
+    .AddAttribute ("SinrTriggeredDuplication",
+                   "If true, the PDCP duplication of the bearers of a UE connected to "
+                   "two mmWave cells is activated while the SINR of one of them is "
+                   "below DuplicationSinrThreshold",
+                   BooleanValue (false),
+                   MakeBooleanAccessor (&LteEnbRrc::m_sinrTriggeredDuplication),
+                   MakeBooleanChecker ())
+    .AddAttribute ("DuplicationSinrThreshold",
+                   "SINR threshold for the PDCP duplication [dB]",
+                   DoubleValue (10.0),
+                   MakeDoubleAccessor (&LteEnbRrc::m_duplicationSinrThreshold),
+                   MakeDoubleChecker<long double> ())
 
     // Cell selection related attribute
     .AddAttribute ("QRxLevMin",
@@ -3308,6 +3326,18 @@ LteEnbRrc::GetUeManager (uint16_t rnti)
   return it->second;
 }
 
+bool
+LteEnbRrc::GetSinrTriggeredDuplication (long double sinrDb, long double sinrDb2, bool &duplicate) const
+{
+  NS_LOG_FUNCTION (this << (double) sinrDb << (double) sinrDb2);
+  if (!m_sinrTriggeredDuplication)
+    {
+      return false;
+    }
+  duplicate = std::min (sinrDb, sinrDb2) < m_duplicationSinrThreshold;
+  return true;
+}
+
 void 
 LteEnbRrc::RegisterImsiToRnti(uint64_t imsi, uint16_t rnti)
 {
@@ -4544,6 +4574,11 @@ LteEnbRrc::TriggerUeAssociationUpdate()
         		// m_x2SapProvider->DuplicateRlcBuffer(message);
 //        		 GetUeManager(GetRntiFromImsi(imsi))->SetDuplicationMode(true);
         		 }
+        	 bool duplicate;
+        	 if (GetSinrTriggeredDuplication (currentSinrDb, currentSinrDb_2, duplicate))
+        	   {
+        	     GetUeManager (GetRntiFromImsi (imsi))->SetDuplicationMode (duplicate);
+        	   }
 
         			/*
         			if (currentSinrDb <= 10 && currentSinrDb_2 >= 10 ){ //currentSinrDb_2 is 28G, currentSinrDb is 73G
@@ -842,6 +842,20 @@ uint16_t GetRntifromCellIDAndImsi[60][60];
    */
   Ptr<UeManager> GetUeManager (uint16_t rnti);
 
+  /**
+   * Decide the PDCP duplication of a UE connected to two mmWave cells from
+   * the SINRs of the cells, as configured by the SinrTriggeredDuplication
+   * and DuplicationSinrThreshold attributes
+   *
+   * \param sinrDb the SINR of the first mmWave cell [dB]
+   * \param sinrDb2 the SINR of the second mmWave cell [dB]
+   * \param duplicate set to true if the duplication is to be active
+   *
+   * \return false if the duplication is not switched by the SINRs, in
+   *         which case duplicate is left as it is
+   */
+  bool GetSinrTriggeredDuplication (long double sinrDb, long double sinrDb2, bool &duplicate) const;
+
   /**
    * \brief Add a new UE measurement reporting configuration
    * \param config the new reporting configuration
@@ -1580,6 +1594,9 @@ private:
 
   long double m_outageThreshold;
 
+  bool m_sinrTriggeredDuplication;
+  long double m_duplicationSinrThreshold;
+
   uint8_t m_fixedTttValue;
   uint8_t m_minDynTttValue;
   uint8_t m_maxDynTttValue;
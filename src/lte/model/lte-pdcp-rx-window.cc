@@ -0,0 +1,144 @@
+/* -*-  Mode: C++; c-file-style: "gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "ns3/log.h"
+#include "ns3/assert.h"
+
+#include "ns3/lte-pdcp-rx-window.h"
+
+namespace ns3 {
+
+NS_LOG_COMPONENT_DEFINE ("LtePdcpRxWindow");
+
+LtePdcpDuplicateFilter::LtePdcpDuplicateFilter (uint32_t snSpace)
+  : m_received (snSpace, false),
+    m_snSpace (snSpace),
+    m_highestSn (0),
+    m_started (false)
+{
+  NS_ASSERT_MSG (snSpace >= 2, "Invalid PDCP SN space " << snSpace);
+}
+
+bool
+LtePdcpDuplicateFilter::IsDuplicate (uint32_t sn)
+{
+  NS_ASSERT_MSG (sn < m_snSpace, "PDCP SN " << sn << " out of the SN space");
+  if (!m_started)
+    {
+      m_highestSn = sn;
+      m_started = true;
+    }
+
+  uint32_t ahead = (sn + m_snSpace - m_highestSn) % m_snSpace;
+  if (ahead > 0 && ahead <= m_snSpace / 2)
+    {
+      // the SNs that are now more than half the SN space behind belong
+      // to the previous HFN, forget them
+      uint32_t forget = m_highestSn + m_snSpace / 2;
+      for (uint32_t i = 1; i <= ahead; i++)
+        {
+          m_received[(forget + i) % m_snSpace] = false;
+        }
+      m_highestSn = sn;
+    }
+
+  if (m_received[sn])
+    {
+      NS_LOG_LOGIC ("duplicate PDCP SN " << sn);
+      return true;
+    }
+  m_received[sn] = true;
+  return false;
+}
+
+void
+LtePdcpDuplicateFilter::Reset ()
+{
+  m_received.assign (m_snSpace, false);
+  m_highestSn = 0;
+  m_started = false;
+}
+
+
+LtePdcpReorderingWindow::LtePdcpReorderingWindow (uint32_t snSpace)
+  : m_buffered (snSpace, false),
+    m_snSpace (snSpace),
+    m_nBuffered (0)
+{
+  NS_ASSERT_MSG (snSpace >= 2, "Invalid PDCP SN space " << snSpace);
+}
+
+uint32_t
+LtePdcpReorderingWindow::GetSnSpace () const
+{
+  return m_snSpace;
+}
+
+uint32_t
+LtePdcpReorderingWindow::GetNBuffered () const
+{
+  return m_nBuffered;
+}
+
+bool
+LtePdcpReorderingWindow::IsBuffered (uint32_t sn) const
+{
+  NS_ASSERT_MSG (sn < m_snSpace, "PDCP SN " << sn << " out of the SN space");
+  return m_buffered[sn];
+}
+
+uint64_t
+LtePdcpReorderingWindow::GetCount (uint32_t sn) const
+{
+  NS_ASSERT_MSG (IsBuffered (sn), "No PDCP SDU buffered with SN " << sn);
+  return m_slots[sn].count;
+}
+
+void
+LtePdcpReorderingWindow::Insert (uint32_t sn, uint64_t count, const LtePdcpSapUser::ReceivePdcpSduParameters &params)
+{
+  NS_ASSERT_MSG (!IsBuffered (sn), "PDCP SDU with SN " << sn << " already buffered");
+  if (m_slots.empty ())
+    {
+      m_slots.resize (m_snSpace);
+    }
+  m_slots[sn].count = count;
+  m_slots[sn].params = params;
+  m_buffered[sn] = true;
+  m_nBuffered++;
+}
+
+LtePdcpSapUser::ReceivePdcpSduParameters
+LtePdcpReorderingWindow::Remove (uint32_t sn)
+{
+  NS_ASSERT_MSG (IsBuffered (sn), "No PDCP SDU buffered with SN " << sn);
+  LtePdcpSapUser::ReceivePdcpSduParameters params = m_slots[sn].params;
+  // release the packet now rather than when the slot is reused
+  m_slots[sn].params.pdcpSdu = 0;
+  m_buffered[sn] = false;
+  m_nBuffered--;
+  return params;
+}
+
+void
+LtePdcpReorderingWindow::Clear ()
+{
+  m_buffered.assign (m_snSpace, false);
+  m_slots.clear ();
+  m_nBuffered = 0;
+}
+
+} // namespace ns3
@@ -0,0 +1,140 @@
+/* -*-  Mode: C++; c-file-style: "gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef LTE_PDCP_RX_WINDOW_H
+#define LTE_PDCP_RX_WINDOW_H
+
+#include <vector>
+
+#include "ns3/lte-pdcp-sap.h"
+
+namespace ns3 {
+
+/**
+ * Duplicate detection of received PDCP SNs over the whole SN space
+ * (4096, 32768 or 262144 values for 12, 15 and 18 bit SNs).
+ *
+ * A received SN is remembered until the highest received SN moves
+ * half the SN space beyond it, so that the same SN of the next HFN is
+ * not taken for a duplicate. Checking an SN is O(1), forgetting the old
+ * ones is amortized O(1) per received SN.
+ */
+class LtePdcpDuplicateFilter
+{
+public:
+  /**
+   * \param snSpace number of PDCP SN values
+   */
+  LtePdcpDuplicateFilter (uint32_t snSpace);
+
+  /**
+   * Record the reception of an SN
+   *
+   * \param sn the received PDCP SN
+   * \return true if the SN was already received
+   */
+  bool IsDuplicate (uint32_t sn);
+
+  /**
+   * Forget all the received SNs
+   */
+  void Reset ();
+
+private:
+  std::vector<bool> m_received; ///< one bit per SN
+  uint32_t m_snSpace;
+  uint32_t m_highestSn; ///< highest SN received, modulo the SN space
+  bool m_started;
+};
+
+/**
+ * Reordering buffer of a receiving PDCP entity, indexed by SN.
+ *
+ * Each slot of the SN space holds at most one SDU and its COUNT, and a
+ * bitmap tells which slots are in use, so that checking, buffering and
+ * releasing an SDU are O(1). The caller walks the slots from its
+ * in-order delivery cursor, so delivering a run of consecutive SDUs
+ * costs one step per SDU. The slots are only allocated when the first
+ * SDU is buffered.
+ */
+class LtePdcpReorderingWindow
+{
+public:
+  /**
+   * \param snSpace number of PDCP SN values
+   */
+  LtePdcpReorderingWindow (uint32_t snSpace);
+
+  /**
+   * \return the number of PDCP SN values
+   */
+  uint32_t GetSnSpace () const;
+
+  /**
+   * \return the number of SDUs in the buffer
+   */
+  uint32_t GetNBuffered () const;
+
+  /**
+   * \param sn a PDCP SN
+   * \return true if an SDU with this SN is in the buffer
+   */
+  bool IsBuffered (uint32_t sn) const;
+
+  /**
+   * \param sn the SN of a buffered SDU
+   * \return the COUNT of the SDU
+   */
+  uint64_t GetCount (uint32_t sn) const;
+
+  /**
+   * Buffer an SDU. The slot of its SN must be free.
+   *
+   * \param sn the PDCP SN of the SDU
+   * \param count the COUNT (HFN and SN) of the SDU
+   * \param params the SDU to deliver to the upper layer
+   */
+  void Insert (uint32_t sn, uint64_t count, const LtePdcpSapUser::ReceivePdcpSduParameters &params);
+
+  /**
+   * Take a buffered SDU out of the buffer
+   *
+   * \param sn the SN of a buffered SDU
+   * \return the SDU
+   */
+  LtePdcpSapUser::ReceivePdcpSduParameters Remove (uint32_t sn);
+
+  /**
+   * Drop all the buffered SDUs
+   */
+  void Clear ();
+
+private:
+  struct Slot
+  {
+    uint64_t count;
+    LtePdcpSapUser::ReceivePdcpSduParameters params;
+  };
+
+  std::vector<bool> m_buffered; ///< one bit per SN
+  std::vector<Slot> m_slots;
+  uint32_t m_snSpace;
+  uint32_t m_nBuffered;
+};
+
+} // namespace ns3
+
+#endif // LTE_PDCP_RX_WINDOW_H
@@ -28,7 +28,13 @@
 #include "ns3/lte-pdcp-sap.h"
 #include "ns3/lte-pdcp-tag.h"
 #include "ns3/epc-x2-sap.h"
-#include <ctime>
+#include "ns3/string.h"
+#include "ns3/uinteger.h"
+#include "ns3/boolean.h"
+#include "ns3/double.h"
+#include "ns3/enum.h"
+
+#include <algorithm>
 
 namespace ns3 {
 
@@ -128,12 +134,11 @@ McEnbPdcp::McEnbPdcp ()
   isAlternative = true;
   isTargetCellId_1 = false;
   isTargetCellId_2 = false;
-  eta = 0.5;
-  t_1 = 0; t_2= 0;
-  print_Eta.open("Pvalue.txt");
   m_isLteMmWaveDC = false;
   RequestAssistantInfoLTE = false;
   m_isEnableDuplicate = false;
+  m_duplicatedPdus = 0;
+  m_duplicatedBytes = 0;
   //RequestAssistantInfoMmWave = false;
 }
 void
@@ -198,12 +203,86 @@ McEnbPdcp::SetTargetCellIds(uint16_t targetID2, uint16_t targetID1, uint16_t lte
 
 	targetCellId_1  =targetID1;
 	targetCellId_2 = targetID2;
+	UpdateSplitLegs ();
 	//std::cout <<"sjkang0----" << targetCellId_1 << "\t" <<targetCellId_2 <<std::endl;
 }
 void
 McEnbPdcp::SetPacketDuplicateMode( bool isDuplicate){
 	m_isEnableDuplicate = isDuplicate;
 }
+
+bool
+McEnbPdcp::IsDuplicating ()
+{
+  if (m_duplicationMode == DUPLICATION_ALWAYS || m_isEnableDuplicate)
+    {
+      return true;
+    }
+  if (m_duplicationMode == DUPLICATION_ADAPTIVE)
+    {
+      Ptr<PdcpSplitAlgorithm> algorithm = GetSplitAlgorithm ();
+      const std::vector<uint16_t> &legs = algorithm->GetLegs ();
+      for (std::vector<uint16_t>::const_iterator it = legs.begin (); it != legs.end (); ++it)
+        {
+          if (algorithm->GetQueueDelay (*it) > m_duplicationDelayThreshold.GetSeconds ())
+            {
+              return true;
+            }
+        }
+    }
+  return false;
+}
+
+uint64_t
+McEnbPdcp::GetDuplicatedPdus () const
+{
+  return m_duplicatedPdus;
+}
+
+uint64_t
+McEnbPdcp::GetDuplicatedBytes () const
+{
+  return m_duplicatedBytes;
+}
+
+void
+McEnbPdcp::TransmitDuplicates (Ptr<Packet> p, LtePdcpHeader pdcpHeader, LteRlcSapProvider::TransmitPdcpPduParameters params)
+{
+  NS_LOG_FUNCTION (this << pdcpHeader.GetSequenceNumber ());
+  Ptr<PdcpSplitAlgorithm> algorithm = GetSplitAlgorithm ();
+  const std::vector<uint16_t> &legs = algorithm->GetLegs ();
+  uint32_t size = p->GetSize () + pdcpHeader.GetSerializedSize ();
+
+  PdcpTag pdcpTag (Simulator::Now ());
+  p->AddByteTag (pdcpTag);
+  for (uint32_t i = 0; i < legs.size (); i++)
+    {
+      // the last leg gets the original
+      Ptr<Packet> copy = (i + 1 < legs.size ()) ? p->Copy () : p;
+      pdcpHeader.SetSourceCellId (legs[i]);
+      copy->AddHeader (pdcpHeader);
+      if (legs[i] == lteCellId)
+        {
+          params.pdcpPdu = copy;
+          m_rlcSapProvider->TransmitPdcpPdu (params);
+        }
+      else
+        {
+          EpcX2Sap::UeDataParams ueDataParams = m_ueDataParams;
+          ueDataParams.ueData = copy;
+          ueDataParams.targetCellId = legs[i];
+          m_epcX2PdcpProvider->SendMcPdcpPdu (ueDataParams);
+        }
+      algorithm->NotifyPduSent (legs[i], size);
+    }
+
+  if (legs.size () > 1)
+    {
+      m_duplicatedPdus++;
+      m_duplicatedBytes += (uint64_t) size * (legs.size () - 1);
+      m_txDuplicateTrace (m_rnti, m_lcid, pdcpHeader.GetSequenceNumber (), size, legs.size ());
+    }
+}
 uint16_t
 McEnbPdcp::GetTargetCellId_1(){ //sjkang
 	return this->targetCellId_1;
@@ -227,9 +306,30 @@ McEnbPdcp::GetTypeId (void)
 			UintegerValue(2),
 			MakeUintegerAccessor(&McEnbPdcp::m_isSplitting),
 			MakeUintegerChecker<uint16_t> ())
+	.AddAttribute ("SplitAlgorithm",
+	               "The type of split bearer scheduler to be used. The allowed values for "
+	               "this attributes are the type names of any class inheriting from "
+	               "ns3::PdcpSplitAlgorithm. If empty, numberOfAlgorithm selects one.",
+	               StringValue (""),
+	               MakeStringAccessor (&McEnbPdcp::SetSplitAlgorithmType,
+	                                   &McEnbPdcp::GetSplitAlgorithmType),
+	               MakeStringChecker ())
 	.AddAttribute("enableLteMmWaveDC", "this value means if Lte - mmWave DC is enable or not", BooleanValue(false),
 			MakeBooleanAccessor(&McEnbPdcp::m_isLteMmWaveDC),
 			MakeBooleanChecker())
+    .AddAttribute ("DuplicationMode",
+                   "When the PDUs are duplicated on all the legs of the bearer",
+                   EnumValue (McEnbPdcp::DUPLICATION_ON_DEMAND),
+                   MakeEnumAccessor (&McEnbPdcp::m_duplicationMode),
+                   MakeEnumChecker (McEnbPdcp::DUPLICATION_ON_DEMAND, "OnDemand",
+                                    McEnbPdcp::DUPLICATION_ALWAYS, "Always",
+                                    McEnbPdcp::DUPLICATION_ADAPTIVE, "Adaptive"))
+    .AddAttribute ("DuplicationDelayThreshold",
+                   "In Adaptive duplication mode, the PDUs are duplicated while the "
+                   "smoothed queueing delay of a leg is above this value",
+                   TimeValue (MilliSeconds (10)),
+                   MakeTimeAccessor (&McEnbPdcp::m_duplicationDelayThreshold),
+                   MakeTimeChecker ())
     .AddTraceSource ("TxPDU",
                      "PDU transmission notified to the RLC.",
                      MakeTraceSourceAccessor (&McEnbPdcp::m_txPdu),
@@ -238,6 +338,10 @@ McEnbPdcp::GetTypeId (void)
                      "PDU received.",
                      MakeTraceSourceAccessor (&McEnbPdcp::m_rxPdu),
                      "ns3::McEnbPdcp::PduRxTracedCallback")
+    .AddTraceSource ("TxDuplicate",
+                     "PDU sent to more than one leg.",
+                     MakeTraceSourceAccessor (&McEnbPdcp::m_txDuplicateTrace),
+                     "ns3::McEnbPdcp::DuplicateTxTracedCallback")
     ;
   return tid;
 }
@@ -249,6 +353,11 @@ McEnbPdcp::DoDispose ()
   delete (m_pdcpSapProvider);
   delete (m_rlcSapUser);
   delete (m_epcX2PdcpUser);
+  if (m_splitAlgorithm != 0)
+    {
+      m_splitAlgorithm->Dispose ();
+      m_splitAlgorithm = 0;
+    }
 }
 
 void
@@ -405,7 +514,10 @@ McEnbPdcp::DoTransmitPdcpSdu (Ptr<Packet> p)
     		    							RequestAssistantInfoLTE = true; //sjkang
     		    						}
 
-    		if (splitingAlgorithm() == lteCellId ){
+    		if (IsDuplicating ()){
+    			TransmitDuplicates (p, pdcpHeader, params);
+    		}
+    		else if (splitingAlgorithm (p->GetSize () + pdcpHeader.GetSerializedSize ()) == lteCellId ){
     				  p->AddHeader (pdcpHeader);
     			    PdcpTag pdcpTag (Simulator::Now ());
     			    p->AddByteTag (pdcpTag);
@@ -429,27 +541,10 @@ McEnbPdcp::DoTransmitPdcpSdu (Ptr<Packet> p)
     	}else
     	{
     		if (count >=100){
-    			if (m_isEnableDuplicate){
-    				//	std::cout << "----------------Duplicate Mode ---------------" <<std::endl;
-    				EpcX2Sap::UeDataParams m_ueDataParams_copy = m_ueDataParams;
-    				  PdcpTag pdcpTag (Simulator::Now ());
-    			    	 p->AddByteTag (pdcpTag);
-    			    	 p->AddHeader (pdcpHeader);
-    			    	 Ptr<Packet> p_copy = p->Copy();
-    			    	 m_ueDataParams_copy.ueData = p_copy;
-    			    	 m_ueDataParams.targetCellId = targetCellId_1;
-    			    	 m_ueDataParams_copy.targetCellId = targetCellId_2;
-    			    		params.pdcpPdu = p;
-    			    	   if (targetCellId_1 == lteCellId or targetCellId_2 == lteCellId)
-    			    	    		  m_rlcSapProvider->TransmitPdcpPdu (params);
-    			    	  else{
-
-    			    	 m_epcX2PdcpProvider->SendMcPdcpPdu(m_ueDataParams);
-    			    	 m_epcX2PdcpProvider->SendMcPdcpPdu(m_ueDataParams_copy);
-    			    	  }
-
+    			if (IsDuplicating ()){
+    				TransmitDuplicates (p, pdcpHeader, params);
     			}else{
-    					uint16_t Cellid = splitingAlgorithm();
+    					uint16_t Cellid = splitingAlgorithm (p->GetSize () + pdcpHeader.GetSerializedSize ());
 
     					m_ueDataParams.targetCellId = Cellid;
     				//	std::cout<<Simulator::Now().GetSeconds()<<"\t"<<Cellid << std::endl;
@@ -572,143 +667,131 @@ void
 McEnbPdcp::UpdateEta(){
 
 }
-uint16_t
-McEnbPdcp::splitingAlgorithm(){
 
-switch(m_isSplitting){
-case 0:
+void
+McEnbPdcp::SetSplitAlgorithmType (std::string type)
 {
-	return targetCellId_1;
-	break;
+  NS_LOG_FUNCTION (this << type);
+  if (!type.empty ())
+    {
+      m_splitAlgorithmFactory = ObjectFactory ();
+      m_splitAlgorithmFactory.SetTypeId (type);
+    }
 }
-case 1:
+
+std::string
+McEnbPdcp::GetSplitAlgorithmType () const
 {
-	return targetCellId_2;
-	break;
+  if (m_splitAlgorithmFactory.GetTypeId ().GetUid () == 0)
+    {
+      return "";
+    }
+  return m_splitAlgorithmFactory.GetTypeId ().GetName ();
 }
-case 2: //alternative
-{
-	count ++;
-	if (count % 2 == 0)
-		return targetCellId_1;
-	else
-		return targetCellId_2;
-
 
-	break;
-}
-case 3: // p-split
+void
+McEnbPdcp::SetSplitAlgorithmAttribute (std::string n, const AttributeValue &v)
 {
-	double randomValue = (double) rand()/ RAND_MAX;
-	if (q_Delay[targetCellId_1] >0.003 || q_Delay[targetCellId_2]>0.003){
-		if(q_Delay[targetCellId_1]> q_Delay[targetCellId_2]){
-			eta -= 0.001;
-			if (eta < 0.0) eta =0.0;
-		}else if (q_Delay[targetCellId_2] >= q_Delay[targetCellId_1]){
-			eta += 0.001;
-			if (eta >= 1) eta = 1.0;
-		}
-	}
- print_Eta << Simulator::Now().GetSeconds() << "\t"<<eta << std::endl;
-	if (randomValue < eta){
-		return targetCellId_1;
-	}else
-		return targetCellId_2;
-
-break;
-		}
-case 4: //SDF
-	//	std::cout <<targetCellId_1 <<"\t"<< q_Delay[targetCellId_1] <<"\t"<<targetCellId_2<<"\t"<<q_Delay[targetCellId_2]<< std::endl;
-			if (q_Delay[targetCellId_1] > q_Delay[targetCellId_2]){
-				t_2++;
-				targetCellID = targetCellId_2;
-			//std::cout << q_Delay[targetCellId_1] <<"\t"<<q_Delay[targetCellId_2]<<"\t"<<targetCellID << std::endl;
-			}else if (q_Delay[targetCellId_2] > q_Delay[targetCellId_1]){
-				t_1 ++;
-				targetCellID = targetCellId_1;
-				//std::cout << q_Delay[targetCellId_1] <<"\t"<<q_Delay[targetCellId_2]<<"\t"<<targetCellID << std::endl;
-
-			}
-			else if (q_Delay[targetCellId_1] == q_Delay[targetCellId_2]){
-					if(count % 2 == 0){
-						t_1 ++;
-						targetCellID = targetCellId_1;
-						//std::cout << q_Delay[targetCellId_1] <<"\t"<<q_Delay[targetCellId_2]<<"\t"<<targetCellID << std::endl;
-
-					}else{
-						t_2 ++;
-						targetCellID = targetCellId_2;
-						//std::cout << q_Delay[targetCellId_1] <<"\t"<<q_Delay[targetCellId_2]<<"\t"<<targetCellID << std::endl;
-
-					}
-					count ++;
-			}
-			print_Eta << Simulator::Now().GetSeconds() <<"\t"<<(double) t_1/(t_1+t_2)<<std::endl;
-		return targetCellID;
-	break;
-case 5: //SQF
-	///std::cout << q_Size[targetCellId_1] <<"\t"<<q_Size[targetCellId_2]<< "\t"<< targetCellId_1<<"\t" << targetCellId_2 <<std::endl;
-	if(q_Size[targetCellId_1] > q_Size[targetCellId_2]){
-		t_2++;
-		targetCellID = targetCellId_2;
-	}else if (q_Size[targetCellId_2] >q_Size[targetCellId_1]){
-		t_1 ++;
-		targetCellID = targetCellId_1;
-	}else if(q_Size[targetCellId_1] == q_Size[targetCellId_2])
-	    {
-			if (count %2 ==0){
-				t_1 ++;
-				targetCellID = targetCellId_1;
-			//	std::cout << count<< "\t"<< targetCellID<<std::endl;
-			}else{
-				t_2 ++;
-				targetCellID = targetCellId_2;
-				//std::cout << count<< "\t"<< targetCellID<<std::endl;
+  NS_LOG_FUNCTION (this << n);
+  NS_ASSERT_MSG (m_splitAlgorithmFactory.GetTypeId ().GetUid () != 0, "Set the split algorithm type first");
+  m_splitAlgorithmFactory.Set (n, v);
+}
 
-			}
-			count ++;
+Ptr<PdcpSplitAlgorithm>
+McEnbPdcp::GetSplitAlgorithm ()
+{
+  if (m_splitAlgorithm == 0)
+    {
+      if (m_splitAlgorithmFactory.GetTypeId ().GetUid () == 0)
+        {
+          // the algorithms of the numberOfAlgorithm attribute
+          switch (m_isSplitting)
+            {
+            case 0:
+            case 1:
+              m_splitAlgorithmFactory.SetTypeId ("ns3::FixedPdcpSplitAlgorithm");
+              m_splitAlgorithmFactory.Set ("Leg", UintegerValue (m_isSplitting));
+              break;
+            case 2: // alternative
+              m_splitAlgorithmFactory.SetTypeId ("ns3::RoundRobinPdcpSplitAlgorithm");
+              break;
+            case 3: // p-split
+              m_splitAlgorithmFactory.SetTypeId ("ns3::ProbabilisticPdcpSplitAlgorithm");
+              break;
+            case 4: // SDF
+              m_splitAlgorithmFactory.SetTypeId ("ns3::ShortestDelayPdcpSplitAlgorithm");
+              break;
+            case 5: // SQF
+              m_splitAlgorithmFactory.SetTypeId ("ns3::ShortestQueuePdcpSplitAlgorithm");
+              break;
+            case 6: // 95-5
+              m_splitAlgorithmFactory.SetTypeId ("ns3::ProbabilisticPdcpSplitAlgorithm");
+              m_splitAlgorithmFactory.Set ("FirstLegShare", DoubleValue (0.95));
+              m_splitAlgorithmFactory.Set ("Adaptive", BooleanValue (false));
+              break;
+            default:
+              NS_FATAL_ERROR ("Unknown splitting algorithm " << m_isSplitting);
+            }
+        }
+      m_splitAlgorithm = m_splitAlgorithmFactory.Create<PdcpSplitAlgorithm> ();
+      UpdateSplitLegs ();
+    }
+  return m_splitAlgorithm;
+}
 
-	}
-	print_Eta << Simulator::Now().GetSeconds() <<"\t"<< (double)t_1/(t_1+t_2)<<std::endl;
-	return targetCellID;
-	break;
-case 6:{
-	double randomValue = (double) rand()/ RAND_MAX;
-	if (randomValue >0.05)
-		return targetCellId_1;
+void
+McEnbPdcp::AddSplitLeg (uint16_t cellId)
+{
+  NS_LOG_FUNCTION (this << cellId);
+  m_extraSplitLegs.push_back (cellId);
+  UpdateSplitLegs ();
+}
 
-	else
-		return targetCellId_2;
-		break;
+void
+McEnbPdcp::UpdateSplitLegs ()
+{
+  if (m_splitAlgorithm == 0)
+    {
+      return;
+    }
+  std::vector<uint16_t> legs;
+  legs.push_back (targetCellId_1);
+  uint16_t secondLeg = m_isLteMmWaveDC ? lteCellId : targetCellId_2;
+  if (secondLeg != targetCellId_1)
+    {
+      legs.push_back (secondLeg);
+    }
+  for (std::vector<uint16_t>::const_iterator it = m_extraSplitLegs.begin (); it != m_extraSplitLegs.end (); ++it)
+    {
+      if (std::find (legs.begin (), legs.end (), *it) == legs.end ())
+        {
+          legs.push_back (*it);
+        }
+    }
+  m_splitAlgorithm->SetLegs (legs);
+  m_splitAlgorithm->SetLocalCellId (lteCellId);
+}
 
+int64_t
+McEnbPdcp::AssignStreams (int64_t stream)
+{
+  return GetSplitAlgorithm ()->AssignStreams (stream);
 }
- } // switch
 
-return 1;
+uint16_t
+McEnbPdcp::splitingAlgorithm (uint32_t size)
+{
+  return GetSplitAlgorithm ()->SelectLeg (size);
 }
+
 void
 McEnbPdcp::DoReceiveAssistantInformation(EpcX2Sap::AssistantInformationForSplitting info){
-
-//	q_Size[info.sourceCellId] = info.Re_TX_Q_Size+info.Tx_On_Q_Size+info.Txed_Q_Size;
-	q_Size[info.sourceCellId] = info.Tx_On_Q_Size+info.Txed_Q_Size;
-	//q_Delay[info.sourceCellId] =(double) (info.Txed_Q_Delay+info.Tx_On_Q_Delay+info.Re_Tx_Q_Delay)/10e6;
-	double alpha=0.9;
-	q_Delay[info.sourceCellId] =(1-alpha)*(double) (info.Tx_On_Q_Delay)/10e3 + alpha*q_Delay[info.sourceCellId];
-//std::cout <<info.Re_TX_Q_Size <<std::endl;
-	//std::cout<<"mmWave received-->" <<info.Tx_On_Q_Delay<<std::endl;;
-	//std::cout << "MmWave : "<<info.Tx_On_Q_Delay << "\t"<< info.Re_Tx_Q_Delay << info.Txed_Q_Delay <<std::endl;
-
+  GetSplitAlgorithm ()->ReportAssistantInfo (info.sourceCellId, info);
 }
+
 void
 McEnbPdcp::DoReceiveLteAssistantInfo(EpcX2Sap::AssistantInformationForSplitting info){
-	q_Size[lteCellId] = info.Tx_On_Q_Size+info.Txed_Q_Size;
-	//q_Size[lteCellId] = info.Re_TX_Q_Size+info.Tx_On_Q_Size+info.Txed_Q_Size;
-	//q_Delay[lteCellId] =(double) (info.Txed_Q_Delay+info.Tx_On_Q_Delay+info.Re_Tx_Q_Delay)/10e6;
-	double alpha = 0.9;
-	q_Delay[lteCellId]=(1-alpha)*(double) (info.Tx_On_Q_Delay)/10e3 + alpha* q_Delay[lteCellId];
-
-//	std::cout << "lte received -->"<<q_Delay[lteCellId]<<std::endl;;
-   // std::cout << "LTE : "<<info.Tx_On_Q_Delay << "\t"<< info.Re_Tx_Q_Delay <<"\t"<< info.Txed_Q_Delay <<std::endl;
+  GetSplitAlgorithm ()->ReportAssistantInfo (lteCellId, info);
 }
 
 } // namespace ns3
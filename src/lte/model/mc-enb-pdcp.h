@@ -27,12 +27,15 @@
 #include "ns3/trace-source-accessor.h"
 
 #include "ns3/object.h"
+#include "ns3/object-factory.h"
 
 #include <ns3/epc-x2-sap.h>
 #include <ns3/epc-x2.h>
 #include <ns3/lte-pdcp-sap.h>
 #include <ns3/lte-rlc-sap.h>
 #include <ns3/lte-pdcp.h>
+#include <ns3/lte-pdcp-header.h>
+#include <ns3/pdcp-split-algorithm.h>
 #include <fstream>
 namespace ns3 {
 
@@ -178,6 +181,28 @@ public:
     (const uint16_t rnti, const uint8_t lcid,
      const uint32_t size, const uint64_t delay);
 
+  /**
+   * TracedCallback signature for the transmission of a duplicated PDU.
+   *
+   * \param [in] rnti The C-RNTI identifying the UE.
+   * \param [in] lcid The logical channel id.
+   * \param [in] sn The PDCP sequence number.
+   * \param [in] size The PDU size.
+   * \param [in] nCopies The number of legs the PDU was sent to.
+   */
+  typedef void (* DuplicateTxTracedCallback)
+    (uint16_t rnti, uint8_t lcid, uint16_t sn, uint32_t size, uint32_t nCopies);
+
+  /**
+   * When the PDUs of the bearer are sent to all its legs
+   */
+  enum DuplicationMode_t
+  {
+    DUPLICATION_ON_DEMAND, ///< when activated with SetPacketDuplicateMode
+    DUPLICATION_ALWAYS,    ///< always
+    DUPLICATION_ADAPTIVE   ///< on demand, or while a leg queue delay is above DuplicationDelayThreshold
+  };
+
   /**
    * Switch between LTE and MmWave
    */
@@ -191,9 +216,52 @@ public:
   uint16_t GetTargetCellId_1(); //sjkang
   uint16_t GetTargetCellId_2(); //sjkang
   virtual void DoReceiveAssistantInformation (EpcX2Sap::AssistantInformationForSplitting info); //sjkang1114
-  uint16_t splitingAlgorithm();
+  uint16_t splitingAlgorithm (uint32_t size);
+
+  /**
+   * Set the type of the split bearer scheduler. If no type is set, the
+   * numberOfAlgorithm attribute selects one.
+   *
+   * \param type type of split algorithm, must be a type name of any class
+   *        inheriting from ns3::PdcpSplitAlgorithm
+   */
+  void SetSplitAlgorithmType (std::string type);
+  std::string GetSplitAlgorithmType () const;
+
+  /**
+   * Set an attribute of the split algorithm, before its creation
+   */
+  void SetSplitAlgorithmAttribute (std::string n, const AttributeValue &v);
+
+  /**
+   * \return the split algorithm, created at the first call
+   */
+  Ptr<PdcpSplitAlgorithm> GetSplitAlgorithm ();
+
+  /**
+   * Split the bearer on one more cell, besides the target cells
+   */
+  void AddSplitLeg (uint16_t cellId);
+
+  /**
+   * Assign fixed random variable stream numbers to the split algorithm
+   *
+   * \param stream first stream index to use
+   * \return the number of stream indices assigned
+   */
+  int64_t AssignStreams (int64_t stream);
  void DoReceiveLteAssistantInfo(EpcX2Sap::AssistantInformationForSplitting info); //sjkang
  void SetPacketDuplicateMode (bool) ; //sjkang
+
+  /**
+   * \return true if the next PDU is sent to all the legs
+   */
+  bool IsDuplicating ();
+
+  /// \return the number of PDUs sent to more than one leg
+  uint64_t GetDuplicatedPdus () const;
+  /// \return the bytes sent in extra copies of the duplicated PDUs
+  uint64_t GetDuplicatedBytes () const;
 protected:
   // Interface provided to upper RRC entity
   virtual void DoTransmitPdcpSdu (Ptr<Packet> p);
@@ -231,8 +299,18 @@ protected:
   EpcX2PdcpUser* m_epcX2PdcpUser;
   void UpdateEta();
  // uint16_t splitingAlgorithm();
-  std::ofstream print_Eta;
 private:
+  void UpdateSplitLegs ();
+
+  /**
+   * Send a copy of a PDU to each leg of the bearer
+   *
+   * \param p the PDCP SDU
+   * \param pdcpHeader the header of the PDU, the source cell is set per leg
+   * \param params the RLC parameters of the copy sent to the local cell
+   */
+  void TransmitDuplicates (Ptr<Packet> p, LtePdcpHeader pdcpHeader, LteRlcSapProvider::TransmitPdcpPduParameters params);
+
   /**
    * State variables. See section 7.1 in TS 36.323
    */
@@ -255,16 +333,23 @@ private:
   bool isTargetCellId_1 ;
   bool isTargetCellId_2 ;
 
-  uint32_t q_Size[20];
-  double q_Delay[10];
   std::vector < Ptr<Packet> > bufferOfTargetEnb1, bufferOfTargetEnb2; //sjkang1221
   uint16_t m_isSplitting;
-  double eta;
-  uint64_t t_1, t_2;
-  uint16_t targetCellID;
+  ObjectFactory m_splitAlgorithmFactory;
+  Ptr<PdcpSplitAlgorithm> m_splitAlgorithm;
+  std::vector<uint16_t> m_extraSplitLegs;
   bool m_isLteMmWaveDC;
   bool RequestAssistantInfoLTE;
   bool m_isEnableDuplicate;
+  DuplicationMode_t m_duplicationMode;
+  Time m_duplicationDelayThreshold;
+  uint64_t m_duplicatedPdus;
+  uint64_t m_duplicatedBytes;
+
+  /**
+   * Used to inform of the transmission of a PDU to more than one leg.
+   */
+  TracedCallback<uint16_t, uint8_t, uint16_t, uint32_t, uint32_t> m_txDuplicateTrace;
 };
 
 
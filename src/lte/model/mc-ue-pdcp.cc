@@ -83,7 +83,9 @@ McUePdcp::McUePdcp ()
     m_lcid (0),
     m_txSequenceNumber (0),
     m_rxSequenceNumber (0),
-    m_useMmWaveConnection (false)
+    m_useMmWaveConnection (false),
+    m_rxWindow (MAX_PDCP_SN),
+    m_duplicateFilter (MAX_PDCP_SN)
 {
   NS_LOG_FUNCTION (this);
   m_pdcpSapProvider = new LtePdcpSpecificLtePdcpSapProvider<McUePdcp> (this);
@@ -144,6 +146,10 @@ McUePdcp::GetTypeId (void)
                      "PDU received.",
                      MakeTraceSourceAccessor (&McUePdcp::m_rxPdu),
                      "ns3::McUePdcp::PduRxTracedCallback")
+    .AddTraceSource ("RxDuplicate",
+                     "Copy of a PDU discarded, another copy arrived first.",
+                     MakeTraceSourceAccessor (&McUePdcp::m_rxDuplicate),
+                     "ns3::McUePdcp::DuplicateRxTracedCallback")
     .AddAttribute ("LteUplink",
                     "Use LTE for uplink",
                     BooleanValue (false),
@@ -157,6 +163,45 @@ McUePdcp::GetTypeId (void)
   return tid;
 }
 
+McUePdcp::DuplicationStats::DuplicationStats ()
+  : rxPdus (0),
+    usefulPdus (0),
+    wastedPdus (0),
+    wastedBytes (0)
+{
+}
+
+McUePdcp::DuplicationStats
+McUePdcp::GetDuplicationStats (uint16_t cellId) const
+{
+  std::map<uint16_t, DuplicationStats>::const_iterator it = m_duplicationStats.find (cellId);
+  return it == m_duplicationStats.end () ? DuplicationStats () : it->second;
+}
+
+void
+McUePdcp::RecordCopy (uint16_t sn, uint16_t cellId, uint32_t size, bool duplicate)
+{
+  DuplicationStats &stats = m_duplicationStats[cellId];
+  stats.rxPdus++;
+  if (m_firstCopies.empty ())
+    {
+      m_firstCopies.resize (MAX_PDCP_SN);
+    }
+  if (!duplicate)
+    {
+      stats.usefulPdus++;
+      m_firstCopies[sn].arrival = Simulator::Now ();
+      m_firstCopies[sn].cellId = cellId;
+      return;
+    }
+  stats.wastedPdus++;
+  stats.wastedBytes += size;
+  const FirstCopy &first = m_firstCopies[sn];
+  NS_LOG_LOGIC ("copy of SN " << sn << " from cell " << cellId << " discarded, " << (Simulator::Now () - first.arrival).GetMicroSeconds ()
+                              << " us after the one from cell " << first.cellId);
+  m_rxDuplicate (m_rnti, m_lcid, sn, first.cellId, cellId, size, Simulator::Now () - first.arrival);
+}
+
 void
 McUePdcp::DoDispose ()
 {
@@ -345,7 +390,6 @@ McUePdcp::DoTransmitPdcpControlPacket(Ptr<Packet> p, uint16_t cellId){
 	    NS_FATAL_ERROR ("Invalid combination");
 	  }
 }
-std::ofstream duplicationDiscard("duplication_discard_log.txt");
 void
 McUePdcp::DoReceivePdu (Ptr<Packet> p)
 {
@@ -386,14 +430,12 @@ if(!m_isEnableReordering){
      //   Last_Submitted_PDCP_RX_SN = -1;
       }
 
-    if (std::find(CheckSN.begin(), CheckSN.end(),m_rxSequenceNumber) != CheckSN.end()){
-    duplicationDiscard<<Simulator::Now().GetSeconds()<<"\t"<<m_rxSequenceNumber<<std::endl;
+    bool duplicate = m_duplicateFilter.IsDuplicate (m_rxSequenceNumber);
+    RecordCopy (pdcpHeader.GetSequenceNumber (), pdcpHeader.GetSourceCellId (),
+                p->GetSize () + pdcpHeader.GetSerializedSize (), duplicate);
+    if (duplicate){
     	return;
     }
-    CheckSN.push_back(m_rxSequenceNumber);
-    if (CheckSN.size() == MAX_PDCP_SN/2){
-    	CheckSN.erase(CheckSN.begin(), CheckSN.begin()+MAX_PDCP_SN/4);
-    }
     if(p->GetSize() > 20 + 8 + 12)
     {
 
@@ -467,21 +509,19 @@ McUePdcp::BufferingAndReordering(Ptr<Packet> p){ // sjkang
 //  PropagationDelaybySN[pdcpHeader.GetSequenceNumber()] = delay;
   //printData("RX_SN", PacketInBuffer.sequenceNumber);
 
-  // for checking whether there is the same PDCP SDU in buffer
-  std::map<int, LtePdcpSapUser::ReceivePdcpSduParameters>::iterator iter;
-  for (iter =PdcpBuffer.begin(); iter != PdcpBuffer.end() ; ++iter)
+  // for checking whether the PDCP SDU was already received on another leg
+  bool duplicate = m_duplicateFilter.IsDuplicate (receivedPDCP_SN) || m_rxWindow.IsBuffered (receivedPDCP_SN);
+  RecordCopy (receivedPDCP_SN, pdcpHeader.GetSourceCellId (),
+              p->GetSize () + pdcpHeader.GetSerializedSize (), duplicate);
+  if (duplicate)
   {
-    if (iter->first == receivedPDCP_SN ) {
-	NS_LOG_INFO(iter->first << "   discard ");
+	NS_LOG_INFO(receivedPDCP_SN << "   discard ");
 	discardedPacketSize+=params.pdcpSdu->GetSize();
 	numberOfDiscaredPackets++;
 //	OutFile_D<< Simulator::Now().GetSeconds()<<"\t"<<discardedPacketSize<<"\t"<<numberOfDiscaredPackets << std::endl;
 	return;
-    }
   }
 
-  PdcpBuffer[PacketInBuffer.sequenceNumber] = params;
-
 // Logging module
 /*    uint16_t nextPDCP_SN = (Last_Submitted_PDCP_RX_SN + 1)%(m_maxPdcpSn+1);
     std::map<uint16_t, LtePdcpSapUser::ReceivePdcpSduParameters>::iterator it;
@@ -501,27 +541,27 @@ NS_LOG_UNCOND(it->first);
 	// if(firstOne ==1){
     NS_LOG_INFO(Simulator::Now().GetSeconds() << "last SN " << Last_Submitted_PDCP_RX_SN << "\t"
                 "received SN "	<< PacketInBuffer.sequenceNumber<< " discard" << "  Next PDCP SN  " << Next_PDCP_RX_SN
-				<<"   Q Size " << PdcpBuffer.size());
+				<<"   Q Size " << m_rxWindow.GetNBuffered ());
     discardedPacketSize+=params.pdcpSdu->GetSize();
-    PdcpBuffer.erase(PacketInBuffer.sequenceNumber);
     numberOfDiscaredPackets++;
    // OutFile_D<< Simulator::Now().GetSeconds()<<"\t"<<discardedPacketSize<<"\t"<<numberOfDiscaredPackets << std::endl;
 
     return ;
 	 //}
   }
-  else if ((Next_PDCP_RX_SN-receivedPDCP_SN) > reorderingWindow)
+  int rxHfn = present_RX_HFN;
+  if ((Next_PDCP_RX_SN-receivedPDCP_SN) > reorderingWindow)
   {
 
 	  Next_PDCP_RX_SN = receivedPDCP_SN +1;
 	  present_RX_HFN ++;
-	      RX_HFNbySN[receivedPDCP_SN] = present_RX_HFN;
+	      rxHfn = present_RX_HFN;
 
   }
   else if (receivedPDCP_SN - Next_PDCP_RX_SN >= reorderingWindow)
   {
 
-			  RX_HFNbySN[receivedPDCP_SN]= present_RX_HFN -1;
+			  rxHfn = present_RX_HFN -1;
 
   }
 
@@ -529,7 +569,7 @@ NS_LOG_UNCOND(it->first);
   else if (receivedPDCP_SN >= Next_PDCP_RX_SN){
 
 	  Next_PDCP_RX_SN = receivedPDCP_SN +1;
-	        RX_HFNbySN[receivedPDCP_SN] =present_RX_HFN;
+	        rxHfn =present_RX_HFN;
 
 
 	        if (Next_PDCP_RX_SN >= m_maxPdcpSn)
@@ -539,9 +579,7 @@ NS_LOG_UNCOND(it->first);
 
 	        }
   }
-  else if (receivedPDCP_SN < Next_PDCP_RX_SN) {
-	  RX_HFNbySN[receivedPDCP_SN] = present_RX_HFN;
-  }
+  m_rxWindow.Insert (receivedPDCP_SN, receivedPDCP_SN + (int64_t) rxHfn * MAX_PDCP_SN, params);
 
   ///sjkang1116 below procedure is for measuring SN difference between two different path.
     if(cellId_1 == 0 && cellId_1 != pdcpHeader.GetSourceCellId()){
@@ -550,10 +588,10 @@ NS_LOG_UNCOND(it->first);
    	cellId_2 = pdcpHeader.GetSourceCellId();
    	 //sjkang1116
      }else if(cellId_1 == pdcpHeader.GetSourceCellId()){
-   	  cellIdToSN_1= m_rxSequenceNumber+RX_HFNbySN[receivedPDCP_SN]*MAX_PDCP_SN;
+   	  cellIdToSN_1= m_rxSequenceNumber+rxHfn*MAX_PDCP_SN;
    	  	  	 // if (cellIdToSN_1 >40000) cellIdToSN_1 -=32768;
      }else if (cellId_2 == pdcpHeader.GetSourceCellId()){
-  	   cellIdToSN_2 = m_rxSequenceNumber + RX_HFNbySN[receivedPDCP_SN]*MAX_PDCP_SN;
+  	   cellIdToSN_2 = m_rxSequenceNumber + rxHfn*MAX_PDCP_SN;
   	   	   	  //if (cellIdToSN_2 > 40000) cellIdToSN_2 -=32768;
      }
     if (cellId_1 != 0 && cellId_2 != 0 && firstPacket == false){
@@ -567,55 +605,15 @@ NS_LOG_UNCOND(it->first);
 
 
   if ((receivedPDCP_SN == Last_Submitted_PDCP_RX_SN +1)||(receivedPDCP_SN==Last_Submitted_PDCP_RX_SN-m_maxPdcpSn) )
-        {
-
-			  std::map<int, LtePdcpSapUser::ReceivePdcpSduParameters> ::iterator it;
-        	  	  temp = new int[(size_t)PdcpBuffer.size()+1];
-
-        	  	    int i=0 , COUNT=0;
-        	  		for (it = PdcpBuffer.begin() ;it !=PdcpBuffer.end(); ++it, ++i){
-        	  			COUNT = it->first + RX_HFNbySN[it->first]*MAX_PDCP_SN;
-        	  			temp[i]=COUNT;
-
-        	  		}
-
-        	  		std::sort(temp, temp + i);
-
-        	             int sum = temp[0];
-        	            uint16_t p=0;
-
-
-        	             while (sum == temp[p] && p!=PdcpBuffer.size()){
-        	          	   sum =temp[p]+1;
-        	          	   p++;
-        	             }
-
-        	            for (int c = 0 ; c< p; c++){
-        	            	if (temp[c]> m_maxPdcpSn) temp[c]= temp[c]% MAX_PDCP_SN;
-
-        	            	PdcpTag reorderingTag;
-        	            	PdcpBuffer[temp[c]].pdcpSdu->RemovePacketTag(reorderingTag);
-        	            	uint32_t reordering_delay = Simulator::Now().GetMicroSeconds() - reorderingTag.GetSenderTimestamp().GetMicroSeconds();
-        	            	reorderingDelay <<Simulator::Now().GetSeconds()<<"\t"<< reordering_delay / 10e5 <<std::endl;
-
-        	            	m_pdcpSapUser->ReceivePdcpSdu(PdcpBuffer[temp[c]]);
-
-        	            	SumOfPacketSize +=PdcpBuffer[temp[c]].pdcpSdu->GetSize();//sjkang0718
-        	               orderdedSumOfPacket=SumOfPacketSize;
-        	        		 PdcpBuffer.erase(temp[c]);
-        	               Last_Submitted_PDCP_RX_SN = temp[c];
-
-        	             if(Last_Submitted_PDCP_RX_SN == Reordering_PDCP_RX_COUNT % MAX_PDCP_SN -1)
-        	                    	                    	check =true;
-        	              if(Last_Submitted_PDCP_RX_SN ==m_maxPdcpSn && Reordering_PDCP_RX_COUNT % MAX_PDCP_SN==0)
-        	                    	                    	  check =true;
-
-        	            }
-
-
-
-        	     delete [] temp;
-          }
+  {
+    // release the run of consecutive SDUs that starts with the received one
+    uint32_t sn = receivedPDCP_SN;
+    while (m_rxWindow.IsBuffered (sn))
+    {
+      DeliverReordered (sn);
+      sn = (sn + 1) % MAX_PDCP_SN;
+    }
+  }
 
   if (t_ReorderingTimer.IsRunning())
   {
@@ -628,7 +626,7 @@ NS_LOG_UNCOND(it->first);
 
   if (!t_ReorderingTimer.IsRunning())
   {
-    if (PdcpBuffer.size()>=1){
+    if (m_rxWindow.GetNBuffered () > 0){
       t_ReorderingTimer = Simulator::Schedule(expiredTime, &McUePdcp::t_ReordringTimer_Expired, this);
       Reordering_PDCP_RX_COUNT = Next_PDCP_RX_SN + present_RX_HFN* MAX_PDCP_SN;
 
@@ -711,61 +709,41 @@ McUePdcp::BufferingAndReordering_New(Ptr<Packet> p){ // sjkang
 	//	 OutFile_D<< Simulator::Now().GetSeconds()<<"\t"<<discardedPacketSize<<"\t"<<numberOfDiscaredPackets << std::endl;
 	  return;
   }
-  std::map<uint64_t, LtePdcpSapUser::ReceivePdcpSduParameters>::iterator iter;
-  for (iter =NewPdcpBuffer.begin(); iter != NewPdcpBuffer.end() ; ++iter)
+  // the slot of RCVD_COUNT is taken either by the same COUNT or by one
+  // a whole SN space away, which cannot be in the window
+  if (m_rxWindow.IsBuffered (RCVD_COUNT % MAX_PDCP_SN))
   {
-    if (iter->first == RCVD_COUNT ) {
-	NS_LOG_UNCOND(iter->first << "   discard ");
+	NS_LOG_UNCOND(RCVD_COUNT << "   discard ");
 	discardedPacketSize+=params.pdcpSdu->GetSize();
 	numberOfDiscaredPackets++;
 //	OutFile_D<< Simulator::Now().GetSeconds()<<"\t"<<discardedPacketSize<<"\t"<<numberOfDiscaredPackets << std::endl;
 	return;
-    }
   }
-  NewPdcpBuffer[RCVD_COUNT] = params;
   if (RCVD_COUNT>= RX_NEXT){
 	  RX_NEXT = RCVD_COUNT +1;
   }
 
   if (outOfDelivery){
-	  std::map<uint64_t, LtePdcpSapUser::ReceivePdcpSduParameters> ::iterator it;
-	        for (it = NewPdcpBuffer.begin() ;it !=NewPdcpBuffer.end(); ++it){
-	        	m_pdcpSapUser->ReceivePdcpSdu(NewPdcpBuffer[it->first]);
-	        	NewPdcpBuffer.erase(it->first);
-	        }
+	        m_pdcpSapUser->ReceivePdcpSdu(params);
 	        return;
   	  }
+  m_rxWindow.Insert (RCVD_COUNT % MAX_PDCP_SN, RCVD_COUNT, params);
  // std::cout << RCVD_COUNT << "\t" <<RX_DELIV << std::endl;
   if (RCVD_COUNT == RX_DELIV){
- 	  temp_n = new uint64_t[(size_t)NewPdcpBuffer.size()+1];
- 	  std::map<uint64_t, LtePdcpSapUser::ReceivePdcpSduParameters> ::iterator it;
- 	  uint16_t i=0;
- 	    for (it = NewPdcpBuffer.begin() ;it !=NewPdcpBuffer.end(); ++it, ++i)
- 	        	  			temp_n[i]=it->first;
-
- 	        	  		std::sort(temp_n, temp_n + i);
-
- 	        	       uint64_t sum = temp_n[0];
- 	        	       uint16_t p=0;
- 	        	       while (sum == temp_n[p] && p!=NewPdcpBuffer.size()){
- 	        	          	   sum =temp_n[p]+1;
- 	        	          	   p++;
- 	        	             }
-
- 	    for (uint64_t c = 0 ; c< p; c++){
- 	      m_pdcpSapUser->ReceivePdcpSdu(NewPdcpBuffer[temp_n[c]]);
- 	      LAST_SUBMITED = temp_n[c];
- 		 printData("Reordered_SN", temp_n[c]);
- 	       NewPdcpBuffer.erase(temp_n[c]);
+ 	    // release the run of consecutive COUNTs that starts with the received one
+ 	    uint64_t c = RCVD_COUNT;
+ 	    while (m_rxWindow.IsBuffered (c % MAX_PDCP_SN) && m_rxWindow.GetCount (c % MAX_PDCP_SN) == c){
+ 	      m_pdcpSapUser->ReceivePdcpSdu(m_rxWindow.Remove (c % MAX_PDCP_SN));
+ 	      LAST_SUBMITED = c;
+ 		 printData("Reordered_SN", c);
  	      RX_DELIV =LAST_SUBMITED +1;
  	      if(RX_DELIV >= RX_RECORD)
  	    	  check = true;
  	      	if (RX_DELIV <RX_NEXT)
  	      		check_2 =true;
+ 	      c++;
  	        	            }
 
- 	        	     delete [] temp_n;
-
 
   }
   	RX_DELIV =LAST_SUBMITED +1;
@@ -786,50 +764,27 @@ McUePdcp::BufferingAndReordering_New(Ptr<Packet> p){ // sjkang
 void
 McUePdcp::t_ReorderingTimer_Expired_New(){
 	std::cout << "Reordering Timer is expired  " << RCVD_HFN << std::endl;
-	  std::map<uint64_t, LtePdcpSapUser::ReceivePdcpSduParameters> ::iterator it;
-	  // copy the SN from buffer for a while
-	  temp_n = new uint64_t [(size_t)NewPdcpBuffer.size()];
-	  int i=0;
-	  for (it = NewPdcpBuffer.begin();it !=NewPdcpBuffer.end(); ++it, ++i) {
-		  temp_n[i] = it->first;  }
-
 	// ETSI TS 136 323  5.1.2.4.2 procedure: when t- reordering expires
+	// walk the window from RX_DELIV: release the SDUs below RX_RECORD,
+	// then the run of consecutive COUNTs that follows
 	  LAST_SUBMITED = RX_RECORD;
-	  for (uint16_t c=0; c<i; c++)
+	  bool inRun = false;
+	  uint64_t c = RX_DELIV;
+	  for (uint32_t n = 0; n < MAX_PDCP_SN && m_rxWindow.GetNBuffered () > 0; n++, c++)
 	  {
-	    if (temp_n[c] < RX_RECORD )
+	    uint32_t slot = c % MAX_PDCP_SN;
+	    if (!m_rxWindow.IsBuffered (slot) || m_rxWindow.GetCount (slot) != c)
 	    {
-	      m_pdcpSapUser->ReceivePdcpSdu(NewPdcpBuffer[temp_n[c]]);
-	     LAST_SUBMITED =temp_n[c];
-	     printData("Reordered_SN", temp_n[c]);
-	      NewPdcpBuffer.erase(temp_n[c]);
+	      if (inRun)
+	        break;
+	      continue;
 	    }
+	    if (c >= RX_RECORD)
+	      inRun = true;
+	    m_pdcpSapUser->ReceivePdcpSdu(m_rxWindow.Remove (slot));
+	    LAST_SUBMITED = c;
+	    printData("Reordered_SN", c);
 	  }
-	  delete [] temp_n;
-	  i=0;
-
-
-	  temp_n =new uint64_t [(size_t)NewPdcpBuffer.size()+1];
-	  for (it = NewPdcpBuffer.begin();it !=NewPdcpBuffer.end(); ++it, ++i)
-		  temp_n[i] = it->first;
-
-	  // sort the SN in acsending order
-	  std::sort(temp_n , temp_n +i);
-
-	    uint64_t sum = temp_n[0],p=0;
-		  while (sum == temp_n[p] && p!= NewPdcpBuffer.size())
-		  {
-			  sum =temp_n[p]+1;
-			  p++;
-		  }
-
-		  for (uint16_t c = 0 ; c< p; c++)
-		  {
-			m_pdcpSapUser->ReceivePdcpSdu(NewPdcpBuffer[temp_n[c]]);
-			  printData("Reordered_SN", temp_n[c]);
-			  NewPdcpBuffer.erase(temp_n[c]);
-			  LAST_SUBMITED = temp_n[c];
-		  }
 		  RX_DELIV = LAST_SUBMITED;
 		SN[RX_DELIV] = RX_DELIV % MAX_PDCP_SN;
 		  HFN[RX_DELIV] = (RX_DELIV- SN[RX_DELIV])/MAX_PDCP_SN;
@@ -885,87 +840,52 @@ previousTime = Simulator :: Now();
   }*/
 
 
-  std::map<int, LtePdcpSapUser::ReceivePdcpSduParameters> ::iterator it;
-
-  // copy the SN from buffer for a while
-  temp = new int [(size_t)PdcpBuffer.size()];
-  int i=0;
-  for (it = PdcpBuffer.begin();it !=PdcpBuffer.end(); ++it, ++i) {
-	  temp[i] = it->first + RX_HFNbySN [it->first]*MAX_PDCP_SN;  }
-
-  // sort the SN in acsending order
-  std::sort(temp , temp +i);
-
 // ETSI TS 136 323  5.1.2.4.2 procedure: when t- reordering expires
-
-  for (uint16_t c=0; c<i; c++)
+// walk the window from the first missing SN: release the SDUs below
+// Reordering_PDCP_RX_COUNT, then the run of consecutive SNs that follows
+  bool inRun = false;
+  uint32_t sn = (Last_Submitted_PDCP_RX_SN + 1) % MAX_PDCP_SN;
+  for (uint32_t n = 0; n < MAX_PDCP_SN && m_rxWindow.GetNBuffered () > 0; n++, sn = (sn + 1) % MAX_PDCP_SN)
   {
-    if (temp[c] < Reordering_PDCP_RX_COUNT )
+    if (!m_rxWindow.IsBuffered (sn))
     {
-    	if (temp[c]> m_maxPdcpSn) temp[c] = temp[c] % MAX_PDCP_SN;
-      m_pdcpSapUser->ReceivePdcpSdu(PdcpBuffer[temp[c]]);
-
-     PdcpTag reorderingTag;
-    PdcpBuffer[temp[c]].pdcpSdu->RemovePacketTag(reorderingTag);
-    uint32_t reordering_delay = Simulator::Now().GetMicroSeconds() - reorderingTag.GetSenderTimestamp().GetMicroSeconds();
-	reorderingDelay <<Simulator::Now().GetSeconds()<<"\t"<< reordering_delay / 10e5 <<std::endl;
-
-
-    SumOfPacketSize +=PdcpBuffer[temp[c]].pdcpSdu->GetSize();//sjkang0718
-     Last_Submitted_PDCP_RX_SN =temp[c];
-     //printData("Reordered_SN", temp[c]);
-      PdcpBuffer.erase(temp[c]);
-      if(Last_Submitted_PDCP_RX_SN == Reordering_PDCP_RX_COUNT % MAX_PDCP_SN-1) check =true;
+      if (inRun)
+        break;
+      continue;
     }
+    if ((int64_t) m_rxWindow.GetCount (sn) >= Reordering_PDCP_RX_COUNT)
+      inRun = true;
+    DeliverReordered (sn);
   }
-  delete [] temp;
-  i=0;
-
 
-  temp =new int [(size_t)PdcpBuffer.size()+1];
-  for (it = PdcpBuffer.begin();it !=PdcpBuffer.end(); ++it, ++i)
-	  temp[i] = it->first + RX_HFNbySN[it->first]*MAX_PDCP_SN;
-
-  // sort the SN in acsending order
-  std::sort(temp , temp +i);
-
-  //if(temp[0]==Reordering_PDCP_RX_COUNT % MAX_PDCP_SN + 1 ){
-	  int sum = temp[0],p=0;
-	  while (sum == temp[p] && p!= (int)PdcpBuffer.size())
-	  {
-		  sum =temp[p]+1;
-		  p++;
-	  }
-
-	  for (uint16_t c = 0 ; c< p; c++)
-	  {
-		  if (temp[c]> m_maxPdcpSn) temp[c] = temp[c] % MAX_PDCP_SN;
-   // PdcpDelayCalculater(temp[c]);
-		  m_pdcpSapUser->ReceivePdcpSdu(PdcpBuffer[temp[c]]);
-		  PdcpTag reorderingTag;
-		    PdcpBuffer[temp[c]].pdcpSdu->RemovePacketTag(reorderingTag);
-		    uint32_t reordering_delay = Simulator::Now().GetMicroSeconds() - reorderingTag.GetSenderTimestamp().GetMicroSeconds();
-			reorderingDelay <<Simulator::Now().GetSeconds()<<"\t"<< reordering_delay / 10e5 <<std::endl;
-
-
-	  SumOfPacketSize +=PdcpBuffer[temp[c]].pdcpSdu->GetSize();//sjkang0718
-
-		 // printData("Reordered_SN", temp[c]);
-		  PdcpBuffer.erase(temp[c]);
-		  Last_Submitted_PDCP_RX_SN = temp[c];
-
-		  if(Last_Submitted_PDCP_RX_SN == Reordering_PDCP_RX_COUNT % MAX_PDCP_SN-1) check =true;
-	  }
-
- //}
-  delete [] temp;
-  if (PdcpBuffer.size()>=1 )
+  if (m_rxWindow.GetNBuffered () > 0)
   {
     Reordering_PDCP_RX_COUNT = Next_PDCP_RX_SN + present_RX_HFN *MAX_PDCP_SN;
 	//  Reordering_PDCP_RX_COUNT =Last_Submitted_PDCP_RX_SN+present_RX_HFN*MAX_PDCP_SN+1;
     t_ReorderingTimer= Simulator::Schedule(expiredTime, &McUePdcp::t_ReordringTimer_Expired, this);
   }
 }
+void
+McUePdcp::DeliverReordered (uint32_t sn)
+{
+  LtePdcpSapUser::ReceivePdcpSduParameters params = m_rxWindow.Remove (sn);
+
+  PdcpTag reorderingTag;
+  params.pdcpSdu->RemovePacketTag(reorderingTag);
+  uint32_t reordering_delay = Simulator::Now().GetMicroSeconds() - reorderingTag.GetSenderTimestamp().GetMicroSeconds();
+  reorderingDelay <<Simulator::Now().GetSeconds()<<"\t"<< reordering_delay / 10e5 <<std::endl;
+
+  SumOfPacketSize +=params.pdcpSdu->GetSize();//sjkang0718
+  orderdedSumOfPacket=SumOfPacketSize;
+  m_pdcpSapUser->ReceivePdcpSdu(params);
+  Last_Submitted_PDCP_RX_SN = sn;
+
+  if(Last_Submitted_PDCP_RX_SN == Reordering_PDCP_RX_COUNT % MAX_PDCP_SN -1)
+    check =true;
+  if(Last_Submitted_PDCP_RX_SN ==m_maxPdcpSn && Reordering_PDCP_RX_COUNT % MAX_PDCP_SN==0)
+    check =true;
+}
+
 std::ofstream OutFile1("pdcp_1_RX_SN.txt");
 std::ofstream OutFile2("pdcp_1_Reordered_SN.txt");
 //std::ofstream OutFile3("pdcp_1_RX_SN.txt");
@@ -999,7 +919,7 @@ McUePdcp::printData(std::string filename, uint16_t SN) // sjkang
         OutFile2.open ("1_Reordered_SN.txt");
       }
       OutFile2 << this<< "\t"<<Simulator::Now ().GetSeconds() << "\t"<< "Reordered SN " << "\t" << SN<<
-    	 "\t" <<RX_HFNbySN[SN] <<  std::endl;
+    	 "\t" <<present_RX_HFN <<  std::endl;
      }
 //}
   /*else
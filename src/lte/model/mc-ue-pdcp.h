@@ -31,6 +31,7 @@
 #include <ns3/lte-pdcp-sap.h>
 #include <ns3/lte-rlc-sap.h>
 #include <ns3/lte-pdcp.h>
+#include <ns3/lte-pdcp-rx-window.h>
 #include "ns3/network-module.h"
 namespace ns3 {
 
@@ -69,6 +70,7 @@ public:
   void printData(std::string filename, uint16_t SN);
   void t_ReordringTimer_Expired();
   void t_ReorderingTimer_Expired_New();
+  void DeliverReordered (uint32_t sn); // release the SDU buffered at sn to the upper layer
 
   /**
    * Set the ldid
@@ -167,6 +169,40 @@ public:
     (const uint16_t rnti, const uint8_t lcid,
      const uint32_t size, const uint64_t delay);
 
+  /**
+   * TracedCallback signature for the discard of a duplicated PDU.
+   *
+   * \param [in] rnti The C-RNTI identifying the UE.
+   * \param [in] lcid The logical channel id.
+   * \param [in] sn The PDCP sequence number.
+   * \param [in] usefulCellId The cell of the leg whose copy was delivered.
+   * \param [in] wastedCellId The cell of the leg of the discarded copy.
+   * \param [in] size The size of the discarded copy.
+   * \param [in] gain The time between the arrivals of the two copies.
+   */
+  typedef void (* DuplicateRxTracedCallback)
+    (uint16_t rnti, uint8_t lcid, uint16_t sn, uint16_t usefulCellId,
+     uint16_t wastedCellId, uint32_t size, Time gain);
+
+  /**
+   * Copies of the PDUs received from a leg
+   */
+  struct DuplicationStats
+  {
+    DuplicationStats ();
+
+    uint64_t rxPdus;      ///< PDUs received from the leg
+    uint64_t usefulPdus;  ///< PDUs of which this was the first copy
+    uint64_t wastedPdus;  ///< PDUs discarded as duplicates
+    uint64_t wastedBytes; ///< bytes of the PDUs discarded as duplicates
+  };
+
+  /**
+   * \param cellId the cell of a leg
+   * \return the copies received from the leg
+   */
+  DuplicationStats GetDuplicationStats (uint16_t cellId) const;
+
   /**
    * Switch between LTE and MmWave
    */
@@ -210,6 +246,16 @@ protected:
   TracedCallback<uint16_t, uint8_t, uint32_t, uint64_t> m_rxPdu;
   EventId t_ReorderingTimer;
 private:
+  /**
+   * Account for a copy of a PDU, first copies win
+   *
+   * \param sn the PDCP SN
+   * \param cellId the cell of the leg of the copy
+   * \param size the copy size
+   * \param duplicate true if another copy was received first
+   */
+  void RecordCopy (uint16_t sn, uint16_t cellId, uint32_t size, bool duplicate);
+
   /**
    * State variables. See section 7.1 in TS 36.323
    */
@@ -225,17 +271,15 @@ private:
   bool m_alwaysLteUplink;
   int  Last_Submitted_PDCP_RX_SN;
   /////sjkang for enabling reordering
-  int *temp ;
  Time  expiredTime;
  int receivedPDCP_SN;
     int  Reordering_PDCP_RX_COUNT;
     int Next_PDCP_RX_SN;
-    std::map <int,LtePdcpSapUser::ReceivePdcpSduParameters> PdcpBuffer;
+    LtePdcpReorderingWindow m_rxWindow; // SDUs waiting for reordering, indexed by SN
 
     uint64_t discardedPacketSize=0;
     uint32_t numberOfDiscaredPackets=0;
     static const int reorderingWindow =16384;//8192;//2048;
-    std::map<uint16_t, uint16_t>RX_HFNbySN;
     int present_RX_HFN;
     uint32_t 	SumOfPacketSize=0;
     uint32_t	 orderdedSumOfPacket=0;
@@ -246,7 +290,6 @@ private:
 ///////// for measuring SN difference
 
     int tempBuffer[100]; //sjkang0810
-    uint64_t *temp_n;
      Time tempTime; //sjkang0810
      Time previousTime;
      uint16_t counter=0;
@@ -263,7 +306,6 @@ private:
     bool firstPacket ;
 
 
-    std::map <uint64_t,LtePdcpSapUser::ReceivePdcpSduParameters> NewPdcpBuffer;
     std::map<uint64_t,uint16_t> HFN;
     std::map<uint64_t,uint32_t> SN;
     uint32_t RCVD_SN;
@@ -277,7 +319,16 @@ private:
 
     // for processing packet duplication
   //  std::map <uint16_t, uint16_t> checkPacketDuplication; //sjkang
-    std::vector<uint32_t> CheckSN;
+    LtePdcpDuplicateFilter m_duplicateFilter;
+
+    struct FirstCopy
+    {
+      Time arrival;
+      uint16_t cellId;
+    };
+    std::vector<FirstCopy> m_firstCopies; // indexed by SN
+    std::map<uint16_t, DuplicationStats> m_duplicationStats; // by cell ID
+    TracedCallback<uint16_t, uint8_t, uint16_t, uint16_t, uint16_t, uint32_t, Time> m_rxDuplicate;
 
 };
 
@@ -0,0 +1,635 @@
+/* -*-  Mode: C++; c-file-style: "gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "ns3/pdcp-split-algorithm.h"
+
+#include <ns3/log.h>
+#include <ns3/assert.h>
+#include <ns3/simulator.h>
+#include <ns3/double.h>
+#include <ns3/boolean.h>
+#include <ns3/uinteger.h>
+#include <ns3/trace-source-accessor.h>
+
+#include <limits>
+
+namespace ns3 {
+
+NS_LOG_COMPONENT_DEFINE ("PdcpSplitAlgorithm");
+
+///////////////////////////////////////////
+// PdcpSplitAlgorithm
+///////////////////////////////////////////
+
+NS_OBJECT_ENSURE_REGISTERED (PdcpSplitAlgorithm);
+
+PdcpSplitAlgorithm::LegState::LegState ()
+  : queueSize (0),
+    queueDelay (0),
+    bytesSinceReport (0),
+    rate (0),
+    reported (false)
+{
+}
+
+PdcpSplitAlgorithm::PdcpSplitAlgorithm ()
+  : m_localCellId (0),
+    m_ties (0)
+{
+  NS_LOG_FUNCTION (this);
+}
+
+PdcpSplitAlgorithm::~PdcpSplitAlgorithm ()
+{
+  NS_LOG_FUNCTION (this);
+}
+
+TypeId
+PdcpSplitAlgorithm::GetTypeId ()
+{
+  static TypeId tid = TypeId ("ns3::PdcpSplitAlgorithm")
+    .SetParent<Object> ()
+    .SetGroupName ("Lte")
+    .AddAttribute ("Alpha",
+                   "Weight of the history in the smoothed queueing delays and drain rates",
+                   DoubleValue (0.9),
+                   MakeDoubleAccessor (&PdcpSplitAlgorithm::m_alpha),
+                   MakeDoubleChecker<double> (0.0, 1.0))
+    .AddTraceSource ("LegSelected",
+                     "A PDU was given to a leg.",
+                     MakeTraceSourceAccessor (&PdcpSplitAlgorithm::m_legSelectedTrace),
+                     "ns3::PdcpSplitAlgorithm::LegSelectedTracedCallback")
+  ;
+  return tid;
+}
+
+void
+PdcpSplitAlgorithm::SetLegs (const std::vector<uint16_t> &legs)
+{
+  NS_LOG_FUNCTION (this << legs.size ());
+  if (legs == m_legs)
+    {
+      return;
+    }
+  m_legs = legs;
+  DoSetLegs ();
+}
+
+const std::vector<uint16_t> &
+PdcpSplitAlgorithm::GetLegs () const
+{
+  return m_legs;
+}
+
+void
+PdcpSplitAlgorithm::SetLocalCellId (uint16_t cellId)
+{
+  m_localCellId = cellId;
+}
+
+bool
+PdcpSplitAlgorithm::IsLocal (uint16_t cellId) const
+{
+  return m_localCellId != 0 && cellId == m_localCellId;
+}
+
+void
+PdcpSplitAlgorithm::DoSetLegs ()
+{
+}
+
+uint16_t
+PdcpSplitAlgorithm::SelectLeg (uint32_t size)
+{
+  NS_ASSERT_MSG (!m_legs.empty (), "No leg to split the bearer on");
+  uint32_t leg = DoSelectLeg (size);
+  NS_ASSERT_MSG (leg < m_legs.size (), "Invalid leg " << leg);
+  uint16_t cellId = m_legs[leg];
+  NotifyPduSent (cellId, size);
+  m_legSelectedTrace (cellId, size);
+  return cellId;
+}
+
+void
+PdcpSplitAlgorithm::NotifyPduSent (uint16_t cellId, uint32_t size)
+{
+  NS_LOG_LOGIC ("PDU of " << size << " bytes to cell " << cellId);
+  m_state[cellId].bytesSinceReport += size;
+}
+
+void
+PdcpSplitAlgorithm::ReportAssistantInfo (uint16_t cellId, const EpcX2Sap::AssistantInformationForSplitting &info)
+{
+  LegState &state = m_state[cellId];
+  uint32_t queueSize = info.Tx_On_Q_Size + info.Txed_Q_Size;
+  Time now = Simulator::Now ();
+
+  if (state.reported && now > state.lastReport)
+    {
+      // bytes that left the queue since the last report
+      double served = state.queueSize + state.bytesSinceReport - queueSize;
+      double rate = std::max (served, 0.0) / (now - state.lastReport).GetSeconds ();
+      state.rate = state.rate > 0 ? m_alpha * state.rate + (1 - m_alpha) * rate : rate;
+    }
+  state.queueDelay = (1 - m_alpha) * (double) info.Tx_On_Q_Delay / 10e3 + m_alpha * state.queueDelay;
+  state.queueSize = queueSize;
+  state.bytesSinceReport = 0;
+  state.lastReport = now;
+  state.reported = true;
+  NS_LOG_LOGIC ("cell " << cellId << " queue " << state.queueSize << " delay " << state.queueDelay
+                        << " rate " << state.rate);
+}
+
+int64_t
+PdcpSplitAlgorithm::AssignStreams (int64_t stream)
+{
+  return 0;
+}
+
+uint32_t
+PdcpSplitAlgorithm::GetQueueSize (uint16_t cellId) const
+{
+  std::map<uint16_t, LegState>::const_iterator it = m_state.find (cellId);
+  return it == m_state.end () ? 0 : it->second.queueSize;
+}
+
+double
+PdcpSplitAlgorithm::GetQueueDelay (uint16_t cellId) const
+{
+  std::map<uint16_t, LegState>::const_iterator it = m_state.find (cellId);
+  return it == m_state.end () ? 0 : it->second.queueDelay;
+}
+
+double
+PdcpSplitAlgorithm::GetBacklog (uint16_t cellId) const
+{
+  std::map<uint16_t, LegState>::const_iterator it = m_state.find (cellId);
+  return it == m_state.end () ? 0 : it->second.queueSize + it->second.bytesSinceReport;
+}
+
+double
+PdcpSplitAlgorithm::GetRate (uint16_t cellId) const
+{
+  std::map<uint16_t, LegState>::const_iterator it = m_state.find (cellId);
+  return it == m_state.end () ? 0 : it->second.rate;
+}
+
+uint32_t
+PdcpSplitAlgorithm::SelectMin (const std::vector<double> &values)
+{
+  std::vector<uint32_t> ties;
+  for (uint32_t i = 0; i < values.size (); i++)
+    {
+      if (ties.empty () || values[i] < values[ties[0]])
+        {
+          ties.assign (1, i);
+        }
+      else if (values[i] == values[ties[0]])
+        {
+          ties.push_back (i);
+        }
+    }
+  NS_ASSERT (!ties.empty ());
+  if (ties.size () == 1)
+    {
+      return ties[0];
+    }
+  return ties[m_ties++ % ties.size ()];
+}
+
+///////////////////////////////////////////
+// FixedPdcpSplitAlgorithm
+///////////////////////////////////////////
+
+NS_OBJECT_ENSURE_REGISTERED (FixedPdcpSplitAlgorithm);
+
+FixedPdcpSplitAlgorithm::FixedPdcpSplitAlgorithm ()
+{
+  NS_LOG_FUNCTION (this);
+}
+
+FixedPdcpSplitAlgorithm::~FixedPdcpSplitAlgorithm ()
+{
+  NS_LOG_FUNCTION (this);
+}
+
+TypeId
+FixedPdcpSplitAlgorithm::GetTypeId ()
+{
+  static TypeId tid = TypeId ("ns3::FixedPdcpSplitAlgorithm")
+    .SetParent<PdcpSplitAlgorithm> ()
+    .SetGroupName ("Lte")
+    .AddConstructor<FixedPdcpSplitAlgorithm> ()
+    .AddAttribute ("Leg",
+                   "Index of the leg that gets all the PDUs (the last one if there are less legs)",
+                   UintegerValue (0),
+                   MakeUintegerAccessor (&FixedPdcpSplitAlgorithm::m_leg),
+                   MakeUintegerChecker<uint32_t> ())
+  ;
+  return tid;
+}
+
+uint32_t
+FixedPdcpSplitAlgorithm::DoSelectLeg (uint32_t size)
+{
+  return std::min<uint32_t> (m_leg, GetLegs ().size () - 1);
+}
+
+///////////////////////////////////////////
+// RoundRobinPdcpSplitAlgorithm
+///////////////////////////////////////////
+
+NS_OBJECT_ENSURE_REGISTERED (RoundRobinPdcpSplitAlgorithm);
+
+RoundRobinPdcpSplitAlgorithm::RoundRobinPdcpSplitAlgorithm ()
+  : m_next (0)
+{
+  NS_LOG_FUNCTION (this);
+}
+
+RoundRobinPdcpSplitAlgorithm::~RoundRobinPdcpSplitAlgorithm ()
+{
+  NS_LOG_FUNCTION (this);
+}
+
+TypeId
+RoundRobinPdcpSplitAlgorithm::GetTypeId ()
+{
+  static TypeId tid = TypeId ("ns3::RoundRobinPdcpSplitAlgorithm")
+    .SetParent<PdcpSplitAlgorithm> ()
+    .SetGroupName ("Lte")
+    .AddConstructor<RoundRobinPdcpSplitAlgorithm> ()
+  ;
+  return tid;
+}
+
+uint32_t
+RoundRobinPdcpSplitAlgorithm::DoSelectLeg (uint32_t size)
+{
+  return m_next++ % GetLegs ().size ();
+}
+
+///////////////////////////////////////////
+// ProbabilisticPdcpSplitAlgorithm
+///////////////////////////////////////////
+
+NS_OBJECT_ENSURE_REGISTERED (ProbabilisticPdcpSplitAlgorithm);
+
+ProbabilisticPdcpSplitAlgorithm::ProbabilisticPdcpSplitAlgorithm ()
+{
+  NS_LOG_FUNCTION (this);
+  m_uniform = CreateObject<UniformRandomVariable> ();
+}
+
+ProbabilisticPdcpSplitAlgorithm::~ProbabilisticPdcpSplitAlgorithm ()
+{
+  NS_LOG_FUNCTION (this);
+}
+
+TypeId
+ProbabilisticPdcpSplitAlgorithm::GetTypeId ()
+{
+  static TypeId tid = TypeId ("ns3::ProbabilisticPdcpSplitAlgorithm")
+    .SetParent<PdcpSplitAlgorithm> ()
+    .SetGroupName ("Lte")
+    .AddConstructor<ProbabilisticPdcpSplitAlgorithm> ()
+    .AddAttribute ("FirstLegShare",
+                   "Initial share of the PDUs sent to the first leg",
+                   DoubleValue (0.5),
+                   MakeDoubleAccessor (&ProbabilisticPdcpSplitAlgorithm::m_firstLegShare),
+                   MakeDoubleChecker<double> (0.0, 1.0))
+    .AddAttribute ("Adaptive",
+                   "Move share from the leg with the longest queueing delay to the one with the shortest",
+                   BooleanValue (true),
+                   MakeBooleanAccessor (&ProbabilisticPdcpSplitAlgorithm::m_adaptive),
+                   MakeBooleanChecker ())
+    .AddAttribute ("Step",
+                   "Share moved at each PDU",
+                   DoubleValue (0.001),
+                   MakeDoubleAccessor (&ProbabilisticPdcpSplitAlgorithm::m_step),
+                   MakeDoubleChecker<double> (0.0, 1.0))
+    .AddAttribute ("DelayThreshold",
+                   "Smoothed queueing delay of a leg above which the shares adapt",
+                   DoubleValue (0.003),
+                   MakeDoubleAccessor (&ProbabilisticPdcpSplitAlgorithm::m_delayThreshold),
+                   MakeDoubleChecker<double> (0.0))
+    .AddTraceSource ("FirstLegShare",
+                     "Share of the first leg after an adaptation.",
+                     MakeTraceSourceAccessor (&ProbabilisticPdcpSplitAlgorithm::m_firstLegShareTrace),
+                     "ns3::ProbabilisticPdcpSplitAlgorithm::ShareTracedCallback")
+  ;
+  return tid;
+}
+
+int64_t
+ProbabilisticPdcpSplitAlgorithm::AssignStreams (int64_t stream)
+{
+  m_uniform->SetStream (stream);
+  return 1;
+}
+
+double
+ProbabilisticPdcpSplitAlgorithm::GetShare (uint32_t leg) const
+{
+  NS_ASSERT_MSG (leg < m_shares.size (), "Invalid leg " << leg);
+  return m_shares[leg];
+}
+
+void
+ProbabilisticPdcpSplitAlgorithm::DoSetLegs ()
+{
+  uint32_t n = GetLegs ().size ();
+  if (m_shares.size () == n)
+    {
+      // same number of legs, e.g. after a handover of one of them
+      return;
+    }
+  m_shares.assign (n, n > 1 ? (1 - m_firstLegShare) / (n - 1) : 0);
+  if (n > 0)
+    {
+      m_shares[0] = n > 1 ? m_firstLegShare : 1;
+    }
+}
+
+uint32_t
+ProbabilisticPdcpSplitAlgorithm::DoSelectLeg (uint32_t size)
+{
+  const std::vector<uint16_t> &legs = GetLegs ();
+  if (m_adaptive && legs.size () > 1)
+    {
+      uint32_t longest = 0;
+      uint32_t shortest = 0;
+      for (uint32_t i = 1; i < legs.size (); i++)
+        {
+          if (GetQueueDelay (legs[i]) >= GetQueueDelay (legs[longest]))
+            {
+              longest = i;
+            }
+          if (GetQueueDelay (legs[i]) < GetQueueDelay (legs[shortest]))
+            {
+              shortest = i;
+            }
+        }
+      if (GetQueueDelay (legs[longest]) > m_delayThreshold && longest != shortest)
+        {
+          double moved = std::min (m_step, m_shares[longest]);
+          m_shares[longest] -= moved;
+          m_shares[shortest] += moved;
+        }
+      m_firstLegShareTrace (m_shares[0]);
+    }
+
+  double u = m_uniform->GetValue (0.0, 1.0);
+  for (uint32_t i = 0; i < legs.size (); i++)
+    {
+      if (u < m_shares[i])
+        {
+          return i;
+        }
+      u -= m_shares[i];
+    }
+  return legs.size () - 1;
+}
+
+///////////////////////////////////////////
+// ShortestDelayPdcpSplitAlgorithm
+///////////////////////////////////////////
+
+NS_OBJECT_ENSURE_REGISTERED (ShortestDelayPdcpSplitAlgorithm);
+
+ShortestDelayPdcpSplitAlgorithm::ShortestDelayPdcpSplitAlgorithm ()
+{
+  NS_LOG_FUNCTION (this);
+}
+
+ShortestDelayPdcpSplitAlgorithm::~ShortestDelayPdcpSplitAlgorithm ()
+{
+  NS_LOG_FUNCTION (this);
+}
+
+TypeId
+ShortestDelayPdcpSplitAlgorithm::GetTypeId ()
+{
+  static TypeId tid = TypeId ("ns3::ShortestDelayPdcpSplitAlgorithm")
+    .SetParent<PdcpSplitAlgorithm> ()
+    .SetGroupName ("Lte")
+    .AddConstructor<ShortestDelayPdcpSplitAlgorithm> ()
+  ;
+  return tid;
+}
+
+uint32_t
+ShortestDelayPdcpSplitAlgorithm::DoSelectLeg (uint32_t size)
+{
+  const std::vector<uint16_t> &legs = GetLegs ();
+  std::vector<double> delays (legs.size ());
+  for (uint32_t i = 0; i < legs.size (); i++)
+    {
+      delays[i] = GetQueueDelay (legs[i]);
+    }
+  return SelectMin (delays);
+}
+
+///////////////////////////////////////////
+// ShortestQueuePdcpSplitAlgorithm
+///////////////////////////////////////////
+
+NS_OBJECT_ENSURE_REGISTERED (ShortestQueuePdcpSplitAlgorithm);
+
+ShortestQueuePdcpSplitAlgorithm::ShortestQueuePdcpSplitAlgorithm ()
+{
+  NS_LOG_FUNCTION (this);
+}
+
+ShortestQueuePdcpSplitAlgorithm::~ShortestQueuePdcpSplitAlgorithm ()
+{
+  NS_LOG_FUNCTION (this);
+}
+
+TypeId
+ShortestQueuePdcpSplitAlgorithm::GetTypeId ()
+{
+  static TypeId tid = TypeId ("ns3::ShortestQueuePdcpSplitAlgorithm")
+    .SetParent<PdcpSplitAlgorithm> ()
+    .SetGroupName ("Lte")
+    .AddConstructor<ShortestQueuePdcpSplitAlgorithm> ()
+  ;
+  return tid;
+}
+
+uint32_t
+ShortestQueuePdcpSplitAlgorithm::DoSelectLeg (uint32_t size)
+{
+  const std::vector<uint16_t> &legs = GetLegs ();
+  std::vector<double> queues (legs.size ());
+  for (uint32_t i = 0; i < legs.size (); i++)
+    {
+      queues[i] = GetQueueSize (legs[i]);
+    }
+  return SelectMin (queues);
+}
+
+///////////////////////////////////////////
+// DeliveryTimePdcpSplitAlgorithm
+///////////////////////////////////////////
+
+NS_OBJECT_ENSURE_REGISTERED (DeliveryTimePdcpSplitAlgorithm);
+
+DeliveryTimePdcpSplitAlgorithm::DeliveryTimePdcpSplitAlgorithm ()
+  : m_next (0)
+{
+  NS_LOG_FUNCTION (this);
+}
+
+DeliveryTimePdcpSplitAlgorithm::~DeliveryTimePdcpSplitAlgorithm ()
+{
+  NS_LOG_FUNCTION (this);
+}
+
+TypeId
+DeliveryTimePdcpSplitAlgorithm::GetTypeId ()
+{
+  static TypeId tid = TypeId ("ns3::DeliveryTimePdcpSplitAlgorithm")
+    .SetParent<PdcpSplitAlgorithm> ()
+    .SetGroupName ("Lte")
+    .AddConstructor<DeliveryTimePdcpSplitAlgorithm> ()
+    .AddAttribute ("X2Latency",
+                   "Latency added to the legs that go through the X2",
+                   TimeValue (MilliSeconds (1)),
+                   MakeTimeAccessor (&DeliveryTimePdcpSplitAlgorithm::m_x2Latency),
+                   MakeTimeChecker ())
+  ;
+  return tid;
+}
+
+double
+DeliveryTimePdcpSplitAlgorithm::GetDeliveryTime (uint32_t leg, uint32_t size) const
+{
+  uint16_t cellId = GetLegs ().at (leg);
+  double rate = GetRate (cellId);
+  if (rate <= 0)
+    {
+      return std::numeric_limits<double>::infinity ();
+    }
+  double latency = IsLocal (cellId) ? 0 : m_x2Latency.GetSeconds ();
+  return (GetBacklog (cellId) + size) / rate + latency;
+}
+
+uint32_t
+DeliveryTimePdcpSplitAlgorithm::DoSelectLeg (uint32_t size)
+{
+  const std::vector<uint16_t> &legs = GetLegs ();
+  std::vector<double> times (legs.size ());
+  for (uint32_t i = 0; i < legs.size (); i++)
+    {
+      if (GetRate (legs[i]) <= 0)
+        {
+          // probe the legs until they all have a rate
+          return m_next++ % legs.size ();
+        }
+      times[i] = GetDeliveryTime (i, size);
+    }
+  return SelectMin (times);
+}
+
+///////////////////////////////////////////
+// ProportionalPdcpSplitAlgorithm
+///////////////////////////////////////////
+
+NS_OBJECT_ENSURE_REGISTERED (ProportionalPdcpSplitAlgorithm);
+
+ProportionalPdcpSplitAlgorithm::ProportionalPdcpSplitAlgorithm ()
+{
+  NS_LOG_FUNCTION (this);
+}
+
+ProportionalPdcpSplitAlgorithm::~ProportionalPdcpSplitAlgorithm ()
+{
+  NS_LOG_FUNCTION (this);
+}
+
+TypeId
+ProportionalPdcpSplitAlgorithm::GetTypeId ()
+{
+  static TypeId tid = TypeId ("ns3::ProportionalPdcpSplitAlgorithm")
+    .SetParent<PdcpSplitAlgorithm> ()
+    .SetGroupName ("Lte")
+    .AddConstructor<ProportionalPdcpSplitAlgorithm> ()
+    .AddAttribute ("MaxBacklogTime",
+                   "Time to drain the backlog of a leg above which the leg gets no PDU",
+                   TimeValue (MilliSeconds (20)),
+                   MakeTimeAccessor (&ProportionalPdcpSplitAlgorithm::m_maxBacklogTime),
+                   MakeTimeChecker ())
+  ;
+  return tid;
+}
+
+void
+ProportionalPdcpSplitAlgorithm::DoSetLegs ()
+{
+  m_credits.assign (GetLegs ().size (), 0);
+}
+
+uint32_t
+ProportionalPdcpSplitAlgorithm::DoSelectLeg (uint32_t size)
+{
+  const std::vector<uint16_t> &legs = GetLegs ();
+  bool allRates = true;
+  for (uint32_t i = 0; i < legs.size (); i++)
+    {
+      allRates = allRates && GetRate (legs[i]) > 0;
+    }
+
+  double totalWeight = 0;
+  std::vector<double> drainTimes (legs.size ());
+  std::vector<bool> eligible (legs.size (), true);
+  for (uint32_t i = 0; i < legs.size (); i++)
+    {
+      if (allRates)
+        {
+          drainTimes[i] = GetBacklog (legs[i]) / GetRate (legs[i]);
+          eligible[i] = drainTimes[i] <= m_maxBacklogTime.GetSeconds ();
+        }
+      if (eligible[i])
+        {
+          totalWeight += allRates ? GetRate (legs[i]) : 1;
+        }
+    }
+  if (totalWeight == 0)
+    {
+      // every leg is backlogged, take the one that drains first
+      return SelectMin (drainTimes);
+    }
+
+  // smooth weighted round robin over the eligible legs
+  int32_t best = -1;
+  for (uint32_t i = 0; i < legs.size (); i++)
+    {
+      if (!eligible[i])
+        {
+          continue;
+        }
+      m_credits[i] += allRates ? GetRate (legs[i]) : 1;
+      if (best < 0 || m_credits[i] > m_credits[best])
+        {
+          best = i;
+        }
+    }
+  m_credits[best] -= totalWeight;
+  return best;
+}
+
+} // namespace ns3
@@ -0,0 +1,343 @@
+/* -*-  Mode: C++; c-file-style: "gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef PDCP_SPLIT_ALGORITHM_H
+#define PDCP_SPLIT_ALGORITHM_H
+
+#include <map>
+#include <vector>
+
+#include <ns3/object.h>
+#include <ns3/nstime.h>
+#include <ns3/traced-callback.h>
+#include <ns3/random-variable-stream.h>
+#include <ns3/epc-x2-sap.h>
+
+namespace ns3 {
+
+/**
+ * \brief The abstract base class of the split bearer schedulers of a
+ *        McEnbPdcp.
+ *
+ * A split algorithm picks, for each PDCP PDU, the cell (the leg) that
+ * transmits it among the legs of the bearer. The RLC of each leg reports
+ * its queue with an EpcX2Sap::AssistantInformationForSplitting, which the
+ * McEnbPdcp forwards to ReportAssistantInfo. From the reports and from the
+ * bytes given to each leg since, the base class keeps per leg
+ *  - the queue size and the smoothed queueing delay as reported,
+ *  - the backlog, i.e. the reported queue plus the bytes sent since,
+ *  - the smoothed drain rate of the queue.
+ *
+ * There can be any number of legs. The algorithm is selected with the
+ * McEnbPdcp "SplitAlgorithm" attribute.
+ */
+class PdcpSplitAlgorithm : public Object
+{
+public:
+  PdcpSplitAlgorithm ();
+  virtual ~PdcpSplitAlgorithm ();
+
+  // inherited from Object
+  static TypeId GetTypeId ();
+
+  /**
+   * TracedCallback signature for the leg selection of a PDU.
+   *
+   * \param [in] cellId The cell that transmits the PDU.
+   * \param [in] size The PDU size.
+   */
+  typedef void (* LegSelectedTracedCallback)(uint16_t cellId, uint32_t size);
+
+  /**
+   * \param legs the cell IDs of the legs of the bearer, the first leg
+   *             first. The state of the cells is kept across calls.
+   */
+  void SetLegs (const std::vector<uint16_t> &legs);
+
+  /**
+   * \return the cell IDs of the legs
+   */
+  const std::vector<uint16_t> & GetLegs () const;
+
+  /**
+   * \param cellId the cell of the PDCP entity, whose leg does not go
+   *               through the X2 (0 if none is)
+   */
+  void SetLocalCellId (uint16_t cellId);
+
+  /**
+   * \param cellId a cell ID
+   * \return true if the leg of the cell does not go through the X2
+   */
+  bool IsLocal (uint16_t cellId) const;
+
+  /**
+   * Pick the leg of a PDU and account for its bytes
+   *
+   * \param size the PDU size
+   * \return the cell ID of the leg
+   */
+  uint16_t SelectLeg (uint32_t size);
+
+  /**
+   * Account for the bytes of a PDU sent to a leg without SelectLeg, e.g. a
+   * duplicate
+   *
+   * \param cellId the cell ID of the leg
+   * \param size the PDU size
+   */
+  void NotifyPduSent (uint16_t cellId, uint32_t size);
+
+  /**
+   * Update the state of a leg with an RLC report
+   *
+   * \param cellId the cell of the reporting RLC
+   * \param info the report
+   */
+  void ReportAssistantInfo (uint16_t cellId, const EpcX2Sap::AssistantInformationForSplitting &info);
+
+  /**
+   * Assign fixed random variable stream numbers to the random variables
+   * used by this algorithm.
+   *
+   * \param stream first stream index to use
+   * \return the number of stream indices assigned by this algorithm
+   */
+  virtual int64_t AssignStreams (int64_t stream);
+
+  /// \return the reported RLC queue of the cell, in bytes
+  uint32_t GetQueueSize (uint16_t cellId) const;
+  /// \return the smoothed reported queueing delay of the cell
+  double GetQueueDelay (uint16_t cellId) const;
+  /// \return the reported queue of the cell plus the bytes sent to it since
+  double GetBacklog (uint16_t cellId) const;
+  /// \return the smoothed drain rate of the cell queue in bytes/s, 0 if unknown
+  double GetRate (uint16_t cellId) const;
+
+protected:
+  /**
+   * \param size the PDU size
+   * \return the index in GetLegs () of the leg of the PDU
+   */
+  virtual uint32_t DoSelectLeg (uint32_t size) = 0;
+
+  /**
+   * Called when the legs change
+   */
+  virtual void DoSetLegs ();
+
+  /**
+   * \param values a value per leg
+   * \return the index of the smallest value, ties broken in turn
+   */
+  uint32_t SelectMin (const std::vector<double> &values);
+
+private:
+  struct LegState
+  {
+    LegState ();
+
+    uint32_t queueSize;
+    double queueDelay;
+    double bytesSinceReport;
+    double rate;
+    Time lastReport;
+    bool reported;
+  };
+
+  std::vector<uint16_t> m_legs;
+  uint16_t m_localCellId;
+  std::map<uint16_t, LegState> m_state; ///< cell ID -> state
+  double m_alpha;
+  uint32_t m_ties;
+
+  TracedCallback<uint16_t, uint32_t> m_legSelectedTrace;
+};
+
+
+/**
+ * \brief Sends all the PDUs to one leg.
+ */
+class FixedPdcpSplitAlgorithm : public PdcpSplitAlgorithm
+{
+public:
+  FixedPdcpSplitAlgorithm ();
+  virtual ~FixedPdcpSplitAlgorithm ();
+  static TypeId GetTypeId ();
+
+protected:
+  virtual uint32_t DoSelectLeg (uint32_t size);
+
+private:
+  uint32_t m_leg;
+};
+
+
+/**
+ * \brief Sends the PDUs to the legs in turn.
+ */
+class RoundRobinPdcpSplitAlgorithm : public PdcpSplitAlgorithm
+{
+public:
+  RoundRobinPdcpSplitAlgorithm ();
+  virtual ~RoundRobinPdcpSplitAlgorithm ();
+  static TypeId GetTypeId ();
+
+protected:
+  virtual uint32_t DoSelectLeg (uint32_t size);
+
+private:
+  uint32_t m_next;
+};
+
+
+/**
+ * \brief Sends each PDU to a leg drawn at random with per leg shares
+ *        (p-split).
+ *
+ * The first leg starts with FirstLegShare, the others share the rest
+ * evenly. If Adaptive is set, whenever a leg delay is above
+ * DelayThreshold, Step is moved at each PDU from the share of the leg with
+ * the longest delay to the leg with the shortest one.
+ */
+class ProbabilisticPdcpSplitAlgorithm : public PdcpSplitAlgorithm
+{
+public:
+  ProbabilisticPdcpSplitAlgorithm ();
+  virtual ~ProbabilisticPdcpSplitAlgorithm ();
+  static TypeId GetTypeId ();
+
+  /**
+   * TracedCallback signature for the adaptation of the shares.
+   *
+   * \param [in] share The share of the first leg.
+   */
+  typedef void (* ShareTracedCallback)(double share);
+
+  virtual int64_t AssignStreams (int64_t stream);
+
+  /**
+   * \param leg an index in GetLegs ()
+   * \return the current share of the leg
+   */
+  double GetShare (uint32_t leg) const;
+
+protected:
+  virtual uint32_t DoSelectLeg (uint32_t size);
+  virtual void DoSetLegs ();
+
+private:
+  std::vector<double> m_shares;
+  double m_firstLegShare;
+  bool m_adaptive;
+  double m_step;
+  double m_delayThreshold;
+  Ptr<UniformRandomVariable> m_uniform;
+
+  /// share of the first leg after each adaptation
+  TracedCallback<double> m_firstLegShareTrace;
+};
+
+
+/**
+ * \brief Sends each PDU to the leg with the shortest smoothed queueing
+ *        delay (SDF).
+ */
+class ShortestDelayPdcpSplitAlgorithm : public PdcpSplitAlgorithm
+{
+public:
+  ShortestDelayPdcpSplitAlgorithm ();
+  virtual ~ShortestDelayPdcpSplitAlgorithm ();
+  static TypeId GetTypeId ();
+
+protected:
+  virtual uint32_t DoSelectLeg (uint32_t size);
+};
+
+
+/**
+ * \brief Sends each PDU to the leg with the shortest reported queue (SQF).
+ */
+class ShortestQueuePdcpSplitAlgorithm : public PdcpSplitAlgorithm
+{
+public:
+  ShortestQueuePdcpSplitAlgorithm ();
+  virtual ~ShortestQueuePdcpSplitAlgorithm ();
+  static TypeId GetTypeId ();
+
+protected:
+  virtual uint32_t DoSelectLeg (uint32_t size);
+};
+
+
+/**
+ * \brief Sends each PDU to the leg that would deliver it first.
+ *
+ * The expected delivery time of a PDU on a leg is its backlog plus the
+ * PDU over its drain rate, plus X2Latency for the legs that go through
+ * the X2. Until every leg has a rate estimate, PDUs are sent in turn.
+ */
+class DeliveryTimePdcpSplitAlgorithm : public PdcpSplitAlgorithm
+{
+public:
+  DeliveryTimePdcpSplitAlgorithm ();
+  virtual ~DeliveryTimePdcpSplitAlgorithm ();
+  static TypeId GetTypeId ();
+
+  /**
+   * \param leg an index in GetLegs ()
+   * \param size a PDU size
+   * \return the expected delivery time of the PDU on the leg, in seconds
+   */
+  double GetDeliveryTime (uint32_t leg, uint32_t size) const;
+
+protected:
+  virtual uint32_t DoSelectLeg (uint32_t size);
+
+private:
+  Time m_x2Latency;
+  uint32_t m_next;
+};
+
+
+/**
+ * \brief Splits the PDUs in proportion to the drain rates of the legs,
+ *        skipping the legs with too long a backlog.
+ *
+ * Smooth weighted round robin with the leg rates as weights. A leg whose
+ * backlog would take more than MaxBacklogTime to drain gets no PDU; if all
+ * the legs are so, the PDU goes to the leg that drains its backlog first.
+ * Until every leg has a rate estimate, the legs have the same weight.
+ */
+class ProportionalPdcpSplitAlgorithm : public PdcpSplitAlgorithm
+{
+public:
+  ProportionalPdcpSplitAlgorithm ();
+  virtual ~ProportionalPdcpSplitAlgorithm ();
+  static TypeId GetTypeId ();
+
+protected:
+  virtual uint32_t DoSelectLeg (uint32_t size);
+  virtual void DoSetLegs ();
+
+private:
+  std::vector<double> m_credits;
+  Time m_maxBacklogTime;
+};
+
+} // namespace ns3
+
+#endif // PDCP_SPLIT_ALGORITHM_H
@@ -0,0 +1,256 @@
+/* -*-  Mode: C++; c-file-style: "gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "ns3/test.h"
+#include "ns3/packet.h"
+#include "ns3/random-variable-stream.h"
+
+#include "ns3/lte-pdcp-rx-window.h"
+
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+#include <map>
+#include <vector>
+
+using namespace ns3;
+
+/**
+ * Time the receiving side of a dual connected PDCP entity on out of
+ * order arrival patterns: the SN-indexed window against the sorted
+ * std::map buffer and the SN list it replaces in McUePdcp.
+ */
+class LtePdcpRxWindowBenchmarkTestCase : public TestCase
+{
+public:
+  enum Pattern
+  {
+    IN_ORDER,  ///< a single path
+    DUAL_PATH, ///< odd SNs on a path lagging by a number of SDUs
+    SHUFFLED,  ///< random order within blocks of a number of SDUs
+    DUPLICATED ///< every SN on both paths, one lagging
+  };
+
+  LtePdcpRxWindowBenchmarkTestCase (Pattern pattern, uint32_t spread, uint32_t nSdus);
+
+private:
+  virtual void DoRun (void);
+  std::vector<uint64_t> MakeArrivals (void);
+  double RunWindow (const std::vector<uint64_t> &arrivals, uint64_t &delivered);
+  double RunLegacy (const std::vector<uint64_t> &arrivals, uint64_t &delivered);
+
+  Pattern m_pattern;
+  uint32_t m_spread;
+  uint32_t m_nSdus;
+  std::vector<LtePdcpSapUser::ReceivePdcpSduParameters> m_sdus;
+};
+
+static const uint32_t SN_SPACE = 32768;
+
+static std::string
+PatternName (LtePdcpRxWindowBenchmarkTestCase::Pattern pattern)
+{
+  switch (pattern)
+    {
+    case LtePdcpRxWindowBenchmarkTestCase::IN_ORDER:
+      return "in order";
+    case LtePdcpRxWindowBenchmarkTestCase::DUAL_PATH:
+      return "dual path";
+    case LtePdcpRxWindowBenchmarkTestCase::SHUFFLED:
+      return "shuffled";
+    default:
+      return "duplicated";
+    }
+}
+
+LtePdcpRxWindowBenchmarkTestCase::LtePdcpRxWindowBenchmarkTestCase (Pattern pattern, uint32_t spread, uint32_t nSdus)
+  : TestCase ("PDCP RX window, " + PatternName (pattern) + ", spread " + std::to_string (spread)),
+    m_pattern (pattern),
+    m_spread (spread),
+    m_nSdus (nSdus)
+{
+}
+
+std::vector<uint64_t>
+LtePdcpRxWindowBenchmarkTestCase::MakeArrivals (void)
+{
+  std::vector<uint64_t> arrivals;
+  switch (m_pattern)
+    {
+    case IN_ORDER:
+      for (uint64_t c = 0; c < m_nSdus; c++)
+        {
+          arrivals.push_back (c);
+        }
+      break;
+    case DUAL_PATH:
+    case DUPLICATED:
+      // the fast path carries the even SNs (all SNs if duplicated), the
+      // slow path the odd ones (all SNs), m_spread SDUs late
+      for (uint64_t c = 0; c < m_nSdus + m_spread; c++)
+        {
+          if (c < m_nSdus && (m_pattern == DUPLICATED || c % 2 == 0))
+            {
+              arrivals.push_back (c);
+            }
+          if (c >= m_spread && (m_pattern == DUPLICATED || (c - m_spread) % 2 == 1))
+            {
+              arrivals.push_back (c - m_spread);
+            }
+        }
+      break;
+    case SHUFFLED:
+      {
+        Ptr<UniformRandomVariable> rng = CreateObject<UniformRandomVariable> ();
+        rng->SetStream (1);
+        for (uint64_t block = 0; block < m_nSdus; block += m_spread)
+          {
+            std::vector<uint64_t> counts;
+            for (uint64_t c = block; c < std::min<uint64_t> (block + m_spread, m_nSdus); c++)
+              {
+                counts.push_back (c);
+              }
+            for (uint32_t i = counts.size (); i > 1; i--)
+              {
+                std::swap (counts[i - 1], counts[rng->GetInteger (0, i - 1)]);
+              }
+            arrivals.insert (arrivals.end (), counts.begin (), counts.end ());
+          }
+      }
+      break;
+    }
+  return arrivals;
+}
+
+double
+LtePdcpRxWindowBenchmarkTestCase::RunWindow (const std::vector<uint64_t> &arrivals, uint64_t &delivered)
+{
+  LtePdcpDuplicateFilter filter (SN_SPACE);
+  LtePdcpReorderingWindow window (SN_SPACE);
+  uint64_t cursor = 0;
+  delivered = 0;
+
+  std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now ();
+  for (uint32_t i = 0; i < arrivals.size (); i++)
+    {
+      uint32_t sn = arrivals[i] % SN_SPACE;
+      if (filter.IsDuplicate (sn) || arrivals[i] < cursor)
+        {
+          continue;
+        }
+      window.Insert (sn, arrivals[i], m_sdus[sn]);
+      while (window.IsBuffered (cursor % SN_SPACE))
+        {
+          window.Remove (cursor % SN_SPACE);
+          cursor++;
+          delivered++;
+        }
+    }
+  std::chrono::steady_clock::time_point end = std::chrono::steady_clock::now ();
+  return std::chrono::duration_cast<std::chrono::nanoseconds> (end - start).count ();
+}
+
+double
+LtePdcpRxWindowBenchmarkTestCase::RunLegacy (const std::vector<uint64_t> &arrivals, uint64_t &delivered)
+{
+  std::vector<uint32_t> checkSn;
+  std::map<uint64_t, LtePdcpSapUser::ReceivePdcpSduParameters> buffer;
+  uint64_t cursor = 0;
+  delivered = 0;
+
+  std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now ();
+  for (uint32_t i = 0; i < arrivals.size (); i++)
+    {
+      uint32_t sn = arrivals[i] % SN_SPACE;
+      if (std::find (checkSn.begin (), checkSn.end (), sn) != checkSn.end () || arrivals[i] < cursor)
+        {
+          continue;
+        }
+      checkSn.push_back (sn);
+      if (checkSn.size () == SN_SPACE / 2)
+        {
+          checkSn.erase (checkSn.begin (), checkSn.begin () + SN_SPACE / 4);
+        }
+      buffer[arrivals[i]] = m_sdus[sn];
+      if (arrivals[i] != cursor)
+        {
+          continue;
+        }
+
+      // copy, sort and release the consecutive COUNTs, as McUePdcp did
+      uint64_t *counts = new uint64_t[buffer.size ()];
+      uint32_t n = 0;
+      std::map<uint64_t, LtePdcpSapUser::ReceivePdcpSduParameters>::iterator it;
+      for (it = buffer.begin (); it != buffer.end (); ++it, ++n)
+        {
+          counts[n] = it->first;
+        }
+      std::sort (counts, counts + n);
+      for (uint32_t c = 0; c < n && counts[c] == cursor; c++)
+        {
+          buffer.erase (counts[c]);
+          cursor++;
+          delivered++;
+        }
+      delete [] counts;
+    }
+  std::chrono::steady_clock::time_point end = std::chrono::steady_clock::now ();
+  return std::chrono::duration_cast<std::chrono::nanoseconds> (end - start).count ();
+}
+
+void
+LtePdcpRxWindowBenchmarkTestCase::DoRun (void)
+{
+  m_sdus.resize (SN_SPACE);
+  for (uint32_t sn = 0; sn < SN_SPACE; sn++)
+    {
+      m_sdus[sn].pdcpSdu = Create<Packet> (100);
+      m_sdus[sn].rnti = 1;
+      m_sdus[sn].lcid = 3;
+    }
+  std::vector<uint64_t> arrivals = MakeArrivals ();
+
+  uint64_t windowDelivered;
+  uint64_t legacyDelivered;
+  double windowNs = RunWindow (arrivals, windowDelivered);
+  double legacyNs = RunLegacy (arrivals, legacyDelivered);
+  NS_TEST_ASSERT_MSG_EQ (windowDelivered, m_nSdus, "the window did not deliver all the SDUs");
+  NS_TEST_ASSERT_MSG_EQ (legacyDelivered, m_nSdus, "the sorted buffer did not deliver all the SDUs");
+
+  std::cout << "PDCP RX " << PatternName (m_pattern) << ", spread " << m_spread << ", "
+            << arrivals.size () << " arrivals: window " << windowNs / arrivals.size ()
+            << " ns/PDU, sorted buffer " << legacyNs / arrivals.size () << " ns/PDU" << std::endl;
+  m_sdus.clear ();
+}
+
+class LtePdcpRxWindowBenchmarkTestSuite : public TestSuite
+{
+public:
+  LtePdcpRxWindowBenchmarkTestSuite ();
+};
+
+LtePdcpRxWindowBenchmarkTestSuite::LtePdcpRxWindowBenchmarkTestSuite ()
+  : TestSuite ("lte-pdcp-rx-window-benchmark", PERFORMANCE)
+{
+  AddTestCase (new LtePdcpRxWindowBenchmarkTestCase (LtePdcpRxWindowBenchmarkTestCase::IN_ORDER, 0, 100000), TestCase::QUICK);
+  AddTestCase (new LtePdcpRxWindowBenchmarkTestCase (LtePdcpRxWindowBenchmarkTestCase::DUAL_PATH, 16, 100000), TestCase::QUICK);
+  AddTestCase (new LtePdcpRxWindowBenchmarkTestCase (LtePdcpRxWindowBenchmarkTestCase::SHUFFLED, 64, 100000), TestCase::QUICK);
+  AddTestCase (new LtePdcpRxWindowBenchmarkTestCase (LtePdcpRxWindowBenchmarkTestCase::DUPLICATED, 16, 100000), TestCase::QUICK);
+  AddTestCase (new LtePdcpRxWindowBenchmarkTestCase (LtePdcpRxWindowBenchmarkTestCase::DUAL_PATH, 1024, 100000), TestCase::EXTENSIVE);
+  AddTestCase (new LtePdcpRxWindowBenchmarkTestCase (LtePdcpRxWindowBenchmarkTestCase::SHUFFLED, 4096, 100000), TestCase::EXTENSIVE);
+}
+
+static LtePdcpRxWindowBenchmarkTestSuite ltePdcpRxWindowBenchmarkTestSuite;
@@ -0,0 +1,1210 @@
+/* -*-  Mode: C++; c-file-style: "gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "ns3/test.h"
+#include "ns3/log.h"
+#include "ns3/simulator.h"
+#include "ns3/enum.h"
+#include "ns3/packet.h"
+#include "ns3/ipv4-header.h"
+#include "ns3/udp-header.h"
+#include "ns3/udp-l4-protocol.h"
+#include "ns3/ipv4-l3-protocol.h"
+#include "ns3/mac48-address.h"
+#include "ns3/udp-socket-factory.h"
+#include "ns3/inet-socket-address.h"
+#include "ns3/internet-stack-helper.h"
+#include "ns3/ipv4-address-helper.h"
+#include "ns3/point-to-point-helper.h"
+#include "ns3/virtual-net-device.h"
+#include "ns3/epc-gtpu-header.h"
+#include "ns3/epc-sgw-pgw-application.h"
+#include <algorithm>
+
+using namespace ns3;
+
+NS_LOG_COMPONENT_DEFINE ("TestEpcSgwPgwApplication");
+
+/**
+ * MME side of the S11 SAP, keeping the TEIDs of the last session created
+ */
+class EpcSgwPgwTestMme : public EpcS11SapMme
+{
+public:
+  virtual void CreateSessionResponse (CreateSessionResponseMessage msg);
+  virtual void DeleteBearerRequest (DeleteBearerRequestMessage msg);
+  virtual void ModifyBearerResponse (ModifyBearerResponseMessage msg);
+
+  std::vector<uint32_t> m_teids;
+};
+
+void
+EpcSgwPgwTestMme::CreateSessionResponse (CreateSessionResponseMessage msg)
+{
+  m_teids.clear ();
+  for (std::list<BearerContextCreated>::iterator it = msg.bearerContextsCreated.begin ();
+       it != msg.bearerContextsCreated.end ();
+       ++it)
+    {
+      m_teids.push_back (it->sgwFteid.teid);
+    }
+}
+
+void
+EpcSgwPgwTestMme::DeleteBearerRequest (DeleteBearerRequestMessage msg)
+{
+}
+
+void
+EpcSgwPgwTestMme::ModifyBearerResponse (ModifyBearerResponseMessage msg)
+{
+}
+
+
+/**
+ * Base of the test cases of the SGW/PGW application: the application
+ * between its TUN device and an eNB reached over a point-to-point S1-U
+ * link, with the downlink packets written to the TUN device by the test
+ * and the uplink packets sent by the eNB. The packets carry a UDP datagram
+ * whose payload is a sequence number.
+ */
+class EpcSgwPgwTestCase : public TestCase
+{
+public:
+  EpcSgwPgwTestCase (std::string name);
+
+protected:
+  /// a packet delivered to the eNB (downlink) or to the TUN device (uplink)
+  struct Delivery
+  {
+    Ipv4Address ueAddress;
+    uint32_t teid;        ///< TEID of a downlink packet, 0 for uplink
+    uint32_t seq;
+    Time time;
+  };
+
+  /**
+   * Create the nodes and the application
+   */
+  void CreateGateway (void);
+
+  /**
+   * Destroy the nodes and the application
+   */
+  void DestroyGateway (void);
+
+  /**
+   * Add a UE and create its session, with a bearer per TFT
+   *
+   * \param imsi the IMSI of the UE
+   * \param ueAddress the address of the UE
+   * \param tfts the TFTs of the bearers, the default bearer first
+   * \return the TEIDs of the bearers
+   */
+  std::vector<uint32_t> AddUe (uint64_t imsi, Ipv4Address ueAddress,
+                               std::vector<Ptr<EpcTft> > tfts);
+
+  /**
+   * Create bearers of a UE, with a bearer per TFT
+   *
+   * \param imsi the IMSI of the UE
+   * \param tfts the TFTs of the bearers
+   * \param firstBearerId the EPS bearer ID of the first bearer
+   * \return the TEIDs of the bearers
+   */
+  std::vector<uint32_t> CreateBearers (uint64_t imsi, std::vector<Ptr<EpcTft> > tfts,
+                                       uint8_t firstBearerId);
+
+  /**
+   * Write a downlink packet to the TUN device
+   */
+  void SendDownlink (Ipv4Address ueAddress, uint32_t seq,
+                     uint16_t remotePort = 1234, uint16_t localPort = 5678);
+
+  /**
+   * Send an uplink packet from the eNB
+   */
+  void SendUplink (Ipv4Address ueAddress, uint32_t teid, uint32_t seq);
+
+  /**
+   * \return the deliveries to or from a UE, in their order
+   */
+  std::vector<Delivery> GetDeliveries (const std::vector<Delivery> &deliveries,
+                                       Ipv4Address ueAddress) const;
+
+  Ptr<EpcSgwPgwApplication> m_app;
+  std::vector<Delivery> m_downlink;
+  std::vector<Delivery> m_uplink;
+
+private:
+  static Ptr<Packet> CreateIpPacket (Ipv4Address source, Ipv4Address destination,
+                                     uint16_t sourcePort, uint16_t destinationPort,
+                                     uint32_t seq);
+  static uint32_t ReadSeq (Ptr<Packet> p, Ipv4Header &ipHeader);
+
+  void EnbReceive (Ptr<Socket> socket);
+  void TunReceive (Ptr<const Packet> p);
+
+  EpcSgwPgwTestMme m_mme;
+  Ptr<Node> m_pgw;
+  Ptr<Node> m_enb;
+  Ptr<Socket> m_enbSocket;
+  Ipv4Address m_pgwS1uAddress;
+  Ipv4Address m_enbS1uAddress;
+};
+
+static const Ipv4Address g_remoteAddress ("1.0.0.2");
+static const uint16_t g_gtpuPort = 2152;
+static const uint16_t g_cellId = 1;
+
+EpcSgwPgwTestCase::EpcSgwPgwTestCase (std::string name)
+  : TestCase (name)
+{
+}
+
+void
+EpcSgwPgwTestCase::CreateGateway (void)
+{
+  m_downlink.clear ();
+  m_uplink.clear ();
+  m_pgw = CreateObject<Node> ();
+  m_enb = CreateObject<Node> ();
+  InternetStackHelper internet;
+  internet.Install (m_pgw);
+  internet.Install (m_enb);
+
+  PointToPointHelper p2ph;
+  p2ph.SetDeviceAttribute ("DataRate", DataRateValue (DataRate ("10Gb/s")));
+  NetDeviceContainer s1uDevices = p2ph.Install (m_pgw, m_enb);
+  Ipv4AddressHelper s1uAddressHelper;
+  s1uAddressHelper.SetBase ("10.0.0.0", "255.255.255.252");
+  Ipv4InterfaceContainer s1uInterfaces = s1uAddressHelper.Assign (s1uDevices);
+  m_pgwS1uAddress = s1uInterfaces.GetAddress (0);
+  m_enbS1uAddress = s1uInterfaces.GetAddress (1);
+
+  // the TUN device has an address on the UE network, as in the EPC helpers
+  Ptr<VirtualNetDevice> tunDevice = CreateObject<VirtualNetDevice> ();
+  tunDevice->SetAddress (Mac48Address::Allocate ());
+  m_pgw->AddDevice (tunDevice);
+  Ipv4AddressHelper ueAddressHelper;
+  ueAddressHelper.SetBase ("7.0.0.0", "255.0.0.0");
+  ueAddressHelper.Assign (NetDeviceContainer (tunDevice));
+  tunDevice->TraceConnectWithoutContext ("MacRx", MakeCallback (&EpcSgwPgwTestCase::TunReceive, this));
+
+  Ptr<Socket> s1uSocket = Socket::CreateSocket (m_pgw, UdpSocketFactory::GetTypeId ());
+  s1uSocket->Bind (InetSocketAddress (Ipv4Address::GetAny (), g_gtpuPort));
+  m_app = CreateObject<EpcSgwPgwApplication> (tunDevice, s1uSocket);
+  m_pgw->AddApplication (m_app);
+  tunDevice->SetSendCallback (MakeCallback (&EpcSgwPgwApplication::RecvFromTunDevice, m_app));
+  m_app->SetS11SapMme (&m_mme);
+  m_app->AddEnb (g_cellId, m_enbS1uAddress, m_pgwS1uAddress);
+
+  m_enbSocket = Socket::CreateSocket (m_enb, UdpSocketFactory::GetTypeId ());
+  m_enbSocket->Bind (InetSocketAddress (m_enbS1uAddress, g_gtpuPort));
+  m_enbSocket->SetRecvCallback (MakeCallback (&EpcSgwPgwTestCase::EnbReceive, this));
+}
+
+void
+EpcSgwPgwTestCase::DestroyGateway (void)
+{
+  Simulator::Destroy ();
+  m_enbSocket = 0;
+  m_app = 0;
+  m_pgw = 0;
+  m_enb = 0;
+}
+
+std::vector<uint32_t>
+EpcSgwPgwTestCase::AddUe (uint64_t imsi, Ipv4Address ueAddress,
+                          std::vector<Ptr<EpcTft> > tfts)
+{
+  m_app->AddUe (imsi);
+  m_app->SetUeAddress (imsi, ueAddress);
+  return CreateBearers (imsi, tfts, 1);
+}
+
+std::vector<uint32_t>
+EpcSgwPgwTestCase::CreateBearers (uint64_t imsi, std::vector<Ptr<EpcTft> > tfts,
+                                  uint8_t firstBearerId)
+{
+  EpcS11SapSgw::CreateSessionRequestMessage req;
+  req.imsi = imsi;
+  req.uli.gci = g_cellId;
+  for (uint32_t i = 0; i < tfts.size (); i++)
+    {
+      EpcS11SapSgw::BearerContextToBeCreated bearer;
+      bearer.epsBearerId = firstBearerId + i;
+      bearer.bearerLevelQos = EpsBearer (EpsBearer::NGBR_VIDEO_TCP_DEFAULT);
+      bearer.tft = tfts[i];
+      req.bearerContextsToBeCreated.push_back (bearer);
+    }
+  m_app->GetS11SapSgw ()->CreateSessionRequest (req);
+  return m_mme.m_teids;
+}
+
+Ptr<Packet>
+EpcSgwPgwTestCase::CreateIpPacket (Ipv4Address source, Ipv4Address destination,
+                                   uint16_t sourcePort, uint16_t destinationPort,
+                                   uint32_t seq)
+{
+  uint8_t payload[4] = { (uint8_t) (seq >> 24), (uint8_t) (seq >> 16),
+                         (uint8_t) (seq >> 8), (uint8_t) seq };
+  Ptr<Packet> p = Create<Packet> (payload, sizeof (payload));
+  UdpHeader udpHeader;
+  udpHeader.SetSourcePort (sourcePort);
+  udpHeader.SetDestinationPort (destinationPort);
+  p->AddHeader (udpHeader);
+  Ipv4Header ipHeader;
+  ipHeader.SetSource (source);
+  ipHeader.SetDestination (destination);
+  ipHeader.SetProtocol (UdpL4Protocol::PROT_NUMBER);
+  ipHeader.SetPayloadSize (p->GetSize ());
+  ipHeader.SetTtl (64);
+  p->AddHeader (ipHeader);
+  return p;
+}
+
+uint32_t
+EpcSgwPgwTestCase::ReadSeq (Ptr<Packet> p, Ipv4Header &ipHeader)
+{
+  p->RemoveHeader (ipHeader);
+  UdpHeader udpHeader;
+  p->RemoveHeader (udpHeader);
+  uint8_t payload[4];
+  p->CopyData (payload, sizeof (payload));
+  return ((uint32_t) payload[0] << 24) | (payload[1] << 16) | (payload[2] << 8) | payload[3];
+}
+
+void
+EpcSgwPgwTestCase::SendDownlink (Ipv4Address ueAddress, uint32_t seq,
+                                 uint16_t remotePort, uint16_t localPort)
+{
+  Ptr<Packet> p = CreateIpPacket (g_remoteAddress, ueAddress, remotePort, localPort, seq);
+  m_app->RecvFromTunDevice (p, Address (), Address (), Ipv4L3Protocol::PROT_NUMBER);
+}
+
+void
+EpcSgwPgwTestCase::SendUplink (Ipv4Address ueAddress, uint32_t teid, uint32_t seq)
+{
+  Ptr<Packet> p = CreateIpPacket (ueAddress, g_remoteAddress, 5678, 1234, seq);
+  GtpuHeader gtpu;
+  gtpu.SetTeid (teid);
+  gtpu.SetLength (p->GetSize () + gtpu.GetSerializedSize () - 8);
+  p->AddHeader (gtpu);
+  m_enbSocket->SendTo (p, 0, InetSocketAddress (m_pgwS1uAddress, g_gtpuPort));
+}
+
+void
+EpcSgwPgwTestCase::EnbReceive (Ptr<Socket> socket)
+{
+  Ptr<Packet> p = socket->Recv ();
+  GtpuHeader gtpu;
+  p->RemoveHeader (gtpu);
+  Ipv4Header ipHeader;
+  Delivery delivery;
+  delivery.seq = ReadSeq (p, ipHeader);
+  delivery.ueAddress = ipHeader.GetDestination ();
+  delivery.teid = gtpu.GetTeid ();
+  delivery.time = Simulator::Now ();
+  m_downlink.push_back (delivery);
+}
+
+void
+EpcSgwPgwTestCase::TunReceive (Ptr<const Packet> p)
+{
+  Ipv4Header ipHeader;
+  Delivery delivery;
+  delivery.seq = ReadSeq (p->Copy (), ipHeader);
+  delivery.ueAddress = ipHeader.GetSource ();
+  delivery.teid = 0;
+  delivery.time = Simulator::Now ();
+  m_uplink.push_back (delivery);
+}
+
+std::vector<EpcSgwPgwTestCase::Delivery>
+EpcSgwPgwTestCase::GetDeliveries (const std::vector<Delivery> &deliveries,
+                                  Ipv4Address ueAddress) const
+{
+  std::vector<Delivery> ueDeliveries;
+  for (uint32_t i = 0; i < deliveries.size (); i++)
+    {
+      if (deliveries[i].ueAddress == ueAddress)
+        {
+          ueDeliveries.push_back (deliveries[i]);
+        }
+    }
+  return ueDeliveries;
+}
+
+
+/**
+ * Migrate the context of one of two UEs, with downlink and uplink packets
+ * of both UEs before, during and after the migration
+ */
+class EpcSgwPgwMigrationTestCase : public EpcSgwPgwTestCase
+{
+public:
+  EpcSgwPgwMigrationTestCase (EpcSgwPgwApplication::MigrationPolicy policy);
+
+private:
+  virtual void DoRun (void);
+
+  void QueueDepth (uint32_t oldValue, uint32_t newValue);
+  void Stall (uint64_t imsi, Time stall, uint32_t released);
+  void Drop (Ptr<const Packet> p, uint64_t imsi);
+
+  EpcSgwPgwApplication::MigrationPolicy m_policy;
+  uint32_t m_maxQueueDepth;
+  uint32_t m_queueDepth;
+  std::vector<uint64_t> m_stallImsis;
+  std::vector<Time> m_stalls;
+  std::vector<uint32_t> m_released;
+  std::vector<uint64_t> m_dropImsis;
+};
+
+EpcSgwPgwMigrationTestCase::EpcSgwPgwMigrationTestCase (EpcSgwPgwApplication::MigrationPolicy policy)
+  : EpcSgwPgwTestCase (policy == EpcSgwPgwApplication::MIGRATION_BUFFER
+                       ? "Buffer policy" : "Drop policy"),
+    m_policy (policy)
+{
+}
+
+void
+EpcSgwPgwMigrationTestCase::QueueDepth (uint32_t oldValue, uint32_t newValue)
+{
+  m_queueDepth = newValue;
+  m_maxQueueDepth = std::max (m_maxQueueDepth, newValue);
+}
+
+void
+EpcSgwPgwMigrationTestCase::Stall (uint64_t imsi, Time stall, uint32_t released)
+{
+  m_stallImsis.push_back (imsi);
+  m_stalls.push_back (stall);
+  m_released.push_back (released);
+}
+
+void
+EpcSgwPgwMigrationTestCase::Drop (Ptr<const Packet> p, uint64_t imsi)
+{
+  m_dropImsis.push_back (imsi);
+}
+
+void
+EpcSgwPgwMigrationTestCase::DoRun (void)
+{
+  m_maxQueueDepth = 0;
+  m_queueDepth = 0;
+  CreateGateway ();
+  m_app->SetAttribute ("MigrationPolicy", EnumValue (m_policy));
+  m_app->TraceConnectWithoutContext ("MigrationQueueDepth", MakeCallback (&EpcSgwPgwMigrationTestCase::QueueDepth, this));
+  m_app->TraceConnectWithoutContext ("MigrationStall", MakeCallback (&EpcSgwPgwMigrationTestCase::Stall, this));
+  m_app->TraceConnectWithoutContext ("MigrationDrop", MakeCallback (&EpcSgwPgwMigrationTestCase::Drop, this));
+
+  Ipv4Address ue1 ("7.0.0.2");
+  Ipv4Address ue2 ("7.0.0.3");
+  std::vector<Ptr<EpcTft> > tfts (1, EpcTft::Default ());
+  uint32_t teid1 = AddUe (1, ue1, tfts)[0];
+  uint32_t teid2 = AddUe (2, ue2, tfts)[0];
+
+  // UE 1 migrates from 1 s to 1.1 s: packets 1 to 5 of both UEs are sent
+  // during its migration, packet 0 before and packet 6 after
+  Time start = Seconds (1);
+  Time duration = MilliSeconds (100);
+  void (EpcSgwPgwApplication::*startMigration) (uint64_t, Time) = &EpcSgwPgwApplication::StartMigration;
+  Simulator::Schedule (start, startMigration, m_app, 1, duration);
+  for (uint32_t seq = 0; seq <= 6; seq++)
+    {
+      Time t = start + MilliSeconds (20 * seq) - MilliSeconds (10);
+      Simulator::Schedule (t, &EpcSgwPgwMigrationTestCase::SendDownlink, this, ue1, seq, 1234, 5678);
+      Simulator::Schedule (t, &EpcSgwPgwMigrationTestCase::SendDownlink, this, ue2, seq, 1234, 5678);
+      Simulator::Schedule (t, &EpcSgwPgwMigrationTestCase::SendUplink, this, ue1, teid1, seq);
+      Simulator::Schedule (t, &EpcSgwPgwMigrationTestCase::SendUplink, this, ue2, teid2, seq);
+    }
+  Simulator::Stop (Seconds (2));
+  Simulator::Run ();
+
+  // the migration ended once, after its duration
+  NS_TEST_ASSERT_MSG_EQ (m_stallImsis.size (), 1, "one migration expected to end");
+  NS_TEST_ASSERT_MSG_EQ (m_stallImsis[0], 1, "wrong IMSI in MigrationStall");
+  NS_TEST_ASSERT_MSG_EQ (m_stalls[0], duration, "wrong stall in MigrationStall");
+  NS_TEST_ASSERT_MSG_EQ (m_queueDepth, 0, "packets left in the migration buffer");
+
+  std::vector<Delivery> dl1 = GetDeliveries (m_downlink, ue1);
+  std::vector<Delivery> ul1 = GetDeliveries (m_uplink, ue1);
+  if (m_policy == EpcSgwPgwApplication::MIGRATION_BUFFER)
+    {
+      // packets 1 to 5 of each direction held, and released in order at the end
+      NS_TEST_ASSERT_MSG_EQ (m_released[0], 10, "wrong number of released packets");
+      NS_TEST_ASSERT_MSG_EQ (m_maxQueueDepth, 10, "wrong MigrationQueueDepth");
+      NS_TEST_ASSERT_MSG_EQ (m_dropImsis.size (), 0, "no drop expected");
+      NS_TEST_ASSERT_MSG_EQ (dl1.size (), 7, "wrong number of downlink packets of UE 1");
+      NS_TEST_ASSERT_MSG_EQ (ul1.size (), 7, "wrong number of uplink packets of UE 1");
+      for (uint32_t i = 0; i < dl1.size () && i < ul1.size (); i++)
+        {
+          NS_TEST_ASSERT_MSG_EQ (dl1[i].seq, i, "downlink packets of UE 1 reordered");
+          NS_TEST_ASSERT_MSG_EQ (ul1[i].seq, i, "uplink packets of UE 1 reordered");
+          NS_TEST_ASSERT_MSG_EQ (dl1[i].teid, teid1, "wrong TEID of UE 1");
+          if (i >= 1 && i <= 5)
+            {
+              NS_TEST_ASSERT_MSG_GT_OR_EQ (dl1[i].time, start + duration, "downlink packet " << i << " released early");
+              NS_TEST_ASSERT_MSG_GT_OR_EQ (ul1[i].time, start + duration, "uplink packet " << i << " released early");
+            }
+        }
+    }
+  else
+    {
+      // packets 1 to 5 of each direction dropped, the others delivered
+      NS_TEST_ASSERT_MSG_EQ (m_released[0], 0, "no packet expected to be released");
+      NS_TEST_ASSERT_MSG_EQ (m_maxQueueDepth, 0, "no packet expected to be held");
+      NS_TEST_ASSERT_MSG_EQ (m_dropImsis.size (), 10, "wrong number of MigrationDrop");
+      for (uint32_t i = 0; i < m_dropImsis.size (); i++)
+        {
+          NS_TEST_ASSERT_MSG_EQ (m_dropImsis[i], 1, "wrong IMSI in MigrationDrop");
+        }
+      NS_TEST_ASSERT_MSG_EQ (dl1.size (), 2, "wrong number of downlink packets of UE 1");
+      NS_TEST_ASSERT_MSG_EQ (ul1.size (), 2, "wrong number of uplink packets of UE 1");
+      for (uint32_t i = 0; i < dl1.size () && i < ul1.size (); i++)
+        {
+          NS_TEST_ASSERT_MSG_EQ (dl1[i].seq, i * 6, "wrong downlink packet of UE 1");
+          NS_TEST_ASSERT_MSG_EQ (ul1[i].seq, i * 6, "wrong uplink packet of UE 1");
+        }
+    }
+
+  // UE 2 is not affected: all its packets delivered in order as they are sent
+  std::vector<Delivery> dl2 = GetDeliveries (m_downlink, ue2);
+  std::vector<Delivery> ul2 = GetDeliveries (m_uplink, ue2);
+  NS_TEST_ASSERT_MSG_EQ (dl2.size (), 7, "wrong number of downlink packets of UE 2");
+  NS_TEST_ASSERT_MSG_EQ (ul2.size (), 7, "wrong number of uplink packets of UE 2");
+  for (uint32_t i = 0; i < dl2.size () && i < ul2.size (); i++)
+    {
+      NS_TEST_ASSERT_MSG_EQ (dl2[i].seq, i, "downlink packets of UE 2 reordered");
+      NS_TEST_ASSERT_MSG_EQ (ul2[i].seq, i, "uplink packets of UE 2 reordered");
+      NS_TEST_ASSERT_MSG_EQ (dl2[i].teid, teid2, "wrong TEID of UE 2");
+      if (i >= 1 && i <= 5)
+        {
+          NS_TEST_ASSERT_MSG_LT (dl2[i].time, start + duration, "downlink packet " << i << " of UE 2 delayed");
+          NS_TEST_ASSERT_MSG_LT (ul2[i].time, start + duration, "uplink packet " << i << " of UE 2 delayed");
+        }
+    }
+
+  DestroyGateway ();
+}
+
+
+class EpcSgwPgwMigrationTestSuite : public TestSuite
+{
+public:
+  EpcSgwPgwMigrationTestSuite ();
+};
+
+EpcSgwPgwMigrationTestSuite::EpcSgwPgwMigrationTestSuite ()
+  : TestSuite ("epc-sgw-pgw-migration", UNIT)
+{
+  AddTestCase (new EpcSgwPgwMigrationTestCase (EpcSgwPgwApplication::MIGRATION_BUFFER), TestCase::QUICK);
+  AddTestCase (new EpcSgwPgwMigrationTestCase (EpcSgwPgwApplication::MIGRATION_DROP), TestCase::QUICK);
+}
+
+static EpcSgwPgwMigrationTestSuite epcSgwPgwMigrationTestSuite;
+
+
+/**
+ * Base of the test cases of the worker instances, recording their traces
+ */
+class EpcSgwPgwWorkerTestCase : public EpcSgwPgwTestCase
+{
+public:
+  EpcSgwPgwWorkerTestCase (std::string name);
+
+protected:
+  /**
+   * Create the nodes and the application, and connect the worker traces
+   */
+  void CreateWorkerGateway (void);
+
+  /**
+   * \return the size of the packets sent by SendDownlink
+   */
+  static uint32_t GetDownlinkSize (void);
+
+  std::vector<std::pair<uint32_t, Time> > m_delays;
+  std::vector<uint32_t> m_drops;
+  std::vector<uint64_t> m_changeImsis;
+  std::vector<std::pair<uint32_t, uint32_t> > m_changes;
+  uint32_t m_maxQueueDepth;
+
+private:
+  void Queue (uint32_t workerId, uint32_t depth);
+  void Delay (uint32_t workerId, Time delay);
+  void Drop (Ptr<const Packet> p, uint32_t workerId);
+  void Change (uint64_t imsi, uint32_t from, uint32_t to);
+};
+
+EpcSgwPgwWorkerTestCase::EpcSgwPgwWorkerTestCase (std::string name)
+  : EpcSgwPgwTestCase (name)
+{
+}
+
+void
+EpcSgwPgwWorkerTestCase::CreateWorkerGateway (void)
+{
+  m_delays.clear ();
+  m_drops.clear ();
+  m_changeImsis.clear ();
+  m_changes.clear ();
+  m_maxQueueDepth = 0;
+  CreateGateway ();
+  m_app->TraceConnectWithoutContext ("WorkerQueue", MakeCallback (&EpcSgwPgwWorkerTestCase::Queue, this));
+  m_app->TraceConnectWithoutContext ("WorkerDelay", MakeCallback (&EpcSgwPgwWorkerTestCase::Delay, this));
+  m_app->TraceConnectWithoutContext ("WorkerDrop", MakeCallback (&EpcSgwPgwWorkerTestCase::Drop, this));
+  m_app->TraceConnectWithoutContext ("WorkerChange", MakeCallback (&EpcSgwPgwWorkerTestCase::Change, this));
+}
+
+uint32_t
+EpcSgwPgwWorkerTestCase::GetDownlinkSize (void)
+{
+  // IPv4 and UDP headers, and the sequence number
+  return 20 + 8 + 4;
+}
+
+void
+EpcSgwPgwWorkerTestCase::Queue (uint32_t workerId, uint32_t depth)
+{
+  m_maxQueueDepth = std::max (m_maxQueueDepth, depth);
+}
+
+void
+EpcSgwPgwWorkerTestCase::Delay (uint32_t workerId, Time delay)
+{
+  m_delays.push_back (std::make_pair (workerId, delay));
+}
+
+void
+EpcSgwPgwWorkerTestCase::Drop (Ptr<const Packet> p, uint32_t workerId)
+{
+  m_drops.push_back (workerId);
+}
+
+void
+EpcSgwPgwWorkerTestCase::Change (uint64_t imsi, uint32_t from, uint32_t to)
+{
+  m_changeImsis.push_back (imsi);
+  m_changes.push_back (std::make_pair (from, to));
+}
+
+
+/**
+ * The delay of the packets at a worker is their processing time at its
+ * processing rate, plus the processing time of the packets ahead of them
+ */
+class EpcSgwPgwWorkerDelayTestCase : public EpcSgwPgwWorkerTestCase
+{
+public:
+  EpcSgwPgwWorkerDelayTestCase ();
+
+private:
+  virtual void DoRun (void);
+};
+
+EpcSgwPgwWorkerDelayTestCase::EpcSgwPgwWorkerDelayTestCase ()
+  : EpcSgwPgwWorkerTestCase ("Worker service delay")
+{
+}
+
+void
+EpcSgwPgwWorkerDelayTestCase::DoRun (void)
+{
+  CreateWorkerGateway ();
+  DataRate processingRate ("1Mb/s");
+  uint32_t workerId = m_app->AddWorker (processingRate, 10);
+  Ipv4Address ue ("7.0.0.2");
+  uint32_t teid = AddUe (1, ue, std::vector<Ptr<EpcTft> > (1, EpcTft::Default ()))[0];
+
+  // a packet alone, then three packets at once
+  Simulator::Schedule (Seconds (1), &EpcSgwPgwWorkerDelayTestCase::SendDownlink, this, ue, 0, 1234, 5678);
+  for (uint32_t seq = 1; seq <= 3; seq++)
+    {
+      Simulator::Schedule (Seconds (2), &EpcSgwPgwWorkerDelayTestCase::SendDownlink, this, ue, seq, 1234, 5678);
+    }
+  Simulator::Stop (Seconds (3));
+  Simulator::Run ();
+
+  Time serviceTime = processingRate.CalculateBytesTxTime (GetDownlinkSize ());
+  NS_TEST_ASSERT_MSG_EQ (m_app->GetWorkerOfUe (1), workerId, "UE not assigned to the worker");
+  NS_TEST_ASSERT_MSG_EQ (m_delays.size (), 4, "wrong number of processed packets");
+  uint32_t ahead[] = { 0, 0, 1, 2 };
+  for (uint32_t i = 0; i < m_delays.size (); i++)
+    {
+      NS_TEST_ASSERT_MSG_EQ (m_delays[i].first, workerId, "wrong worker in WorkerDelay");
+      NS_TEST_ASSERT_MSG_EQ (m_delays[i].second, serviceTime * (ahead[i] + 1), "wrong delay of packet " << i);
+    }
+  NS_TEST_ASSERT_MSG_EQ (m_maxQueueDepth, 3, "wrong WorkerQueue");
+  NS_TEST_ASSERT_MSG_EQ (m_drops.size (), 0, "no drop expected");
+
+  std::vector<Delivery> dl = GetDeliveries (m_downlink, ue);
+  NS_TEST_ASSERT_MSG_EQ (dl.size (), 4, "wrong number of downlink packets");
+  for (uint32_t i = 0; i < dl.size (); i++)
+    {
+      NS_TEST_ASSERT_MSG_EQ (dl[i].seq, i, "downlink packets reordered");
+      NS_TEST_ASSERT_MSG_EQ (dl[i].teid, teid, "wrong TEID");
+    }
+  NS_TEST_ASSERT_MSG_GT_OR_EQ (dl[0].time, Seconds (1) + serviceTime, "packet forwarded before its processing");
+  NS_TEST_ASSERT_MSG_GT_OR_EQ (dl[3].time, Seconds (2) + serviceTime * 3, "packet forwarded before its processing");
+
+  DestroyGateway ();
+}
+
+
+/**
+ * The packets arriving at a worker whose queue is full are dropped
+ */
+class EpcSgwPgwWorkerDropTestCase : public EpcSgwPgwWorkerTestCase
+{
+public:
+  EpcSgwPgwWorkerDropTestCase ();
+
+private:
+  virtual void DoRun (void);
+};
+
+EpcSgwPgwWorkerDropTestCase::EpcSgwPgwWorkerDropTestCase ()
+  : EpcSgwPgwWorkerTestCase ("Worker queue full")
+{
+}
+
+void
+EpcSgwPgwWorkerDropTestCase::DoRun (void)
+{
+  CreateWorkerGateway ();
+  uint32_t workerId = m_app->AddWorker (DataRate ("1Mb/s"), 2);
+  Ipv4Address ue ("7.0.0.2");
+  AddUe (1, ue, std::vector<Ptr<EpcTft> > (1, EpcTft::Default ()));
+
+  // packet 0 is processed while 1 and 2 wait, and 3 and 4 are dropped
+  for (uint32_t seq = 0; seq <= 4; seq++)
+    {
+      Simulator::Schedule (Seconds (1), &EpcSgwPgwWorkerDropTestCase::SendDownlink, this, ue, seq, 1234, 5678);
+    }
+  Simulator::Stop (Seconds (2));
+  Simulator::Run ();
+
+  NS_TEST_ASSERT_MSG_EQ (m_drops.size (), 2, "wrong number of WorkerDrop");
+  for (uint32_t i = 0; i < m_drops.size (); i++)
+    {
+      NS_TEST_ASSERT_MSG_EQ (m_drops[i], workerId, "wrong worker in WorkerDrop");
+    }
+  NS_TEST_ASSERT_MSG_EQ (m_maxQueueDepth, 3, "wrong WorkerQueue");
+  std::vector<Delivery> dl = GetDeliveries (m_downlink, ue);
+  NS_TEST_ASSERT_MSG_EQ (dl.size (), 3, "wrong number of downlink packets");
+  for (uint32_t i = 0; i < dl.size (); i++)
+    {
+      NS_TEST_ASSERT_MSG_EQ (dl[i].seq, i, "wrong downlink packet");
+    }
+
+  DestroyGateway ();
+}
+
+
+/**
+ * A worker removed with packets waiting: its UEs and its packets move to
+ * the remaining worker, without loss nor reordering
+ */
+class EpcSgwPgwWorkerRemoveTestCase : public EpcSgwPgwWorkerTestCase
+{
+public:
+  EpcSgwPgwWorkerRemoveTestCase ();
+
+private:
+  virtual void DoRun (void);
+  void RemoveWorker (uint32_t workerId);
+
+  std::list<uint64_t> m_moved;
+};
+
+EpcSgwPgwWorkerRemoveTestCase::EpcSgwPgwWorkerRemoveTestCase ()
+  : EpcSgwPgwWorkerTestCase ("Worker removal")
+{
+}
+
+void
+EpcSgwPgwWorkerRemoveTestCase::RemoveWorker (uint32_t workerId)
+{
+  m_moved = m_app->RemoveWorker (workerId);
+}
+
+void
+EpcSgwPgwWorkerRemoveTestCase::DoRun (void)
+{
+  CreateWorkerGateway ();
+  DataRate processingRate ("100kb/s");
+  uint32_t workerId1 = m_app->AddWorker (processingRate, 100);
+  uint32_t workerId2 = m_app->AddWorker (processingRate, 100);
+  const uint32_t nUes = 4;
+  std::vector<Ipv4Address> ues;
+  for (uint32_t i = 0; i < nUes; i++)
+    {
+      ues.push_back (Ipv4Address (Ipv4Address ("7.0.0.2").Get () + i));
+      AddUe (i + 1, ues[i], std::vector<Ptr<EpcTft> > (1, EpcTft::Default ()));
+    }
+
+  // each worker gets two UEs and ten packets, and worker 1 is removed
+  // before it processed any of them; packet 5 follows the removal
+  for (uint32_t seq = 0; seq <= 5; seq++)
+    {
+      Time t = seq < 5 ? Seconds (1) : Seconds (1) + MilliSeconds (2);
+      for (uint32_t i = 0; i < nUes; i++)
+        {
+          Simulator::Schedule (t, &EpcSgwPgwWorkerRemoveTestCase::SendDownlink, this, ues[i], seq, 1234, 5678);
+        }
+    }
+  Simulator::Schedule (Seconds (1) + MilliSeconds (1), &EpcSgwPgwWorkerRemoveTestCase::RemoveWorker, this, workerId1);
+  Simulator::Stop (Seconds (2));
+  Simulator::Run ();
+
+  NS_TEST_ASSERT_MSG_EQ (m_app->GetNWorkers (), 1, "worker not removed");
+  NS_TEST_ASSERT_MSG_EQ (m_moved.size (), 2, "wrong number of moved UEs");
+  NS_TEST_ASSERT_MSG_EQ (m_changeImsis.size (), 2, "wrong number of WorkerChange");
+  std::list<uint64_t>::iterator movedIt = m_moved.begin ();
+  for (uint32_t i = 0; i < m_changeImsis.size () && movedIt != m_moved.end (); i++, ++movedIt)
+    {
+      NS_TEST_ASSERT_MSG_EQ (m_changeImsis[i], *movedIt, "WorkerChange of a UE not moved");
+      NS_TEST_ASSERT_MSG_EQ (m_changes[i].first, workerId1, "UE not moved from the removed worker");
+      NS_TEST_ASSERT_MSG_EQ (m_changes[i].second, workerId2, "UE not moved to the remaining worker");
+    }
+  for (uint32_t i = 0; i < nUes; i++)
+    {
+      NS_TEST_ASSERT_MSG_EQ (m_app->GetWorkerOfUe (i + 1), workerId2, "UE " << i + 1 << " not on the remaining worker");
+    }
+
+  NS_TEST_ASSERT_MSG_EQ (m_drops.size (), 0, "no drop expected");
+  for (uint32_t i = 0; i < m_delays.size (); i++)
+    {
+      NS_TEST_ASSERT_MSG_EQ (m_delays[i].first, workerId2, "packet processed by the removed worker");
+    }
+  for (uint32_t i = 0; i < nUes; i++)
+    {
+      std::vector<Delivery> dl = GetDeliveries (m_downlink, ues[i]);
+      NS_TEST_ASSERT_MSG_EQ (dl.size (), 6, "packets of UE " << i + 1 << " lost");
+      for (uint32_t j = 0; j < dl.size (); j++)
+        {
+          NS_TEST_ASSERT_MSG_EQ (dl[j].seq, j, "packets of UE " << i + 1 << " reordered");
+        }
+    }
+
+  DestroyGateway ();
+}
+
+
+/**
+ * The UEs of a worker are evenly redistributed once workers are added
+ */
+class EpcSgwPgwWorkerRebalanceTestCase : public EpcSgwPgwWorkerTestCase
+{
+public:
+  EpcSgwPgwWorkerRebalanceTestCase ();
+
+private:
+  virtual void DoRun (void);
+};
+
+EpcSgwPgwWorkerRebalanceTestCase::EpcSgwPgwWorkerRebalanceTestCase ()
+  : EpcSgwPgwWorkerTestCase ("Worker rebalancing")
+{
+}
+
+void
+EpcSgwPgwWorkerRebalanceTestCase::DoRun (void)
+{
+  CreateWorkerGateway ();
+  DataRate processingRate ("1Mb/s");
+  uint32_t workerId1 = m_app->AddWorker (processingRate, 100);
+  const uint32_t nUes = 4;
+  std::vector<Ipv4Address> ues;
+  for (uint32_t i = 0; i < nUes; i++)
+    {
+      ues.push_back (Ipv4Address (Ipv4Address ("7.0.0.2").Get () + i));
+      AddUe (i + 1, ues[i], std::vector<Ptr<EpcTft> > (1, EpcTft::Default ()));
+      Simulator::Schedule (Seconds (1), &EpcSgwPgwWorkerRebalanceTestCase::SendDownlink, this, ues[i], 0, 1234, 5678);
+    }
+  Simulator::Stop (Seconds (2));
+  Simulator::Run ();
+  for (uint32_t i = 0; i < nUes; i++)
+    {
+      NS_TEST_ASSERT_MSG_EQ (m_app->GetWorkerOfUe (i + 1), workerId1, "UE " << i + 1 << " not on the only worker");
+    }
+  NS_TEST_ASSERT_MSG_EQ (m_changeImsis.size (), 0, "no WorkerChange expected before the rebalancing");
+
+  // the added workers get no existing UE until the rebalancing
+  uint32_t workerId2 = m_app->AddWorker (processingRate, 100);
+  uint32_t workerId3 = m_app->AddWorker (processingRate, 100);
+  std::list<uint64_t> moved = m_app->RebalanceWorkers ();
+  std::map<uint32_t, uint32_t> nUesByWorker;
+  for (uint32_t i = 0; i < nUes; i++)
+    {
+      nUesByWorker[m_app->GetWorkerOfUe (i + 1)]++;
+    }
+  NS_TEST_ASSERT_MSG_EQ (nUesByWorker[workerId1], 2, "wrong number of UEs on worker 1");
+  NS_TEST_ASSERT_MSG_EQ (nUesByWorker[workerId2], 1, "wrong number of UEs on worker 2");
+  NS_TEST_ASSERT_MSG_EQ (nUesByWorker[workerId3], 1, "wrong number of UEs on worker 3");
+  NS_TEST_ASSERT_MSG_EQ (moved.size (), 2, "wrong number of moved UEs");
+  NS_TEST_ASSERT_MSG_EQ (m_changeImsis.size (), 2, "wrong number of WorkerChange");
+  std::list<uint64_t>::iterator movedIt = moved.begin ();
+  for (uint32_t i = 0; i < m_changeImsis.size () && movedIt != moved.end (); i++, ++movedIt)
+    {
+      NS_TEST_ASSERT_MSG_EQ (m_changeImsis[i], *movedIt, "WorkerChange of a UE not moved");
+      NS_TEST_ASSERT_MSG_EQ (m_changes[i].first, workerId1, "UE not moved from worker 1");
+      NS_TEST_ASSERT_MSG_EQ (m_changes[i].second, m_app->GetWorkerOfUe (*movedIt), "wrong worker in WorkerChange");
+    }
+
+  // balanced workers: nothing to move
+  NS_TEST_ASSERT_MSG_EQ (m_app->RebalanceWorkers ().size (), 0, "UEs moved between balanced workers");
+  NS_TEST_ASSERT_MSG_EQ (m_changeImsis.size (), 2, "WorkerChange between balanced workers");
+
+  // the moved UEs are then served by their new worker
+  for (uint32_t i = 0; i < nUes; i++)
+    {
+      Simulator::Schedule (Seconds (1), &EpcSgwPgwWorkerRebalanceTestCase::SendDownlink, this, ues[i], 1, 1234, 5678);
+    }
+  m_delays.clear ();
+  Simulator::Stop (Seconds (2));
+  Simulator::Run ();
+  NS_TEST_ASSERT_MSG_EQ (m_delays.size (), nUes, "wrong number of processed packets");
+  std::map<uint32_t, uint32_t> nPacketsByWorker;
+  for (uint32_t i = 0; i < m_delays.size (); i++)
+    {
+      nPacketsByWorker[m_delays[i].first]++;
+    }
+  NS_TEST_ASSERT_MSG_EQ (nPacketsByWorker[workerId1], 2, "wrong number of packets processed by worker 1");
+  NS_TEST_ASSERT_MSG_EQ (nPacketsByWorker[workerId2], 1, "wrong number of packets processed by worker 2");
+  NS_TEST_ASSERT_MSG_EQ (nPacketsByWorker[workerId3], 1, "wrong number of packets processed by worker 3");
+  NS_TEST_ASSERT_MSG_EQ (m_downlink.size (), 2 * nUes, "packets lost");
+
+  DestroyGateway ();
+}
+
+
+/**
+ * The packets of a worker with a forwarding delay (e.g., on another rack)
+ * are forwarded that much later once processed, even if the worker is
+ * removed meanwhile, and the delay is not part of WorkerDelay
+ */
+class EpcSgwPgwWorkerForwardingDelayTestCase : public EpcSgwPgwWorkerTestCase
+{
+public:
+  EpcSgwPgwWorkerForwardingDelayTestCase ();
+
+private:
+  virtual void DoRun (void);
+  void RemoveWorker (uint32_t workerId);
+};
+
+EpcSgwPgwWorkerForwardingDelayTestCase::EpcSgwPgwWorkerForwardingDelayTestCase ()
+  : EpcSgwPgwWorkerTestCase ("Worker forwarding delay")
+{
+}
+
+void
+EpcSgwPgwWorkerForwardingDelayTestCase::RemoveWorker (uint32_t workerId)
+{
+  m_app->RemoveWorker (workerId);
+}
+
+void
+EpcSgwPgwWorkerForwardingDelayTestCase::DoRun (void)
+{
+  CreateWorkerGateway ();
+  DataRate processingRate ("1Mb/s");
+  Time forwardingDelay = MilliSeconds (1);
+  uint32_t workerId1 = m_app->AddWorker (processingRate, 10);
+  uint32_t workerId2 = m_app->AddWorker (processingRate, 10);
+  m_app->SetWorkerForwardingDelay (workerId2, forwardingDelay);
+  Ipv4Address ue1 ("7.0.0.2");
+  Ipv4Address ue2 ("7.0.0.3");
+  AddUe (1, ue1, std::vector<Ptr<EpcTft> > (1, EpcTft::Default ()));
+  AddUe (2, ue2, std::vector<Ptr<EpcTft> > (1, EpcTft::Default ()));
+
+  // a packet per UE, each UE on its own worker, and worker 2 removed
+  // while its packet is on the way back
+  Time serviceTime = processingRate.CalculateBytesTxTime (GetDownlinkSize ());
+  Simulator::Schedule (Seconds (1), &EpcSgwPgwWorkerForwardingDelayTestCase::SendDownlink, this, ue1, 0, 1234, 5678);
+  Simulator::Schedule (Seconds (1), &EpcSgwPgwWorkerForwardingDelayTestCase::SendDownlink, this, ue2, 0, 1234, 5678);
+  Simulator::Schedule (Seconds (1) + serviceTime + forwardingDelay / 2,
+                       &EpcSgwPgwWorkerForwardingDelayTestCase::RemoveWorker, this, workerId2);
+  Simulator::Stop (Seconds (2));
+  Simulator::Run ();
+
+  NS_TEST_ASSERT_MSG_EQ (m_delays.size (), 2, "wrong number of processed packets");
+  for (uint32_t i = 0; i < m_delays.size (); i++)
+    {
+      NS_TEST_ASSERT_MSG_EQ (m_delays[i].second, serviceTime, "forwarding delay in WorkerDelay");
+    }
+  NS_TEST_ASSERT_MSG_EQ (m_app->GetWorkerOfUe (2), workerId1, "UE 2 not moved from the removed worker");
+
+  std::vector<Delivery> dl1 = GetDeliveries (m_downlink, ue1);
+  std::vector<Delivery> dl2 = GetDeliveries (m_downlink, ue2);
+  NS_TEST_ASSERT_MSG_EQ (dl1.size (), 1, "packet of UE 1 lost");
+  NS_TEST_ASSERT_MSG_EQ (dl2.size (), 1, "packet of UE 2 lost with its worker");
+  if (dl1.size () == 1 && dl2.size () == 1)
+    {
+      NS_TEST_ASSERT_MSG_EQ (dl2[0].time - dl1[0].time, forwardingDelay, "wrong forwarding delay");
+    }
+
+  DestroyGateway ();
+}
+
+
+class EpcSgwPgwWorkerTestSuite : public TestSuite
+{
+public:
+  EpcSgwPgwWorkerTestSuite ();
+};
+
+EpcSgwPgwWorkerTestSuite::EpcSgwPgwWorkerTestSuite ()
+  : TestSuite ("epc-sgw-pgw-workers", UNIT)
+{
+  AddTestCase (new EpcSgwPgwWorkerDelayTestCase (), TestCase::QUICK);
+  AddTestCase (new EpcSgwPgwWorkerDropTestCase (), TestCase::QUICK);
+  AddTestCase (new EpcSgwPgwWorkerRemoveTestCase (), TestCase::QUICK);
+  AddTestCase (new EpcSgwPgwWorkerRebalanceTestCase (), TestCase::QUICK);
+  AddTestCase (new EpcSgwPgwWorkerForwardingDelayTestCase (), TestCase::QUICK);
+}
+
+static EpcSgwPgwWorkerTestSuite epcSgwPgwWorkerTestSuite;
+
+
+/**
+ * The size of the context of a UE follows its state: its bearers, and the
+ * packet filters of their TFT
+ */
+class EpcSgwPgwUeContextSizeTestCase : public EpcSgwPgwTestCase
+{
+public:
+  EpcSgwPgwUeContextSizeTestCase ();
+
+private:
+  virtual void DoRun (void);
+
+  /**
+   * \param nFilters the number of packet filters
+   * \return a TFT whose packet filters each match a remote address, a
+   * remote port range, a local port and a type of service
+   */
+  static Ptr<EpcTft> CreateTft (uint32_t nFilters);
+};
+
+EpcSgwPgwUeContextSizeTestCase::EpcSgwPgwUeContextSizeTestCase ()
+  : EpcSgwPgwTestCase ("UE context size")
+{
+}
+
+Ptr<EpcTft>
+EpcSgwPgwUeContextSizeTestCase::CreateTft (uint32_t nFilters)
+{
+  Ptr<EpcTft> tft = Create<EpcTft> ();
+  for (uint32_t i = 0; i < nFilters; i++)
+    {
+      EpcTft::PacketFilter pf;
+      pf.remoteAddress = Ipv4Address (Ipv4Address ("1.0.0.0").Get () + (i << 8));
+      pf.remoteMask = Ipv4Mask ("255.255.255.0");
+      pf.remotePortStart = 1000;
+      pf.remotePortEnd = 1999;
+      pf.localPortStart = 5000 + i;
+      pf.localPortEnd = 5000 + i;
+      pf.typeOfService = 0xb8;
+      pf.typeOfServiceMask = 0xfc;
+      tft->Add (pf);
+    }
+  return tft;
+}
+
+void
+EpcSgwPgwUeContextSizeTestCase::DoRun (void)
+{
+  CreateGateway ();
+
+  // IMSI, UE address and eNB address
+  const uint32_t ueSize = 8 + 4 + 4;
+  // EPS bearer ID, F-TEID and bearer QoS
+  const uint32_t bearerSize = 1 + 8 + 22;
+  // TFT IE header
+  const uint32_t tftSize = 3;
+  // identifier, direction, precedence and length; remote address and mask;
+  // remote port range; local port; type of service and mask
+  const uint32_t filterSize = 3 + 9 + 5 + 3 + 3;
+
+  NS_TEST_ASSERT_MSG_EQ (m_app->GetUeContextSize (42), 0, "context of an unknown UE");
+
+  // a UE without session
+  m_app->AddUe (1);
+  NS_TEST_ASSERT_MSG_EQ (m_app->GetUeContextSize (1), ueSize, "wrong context size without session");
+
+  // the TFT grows by the same amount with each packet filter, and a packet
+  // filter matching any packet has no component
+  for (uint32_t nFilters = 0; nFilters <= 4; nFilters++)
+    {
+      NS_TEST_ASSERT_MSG_EQ (CreateTft (nFilters)->GetSerializedSize (), tftSize + nFilters * filterSize,
+                             "wrong size of a TFT with " << nFilters << " packet filters");
+    }
+  NS_TEST_ASSERT_MSG_EQ (EpcTft::Default ()->GetSerializedSize (), tftSize + 3, "wrong size of the default TFT");
+
+  // a session with the default bearer only
+  AddUe (2, Ipv4Address ("7.0.0.2"), std::vector<Ptr<EpcTft> > (1, EpcTft::Default ()));
+  NS_TEST_ASSERT_MSG_EQ (m_app->GetUeContextSize (2), ueSize + bearerSize + tftSize + 3,
+                         "wrong context size with one bearer");
+
+  // a session with N bearers, the i-th one with i packet filters
+  const uint32_t nBearers = 4;
+  std::vector<Ptr<EpcTft> > tfts;
+  uint32_t expected = ueSize;
+  for (uint32_t i = 1; i <= nBearers; i++)
+    {
+      tfts.push_back (CreateTft (i));
+      expected += bearerSize + tftSize + i * filterSize;
+    }
+  AddUe (3, Ipv4Address ("7.0.0.3"), tfts);
+  NS_TEST_ASSERT_MSG_EQ (m_app->GetUeContextSize (3), expected,
+                         "wrong context size with " << nBearers << " bearers");
+
+  // removing a bearer removes its share of the context
+  EpcS11SapSgw::DeleteBearerResponseMessage res;
+  res.teid = 3;
+  EpcS11SapSgw::BearerContextRemovedSgwPgw bearer;
+  bearer.epsBearerId = nBearers;
+  res.bearerContextsRemoved.push_back (bearer);
+  m_app->GetS11SapSgw ()->DeleteBearerResponse (res);
+  expected -= bearerSize + tftSize + nBearers * filterSize;
+  NS_TEST_ASSERT_MSG_EQ (m_app->GetUeContextSize (3), expected, "wrong context size after removing a bearer");
+
+  // the other UEs are not affected
+  NS_TEST_ASSERT_MSG_EQ (m_app->GetUeContextSize (1), ueSize, "context of another UE changed");
+  NS_TEST_ASSERT_MSG_EQ (m_app->GetUeContextSize (2), ueSize + bearerSize + tftSize + 3,
+                         "context of another UE changed");
+
+  DestroyGateway ();
+}
+
+
+class EpcSgwPgwUeContextTestSuite : public TestSuite
+{
+public:
+  EpcSgwPgwUeContextTestSuite ();
+};
+
+EpcSgwPgwUeContextTestSuite::EpcSgwPgwUeContextTestSuite ()
+  : TestSuite ("epc-sgw-pgw-ue-context", UNIT)
+{
+  AddTestCase (new EpcSgwPgwUeContextSizeTestCase (), TestCase::QUICK);
+}
+
+static EpcSgwPgwUeContextTestSuite epcSgwPgwUeContextTestSuite;
+
+
+/**
+ * The downlink packets of a flow are classified from the flow cache of
+ * their UE once the first one is, until the bearers of the UE change
+ */
+class EpcSgwPgwFlowCacheTestCase : public EpcSgwPgwTestCase
+{
+public:
+  EpcSgwPgwFlowCacheTestCase ();
+
+private:
+  virtual void DoRun (void);
+};
+
+EpcSgwPgwFlowCacheTestCase::EpcSgwPgwFlowCacheTestCase ()
+  : EpcSgwPgwTestCase ("Flow cache")
+{
+}
+
+void
+EpcSgwPgwFlowCacheTestCase::DoRun (void)
+{
+  CreateGateway ();
+  Ipv4Address ue ("7.0.0.2");
+  uint32_t defaultTeid = AddUe (1, ue, std::vector<Ptr<EpcTft> > (1, EpcTft::Default ()))[0];
+
+  // the packets are classified as they are written to the TUN device
+  std::vector<uint32_t> expected;
+  SendDownlink (ue, 0, 1234, 5678);
+  NS_TEST_ASSERT_MSG_EQ (m_app->GetFlowCacheHits (1), 0, "first packet of a flow classified from the cache");
+  SendDownlink (ue, 1, 1234, 5678);
+  SendDownlink (ue, 2, 1234, 5678);
+  NS_TEST_ASSERT_MSG_EQ (m_app->GetFlowCacheHits (1), 2, "repeated flow not classified from the cache");
+  SendDownlink (ue, 3, 1234, 9999);
+  NS_TEST_ASSERT_MSG_EQ (m_app->GetFlowCacheHits (1), 2, "another flow classified from the cache");
+  expected.insert (expected.end (), 4, defaultTeid);
+
+  // a dedicated bearer for the first flow: the cache is flushed, and the
+  // first flow is classified to the new bearer
+  Ptr<EpcTft> tft = Create<EpcTft> ();
+  EpcTft::PacketFilter pf;
+  pf.localPortStart = 5678;
+  pf.localPortEnd = 5678;
+  tft->Add (pf);
+  std::vector<uint32_t> teids = CreateBearers (1, std::vector<Ptr<EpcTft> > (1, tft), 2);
+  NS_TEST_ASSERT_MSG_EQ (teids.size (), 1, "dedicated bearer not created");
+  uint32_t dedicatedTeid = teids[0];
+  NS_TEST_ASSERT_MSG_NE (dedicatedTeid, defaultTeid, "dedicated bearer with the TEID of the default one");
+  SendDownlink (ue, 4, 1234, 5678);
+  NS_TEST_ASSERT_MSG_EQ (m_app->GetFlowCacheHits (1), 2, "flow cache not flushed by a new bearer");
+  SendDownlink (ue, 5, 1234, 5678);
+  NS_TEST_ASSERT_MSG_EQ (m_app->GetFlowCacheHits (1), 3, "repeated flow not classified from the cache");
+  SendDownlink (ue, 6, 1234, 9999);
+  expected.push_back (dedicatedTeid);
+  expected.push_back (dedicatedTeid);
+  expected.push_back (defaultTeid);
+
+  // the dedicated bearer removed: the first flow is back to the default one
+  EpcS11SapSgw::DeleteBearerResponseMessage res;
+  res.teid = 1;
+  EpcS11SapSgw::BearerContextRemovedSgwPgw removed;
+  removed.epsBearerId = 2;
+  res.bearerContextsRemoved.push_back (removed);
+  m_app->GetS11SapSgw ()->DeleteBearerResponse (res);
+  SendDownlink (ue, 7, 1234, 5678);
+  NS_TEST_ASSERT_MSG_EQ (m_app->GetFlowCacheHits (1), 3, "flow cache not flushed by a removed bearer");
+  SendDownlink (ue, 8, 1234, 5678);
+  NS_TEST_ASSERT_MSG_EQ (m_app->GetFlowCacheHits (1), 4, "repeated flow not classified from the cache");
+  expected.push_back (defaultTeid);
+  expected.push_back (defaultTeid);
+
+  Simulator::Run ();
+  NS_TEST_ASSERT_MSG_EQ (m_downlink.size (), expected.size (), "wrong number of downlink packets");
+  for (uint32_t i = 0; i < m_downlink.size (); i++)
+    {
+      NS_TEST_ASSERT_MSG_EQ (m_downlink[i].seq, i, "downlink packets reordered");
+      NS_TEST_ASSERT_MSG_EQ (m_downlink[i].teid, expected[i], "wrong TEID of downlink packet " << i);
+    }
+  NS_TEST_ASSERT_MSG_EQ (m_app->GetFlowCacheHits (42), 0, "flow cache hits of an unknown UE");
+
+  DestroyGateway ();
+}
+
+
+class EpcSgwPgwFlowCacheTestSuite : public TestSuite
+{
+public:
+  EpcSgwPgwFlowCacheTestSuite ();
+};
+
+EpcSgwPgwFlowCacheTestSuite::EpcSgwPgwFlowCacheTestSuite ()
+  : TestSuite ("epc-sgw-pgw-flow-cache", UNIT)
+{
+  AddTestCase (new EpcSgwPgwFlowCacheTestCase (), TestCase::QUICK);
+}
+
+static EpcSgwPgwFlowCacheTestSuite epcSgwPgwFlowCacheTestSuite;
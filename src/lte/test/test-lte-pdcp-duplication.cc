@@ -0,0 +1,380 @@
+/* -*-  Mode: C++; c-file-style: "gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "ns3/test.h"
+#include "ns3/log.h"
+#include "ns3/simulator.h"
+#include "ns3/packet.h"
+#include "ns3/boolean.h"
+#include "ns3/enum.h"
+#include "ns3/nstime.h"
+#include "ns3/double.h"
+
+#include "ns3/mc-enb-pdcp.h"
+#include "ns3/mc-ue-pdcp.h"
+#include "ns3/lte-pdcp-header.h"
+#include "ns3/lte-enb-rrc.h"
+
+using namespace ns3;
+
+NS_LOG_COMPONENT_DEFINE ("TestLtePdcpDuplication");
+
+/**
+ * Links the legs of an McEnbPdcp to an McUePdcp: the local RLC and the
+ * X2 towards the mmWave cell each deliver the PDUs after a fixed delay.
+ */
+class PdcpDuplicationTestLegs : public LteRlcSapProvider,
+                                public EpcX2PdcpProvider,
+                                public LtePdcpSapUser
+{
+public:
+  PdcpDuplicationTestLegs (Ptr<McUePdcp> uePdcp, Time lteDelay, Time x2Delay)
+    : m_uePdcp (uePdcp),
+      m_lteDelay (lteDelay),
+      m_x2Delay (x2Delay),
+      m_nLtePdus (0),
+      m_nX2Pdus (0),
+      m_nSdus (0)
+  {
+  }
+
+  // the local RLC
+  virtual void TransmitPdcpPdu (TransmitPdcpPduParameters params)
+  {
+    m_nLtePdus++;
+    Simulator::Schedule (m_lteDelay, &PdcpDuplicationTestLegs::Deliver, this, params.pdcpPdu);
+  }
+  virtual void RequestAssistantInfo ()
+  {
+  }
+
+  // the X2
+  virtual void SendMcPdcpPdu (UeDataParams params)
+  {
+    m_nX2Pdus++;
+    Simulator::Schedule (m_x2Delay, &PdcpDuplicationTestLegs::Deliver, this, params.ueData);
+  }
+  virtual void ReceiveAssistantInformation (AssistantInformationForSplitting info)
+  {
+  }
+
+  // the upper layer of the UE
+  virtual void ReceivePdcpSdu (ReceivePdcpSduParameters params)
+  {
+    m_nSdus++;
+  }
+
+  void Deliver (Ptr<Packet> p)
+  {
+    m_uePdcp->GetLteRlcSapUser ()->ReceivePdcpPdu (p);
+  }
+
+  Ptr<McUePdcp> m_uePdcp;
+  Time m_lteDelay;
+  Time m_x2Delay;
+  uint32_t m_nLtePdus;
+  uint32_t m_nX2Pdus;
+  uint32_t m_nSdus;
+};
+
+/**
+ * Downlink of a split bearer between an LTE cell and a mmWave cell, with
+ * and without duplication
+ */
+class LtePdcpDuplicationTestCase : public TestCase
+{
+public:
+  LtePdcpDuplicationTestCase (McEnbPdcp::DuplicationMode_t mode);
+
+private:
+  virtual void DoRun (void);
+  void Send ();
+  void TxDuplicate (uint16_t rnti, uint8_t lcid, uint16_t sn, uint32_t size, uint32_t nCopies);
+  void RxDuplicate (uint16_t rnti, uint8_t lcid, uint16_t sn, uint16_t usefulCellId,
+                    uint16_t wastedCellId, uint32_t size, Time gain);
+
+  McEnbPdcp::DuplicationMode_t m_mode;
+  Ptr<McEnbPdcp> m_enbPdcp;
+  uint32_t m_nTxDuplicates;
+  uint32_t m_nRxDuplicates;
+};
+
+static const uint16_t LTE_CELL = 1;
+static const uint16_t MMWAVE_CELL = 2;
+static const uint32_t N_SDUS = 10;
+static const uint32_t SDU_SIZE = 100;
+
+LtePdcpDuplicationTestCase::LtePdcpDuplicationTestCase (McEnbPdcp::DuplicationMode_t mode)
+  : TestCase (mode == McEnbPdcp::DUPLICATION_ALWAYS ? "PDCP duplication, always" : "PDCP duplication, on demand"),
+    m_mode (mode),
+    m_nTxDuplicates (0),
+    m_nRxDuplicates (0)
+{
+}
+
+void
+LtePdcpDuplicationTestCase::Send ()
+{
+  LtePdcpSapProvider::TransmitPdcpSduParameters params;
+  params.pdcpSdu = Create<Packet> (SDU_SIZE);
+  params.rnti = 1;
+  params.lcid = 3;
+  m_enbPdcp->GetLtePdcpSapProvider ()->TransmitPdcpSdu (params);
+}
+
+void
+LtePdcpDuplicationTestCase::TxDuplicate (uint16_t rnti, uint8_t lcid, uint16_t sn, uint32_t size, uint32_t nCopies)
+{
+  NS_TEST_EXPECT_MSG_EQ (sn, m_nTxDuplicates, "SN of the duplicated PDU");
+  NS_TEST_EXPECT_MSG_EQ (nCopies, 2, "copies of the PDU");
+  m_nTxDuplicates++;
+}
+
+void
+LtePdcpDuplicationTestCase::RxDuplicate (uint16_t rnti, uint8_t lcid, uint16_t sn, uint16_t usefulCellId,
+                                         uint16_t wastedCellId, uint32_t size, Time gain)
+{
+  // the mmWave copy arrives first
+  NS_TEST_EXPECT_MSG_EQ (usefulCellId, MMWAVE_CELL, "useful copy");
+  NS_TEST_EXPECT_MSG_EQ (wastedCellId, LTE_CELL, "discarded copy");
+  NS_TEST_EXPECT_MSG_EQ (gain, MilliSeconds (3), "latency gain");
+  m_nRxDuplicates++;
+}
+
+void
+LtePdcpDuplicationTestCase::DoRun (void)
+{
+  Ptr<McUePdcp> uePdcp = CreateObject<McUePdcp> ();
+  PdcpDuplicationTestLegs legs (uePdcp, MilliSeconds (5), MilliSeconds (2));
+  uePdcp->SetRnti (1);
+  uePdcp->SetLcId (3);
+  uePdcp->SetLtePdcpSapUser (&legs);
+
+  m_enbPdcp = CreateObject<McEnbPdcp> ();
+  m_enbPdcp->SetAttribute ("enableLteMmWaveDC", BooleanValue (true));
+  m_enbPdcp->SetAttribute ("DuplicationMode", EnumValue (m_mode));
+  m_enbPdcp->SetRnti (1);
+  m_enbPdcp->SetLcId (3);
+  m_enbPdcp->SetLteRlcSapProvider (&legs);
+  m_enbPdcp->SetEpcX2PdcpProvider (&legs);
+  m_enbPdcp->SetTargetCellIds (0, MMWAVE_CELL, LTE_CELL);
+  m_enbPdcp->SwitchConnection (true);
+  m_enbPdcp->TraceConnectWithoutContext ("TxDuplicate", MakeCallback (&LtePdcpDuplicationTestCase::TxDuplicate, this));
+  uePdcp->TraceConnectWithoutContext ("RxDuplicate", MakeCallback (&LtePdcpDuplicationTestCase::RxDuplicate, this));
+
+  for (uint32_t i = 0; i < N_SDUS; i++)
+    {
+      Simulator::Schedule (MilliSeconds (i), &LtePdcpDuplicationTestCase::Send, this);
+    }
+  Simulator::Run ();
+
+  uint32_t pduSize = SDU_SIZE + LtePdcpHeader ().GetSerializedSize ();
+  NS_TEST_ASSERT_MSG_EQ (legs.m_nSdus, N_SDUS, "SDUs delivered to the upper layer");
+  McUePdcp::DuplicationStats lteStats = uePdcp->GetDuplicationStats (LTE_CELL);
+  McUePdcp::DuplicationStats mmWaveStats = uePdcp->GetDuplicationStats (MMWAVE_CELL);
+  if (m_mode == McEnbPdcp::DUPLICATION_ALWAYS)
+    {
+      NS_TEST_ASSERT_MSG_EQ (legs.m_nLtePdus, N_SDUS, "PDUs sent to the local RLC");
+      NS_TEST_ASSERT_MSG_EQ (legs.m_nX2Pdus, N_SDUS, "PDUs sent on the X2");
+      NS_TEST_ASSERT_MSG_EQ (m_enbPdcp->GetDuplicatedPdus (), N_SDUS, "duplicated PDUs");
+      NS_TEST_ASSERT_MSG_EQ (m_enbPdcp->GetDuplicatedBytes (), N_SDUS * pduSize, "duplicated bytes");
+      NS_TEST_ASSERT_MSG_EQ (m_nTxDuplicates, N_SDUS, "TxDuplicate traces");
+      NS_TEST_ASSERT_MSG_EQ (m_nRxDuplicates, N_SDUS, "RxDuplicate traces");
+      NS_TEST_ASSERT_MSG_EQ (mmWaveStats.usefulPdus, N_SDUS, "useful mmWave copies");
+      NS_TEST_ASSERT_MSG_EQ (lteStats.rxPdus, N_SDUS, "LTE copies");
+      NS_TEST_ASSERT_MSG_EQ (lteStats.usefulPdus, 0, "useful LTE copies");
+      NS_TEST_ASSERT_MSG_EQ (lteStats.wastedBytes, N_SDUS * pduSize, "wasted LTE bytes");
+    }
+  else
+    {
+      NS_TEST_ASSERT_MSG_EQ (legs.m_nLtePdus + legs.m_nX2Pdus, N_SDUS, "PDUs sent");
+      NS_TEST_ASSERT_MSG_EQ (m_enbPdcp->GetDuplicatedPdus (), 0, "duplicated PDUs");
+      NS_TEST_ASSERT_MSG_EQ (m_nTxDuplicates + m_nRxDuplicates, 0, "duplication traces");
+      NS_TEST_ASSERT_MSG_EQ (lteStats.usefulPdus + mmWaveStats.usefulPdus, N_SDUS, "useful copies");
+      NS_TEST_ASSERT_MSG_EQ (lteStats.wastedPdus + mmWaveStats.wastedPdus, 0, "wasted copies");
+    }
+
+  m_enbPdcp->Dispose ();
+  uePdcp->Dispose ();
+  Simulator::Destroy ();
+}
+
+/**
+ * Downlink of a split bearer in Adaptive duplication mode: the PDUs are
+ * duplicated while the reported queueing delay of a leg is above the
+ * threshold, or while the duplication is activated on demand
+ */
+class LtePdcpAdaptiveDuplicationTestCase : public TestCase
+{
+public:
+  LtePdcpAdaptiveDuplicationTestCase ();
+
+private:
+  virtual void DoRun (void);
+  void Send (bool duplicating);
+  void ReportDelay (uint32_t delay);
+  void TxDuplicate (uint16_t rnti, uint8_t lcid, uint16_t sn, uint32_t size, uint32_t nCopies);
+
+  Ptr<McEnbPdcp> m_enbPdcp;
+  uint32_t m_nTxDuplicates;
+};
+
+LtePdcpAdaptiveDuplicationTestCase::LtePdcpAdaptiveDuplicationTestCase ()
+  : TestCase ("PDCP duplication, adaptive"),
+    m_nTxDuplicates (0)
+{
+}
+
+void
+LtePdcpAdaptiveDuplicationTestCase::Send (bool duplicating)
+{
+  NS_TEST_EXPECT_MSG_EQ (m_enbPdcp->IsDuplicating (), duplicating, "duplication at " << Simulator::Now ().GetSeconds ());
+  LtePdcpSapProvider::TransmitPdcpSduParameters params;
+  params.pdcpSdu = Create<Packet> (SDU_SIZE);
+  params.rnti = 1;
+  params.lcid = 3;
+  m_enbPdcp->GetLtePdcpSapProvider ()->TransmitPdcpSdu (params);
+}
+
+void
+LtePdcpAdaptiveDuplicationTestCase::ReportDelay (uint32_t delay)
+{
+  EpcX2Sap::AssistantInformationForSplitting info;
+  info.sourceCellId = MMWAVE_CELL;
+  info.Tx_On_Q_Delay = delay;
+  m_enbPdcp->DoReceiveAssistantInformation (info);
+}
+
+void
+LtePdcpAdaptiveDuplicationTestCase::TxDuplicate (uint16_t rnti, uint8_t lcid, uint16_t sn, uint32_t size, uint32_t nCopies)
+{
+  m_nTxDuplicates++;
+}
+
+void
+LtePdcpAdaptiveDuplicationTestCase::DoRun (void)
+{
+  Ptr<McUePdcp> uePdcp = CreateObject<McUePdcp> ();
+  PdcpDuplicationTestLegs legs (uePdcp, MilliSeconds (5), MilliSeconds (2));
+  uePdcp->SetRnti (1);
+  uePdcp->SetLcId (3);
+  uePdcp->SetLtePdcpSapUser (&legs);
+
+  m_enbPdcp = CreateObject<McEnbPdcp> ();
+  m_enbPdcp->SetAttribute ("enableLteMmWaveDC", BooleanValue (true));
+  m_enbPdcp->SetAttribute ("DuplicationMode", EnumValue (McEnbPdcp::DUPLICATION_ADAPTIVE));
+  m_enbPdcp->SetAttribute ("DuplicationDelayThreshold", TimeValue (MilliSeconds (10)));
+  // the smoothed delay is the last reported one
+  m_enbPdcp->SetSplitAlgorithmAttribute ("Alpha", DoubleValue (0));
+  m_enbPdcp->SetRnti (1);
+  m_enbPdcp->SetLcId (3);
+  m_enbPdcp->SetLteRlcSapProvider (&legs);
+  m_enbPdcp->SetEpcX2PdcpProvider (&legs);
+  m_enbPdcp->SetTargetCellIds (0, MMWAVE_CELL, LTE_CELL);
+  m_enbPdcp->SwitchConnection (true);
+  m_enbPdcp->TraceConnectWithoutContext ("TxDuplicate", MakeCallback (&LtePdcpAdaptiveDuplicationTestCase::TxDuplicate, this));
+
+  // N_SDUS PDUs with each of: no report, a mmWave queue delay of 50 ms
+  // (500 in units of 0.1 ms), of 5 ms, and of 5 ms with the duplication
+  // activated on demand
+  for (uint32_t i = 0; i < N_SDUS; i++)
+    {
+      Simulator::Schedule (MilliSeconds (i), &LtePdcpAdaptiveDuplicationTestCase::Send, this, false);
+      Simulator::Schedule (MilliSeconds (N_SDUS + i), &LtePdcpAdaptiveDuplicationTestCase::Send, this, true);
+      Simulator::Schedule (MilliSeconds (2 * N_SDUS + i), &LtePdcpAdaptiveDuplicationTestCase::Send, this, false);
+      Simulator::Schedule (MilliSeconds (3 * N_SDUS + i), &LtePdcpAdaptiveDuplicationTestCase::Send, this, true);
+    }
+  Simulator::Schedule (MicroSeconds (1000 * N_SDUS - 500), &LtePdcpAdaptiveDuplicationTestCase::ReportDelay, this, 500);
+  Simulator::Schedule (MicroSeconds (2000 * N_SDUS - 500), &LtePdcpAdaptiveDuplicationTestCase::ReportDelay, this, 50);
+  Simulator::Schedule (MicroSeconds (3000 * N_SDUS - 500), &McEnbPdcp::SetPacketDuplicateMode, m_enbPdcp, true);
+  Simulator::Run ();
+
+  uint32_t pduSize = SDU_SIZE + LtePdcpHeader ().GetSerializedSize ();
+  NS_TEST_ASSERT_MSG_EQ (legs.m_nSdus, 4 * N_SDUS, "SDUs delivered to the upper layer");
+  NS_TEST_ASSERT_MSG_EQ (legs.m_nLtePdus + legs.m_nX2Pdus, 6 * N_SDUS, "PDUs sent");
+  NS_TEST_ASSERT_MSG_EQ (m_enbPdcp->GetDuplicatedPdus (), 2 * N_SDUS, "duplicated PDUs");
+  NS_TEST_ASSERT_MSG_EQ (m_enbPdcp->GetDuplicatedBytes (), 2 * N_SDUS * pduSize, "duplicated bytes");
+  NS_TEST_ASSERT_MSG_EQ (m_nTxDuplicates, 2 * N_SDUS, "TxDuplicate traces");
+
+  m_enbPdcp->Dispose ();
+  uePdcp->Dispose ();
+  Simulator::Destroy ();
+}
+
+/**
+ * The PDCP duplication decision of LteEnbRrc from the SINRs of the two
+ * mmWave cells of a UE
+ */
+class LteEnbRrcSinrDuplicationTestCase : public TestCase
+{
+public:
+  LteEnbRrcSinrDuplicationTestCase ();
+
+private:
+  virtual void DoRun (void);
+};
+
+LteEnbRrcSinrDuplicationTestCase::LteEnbRrcSinrDuplicationTestCase ()
+  : TestCase ("SINR triggered PDCP duplication")
+{
+}
+
+void
+LteEnbRrcSinrDuplicationTestCase::DoRun (void)
+{
+  Ptr<LteEnbRrc> rrc = CreateObject<LteEnbRrc> ();
+  rrc->SetAttribute ("DuplicationSinrThreshold", DoubleValue (10));
+  bool duplicate = true;
+
+  // switched off: the duplication is left to the other triggers
+  rrc->SetAttribute ("SinrTriggeredDuplication", BooleanValue (false));
+  NS_TEST_ASSERT_MSG_EQ (rrc->GetSinrTriggeredDuplication (0, 0, duplicate), false, "decision while switched off");
+  NS_TEST_ASSERT_MSG_EQ (duplicate, true, "duplication changed while switched off");
+
+  rrc->SetAttribute ("SinrTriggeredDuplication", BooleanValue (true));
+  NS_TEST_ASSERT_MSG_EQ (rrc->GetSinrTriggeredDuplication (20, 15, duplicate), true, "decision");
+  NS_TEST_ASSERT_MSG_EQ (duplicate, false, "duplication with both cells above the threshold");
+  NS_TEST_ASSERT_MSG_EQ (rrc->GetSinrTriggeredDuplication (20, 5, duplicate), true, "decision");
+  NS_TEST_ASSERT_MSG_EQ (duplicate, true, "duplication with the second cell below the threshold");
+  NS_TEST_ASSERT_MSG_EQ (rrc->GetSinrTriggeredDuplication (-3, 20, duplicate), true, "decision");
+  NS_TEST_ASSERT_MSG_EQ (duplicate, true, "duplication with the first cell below the threshold");
+  NS_TEST_ASSERT_MSG_EQ (rrc->GetSinrTriggeredDuplication (10, 10, duplicate), true, "decision");
+  NS_TEST_ASSERT_MSG_EQ (duplicate, false, "duplication with both cells at the threshold");
+
+  rrc->SetAttribute ("DuplicationSinrThreshold", DoubleValue (25));
+  rrc->GetSinrTriggeredDuplication (20, 15, duplicate);
+  NS_TEST_ASSERT_MSG_EQ (duplicate, true, "duplication below a higher threshold");
+
+  rrc->Dispose ();
+  Simulator::Destroy ();
+}
+
+class LtePdcpDuplicationTestSuite : public TestSuite
+{
+public:
+  LtePdcpDuplicationTestSuite ();
+};
+
+LtePdcpDuplicationTestSuite::LtePdcpDuplicationTestSuite ()
+  : TestSuite ("lte-pdcp-duplication", UNIT)
+{
+  AddTestCase (new LtePdcpDuplicationTestCase (McEnbPdcp::DUPLICATION_ALWAYS), TestCase::QUICK);
+  AddTestCase (new LtePdcpDuplicationTestCase (McEnbPdcp::DUPLICATION_ON_DEMAND), TestCase::QUICK);
+  AddTestCase (new LtePdcpAdaptiveDuplicationTestCase (), TestCase::QUICK);
+  AddTestCase (new LteEnbRrcSinrDuplicationTestCase (), TestCase::QUICK);
+}
+
+static LtePdcpDuplicationTestSuite ltePdcpDuplicationTestSuite;
@@ -0,0 +1,153 @@
+/* -*-  Mode: C++; c-file-style: "gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "ns3/test.h"
+#include "ns3/log.h"
+#include "ns3/packet.h"
+
+#include "ns3/lte-pdcp-rx-window.h"
+
+using namespace ns3;
+
+NS_LOG_COMPONENT_DEFINE ("TestLtePdcpRxWindow");
+
+/**
+ * Duplicate detection over several wraps of the SN space
+ */
+class LtePdcpDuplicateFilterTestCase : public TestCase
+{
+public:
+  LtePdcpDuplicateFilterTestCase (uint32_t snSpace);
+
+private:
+  virtual void DoRun (void);
+
+  uint32_t m_snSpace;
+};
+
+LtePdcpDuplicateFilterTestCase::LtePdcpDuplicateFilterTestCase (uint32_t snSpace)
+  : TestCase ("PDCP duplicate filter, SN space " + std::to_string (snSpace)),
+    m_snSpace (snSpace)
+{
+}
+
+void
+LtePdcpDuplicateFilterTestCase::DoRun (void)
+{
+  LtePdcpDuplicateFilter filter (m_snSpace);
+
+  // three HFNs in order, each SN received twice on two paths lagging by 10 SNs
+  uint32_t nDuplicates = 0;
+  for (uint32_t i = 0; i < 3 * m_snSpace + 10; i++)
+    {
+      if (i < 3 * m_snSpace && filter.IsDuplicate (i % m_snSpace))
+        {
+          nDuplicates++;
+        }
+      if (i >= 10)
+        {
+          NS_TEST_ASSERT_MSG_EQ (filter.IsDuplicate ((i - 10) % m_snSpace), true,
+                                 "copy of SN " << (i - 10) % m_snSpace << " not detected");
+        }
+    }
+  NS_TEST_ASSERT_MSG_EQ (nDuplicates, 0, "SNs of a new HFN taken for duplicates");
+
+  // an SN received late, but less than half the SN space behind, is new once
+  filter.Reset ();
+  NS_TEST_ASSERT_MSG_EQ (filter.IsDuplicate (100), false, "first SN");
+  NS_TEST_ASSERT_MSG_EQ (filter.IsDuplicate (50), false, "late SN");
+  NS_TEST_ASSERT_MSG_EQ (filter.IsDuplicate (50), true, "copy of the late SN");
+  NS_TEST_ASSERT_MSG_EQ (filter.IsDuplicate (m_snSpace - 1), false, "SN of the previous HFN");
+  NS_TEST_ASSERT_MSG_EQ (filter.IsDuplicate (m_snSpace - 1), true, "copy of the SN of the previous HFN");
+}
+
+/**
+ * Buffering and in-order release of out of order SDUs
+ */
+class LtePdcpReorderingWindowTestCase : public TestCase
+{
+public:
+  LtePdcpReorderingWindowTestCase ();
+
+private:
+  virtual void DoRun (void);
+};
+
+LtePdcpReorderingWindowTestCase::LtePdcpReorderingWindowTestCase ()
+  : TestCase ("PDCP reordering window")
+{
+}
+
+void
+LtePdcpReorderingWindowTestCase::DoRun (void)
+{
+  const uint32_t snSpace = 4096;
+  LtePdcpReorderingWindow window (snSpace);
+  NS_TEST_ASSERT_MSG_EQ (window.GetSnSpace (), snSpace, "SN space");
+
+  // SDUs 4094..4099 of the COUNT space arrive as 4097, 4095, 4099, 4096, 4098
+  uint64_t arrivals[] = {4097, 4095, 4099, 4096, 4098};
+  for (uint32_t i = 0; i < 5; i++)
+    {
+      LtePdcpSapUser::ReceivePdcpSduParameters params;
+      params.pdcpSdu = Create<Packet> (100 + arrivals[i] % snSpace);
+      params.rnti = 1;
+      params.lcid = 3;
+      window.Insert (arrivals[i] % snSpace, arrivals[i], params);
+    }
+  NS_TEST_ASSERT_MSG_EQ (window.GetNBuffered (), 5, "buffered SDUs");
+  NS_TEST_ASSERT_MSG_EQ (window.IsBuffered (4094), false, "missing SDU");
+  NS_TEST_ASSERT_MSG_EQ (window.IsBuffered (0), true, "SDU after the wrap");
+  NS_TEST_ASSERT_MSG_EQ (window.GetCount (0), 4096, "COUNT after the wrap");
+
+  // the cursor is stuck on 4094 until it arrives, then the run is released
+  uint64_t cursor = 4094;
+  NS_TEST_ASSERT_MSG_EQ (window.IsBuffered (cursor % snSpace), false, "cursor released too early");
+  LtePdcpSapUser::ReceivePdcpSduParameters missing;
+  missing.pdcpSdu = Create<Packet> (100 + 4094);
+  window.Insert (4094, 4094, missing);
+
+  while (window.IsBuffered (cursor % snSpace))
+    {
+      NS_TEST_ASSERT_MSG_EQ (window.GetCount (cursor % snSpace), cursor, "COUNT of the released SDU");
+      LtePdcpSapUser::ReceivePdcpSduParameters params = window.Remove (cursor % snSpace);
+      NS_TEST_ASSERT_MSG_EQ (params.pdcpSdu->GetSize (), 100 + cursor % snSpace, "wrong SDU released");
+      cursor++;
+    }
+  NS_TEST_ASSERT_MSG_EQ (cursor, 4100, "run not fully released");
+  NS_TEST_ASSERT_MSG_EQ (window.GetNBuffered (), 0, "SDUs left in the buffer");
+
+  window.Insert (7, 8199, missing);
+  window.Clear ();
+  NS_TEST_ASSERT_MSG_EQ (window.IsBuffered (7), false, "SDU left after Clear");
+  NS_TEST_ASSERT_MSG_EQ (window.GetNBuffered (), 0, "buffer not empty after Clear");
+}
+
+class LtePdcpRxWindowTestSuite : public TestSuite
+{
+public:
+  LtePdcpRxWindowTestSuite ();
+};
+
+LtePdcpRxWindowTestSuite::LtePdcpRxWindowTestSuite ()
+  : TestSuite ("lte-pdcp-rx-window", UNIT)
+{
+  AddTestCase (new LtePdcpDuplicateFilterTestCase (4096), TestCase::QUICK);
+  AddTestCase (new LtePdcpDuplicateFilterTestCase (32768), TestCase::QUICK);
+  AddTestCase (new LtePdcpReorderingWindowTestCase, TestCase::QUICK);
+}
+
+static LtePdcpRxWindowTestSuite ltePdcpRxWindowTestSuite;
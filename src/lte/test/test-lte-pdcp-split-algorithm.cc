@@ -0,0 +1,365 @@
+/* -*-  Mode: C++; c-file-style: "gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "ns3/test.h"
+#include "ns3/log.h"
+#include "ns3/simulator.h"
+#include "ns3/uinteger.h"
+#include "ns3/boolean.h"
+#include "ns3/double.h"
+#include "ns3/nstime.h"
+#include "ns3/string.h"
+
+#include "ns3/pdcp-split-algorithm.h"
+#include "ns3/mc-enb-pdcp.h"
+
+#include <map>
+
+using namespace ns3;
+
+NS_LOG_COMPONENT_DEFINE ("TestLtePdcpSplitAlgorithm");
+
+static EpcX2Sap::AssistantInformationForSplitting
+MakeReport (uint16_t cellId, uint32_t queueSize, uint32_t queueDelay)
+{
+  EpcX2Sap::AssistantInformationForSplitting info;
+  info.targetCellId = 0;
+  info.drbId = 1;
+  info.rnti = 1;
+  info.sourceCellId = cellId;
+  info.Tx_On_Q_Size = queueSize;
+  info.Tx_On_Q_Delay = queueDelay;
+  return info;
+}
+
+static std::vector<uint16_t>
+MakeLegs (uint16_t a, uint16_t b, uint16_t c)
+{
+  std::vector<uint16_t> legs;
+  legs.push_back (a);
+  legs.push_back (b);
+  legs.push_back (c);
+  return legs;
+}
+
+/**
+ * Leg selection of the algorithms that do not depend on the drain rates,
+ * on three legs
+ */
+class LtePdcpSplitAlgorithmSelectionTestCase : public TestCase
+{
+public:
+  LtePdcpSplitAlgorithmSelectionTestCase ();
+
+private:
+  virtual void DoRun (void);
+};
+
+LtePdcpSplitAlgorithmSelectionTestCase::LtePdcpSplitAlgorithmSelectionTestCase ()
+  : TestCase ("PDCP split algorithms, leg selection")
+{
+}
+
+void
+LtePdcpSplitAlgorithmSelectionTestCase::DoRun (void)
+{
+  std::vector<uint16_t> legs = MakeLegs (2, 3, 1);
+
+  Ptr<PdcpSplitAlgorithm> fixed = CreateObject<FixedPdcpSplitAlgorithm> ();
+  fixed->SetAttribute ("Leg", UintegerValue (1));
+  fixed->SetLegs (legs);
+  for (uint32_t i = 0; i < 10; i++)
+    {
+      NS_TEST_ASSERT_MSG_EQ (fixed->SelectLeg (100), 3, "fixed leg");
+    }
+  NS_TEST_ASSERT_MSG_EQ (fixed->GetBacklog (3), 1000, "bytes sent to the leg");
+
+  Ptr<PdcpSplitAlgorithm> roundRobin = CreateObject<RoundRobinPdcpSplitAlgorithm> ();
+  roundRobin->SetLegs (legs);
+  for (uint32_t i = 0; i < 9; i++)
+    {
+      NS_TEST_ASSERT_MSG_EQ (roundRobin->SelectLeg (100), legs[i % 3], "round robin");
+    }
+
+  Ptr<PdcpSplitAlgorithm> sdf = CreateObject<ShortestDelayPdcpSplitAlgorithm> ();
+  sdf->SetLegs (legs);
+  sdf->ReportAssistantInfo (2, MakeReport (2, 1000, 3000));
+  sdf->ReportAssistantInfo (3, MakeReport (3, 9000, 1000));
+  sdf->ReportAssistantInfo (1, MakeReport (1, 100, 2000));
+  NS_TEST_ASSERT_MSG_EQ_TOL (sdf->GetQueueDelay (3), 0.1 * 1000 / 10e3, 1e-9, "smoothed delay");
+  NS_TEST_ASSERT_MSG_EQ (sdf->SelectLeg (100), 3, "shortest delay");
+  sdf->ReportAssistantInfo (3, MakeReport (3, 9000, 10000));
+  NS_TEST_ASSERT_MSG_EQ (sdf->SelectLeg (100), 1, "shortest delay after a report");
+
+  Ptr<PdcpSplitAlgorithm> sqf = CreateObject<ShortestQueuePdcpSplitAlgorithm> ();
+  sqf->SetLegs (legs);
+  sqf->ReportAssistantInfo (2, MakeReport (2, 1000, 3000));
+  sqf->ReportAssistantInfo (3, MakeReport (3, 9000, 1000));
+  sqf->ReportAssistantInfo (1, MakeReport (1, 100, 2000));
+  NS_TEST_ASSERT_MSG_EQ (sqf->SelectLeg (100), 1, "shortest queue");
+  NS_TEST_ASSERT_MSG_EQ (sqf->GetQueueSize (1), 100, "reported queue");
+  NS_TEST_ASSERT_MSG_EQ (sqf->GetBacklog (1), 200, "backlog");
+
+  // ties are broken in turn
+  Ptr<PdcpSplitAlgorithm> ties = CreateObject<ShortestQueuePdcpSplitAlgorithm> ();
+  ties->SetLegs (legs);
+  std::map<uint16_t, uint32_t> counts;
+  for (uint32_t i = 0; i < 9; i++)
+    {
+      counts[ties->SelectLeg (100)]++;
+    }
+  NS_TEST_ASSERT_MSG_EQ (counts[1] + counts[2] + counts[3], 9, "PDUs");
+  NS_TEST_ASSERT_MSG_GT (counts[1], 0, "leg starved on ties");
+  NS_TEST_ASSERT_MSG_GT (counts[2], 0, "leg starved on ties");
+  NS_TEST_ASSERT_MSG_GT (counts[3], 0, "leg starved on ties");
+}
+
+/**
+ * Adaptation of the shares of the p-split to the queueing delays
+ */
+class LtePdcpSplitAlgorithmProbabilisticTestCase : public TestCase
+{
+public:
+  LtePdcpSplitAlgorithmProbabilisticTestCase ();
+
+private:
+  virtual void DoRun (void);
+};
+
+LtePdcpSplitAlgorithmProbabilisticTestCase::LtePdcpSplitAlgorithmProbabilisticTestCase ()
+  : TestCase ("PDCP split algorithms, p-split")
+{
+}
+
+void
+LtePdcpSplitAlgorithmProbabilisticTestCase::DoRun (void)
+{
+  Ptr<ProbabilisticPdcpSplitAlgorithm> split = CreateObject<ProbabilisticPdcpSplitAlgorithm> ();
+  split->SetAttribute ("FirstLegShare", DoubleValue (0.5));
+  split->SetAttribute ("Step", DoubleValue (0.001));
+  split->AssignStreams (1);
+  split->SetLegs (MakeLegs (2, 3, 1));
+  NS_TEST_ASSERT_MSG_EQ_TOL (split->GetShare (0), 0.5, 1e-9, "first leg share");
+  NS_TEST_ASSERT_MSG_EQ_TOL (split->GetShare (1), 0.25, 1e-9, "share of the other legs");
+
+  // below the delay threshold, the shares stay
+  std::map<uint16_t, uint32_t> counts;
+  for (uint32_t i = 0; i < 10000; i++)
+    {
+      counts[split->SelectLeg (100)]++;
+    }
+  NS_TEST_ASSERT_MSG_EQ_TOL (split->GetShare (0), 0.5, 1e-9, "share adapted below the threshold");
+  NS_TEST_ASSERT_MSG_EQ_TOL (counts[2] / 10000.0, 0.5, 0.02, "first leg share of the PDUs");
+  NS_TEST_ASSERT_MSG_EQ_TOL (counts[1] / 10000.0, 0.25, 0.02, "third leg share of the PDUs");
+
+  // the first leg is late: Step moves to the fastest leg at each PDU
+  split->ReportAssistantInfo (2, MakeReport (2, 10000, 1000));
+  split->ReportAssistantInfo (1, MakeReport (1, 0, 10));
+  NS_TEST_ASSERT_MSG_GT (split->GetQueueDelay (2), 0.003, "delay above the threshold");
+  for (uint32_t i = 0; i < 100; i++)
+    {
+      split->SelectLeg (100);
+    }
+  NS_TEST_ASSERT_MSG_EQ_TOL (split->GetShare (0), 0.4, 1e-9, "first leg share after adaptation");
+  NS_TEST_ASSERT_MSG_EQ_TOL (split->GetShare (1), 0.35, 1e-9, "share of the leg with no delay");
+  NS_TEST_ASSERT_MSG_EQ_TOL (split->GetShare (2), 0.25, 1e-9, "share of the third leg");
+
+  // the same draws with the same stream
+  Ptr<ProbabilisticPdcpSplitAlgorithm> a = CreateObject<ProbabilisticPdcpSplitAlgorithm> ();
+  Ptr<ProbabilisticPdcpSplitAlgorithm> b = CreateObject<ProbabilisticPdcpSplitAlgorithm> ();
+  a->AssignStreams (7);
+  b->AssignStreams (7);
+  a->SetLegs (MakeLegs (2, 3, 1));
+  b->SetLegs (MakeLegs (2, 3, 1));
+  for (uint32_t i = 0; i < 100; i++)
+    {
+      NS_TEST_ASSERT_MSG_EQ (a->SelectLeg (100), b->SelectLeg (100), "draws differ with the same stream");
+    }
+}
+
+/**
+ * Delivery time and proportional split, fed with reports from which the
+ * drain rates of the legs are estimated
+ */
+class LtePdcpSplitAlgorithmRateTestCase : public TestCase
+{
+public:
+  LtePdcpSplitAlgorithmRateTestCase ();
+
+private:
+  virtual void DoRun (void);
+  void Report (uint32_t q1, uint32_t q2, uint32_t q3);
+  void CheckDeliveryTime ();
+  void CheckProportional ();
+  void CheckBacklogged ();
+
+  Ptr<DeliveryTimePdcpSplitAlgorithm> m_deliveryTime;
+  Ptr<PdcpSplitAlgorithm> m_proportional;
+};
+
+LtePdcpSplitAlgorithmRateTestCase::LtePdcpSplitAlgorithmRateTestCase ()
+  : TestCase ("PDCP split algorithms, delivery time and proportional")
+{
+}
+
+void
+LtePdcpSplitAlgorithmRateTestCase::Report (uint32_t q1, uint32_t q2, uint32_t q3)
+{
+  Ptr<PdcpSplitAlgorithm> algorithms[] = {m_deliveryTime, m_proportional};
+  for (uint32_t i = 0; i < 2; i++)
+    {
+      algorithms[i]->ReportAssistantInfo (1, MakeReport (1, q1, 0));
+      algorithms[i]->ReportAssistantInfo (2, MakeReport (2, q2, 0));
+      algorithms[i]->ReportAssistantInfo (3, MakeReport (3, q3, 0));
+    }
+}
+
+void
+LtePdcpSplitAlgorithmRateTestCase::CheckDeliveryTime ()
+{
+  // the queues drained in 10 ms: 1 MB/s, 500 kB/s and 100 kB/s
+  NS_TEST_EXPECT_MSG_EQ_TOL (m_deliveryTime->GetRate (1), 1e6, 1e-3, "rate of cell 1");
+  NS_TEST_EXPECT_MSG_EQ_TOL (m_deliveryTime->GetRate (3), 1e5, 1e-3, "rate of cell 3");
+
+  // cell 3 is local, the others pay the X2 latency
+  NS_TEST_EXPECT_MSG_EQ_TOL (m_deliveryTime->GetDeliveryTime (0, 1000), 0.001 + 0.001, 1e-9, "remote leg");
+  NS_TEST_EXPECT_MSG_EQ_TOL (m_deliveryTime->GetDeliveryTime (2, 1000), 0.01, 1e-9, "local leg");
+  NS_TEST_EXPECT_MSG_EQ (m_deliveryTime->SelectLeg (1000), 1, "fastest leg");
+  NS_TEST_EXPECT_MSG_EQ_TOL (m_deliveryTime->GetDeliveryTime (0, 1000), 0.002 + 0.001, 1e-9,
+                             "the backlog adds to the delivery time");
+
+  // with a long X2 latency, the local leg is the fastest despite its rate
+  m_deliveryTime->SetAttribute ("X2Latency", TimeValue (MilliSeconds (100)));
+  NS_TEST_EXPECT_MSG_EQ (m_deliveryTime->SelectLeg (1000), 3, "local leg");
+}
+
+void
+LtePdcpSplitAlgorithmRateTestCase::CheckProportional ()
+{
+  // weights 10:5:1
+  std::map<uint16_t, uint32_t> counts;
+  for (uint32_t i = 0; i < 160; i++)
+    {
+      counts[m_proportional->SelectLeg (100)]++;
+    }
+  NS_TEST_EXPECT_MSG_EQ (counts[1], 100, "PDUs of cell 1");
+  NS_TEST_EXPECT_MSG_EQ (counts[2], 50, "PDUs of cell 2");
+  NS_TEST_EXPECT_MSG_EQ (counts[3], 10, "PDUs of cell 3");
+}
+
+void
+LtePdcpSplitAlgorithmRateTestCase::CheckBacklogged ()
+{
+  // the queue of cell 1 grew to 50 kB, more than 20 ms of drain time
+  NS_TEST_EXPECT_MSG_GT (m_proportional->GetBacklog (1) / m_proportional->GetRate (1), 0.02,
+                         "cell 1 not backlogged");
+  for (uint32_t i = 0; i < 10; i++)
+    {
+      NS_TEST_EXPECT_MSG_NE (m_proportional->SelectLeg (100), 1, "PDU sent to a backlogged leg");
+    }
+}
+
+void
+LtePdcpSplitAlgorithmRateTestCase::DoRun (void)
+{
+  m_deliveryTime = CreateObject<DeliveryTimePdcpSplitAlgorithm> ();
+  m_deliveryTime->SetLegs (MakeLegs (1, 2, 3));
+  m_deliveryTime->SetLocalCellId (3);
+  m_proportional = CreateObject<ProportionalPdcpSplitAlgorithm> ();
+  m_proportional->SetLegs (MakeLegs (1, 2, 3));
+  m_proportional->SetLocalCellId (3);
+
+  // with no rate estimate yet, the delivery time split probes the legs in turn
+  NS_TEST_ASSERT_MSG_EQ (m_deliveryTime->SelectLeg (0), 1, "probe");
+  NS_TEST_ASSERT_MSG_EQ (m_deliveryTime->SelectLeg (0), 2, "probe");
+  NS_TEST_ASSERT_MSG_EQ (m_deliveryTime->SelectLeg (0), 3, "probe");
+
+  Simulator::Schedule (MilliSeconds (10), &LtePdcpSplitAlgorithmRateTestCase::Report, this, 10000, 5000, 1000);
+  Simulator::Schedule (MilliSeconds (20), &LtePdcpSplitAlgorithmRateTestCase::Report, this, 0, 0, 0);
+  Simulator::Schedule (MilliSeconds (21), &LtePdcpSplitAlgorithmRateTestCase::CheckDeliveryTime, this);
+  Simulator::Schedule (MilliSeconds (21), &LtePdcpSplitAlgorithmRateTestCase::CheckProportional, this);
+  Simulator::Schedule (MilliSeconds (30), &LtePdcpSplitAlgorithmRateTestCase::Report, this, 50000, 0, 0);
+  Simulator::Schedule (MilliSeconds (31), &LtePdcpSplitAlgorithmRateTestCase::CheckBacklogged, this);
+  Simulator::Run ();
+  Simulator::Destroy ();
+}
+
+/**
+ * The split algorithm of a McEnbPdcp: the legacy numberOfAlgorithm values
+ * and the SplitAlgorithm attribute
+ */
+class LtePdcpSplitAlgorithmMcEnbPdcpTestCase : public TestCase
+{
+public:
+  LtePdcpSplitAlgorithmMcEnbPdcpTestCase ();
+
+private:
+  virtual void DoRun (void);
+};
+
+LtePdcpSplitAlgorithmMcEnbPdcpTestCase::LtePdcpSplitAlgorithmMcEnbPdcpTestCase ()
+  : TestCase ("PDCP split algorithms, McEnbPdcp")
+{
+}
+
+void
+LtePdcpSplitAlgorithmMcEnbPdcpTestCase::DoRun (void)
+{
+  Ptr<McEnbPdcp> sqf = CreateObject<McEnbPdcp> ();
+  sqf->SetAttribute ("numberOfAlgorithm", UintegerValue (5));
+  sqf->SetTargetCellIds (3, 2, 1);
+  NS_TEST_ASSERT_MSG_EQ (sqf->GetSplitAlgorithm ()->GetInstanceTypeId (),
+                         ShortestQueuePdcpSplitAlgorithm::GetTypeId (), "legacy algorithm");
+  std::vector<uint16_t> legs = sqf->GetSplitAlgorithm ()->GetLegs ();
+  NS_TEST_ASSERT_MSG_EQ (legs.size (), 2, "legs");
+  NS_TEST_ASSERT_MSG_EQ (legs[0], 2, "first leg");
+  NS_TEST_ASSERT_MSG_EQ (legs[1], 3, "second leg");
+  NS_TEST_ASSERT_MSG_EQ (sqf->GetSplitAlgorithm ()->IsLocal (1), true, "local cell");
+
+  Ptr<McEnbPdcp> proportional = CreateObject<McEnbPdcp> ();
+  proportional->SetAttribute ("SplitAlgorithm", StringValue ("ns3::ProportionalPdcpSplitAlgorithm"));
+  proportional->SetSplitAlgorithmAttribute ("MaxBacklogTime", TimeValue (MilliSeconds (50)));
+  proportional->SetTargetCellIds (3, 2, 1);
+  proportional->AddSplitLeg (4);
+  proportional->AddSplitLeg (2);
+  Ptr<PdcpSplitAlgorithm> algorithm = proportional->GetSplitAlgorithm ();
+  NS_TEST_ASSERT_MSG_EQ (algorithm->GetInstanceTypeId (), ProportionalPdcpSplitAlgorithm::GetTypeId (), "algorithm");
+  TimeValue maxBacklogTime;
+  algorithm->GetAttribute ("MaxBacklogTime", maxBacklogTime);
+  NS_TEST_ASSERT_MSG_EQ (maxBacklogTime.Get (), MilliSeconds (50), "algorithm attribute");
+  NS_TEST_ASSERT_MSG_EQ (algorithm->GetLegs ().size (), 3, "extra leg");
+  NS_TEST_ASSERT_MSG_EQ (algorithm->GetLegs ()[2], 4, "extra leg");
+
+  sqf->Dispose ();
+  proportional->Dispose ();
+}
+
+class LtePdcpSplitAlgorithmTestSuite : public TestSuite
+{
+public:
+  LtePdcpSplitAlgorithmTestSuite ();
+};
+
+LtePdcpSplitAlgorithmTestSuite::LtePdcpSplitAlgorithmTestSuite ()
+  : TestSuite ("lte-pdcp-split-algorithm", UNIT)
+{
+  AddTestCase (new LtePdcpSplitAlgorithmSelectionTestCase, TestCase::QUICK);
+  AddTestCase (new LtePdcpSplitAlgorithmProbabilisticTestCase, TestCase::QUICK);
+  AddTestCase (new LtePdcpSplitAlgorithmRateTestCase, TestCase::QUICK);
+  AddTestCase (new LtePdcpSplitAlgorithmMcEnbPdcpTestCase, TestCase::QUICK);
+}
+
+static LtePdcpSplitAlgorithmTestSuite ltePdcpSplitAlgorithmTestSuite;
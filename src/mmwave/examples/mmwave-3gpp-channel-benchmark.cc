@@ -0,0 +1,238 @@
+ /* -*-  Mode: C++; c-file-style: "gnu"; indent-tabs-mode:nil; -*- */
+ /*
+ *   This program is free software; you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License version 2 as
+ *   published by the Free Software Foundation;
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program; if not, write to the Free Software
+ *   Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+
+#include "ns3/core-module.h"
+#include "ns3/mmwave-3gpp-channel.h"
+#include "ns3/mmwave-phy-mac-common.h"
+#include <chrono>
+#include <iostream>
+
+using namespace ns3;
+
+/*
+ * Memory per link and time per BF update of the channel coefficients of
+ * MmWave3gppChannel, stored in a ChannelTensor, for several antenna array
+ * sizes. The same sums over the coefficients are also timed on nested
+ * vectors H[u][s][n], the layout the coefficients used to have.
+ */
+
+/*
+ * @returns the bytes held by nested vectors, without the allocator overhead
+ */
+static uint64_t
+GetNestedMemoryUsage (const complex3DVector_t &h)
+{
+  uint64_t bytes = sizeof (h) + h.capacity () * sizeof (complex2DVector_t);
+  for (uint32_t u = 0; u < h.size (); u++)
+    {
+      bytes += h[u].capacity () * sizeof (complexVector_t);
+      for (uint32_t s = 0; s < h[u].size (); s++)
+        {
+          bytes += h[u][s].capacity () * sizeof (std::complex<double>);
+        }
+    }
+  return bytes;
+}
+
+/*
+ * The tx and rx spatial correlation matrices and the long term components,
+ * as computed by the BF update, on nested vectors
+ */
+static std::complex<double>
+NestedBfSums (const complex3DVector_t &h, const complexVector_t &txW, const complexVector_t &rxW)
+{
+  std::complex<double> check (0, 0);
+  for (uint16_t t1 = 0; t1 < h.at (0).size (); t1++)
+    {
+      for (uint16_t t2 = 0; t2 < h.at (0).size (); t2++)
+        {
+          for (uint16_t u = 0; u < h.size (); u++)
+            {
+              for (uint8_t n = 0; n < h.at (u).at (t1).size (); n++)
+                {
+                  check += std::conj (h.at (u).at (t1).at (n)) * h.at (u).at (t2).at (n);
+                }
+            }
+        }
+    }
+  for (uint16_t u1 = 0; u1 < h.size (); u1++)
+    {
+      for (uint16_t u2 = 0; u2 < h.size (); u2++)
+        {
+          for (uint16_t s = 0; s < h.at (0).size (); s++)
+            {
+              for (uint8_t n = 0; n < h.at (u1).at (s).size (); n++)
+                {
+                  check += h.at (u1).at (s).at (n) * std::conj (h.at (u2).at (s).at (n));
+                }
+            }
+        }
+    }
+  for (uint8_t n = 0; n < h.at (0).at (0).size (); n++)
+    {
+      for (uint16_t s = 0; s < h.at (0).size (); s++)
+        {
+          for (uint16_t u = 0; u < h.size (); u++)
+            {
+              check += txW.at (s) * std::conj (rxW.at (u)) * h.at (u).at (s).at (n);
+            }
+        }
+    }
+  return check;
+}
+
+/*
+ * The same sums on a ChannelTensor
+ */
+static std::complex<double>
+TensorBfSums (const ChannelTensor &h, const complexVector_t &txW, const complexVector_t &rxW)
+{
+  std::complex<double> check (0, 0);
+  uint8_t numCluster = h.GetNumCluster ();
+  for (uint16_t t1 = 0; t1 < h.GetTxSize (); t1++)
+    {
+      for (uint16_t t2 = 0; t2 < h.GetTxSize (); t2++)
+        {
+          for (uint16_t u = 0; u < h.GetRxSize (); u++)
+            {
+              const std::complex<double> *h1 = h.GetClusters (u, t1);
+              const std::complex<double> *h2 = h.GetClusters (u, t2);
+              for (uint8_t n = 0; n < numCluster; n++)
+                {
+                  check += std::conj (h1[n]) * h2[n];
+                }
+            }
+        }
+    }
+  for (uint16_t u1 = 0; u1 < h.GetRxSize (); u1++)
+    {
+      for (uint16_t u2 = 0; u2 < h.GetRxSize (); u2++)
+        {
+          for (uint16_t s = 0; s < h.GetTxSize (); s++)
+            {
+              const std::complex<double> *h1 = h.GetClusters (u1, s);
+              const std::complex<double> *h2 = h.GetClusters (u2, s);
+              for (uint8_t n = 0; n < numCluster; n++)
+                {
+                  check += h1[n] * std::conj (h2[n]);
+                }
+            }
+        }
+    }
+  for (uint16_t u = 0; u < h.GetRxSize (); u++)
+    {
+      for (uint16_t s = 0; s < h.GetTxSize (); s++)
+        {
+          std::complex<double> weight = std::conj (rxW.at (u)) * txW.at (s);
+          const std::complex<double> *hus = h.GetClusters (u, s);
+          for (uint8_t n = 0; n < numCluster; n++)
+            {
+              check += weight * hus[n];
+            }
+        }
+    }
+  return check;
+}
+
+static double
+ElapsedNs (std::chrono::steady_clock::time_point start, uint32_t n)
+{
+  return std::chrono::duration<double, std::nano> (std::chrono::steady_clock::now () - start).count () / n;
+}
+
+static void
+RunBenchmark (uint16_t txSize, uint16_t rxSize, uint8_t numCluster, uint32_t nUpdates)
+{
+  Ptr<MmWavePhyMacCommon> config = CreateObject<MmWavePhyMacCommon> ();
+  Ptr<MmWave3gppChannel> channel = CreateObject<MmWave3gppChannel> ();
+  channel->SetConfigurationParameters (config);
+
+  Ptr<UniformRandomVariable> rv = CreateObject<UniformRandomVariable> ();
+  Ptr<Params3gpp> params = Create<Params3gpp> ();
+  params->m_channel.Resize (rxSize, txSize, numCluster);
+  complex3DVector_t nested (rxSize, complex2DVector_t (txSize));
+  for (uint16_t u = 0; u < rxSize; u++)
+    {
+      for (uint16_t s = 0; s < txSize; s++)
+        {
+          for (uint8_t n = 0; n < numCluster; n++)
+            {
+              std::complex<double> h = std::polar (rv->GetValue (0.01, 1), rv->GetValue (0, 2 * M_PI));
+              params->m_channel (u, s, n) = h;
+              nested[u][s].push_back (h);
+            }
+        }
+    }
+  params->m_angle.resize (4);
+  for (uint8_t n = 0; n < numCluster; n++)
+    {
+      params->m_delay.push_back (rv->GetValue (0, 1e-6));
+      for (uint32_t direction = 0; direction < 4; direction++)
+        {
+          params->m_angle[direction].push_back (rv->GetValue (0, 180));
+        }
+    }
+
+  std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now ();
+  for (uint32_t i = 0; i < nUpdates; i++)
+    {
+      channel->LongTermCovMatrixBeamforming (params);
+      channel->CalLongTerm (params);
+    }
+  double updateNs = ElapsedNs (start, nUpdates);
+
+  std::complex<double> nestedCheck;
+  start = std::chrono::steady_clock::now ();
+  for (uint32_t i = 0; i < nUpdates; i++)
+    {
+      nestedCheck = NestedBfSums (nested, params->m_txW, params->m_rxW);
+    }
+  double nestedNs = ElapsedNs (start, nUpdates);
+  std::complex<double> tensorCheck;
+  start = std::chrono::steady_clock::now ();
+  for (uint32_t i = 0; i < nUpdates; i++)
+    {
+      tensorCheck = TensorBfSums (params->m_channel, params->m_txW, params->m_rxW);
+    }
+  double tensorNs = ElapsedNs (start, nUpdates);
+  NS_ABORT_MSG_IF (std::abs (tensorCheck - nestedCheck) > 1e-9 * std::abs (nestedCheck), "the layouts disagree");
+
+  std::cout << txSize << "x" << rxSize << " elements, " << (uint16_t) numCluster << " clusters: "
+            << params->m_channel.GetMemoryUsage () << " bytes per link ("
+            << GetNestedMemoryUsage (nested) << " with nested vectors, in "
+            << 1 + rxSize + (uint32_t) rxSize * txSize << " allocations), "
+            << updateNs / 1e3 << " us per BF update, of which sums over the coefficients "
+            << tensorNs / 1e3 << " us (" << nestedNs / 1e3 << " us with nested vectors)" << std::endl;
+}
+
+int
+main (int argc, char *argv[])
+{
+  uint32_t numCluster = 23;
+  uint32_t nUpdates = 20;
+
+  CommandLine cmd;
+  cmd.AddValue ("numCluster", "Number of clusters, with the sub-clusters", numCluster);
+  cmd.AddValue ("nUpdates", "Number of BF updates timed for each array size", nUpdates);
+  cmd.Parse (argc, argv);
+
+  RunBenchmark (16, 4, numCluster, nUpdates);
+  RunBenchmark (64, 16, numCluster, nUpdates);
+  RunBenchmark (128, 32, numCluster, nUpdates);
+  Simulator::Destroy ();
+  return 0;
+}
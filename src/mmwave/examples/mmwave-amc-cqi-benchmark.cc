@@ -0,0 +1,160 @@
+ /* -*-  Mode: C++; c-file-style: "gnu"; indent-tabs-mode:nil; -*- */
+ /*
+ *   This program is free software; you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License version 2 as
+ *   published by the Free Software Foundation;
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program; if not, write to the Free Software
+ *   Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+
+#include "ns3/core-module.h"
+#include "ns3/mmwave-amc.h"
+#include "ns3/mmwave-mi-error-model.h"
+#include "ns3/mmwave-phy-mac-common.h"
+#include "ns3/mmwave-spectrum-value-helper.h"
+#include <chrono>
+#include <iostream>
+#include <map>
+#include <vector>
+
+using namespace ns3;
+
+/*
+ * Time the wideband CQI reports of MmWaveAmc::CreateCqiFeedbackWbTdma with
+ * the MI error model, on frequency selective SINR vectors drawn with a
+ * fixed seed, and check its MCS and CQI against a search evaluating the
+ * error model from the SINRs for every MCS.
+ */
+
+/*
+ * The MCS chosen by evaluating the error model from the SINRs for every
+ * MCS, up to the first one over 10 % of TB error rate
+ */
+static int
+ReferenceMcs (const SpectrumValue& sinr, uint32_t tbSize, bool &outage)
+{
+  std::vector<int> chunkMap;
+  for (uint32_t i = 0; i < sinr.GetSpectrumModel ()->GetNumBands (); i++)
+    {
+      chunkMap.push_back (i);
+    }
+  int mcs = 0;
+  MmWaveTbStats_t tbStats;
+  while (mcs <= 28)
+    {
+      MmWaveHarqProcessInfoList_t harqInfoList;
+      tbStats = MmWaveMiErrorModel::GetTbDecodificationStats (sinr, chunkMap, tbSize, mcs, harqInfoList);
+      if (tbStats.tbler > 0.1)
+        {
+          break;
+        }
+      mcs++;
+    }
+  if (mcs > 0)
+    {
+      mcs--;
+    }
+  outage = (tbStats.tbler > 0.1 && mcs == 0);
+  return mcs;
+}
+
+int
+main (int argc, char *argv[])
+{
+  uint32_t nReports = 2000;
+  uint32_t nRounds = 10;
+
+  CommandLine cmd;
+  cmd.AddValue ("nReports", "Number of SINR vectors", nReports);
+  cmd.AddValue ("nRounds", "Number of times the reports of all the SINR vectors are timed", nRounds);
+  cmd.Parse (argc, argv);
+
+  RngSeedManager::SetSeed (1);
+  RngSeedManager::SetRun (1);
+
+  Ptr<MmWavePhyMacCommon> config = CreateObject<MmWavePhyMacCommon> ();
+  Ptr<MmWaveAmc> amc = CreateObject<MmWaveAmc> (config);
+  Ptr<SpectrumModel> model = MmWaveSpectrumValueHelper::GetSpectrumModel (config);
+
+  // SINRs from -10 to 40 dB on average, with a few dB of fading across
+  // the band, and TBs of any MCS over a slot
+  Ptr<UniformRandomVariable> rv = CreateObject<UniformRandomVariable> ();
+  std::vector<SpectrumValue> sinrs;
+  std::vector<uint32_t> tbSizes;
+  std::vector<uint8_t> numSyms;
+  for (uint32_t i = 0; i < nReports; i++)
+    {
+      SpectrumValue sinr (model);
+      double averageDb = rv->GetValue (-10, 40);
+      double fadingDb = rv->GetValue (0, 10);
+      for (Values::iterator it = sinr.ValuesBegin (); it != sinr.ValuesEnd (); it++)
+        {
+          *it = std::pow (10, (averageDb + rv->GetValue (-fadingDb, fadingDb)) / 10);
+        }
+      sinrs.push_back (sinr);
+      numSyms.push_back (rv->GetInteger (1, config->GetSymbPerSlot ()));
+      tbSizes.push_back (amc->GetTbSizeFromMcsSymbols (rv->GetInteger (0, 28), numSyms.back ()) / 8);
+    }
+
+  // the CQI is a function of the MCS, but in outage
+  std::map<int, int> cqiOfMcs;
+  uint32_t nMcs28 = 0;
+  uint32_t nOutages = 0;
+  for (uint32_t i = 0; i < nReports; i++)
+    {
+      bool outage;
+      int referenceMcs = ReferenceMcs (sinrs[i], tbSizes[i], outage);
+      int mcs;
+      int cqi = amc->CreateCqiFeedbackWbTdma (sinrs[i], numSyms[i], tbSizes[i], mcs);
+      NS_ABORT_MSG_IF (mcs != referenceMcs, "report " << i << ": MCS " << mcs << " instead of " << referenceMcs);
+      if (outage)
+        {
+          NS_ABORT_MSG_IF (cqi != 0, "report " << i << ": CQI " << cqi << " in outage");
+          nOutages++;
+          continue;
+        }
+      nMcs28 += (mcs == 28);
+      if (cqiOfMcs.find (mcs) == cqiOfMcs.end ())
+        {
+          cqiOfMcs[mcs] = cqi;
+        }
+      NS_ABORT_MSG_IF (cqi != cqiOfMcs[mcs], "report " << i << ": CQI " << cqi << " for MCS " << mcs
+                       << " instead of " << cqiOfMcs[mcs]);
+    }
+
+  std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now ();
+  for (uint32_t round = 0; round < nRounds; round++)
+    {
+      for (uint32_t i = 0; i < nReports; i++)
+        {
+          bool outage;
+          ReferenceMcs (sinrs[i], tbSizes[i], outage);
+        }
+    }
+  double referenceSeconds = std::chrono::duration<double> (std::chrono::steady_clock::now () - start).count ();
+  start = std::chrono::steady_clock::now ();
+  for (uint32_t round = 0; round < nRounds; round++)
+    {
+      for (uint32_t i = 0; i < nReports; i++)
+        {
+          int mcs;
+          amc->CreateCqiFeedbackWbTdma (sinrs[i], numSyms[i], tbSizes[i], mcs);
+        }
+    }
+  double seconds = std::chrono::duration<double> (std::chrono::steady_clock::now () - start).count ();
+
+  std::cout << nReports << " reports over " << model->GetNumBands () << " chunks, " << nOutages
+            << " in outage, " << nMcs28 << " at MCS 28: same MCS and CQI as the search from the SINRs" << std::endl;
+  std::cout << nReports * nRounds / seconds << " reports/s, "
+            << nReports * nRounds / referenceSeconds << " reports/s with the MI from the SINRs for every MCS"
+            << std::endl;
+  return 0;
+}
@@ -0,0 +1,108 @@
+ /* -*-  Mode: C++; c-file-style: "gnu"; indent-tabs-mode:nil; -*- */
+ /*
+ *   This program is free software; you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License version 2 as
+ *   published by the Free Software Foundation;
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program; if not, write to the Free Software
+ *   Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+
+#include "ns3/core-module.h"
+#include "ns3/network-module.h"
+#include "ns3/mobility-module.h"
+#include "ns3/mmwave-helper.h"
+#include <ns3/buildings-helper.h>
+#include <chrono>
+#include <iostream>
+
+using namespace ns3;
+
+/*
+ * Wall-clock time of a scenario with many eNBs and UEs, where each eNB
+ * computes the path loss towards every UE, with and without the monitoring
+ * of the real SINR in MmWaveEnbPhy::CallPathloss. Compare e.g.
+ *
+ *   ./waf --run "mmwave-pathloss-monitor-benchmark --monitorPeriod=0"
+ *   ./waf --run "mmwave-pathloss-monitor-benchmark --monitorPeriod=125"
+ *
+ * the latter being the behaviour before the monitoring was made optional.
+ */
+int
+main (int argc, char *argv[])
+{
+  uint32_t nEnbs = 10;
+  uint32_t nUes = 200;
+  double simTime = 0.1;
+  uint32_t monitorPeriod = 0;
+  double side = 400.0;
+
+  CommandLine cmd;
+  cmd.AddValue ("nEnbs", "Number of eNBs", nEnbs);
+  cmd.AddValue ("nUes", "Number of UEs", nUes);
+  cmd.AddValue ("simTime", "Simulated time [s]", simTime);
+  cmd.AddValue ("monitorPeriod", "Period of the real SINR monitoring of the eNBs [us], 0 to disable it", monitorPeriod);
+  cmd.AddValue ("side", "Side of the square area of the eNBs and UEs [m]", side);
+  cmd.Parse (argc, argv);
+
+  Config::SetDefault ("ns3::MmWaveEnbPhy::PathlossMonitorPeriod", TimeValue (MicroSeconds (monitorPeriod)));
+
+  Ptr<MmWaveHelper> ptr_mmWave = CreateObject<MmWaveHelper> ();
+  ptr_mmWave->Initialize();
+
+  NodeContainer enbNodes;
+  NodeContainer ueNodes;
+  enbNodes.Create (nEnbs);
+  ueNodes.Create (nUes);
+
+  // the eNBs on a line across the area, the UEs spread at random
+  Ptr<ListPositionAllocator> enbPositionAlloc = CreateObject<ListPositionAllocator> ();
+  for (uint32_t i = 0; i < nEnbs; i++)
+    {
+      enbPositionAlloc->Add (Vector (side * (i + 0.5) / nEnbs, side / 2, 10.0));
+    }
+  MobilityHelper enbmobility;
+  enbmobility.SetMobilityModel ("ns3::ConstantPositionMobilityModel");
+  enbmobility.SetPositionAllocator (enbPositionAlloc);
+  enbmobility.Install (enbNodes);
+  BuildingsHelper::Install (enbNodes);
+
+  Ptr<UniformRandomVariable> coordinate = CreateObject<UniformRandomVariable> ();
+  coordinate->SetAttribute ("Max", DoubleValue (side));
+  Ptr<ListPositionAllocator> uePositionAlloc = CreateObject<ListPositionAllocator> ();
+  for (uint32_t i = 0; i < nUes; i++)
+    {
+      double x = coordinate->GetValue ();
+      uePositionAlloc->Add (Vector (x, coordinate->GetValue (), 1.5));
+    }
+  MobilityHelper uemobility;
+  uemobility.SetMobilityModel ("ns3::ConstantPositionMobilityModel");
+  uemobility.SetPositionAllocator (uePositionAlloc);
+  uemobility.Install (ueNodes);
+  BuildingsHelper::Install (ueNodes);
+
+  NetDeviceContainer enbNetDev = ptr_mmWave->InstallEnbDevice_28GHZ (enbNodes);
+  NetDeviceContainer ueNetDev = ptr_mmWave->InstallUeDevice (ueNodes);
+  ptr_mmWave->AttachToClosestEnb (ueNetDev, enbNetDev);
+
+  enum EpsBearer::Qci q = EpsBearer::GBR_CONV_VOICE;
+  EpsBearer bearer (q);
+  ptr_mmWave->ActivateDataRadioBearer (ueNetDev, bearer);
+
+  Simulator::Stop (Seconds (simTime));
+  std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now ();
+  Simulator::Run ();
+  double elapsed = std::chrono::duration<double> (std::chrono::steady_clock::now () - start).count ();
+  Simulator::Destroy ();
+
+  std::cout << nEnbs << " eNBs, " << nUes << " UEs, monitor period " << monitorPeriod << " us: "
+            << elapsed << " s of wall-clock time for " << simTime << " s of simulated time" << std::endl;
+  return 0;
+}
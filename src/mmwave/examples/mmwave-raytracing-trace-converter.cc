@@ -0,0 +1,167 @@
+ /* -*-  Mode: C++; c-file-style: "gnu"; indent-tabs-mode:nil; -*- */
+ /*
+ *   This program is free software; you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License version 2 as
+ *   published by the Free Software Foundation;
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program; if not, write to the Free Software
+ *   Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+
+#include "ns3/core-module.h"
+#include "ns3/mmwave-raytracing-traces.h"
+#include <chrono>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <vector>
+
+using namespace ns3;
+
+/*
+ * Convert a text raytracing trace of MmWaveChannelRaytracing to the binary
+ * format of MmWaveRaytracingTraces, then compare the load time and memory
+ * of the binary file, of the text file, and of the text file parsed into a
+ * vector per position and quantity. Without an input file, a trace of
+ * random paths is written first.
+ *
+ * Use the binary file with
+ *   --ns3::MmWaveChannelRaytracing::TraceFile=<output>
+ */
+
+typedef std::vector<std::vector<double> > PositionVectors;
+
+/*
+ * The text parsing with a vector per position and quantity, and its heap
+ * usage
+ */
+static uint64_t
+ReadVectors (std::string filename, PositionVectors columns[8])
+{
+  std::ifstream singlefile (filename.c_str (), std::ifstream::in);
+  std::string line;
+  std::string token;
+  uint16_t counter = 0;
+  uint64_t bytes = 0;
+  while (std::getline (singlefile, line))
+    {
+      if (counter == 8)
+        {
+          counter = 0;
+        }
+      std::vector<double> path;
+      std::istringstream stream (line);
+      while (getline (stream, token, ','))
+        {
+          double sigma = 0.00;
+          std::stringstream stream (token);
+          stream >> sigma;
+          path.push_back (sigma);
+        }
+      bytes += sizeof (path) + path.capacity () * sizeof (double);
+      columns[counter++].push_back (path);
+    }
+  return bytes;
+}
+
+static void
+WriteRandomTrace (std::string filename, uint32_t nPositions, uint32_t maxPaths)
+{
+  Ptr<UniformRandomVariable> rv = CreateObject<UniformRandomVariable> ();
+  std::ofstream out (filename.c_str ());
+  out.precision (10);
+  for (uint32_t position = 0; position < nPositions; position++)
+    {
+      uint32_t nPaths = rv->GetInteger (1, maxPaths);
+      out << nPaths << "\n";
+      double ranges[7][2] = {{10, 1000}, {-160, -60}, {-180, 180}, {-90, 90}, {-180, 180}, {-90, 90}, {-180, 180}};
+      for (uint32_t column = 0; column < 7; column++)
+        {
+          for (uint32_t path = 0; path < nPaths; path++)
+            {
+              out << (path > 0 ? "," : "") << rv->GetValue (ranges[column][0], ranges[column][1]);
+            }
+          out << "\n";
+        }
+    }
+}
+
+int
+main (int argc, char *argv[])
+{
+  std::string input = "";
+  std::string output = "raytracing-traces.bin";
+  uint32_t nPositions = 26051;
+  uint32_t maxPaths = 20;
+
+  CommandLine cmd;
+  cmd.AddValue ("input", "Text raytracing trace to convert, a random one if empty", input);
+  cmd.AddValue ("output", "Binary raytracing trace to write", output);
+  cmd.AddValue ("nPositions", "Positions of the random trace", nPositions);
+  cmd.AddValue ("maxPaths", "Largest number of paths of a position of the random trace", maxPaths);
+  cmd.Parse (argc, argv);
+
+  if (input.empty ())
+    {
+      input = output + ".txt";
+      WriteRandomTrace (input, nPositions, maxPaths);
+    }
+
+  std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now ();
+  MmWaveRaytracingTraces::ConvertToBinary (input, output);
+  double convertSeconds = std::chrono::duration<double> (std::chrono::steady_clock::now () - start).count ();
+
+  start = std::chrono::steady_clock::now ();
+  PositionVectors vectors[8];
+  uint64_t vectorBytes = ReadVectors (input, vectors);
+  double vectorSeconds = std::chrono::duration<double> (std::chrono::steady_clock::now () - start).count ();
+
+  start = std::chrono::steady_clock::now ();
+  Ptr<MmWaveRaytracingTraces> text = MmWaveRaytracingTraces::Load (input);
+  double textSeconds = std::chrono::duration<double> (std::chrono::steady_clock::now () - start).count ();
+
+  start = std::chrono::steady_clock::now ();
+  Ptr<MmWaveRaytracingTraces> binary = MmWaveRaytracingTraces::Load (output);
+  double binarySeconds = std::chrono::duration<double> (std::chrono::steady_clock::now () - start).count ();
+
+  // every path of every position is the same in the three
+  NS_ABORT_MSG_IF (binary->GetNumPositions () != vectors[0].size () || text->GetNumPositions () != vectors[0].size (),
+                   "positions differ");
+  start = std::chrono::steady_clock::now ();
+  for (uint32_t position = 0; position < binary->GetNumPositions (); position++)
+    {
+      uint32_t nPaths = vectors[0][position].at (0);
+      NS_ABORT_MSG_IF (binary->GetNumPaths (position) != nPaths || text->GetNumPaths (position) != nPaths,
+                       "paths of position " << position << " differ");
+      for (uint8_t column = 0; column < MmWaveRaytracingTraces::NUM_COLUMNS; column++)
+        {
+          MmWaveRaytracingTraces::Column c = static_cast<MmWaveRaytracingTraces::Column> (column);
+          const double* binaryPaths = binary->GetPaths (position, c);
+          const double* textPaths = text->GetPaths (position, c);
+          for (uint32_t path = 0; path < nPaths; path++)
+            {
+              double value = vectors[column + 1][position].at (path);
+              NS_ABORT_MSG_IF (binaryPaths[path] != value || textPaths[path] != value,
+                               "path " << path << " of position " << position << " differs");
+            }
+        }
+    }
+  double readSeconds = std::chrono::duration<double> (std::chrono::steady_clock::now () - start).count ();
+
+  std::cout << input << " -> " << output << ": " << binary->GetNumPositions () << " positions, converted in "
+            << convertSeconds << " s" << std::endl;
+  std::cout << "vector per position and quantity: " << vectorSeconds << " s, "
+            << vectorBytes / 1024 << " KiB" << std::endl;
+  std::cout << "text file: " << textSeconds << " s, " << text->GetMemoryUsage () / 1024 << " KiB" << std::endl;
+  std::cout << "binary file: " << binarySeconds << " s, " << binary->GetMemoryUsage () / 1024 << " KiB, "
+            << binary->GetMappedSize () / 1024 << " KiB mapped, read through in " << readSeconds
+            << " s along with the text ones" << std::endl;
+  return 0;
+}
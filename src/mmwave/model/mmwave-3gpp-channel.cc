@@ -560,13 +560,13 @@ MmWave3gppChannel::DoCalcRxPowerSpectralDensity (Ptr<const SpectrumValue> txPsd,
 
 	//I only update the fowrad channel.
 	if ((it == m_channelMap.end () && itReverse == m_channelMap.end ()) ||
-			(it != m_channelMap.end () && it->second->m_channel.size() == 0)||
+			(it != m_channelMap.end () && it->second->m_channel.IsEmpty ())||
 			(it != m_channelMap.end () && it->second->m_los != los))
 	{
 		NS_LOG_INFO("Update or create the forward channel");
 		NS_LOG_LOGIC("it == m_channelMap.end () " << (it == m_channelMap.end ()));
 		NS_LOG_LOGIC("itReverse == m_channelMap.end () " << (itReverse == m_channelMap.end ()));
-		NS_LOG_LOGIC("it->second->m_channel.size() == 0 " << (it->second->m_channel.size() == 0));
+		NS_LOG_LOGIC("it->second->m_channel.IsEmpty () " << (it->second->m_channel.IsEmpty ()));
 		NS_LOG_LOGIC("it->second->m_los != los" << (it->second->m_los != los));
 		
 		//Step 1: The parameters are configured in the example code.
@@ -599,7 +599,7 @@ MmWave3gppChannel::DoCalcRxPowerSpectralDensity (Ptr<const SpectrumValue> txPsd,
 
 		// Step 4-11 are performed in function GetNewChannel()
 		if((it == m_channelMap.end () && itReverse == m_channelMap.end ()) ||
-				(it != m_channelMap.end () && it->second->m_channel.size() == 0))
+				(it != m_channelMap.end () && it->second->m_channel.IsEmpty ()))
 		{
 			//delete the channel parameter to cause the channel to be updated again.
 			//The m_updatePeriod can be configured to be relatively large in order to disable updates.
@@ -613,7 +613,7 @@ MmWave3gppChannel::DoCalcRxPowerSpectralDensity (Ptr<const SpectrumValue> txPsd,
 		double distance3D = a->GetDistanceFrom(b);
 
 		bool channelUpdate = false;
-		if(it != m_channelMap.end () && it->second->m_channel.size() == 0)
+		if(it != m_channelMap.end () && it->second->m_channel.IsEmpty ())
 		{
 			//if the channel map is not empty, we only update the channel.
 			NS_LOG_DEBUG ("Update forward channel consistently between device " << a << " " << b);
@@ -737,157 +737,136 @@ MmWave3gppChannel::DoCalcRxPowerSpectralDensity (Ptr<const SpectrumValue> txPsd,
 	return bfPsd;
 }
 
-void
-MmWave3gppChannel::LongTermCovMatrixBeamforming(Ptr<Params3gpp> params) const
+/*
+ * Sum over i < n of conj(a[i])*b[i], on the real and imaginary parts
+ * separately so that the loop can be vectorized
+ */
+static std::complex<double>
+ConjDot (const std::complex<double> *a, const std::complex<double> *b, uint32_t n)
 {
-	//generate transmitter side spatial correlation matrix
-	uint8_t txSize = params->m_channel.at(0).size();
-	uint8_t rxSize = params->m_channel.size();
-	complex2DVector_t txQ;
-	txQ.resize(txSize);
-
-	for (uint8_t txIndex = 0; txIndex < txSize; txIndex++)
+	const double *x = reinterpret_cast<const double *> (a);
+	const double *y = reinterpret_cast<const double *> (b);
+	double re = 0, im = 0;
+	for (uint32_t i = 0; i < 2*n; i += 2)
 	{
-		txQ.at(txIndex).resize(txSize);
+		re += x[i]*y[i] + x[i+1]*y[i+1];
+		im += x[i]*y[i+1] - x[i+1]*y[i];
 	}
+	return std::complex<double> (re, im);
+}
 
-	//compute the transmitter side spatial correlation matrix txQ = H*H, where H is the sum of H_n over n clusters.
-	for (uint8_t t1Index = 0; t1Index < txSize; t1Index++)
-	{
-		for (uint8_t t2Index = 0; t2Index < txSize; t2Index++)
-		{
-			for(uint8_t rxIndex = 0; rxIndex < rxSize; rxIndex++)
-			{
-				std::complex<double> cSum (0,0);
-				for (uint8_t cIndex = 0; cIndex < params->m_channel.at(rxIndex).at(t1Index).size(); cIndex++)
-				{
-					cSum = cSum + std::conj(params->m_channel.at(rxIndex).at(t1Index).at(cIndex))*
-							(params->m_channel.at(rxIndex).at(t2Index).at(cIndex));
-				}
-				txQ[t1Index][t2Index] += cSum;
-			}
-
-		}
-	}
-
-
-	//calculate beamforming vector from spatial correlation matrix.
-	complexVector_t antennaWeights;
-	uint8_t txAntenna = txQ.size ();
-	for (uint8_t eIndex = 0; eIndex < txAntenna; eIndex++)
+/*
+ * Sum over i < n of a[i]*b[i]
+ */
+static std::complex<double>
+Dot (const std::complex<double> *a, const std::complex<double> *b, uint32_t n)
+{
+	const double *x = reinterpret_cast<const double *> (a);
+	const double *y = reinterpret_cast<const double *> (b);
+	double re = 0, im = 0;
+	for (uint32_t i = 0; i < 2*n; i += 2)
 	{
-		antennaWeights.push_back(txQ.at (0).at (eIndex));
+		re += x[i]*y[i] - x[i+1]*y[i+1];
+		im += x[i]*y[i+1] + x[i+1]*y[i];
 	}
+	return std::complex<double> (re, im);
+}
 
-
+/*
+ * Power method on the Hermitian matrix q of size n x n, stored by rows,
+ * starting from its first row. The result is left in w, wNew is scratch space
+ */
+static void
+PowerIteration (const complexVector_t &q, uint16_t n, complexVector_t &w, complexVector_t &wNew)
+{
+	w.assign (q.begin (), q.begin () + n);
+	wNew.resize (n);
 	int iter = 10;
 	double diff = 1;
 	while(iter != 0 && diff>1e-10)
 	{
-		complexVector_t antennaWeights_New;
-
-		for(uint8_t row = 0; row<txAntenna; row++)
-		{
-			std::complex<double> sum(0,0);
-			for (uint8_t col = 0; col< txAntenna; col++)
-			{
-				sum += txQ.at (row).at (col)*antennaWeights.at (col);
-			}
-
-		    antennaWeights_New.push_back(sum);
-		}
-		//normalize antennaWeights;
 		double weightSum = 0;
-		for (uint8_t i = 0; i< txAntenna; i++)
-		{
-			weightSum += norm(antennaWeights_New. at(i));
-		}
-		for (uint8_t i = 0; i< txAntenna; i++)
+		for (uint16_t row = 0; row < n; row++)
 		{
-			antennaWeights_New. at(i) = antennaWeights_New. at(i)/sqrt(weightSum);
+			wNew[row] = Dot (&q[(std::size_t) row*n], &w[0], n);
+			weightSum += norm (wNew[row]);
 		}
+		//normalize antennaWeights;
+		double scale = 1/sqrt(weightSum);
 		diff = 0;
-		for (uint8_t i = 0; i< txAntenna; i++)
+		for (uint16_t i = 0; i < n; i++)
 		{
-			diff += std::norm(antennaWeights_New. at(i)-antennaWeights. at(i));
+			wNew[i] *= scale;
+			diff += std::norm (wNew[i] - w[i]);
 		}
 		iter--;
-		antennaWeights = antennaWeights_New;
+		w.swap (wNew);
 	}
+}
 
-	params->m_txW = antennaWeights;
+//the side of the blocks of the spatial correlation matrix computed together
+static const uint16_t COV_BLOCK = 8;
 
-	//compute the receiver side spatial correlation matrix rxQ = HH*, where H is the sum of H_n over n clusters.
-	complex2DVector_t rxQ;
-	rxQ.resize(rxSize);
-	for (uint8_t r1Index = 0; r1Index < rxSize; r1Index++)
-	{
-		rxQ.at(r1Index).resize(rxSize);
-	}
+void
+MmWave3gppChannel::LongTermCovMatrixBeamforming(Ptr<Params3gpp> params) const
+{
+	uint16_t txSize = params->m_channel.GetTxSize();
+	uint16_t rxSize = params->m_channel.GetRxSize();
+	uint8_t numCluster = params->m_channel.GetNumCluster();
+	complexVector_t &q = params->m_bfCov;
+	complexVector_t &scratch = params->m_bfScratch;
 
-	for (uint8_t r1Index = 0; r1Index < rxSize; r1Index++)
+	//compute the transmitter side spatial correlation matrix txQ = H*H, where H is the sum of H_n over n clusters.
+	//txQ is Hermitian: only its upper triangle is accumulated, by blocks of COV_BLOCK x COV_BLOCK
+	//elements whose rows of coefficients stay in cache across the blocks of the receiver elements.
+	q.assign ((std::size_t) txSize*txSize, std::complex<double> (0,0));
+	for (uint16_t b1 = 0; b1 < txSize; b1 += COV_BLOCK)
 	{
-		for (uint8_t r2Index = 0; r2Index < rxSize; r2Index++)
+		uint16_t e1 = std::min<uint16_t> (b1 + COV_BLOCK, txSize);
+		for (uint16_t b2 = b1; b2 < txSize; b2 += COV_BLOCK)
 		{
-			for(uint8_t txIndex = 0; txIndex < txSize; txIndex++)
-            {
-				std::complex<double> cSum (0,0);
-				for (uint8_t cIndex = 0; cIndex < params->m_channel.at(r1Index).at(txIndex).size(); cIndex++)
+			uint16_t e2 = std::min<uint16_t> (b2 + COV_BLOCK, txSize);
+			for (uint16_t rxIndex = 0; rxIndex < rxSize; rxIndex++)
+			{
+				for (uint16_t t1Index = b1; t1Index < e1; t1Index++)
 				{
-					cSum = cSum + params->m_channel.at(r1Index).at(txIndex).at(cIndex)*
-							std::conj(params->m_channel.at(r2Index).at(txIndex).at(cIndex));
+					const std::complex<double> *h1 = params->m_channel.GetClusters(rxIndex, t1Index);
+					for (uint16_t t2Index = std::max (b2, t1Index); t2Index < e2; t2Index++)
+					{
+						q[(std::size_t) t1Index*txSize + t2Index] += ConjDot (h1, params->m_channel.GetClusters(rxIndex, t2Index), numCluster);
+					}
 				}
-				rxQ[r1Index][r2Index] += cSum;
-            }
-
+			}
 		}
 	}
-
-	//calculate beamforming vector from spatial correlation matrix.
-	antennaWeights.clear();
-	uint8_t rxAntenna = rxQ.size ();
-	for (uint8_t eIndex = 0; eIndex < rxAntenna; eIndex++)
-	{
-		antennaWeights.push_back(rxQ.at (0).at (eIndex));
-	}
-
-	iter = 10;
-	diff = 1;
-	while(iter != 0 && diff>1e-10)
+	for (uint16_t t1Index = 0; t1Index < txSize; t1Index++)
 	{
-		complexVector_t antennaWeights_New;
-
-		for(uint8_t row = 0; row<rxAntenna; row++)
+		for (uint16_t t2Index = 0; t2Index < t1Index; t2Index++)
 		{
-			std::complex<double> sum(0,0);
-			for (uint8_t col = 0; col< rxAntenna; col++)
-			{
-				sum += rxQ.at (row).at (col)*antennaWeights.at (col);
-			}
-
-		    antennaWeights_New.push_back(sum);
+			q[(std::size_t) t1Index*txSize + t2Index] = std::conj (q[(std::size_t) t2Index*txSize + t1Index]);
 		}
+	}
 
-		//normalize antennaWeights;
-		double weightSum = 0;
-		for (uint8_t i = 0; i< rxAntenna; i++)
-		{
-			weightSum += norm(antennaWeights_New. at(i));
-		}
-		for (uint8_t i = 0; i< rxAntenna; i++)
-		{
-			antennaWeights_New. at(i) = antennaWeights_New. at(i)/sqrt(weightSum);
-		}
-		diff = 0;
-		for (uint8_t i = 0; i< rxAntenna; i++)
+	//calculate beamforming vector from spatial correlation matrix.
+	PowerIteration (q, txSize, params->m_txW, scratch);
+
+	//compute the receiver side spatial correlation matrix rxQ = HH*, where H is the sum of H_n over n clusters.
+	//The coefficients of a receiver element are contiguous, so each entry of the upper triangle is a single dot product.
+	uint32_t rowSize = (uint32_t) txSize*numCluster;
+	q.assign ((std::size_t) rxSize*rxSize, std::complex<double> (0,0));
+	for (uint16_t r1Index = 0; r1Index < rxSize; r1Index++)
+	{
+		const std::complex<double> *h1 = params->m_channel.GetClusters(r1Index, 0);
+		for (uint16_t r2Index = r1Index; r2Index < rxSize; r2Index++)
 		{
-			diff += std::norm(antennaWeights_New. at(i)-antennaWeights. at(i));
+			std::complex<double> cSum = ConjDot (params->m_channel.GetClusters(r2Index, 0), h1, rowSize);
+			q[(std::size_t) r1Index*rxSize + r2Index] = cSum;
+			q[(std::size_t) r2Index*rxSize + r1Index] = std::conj (cSum);
 		}
-		iter--;
-		antennaWeights = antennaWeights_New;
 	}
 
-	params->m_rxW = antennaWeights;
+	//calculate beamforming vector from spatial correlation matrix.
+	PowerIteration (q, rxSize, params->m_rxW, scratch);
 }
 
 Ptr<SpectrumValue>
@@ -897,47 +876,48 @@ MmWave3gppChannel::CalBeamformingGain (Ptr<const SpectrumValue> txPsd, Ptr<Param
 
 	Ptr<SpectrumValue> tempPsd = Copy<SpectrumValue> (txPsd);
 
-	//NS_ASSERT_MSG (params->m_delay.size()==params->m_channel.at(0).at(0).size(), "the cluster number of channel and delay spread should be the same");
-	//NS_ASSERT_MSG (params->m_txW.size()==params->m_channel.at(0).size(), "the tx antenna size of channel and antenna weights should be the same");
-	//NS_ASSERT_MSG (params->m_rxW.size()==params->m_channel.size(), "the rx antenna size of channel and antenna weights should be the same");
-	//NS_ASSERT_MSG (params->m_angle.at(0).size()==params->m_channel.at(0).at(0).size(), "the cluster number of channel and AOA should be the same");
-	//NS_ASSERT_MSG (params->m_angle.at(1).size()==params->m_channel.at(0).at(0).size(), "the cluster number of channel and ZOA should be the same");
-
 	//channel[rx][tx][cluster]
 	uint8_t numCluster = params->m_delay.size();
-	//uint8_t txAntenna = params->m_txW.size();
-	//uint8_t rxAntenna = params->m_rxW.size();
+	NS_ASSERT_MSG (params->m_subbandRe.size() == numCluster, "the BF gain terms are not up to date, CalLongTerm must be called first");
 	//the update of Doppler is simplified by only taking the center angle of each cluster in to consideration.
-	Values::iterator vit = tempPsd->ValuesBegin ();
-	uint16_t iSubband = 0;
+	//The gain of each cluster at the first subband is the cached one rotated by the Doppler phase,
+	//and it is rotated by the cluster delay phase step from one subband to the next.
 	double slotTime = Simulator::Now ().GetSeconds ();
-	complexVector_t doppler;
+	params->m_gainRe.resize (numCluster);
+	params->m_gainIm.resize (numCluster);
+	double *gainRe = params->m_gainRe.data ();
+	double *gainIm = params->m_gainIm.data ();
+	const double *stepRe = params->m_stepRe.data ();
+	const double *stepIm = params->m_stepIm.data ();
 	for (uint8_t cIndex = 0; cIndex < numCluster; cIndex++)
 	{
-		//cluster angle angle[direction][n],where, direction = 0(aoa), 1(zoa).
-		double temp_doppler = 2*M_PI*(sin(params->m_angle.at(ZOA_INDEX).at(cIndex)*M_PI/180)*cos(params->m_angle.at(AOA_INDEX).at(cIndex)*M_PI/180)*speed.x
-				+ sin(params->m_angle.at(ZOA_INDEX).at(cIndex)*M_PI/180)*sin(params->m_angle.at(AOA_INDEX).at(cIndex)*M_PI/180)*speed.y
-				+ cos(params->m_angle.at(ZOA_INDEX).at(cIndex)*M_PI/180)*speed.z)*slotTime*m_phyMacConfig->GetCenterFrequency ()/3e8;
-		doppler.push_back(exp(std::complex<double> (0, temp_doppler)));
-
+		double doppler = (params->m_dopplerX[cIndex]*speed.x + params->m_dopplerY[cIndex]*speed.y
+				+ params->m_dopplerZ[cIndex]*speed.z)*slotTime;
+		double dopplerRe = cos (doppler);
+		double dopplerIm = sin (doppler);
+		gainRe[cIndex] = params->m_subbandRe[cIndex]*dopplerRe - params->m_subbandIm[cIndex]*dopplerIm;
+		gainIm[cIndex] = params->m_subbandRe[cIndex]*dopplerIm + params->m_subbandIm[cIndex]*dopplerRe;
 	}
 
-	while (vit != tempPsd->ValuesEnd ())
+	for (Values::iterator vit = tempPsd->ValuesBegin (); vit != tempPsd->ValuesEnd (); vit++)
 	{
-		std::complex<double> subsbandGain (0.0,0.0);
 		if ((*vit) != 0.00)
 		{
-			double fsb = m_phyMacConfig->GetCenterFrequency () - GetSystemBandwidth ()/2 + m_phyMacConfig->GetChunkWidth ()*iSubband ;
+			double subbandGainRe = 0;
+			double subbandGainIm = 0;
 			for (uint8_t cIndex = 0; cIndex < numCluster; cIndex++)
 			{
-				double delay = -2*M_PI*fsb*(params->m_delay.at (cIndex));
-				std::complex<double> txSum(0,0);
-				subsbandGain = subsbandGain + params->m_longTerm.at(cIndex)*doppler.at(cIndex)*exp(std::complex<double>(0, delay));
+				subbandGainRe += gainRe[cIndex];
+				subbandGainIm += gainIm[cIndex];
 			}
-			*vit = (*vit)*(norm (subsbandGain));
+			*vit = (*vit)*(subbandGainRe*subbandGainRe + subbandGainIm*subbandGainIm);
+		}
+		for (uint8_t cIndex = 0; cIndex < numCluster; cIndex++)
+		{
+			double re = gainRe[cIndex]*stepRe[cIndex] - gainIm[cIndex]*stepIm[cIndex];
+			gainIm[cIndex] = gainRe[cIndex]*stepIm[cIndex] + gainIm[cIndex]*stepRe[cIndex];
+			gainRe[cIndex] = re;
 		}
-		vit++;
-		iSubband++;
 	}
 	return tempPsd;
 }
@@ -969,33 +949,94 @@ MmWave3gppChannel::SetPathlossModel (Ptr<PropagationLossModel> pathloss)
 }
 
 
+ChannelTensor::ChannelTensor ()
+	: m_rxSize (0),
+	  m_txSize (0),
+	  m_numCluster (0)
+{
+}
+
+void
+ChannelTensor::Resize (uint16_t rxSize, uint16_t txSize, uint8_t numCluster)
+{
+	m_rxSize = rxSize;
+	m_txSize = txSize;
+	m_numCluster = numCluster;
+	m_coefficients.assign ((std::size_t) rxSize*txSize*numCluster, std::complex<double> (0,0));
+}
+
+void
+ChannelTensor::Clear ()
+{
+	m_rxSize = 0;
+	m_txSize = 0;
+	m_numCluster = 0;
+	complexVector_t ().swap (m_coefficients);
+}
+
+uint64_t
+ChannelTensor::GetMemoryUsage () const
+{
+	return sizeof (ChannelTensor) + m_coefficients.capacity ()*sizeof (std::complex<double>);
+}
+
 void
 MmWave3gppChannel::CalLongTerm (Ptr<Params3gpp> params) const
 {
-	uint8_t txAntenna = params->m_txW.size();
-	uint8_t rxAntenna = params->m_rxW.size();
+	uint16_t txAntenna = params->m_txW.size();
+	uint16_t rxAntenna = params->m_rxW.size();
+	NS_ASSERT_MSG (params->m_channel.GetTxSize() == txAntenna && params->m_channel.GetRxSize() == rxAntenna,
+			"the antenna sizes of the channel and of the antenna weights should be the same");
 
 	//store the long term part to reduce computation load
 	//only the small scale fading is need to be updated if the large scale parameters and antenna weights remain unchanged.
-	complexVector_t longTerm;
 	uint8_t numCluster = params->m_delay.size();
+	NS_ASSERT_MSG (params->m_channel.GetNumCluster() == numCluster, "the cluster number of channel and delay spread should be the same");
+	complexVector_t longTerm (numCluster);
 
-	for (uint8_t cIndex = 0; cIndex < numCluster; cIndex++)
+	//longTerm[n] = sum over u and s of conj(rxW[u])*txW[s]*H[u][s][n], accumulated over the contiguous clusters of each element pair
+	for(uint16_t rxIndex = 0; rxIndex < rxAntenna; rxIndex++)
 	{
-		std::complex<double> txSum(0,0);
-		for(uint8_t txIndex = 0; txIndex < txAntenna; txIndex++)
+		for (uint16_t txIndex = 0; txIndex < txAntenna; txIndex++)
 		{
-			std::complex<double> rxSum(0,0);
-			for (uint8_t rxIndex = 0; rxIndex < rxAntenna; rxIndex++)
+			std::complex<double> weight = std::conj(params->m_rxW.at(rxIndex))*params->m_txW.at(txIndex);
+			const std::complex<double> *h = params->m_channel.GetClusters(rxIndex, txIndex);
+			for (uint8_t cIndex = 0; cIndex < numCluster; cIndex++)
 			{
-				rxSum = rxSum + std::conj(params->m_rxW.at(rxIndex))*params->m_channel.at(rxIndex).at(txIndex).at(cIndex);
+				longTerm[cIndex] += weight*h[cIndex];
 			}
-			txSum = txSum + params->m_txW.at(txIndex)*rxSum;
 		}
-		longTerm.push_back(txSum);
 	}
 	params->m_longTerm = longTerm;
 
+	//store the terms of the BF gain that only change with the clusters and the long term part,
+	//so that CalBeamformingGain only has to rotate their phases
+	double fc = m_phyMacConfig->GetCenterFrequency ();
+	double firstSubband = fc - GetSystemBandwidth ()/2;
+	params->m_dopplerX.resize (numCluster);
+	params->m_dopplerY.resize (numCluster);
+	params->m_dopplerZ.resize (numCluster);
+	params->m_subbandRe.resize (numCluster);
+	params->m_subbandIm.resize (numCluster);
+	params->m_stepRe.resize (numCluster);
+	params->m_stepIm.resize (numCluster);
+	for (uint8_t cIndex = 0; cIndex < numCluster; cIndex++)
+	{
+		//cluster angle angle[direction][n],where, direction = 0(aoa), 1(zoa).
+		double zoa = params->m_angle.at(ZOA_INDEX).at(cIndex)*M_PI/180;
+		double aoa = params->m_angle.at(AOA_INDEX).at(cIndex)*M_PI/180;
+		params->m_dopplerX[cIndex] = 2*M_PI*sin(zoa)*cos(aoa)*fc/3e8;
+		params->m_dopplerY[cIndex] = 2*M_PI*sin(zoa)*sin(aoa)*fc/3e8;
+		params->m_dopplerZ[cIndex] = 2*M_PI*cos(zoa)*fc/3e8;
+
+		std::complex<double> subband = longTerm.at(cIndex)*exp(std::complex<double>(0, -2*M_PI*firstSubband*params->m_delay.at (cIndex)));
+		params->m_subbandRe[cIndex] = subband.real ();
+		params->m_subbandIm[cIndex] = subband.imag ();
+		double step = -2*M_PI*m_phyMacConfig->GetChunkWidth ()*params->m_delay.at (cIndex);
+		params->m_stepRe[cIndex] = cos (step);
+		params->m_stepIm[cIndex] = sin (step);
+	}
+
 }
 
 Ptr<ParamsTable>
@@ -1194,9 +1235,9 @@ MmWave3gppChannel::DeleteChannel(Ptr<const MobilityModel> a, Ptr<const MobilityM
 	NS_LOG_INFO("a position " << a->GetPosition() << " b " << b->GetPosition());
 	Ptr<Params3gpp> params = m_channelMap.find(std::make_pair(dev1,dev2))->second;
 	NS_LOG_INFO("params " << params);
-	NS_LOG_INFO("params m_channel size" << params->m_channel.size());
+	NS_LOG_INFO("params m_channel size" << params->m_channel.GetRxSize());
 	NS_ASSERT_MSG(m_channelMap.find(std::make_pair(dev1,dev2)) != m_channelMap.end(), "Channel not found");
-	params->m_channel.clear();
+	params->m_channel.Clear ();
 	m_channelMap[std::make_pair(dev1,dev2)] = params;
 }
 
@@ -1768,18 +1809,10 @@ MmWave3gppChannel::GetNewChannel(Ptr<ParamsTable>  table3gpp, Vector locUT, bool
 
 	NS_LOG_INFO ("1st strongest cluster:"<<(int)cluster1st<<", 2nd strongest cluster:"<<(int)cluster2nd);
 
-	complex3DVector_t H_usn; //channel coffecient H_usn[u][s][n];
-	//Since each of the strongest 2 clusters are divided into 3 sub-clusters, the total cluster will be numReducedCLuster + 4.
-
-	H_usn.resize(uSize);
-	for (uint16_t uIndex = 0; uIndex < uSize; uIndex++)
-	{
-		H_usn.at(uIndex).resize(sSize);
-		for (uint16_t sIndex = 0; sIndex < sSize; sIndex++)
-		{
-			H_usn.at(uIndex).at(sIndex).resize(numReducedCluster);
-		}
-	}
+	ChannelTensor H_usn; //channel coffecient H_usn[u][s][n];
+	//Since each of the strongest 2 clusters are divided into 3 sub-clusters, the total cluster will be numReducedCLuster + 4,
+	//the sub-clusters being stored after the reduced clusters.
+	H_usn.Resize (uSize, sSize, numReducedCluster + (cluster1st == cluster2nd ? 2 : 4));
 	//double slotTime = Simulator::Now ().GetSeconds ();
 	// The following for loops computes the channel coefficients
 	for (uint16_t uIndex = 0; uIndex < uSize; uIndex++)
@@ -1791,6 +1824,7 @@ MmWave3gppChannel::GetNewChannel(Ptr<ParamsTable>  table3gpp, Vector locUT, bool
 
 			Vector sLoc = txAntenna->GetAntennaLocation(sIndex,txAntennaNum);
 
+			uint8_t subClusterIndex = numReducedCluster;
 			for (uint8_t nIndex = 0; nIndex < numReducedCluster; nIndex++)
 			{
 				//Compute the N-2 weakest cluster, only vertical polarization. (7.5-22)
@@ -1821,7 +1855,7 @@ MmWave3gppChannel::GetNewChannel(Ptr<ParamsTable>  table3gpp, Vector locUT, bool
 					}
 					//rays *= sqrt(clusterPower.at(nIndex))/raysPerCluster;
 					rays *= sqrt(clusterPower.at(nIndex)/raysPerCluster);
-					H_usn.at(uIndex).at(sIndex).at(nIndex) = rays;
+					H_usn (uIndex, sIndex, nIndex) = rays;
 				}
 				else //(7.5-28)
 				{
@@ -1890,9 +1924,9 @@ MmWave3gppChannel::GetNewChannel(Ptr<ParamsTable>  table3gpp, Vector locUT, bool
 					raysSub1 *= sqrt(clusterPower.at(nIndex)/raysPerCluster);
 					raysSub2 *= sqrt(clusterPower.at(nIndex)/raysPerCluster);
 					raysSub3 *= sqrt(clusterPower.at(nIndex)/raysPerCluster);
-					H_usn.at(uIndex).at(sIndex).at(nIndex) = raysSub1;
-					H_usn.at(uIndex).at(sIndex).push_back(raysSub2);
-					H_usn.at(uIndex).at(sIndex).push_back(raysSub3);
+					H_usn (uIndex, sIndex, nIndex) = raysSub1;
+					H_usn (uIndex, sIndex, subClusterIndex++) = raysSub2;
+					H_usn (uIndex, sIndex, subClusterIndex++) = raysSub3;
 
 				}
 			}
@@ -1917,11 +1951,11 @@ MmWave3gppChannel::GetNewChannel(Ptr<ParamsTable>  table3gpp, Vector locUT, bool
 
 				double K_linear = pow(10,K_factor/10);
 				// the LOS path should be attenuated if blockage is enabled.
-				H_usn.at(uIndex).at(sIndex).at(0) = sqrt(1/(K_linear+1))*H_usn.at(uIndex).at(sIndex).at(0)+sqrt(K_linear/(1+K_linear))*ray/pow(10,attenuation_dB.at (0)/10);  //(7.5-30) for tau = tau1
-				double tempSize = H_usn.at(uIndex).at(sIndex).size();
+				H_usn (uIndex, sIndex, 0) = sqrt(1/(K_linear+1))*H_usn (uIndex, sIndex, 0)+sqrt(K_linear/(1+K_linear))*ray/pow(10,attenuation_dB.at (0)/10);  //(7.5-30) for tau = tau1
+				double tempSize = H_usn.GetNumCluster ();
 				for(uint8_t nIndex = 1; nIndex < tempSize; nIndex++)
 				{
-					H_usn.at(uIndex).at(sIndex).at(nIndex) *= sqrt(1/(K_linear+1)); //(7.5-30) for tau = tau2...taunN
+					H_usn (uIndex, sIndex, nIndex) *= sqrt(1/(K_linear+1)); //(7.5-30) for tau = tau2...taunN
 				}
 
 			}
@@ -1986,7 +2020,7 @@ MmWave3gppChannel::GetNewChannel(Ptr<ParamsTable>  table3gpp, Vector locUT, bool
 
 	}
 
-	NS_LOG_INFO ("size of coefficient matrix =["<<H_usn.size() << "][" << H_usn.at(0).size() << "][" << H_usn.at (0).at(0).size()<<"]");
+	NS_LOG_INFO ("size of coefficient matrix =["<<H_usn.GetRxSize() << "][" << H_usn.GetTxSize() << "][" << (uint16_t) H_usn.GetNumCluster()<<"]");
 
 
 	/*std::cout << "Delay:";
@@ -2412,18 +2446,10 @@ MmWave3gppChannel::UpdateChannel(Ptr<Params3gpp> params3gpp, Ptr<ParamsTable>  t
 
 	NS_LOG_INFO ("1st strongest cluster:"<<(int)cluster1st<<", 2nd strongest cluster:"<<(int)cluster2nd);
 
-	complex3DVector_t H_usn; //channel coffecient H_usn[u][s][n];
-	//Since each of the strongest 2 clusters are divided into 3 sub-clusters, the total cluster will be numReducedCLuster + 4.
-
-	H_usn.resize(uSize);
-	for (uint16_t uIndex = 0; uIndex < uSize; uIndex++)
-	{
-		H_usn.at(uIndex).resize(sSize);
-		for (uint16_t sIndex = 0; sIndex < sSize; sIndex++)
-		{
-			H_usn.at(uIndex).at(sIndex).resize(params->m_numCluster);
-		}
-	}
+	ChannelTensor H_usn; //channel coffecient H_usn[u][s][n];
+	//Since each of the strongest 2 clusters are divided into 3 sub-clusters, the total cluster will be numReducedCLuster + 4,
+	//the sub-clusters being stored after the reduced clusters.
+	H_usn.Resize (uSize, sSize, params->m_numCluster + (cluster1st == cluster2nd ? 2 : 4));
 	//double slotTime = Simulator::Now ().GetSeconds ();
 	// The following for loops computes the channel coefficients
 	for (uint16_t uIndex = 0; uIndex < uSize; uIndex++)
@@ -2435,6 +2461,7 @@ MmWave3gppChannel::UpdateChannel(Ptr<Params3gpp> params3gpp, Ptr<ParamsTable>  t
 
 			Vector sLoc = txAntenna->GetAntennaLocation(sIndex,txAntennaNum);
 
+			uint8_t subClusterIndex = params->m_numCluster;
 			for (uint8_t nIndex = 0; nIndex < params->m_numCluster; nIndex++)
 			{
 				//Compute the N-2 weakest cluster, only vertical polarization. (7.5-22)
@@ -2465,7 +2492,7 @@ MmWave3gppChannel::UpdateChannel(Ptr<Params3gpp> params3gpp, Ptr<ParamsTable>  t
 					}
 					//rays *= sqrt(clusterPower.at(nIndex))/raysPerCluster;
 					rays *= sqrt(clusterPower.at(nIndex)/raysPerCluster);
-					H_usn.at(uIndex).at(sIndex).at(nIndex) = rays;
+					H_usn (uIndex, sIndex, nIndex) = rays;
 				}
 				else //(7.5-28)
 				{
@@ -2531,9 +2558,9 @@ MmWave3gppChannel::UpdateChannel(Ptr<Params3gpp> params3gpp, Ptr<ParamsTable>  t
 					raysSub1 *= sqrt(clusterPower.at(nIndex)/raysPerCluster);
 					raysSub2 *= sqrt(clusterPower.at(nIndex)/raysPerCluster);
 					raysSub3 *= sqrt(clusterPower.at(nIndex)/raysPerCluster);
-					H_usn.at(uIndex).at(sIndex).at(nIndex) = raysSub1;
-					H_usn.at(uIndex).at(sIndex).push_back(raysSub2);
-					H_usn.at(uIndex).at(sIndex).push_back(raysSub3);
+					H_usn (uIndex, sIndex, nIndex) = raysSub1;
+					H_usn (uIndex, sIndex, subClusterIndex++) = raysSub2;
+					H_usn (uIndex, sIndex, subClusterIndex++) = raysSub3;
 
 				}
 			}
@@ -2558,11 +2585,11 @@ MmWave3gppChannel::UpdateChannel(Ptr<Params3gpp> params3gpp, Ptr<ParamsTable>  t
 
 				double K_linear = pow(10,K_factor/10);
 
-				H_usn.at(uIndex).at(sIndex).at(0) = sqrt(1/(K_linear+1))*H_usn.at(uIndex).at(sIndex).at(0)+sqrt(K_linear/(1+K_linear))*ray/pow(10,attenuation_dB.at (0)/10);  //(7.5-30) for tau = tau1
-				double tempSize = H_usn.at(uIndex).at(sIndex).size();
+				H_usn (uIndex, sIndex, 0) = sqrt(1/(K_linear+1))*H_usn (uIndex, sIndex, 0)+sqrt(K_linear/(1+K_linear))*ray/pow(10,attenuation_dB.at (0)/10);  //(7.5-30) for tau = tau1
+				double tempSize = H_usn.GetNumCluster ();
 				for(uint8_t nIndex = 1; nIndex < tempSize; nIndex++)
 				{
-					H_usn.at(uIndex).at(sIndex).at(nIndex) *= sqrt(1/(K_linear+1)); //(7.5-30) for tau = tau2...taunN
+					H_usn (uIndex, sIndex, nIndex) *= sqrt(1/(K_linear+1)); //(7.5-30) for tau = tau2...taunN
 				}
 
 			}
@@ -2610,7 +2637,7 @@ MmWave3gppChannel::UpdateChannel(Ptr<Params3gpp> params3gpp, Ptr<ParamsTable>  t
 
 	}
 
-	NS_LOG_INFO ("size of coefficient matrix =["<<H_usn.size() << "][" << H_usn.at(0).size() << "][" << H_usn.at (0).at(0).size()<<"]");
+	NS_LOG_INFO ("size of coefficient matrix =["<<H_usn.GetRxSize() << "][" << H_usn.GetTxSize() << "][" << (uint16_t) H_usn.GetNumCluster()<<"]");
 
 
 	/*std::cout << "Delay:";
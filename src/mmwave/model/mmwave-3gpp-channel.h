@@ -35,6 +35,7 @@
 #include <ns3/net-device.h>
 #include <map>
 #include <ns3/angles.h>
+#include <ns3/assert.h>
 #include <ns3/net-device-container.h>
 #include <ns3/random-variable-stream.h>
 #include "ns3/mmwave-phy-mac-common.h"
@@ -66,6 +67,105 @@ typedef std::vector<complex2DVector_t> complex3DVector_t;
 
 typedef std::pair<Ptr<NetDevice>, Ptr<NetDevice> > key_t;
 
+/**
+ * Channel coefficients H[u][s][n] of the receive antenna element u, the transmit
+ * antenna element s and the cluster n, stored in a single block with n running
+ * fastest, so that the clusters of an element pair are contiguous
+ */
+class ChannelTensor
+{
+public:
+	ChannelTensor ();
+
+	/**
+	 * Set the sizes of the tensor, with all the coefficients set to 0
+	 * @params the number of receive antenna elements
+	 * @params the number of transmit antenna elements
+	 * @params the number of clusters
+	 */
+	void Resize (uint16_t rxSize, uint16_t txSize, uint8_t numCluster);
+
+	/**
+	 * Remove all the coefficients
+	 */
+	void Clear ();
+
+	/**
+	 * @returns true if there are no coefficients
+	 */
+	bool IsEmpty () const;
+
+	uint16_t GetRxSize () const;
+	uint16_t GetTxSize () const;
+	uint8_t GetNumCluster () const;
+
+	std::complex<double>& operator() (uint16_t u, uint16_t s, uint8_t n);
+	const std::complex<double>& operator() (uint16_t u, uint16_t s, uint8_t n) const;
+
+	/**
+	 * @params the receive antenna element
+	 * @params the transmit antenna element
+	 * @returns the coefficients of the GetNumCluster () clusters of the element pair
+	 */
+	const std::complex<double>* GetClusters (uint16_t u, uint16_t s) const;
+
+	/**
+	 * @returns the memory used by the coefficients, in bytes
+	 */
+	uint64_t GetMemoryUsage () const;
+
+private:
+	uint16_t m_rxSize;
+	uint16_t m_txSize;
+	uint8_t m_numCluster;
+	complexVector_t m_coefficients;
+};
+
+inline bool
+ChannelTensor::IsEmpty () const
+{
+	return m_coefficients.empty ();
+}
+
+inline uint16_t
+ChannelTensor::GetRxSize () const
+{
+	return m_rxSize;
+}
+
+inline uint16_t
+ChannelTensor::GetTxSize () const
+{
+	return m_txSize;
+}
+
+inline uint8_t
+ChannelTensor::GetNumCluster () const
+{
+	return m_numCluster;
+}
+
+inline std::complex<double>&
+ChannelTensor::operator() (uint16_t u, uint16_t s, uint8_t n)
+{
+	NS_ASSERT (u < m_rxSize && s < m_txSize && n < m_numCluster);
+	return m_coefficients[((std::size_t) u*m_txSize + s)*m_numCluster + n];
+}
+
+inline const std::complex<double>&
+ChannelTensor::operator() (uint16_t u, uint16_t s, uint8_t n) const
+{
+	NS_ASSERT (u < m_rxSize && s < m_txSize && n < m_numCluster);
+	return m_coefficients[((std::size_t) u*m_txSize + s)*m_numCluster + n];
+}
+
+inline const std::complex<double>*
+ChannelTensor::GetClusters (uint16_t u, uint16_t s) const
+{
+	NS_ASSERT (u < m_rxSize && s < m_txSize);
+	return &m_coefficients[((std::size_t) u*m_txSize + s)*m_numCluster];
+}
+
 /**
  * Data structure that stores a channel realization
  */
@@ -73,11 +173,25 @@ struct Params3gpp : public SimpleRefCount<Params3gpp>
 {
 	complexVector_t 		m_txW; // tx antenna weights.
 	complexVector_t 		m_rxW; // rx antenna weights.
-	complex3DVector_t  		m_channel; // channel matrix H[u][s][n].
+	ChannelTensor  		m_channel; // channel matrix H[u][s][n].
 	doubleVector_t  		m_delay; // cluster delay.
 	double2DVector_t		m_angle; //cluster angle angle[direction][n], where direction = 0(aoa), 1(zoa), 2(aod), 3(zod) in degree.
 	complexVector_t 		m_longTerm; // long term conponet.
 
+	/*The following terms are cached by CalLongTerm for the BF gain computation, one entry per cluster*/
+	doubleVector_t m_dopplerX; // Doppler phase per unit of speed along x and of time, for the center angle of the cluster
+	doubleVector_t m_dopplerY;
+	doubleVector_t m_dopplerZ;
+	doubleVector_t m_subbandRe; // long term component phase-shifted by the cluster delay at the first subband
+	doubleVector_t m_subbandIm;
+	doubleVector_t m_stepRe; // phase shift by the cluster delay from one subband to the next
+	doubleVector_t m_stepIm;
+	doubleVector_t m_gainRe; // scratch space of CalBeamformingGain
+	doubleVector_t m_gainIm;
+
+	complexVector_t m_bfCov; // scratch space of LongTermCovMatrixBeamforming
+	complexVector_t m_bfScratch;
+
 	double2DVector_t		m_nonSelfBlocking; // store the blockages
 
 	/*The following parameters are stored for spatial consistent updating*/
@@ -218,6 +332,32 @@ public:
 	 * @param a pointer to the pathloss model, which has to implement the PropagationLossModel interface
 	 */
 	void SetPathlossModel (Ptr<PropagationLossModel> pathloss);
+
+	/**
+	 * Compute and store the long term fading params in order to decrease the computational load,
+	 * and the per-cluster terms of the BF gain
+	 * @params the channel realizationin as a Params3gpp object
+	 */
+	void CalLongTerm (Ptr<Params3gpp> params) const;
+
+	/**
+	 * Compute the BF gain, apply frequency selectivity by phase-shifting with the cluster delays
+	 * and scale the txPsd to get the rxPsd. CalLongTerm must have been called since the last change
+	 * of the clusters or of the antenna weights of params
+	 * @params the tx PSD
+	 * @params the channel realizationin as a Params3gpp object
+	 * @params the relative speed between UE and eNB
+	 * @returns the rx PSD
+	 */
+	Ptr<SpectrumValue> CalBeamformingGain (Ptr<const SpectrumValue> txPsd,
+												Ptr<Params3gpp> params, Vector speed) const;
+
+	/**
+	 * Compute the optimal BF vector with the Power Method (Maximum Ratio Transmission method).
+	 * The vector is stored in the Params3gpp object passed as parameter
+	 * @params the channel realizationin as a Params3gpp object
+	 */
+	void LongTermCovMatrixBeamforming (Ptr<Params3gpp> params) const;
 	 bool isAdditionalMmWavePhy=false;//sjkang
 private:
 
@@ -270,13 +410,6 @@ private:
 	Ptr<Params3gpp> UpdateChannel(Ptr<Params3gpp> params3gpp, Ptr<ParamsTable> table3gpp,
 			Ptr<AntennaArrayModel> txAntenna, Ptr<AntennaArrayModel> rxAntenna,
 			uint8_t *txAntennaNum, uint8_t *rxAntennaNum, Angles &rxAngle, Angles &txAngle) const;
-
-	/**
-	 * Compute the optimal BF vector with the Power Method (Maximum Ratio Transmission method).
-	 * The vector is stored in the Params3gpp object passed as parameter
-	 * @params the channel realizationin as a Params3gpp object
-	 */
-	void LongTermCovMatrixBeamforming (Ptr<Params3gpp> params) const;
 	
 	/**
 	 * Scan all sectors with predefined code book and select the one returns maximum gain.
@@ -287,23 +420,6 @@ private:
 			Ptr<AntennaArrayModel> rxAntenna, uint8_t *txAntennaNum, uint8_t *rxAntennaNum) const;
 
 
-	/**
-	 * Compute and store the long term fading params in order to decrease the computational load
-	 * @params the channel realizationin as a Params3gpp object
-	 */
-	void CalLongTerm (Ptr<Params3gpp> params) const;
-
-	/**
-	 * Compute the BF gain, apply frequency selectivity by phase-shifting with the cluster delays
-	 * and scale the txPsd to get the rxPsd
-	 * @params the tx PSD
-	 * @params the channel realizationin as a Params3gpp object
-	 * @params the relative speed between UE and eNB
-	 * @returns the rx PSD
-	 */
-	Ptr<SpectrumValue> CalBeamformingGain (Ptr<const SpectrumValue> txPsd,
-												Ptr<Params3gpp> params, Vector speed) const;
-	
 	/**
 	 * Returns the bandwidth used in a scenario
 	 * @returns a double with the bandwidth
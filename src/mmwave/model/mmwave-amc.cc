@@ -481,10 +481,17 @@ MmWaveAmc::CreateCqiFeedbackWbTdma (const SpectrumValue& sinr, uint8_t numSym, u
 
 		mcs = 0;
 		MmWaveTbStats_t tbStats;
+		MmWaveHarqProcessInfoList_t harqInfoList;
+		double mib = 0;
 		while (mcs <= 28)
 		{
-			MmWaveHarqProcessInfoList_t harqInfoList;
-			tbStats = MmWaveMiErrorModel::GetTbDecodificationStats (sinr, chunkMap, tbSize, mcs, harqInfoList);
+			if (mcs == 0 || mcs == MMWAVE_MI_QPSK_MAX_ID + 1 || mcs == MMWAVE_MI_16QAM_MAX_ID + 1)
+			{
+				// the mmib depends on the modulation only: average it over the
+				// chunks once for the MCSs of each modulation
+				mib = MmWaveMiErrorModel::Mib (sinr, chunkMap, mcs);
+			}
+			tbStats = MmWaveMiErrorModel::GetTbDecodificationStats (mib, tbSize, mcs, harqInfoList);
 			if (tbStats.tbler > 0.1)
 			{
 				break;
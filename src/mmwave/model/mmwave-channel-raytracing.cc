@@ -41,8 +41,9 @@
 #include <ns3/mmwave-ue-phy.h>
 #include <ns3/mmwave-enb-phy.h>
 #include <ns3/double.h>
+#include <ns3/string.h>
 #include <algorithm>
-#include <fstream>
+#include <limits>
 
 
 namespace ns3{
@@ -52,22 +53,11 @@ NS_LOG_COMPONENT_DEFINE ("MmWaveChannelRaytracing");
 NS_OBJECT_ENSURE_REGISTERED (MmWaveChannelRaytracing);
 
 
-doubleVector_t g_path; //number of multipath
-double2DVector_t g_delay; //delay spread in ns
-double2DVector_t g_pathloss;	//pathloss in DB
-double2DVector_t g_phase;	//???what is this
-double2DVector_t g_aodElevation;	//degree
-double2DVector_t g_aodAzimuth;	//degree
-double2DVector_t g_aoaElevation;	//degree
-double2DVector_t g_aoaAzimuth;	//degree
-
-
 MmWaveChannelRaytracing::MmWaveChannelRaytracing ()
-	:m_antennaSeparation(0.5)
+	:m_antennaSeparation(0.5),
+	 m_currentIndex (std::numeric_limits<uint32_t>::max ())
 {
 	m_uniformRv = CreateObject<UniformRandomVariable> ();
-	LoadTraces();
-
 }
 
 TypeId
@@ -85,6 +75,11 @@ MmWaveChannelRaytracing::GetTypeId (void)
 			   DoubleValue (1.0),
 			   MakeDoubleAccessor (&MmWaveChannelRaytracing::m_speed),
 			   MakeDoubleChecker<double> ())
+	.AddAttribute ("TraceFile",
+			   "The raytracing traces, in the text format or in the binary format of MmWaveRaytracingTraces",
+			   StringValue ("src/mmwave/model/Raytracing/traces10cm.txt"),
+			   MakeStringAccessor (&MmWaveChannelRaytracing::m_traceFile),
+			   MakeStringChecker ())
 	;
 	return tid;
 }
@@ -98,6 +93,7 @@ void
 MmWaveChannelRaytracing::DoDispose ()
 {
 	NS_LOG_FUNCTION (this);
+	m_traces = 0;
 }
 
 void
@@ -115,76 +111,18 @@ MmWaveChannelRaytracing::GetConfigurationParameters (void) const
 void
 MmWaveChannelRaytracing::LoadTraces()
 {
-	std::string filename = "src/mmwave/model/Raytracing/traces10cm.txt";
-	NS_LOG_FUNCTION (this << "Loading Raytracing file " << filename);
-	std::ifstream singlefile;
-	singlefile.open (filename.c_str (), std::ifstream::in);
-
-	NS_LOG_INFO (this << " File: " << filename);
-	NS_ASSERT_MSG(singlefile.good (), " Raytracing file not found");
-    std::string line;
-    std::string token;
-    uint16_t counter = 0;
-    while( std::getline(singlefile, line) ) //Parse each line of the file
-    {
-    	if(counter == 8)
-    	{
-    		counter = 0;
-    	}
-    	doubleVector_t path;
-        std::istringstream stream(line);
-        while( getline(stream,token,',') ) //Parse each comma separated string in a line
-        {
-            double sigma = 0.00;
-            std::stringstream stream( token );
-            stream>>sigma;
-        	path.push_back(sigma);
-		}
+	GetTraces ();
+}
 
-		switch (counter)
-		{
-		case 0:
-			g_path.push_back (path.at (0));
-			break;
-		case 1:
-			g_delay.push_back (path);
-			break;
-		case 2:
-			g_pathloss.push_back (path);
-			break;
-		case 3:
-			g_phase.push_back (path);
-			break;
-		case 4:
-			g_aodElevation.push_back (path);
-			break;
-		case 5:
-			g_aodAzimuth.push_back (path);
-			break;
-		case 6:
-			g_aoaElevation.push_back (path);
-			break;
-		case 7:
-			g_aoaAzimuth.push_back (path);
-			break;
-		default:
-			NS_FATAL_ERROR("Never call this");
-			break;
-		}
-		counter++;
+Ptr<MmWaveRaytracingTraces>
+MmWaveChannelRaytracing::GetTraces () const
+{
+	if (m_traces == 0)
+	{
+		NS_LOG_FUNCTION (this << "Loading Raytracing file " << m_traceFile);
+		m_traces = MmWaveRaytracingTraces::Load (m_traceFile);
 	}
-
-	/*NS_LOG_UNCOND(g_path.size());
-	NS_LOG_UNCOND(g_delay.size());
-	NS_LOG_UNCOND(g_pathloss.size());
-	NS_LOG_UNCOND(g_phase.size());
-	NS_LOG_UNCOND(g_aodElevation.size());
-	NS_LOG_UNCOND(g_aodAzimuth.size());
-	NS_LOG_UNCOND(g_aoaElevation.size());
-	NS_LOG_UNCOND(g_aoaAzimuth.size());*/
-
-
-
+	return m_traces;
 }
 
 
@@ -345,16 +283,16 @@ MmWaveChannelRaytracing::DoCalcRxPowerSpectralDensity (Ptr<const SpectrumValue>
 	Ptr<mmWaveBeamFormingTraces> bfParams = Create<mmWaveBeamFormingTraces> ();
 	key_t key = std::make_pair(txDevice,rxDevice);
 
+	Ptr<MmWaveRaytracingTraces> traces = GetTraces ();
 	double time = Simulator::Now().GetSeconds();
-	uint16_t traceIndex = (m_startDistance+time*m_speed)*100;
-	static uint16_t currentIndex = m_startDistance*100;
-	if(traceIndex > 26050)
+	uint32_t traceIndex = (m_startDistance+time*m_speed)*100;
+	if(traceIndex >= traces->GetNumPositions ())
 	{
-		NS_FATAL_ERROR ("The maximum trace index is 26050");
+		NS_FATAL_ERROR ("The maximum trace index is " << traces->GetNumPositions () - 1);
 	}
-	if(traceIndex != currentIndex)
+	if(traceIndex != m_currentIndex)
 	{
-		currentIndex = traceIndex;
+		m_currentIndex = traceIndex;
 		m_channelMatrixMap.clear();
 	}
 
@@ -374,18 +312,21 @@ MmWaveChannelRaytracing::DoCalcRxPowerSpectralDensity (Ptr<const SpectrumValue>
 			txSpatialMatrix = GenSpatialMatrix (traceIndex,txAntennaNum, false);
 			rxSpatialMatrix = GenSpatialMatrix (traceIndex,rxAntennaNum, true);
 		}
+		uint32_t pathNum = traces->GetNumPaths (traceIndex);
 		doubleVector_t dopplerShift;
-		for (unsigned int i = 0; i < g_path.at(traceIndex); i++)
+		for (unsigned int i = 0; i < pathNum; i++)
 		{
 			dopplerShift.push_back(m_uniformRv->GetValue (0,1));
 		}
+		const double* pathloss = traces->GetPaths (traceIndex, MmWaveRaytracingTraces::PATHLOSS);
+		const double* delay = traces->GetPaths (traceIndex, MmWaveRaytracingTraces::DELAY);
 
 		Ptr<TraceParams> channel = Create<TraceParams> ();
 
 		channel->m_txSpatialMatrix = txSpatialMatrix;
 		channel->m_rxSpatialMatrix = rxSpatialMatrix;
-		channel->m_powerFraction = g_pathloss.at (traceIndex);
-		channel->m_delaySpread = g_delay.at (traceIndex);
+		channel->m_powerFraction.assign (pathloss, pathloss + pathNum);
+		channel->m_delaySpread.assign (delay, delay + pathNum);
 		channel->m_doppler = dopplerShift;
 
 
@@ -395,8 +336,8 @@ MmWaveChannelRaytracing::DoCalcRxPowerSpectralDensity (Ptr<const SpectrumValue>
 		Ptr<TraceParams> reverseChannel = Create<TraceParams> ();
 		reverseChannel->m_txSpatialMatrix = rxSpatialMatrix;
 		reverseChannel->m_rxSpatialMatrix = txSpatialMatrix;
-		reverseChannel->m_powerFraction = g_pathloss.at (traceIndex);;
-		reverseChannel->m_delaySpread = g_delay.at (traceIndex);
+		reverseChannel->m_powerFraction = channel->m_powerFraction;
+		reverseChannel->m_delaySpread = channel->m_delaySpread;
 		reverseChannel->m_doppler = dopplerShift;
 
 		m_channelMatrixMap.insert(std::make_pair(reverseKey,reverseChannel));
@@ -510,21 +451,13 @@ complex2DVector_t
 MmWaveChannelRaytracing::GenSpatialMatrix (uint64_t traceIndex, uint8_t* antennaNum, bool bs) const
 {
 	complex2DVector_t spatialMatrix;
-	uint16_t pathNum = g_path.at (traceIndex);
+	uint32_t pathNum = m_traces->GetNumPaths (traceIndex);
+	const double* azimuth = m_traces->GetPaths (traceIndex, bs ? MmWaveRaytracingTraces::AOD_AZIMUTH : MmWaveRaytracingTraces::AOA_AZIMUTH);
+	const double* elevation = m_traces->GetPaths (traceIndex, bs ? MmWaveRaytracingTraces::AOD_ELEVATION : MmWaveRaytracingTraces::AOA_ELEVATION);
 	for(unsigned int pathIndex = 0; pathIndex < pathNum; pathIndex++)
 	{
-		double azimuthAngle;
-		double verticalAngle;
-		if(bs)
-		{
-			azimuthAngle = g_aodAzimuth.at (traceIndex).at (pathIndex);
-			verticalAngle = g_aodElevation.at (traceIndex).at (pathIndex);
-		}
-		else
-		{
-			azimuthAngle = g_aoaAzimuth.at (traceIndex).at (pathIndex);
-			verticalAngle = g_aoaElevation.at (traceIndex).at (pathIndex);
-		}
+		double azimuthAngle = azimuth[pathIndex];
+		double verticalAngle = elevation[pathIndex];
 		complexVector_t singlePath;
 		singlePath = GenSinglePath (azimuthAngle*M_PI/180, verticalAngle*M_PI/180, antennaNum);
 		spatialMatrix.push_back(singlePath);
@@ -42,6 +42,7 @@
 #include <ns3/net-device-container.h>
 #include <ns3/random-variable-stream.h>
 #include "mmwave-phy-mac-common.h"
+#include "mmwave-raytracing-traces.h"
 
 
 
@@ -84,6 +85,10 @@ public:
 
 	static TypeId GetTypeId (void);
 	void DoDispose ();
+	/**
+	 * Load the traces of the TraceFile attribute, if not done yet: they
+	 * are loaded at the first channel computation otherwise
+	 */
 	void LoadTraces();
 	void ConnectDevices (Ptr<NetDevice> dev1, Ptr<NetDevice> dev2);
 	void Initial(NetDeviceContainer ueDevices, NetDeviceContainer enbDevices);
@@ -102,6 +107,7 @@ private:
 														Ptr<const MobilityModel> a,
 														Ptr<const MobilityModel> b) const;
 
+	Ptr<MmWaveRaytracingTraces> GetTraces () const;
 	complex2DVector_t GenSpatialMatrix (uint64_t traceIndex, uint8_t* antennaNum, bool bs) const;
 	complexVector_t GenSinglePath (double hAngle, double vAngle, uint8_t* antennaNum) const;
 	complexVector_t CalcBeamformingVector (complex2DVector_t SpatialMatrix, doubleVector_t powerFraction) const;
@@ -115,6 +121,9 @@ private:
 	Ptr<MmWavePhyMacCommon> m_phyMacConfig;
 	uint16_t m_startDistance;
 	double m_speed;
+	std::string m_traceFile;
+	mutable Ptr<MmWaveRaytracingTraces> m_traces;
+	mutable uint32_t m_currentIndex; // trace index of the channels in m_channelMatrixMap
 };
 
 
@@ -88,6 +88,8 @@ MmWaveEnbPhy::MmWaveEnbPhy (Ptr<MmWaveSpectrumPhy> dlPhy, Ptr<MmWaveSpectrumPhy>
 {
 	m_enbCphySapProvider = new MemberLteEnbCphySapProvider<MmWaveEnbPhy> (this);
 	m_roundFromLastUeSinrUpdate = 0;
+	m_nextPathlossMonitor = Seconds (0);
+	m_rxPsdMapTime = Seconds (0);
 	isAddtionalMmWavPhy=false;
 	Simulator::ScheduleNow (&MmWaveEnbPhy::StartSubFrame, this);
 }
@@ -119,6 +121,12 @@ MmWaveEnbPhy::GetTypeId (void)
 	               IntegerValue (1600), //TODO considering refactoring in MmWavePhyMacCommon
 	               MakeIntegerAccessor (&MmWaveEnbPhy::m_updateSinrPeriod),
 	               MakeIntegerChecker<int> ())
+	.AddAttribute ("PathlossMonitorPeriod",
+	               "Period of the computation of the real SINR of all the UEs, which is only logged. "
+	               "Zero disables it: the path loss is then computed only to update the SINR estimate",
+	               TimeValue (Seconds (0)),
+	               MakeTimeAccessor (&MmWaveEnbPhy::m_pathlossMonitorPeriod),
+	               MakeTimeChecker ())
 	.AddAttribute ("UpdateUeSinrEstimatePeriod",
 	               "Period (in ms) of reporting of SINR estimate of all the UE",
 	               DoubleValue (25.6),
@@ -580,177 +588,206 @@ MmWaveEnbPhy::GetUlSpectrumPhy () const
 void
 MmWaveEnbPhy::CallPathloss()
 {
-	/* THIS METHOD IS JUST USED TO LOOK THROUGH THE ALL EXPERIMENTAL SINR ADITYA'S TRACE
-	EVEN WHEN THE SINR COMPUTATION IS NOT REQUIRED (SINCE THE SINR TRACE IS MADE EVERY 125MICROSECONDS) */
- NS_LOG_FUNCTION(this);
-	Ptr<SpectrumValue> noisePsd = MmWaveSpectrumValueHelper::CreateNoisePowerSpectralDensity (m_phyMacConfig, m_noiseFigure);
-	Ptr<SpectrumValue> totalReceivedPsd = Create <SpectrumValue> (SpectrumValue(noisePsd->GetSpectrumModel()));
-
-	for(std::map<uint64_t, Ptr<NetDevice> >::iterator ue = m_ueAttachedImsiMap.begin(); ue != m_ueAttachedImsiMap.end(); ++ue)
+	/* The experimental LOS/NLOS traces of the MmWaveLosTracker are sampled every 125 microseconds,
+	so the tracker is stepped at that pace even when the SINR computation is not required. The real
+	SINR of the attached UEs, which is only logged, is computed every PathlossMonitorPeriod, if set */
+	NS_LOG_FUNCTION(this);
+	bool monitor = !m_pathlossMonitorPeriod.IsZero ();
+	bool trackLos = (m_losTracker != 0) && m_propagationLoss;
+	if (!monitor && !trackLos)
 	{
-		// distinguish between MC and MmWaveNetDevice
-		Ptr<MmWaveUeNetDevice> ueNetDevice = DynamicCast<MmWaveUeNetDevice> (ue->second);
-		Ptr<McUeNetDevice> mcUeDev = DynamicCast<McUeNetDevice> (ue->second);
-		Ptr<MmWaveUePhy> uePhy;
-
-		// get tx power
-		double ueTxPower = 0;
-		if(ueNetDevice != 0) 
-		{
-			uePhy = ueNetDevice->GetPhy();
-			ueTxPower = uePhy->GetTxPower();
-		}
-		else if (mcUeDev != 0) // it may be a MC device
-		{
-			
-
-
-			if(isAddtionalMmWavPhy) //sjkang
-				uePhy = mcUeDev->GetMmWavePhy_2 ();
-			else
-				uePhy = mcUeDev->GetMmWavePhy ();
-
-			ueTxPower = uePhy->GetTxPower();
+		return; // nobody consumes the path loss between two updates of the SINR estimate
+	}
 
-		}
-		else
+	if (trackLos)
+	{
+		Ptr<MobilityModel> enbMob = m_netDevice->GetNode()->GetObject<MobilityModel>();
+		for(std::map<uint64_t, Ptr<NetDevice> >::iterator ue = m_ueAttachedImsiMap.begin(); ue != m_ueAttachedImsiMap.end(); ++ue)
 		{
-			NS_FATAL_ERROR("Unrecognized device");
+			m_losTracker->UpdateLosNlosState(ue->second->GetNode()->GetObject<MobilityModel>(), enbMob);
 		}
-		NS_LOG_LOGIC("UE Tx power = " << ueTxPower);
-	    double powerTxW = std::pow (10., (ueTxPower - 30) / 10);
-	    double txPowerDensity = 0;
-    	txPowerDensity = (powerTxW / (m_phyMacConfig->GetSystemBandwidth()));
-	    NS_LOG_LOGIC("Linear UE Tx power = " << powerTxW);
-	    NS_LOG_LOGIC("System bandwidth = " << m_phyMacConfig->GetSystemBandwidth());
-	    NS_LOG_LOGIC("txPowerDensity = " << txPowerDensity);
-		// create tx psd
-		Ptr<SpectrumValue> txPsd =						// it is the eNB that dictates the conf, m_listOfSubchannels contains all the subch
-			MmWaveSpectrumValueHelper::CreateTxPowerSpectralDensity (m_phyMacConfig, ueTxPower, m_listOfSubchannels);
-		NS_LOG_LOGIC("TxPsd " << *txPsd);
-
-		// get this node and remote node mobility
-		Ptr<MobilityModel> enbMob = m_netDevice->GetNode()->GetObject<MobilityModel>(); 
-		NS_LOG_LOGIC("eNB mobility " << enbMob->GetPosition());
-		Ptr<MobilityModel> ueMob = ue->second->GetNode()->GetObject<MobilityModel>();
-		NS_LOG_DEBUG("UE mobility " << ueMob->GetPosition());
-		
-		// compute rx psd
-
-		// adjuts beamforming of antenna model wrt user
-		Ptr<AntennaArrayModel> rxAntennaArray = DynamicCast<AntennaArrayModel> (GetDlSpectrumPhy ()->GetRxAntenna());
-		rxAntennaArray->ChangeBeamformingVector (ue->second);									// TODO check if this is the correct antenna
-		Ptr<AntennaArrayModel> txAntennaArray = DynamicCast<AntennaArrayModel> (uePhy->GetDlSpectrumPhy ()->GetRxAntenna());
-		txAntennaArray->ChangeBeamformingVector (m_netDevice);									// TODO check if this is the correct antenna
+	}
 
-		double pathLossDb = 0;
-		if (txAntennaArray != 0)
-		{
-		  Angles txAngles (enbMob->GetPosition (), ueMob->GetPosition ());
-		  double txAntennaGain = txAntennaArray->GetGainDb (txAngles);
-		  NS_LOG_LOGIC ("txAntennaGain = " << txAntennaGain << " dB");
-		  pathLossDb -= txAntennaGain;
-		}
-		if (rxAntennaArray != 0)
-		{
-		  Angles rxAngles (ueMob->GetPosition (), enbMob->GetPosition ());
-		  double rxAntennaGain = rxAntennaArray->GetGainDb (rxAngles);
-		  NS_LOG_LOGIC ("rxAntennaGain = " << rxAntennaGain << " dB");
-		  pathLossDb -= rxAntennaGain;
-		}
-		if (m_propagationLoss)
+	if (monitor && Simulator::Now () >= m_nextPathlossMonitor)
+	{
+		m_nextPathlossMonitor = Simulator::Now () + m_pathlossMonitorPeriod;
+		// the rx PSDs of the last SINR estimate update are reused as long as they are not older than the monitor period
+		if (Simulator::Now () - m_rxPsdMapTime >= m_pathlossMonitorPeriod || m_rxPsdMap.size () != m_ueAttachedImsiMap.size ())
 		{
-			if (m_losTracker != 0) // if I am using the PL propagation model with Aditya's traces
+			m_rxPsdMap.clear ();
+			for(std::map<uint64_t, Ptr<NetDevice> >::iterator ue = m_ueAttachedImsiMap.begin(); ue != m_ueAttachedImsiMap.end(); ++ue)
 			{
-				m_losTracker->UpdateLosNlosState(ueMob,enbMob); // update the maps to keep trak of the real PL values, before computing the PL
+				m_rxPsdMap[ue->first] = CalcUeRxPsd (ue->second, false);
 			}
-		  double propagationGainDb = m_propagationLoss->CalcRxPower (0, ueMob, enbMob);
-		  NS_LOG_LOGIC ("propagationGainDb = " << propagationGainDb << " dB");
-		  pathLossDb -= propagationGainDb;
-		}                    
-		//NS_LOG_DEBUG ("total pathLoss = " << pathLossDb << " dB");    
-
-		double pathGainLinear = std::pow (10.0, (-pathLossDb) / 10.0);
-		Ptr<SpectrumValue> rxPsd = txPsd->Copy();
-		*(rxPsd) *= pathGainLinear;              
-		//std::cout << this  << "\t" << txPsd << std::endl;
-		Ptr<MmWaveBeamforming> beamforming = DynamicCast<MmWaveBeamforming> (m_spectrumPropagationLossModel);
-		//beamforming->SetBeamformingVector(ue->second, m_netDevice);
-		Ptr<MmWaveChannelMatrix> channelMatrix = DynamicCast<MmWaveChannelMatrix> (m_spectrumPropagationLossModel);
-		Ptr<MmWaveChannelRaytracing> rayTracing = DynamicCast<MmWaveChannelRaytracing> (m_spectrumPropagationLossModel);
-		if (beamforming != 0)
-		{
-			//if (isAddtionalMmWavPhy) //sjkang
-			//	beamforming->isAdditionalMmWavePhy=true;
-			//else
-			//	beamforming->isAdditionalMmWavePhy=false;
-			rxPsd = beamforming->CalcRxPowerSpectralDensity(rxPsd, ueMob, enbMob);
-			NS_LOG_LOGIC("RxPsd " << *rxPsd);
+			m_rxPsdMapTime = Simulator::Now ();
 		}
-		else if (channelMatrix != 0)
+
+		Ptr<SpectrumValue> noisePsd = MmWaveSpectrumValueHelper::CreateNoisePowerSpectralDensity (m_phyMacConfig, m_noiseFigure);
+		Ptr<SpectrumValue> totalReceivedPsd = Create <SpectrumValue> (SpectrumValue(noisePsd->GetSpectrumModel()));
+		for(std::map<uint64_t, Ptr<SpectrumValue> >::iterator ue = m_rxPsdMap.begin(); ue != m_rxPsdMap.end(); ++ue)
 		{
-			rxPsd = channelMatrix->CalcRxPowerSpectralDensity(rxPsd, ueMob, enbMob);
-			NS_LOG_LOGIC("RxPsd " << *rxPsd);
+			*totalReceivedPsd += *(ue->second);
 		}
-		else if (rayTracing != 0)
+		for(std::map<uint64_t, Ptr<SpectrumValue> >::iterator ue = m_rxPsdMap.begin(); ue != m_rxPsdMap.end(); ++ue)
 		{
-			rxPsd = rayTracing->CalcRxPowerSpectralDensity(rxPsd, ueMob, enbMob);
-			NS_LOG_LOGIC("RxPsd " << *rxPsd);
+			SpectrumValue interference = *totalReceivedPsd - *(ue->second);
+			NS_LOG_LOGIC("interference " << interference);
+			SpectrumValue sinr = *(ue->second)/(*noisePsd + interference);
+			NS_LOG_LOGIC("sinr " << sinr);
+			double sinrAvg = Sum(sinr)/(sinr.GetSpectrumModel()->GetNumBands());
+			NS_LOG_DEBUG("Real SINR of UE " << ue->first << " is: " << 10*std::log10(sinrAvg));
 		}
-		m_rxPsdMap[ue->first] = rxPsd;
-		*totalReceivedPsd += *rxPsd;
-
-		// set back the bf vector to the main eNB
-		if(ueNetDevice != 0) 
-		{														// target not set yet
-			if((ueNetDevice->GetTargetEnb() != m_netDevice) && (ueNetDevice->GetTargetEnb() != 0))
-			{
-				txAntennaArray->ChangeBeamformingVector(ueNetDevice->GetTargetEnb());
-			}
-		}
-		else if (mcUeDev != 0) // it may be a MC device
-		{															// target not set yet
-			//if(isAddtionalMmWavPhy){
-			if((mcUeDev->GetMmWaveTargetEnb() != m_netDevice) && (mcUeDev->GetMmWaveTargetEnb() != 0) && !isAddtionalMmWavPhy)
-			{
-				//std::cout << this << "---->" << "0 target Enb is --->" <<isAddtionalMmWavPhy <<std::endl;
-				//if(isAddtionalMmWavPhy)
+	}
 
-				txAntennaArray->ChangeBeamformingVector(mcUeDev->GetMmWaveTargetEnb());
-				//std::cout << this << "---->" << "0 target Enb is --->" <<isAddtionalMmWavPhy <<std::endl;
+	Time period = MicroSeconds(125); // since one slot every 125 microseconds
+	if (!trackLos)
+	{
+		period = m_pathlossMonitorPeriod;
+	}
+	else if (monitor)
+	{
+		period = std::min (period, m_pathlossMonitorPeriod);
+	}
+	Simulator::Schedule(period, &MmWaveEnbPhy::CallPathloss, this);
+}
 
 
-			}
-			//}//else {
-				if((mcUeDev->GetMmWaveTargetEnb_2() != m_netDevice) && (mcUeDev->GetMmWaveTargetEnb_2() != 0) && isAddtionalMmWavPhy) //sjkang1117
-			{
-				//std::cout << this << "---->" << "1 target Enb is----> " <<isAddtionalMmWavPhy<< std::endl;
-				//if(!isAddtionalMmWavPhy)
-				txAntennaArray->ChangeBeamformingVector(mcUeDev->GetMmWaveTargetEnb_2());
-				//std::cout << this << "---->" << "1 target Enb is----> " <<isAddtionalMmWavPhy<< std::endl;
+Ptr<SpectrumValue>
+MmWaveEnbPhy::CalcUeRxPsd (Ptr<NetDevice> ueDevice, bool updateLosTracker)
+{
+	// distinguish between MC and MmWaveNetDevice
+	Ptr<MmWaveUeNetDevice> ueNetDevice = DynamicCast<MmWaveUeNetDevice> (ueDevice);
+	Ptr<McUeNetDevice> mcUeDev = DynamicCast<McUeNetDevice> (ueDevice);
+	Ptr<MmWaveUePhy> uePhy;
+	// get tx power
+	double ueTxPower = 0;
+	if(ueNetDevice != 0) 
+	{
+		uePhy = ueNetDevice->GetPhy();
+		ueTxPower = uePhy->GetTxPower();
+	}
+	else if (mcUeDev != 0) // it may be a MC device
+	{
+		
 
+		if(isAddtionalMmWavPhy) //sjkang
+			uePhy = mcUeDev->GetMmWavePhy_2 ();
 
-			}
-			//}
-		}
 		else
+			uePhy = mcUeDev->GetMmWavePhy ();
+		ueTxPower = uePhy->GetTxPower();	
+	}
+	else
+	{
+		NS_FATAL_ERROR("Unrecognized device");
+	}
+	NS_LOG_LOGIC("UE Tx power = " << ueTxPower);
+    double powerTxW = std::pow (10., (ueTxPower - 30) / 10);
+    double txPowerDensity = 0;
+    	txPowerDensity = (powerTxW / (m_phyMacConfig->GetSystemBandwidth()));
+    NS_LOG_LOGIC("Linear UE Tx power = " << powerTxW);
+    NS_LOG_LOGIC("System bandwidth = " << m_phyMacConfig->GetSystemBandwidth());
+    NS_LOG_LOGIC("txPowerDensity = " << txPowerDensity);
+	// create tx psd
+	Ptr<SpectrumValue> txPsd =						// it is the eNB that dictates the conf, m_listOfSubchannels contains all the subch
+		MmWaveSpectrumValueHelper::CreateTxPowerSpectralDensity (m_phyMacConfig, ueTxPower, m_listOfSubchannels);
+	NS_LOG_LOGIC("TxPsd " << *txPsd);
+
+	// get this node and remote node mobility
+	Ptr<MobilityModel> enbMob = m_netDevice->GetNode()->GetObject<MobilityModel>(); 
+	NS_LOG_LOGIC("eNB mobility " << enbMob->GetPosition());
+	Ptr<MobilityModel> ueMob = ueDevice->GetNode()->GetObject<MobilityModel>();
+	NS_LOG_DEBUG("UE mobility " << ueMob->GetPosition());
+	
+	// compute rx psd
+
+	// adjuts beamforming of antenna model wrt user
+	Ptr<AntennaArrayModel> rxAntennaArray = DynamicCast<AntennaArrayModel> (GetDlSpectrumPhy ()->GetRxAntenna());
+	rxAntennaArray->ChangeBeamformingVector (ueDevice);									// TODO check if this is the correct antenna
+	Ptr<AntennaArrayModel> txAntennaArray = DynamicCast<AntennaArrayModel> (uePhy->GetDlSpectrumPhy ()->GetRxAntenna());																				// Dl, since the Ul is not actually used (TDD device)
+	txAntennaArray->ChangeBeamformingVector (m_netDevice);									// TODO check if this is the correct antenna
+	
+	double pathLossDb = 0;
+	if (txAntennaArray != 0)
+	{
+	  Angles txAngles (enbMob->GetPosition (), ueMob->GetPosition ());
+	  double txAntennaGain = txAntennaArray->GetGainDb (txAngles);
+	  NS_LOG_LOGIC ("txAntennaGain = " << txAntennaGain << " dB");
+	  pathLossDb -= txAntennaGain;
+	}
+	if (rxAntennaArray != 0)
+	{
+	  Angles rxAngles (ueMob->GetPosition (), enbMob->GetPosition ());
+	  double rxAntennaGain = rxAntennaArray->GetGainDb (rxAngles);
+	  NS_LOG_LOGIC ("rxAntennaGain = " << rxAntennaGain << " dB");
+	  pathLossDb -= rxAntennaGain;
+	}
+	if (m_propagationLoss)
+	{
+		if (m_losTracker != 0 && updateLosTracker) // if I am using the PL propagation model with Aditya's traces
 		{
-			NS_FATAL_ERROR("Unrecognized device");
+			m_losTracker->UpdateLosNlosState(ueMob,enbMob); // update the maps to keep trak of the real PL values, before computing the PL
 		}
-
+	  double propagationGainDb = m_propagationLoss->CalcRxPower (0, ueMob, enbMob);
+	  NS_LOG_LOGIC ("propagationGainDb = " << propagationGainDb << " dB");
+	  pathLossDb -= propagationGainDb;
+	}                    
+	NS_LOG_DEBUG ("total pathLoss = " << pathLossDb << " dB");
+
+	double pathGainLinear = std::pow (10.0, (-pathLossDb) / 10.0);
+	Ptr<SpectrumValue> rxPsd = txPsd->Copy();
+	*(rxPsd) *= pathGainLinear;              
+
+	Ptr<MmWaveBeamforming> beamforming = DynamicCast<MmWaveBeamforming> (m_spectrumPropagationLossModel);
+	//beamforming->SetBeamformingVector(ueDevice, m_netDevice);
+	Ptr<MmWaveChannelMatrix> channelMatrix = DynamicCast<MmWaveChannelMatrix> (m_spectrumPropagationLossModel);
+	Ptr<MmWaveChannelRaytracing> rayTracing = DynamicCast<MmWaveChannelRaytracing> (m_spectrumPropagationLossModel);
+	Ptr<MmWave3gppChannel> mmWave3gpp = DynamicCast<MmWave3gppChannel> (m_spectrumPropagationLossModel);
+	if (beamforming != 0)
+	{
+		rxPsd = beamforming->CalcRxPowerSpectralDensity(rxPsd, ueMob, enbMob);
+		NS_LOG_LOGIC("RxPsd " << *rxPsd);
+	}
+	else if (channelMatrix != 0)
+	{
+		rxPsd = channelMatrix->CalcRxPowerSpectralDensity(rxPsd, ueMob, enbMob);
+		NS_LOG_LOGIC("RxPsd " << *rxPsd);
 	}
+	else if (rayTracing != 0)
+	{
+		rxPsd = rayTracing->CalcRxPowerSpectralDensity(rxPsd, ueMob, enbMob);
+		NS_LOG_LOGIC("RxPsd " << *rxPsd);
+	}
+	else if (mmWave3gpp != 0)
+	{
+		rxPsd = mmWave3gpp->CalcRxPowerSpectralDensity(rxPsd, ueMob, enbMob);
+		NS_LOG_LOGIC("RxPsd " << *rxPsd);
+	}	
 
-	for(std::map<uint64_t, Ptr<SpectrumValue> >::iterator ue = m_rxPsdMap.begin(); ue != m_rxPsdMap.end(); ++ue)
+	// set back the bf vector to the main eNB
+	if(ueNetDevice != 0) 
+	{														// target not set yet
+		if((ueNetDevice->GetTargetEnb() != m_netDevice) && (ueNetDevice->GetTargetEnb() != 0))
+		{
+			txAntennaArray->ChangeBeamformingVector(ueNetDevice->GetTargetEnb());
+		}
+	}
+	else if (mcUeDev != 0) // it may be a MC device
+	{															// target not set yet
+		if((mcUeDev->GetMmWaveTargetEnb() != m_netDevice) && (mcUeDev->GetMmWaveTargetEnb() != 0) && !isAddtionalMmWavPhy)
+		{
+			txAntennaArray->ChangeBeamformingVector(mcUeDev->GetMmWaveTargetEnb());
+		}else if((mcUeDev->GetMmWaveTargetEnb_2() != m_netDevice) && (mcUeDev->GetMmWaveTargetEnb_2() != 0) && isAddtionalMmWavPhy ) //sjkang1117
+		{
+			txAntennaArray->ChangeBeamformingVector(mcUeDev->GetMmWaveTargetEnb_2());
+		}
+	}
+	else
 	{
-		SpectrumValue interference = *totalReceivedPsd - *(ue->second);
-		NS_LOG_LOGIC("interference " << interference);
-		SpectrumValue sinr = *(ue->second)/(*noisePsd + interference);
-		NS_LOG_LOGIC("sinr " << sinr);
-		double sinrAvg = Sum(sinr)/(sinr.GetSpectrumModel()->GetNumBands());
-		NS_LOG_DEBUG("Real SINR every 125 microseconds is: " << 10*std::log10(sinrAvg));
+		NS_FATAL_ERROR("Unrecognized device");
 	}
 
-	Simulator::Schedule(MicroSeconds(125), &MmWaveEnbPhy::CallPathloss, this); // since one slot every 125 microseconds
+	return rxPsd;
 }
 
 
@@ -763,6 +800,7 @@ MmWaveEnbPhy::UpdateUeSinrEstimate()
     NS_LOG_FUNCTION(this);
 	m_sinrMap.clear();
 	m_rxPsdMap.clear();
+	m_rxPsdMapTime = Simulator::Now ();
 	
 
 	Ptr<SpectrumValue> noisePsd = MmWaveSpectrumValueHelper::CreateNoisePowerSpectralDensity (m_phyMacConfig, m_noiseFigure);
@@ -770,141 +808,9 @@ MmWaveEnbPhy::UpdateUeSinrEstimate()
 
 	for(std::map<uint64_t, Ptr<NetDevice> >::iterator ue = m_ueAttachedImsiMap.begin(); ue != m_ueAttachedImsiMap.end(); ++ue)
 	{
-		// distinguish between MC and MmWaveNetDevice
-		Ptr<MmWaveUeNetDevice> ueNetDevice = DynamicCast<MmWaveUeNetDevice> (ue->second);
-		Ptr<McUeNetDevice> mcUeDev = DynamicCast<McUeNetDevice> (ue->second);
-		Ptr<MmWaveUePhy> uePhy;
-		// get tx power
-		double ueTxPower = 0;
-		if(ueNetDevice != 0) 
-		{
-			uePhy = ueNetDevice->GetPhy();
-			ueTxPower = uePhy->GetTxPower();
-		}
-		else if (mcUeDev != 0) // it may be a MC device
-		{
-			
-
-			if(isAddtionalMmWavPhy) //sjkang
-				uePhy = mcUeDev->GetMmWavePhy_2 ();
-
-			else
-				uePhy = mcUeDev->GetMmWavePhy ();
-			ueTxPower = uePhy->GetTxPower();	
-		}
-		else
-		{
-			NS_FATAL_ERROR("Unrecognized device");
-		}
-		NS_LOG_LOGIC("UE Tx power = " << ueTxPower);
-	    double powerTxW = std::pow (10., (ueTxPower - 30) / 10);
-	    double txPowerDensity = 0;
-    	txPowerDensity = (powerTxW / (m_phyMacConfig->GetSystemBandwidth()));
-	    NS_LOG_LOGIC("Linear UE Tx power = " << powerTxW);
-	    NS_LOG_LOGIC("System bandwidth = " << m_phyMacConfig->GetSystemBandwidth());
-	    NS_LOG_LOGIC("txPowerDensity = " << txPowerDensity);
-		// create tx psd
-		Ptr<SpectrumValue> txPsd =						// it is the eNB that dictates the conf, m_listOfSubchannels contains all the subch
-			MmWaveSpectrumValueHelper::CreateTxPowerSpectralDensity (m_phyMacConfig, ueTxPower, m_listOfSubchannels);
-		NS_LOG_LOGIC("TxPsd " << *txPsd);
-
-		// get this node and remote node mobility
-		Ptr<MobilityModel> enbMob = m_netDevice->GetNode()->GetObject<MobilityModel>(); 
-		NS_LOG_LOGIC("eNB mobility " << enbMob->GetPosition());
-		Ptr<MobilityModel> ueMob = ue->second->GetNode()->GetObject<MobilityModel>();
-		NS_LOG_DEBUG("UE mobility " << ueMob->GetPosition());
-		
-		// compute rx psd
-
-		// adjuts beamforming of antenna model wrt user
-		Ptr<AntennaArrayModel> rxAntennaArray = DynamicCast<AntennaArrayModel> (GetDlSpectrumPhy ()->GetRxAntenna());
-		rxAntennaArray->ChangeBeamformingVector (ue->second);									// TODO check if this is the correct antenna
-		Ptr<AntennaArrayModel> txAntennaArray = DynamicCast<AntennaArrayModel> (uePhy->GetDlSpectrumPhy ()->GetRxAntenna());																				// Dl, since the Ul is not actually used (TDD device)
-		txAntennaArray->ChangeBeamformingVector (m_netDevice);									// TODO check if this is the correct antenna
-		
-		double pathLossDb = 0;
-		if (txAntennaArray != 0)
-		{
-		  Angles txAngles (enbMob->GetPosition (), ueMob->GetPosition ());
-		  double txAntennaGain = txAntennaArray->GetGainDb (txAngles);
-		  NS_LOG_LOGIC ("txAntennaGain = " << txAntennaGain << " dB");
-		  pathLossDb -= txAntennaGain;
-		}
-		if (rxAntennaArray != 0)
-		{
-		  Angles rxAngles (ueMob->GetPosition (), enbMob->GetPosition ());
-		  double rxAntennaGain = rxAntennaArray->GetGainDb (rxAngles);
-		  NS_LOG_LOGIC ("rxAntennaGain = " << rxAntennaGain << " dB");
-		  pathLossDb -= rxAntennaGain;
-		}
-		if (m_propagationLoss)
-		{
-			if (m_losTracker != 0) // if I am using the PL propagation model with Aditya's traces
-			{
-				m_losTracker->UpdateLosNlosState(ueMob,enbMob); // update the maps to keep trak of the real PL values, before computing the PL
-			}
-		  double propagationGainDb = m_propagationLoss->CalcRxPower (0, ueMob, enbMob);
-		  NS_LOG_LOGIC ("propagationGainDb = " << propagationGainDb << " dB");
-		  pathLossDb -= propagationGainDb;
-		}                    
-		NS_LOG_DEBUG ("total pathLoss = " << pathLossDb << " dB");
-
-		double pathGainLinear = std::pow (10.0, (-pathLossDb) / 10.0);
-		Ptr<SpectrumValue> rxPsd = txPsd->Copy();
-		*(rxPsd) *= pathGainLinear;              
-
-		Ptr<MmWaveBeamforming> beamforming = DynamicCast<MmWaveBeamforming> (m_spectrumPropagationLossModel);
-		//beamforming->SetBeamformingVector(ue->second, m_netDevice);
-		Ptr<MmWaveChannelMatrix> channelMatrix = DynamicCast<MmWaveChannelMatrix> (m_spectrumPropagationLossModel);
-		Ptr<MmWaveChannelRaytracing> rayTracing = DynamicCast<MmWaveChannelRaytracing> (m_spectrumPropagationLossModel);
-		Ptr<MmWave3gppChannel> mmWave3gpp = DynamicCast<MmWave3gppChannel> (m_spectrumPropagationLossModel);
-		if (beamforming != 0)
-		{
-			rxPsd = beamforming->CalcRxPowerSpectralDensity(rxPsd, ueMob, enbMob);
-			NS_LOG_LOGIC("RxPsd " << *rxPsd);
-		}
-		else if (channelMatrix != 0)
-		{
-			rxPsd = channelMatrix->CalcRxPowerSpectralDensity(rxPsd, ueMob, enbMob);
-			NS_LOG_LOGIC("RxPsd " << *rxPsd);
-		}
-		else if (rayTracing != 0)
-		{
-			rxPsd = rayTracing->CalcRxPowerSpectralDensity(rxPsd, ueMob, enbMob);
-			NS_LOG_LOGIC("RxPsd " << *rxPsd);
-		}
-		else if (mmWave3gpp != 0)
-		{
-			rxPsd = mmWave3gpp->CalcRxPowerSpectralDensity(rxPsd, ueMob, enbMob);
-			NS_LOG_LOGIC("RxPsd " << *rxPsd);
-		}	
+		Ptr<SpectrumValue> rxPsd = CalcUeRxPsd (ue->second, true);
 		m_rxPsdMap[ue->first] = rxPsd;
-
 		*totalReceivedPsd += *rxPsd;
-
-		// set back the bf vector to the main eNB
-		if(ueNetDevice != 0) 
-		{														// target not set yet
-			if((ueNetDevice->GetTargetEnb() != m_netDevice) && (ueNetDevice->GetTargetEnb() != 0))
-			{
-				txAntennaArray->ChangeBeamformingVector(ueNetDevice->GetTargetEnb());
-			}
-		}
-		else if (mcUeDev != 0) // it may be a MC device
-		{															// target not set yet
-			if((mcUeDev->GetMmWaveTargetEnb() != m_netDevice) && (mcUeDev->GetMmWaveTargetEnb() != 0) && !isAddtionalMmWavPhy)
-			{
-				txAntennaArray->ChangeBeamformingVector(mcUeDev->GetMmWaveTargetEnb());
-			}else if((mcUeDev->GetMmWaveTargetEnb_2() != m_netDevice) && (mcUeDev->GetMmWaveTargetEnb_2() != 0) && isAddtionalMmWavPhy ) //sjkang1117
-			{
-				txAntennaArray->ChangeBeamformingVector(mcUeDev->GetMmWaveTargetEnb_2());
-			}
-		}
-		else
-		{
-			NS_FATAL_ERROR("Unrecognized device");
-		}
-
 	}
 
 	for(std::map<uint64_t, Ptr<SpectrumValue> >::iterator ue = m_rxPsdMap.begin(); ue != m_rxPsdMap.end(); ++ue)
@@ -138,6 +138,13 @@ public:
 private:
 
 	bool AddUePhy (uint16_t rnti);
+	/**
+	 * \brief Compute the PSD received from a UE, with the beams of the pair and its current path loss
+	 * \param ueDevice the UE
+	 * \param updateLosTracker if true, step the MmWaveLosTracker for the pair
+	 * \return the received PSD
+	 */
+	Ptr<SpectrumValue> CalcUeRxPsd (Ptr<NetDevice> ueDevice, bool updateLosTracker);
 	// LteEnbCphySapProvider forwarded methods
 	void DoSetBandwidth (uint8_t ulBandwidth, uint8_t dlBandwidth);
 	void DoSetEarfcn (uint16_t dlEarfcn, uint16_t ulEarfcn);
@@ -178,6 +185,9 @@ private:
 	std::map <uint64_t, Ptr<NetDevice> > m_ueAttachedImsiMap;
 	std::map <uint64_t, double > m_sinrMap;
 	std::map <uint64_t, Ptr<SpectrumValue> > m_rxPsdMap;
+	Time m_rxPsdMapTime; // when m_rxPsdMap was last computed
+	Time m_pathlossMonitorPeriod; // the period of the real SINR monitoring in CallPathloss, zero if disabled
+	Time m_nextPathlossMonitor;
 	std::map <pairDevices_t , std::vector<double> > m_sinrVector; // array containing all SINR values for a specific pair (UE-eNB)
 	std::map <pairDevices_t , std::vector<double> > m_sinrVectorToFilter; // array containing the  SINR values that must be filtered
 	std::map <pairDevices_t , std::vector<double> > m_sinrVectorNoisy; // array containing the  noisy SINR values that must be filteredF
@@ -351,6 +351,21 @@ public:
    */
   static MmWaveTbStats_t GetTbDecodificationStats (const SpectrumValue& sinr, const std::vector<int>& map, uint32_t size, uint8_t mcs, MmWaveHarqProcessInfoList_t miHistory);
 
+  /**
+   * \brief run the error-model algorithm for the specified TB, of which the
+   * mmib is known already
+   *
+   * The mmib depends on the modulation of the MCS only, so that the callers
+   * trying several MCSs on the same SINRs can compute it once per modulation
+   * with Mib.
+   * \param tbMi the mmib of the TB, as returned by Mib for the modulation of the MCS
+   * \param size the size in bytes of the TB
+   * \param mcs the MCS of the TB
+   * \param miHistory the MI of the previous transmissions of the TB
+   * \return the TB error rate and MI
+   */
+  static MmWaveTbStats_t GetTbDecodificationStats (double tbMi, uint32_t size, uint8_t mcs, const MmWaveHarqProcessInfoList_t& miHistory);
+
 
 //private:
 
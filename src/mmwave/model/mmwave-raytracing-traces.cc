@@ -0,0 +1,302 @@
+ /* -*-  Mode: C++; c-file-style: "gnu"; indent-tabs-mode:nil; -*- */
+ /*
+ *   This program is free software; you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License version 2 as
+ *   published by the Free Software Foundation;
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program; if not, write to the Free Software
+ *   Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+
+#include "mmwave-raytracing-traces.h"
+#include <ns3/log.h>
+#include <ns3/abort.h>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <map>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+
+namespace ns3{
+
+NS_LOG_COMPONENT_DEFINE ("MmWaveRaytracingTraces");
+
+static const char RAYTRACING_TRACE_MAGIC[8] = {'M', 'M', 'W', 'R', 'A', 'Y', 'T', '1'};
+
+/*
+ * The binary format: this header, then the index of the first path of
+ * each position (uint64_t) followed by the total number of paths, then
+ * each column in turn (double), in the byte order of the host
+ */
+struct RaytracingTraceHeader
+{
+	char magic[8];
+	uint32_t byteOrder; // RAYTRACING_TRACE_BYTE_ORDER as written by the host
+	uint32_t numPositions;
+	uint64_t numPaths;
+};
+
+static const uint32_t RAYTRACING_TRACE_BYTE_ORDER = 0x01020304;
+
+/*
+ * The traces loaded from each file. The helper creates a channel per link
+ * direction, and the traces only depend on the file, so they are shared;
+ * the entry is not a reference, and is dropped with the traces when the
+ * last channel releases them.
+ */
+static std::map<std::string, MmWaveRaytracingTraces*>&
+GetLoadedTraces ()
+{
+	static std::map<std::string, MmWaveRaytracingTraces*> loaded;
+	return loaded;
+}
+
+MmWaveRaytracingTraces::MmWaveRaytracingTraces ()
+	: m_numPositions (0),
+	  m_firstPath (0),
+	  m_mapping (0),
+	  m_mappingSize (0),
+	  m_fileSize (0),
+	  m_fileTime (0)
+{
+	for (uint8_t column = 0; column < NUM_COLUMNS; column++)
+	{
+		m_columns[column] = 0;
+	}
+}
+
+MmWaveRaytracingTraces::~MmWaveRaytracingTraces ()
+{
+	std::map<std::string, MmWaveRaytracingTraces*>& loaded = GetLoadedTraces ();
+	std::map<std::string, MmWaveRaytracingTraces*>::iterator it = loaded.find (m_filename);
+	// a rewritten file replaced the entry with its own traces
+	if (it != loaded.end () && it->second == this)
+	{
+		loaded.erase (it);
+	}
+	if (m_mapping != 0)
+	{
+		munmap (m_mapping, m_mappingSize);
+	}
+}
+
+Ptr<MmWaveRaytracingTraces>
+MmWaveRaytracingTraces::Load (std::string filename)
+{
+	NS_LOG_FUNCTION (filename);
+	struct stat st;
+	NS_ABORT_MSG_IF (stat (filename.c_str (), &st) != 0, "Raytracing file " << filename << " not found");
+	int64_t fileTime = st.st_mtim.tv_sec * 1000000000LL + st.st_mtim.tv_nsec;
+
+	std::map<std::string, MmWaveRaytracingTraces*>& loaded = GetLoadedTraces ();
+	std::map<std::string, MmWaveRaytracingTraces*>::iterator it = loaded.find (filename);
+	if (it != loaded.end ()
+	    && it->second->m_fileSize == static_cast<uint64_t> (st.st_size)
+	    && it->second->m_fileTime == fileTime)
+	{
+		return Ptr<MmWaveRaytracingTraces> (it->second);
+	}
+
+	char magic[sizeof (RAYTRACING_TRACE_MAGIC)];
+	FILE* file = fopen (filename.c_str (), "rb");
+	NS_ABORT_MSG_IF (file == 0, "Raytracing file " << filename << " not found");
+	bool binary = fread (magic, sizeof (magic), 1, file) == 1
+		&& memcmp (magic, RAYTRACING_TRACE_MAGIC, sizeof (magic)) == 0;
+	fclose (file);
+
+	Ptr<MmWaveRaytracingTraces> traces = Create<MmWaveRaytracingTraces> ();
+	traces->m_filename = filename;
+	traces->m_fileSize = st.st_size;
+	traces->m_fileTime = fileTime;
+	if (binary)
+	{
+		traces->Map (filename);
+	}
+	else
+	{
+		traces->ReadText (filename);
+	}
+	NS_LOG_INFO ("Loaded " << traces->GetNumPositions () << " positions from the "
+	             << (binary ? "binary" : "text") << " raytracing file " << filename);
+	// the traces of an earlier version of the file live on with their holders
+	loaded[filename] = PeekPointer (traces);
+	return traces;
+}
+
+void
+MmWaveRaytracingTraces::ReadText (std::string filename)
+{
+	NS_LOG_FUNCTION (this << filename);
+	std::ifstream singlefile (filename.c_str (), std::ifstream::in);
+	NS_ABORT_MSG_IF (!singlefile.good (), "Raytracing file " << filename << " not found");
+
+	std::string line;
+	uint32_t numPaths = 0;
+	uint16_t counter = 0;
+	m_textFirstPath.push_back (0);
+	while (std::getline (singlefile, line)) //Parse each line of the file
+	{
+		// the comma separated values of the line
+		const char* token = line.c_str ();
+		char* end;
+		if (counter == 0)
+		{
+			if (line.find_first_not_of (" \t\r") == std::string::npos)
+			{
+				continue;
+			}
+			numPaths = strtod (token, &end);
+		}
+		else
+		{
+			std::vector<double>& values = m_textColumns[counter - 1];
+			for (uint32_t pathIndex = 0; pathIndex < numPaths; pathIndex++)
+			{
+				double value = strtod (token, &end);
+				NS_ABORT_MSG_IF (end == token, "Raytracing file " << filename << ": " << numPaths
+				                 << " paths expected at position " << m_textFirstPath.size () - 1
+				                 << ", line \"" << line << "\"");
+				values.push_back (value);
+				token = end;
+				while (*token == ',' || *token == ' ')
+				{
+					token++;
+				}
+			}
+		}
+		if (++counter == 8)
+		{
+			counter = 0;
+			m_textFirstPath.push_back (m_textFirstPath.back () + numPaths);
+		}
+	}
+	NS_ABORT_MSG_IF (counter != 0, "Raytracing file " << filename << " ends within a position");
+
+	m_numPositions = m_textFirstPath.size () - 1;
+	m_firstPath = &m_textFirstPath[0];
+	for (uint8_t column = 0; column < NUM_COLUMNS; column++)
+	{
+		m_textColumns[column].shrink_to_fit ();
+		m_columns[column] = m_textColumns[column].empty () ? 0 : &m_textColumns[column][0];
+	}
+}
+
+void
+MmWaveRaytracingTraces::Map (std::string filename)
+{
+	NS_LOG_FUNCTION (this << filename);
+	int fd = open (filename.c_str (), O_RDONLY);
+	NS_ABORT_MSG_IF (fd < 0, "Cannot open the raytracing file " << filename);
+	struct stat st;
+	NS_ABORT_MSG_IF (fstat (fd, &st) != 0, "Cannot stat the raytracing file " << filename);
+	m_mappingSize = st.st_size;
+	NS_ABORT_MSG_IF (m_mappingSize < sizeof (RaytracingTraceHeader), "Truncated raytracing file " << filename);
+	m_mapping = mmap (0, m_mappingSize, PROT_READ, MAP_PRIVATE, fd, 0);
+	close (fd);
+	NS_ABORT_MSG_IF (m_mapping == MAP_FAILED, "Cannot map the raytracing file " << filename);
+	// the positions are read along the route of the UE, so the default
+	// readahead of each column brings in the next positions with the current one
+	madvise (m_mapping, m_mappingSize, MADV_NORMAL);
+
+	const RaytracingTraceHeader* header = static_cast<const RaytracingTraceHeader*> (m_mapping);
+	NS_ABORT_MSG_IF (header->byteOrder != RAYTRACING_TRACE_BYTE_ORDER,
+	                 "The raytracing file " << filename << " was written on a host of another byte order");
+	m_numPositions = header->numPositions;
+	m_firstPath = reinterpret_cast<const uint64_t*> (header + 1);
+	const double* column = reinterpret_cast<const double*> (m_firstPath + m_numPositions + 1);
+	NS_ABORT_MSG_IF (header->numPaths > m_mappingSize / sizeof (double)
+	                 || m_mappingSize != sizeof (RaytracingTraceHeader) + (m_numPositions + 1) * sizeof (uint64_t)
+	                 + NUM_COLUMNS * header->numPaths * sizeof (double),
+	                 "Truncated raytracing file " << filename);
+	// the paths of each position lie within the columns
+	NS_ABORT_MSG_IF (m_firstPath[0] != 0, "Corrupted raytracing file " << filename << ": position 0 not at path 0");
+	for (uint32_t position = 0; position < m_numPositions; position++)
+	{
+		NS_ABORT_MSG_IF (m_firstPath[position + 1] < m_firstPath[position]
+		                 || m_firstPath[position + 1] > header->numPaths,
+		                 "Corrupted raytracing file " << filename << ": paths of position " << position
+		                 << " out of the " << header->numPaths << " written");
+	}
+	NS_ABORT_MSG_IF (m_firstPath[m_numPositions] != header->numPaths, "Corrupted raytracing file " << filename);
+	for (uint8_t c = 0; c < NUM_COLUMNS; c++)
+	{
+		m_columns[c] = column;
+		column += header->numPaths;
+	}
+}
+
+void
+MmWaveRaytracingTraces::ConvertToBinary (std::string textFile, std::string binaryFile)
+{
+	NS_LOG_FUNCTION (textFile << binaryFile);
+	Ptr<MmWaveRaytracingTraces> text = Create<MmWaveRaytracingTraces> ();
+	text->ReadText (textFile);
+
+	FILE* out = fopen (binaryFile.c_str (), "wb");
+	NS_ABORT_MSG_IF (out == 0, "Cannot create " << binaryFile);
+	RaytracingTraceHeader header;
+	memcpy (header.magic, RAYTRACING_TRACE_MAGIC, sizeof (header.magic));
+	header.byteOrder = RAYTRACING_TRACE_BYTE_ORDER;
+	header.numPositions = text->m_numPositions;
+	header.numPaths = text->m_textFirstPath.back ();
+	bool ok = fwrite (&header, sizeof (header), 1, out) == 1;
+	ok = ok && fwrite (&text->m_textFirstPath[0], sizeof (uint64_t), text->m_textFirstPath.size (), out)
+		== text->m_textFirstPath.size ();
+	for (uint8_t column = 0; column < NUM_COLUMNS; column++)
+	{
+		ok = ok && fwrite (text->m_columns[column], sizeof (double), header.numPaths, out) == header.numPaths;
+	}
+	ok = (fclose (out) == 0) && ok;
+	NS_ABORT_MSG_IF (!ok, "Cannot write " << binaryFile);
+}
+
+uint32_t
+MmWaveRaytracingTraces::GetNumPositions () const
+{
+	return m_numPositions;
+}
+
+uint32_t
+MmWaveRaytracingTraces::GetNumPaths (uint32_t position) const
+{
+	NS_ASSERT_MSG (position < m_numPositions, "position " << position << " out of the " << m_numPositions << " traced");
+	return m_firstPath[position + 1] - m_firstPath[position];
+}
+
+const double*
+MmWaveRaytracingTraces::GetPaths (uint32_t position, Column column) const
+{
+	NS_ASSERT_MSG (position < m_numPositions, "position " << position << " out of the " << m_numPositions << " traced");
+	return m_columns[column] + m_firstPath[position];
+}
+
+uint64_t
+MmWaveRaytracingTraces::GetMemoryUsage () const
+{
+	uint64_t bytes = sizeof (*this) + m_textFirstPath.capacity () * sizeof (uint64_t);
+	for (uint8_t column = 0; column < NUM_COLUMNS; column++)
+	{
+		bytes += m_textColumns[column].capacity () * sizeof (double);
+	}
+	return bytes;
+}
+
+uint64_t
+MmWaveRaytracingTraces::GetMappedSize () const
+{
+	return m_mapping != 0 ? m_mappingSize : 0;
+}
+
+}  //namespace ns3
@@ -0,0 +1,125 @@
+ /* -*-  Mode: C++; c-file-style: "gnu"; indent-tabs-mode:nil; -*- */
+ /*
+ *   This program is free software; you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License version 2 as
+ *   published by the Free Software Foundation;
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program; if not, write to the Free Software
+ *   Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+
+#ifndef MMWAVE_RAYTRACING_TRACES_H_
+#define MMWAVE_RAYTRACING_TRACES_H_
+
+
+#include <ns3/simple-ref-count.h>
+#include <ns3/ptr.h>
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+
+namespace ns3{
+
+/**
+ * The ray-traced paths of MmWaveChannelRaytracing, for each position of
+ * the UE along its route.
+ *
+ * The traces are read from either of two formats, told apart by the first
+ * bytes of the file:
+ * - the text format, 8 lines per position: the number of paths, then the
+ *   comma separated delay (ns), path loss (dB), phase, AoD elevation, AoD
+ *   azimuth, AoA elevation and AoA azimuth (degrees) of each path;
+ * - the binary format written by ConvertToBinary, which is memory mapped:
+ *   the pages of a position are read from the file the first time one of
+ *   its paths is accessed.
+ *
+ * Either way the paths are stored in columns, one per quantity, with the
+ * paths of each position contiguous.
+ */
+class MmWaveRaytracingTraces : public SimpleRefCount<MmWaveRaytracingTraces>
+{
+public:
+	enum Column
+	{
+		DELAY = 0,
+		PATHLOSS,
+		PHASE,
+		AOD_ELEVATION,
+		AOD_AZIMUTH,
+		AOA_ELEVATION,
+		AOA_AZIMUTH,
+		NUM_COLUMNS
+	};
+
+	MmWaveRaytracingTraces ();
+	~MmWaveRaytracingTraces ();
+
+	/**
+	 * \param filename a text or binary trace file
+	 * \return the traces of the file, shared by all the callers loading the
+	 * same file while any of them holds the traces and the file is unchanged
+	 */
+	static Ptr<MmWaveRaytracingTraces> Load (std::string filename);
+
+	/**
+	 * Write the traces of a text file in the binary format
+	 * \param textFile the text trace file
+	 * \param binaryFile the binary trace file to write
+	 */
+	static void ConvertToBinary (std::string textFile, std::string binaryFile);
+
+	uint32_t GetNumPositions () const;
+	uint32_t GetNumPaths (uint32_t position) const;
+
+	/**
+	 * \param position the index of the position
+	 * \param column the quantity
+	 * \return the values of the paths of the position, GetNumPaths of them
+	 */
+	const double* GetPaths (uint32_t position, Column column) const;
+
+	/**
+	 * \return the bytes allocated on the heap for the traces, not counting
+	 * the mapped file
+	 */
+	uint64_t GetMemoryUsage () const;
+
+	/**
+	 * \return the bytes of the mapped file, 0 with a text file
+	 */
+	uint64_t GetMappedSize () const;
+
+private:
+	void ReadText (std::string filename);
+	void Map (std::string filename);
+
+	uint32_t m_numPositions;
+	const uint64_t* m_firstPath; // first path of each position, and the number of paths at the end
+	const double* m_columns[NUM_COLUMNS];
+
+	// storage of the text format
+	std::vector<uint64_t> m_textFirstPath;
+	std::vector<double> m_textColumns[NUM_COLUMNS];
+
+	// mapping of the binary format
+	void* m_mapping;
+	uint64_t m_mappingSize;
+
+	// the file the traces were loaded from, to share them while it is unchanged
+	std::string m_filename;
+	uint64_t m_fileSize;
+	int64_t m_fileTime; // modification time (ns)
+};
+
+}  //namespace ns3
+
+
+#endif /* MMWAVE_RAYTRACING_TRACES_H_ */
@@ -0,0 +1,185 @@
+ /* -*-  Mode: C++; c-file-style: "gnu"; indent-tabs-mode:nil; -*- */
+ /*
+ *   This program is free software; you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License version 2 as
+ *   published by the Free Software Foundation;
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program; if not, write to the Free Software
+ *   Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+
+#include "ns3/core-module.h"
+#include "ns3/mmwave-amc.h"
+#include "ns3/mmwave-mi-error-model.h"
+#include "ns3/mmwave-phy-mac-common.h"
+#include "ns3/mmwave-spectrum-value-helper.h"
+#include "ns3/test.h"
+#include <map>
+#include <sstream>
+
+using namespace ns3;
+
+/*
+ * Check the MCS and CQI of the wideband reports of
+ * MmWaveAmc::CreateCqiFeedbackWbTdma, with the MI error model, against the
+ * computation it replaced, which evaluated the error model from the SINRs
+ * for every MCS up to the first one over 10 % of TB error rate.
+ */
+class MmWaveAmcCqiTestCase : public TestCase
+{
+public:
+  /**
+   * \param minSinrDb the lowest average SINR of the reports [dB]
+   * \param maxSinrDb the highest average SINR of the reports [dB]
+   * \param nReports the number of reports
+   */
+  MmWaveAmcCqiTestCase (double minSinrDb, double maxSinrDb, uint32_t nReports);
+
+private:
+  virtual void DoRun (void);
+
+  /*
+   * The MCS of the previous computation, and whether the TB error rate was
+   * over 10 % at MCS 0
+   */
+  static int ReferenceMcs (const SpectrumValue& sinr, uint32_t tbSize, bool &outage);
+
+  double m_minSinrDb;
+  double m_maxSinrDb;
+  uint32_t m_nReports;
+};
+
+static std::string
+BuildNameString (double minSinrDb, double maxSinrDb)
+{
+  std::ostringstream oss;
+  oss << "average SINR from " << minSinrDb << " to " << maxSinrDb << " dB";
+  return oss.str ();
+}
+
+MmWaveAmcCqiTestCase::MmWaveAmcCqiTestCase (double minSinrDb, double maxSinrDb, uint32_t nReports)
+  : TestCase (BuildNameString (minSinrDb, maxSinrDb)),
+    m_minSinrDb (minSinrDb),
+    m_maxSinrDb (maxSinrDb),
+    m_nReports (nReports)
+{
+}
+
+int
+MmWaveAmcCqiTestCase::ReferenceMcs (const SpectrumValue& sinr, uint32_t tbSize, bool &outage)
+{
+  std::vector<int> chunkMap;
+  for (uint32_t i = 0; i < sinr.GetSpectrumModel ()->GetNumBands (); i++)
+    {
+      chunkMap.push_back (i);
+    }
+  int mcs = 0;
+  MmWaveTbStats_t tbStats;
+  while (mcs <= 28)
+    {
+      MmWaveHarqProcessInfoList_t harqInfoList;
+      tbStats = MmWaveMiErrorModel::GetTbDecodificationStats (sinr, chunkMap, tbSize, mcs, harqInfoList);
+      if (tbStats.tbler > 0.1)
+        {
+          break;
+        }
+      mcs++;
+    }
+  if (mcs > 0)
+    {
+      mcs--;
+    }
+  outage = (tbStats.tbler > 0.1 && mcs == 0);
+  return mcs;
+}
+
+void
+MmWaveAmcCqiTestCase::DoRun (void)
+{
+  RngSeedManager::SetSeed (1);
+  RngSeedManager::SetRun (1);
+
+  Ptr<MmWavePhyMacCommon> config = CreateObject<MmWavePhyMacCommon> ();
+  Ptr<MmWaveAmc> amc = CreateObject<MmWaveAmc> (config);
+  amc->SetAttribute ("AmcModel", EnumValue (MmWaveAmc::MiErrorModel));
+  Ptr<SpectrumModel> model = MmWaveSpectrumValueHelper::GetSpectrumModel (config);
+
+  // frequency selective SINRs, with a few dB of fading across the band,
+  // and TBs of any MCS over a slot
+  Ptr<UniformRandomVariable> rv = CreateObject<UniformRandomVariable> ();
+  std::map<int, int> cqiOfMcs;
+  for (uint32_t i = 0; i < m_nReports; i++)
+    {
+      SpectrumValue sinr (model);
+      double averageDb = rv->GetValue (m_minSinrDb, m_maxSinrDb);
+      double fadingDb = rv->GetValue (0, 10);
+      for (Values::iterator it = sinr.ValuesBegin (); it != sinr.ValuesEnd (); it++)
+        {
+          *it = std::pow (10, (averageDb + rv->GetValue (-fadingDb, fadingDb)) / 10);
+        }
+      uint8_t numSym = rv->GetInteger (1, config->GetSymbPerSlot ());
+      uint32_t tbSize = amc->GetTbSizeFromMcsSymbols (rv->GetInteger (0, 28), numSym) / 8;
+
+      bool outage;
+      int referenceMcs = ReferenceMcs (sinr, tbSize, outage);
+      int mcs;
+      int cqi = amc->CreateCqiFeedbackWbTdma (sinr, numSym, tbSize, mcs);
+      NS_TEST_ASSERT_MSG_EQ (mcs, referenceMcs, "report " << i << ": wrong MCS");
+
+      // the CQI is 0 in outage, and else the same function of the MCS
+      if (outage)
+        {
+          NS_TEST_ASSERT_MSG_EQ (cqi, 0, "report " << i << ": wrong CQI in outage");
+          continue;
+        }
+      if (mcs == 28)
+        {
+          NS_TEST_ASSERT_MSG_EQ (cqi, 15, "report " << i << ": wrong CQI at MCS 28");
+        }
+      std::map<int, int>::iterator it = cqiOfMcs.find (mcs);
+      if (it == cqiOfMcs.end ())
+        {
+          cqiOfMcs[mcs] = cqi;
+        }
+      else
+        {
+          NS_TEST_ASSERT_MSG_EQ (cqi, it->second, "report " << i << ": wrong CQI for MCS " << mcs);
+        }
+    }
+
+  // and a higher MCS never gets a lower CQI
+  int previousCqi = 0;
+  for (std::map<int, int>::iterator it = cqiOfMcs.begin (); it != cqiOfMcs.end (); ++it)
+    {
+      NS_TEST_ASSERT_MSG_GT_OR_EQ (it->second, previousCqi, "CQI decreasing at MCS " << it->first);
+      previousCqi = it->second;
+    }
+}
+
+
+class MmWaveAmcCqiTestSuite : public TestSuite
+{
+public:
+  MmWaveAmcCqiTestSuite ();
+};
+
+MmWaveAmcCqiTestSuite::MmWaveAmcCqiTestSuite ()
+  : TestSuite ("mmwave-amc-cqi", UNIT)
+{
+  // around the outage and the QPSK MCSs
+  AddTestCase (new MmWaveAmcCqiTestCase (-15, 5, 300), TestCase::QUICK);
+  // across the modulation switches
+  AddTestCase (new MmWaveAmcCqiTestCase (5, 25, 300), TestCase::QUICK);
+  // up to MCS 28
+  AddTestCase (new MmWaveAmcCqiTestCase (20, 40, 300), TestCase::QUICK);
+  AddTestCase (new MmWaveAmcCqiTestCase (-10, 40, 2000), TestCase::EXTENSIVE);
+}
+
+static MmWaveAmcCqiTestSuite mmWaveAmcCqiTestSuite;
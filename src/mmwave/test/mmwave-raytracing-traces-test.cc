@@ -0,0 +1,158 @@
+ /* -*-  Mode: C++; c-file-style: "gnu"; indent-tabs-mode:nil; -*- */
+ /*
+ *   This program is free software; you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License version 2 as
+ *   published by the Free Software Foundation;
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program; if not, write to the Free Software
+ *   Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+
+#include "ns3/core-module.h"
+#include "ns3/mmwave-raytracing-traces.h"
+#include "ns3/test.h"
+#include <fstream>
+
+using namespace ns3;
+
+/*
+ * The paths of each position of the trace: the number of paths, then the
+ * delay, path loss, phase, AoD elevation, AoD azimuth, AoA elevation and
+ * AoA azimuth of each path, as in the text format
+ */
+static const uint32_t g_numPositions = 3;
+static const uint32_t g_numPaths[g_numPositions] = {2, 0, 3};
+static const double g_paths[g_numPositions][MmWaveRaytracingTraces::NUM_COLUMNS][3] =
+{
+  {
+    {12.5, 40.125}, {-81.3, -97.06}, {0.25, 3.1}, {90, 87.5}, {-170.2, 15}, {92.25, 88}, {10.5, -179.75}
+  },
+  {
+    {}, {}, {}, {}, {}, {}, {}
+  },
+  {
+    {7.75, 30, 1e3}, {-70.5, -99.125, -120}, {-1.5, 0, 6.28}, {45, 60.5, 120}, {0, 180, -90}, {135, 90, 2.5e1}, {-45.5, 0.125, 60}
+  }
+};
+
+/*
+ * Write the traces above in the text format
+ * \param filename the file to write
+ * \param numPositions the number of positions to write, at most g_numPositions
+ */
+static void
+WriteTextTrace (std::string filename, uint32_t numPositions)
+{
+  std::ofstream file (filename.c_str ());
+  file.precision (17);
+  for (uint32_t position = 0; position < numPositions; position++)
+    {
+      file << g_numPaths[position] << std::endl;
+      for (uint8_t column = 0; column < MmWaveRaytracingTraces::NUM_COLUMNS; column++)
+        {
+          for (uint32_t path = 0; path < g_numPaths[position]; path++)
+            {
+              file << (path > 0 ? "," : "") << g_paths[position][column][path];
+            }
+          file << std::endl;
+        }
+    }
+}
+
+/*
+ * Round trip a small text trace through MmWaveRaytracingTraces::ConvertToBinary,
+ * and check that the traces loaded from either file hold every value of
+ * every column, and that the traces are shared while the file is unchanged.
+ */
+class MmWaveRaytracingTracesTestCase : public TestCase
+{
+public:
+  MmWaveRaytracingTracesTestCase ();
+
+private:
+  virtual void DoRun (void);
+
+  /*
+   * Check the traces against the ones written
+   * \param traces the traces loaded
+   * \param format the format of the file, for the messages
+   */
+  void CheckTraces (Ptr<MmWaveRaytracingTraces> traces, std::string format);
+};
+
+MmWaveRaytracingTracesTestCase::MmWaveRaytracingTracesTestCase ()
+  : TestCase ("Text and binary raytracing traces, round trip")
+{
+}
+
+void
+MmWaveRaytracingTracesTestCase::CheckTraces (Ptr<MmWaveRaytracingTraces> traces, std::string format)
+{
+  NS_TEST_ASSERT_MSG_EQ (traces->GetNumPositions (), g_numPositions, format << ": wrong number of positions");
+  for (uint32_t position = 0; position < g_numPositions; position++)
+    {
+      NS_TEST_ASSERT_MSG_EQ (traces->GetNumPaths (position), g_numPaths[position],
+                             format << ": wrong number of paths at position " << position);
+      for (uint8_t column = 0; column < MmWaveRaytracingTraces::NUM_COLUMNS; column++)
+        {
+          const double* paths = traces->GetPaths (position, static_cast<MmWaveRaytracingTraces::Column> (column));
+          for (uint32_t path = 0; path < g_numPaths[position]; path++)
+            {
+              NS_TEST_ASSERT_MSG_EQ (paths[path], g_paths[position][column][path],
+                                     format << ": wrong column " << (uint32_t) column << " of path " << path
+                                     << " at position " << position);
+            }
+        }
+    }
+}
+
+void
+MmWaveRaytracingTracesTestCase::DoRun (void)
+{
+  std::string textFile = CreateTempDirFilename ("raytracing-traces.txt");
+  std::string binaryFile = CreateTempDirFilename ("raytracing-traces.bin");
+  WriteTextTrace (textFile, g_numPositions);
+  MmWaveRaytracingTraces::ConvertToBinary (textFile, binaryFile);
+
+  Ptr<MmWaveRaytracingTraces> text = MmWaveRaytracingTraces::Load (textFile);
+  CheckTraces (text, "text");
+  NS_TEST_ASSERT_MSG_EQ (text->GetMappedSize (), 0, "text traces mapped");
+
+  Ptr<MmWaveRaytracingTraces> binary = MmWaveRaytracingTraces::Load (binaryFile);
+  CheckTraces (binary, "binary");
+  NS_TEST_ASSERT_MSG_GT (binary->GetMappedSize (), 0, "binary traces not mapped");
+
+  // shared by the channels loading the same file
+  NS_TEST_ASSERT_MSG_EQ (MmWaveRaytracingTraces::Load (binaryFile), binary, "binary traces loaded again");
+
+  // a rewritten file is loaded again, while the traces already held are
+  // kept (the text file, as a mapped one must not be rewritten in place)
+  WriteTextTrace (textFile, 1);
+  Ptr<MmWaveRaytracingTraces> rewritten = MmWaveRaytracingTraces::Load (textFile);
+  NS_TEST_ASSERT_MSG_NE (rewritten, text, "traces of the rewritten file not loaded");
+  NS_TEST_ASSERT_MSG_EQ (rewritten->GetNumPositions (), 1, "wrong number of positions of the rewritten file");
+  NS_TEST_ASSERT_MSG_EQ (MmWaveRaytracingTraces::Load (textFile), rewritten, "rewritten traces loaded again");
+  CheckTraces (text, "text held");
+}
+
+
+class MmWaveRaytracingTracesTestSuite : public TestSuite
+{
+public:
+  MmWaveRaytracingTracesTestSuite ();
+};
+
+MmWaveRaytracingTracesTestSuite::MmWaveRaytracingTracesTestSuite ()
+  : TestSuite ("mmwave-raytracing-traces", UNIT)
+{
+  AddTestCase (new MmWaveRaytracingTracesTestCase (), TestCase::QUICK);
+}
+
+static MmWaveRaytracingTracesTestSuite mmWaveRaytracingTracesTestSuite;
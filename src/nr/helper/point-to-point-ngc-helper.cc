@@ -34,6 +34,7 @@
 #include <ns3/point-to-point-helper.h>
 #include <ns3/packet-socket-helper.h>
 #include <ns3/packet-socket-address.h>
+#include <ns3/ipv4-static-routing-helper.h>
 #include <ns3/ngc-enb-application.h>
 #include <ns3/ngc-smf-upf-application.h>
 
@@ -64,6 +65,7 @@ PointToPointNgcHelper::PointToPointNgcHelper ()
   m_n2uIpv4AddressHelper.SetBase ("10.0.0.0", "255.255.255.252");
   m_n2apIpv4AddressHelper.SetBase ("11.0.0.0", "255.255.255.252");
   m_x2Ipv4AddressHelper.SetBase ("12.0.0.0", "255.255.255.252");
+  m_n9Ipv4AddressHelper.SetBase ("13.0.0.0", "255.255.255.252");
 
   // we use a /8 net for all UEs
   m_ueAddressHelper.SetBase ("7.0.0.0", "255.0.0.0");
@@ -110,6 +112,8 @@ PointToPointNgcHelper::PointToPointNgcHelper ()
   
   // connect SmfUpfApplication and virtual net device for tunneling
   m_tunDevice->SetSendCallback (MakeCallback (&NgcSmfUpfApplication::RecvFromTunDevice, m_smfUpfApp));
+  m_upfNodes.push_back (m_smfUpf);
+  m_upfTunDevices.push_back (m_tunDevice);
 
   // create N2apAmf object and aggregate it with the m_amfNode
   Ptr<NgcN2apAmf> n2apAmf = CreateObject<NgcN2apAmf> (amfN2apSocket, 1); // for now, only one amf!
@@ -182,6 +186,21 @@ PointToPointNgcHelper::GetTypeId (void)
                    UintegerValue (3000),
                    MakeUintegerAccessor (&PointToPointNgcHelper::m_x2LinkMtu),
                    MakeUintegerChecker<uint16_t> ())
+    .AddAttribute ("N9LinkDataRate",
+                   "The data rate to be used for the next N9 link to be created",
+                   DataRateValue (DataRate ("10Gb/s")),
+                   MakeDataRateAccessor (&PointToPointNgcHelper::m_n9LinkDataRate),
+                   MakeDataRateChecker ())
+    .AddAttribute ("N9LinkDelay",
+                   "The delay to be used for the next N9 link to be created",
+                   TimeValue (Seconds (0)),
+                   MakeTimeAccessor (&PointToPointNgcHelper::m_n9LinkDelay),
+                   MakeTimeChecker ())
+    .AddAttribute ("N9LinkMtu",
+                   "The MTU of the next N9 link to be created. It carries GTP-U tunnels, like the N2-U links.",
+                   UintegerValue (2000),
+                   MakeUintegerAccessor (&PointToPointNgcHelper::m_n9LinkMtu),
+                   MakeUintegerChecker<uint16_t> ())
   ;
   return tid;
 }
@@ -190,48 +209,131 @@ void
 PointToPointNgcHelper::DoDispose ()
 {
   NS_LOG_FUNCTION (this);
-  m_tunDevice->SetSendCallback (MakeNullCallback<bool, Ptr<Packet>, const Address&, const Address&, uint16_t> ());
+  for (uint32_t i = 0; i < m_upfTunDevices.size (); i++)
+    {
+      m_upfTunDevices[i]->SetSendCallback (MakeNullCallback<bool, Ptr<Packet>, const Address&, const Address&, uint16_t> ());
+    }
+  m_upfTunDevices.clear ();
   m_tunDevice = 0;
   m_smfUpfApp = 0;  
+  for (uint32_t i = 1; i < m_upfNodes.size (); i++)
+    {
+      m_upfNodes[i]->Dispose ();
+    }
+  m_upfNodes.clear ();
+  m_enbNodeByCellId.clear ();
   m_smfUpf->Dispose ();
 }
 
 
-void
-PointToPointNgcHelper::AddEnb (Ptr<Node> enb, Ptr<NetDevice> nrEnbNetDevice, uint16_t cellId)
+uint32_t
+PointToPointNgcHelper::AddUpf ()
 {
-  NS_LOG_FUNCTION (this << enb << nrEnbNetDevice << cellId);
-
-  NS_ASSERT (enb == nrEnbNetDevice->GetNode ());
+  NS_LOG_FUNCTION (this);
 
-  // add an IPv4 stack to the previously created eNB
+  Ptr<Node> upf = CreateObject<Node> ();
   InternetStackHelper internet;
-  internet.Install (enb);
-  NS_LOG_LOGIC ("number of Ipv4 ifaces of the eNB after node creation: " << enb->GetObject<Ipv4> ()->GetNInterfaces ());
+  internet.Install (upf);
+
+  // create a point to point N9 link between the new UPF and the SMF-UPF
+  PointToPointHelper p2ph;
+  p2ph.SetDeviceAttribute ("DataRate", DataRateValue (m_n9LinkDataRate));
+  p2ph.SetDeviceAttribute ("Mtu", UintegerValue (m_n9LinkMtu));
+  p2ph.SetChannelAttribute ("Delay", TimeValue (m_n9LinkDelay));
+  NetDeviceContainer upfSmfDevices = p2ph.Install (upf, m_smfUpf);
+  m_n9Ipv4AddressHelper.NewNetwork ();
+  Ipv4InterfaceContainer upfSmfIpIfaces = m_n9Ipv4AddressHelper.Assign (upfSmfDevices);
+  Ipv4Address n9Address = upfSmfIpIfaces.GetAddress (0);
+  Ipv4Address smfN9Address = upfSmfIpIfaces.GetAddress (1);
+
+  // the traffic of the UPF to and from the internet goes through the
+  // SMF-UPF, unless the simulation program attaches servers to the UPF
+  Ptr<Ipv4> upfIpv4 = upf->GetObject<Ipv4> ();
+  Ipv4StaticRoutingHelper ipv4RoutingHelper;
+  Ptr<Ipv4StaticRouting> upfStaticRouting = ipv4RoutingHelper.GetStaticRouting (upfIpv4);
+  upfStaticRouting->SetDefaultRoute (smfN9Address, upfIpv4->GetInterfaceForDevice (upfSmfDevices.Get (0)));
+
+  // create the GTP-U socket of the UPF, for both N2-U and N9
+  Ptr<Socket> upfN2uSocket = Socket::CreateSocket (upf, TypeId::LookupByName ("ns3::UdpSocketFactory"));
+  int retval = upfN2uSocket->Bind (InetSocketAddress (Ipv4Address::GetAny (), m_gtpuUdpPort));
+  NS_ASSERT (retval == 0);
+
+  // create the TUN device of the UPF, on the same subnet as the UEs
+  Ptr<VirtualNetDevice> tunDevice = CreateObject<VirtualNetDevice> ();
+  tunDevice->SetAttribute ("Mtu", UintegerValue (30000));
+  tunDevice->SetAddress (Mac48Address::Allocate ());
+  upf->AddDevice (tunDevice);
+  NetDeviceContainer tunDeviceContainer;
+  tunDeviceContainer.Add (tunDevice);
+  m_ueAddressHelper.Assign (tunDeviceContainer);
+
+  uint32_t upfIndex = m_smfUpfApp->AddUpf (tunDevice, upfN2uSocket, n9Address, smfN9Address);
+  tunDevice->SetSendCallback (MakeCallback (&NgcSmfUpfApplication::RecvFromTunDevice, m_smfUpfApp));
+  m_upfNodes.push_back (upf);
+  m_upfTunDevices.push_back (tunDevice);
+  NS_ASSERT (upfIndex == m_upfNodes.size () - 1);
+  NS_LOG_INFO ("UPF " << upfIndex << " at " << n9Address);
+
+  for (std::map<uint16_t, Ptr<Node> >::iterator it = m_enbNodeByCellId.begin ();
+       it != m_enbNodeByCellId.end ();
+       ++it)
+    {
+      ConnectEnbToUpf (it->second, it->first, upfIndex);
+    }
+  return upfIndex;
+}
+
+
+Ipv4InterfaceContainer
+PointToPointNgcHelper::ConnectEnbToUpf (Ptr<Node> enb, uint16_t cellId, uint32_t upfIndex)
+{
+  NS_LOG_FUNCTION (this << enb << cellId << upfIndex);
 
-  // create a point to point link between the new eNB and the SMF with
+  // create a point to point link between the eNB and the UPF with
   // the corresponding new NetDevices on each side  
-  NodeContainer enbSmfNodes;
-  enbSmfNodes.Add (m_smfUpf);
-  enbSmfNodes.Add (enb);
+  Ptr<Node> upf = m_upfNodes[upfIndex];
   PointToPointHelper p2ph;
   p2ph.SetDeviceAttribute ("DataRate", DataRateValue (m_n2uLinkDataRate));
   p2ph.SetDeviceAttribute ("Mtu", UintegerValue (m_n2uLinkMtu));
   p2ph.SetChannelAttribute ("Delay", TimeValue (m_n2uLinkDelay));  
-  NetDeviceContainer enbSmfDevices = p2ph.Install (enb, m_smfUpf);
+  NetDeviceContainer enbUpfDevices = p2ph.Install (enb, upf);
   NS_LOG_LOGIC ("number of Ipv4 ifaces of the eNB after installing p2p dev: " << enb->GetObject<Ipv4> ()->GetNInterfaces ());  
-  Ptr<NetDevice> enbDev = enbSmfDevices.Get (0);
-  Ptr<NetDevice> smfDev = enbSmfDevices.Get (1);
   m_n2uIpv4AddressHelper.NewNetwork ();
-  Ipv4InterfaceContainer enbSmfIpIfaces = m_n2uIpv4AddressHelper.Assign (enbSmfDevices);
+  Ipv4InterfaceContainer enbUpfIpIfaces = m_n2uIpv4AddressHelper.Assign (enbUpfDevices);
   NS_LOG_LOGIC ("number of Ipv4 ifaces of the eNB after assigning Ipv4 addr to N2 dev: " << enb->GetObject<Ipv4> ()->GetNInterfaces ());
+
+  m_smfUpfApp->AddEnb (cellId, enbUpfIpIfaces.GetAddress (0), enbUpfIpIfaces.GetAddress (1), upfIndex);
+  return enbUpfIpIfaces;
+}
+
+
+void
+PointToPointNgcHelper::AddEnb (Ptr<Node> enb, Ptr<NetDevice> nrEnbNetDevice, uint16_t cellId)
+{
+  NS_LOG_FUNCTION (this << enb << nrEnbNetDevice << cellId);
+
+  NS_ASSERT (enb == nrEnbNetDevice->GetNode ());
+
+  // add an IPv4 stack to the previously created eNB
+  InternetStackHelper internet;
+  internet.Install (enb);
+  NS_LOG_LOGIC ("number of Ipv4 ifaces of the eNB after node creation: " << enb->GetObject<Ipv4> ()->GetNInterfaces ());
+
+  // create a point to point link between the new eNB and the SMF,
+  // and one to each of the other UPFs
+  Ipv4InterfaceContainer enbSmfIpIfaces = ConnectEnbToUpf (enb, cellId, 0);
+  for (uint32_t upfIndex = 1; upfIndex < m_upfNodes.size (); upfIndex++)
+    {
+      ConnectEnbToUpf (enb, cellId, upfIndex);
+    }
+  m_enbNodeByCellId[cellId] = enb;
   
   Ipv4Address enbAddress = enbSmfIpIfaces.GetAddress (0);
   Ipv4Address smfAddress = enbSmfIpIfaces.GetAddress (1);
 
-  // create N2-U socket for the ENB
+  // create N2-U socket for the ENB, listening on the links to all the UPFs
   Ptr<Socket> enbN2uSocket = Socket::CreateSocket (enb, TypeId::LookupByName ("ns3::UdpSocketFactory"));
-  int retval = enbN2uSocket->Bind (InetSocketAddress (enbAddress, m_gtpuUdpPort));
+  int retval = enbN2uSocket->Bind (InetSocketAddress (Ipv4Address::GetAny (), m_gtpuUdpPort));
   NS_ASSERT (retval == 0);
 
 
@@ -301,8 +403,6 @@ PointToPointNgcHelper::AddEnb (Ptr<Node> enb, Ptr<NetDevice> nrEnbNetDevice, uin
   // add the interface to the N2AP endpoint on the AMF
   Ptr<NgcN2apAmf> n2apAmf = m_amfNode->GetObject<NgcN2apAmf> ();
   n2apAmf->AddN2apInterface (cellId, amf_enbAddress);
-  
-  m_smfUpfApp->AddEnb (cellId, enbAddress, smfAddress);
 }
 
 
@@ -421,6 +521,26 @@ PointToPointNgcHelper::GetUpfNode ()
   return m_smfUpf;
 }
 
+Ptr<Node>
+PointToPointNgcHelper::GetUpfNode (uint32_t upfIndex)
+{
+  NS_ASSERT_MSG (upfIndex < m_upfNodes.size (), "unknown UPF " << upfIndex);
+  return m_upfNodes[upfIndex];
+}
+
+uint32_t
+PointToPointNgcHelper::GetNUpfs () const
+{
+  return m_upfNodes.size ();
+}
+
+void
+PointToPointNgcHelper::SetLocalUpf (uint16_t cellId, uint32_t upfIndex)
+{
+  NS_LOG_FUNCTION (this << cellId << upfIndex);
+  m_smfUpfApp->SetLocalUpf (cellId, upfIndex);
+}
+
 Ptr<Node>
 PointToPointNgcHelper::GetAmfNode ()
 {
@@ -33,6 +33,7 @@
 #include <ns3/ngc-tft.h>
 #include <ns3/eps-bearer.h>
 #include <ns3/ngc-helper.h>
+#include <ns3/ipv4-interface-container.h>
 
 namespace ns3 {
 
@@ -55,6 +56,13 @@ class NgcN2apAmf;
  * single node that implements both the SMF and UPF functionality, and
  * an AMF node. The N2-U, N2-AP, X2-U and X2-C interfaces are realized over
  * PointToPoint links. 
+ *
+ * Further UPF nodes, e.g. edge anchors, can be added with AddUpf (). Each
+ * of them is attached to the central SMF/UPF node over an N9
+ * PointToPoint link, which also carries its traffic to and from the
+ * internet, and to every eNB over an N2-U PointToPoint link. The SMF
+ * selects the UPF of each PDU session as set by the
+ * ns3::NgcSmfUpfApplication::UpfSelectionPolicy attribute.
  */
 class PointToPointNgcHelper : public NgcHelper
 {
@@ -89,10 +97,48 @@ public:
   virtual Ipv4InterfaceContainer AssignUeIpv4Address (NetDeviceContainer ueDevices);
   virtual Ipv4Address GetUeDefaultGatewayAddress ();
 
+  /**
+   * Add a UPF node, attached to the central SMF/UPF node over N9 and to
+   * the eNBs, already added or not, over N2-U
+   *
+   * \return the index of the UPF, the central one being 0
+   */
+  uint32_t AddUpf ();
+
+  /**
+   * \param upfIndex the index of a UPF
+   * \return the node of the UPF
+   */
+  Ptr<Node> GetUpfNode (uint32_t upfIndex);
+
+  /**
+   * \return the number of UPFs, including the central one
+   */
+  uint32_t GetNUpfs () const;
+
+  /**
+   * Set the UPF of the sessions created in a cell, when the SMF selects
+   * the UPFs by locality
+   *
+   * \param cellId the cell identifier
+   * \param upfIndex the index of the UPF
+   */
+  void SetLocalUpf (uint16_t cellId, uint32_t upfIndex);
+
 
 
 private:
 
+  /**
+   * Create the N2-U link between an eNB and a UPF
+   *
+   * \param enb the node of the eNB
+   * \param cellId the cell identifier of the eNB
+   * \param upfIndex the index of the UPF
+   * \return the interfaces of the eNB and of the UPF on the link
+   */
+  Ipv4InterfaceContainer ConnectEnbToUpf (Ptr<Node> enb, uint16_t cellId, uint32_t upfIndex);
+
   /** 
    * helper to assign addresses to UE devices as well as to the TUN device of the SMF/UPF
    */
@@ -113,6 +159,21 @@ private:
    */
   Ptr<VirtualNetDevice> m_tunDevice;
 
+  /**
+   * UPF network elements, the SMF-UPF first
+   */
+  std::vector<Ptr<Node> > m_upfNodes;
+
+  /**
+   * TUN devices of the UPFs, the one of the SMF-UPF first
+   */
+  std::vector<Ptr<VirtualNetDevice> > m_upfTunDevices;
+
+  /**
+   * The node of each eNB, to link the UPFs added later to it
+   */
+  std::map<uint16_t, Ptr<Node> > m_enbNodeByCellId;
+
   /**
    * AMF network element
    */
@@ -155,6 +216,30 @@ private:
    */
   uint16_t m_gtpuUdpPort;
 
+  /**
+   * N9 interfaces
+   */
+
+  /** 
+   * helper to assign addresses to N9 NetDevices 
+   */
+  Ipv4AddressHelper m_n9Ipv4AddressHelper; 
+
+  /**
+   * The data rate to be used for the next N9 link to be created
+   */
+  DataRate m_n9LinkDataRate;
+
+  /**
+   * The delay to be used for the next N9 link to be created
+   */
+  Time     m_n9LinkDelay;
+
+  /**
+   * The MTU of the next N9 link to be created
+   */
+  uint16_t m_n9LinkMtu;
+
   /**
    * Map storing for each IMSI the corresponding eNB NetDevice
    */
@@ -103,6 +103,8 @@ NgcAmf::AddUe (uint64_t imsi)
   ueInfo->amfUeN2Id = imsi;
   m_ueInfoMap[imsi] = ueInfo;
   ueInfo->bearerCounter = 0;
+  ueInfo->amfN11Teid = 0;
+  ueInfo->smfN11Teid = 0;
 }
 
 uint8_t
@@ -132,9 +134,16 @@ NgcAmf::DoInitialUeMessage (uint64_t amfUeN2Id, uint16_t enbUeN2Id, uint64_t ims
   std::map<uint64_t, Ptr<UeInfo> >::iterator it = m_ueInfoMap.find (imsi);
   NS_ASSERT_MSG (it != m_ueInfoMap.end (), "could not find any UE with IMSI " << imsi);
   it->second->cellId = gci;
+  if (it->second->amfN11Teid == 0)
+    {
+      it->second->amfN11Teid = m_n11TeidAllocator.Allocate ();
+      m_ueInfoByN11Teid.Insert (it->second->amfN11Teid, it->second);
+    }
   NgcN11SapSmf::CreateSessionRequestMessage msg;
+  msg.teid = 0; // the SMF has no TEID for the session yet
   msg.imsi = imsi;
   msg.uli.gci = gci;
+  msg.senderCpFteid.teid = it->second->amfN11Teid;
   for (std::list<BearerInfo>::iterator bit = it->second->bearersToBeActivated.begin ();
        bit != it->second->bearersToBeActivated.end ();
        ++bit)
@@ -168,7 +177,7 @@ NgcAmf::DoPathSwitchRequest (uint64_t enbUeN2Id, uint64_t amfUeN2Id, uint16_t gc
   it->second->enbUeN2Id = enbUeN2Id;
 
   NgcN11SapSmf::ModifyBearerRequestMessage msg;
-  msg.teid = imsi; // trick to avoid the need for allocating TEIDs on the N11 interface
+  msg.teid = it->second->smfN11Teid;
   msg.uli.gci = gci;
   // bearer modification is not supported for now
   m_n11SapSmf->ModifyBearerRequest (msg);
@@ -181,7 +190,8 @@ void
 NgcAmf::DoCreateSessionResponse (NgcN11SapAmf::CreateSessionResponseMessage msg)
 {
   NS_LOG_FUNCTION (this << msg.teid);
-  uint64_t imsi = msg.teid;
+  Ptr<UeInfo> ueInfo = GetUeInfoByN11Teid (msg.teid);
+  ueInfo->smfN11Teid = msg.senderCpFteid.teid;
   std::list<NgcN2apSapEnb::ErabToBeSetupItem> erabToBeSetupList;
   for (std::list<NgcN11SapAmf::BearerContextCreated>::iterator bit = msg.bearerContextsCreated.begin ();
        bit != msg.bearerContextsCreated.end ();
@@ -194,11 +204,9 @@ NgcAmf::DoCreateSessionResponse (NgcN11SapAmf::CreateSessionResponseMessage msg)
       erab.smfTeid = bit->smfFteid.teid;      
       erabToBeSetupList.push_back (erab);
     }
-  std::map<uint64_t, Ptr<UeInfo> >::iterator it = m_ueInfoMap.find (imsi);
-  NS_ASSERT_MSG (it != m_ueInfoMap.end (), "could not find any UE with IMSI " << imsi);
-  uint16_t cellId = it->second->cellId;
-  uint16_t enbUeN2Id = it->second->enbUeN2Id;
-  uint64_t amfUeN2Id = it->second->amfUeN2Id;
+  uint16_t cellId = ueInfo->cellId;
+  uint16_t enbUeN2Id = ueInfo->enbUeN2Id;
+  uint64_t amfUeN2Id = ueInfo->amfUeN2Id;
   std::map<uint16_t, Ptr<EnbInfo> >::iterator jt = m_enbInfoMap.find (cellId);
   NS_ASSERT_MSG (jt != m_enbInfoMap.end (), "could not find any eNB with CellId " << cellId);
   jt->second->n2apSapEnb->InitialContextSetupRequest (amfUeN2Id, enbUeN2Id, erabToBeSetupList);
@@ -210,15 +218,13 @@ NgcAmf::DoModifyBearerResponse (NgcN11SapAmf::ModifyBearerResponseMessage msg)
 {
   NS_LOG_FUNCTION (this << msg.teid);
   NS_ASSERT (msg.cause == NgcN11SapAmf::ModifyBearerResponseMessage::REQUEST_ACCEPTED);
-  uint64_t imsi = msg.teid;
-  std::map<uint64_t, Ptr<UeInfo> >::iterator it = m_ueInfoMap.find (imsi);
-  NS_ASSERT_MSG (it != m_ueInfoMap.end (), "could not find any UE with IMSI " << imsi);
-  uint64_t enbUeN2Id = it->second->enbUeN2Id;
-  uint64_t amfUeN2Id = it->second->amfUeN2Id;
-  uint16_t cgi = it->second->cellId;
+  Ptr<UeInfo> ueInfo = GetUeInfoByN11Teid (msg.teid);
+  uint64_t enbUeN2Id = ueInfo->enbUeN2Id;
+  uint64_t amfUeN2Id = ueInfo->amfUeN2Id;
+  uint16_t cgi = ueInfo->cellId;
   std::list<NgcN2apSapEnb::ErabSwitchedInUplinkItem> erabToBeSwitchedInUplinkList; // unused for now
-  std::map<uint16_t, Ptr<EnbInfo> >::iterator jt = m_enbInfoMap.find (it->second->cellId);
-  NS_ASSERT_MSG (jt != m_enbInfoMap.end (), "could not find any eNB with CellId " << it->second->cellId);
+  std::map<uint16_t, Ptr<EnbInfo> >::iterator jt = m_enbInfoMap.find (ueInfo->cellId);
+  NS_ASSERT_MSG (jt != m_enbInfoMap.end (), "could not find any eNB with CellId " << ueInfo->cellId);
   jt->second->n2apSapEnb->PathSwitchRequestAcknowledge (enbUeN2Id, amfUeN2Id, cgi, erabToBeSwitchedInUplinkList);
 }
 
@@ -231,8 +237,7 @@ NgcAmf::DoErabReleaseIndication (uint64_t amfUeN2Id, uint16_t enbUeN2Id, std::li
   NS_ASSERT_MSG (it != m_ueInfoMap.end (), "could not find any UE with IMSI " << imsi);
 
   NgcN11SapSmf::DeleteBearerCommandMessage msg;
-  // trick to avoid the need for allocating TEIDs on the N11 interface
-  msg.teid = imsi;
+  msg.teid = it->second->smfN11Teid;
 
   for (std::list<NgcN2apSapAmf::ErabToBeReleasedIndication>::iterator bit = erabToBeReleaseIndication.begin (); bit != erabToBeReleaseIndication.end (); ++bit)
     {
@@ -248,12 +253,10 @@ void
 NgcAmf::DoDeleteBearerRequest (NgcN11SapAmf::DeleteBearerRequestMessage msg)
 {
   NS_LOG_FUNCTION (this);
-  uint64_t imsi = msg.teid;
-  std::map<uint64_t, Ptr<UeInfo> >::iterator it = m_ueInfoMap.find (imsi);
-  NS_ASSERT_MSG (it != m_ueInfoMap.end (), "could not find any UE with IMSI " << imsi);
+  Ptr<UeInfo> ueInfo = GetUeInfoByN11Teid (msg.teid);
   NgcN11SapSmf::DeleteBearerResponseMessage res;
 
-  res.teid = imsi;
+  res.teid = ueInfo->smfN11Teid;
 
   for (std::list<NgcN11SapAmf::BearerContextRemoved>::iterator bit = msg.bearerContextsRemoved.begin ();
        bit != msg.bearerContextsRemoved.end ();
@@ -263,10 +266,27 @@ NgcAmf::DoDeleteBearerRequest (NgcN11SapAmf::DeleteBearerRequestMessage msg)
       bearerContext.epsBearerId = bit->epsBearerId;
       res.bearerContextsRemoved.push_back (bearerContext);
 
-      RemoveBearer (it->second, bearerContext.epsBearerId); //schedules function to erase, context of de-activated bearer
+      RemoveBearer (ueInfo, bearerContext.epsBearerId); //schedules function to erase, context of de-activated bearer
     }
   //schedules Delete Bearer Response towards ngc-smf-upf-application
   m_n11SapSmf->DeleteBearerResponse (res);
+
+  // the session ends with its last bearer
+  if (ueInfo->bearersToBeActivated.empty ())
+    {
+      m_ueInfoByN11Teid.Erase (ueInfo->amfN11Teid);
+      m_n11TeidAllocator.Release (ueInfo->amfN11Teid);
+      ueInfo->amfN11Teid = 0;
+      ueInfo->smfN11Teid = 0;
+    }
+}
+
+Ptr<NgcAmf::UeInfo>
+NgcAmf::GetUeInfoByN11Teid (uint32_t teid)
+{
+  Ptr<UeInfo> *ueInfo = m_ueInfoByN11Teid.Find (teid);
+  NS_ASSERT_MSG (ueInfo != 0, "unknown N11 TEID " << teid);
+  return *ueInfo;
 }
 
 void NgcAmf::RemoveBearer (Ptr<UeInfo> ueInfo, uint8_t epsBearerId)
@@ -24,6 +24,7 @@
 #include <ns3/object.h>
 #include <ns3/ngc-n2ap-sap.h>
 #include <ns3/ngc-n11-sap.h>
+#include <ns3/ngc-teid-allocator.h>
 
 #include <map>
 #include <list>
@@ -146,6 +147,8 @@ private:
     uint16_t cellId;
     std::list<BearerInfo> bearersToBeActivated;
     uint16_t bearerCounter;
+    uint32_t amfN11Teid; ///< TEID of the session on the AMF side of N11, 0 if none
+    uint32_t smfN11Teid; ///< TEID of the session on the SMF side of N11
   };
 
   /**
@@ -154,6 +157,22 @@ private:
    */  
   std::map<uint64_t, Ptr<UeInfo> > m_ueInfoMap;
 
+  /**
+   * Pool of the N11 TEIDs of the sessions on the AMF side
+   */
+  NgcTeidAllocator m_n11TeidAllocator;
+
+  /**
+   * UeInfo stored by N11 TEID on the AMF side
+   */
+  NgcTeidTable<Ptr<UeInfo> > m_ueInfoByN11Teid;
+
+  /**
+   * \param teid the TEID of a session on the AMF side of N11
+   * \return the UE of the session
+   */
+  Ptr<UeInfo> GetUeInfoByN11Teid (uint32_t teid);
+
   /**
    * \brief This Function erases all contexts of bearer from AMF side
    * \param ueInfo UE information pointer
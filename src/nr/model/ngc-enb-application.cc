@@ -188,7 +188,8 @@ NgcEnbApplication::DoPathSwitchRequest (NgcEnbN2SapProvider::PathSwitchRequestPa
       EpsFlowId_t rbid (params.rnti, bit->epsBearerId);
       // side effect: create entries if not exist
       m_rbidTeidMap[params.rnti][bit->epsBearerId] = teid;
-      m_teidRbidMap[teid] = rbid;
+      m_teidRbidMap.Insert (teid, rbid);
+      m_upfAddrByTeid.Insert (teid, bit->transportLayerAddress);
 
       NgcN2apSapAmf::ErabSwitchedInDownlinkItem erab;
       erab.erabId = bit->epsBearerId;
@@ -226,7 +227,7 @@ NgcEnbApplication::DoPathSwitchRequest (NgcEnbN2SapProvider::PathSwitchRequestPa
       EpsFlowId_t rbid (params.rnti, bit->epsBearerId);
       // side effect: create entries if not exist
       m_rbidTeidMap[params.rnti][bit->epsBearerId] = teid;
-      m_teidRbidMap[teid] = rbid;
+      m_teidRbidMap.Insert (teid, rbid);
 
       NgcN2apSapAmf::ErabSwitchedInDownlinkItem erab;
       erab.erabId = bit->epsBearerId;
@@ -250,7 +251,8 @@ NgcEnbApplication::DoUeContextRelease (uint16_t rnti)
            ++bidIt)
         {
           uint32_t teid = bidIt->second;
-          m_teidRbidMap.erase (teid);
+          m_teidRbidMap.Erase (teid);
+          m_upfAddrByTeid.Erase (teid);
         }
       m_rbidTeidMap.erase (rntiIt);
     }
@@ -277,12 +279,15 @@ NgcEnbApplication::DoInitialContextSetupRequest (uint64_t amfUeN2Id, uint16_t en
       params.bearer = erabIt->erabLevelQosParameters;
       params.bearerId = erabIt->erabId;
       params.gtpTeid = erabIt->smfTeid;
+      params.transportLayerAddress = erabIt->transportLayerAddress;
       m_n2SapUser->DataRadioBearerSetupRequest (params);
 
       EpsFlowId_t rbid (rnti, erabIt->erabId);
       // side effect: create entries if not exist
       m_rbidTeidMap[rnti][erabIt->erabId] = params.gtpTeid;
-      m_teidRbidMap[params.gtpTeid] = rbid;
+      m_teidRbidMap.Insert (params.gtpTeid, rbid);
+      // the uplink of the bearer goes to the UPF selected by the SMF
+      m_upfAddrByTeid.Insert (params.gtpTeid, erabIt->transportLayerAddress);
 
     }
 }
@@ -348,10 +353,10 @@ NgcEnbApplication::RecvFromN2uSocket (Ptr<Socket> socket)
   //SocketAddressTag tag;
   //packet->RemovePacketTag (tag);
 
-  std::map<uint32_t, EpsFlowId_t>::iterator it = m_teidRbidMap.find (teid);
-  if (it != m_teidRbidMap.end ())
+  EpsFlowId_t *rbid = m_teidRbidMap.Find (teid);
+  if (rbid != 0)
     {
-      SendToNrSocket (packet, it->second.m_rnti, it->second.m_bid);
+      SendToNrSocket (packet, rbid->m_rnti, rbid->m_bid);
     }
   else
     {
@@ -381,8 +386,9 @@ NgcEnbApplication::SendToN2uSocket (Ptr<Packet> packet, uint32_t teid)
   // Length of the payload + the non obligatory GTP-U header
   gtpu.SetLength (packet->GetSize () + gtpu.GetSerializedSize () - 8);  
   packet->AddHeader (gtpu);
+  Ipv4Address *upfAddr = m_upfAddrByTeid.Find (teid);
   uint32_t flags = 0;
-  m_n2uSocket->SendTo (packet, flags, InetSocketAddress (m_smfN2uAddress, m_gtpuUdpPort));
+  m_n2uSocket->SendTo (packet, flags, InetSocketAddress (upfAddr ? *upfAddr : m_smfN2uAddress, m_gtpuUdpPort));
 }
 
 void
@@ -38,6 +38,7 @@
 #include <ns3/eps-bearer.h>
 #include <ns3/ngc-enb-n2-sap.h>
 #include <ns3/ngc-n2ap-sap.h>
+#include <ns3/ngc-teid-allocator.h>
 #include <map>
 
 namespace ns3 {
@@ -213,7 +214,8 @@ private:
   Ipv4Address m_enbN2uAddress;
 
   /**
-   * address of the SMF which terminates all N2-U tunnels
+   * address of the SMF which terminates the N2-U tunnels without a UPF
+   * address of their own
    */
   Ipv4Address m_smfN2uAddress;
 
@@ -224,10 +226,16 @@ private:
   std::map<uint16_t, std::map<uint8_t, uint32_t> > m_rbidTeidMap;  
 
   /**
-   * map telling for each N2-U TEID the corresponding RNTI,BID
+   * table telling for each N2-U TEID the corresponding RNTI,BID
    * 
    */
-  std::map<uint32_t, EpsFlowId_t> m_teidRbidMap;
+  NgcTeidTable<EpsFlowId_t> m_teidRbidMap;
+
+  /**
+   * table telling for each N2-U TEID the address of the UPF terminating
+   * the tunnel
+   */
+  NgcTeidTable<Ipv4Address> m_upfAddrByTeid;
  
   /**
    * UDP port to be used for GTP
@@ -65,6 +65,7 @@ public:
   {
     uint8_t epsBearerId;
     uint32_t teid;
+    Ipv4Address transportLayerAddress; /**< IP Address of the UPF of the bearer */
   };
   
   struct PathSwitchRequestParameters
@@ -92,6 +92,7 @@ public:
    */
   struct CreateSessionResponseMessage : public GtpcMessage
   {
+    NgcN11Sap::Fteid senderCpFteid; ///< the N11 F-TEID of the SMF for the session
     std::list<BearerContextCreated> bearerContextsCreated;
   };
 
@@ -173,6 +174,7 @@ public:
   {
     uint64_t imsi; 
     Uli uli; 
+    NgcN11Sap::Fteid senderCpFteid; ///< the N11 F-TEID of the AMF for the session
     std::list<BearerContextToBeCreated> bearerContextsToBeCreated;    
   };
 
@@ -31,6 +31,9 @@
 #include "ns3/inet-socket-address.h"
 #include "ns3/ngc-gtpu-header.h"
 #include "ns3/abort.h"
+#include "ns3/enum.h"
+#include "ns3/udp-l4-protocol.h"
+#include "ns3/tcp-l4-protocol.h"
 
 namespace ns3 {
 
@@ -42,8 +45,12 @@ NS_LOG_COMPONENT_DEFINE ("NgcSmfUpfApplication");
 
 
 NgcSmfUpfApplication::UeInfo::UeInfo ()
+  : m_smfN11Teid (0),
+    m_amfN11Teid (0),
+    m_upfIndex (0)
 {
   NS_LOG_FUNCTION (this);
+  FlushFlowCache ();
 }
 
 void
@@ -51,24 +58,62 @@ NgcSmfUpfApplication::UeInfo::AddBearer (Ptr<NgcTft> tft, uint8_t bearerId, uint
 {
   NS_LOG_FUNCTION (this << tft << teid);
   m_teidByBearerIdMap[bearerId] = teid;
+  FlushFlowCache ();
   return m_tftClassifier.Add (tft, teid);
 }
 
-void
+uint32_t
 NgcSmfUpfApplication::UeInfo::RemoveBearer (uint8_t bearerId)
 {
   NS_LOG_FUNCTION (this << bearerId);
-  m_teidByBearerIdMap.erase (bearerId);
+  std::map<uint8_t, uint32_t>::iterator it = m_teidByBearerIdMap.find (bearerId);
+  if (it == m_teidByBearerIdMap.end ())
+    {
+      return 0;
+    }
+  uint32_t teid = it->second;
+  m_teidByBearerIdMap.erase (it);
+  // the TEID may be reused by another bearer
+  m_tftClassifier.Delete (teid);
+  FlushFlowCache ();
+  return teid;
+}
+
+bool
+NgcSmfUpfApplication::UeInfo::HasBearers () const
+{
+  return !m_teidByBearerIdMap.empty ();
 }
 
 uint32_t
-NgcSmfUpfApplication::UeInfo::Classify (Ptr<Packet> p)
+NgcSmfUpfApplication::UeInfo::Classify (const NgcTftClassifier::FiveTuple &tuple)
 {
-  NS_LOG_FUNCTION (this << p);
+  NS_LOG_FUNCTION (this);
   // we hardcode DOWNLINK direction since the UPF is espected to
   // classify only downlink packets (uplink packets will go to the
   // internet without any classification). 
-  return m_tftClassifier.Classify (p, NgcTft::DOWNLINK);
+  uint32_t hash = tuple.source ^ tuple.destination
+    ^ ((uint32_t) tuple.sourcePort << 16 | tuple.destinationPort) ^ ((uint32_t) tuple.protocol << 8 | tuple.tos);
+  FlowCacheEntry &entry = m_flowCache[((hash * 2654435761u) >> 16) % FLOW_CACHE_SIZE];
+  if (entry.valid && entry.tuple == tuple)
+    {
+      NS_LOG_LOGIC ("flow cache hit, TEID " << entry.teid);
+      return entry.teid;
+    }
+
+  entry.tuple = tuple;
+  entry.valid = true;
+  entry.teid = m_tftClassifier.Classify (tuple, NgcTft::DOWNLINK);
+  return entry.teid;
+}
+
+void
+NgcSmfUpfApplication::UeInfo::FlushFlowCache ()
+{
+  for (uint32_t i = 0; i < FLOW_CACHE_SIZE; i++)
+    {
+      m_flowCache[i].valid = false;
+    }
 }
 
 Ipv4Address 
@@ -95,6 +140,42 @@ NgcSmfUpfApplication::UeInfo::SetUeAddr (Ipv4Address ueAddr)
   m_ueAddr = ueAddr;
 }
 
+uint32_t
+NgcSmfUpfApplication::UeInfo::GetSmfN11Teid () const
+{
+  return m_smfN11Teid;
+}
+
+void
+NgcSmfUpfApplication::UeInfo::SetSmfN11Teid (uint32_t teid)
+{
+  m_smfN11Teid = teid;
+}
+
+uint32_t
+NgcSmfUpfApplication::UeInfo::GetAmfN11Teid () const
+{
+  return m_amfN11Teid;
+}
+
+void
+NgcSmfUpfApplication::UeInfo::SetAmfN11Teid (uint32_t teid)
+{
+  m_amfN11Teid = teid;
+}
+
+uint32_t
+NgcSmfUpfApplication::UeInfo::GetUpfIndex () const
+{
+  return m_upfIndex;
+}
+
+void
+NgcSmfUpfApplication::UeInfo::SetUpfIndex (uint32_t upfIndex)
+{
+  m_upfIndex = upfIndex;
+}
+
 /////////////////////////
 // NgcSmfUpfApplication
 /////////////////////////
@@ -105,7 +186,15 @@ NgcSmfUpfApplication::GetTypeId (void)
 {
   static TypeId tid = TypeId ("ns3::NgcSmfUpfApplication")
     .SetParent<Object> ()
-    .SetGroupName("Nr");
+    .SetGroupName("Nr")
+    .AddAttribute ("UpfSelectionPolicy",
+                   "How the SMF selects the UPF of a new PDU session",
+                   EnumValue (NgcSmfUpfApplication::ROUND_ROBIN),
+                   MakeEnumAccessor (&NgcSmfUpfApplication::m_upfSelectionPolicy),
+                   MakeEnumChecker (NgcSmfUpfApplication::ROUND_ROBIN, "RoundRobin",
+                                    NgcSmfUpfApplication::LEAST_LOADED, "LeastLoaded",
+                                    NgcSmfUpfApplication::LOCAL, "Local"))
+  ;
   return tid;
 }
 
@@ -113,22 +202,29 @@ void
 NgcSmfUpfApplication::DoDispose ()
 {
   NS_LOG_FUNCTION (this);
-  m_n2uSocket->SetRecvCallback (MakeNullCallback<void, Ptr<Socket> > ());
-  m_n2uSocket = 0;
+  for (std::vector<UpfInfo>::iterator it = m_upfs.begin (); it != m_upfs.end (); ++it)
+    {
+      it->n2uSocket->SetRecvCallback (MakeNullCallback<void, Ptr<Socket> > ());
+    }
+  m_upfs.clear ();
   delete (m_n11SapSmf);
 }
 
   
 
 NgcSmfUpfApplication::NgcSmfUpfApplication (const Ptr<VirtualNetDevice> tunDevice, const Ptr<Socket> n2uSocket)
-  : m_n2uSocket (n2uSocket),
-    m_tunDevice (tunDevice),
-    m_gtpuUdpPort (2152), // fixed by the standard
-    m_teidCount (0),
-    m_n11SapAmf (0)
+  : m_gtpuUdpPort (2152), // fixed by the standard
+    m_n11SapAmf (0),
+    m_upfSelectionPolicy (ROUND_ROBIN),
+    m_nextUpf (0)
 {
   NS_LOG_FUNCTION (this << tunDevice << n2uSocket);
-  m_n2uSocket->SetRecvCallback (MakeCallback (&NgcSmfUpfApplication::RecvFromN2uSocket, this));
+  UpfInfo upf;
+  upf.tunDevice = tunDevice;
+  upf.n2uSocket = n2uSocket;
+  upf.nSessions = 0;
+  m_upfs.push_back (upf);
+  n2uSocket->SetRecvCallback (MakeCallback (&NgcSmfUpfApplication::RecvFromN2uSocket, this));
   m_n11SapSmf = new MemberNgcN11SapSmf<NgcSmfUpfApplication> (this);
 }
 
@@ -144,12 +240,17 @@ NgcSmfUpfApplication::RecvFromTunDevice (Ptr<Packet> packet, const Address& sour
 {
   NS_LOG_FUNCTION (this << source << dest << packet << packet->GetSize ());
 
-  // get IP address of UE
-  Ptr<Packet> pCopy = packet->Copy ();
-  Ipv4Header ipv4Header;
-  pCopy->RemoveHeader (ipv4Header);
-  Ipv4Address ueAddr =  ipv4Header.GetDestination ();
+  // get IP address of UE, reading the headers in place once for the
+  // lookup of the UE and the classification
+  NgcTftClassifier::FiveTuple tuple;
+  if (!NgcTftClassifier::ReadFiveTuple (packet, tuple))
+    {
+      NS_LOG_WARN ("packet too short for its IPv4 and transport headers");
+      return true;
+    }
+  Ipv4Address ueAddr (tuple.destination);
   NS_LOG_LOGIC ("packet addressed to UE " << ueAddr);
+  uint32_t upfIndex = GetUpfIndexByTunAddress (source);
 
   // find corresponding UeInfo address
   std::map<Ipv4Address, Ptr<UeInfo> >::iterator it = m_ueInfoByAddrMap.find (ueAddr);
@@ -159,15 +260,21 @@ NgcSmfUpfApplication::RecvFromTunDevice (Ptr<Packet> packet, const Address& sour
     }
   else
     {
-      Ipv4Address enbAddr = it->second->GetEnbAddr ();      
-      uint32_t teid = it->second->Classify (packet);   
+      uint32_t teid = it->second->Classify (tuple);
       if (teid == 0)
         {
           NS_LOG_WARN ("no matching bearer for this packet");                   
         }
+      else if (it->second->GetUpfIndex () == upfIndex)
+        {
+          SendGtpu (upfIndex, packet, it->second->GetEnbAddr (), teid);
+        }
       else
         {
-          SendToN2uSocket (packet, enbAddr, teid);
+          // the anchor of the UE forwards the packet to the eNB
+          uint32_t anchor = it->second->GetUpfIndex ();
+          NS_LOG_LOGIC ("forwarding to UPF " << anchor << " over N9");
+          SendGtpu (upfIndex, packet, GetN9Address (upfIndex, anchor), teid);
         }
     }
   // there is no reason why we should notify the TUN
@@ -181,8 +288,9 @@ void
 NgcSmfUpfApplication::RecvFromN2uSocket (Ptr<Socket> socket)
 {
   NS_LOG_FUNCTION (this << socket);  
-  NS_ASSERT (socket == m_n2uSocket);
-  Ptr<Packet> packet = socket->Recv ();
+  uint32_t upfIndex = GetUpfIndexBySocket (socket);
+  Address from;
+  Ptr<Packet> packet = socket->RecvFrom (from);
   NrGtpuHeader gtpu;
   packet->RemoveHeader (gtpu);
   uint32_t teid = gtpu.GetTeid ();
@@ -192,6 +300,22 @@ NgcSmfUpfApplication::RecvFromN2uSocket (Ptr<Socket> socket)
   //SocketAddressTag tag;
   //packet->RemovePacketTag (tag);
 
+  BearerRef *bearer = m_bearerByTeid.Find (teid);
+  if (m_n9Addrs.find (InetSocketAddress::ConvertFrom (from).GetIpv4 ()) != m_n9Addrs.end ())
+    {
+      // a downlink packet forwarded by another UPF to the anchor of the UE
+      if (bearer == 0)
+        {
+          NS_LOG_WARN ("unknown TEID " << teid << " on N9");
+          return;
+        }
+      SendGtpu (upfIndex, packet, bearer->ueInfo->GetEnbAddr (), teid);
+      return;
+    }
+  if (bearer == 0)
+    {
+      NS_LOG_WARN ("unknown TEID " << teid);
+    }
   SendToTunDevice (packet, teid);
 }
 
@@ -200,13 +324,23 @@ NgcSmfUpfApplication::SendToTunDevice (Ptr<Packet> packet, uint32_t teid)
 {
   NS_LOG_FUNCTION (this << packet << teid);
   NS_LOG_LOGIC (" packet size: " << packet->GetSize () << " bytes");
-  m_tunDevice->Receive (packet, 0x0800, m_tunDevice->GetAddress (), m_tunDevice->GetAddress (), NetDevice::PACKET_HOST);
+  BearerRef *bearer = m_bearerByTeid.Find (teid);
+  Ptr<VirtualNetDevice> tunDevice = m_upfs[bearer ? bearer->ueInfo->GetUpfIndex () : 0].tunDevice;
+  tunDevice->Receive (packet, 0x0800, tunDevice->GetAddress (), tunDevice->GetAddress (), NetDevice::PACKET_HOST);
 }
 
 void 
 NgcSmfUpfApplication::SendToN2uSocket (Ptr<Packet> packet, Ipv4Address enbAddr, uint32_t teid)
 {
   NS_LOG_FUNCTION (this << packet << enbAddr << teid);
+  BearerRef *bearer = m_bearerByTeid.Find (teid);
+  SendGtpu (bearer ? bearer->ueInfo->GetUpfIndex () : 0, packet, enbAddr, teid);
+}
+
+void
+NgcSmfUpfApplication::SendGtpu (uint32_t upfIndex, Ptr<Packet> packet, Ipv4Address addr, uint32_t teid)
+{
+  NS_LOG_FUNCTION (this << upfIndex << packet << addr << teid);
 
   NrGtpuHeader gtpu;
   gtpu.SetTeid (teid);
@@ -215,7 +349,48 @@ NgcSmfUpfApplication::SendToN2uSocket (Ptr<Packet> packet, Ipv4Address enbAddr,
   gtpu.SetLength (packet->GetSize () + gtpu.GetSerializedSize () - 8);  
   packet->AddHeader (gtpu);
   uint32_t flags = 0;
-  m_n2uSocket->SendTo (packet, flags, InetSocketAddress (enbAddr, m_gtpuUdpPort));
+  m_upfs[upfIndex].n2uSocket->SendTo (packet, flags, InetSocketAddress (addr, m_gtpuUdpPort));
+}
+
+uint32_t
+NgcSmfUpfApplication::GetUpfIndexByTunAddress (const Address &source) const
+{
+  if (m_upfs.size () == 1)
+    {
+      return 0;
+    }
+  for (uint32_t i = 0; i < m_upfs.size (); i++)
+    {
+      if (m_upfs[i].tunDevice->GetAddress () == source)
+        {
+          return i;
+        }
+    }
+  NS_FATAL_ERROR ("unknown TUN device " << source);
+  return 0;
+}
+
+uint32_t
+NgcSmfUpfApplication::GetUpfIndexBySocket (Ptr<Socket> socket) const
+{
+  for (uint32_t i = 0; i < m_upfs.size (); i++)
+    {
+      if (m_upfs[i].n2uSocket == socket)
+        {
+          return i;
+        }
+    }
+  NS_FATAL_ERROR ("unknown GTP-U socket " << socket);
+  return 0;
+}
+
+Ipv4Address
+NgcSmfUpfApplication::GetN9Address (uint32_t from, uint32_t to) const
+{
+  NS_ASSERT (from != to);
+  // UPF 0 is reached on the N9 link of the sender, the other UPFs on
+  // their own N9 link, through UPF 0 if need be
+  return (to == 0) ? m_upfs[from].centralN9Addr : m_upfs[to].n9Addr;
 }
 
 
@@ -231,14 +406,47 @@ NgcSmfUpfApplication::GetN11SapSmf ()
   return m_n11SapSmf;
 }
 
+uint32_t
+NgcSmfUpfApplication::AddUpf (const Ptr<VirtualNetDevice> tunDevice, const Ptr<Socket> n2uSocket,
+                              Ipv4Address n9Addr, Ipv4Address centralN9Addr)
+{
+  NS_LOG_FUNCTION (this << tunDevice << n2uSocket << n9Addr << centralN9Addr);
+  UpfInfo upf;
+  upf.tunDevice = tunDevice;
+  upf.n2uSocket = n2uSocket;
+  upf.n9Addr = n9Addr;
+  upf.centralN9Addr = centralN9Addr;
+  upf.nSessions = 0;
+  m_upfs.push_back (upf);
+  m_n9Addrs.insert (n9Addr);
+  m_n9Addrs.insert (centralN9Addr);
+  n2uSocket->SetRecvCallback (MakeCallback (&NgcSmfUpfApplication::RecvFromN2uSocket, this));
+  return m_upfs.size () - 1;
+}
+
+uint32_t
+NgcSmfUpfApplication::GetNUpfs () const
+{
+  return m_upfs.size ();
+}
+
 void 
-NgcSmfUpfApplication::AddEnb (uint16_t cellId, Ipv4Address enbAddr, Ipv4Address smfAddr)
+NgcSmfUpfApplication::AddEnb (uint16_t cellId, Ipv4Address enbAddr, Ipv4Address smfAddr, uint32_t upfIndex)
 {
-  NS_LOG_FUNCTION (this << cellId << enbAddr << smfAddr);
+  NS_LOG_FUNCTION (this << cellId << enbAddr << smfAddr << upfIndex);
+  NS_ASSERT_MSG (upfIndex < m_upfs.size (), "unknown UPF " << upfIndex);
   EnbInfo enbInfo;
   enbInfo.enbAddr = enbAddr;
   enbInfo.smfAddr = smfAddr;
-  m_enbInfoByCellId[cellId] = enbInfo;
+  m_upfs[upfIndex].enbInfoByCellId[cellId] = enbInfo;
+}
+
+void
+NgcSmfUpfApplication::SetLocalUpf (uint16_t cellId, uint32_t upfIndex)
+{
+  NS_LOG_FUNCTION (this << cellId << upfIndex);
+  NS_ASSERT_MSG (upfIndex < m_upfs.size (), "unknown UPF " << upfIndex);
+  m_localUpfByCellId[cellId] = upfIndex;
 }
 
 void 
@@ -266,24 +474,43 @@ NgcSmfUpfApplication::DoCreateSessionRequest (NgcN11SapSmf::CreateSessionRequest
   std::map<uint64_t, Ptr<UeInfo> >::iterator ueit = m_ueInfoByImsiMap.find (req.imsi);
   NS_ASSERT_MSG (ueit != m_ueInfoByImsiMap.end (), "unknown IMSI " << req.imsi); 
   uint16_t cellId = req.uli.gci;
-  std::map<uint16_t, EnbInfo>::iterator enbit = m_enbInfoByCellId.find (cellId);
-  NS_ASSERT_MSG (enbit != m_enbInfoByCellId.end (), "unknown CellId " << cellId); 
-  Ipv4Address enbAddr = enbit->second.enbAddr;
-  ueit->second->SetEnbAddr (enbAddr);
+  Ptr<UeInfo> ueInfo = ueit->second;
+  if (ueInfo->GetSmfN11Teid () == 0)
+    {
+      uint32_t n11Teid = m_n11TeidAllocator.Allocate ();
+      ueInfo->SetSmfN11Teid (n11Teid);
+      m_ueInfoByN11Teid.Insert (n11Teid, ueInfo);
+      // the UPF anchors the session until its last bearer is removed
+      uint32_t upfIndex = SelectUpf (cellId);
+      NS_LOG_INFO ("IMSI " << req.imsi << " in cell " << cellId << " anchored at UPF " << upfIndex);
+      ueInfo->SetUpfIndex (upfIndex);
+      m_upfs[upfIndex].nSessions++;
+    }
+  ueInfo->SetAmfN11Teid (req.senderCpFteid.teid);
+
+  UpfInfo &upf = m_upfs[ueInfo->GetUpfIndex ()];
+  std::map<uint16_t, EnbInfo>::iterator enbit = upf.enbInfoByCellId.find (cellId);
+  NS_ASSERT_MSG (enbit != upf.enbInfoByCellId.end (),
+                 "unknown CellId " << cellId << " at UPF " << ueInfo->GetUpfIndex ()); 
+  ueInfo->SetEnbAddr (enbit->second.enbAddr);
 
   NgcN11SapAmf::CreateSessionResponseMessage res;
-  res.teid = req.imsi; // trick to avoid the need for allocating TEIDs on the N11 interface
+  res.teid = ueInfo->GetAmfN11Teid ();
+  res.senderCpFteid.teid = ueInfo->GetSmfN11Teid ();
+  res.senderCpFteid.address = enbit->second.smfAddr;
 
   for (std::list<NgcN11SapSmf::BearerContextToBeCreated>::iterator bit = req.bearerContextsToBeCreated.begin ();
        bit != req.bearerContextsToBeCreated.end ();
        ++bit)
     {
-      // simple sanity check. If you ever need more than 4M teids
-      // throughout your simulation, you'll need to implement a smarter teid
-      // management algorithm. 
-      NS_ABORT_IF (m_teidCount == 0xFFFFFFFF);
-      uint32_t teid = ++m_teidCount;  
-      ueit->second->AddBearer (bit->tft, bit->epsBearerId, teid);
+      // a bearer set up again replaces the previous one
+      ReleaseBearerTeid (ueInfo->RemoveBearer (bit->epsBearerId));
+      uint32_t teid = m_teidAllocator.Allocate ();
+      ueInfo->AddBearer (bit->tft, bit->epsBearerId, teid);
+      BearerRef bearer;
+      bearer.ueInfo = ueInfo;
+      bearer.bearerId = bit->epsBearerId;
+      m_bearerByTeid.Insert (teid, bearer);
 
       NgcN11SapAmf::BearerContextCreated bearerContext;
       bearerContext.smfFteid.teid = teid;
@@ -301,17 +528,18 @@ void
 NgcSmfUpfApplication::DoModifyBearerRequest (NgcN11SapSmf::ModifyBearerRequestMessage req)
 {
   NS_LOG_FUNCTION (this << req.teid);
-  uint64_t imsi = req.teid; // trick to avoid the need for allocating TEIDs on the N11 interface
-  std::map<uint64_t, Ptr<UeInfo> >::iterator ueit = m_ueInfoByImsiMap.find (imsi);
-  NS_ASSERT_MSG (ueit != m_ueInfoByImsiMap.end (), "unknown IMSI " << imsi); 
+  Ptr<UeInfo> ueInfo = GetUeInfoByN11Teid (req.teid);
   uint16_t cellId = req.uli.gci;
-  std::map<uint16_t, EnbInfo>::iterator enbit = m_enbInfoByCellId.find (cellId);
-  NS_ASSERT_MSG (enbit != m_enbInfoByCellId.end (), "unknown CellId " << cellId); 
+  // the session keeps its UPF across handovers
+  UpfInfo &upf = m_upfs[ueInfo->GetUpfIndex ()];
+  std::map<uint16_t, EnbInfo>::iterator enbit = upf.enbInfoByCellId.find (cellId);
+  NS_ASSERT_MSG (enbit != upf.enbInfoByCellId.end (),
+                 "unknown CellId " << cellId << " at UPF " << ueInfo->GetUpfIndex ()); 
   Ipv4Address enbAddr = enbit->second.enbAddr;
-  ueit->second->SetEnbAddr (enbAddr);
+  ueInfo->SetEnbAddr (enbAddr);
   // no actual bearer modification: for now we just support the minimum needed for path switch request (handover)
   NgcN11SapAmf::ModifyBearerResponseMessage res;
-  res.teid = imsi; // trick to avoid the need for allocating TEIDs on the N11 interface
+  res.teid = ueInfo->GetAmfN11Teid ();
   res.cause = NgcN11SapAmf::ModifyBearerResponseMessage::REQUEST_ACCEPTED;
   m_n11SapAmf->ModifyBearerResponse (res);
 }
@@ -320,12 +548,10 @@ void
 NgcSmfUpfApplication::DoDeleteBearerCommand (NgcN11SapSmf::DeleteBearerCommandMessage req)
 {
   NS_LOG_FUNCTION (this << req.teid);
-  uint64_t imsi = req.teid; // trick to avoid the need for allocating TEIDs on the N11 interface
-  std::map<uint64_t, Ptr<UeInfo> >::iterator ueit = m_ueInfoByImsiMap.find (imsi);
-  NS_ASSERT_MSG (ueit != m_ueInfoByImsiMap.end (), "unknown IMSI " << imsi);
+  Ptr<UeInfo> ueInfo = GetUeInfoByN11Teid (req.teid);
 
   NgcN11SapAmf::DeleteBearerRequestMessage res;
-  res.teid = imsi;
+  res.teid = ueInfo->GetAmfN11Teid ();
 
   for (std::list<NgcN11SapSmf::BearerContextToBeRemoved>::iterator bit = req.bearerContextsToBeRemoved.begin ();
        bit != req.bearerContextsToBeRemoved.end ();
@@ -343,17 +569,104 @@ void
 NgcSmfUpfApplication::DoDeleteBearerResponse (NgcN11SapSmf::DeleteBearerResponseMessage req)
 {
   NS_LOG_FUNCTION (this << req.teid);
-  uint64_t imsi = req.teid; // trick to avoid the need for allocating TEIDs on the N11 interface
-  std::map<uint64_t, Ptr<UeInfo> >::iterator ueit = m_ueInfoByImsiMap.find (imsi);
-  NS_ASSERT_MSG (ueit != m_ueInfoByImsiMap.end (), "unknown IMSI " << imsi);
+  Ptr<UeInfo> ueInfo = GetUeInfoByN11Teid (req.teid);
 
   for (std::list<NgcN11SapSmf::BearerContextRemovedSmfUpf>::iterator bit = req.bearerContextsRemoved.begin ();
        bit != req.bearerContextsRemoved.end ();
        ++bit)
     {
       //Function to remove de-activated bearer contexts from S-Gw and P-Gw side
-      ueit->second->RemoveBearer (bit->epsBearerId);
+      ReleaseBearerTeid (ueInfo->RemoveBearer (bit->epsBearerId));
     }
+
+  // the session ends with its last bearer
+  if (!ueInfo->HasBearers ())
+    {
+      NS_LOG_LOGIC ("releasing N11 TEID " << ueInfo->GetSmfN11Teid ());
+      m_ueInfoByN11Teid.Erase (ueInfo->GetSmfN11Teid ());
+      m_n11TeidAllocator.Release (ueInfo->GetSmfN11Teid ());
+      ueInfo->SetSmfN11Teid (0);
+      m_upfs[ueInfo->GetUpfIndex ()].nSessions--;
+    }
+}
+
+uint32_t
+NgcSmfUpfApplication::SelectUpf (uint16_t cellId)
+{
+  NS_LOG_FUNCTION (this << cellId);
+  switch (m_upfSelectionPolicy)
+    {
+    case ROUND_ROBIN:
+      {
+        uint32_t upfIndex = m_nextUpf;
+        m_nextUpf = (m_nextUpf + 1) % m_upfs.size ();
+        return upfIndex;
+      }
+    case LEAST_LOADED:
+      {
+        uint32_t upfIndex = 0;
+        for (uint32_t i = 1; i < m_upfs.size (); i++)
+          {
+            if (m_upfs[i].nSessions < m_upfs[upfIndex].nSessions)
+              {
+                upfIndex = i;
+              }
+          }
+        return upfIndex;
+      }
+    case LOCAL:
+      {
+        std::map<uint16_t, uint32_t>::const_iterator it = m_localUpfByCellId.find (cellId);
+        return (it == m_localUpfByCellId.end ()) ? 0 : it->second;
+      }
+    default:
+      NS_FATAL_ERROR ("unknown UPF selection policy " << m_upfSelectionPolicy);
+      return 0;
+    }
+}
+
+void
+NgcSmfUpfApplication::ReleaseBearerTeid (uint32_t teid)
+{
+  if (teid != 0)
+    {
+      m_bearerByTeid.Erase (teid);
+      m_teidAllocator.Release (teid);
+    }
+}
+
+Ptr<NgcSmfUpfApplication::UeInfo>
+NgcSmfUpfApplication::GetUeInfoByN11Teid (uint32_t teid)
+{
+  Ptr<UeInfo> *ueInfo = m_ueInfoByN11Teid.Find (teid);
+  NS_ASSERT_MSG (ueInfo != 0, "unknown N11 TEID " << teid);
+  return *ueInfo;
+}
+
+uint32_t
+NgcSmfUpfApplication::GetNSessions () const
+{
+  return m_ueInfoByN11Teid.GetSize ();
+}
+
+uint32_t
+NgcSmfUpfApplication::GetNSessions (uint32_t upfIndex) const
+{
+  NS_ASSERT_MSG (upfIndex < m_upfs.size (), "unknown UPF " << upfIndex);
+  return m_upfs[upfIndex].nSessions;
+}
+
+uint32_t
+NgcSmfUpfApplication::GetNBearers () const
+{
+  return m_teidAllocator.GetNAllocated ();
+}
+
+uint64_t
+NgcSmfUpfApplication::GetTeidMemoryUsage () const
+{
+  return m_teidAllocator.GetMemoryUsage () + m_n11TeidAllocator.GetMemoryUsage ()
+    + m_bearerByTeid.GetMemoryUsage () + m_ueInfoByN11Teid.GetMemoryUsage ();
 }
 
 }  // namespace ns3
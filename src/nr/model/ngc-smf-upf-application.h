@@ -36,7 +36,10 @@
 #include <ns3/application.h>
 #include <ns3/ngc-n2ap-sap.h>
 #include <ns3/ngc-n11-sap.h>
+#include <ns3/ngc-teid-allocator.h>
 #include <map>
+#include <set>
+#include <vector>
 
 namespace ns3 {
 
@@ -44,6 +47,15 @@ namespace ns3 {
  * \ingroup nr
  *
  * This application implements the SMF/UPF functionality.
+ *
+ * The SMF may control several UPFs: the UPF given at construction (UPF 0)
+ * is the central anchor, and further UPFs, e.g. edge anchors, are
+ * attached to it over N9 with AddUpf (). The SMF selects the UPF of each
+ * PDU session when the session is created, according to the
+ * UpfSelectionPolicy attribute, and the UPF stays the anchor of the
+ * session until its last bearer is removed. The downlink packets that
+ * reach a UPF other than the anchor of their UE are classified there and
+ * forwarded to the anchor over N9, in the GTP-U tunnel of their bearer.
  */
 class NgcSmfUpfApplication : public Application
 {
@@ -51,6 +63,14 @@ class NgcSmfUpfApplication : public Application
 
 public:
 
+  /// How the SMF selects the UPF of a new PDU session
+  enum UpfSelectionPolicy
+  {
+    ROUND_ROBIN,  ///< the UPFs in turn
+    LEAST_LOADED, ///< the UPF with the fewest sessions
+    LOCAL         ///< the local UPF of the cell, UPF 0 if the cell has none
+  };
+
   // inherited from Object
   static TypeId GetTypeId (void);
   virtual void DoDispose ();
@@ -74,10 +94,12 @@ public:
    * Method to be assigned to the callback of the Gi TUN VirtualNetDevice. It
    * is called when the SMF/UPF receives a data packet from the
    * internet (including IP headers) that is to be sent to the UE via
-   * its associated eNB, tunneling IP over GTP-U/UDP/IP.
+   * its associated eNB, tunneling IP over GTP-U/UDP/IP. The TUN devices
+   * of all the UPFs share it.
    * 
    * \param packet 
-   * \param source 
+   * \param source the address of the TUN device, telling which UPF
+   * received the packet
    * \param dest 
    * \param protocolNumber 
    * \return true always 
@@ -95,15 +117,18 @@ public:
   void RecvFromN2uSocket (Ptr<Socket> socket);
 
   /** 
-   * Send a packet to the internet via the Gi interface of the SMF/UPF
+   * Send a packet to the internet via the Gi interface of the UPF
+   * anchoring the bearer of the packet, UPF 0 if the bearer is unknown
    * 
    * \param packet 
+   * \param teid the Tunnel Enpoint IDentifier of the bearer
    */
   void SendToTunDevice (Ptr<Packet> packet, uint32_t teid);
 
 
   /** 
-   * Send a packet to the SMF via the N2-U interface
+   * Send a packet to the eNB via the N2-U interface of the UPF anchoring
+   * the bearer of the packet, UPF 0 if the bearer is unknown
    * 
    * \param packet packet to be sent
    * \param enbN2uAddress the address of the eNB
@@ -126,14 +151,43 @@ public:
   NgcN11SapSmf* GetN11SapSmf ();
 
 
+  /**
+   * Add a UPF, attached to UPF 0 over N9
+   *
+   * \param tunDevice the TUN VirtualNetDevice of the Gi interface of the UPF
+   * \param n2uSocket the socket of the UPF bound to the GTP-U port, for
+   *        both N2-U and N9
+   * \param n9Addr the address of the UPF on its N9 link to UPF 0
+   * \param centralN9Addr the address of UPF 0 on that link
+   * \return the index of the UPF
+   */
+  uint32_t AddUpf (const Ptr<VirtualNetDevice> tunDevice, const Ptr<Socket> n2uSocket,
+                   Ipv4Address n9Addr, Ipv4Address centralN9Addr);
+
+  /**
+   * \return the number of UPFs, including UPF 0
+   */
+  uint32_t GetNUpfs () const;
+
   /** 
-   * Let the SMF be aware of a new eNB 
+   * Let the SMF be aware of a new eNB, or of a new N2-U link between an
+   * eNB and a UPF
    * 
    * \param cellId the cell identifier
-   * \param enbAddr the address of the eNB
-   * \param smfAddr the address of the SMF
+   * \param enbAddr the address of the eNB on the link
+   * \param smfAddr the address of the UPF on the link
+   * \param upfIndex the index of the UPF
+   */
+  void AddEnb (uint16_t cellId, Ipv4Address enbAddr, Ipv4Address smfAddr, uint32_t upfIndex = 0);
+
+  /**
+   * Set the UPF selected for the sessions created in a cell by the LOCAL
+   * policy
+   *
+   * \param cellId the cell identifier
+   * \param upfIndex the index of the UPF, linked to the eNB of the cell
    */
-  void AddEnb (uint16_t cellId, Ipv4Address enbAddr, Ipv4Address smfAddr);
+  void SetLocalUpf (uint16_t cellId, uint32_t upfIndex);
 
   /** 
    * Let the SMF be aware of a new UE
@@ -150,6 +204,28 @@ public:
    */
   void SetUeAddress (uint64_t imsi, Ipv4Address ueAddr);
 
+  /**
+   * \return the number of sessions, i.e. of UEs with an N11 TEID
+   */
+  uint32_t GetNSessions () const;
+
+  /**
+   * \param upfIndex the index of a UPF
+   * \return the number of sessions anchored at the UPF
+   */
+  uint32_t GetNSessions (uint32_t upfIndex) const;
+
+  /**
+   * \return the number of bearers, i.e. of N2-U TEIDs in use
+   */
+  uint32_t GetNBearers () const;
+
+  /**
+   * \return the approximate memory used by the TEID pools and the TEID
+   *         lookup tables, in bytes
+   */
+  uint64_t GetTeidMemoryUsage () const;
+
 private:
 
   // N11 SAP SMF methods
@@ -179,19 +255,29 @@ public:
     /** 
      * \brief Function, deletes contexts of bearer on SMF and UPF side
      * \param bearerId, the Bearer Id whose contexts to be removed
+     * \return the TEID of the removed bearer, 0 if the bearer is unknown
      */
-    void RemoveBearer (uint8_t bearerId);
+    uint32_t RemoveBearer (uint8_t bearerId);
+
+    /**
+     * \return true if the UE has at least one bearer
+     */
+    bool HasBearers () const;
 
     /**
      * 
      * 
-     * \param p the IP packet from the internet to be classified
+     * \param tuple the fields of the IP packet from the internet to be
+     * classified, as read by NgcTftClassifier::ReadFiveTuple
      * 
      * \return the corresponding bearer ID > 0 identifying the bearer
      * among all the bearers of this UE;  returns 0 if no bearers
      * matches with the previously declared TFTs
+     *
+     * The result is cached for the flow of the packet (addresses,
+     * protocol, ports and TOS) until the bearers of the UE change.
      */
-    uint32_t Classify (Ptr<Packet> p);
+    uint32_t Classify (const NgcTftClassifier::FiveTuple &tuple);
 
     /** 
      * \return the address of the eNB to which the UE is connected
@@ -217,25 +303,115 @@ public:
      */
     void SetUeAddr (Ipv4Address addr);
 
+    /**
+     * \return the TEID of the session of the UE on the SMF side of N11,
+     *         0 if none
+     */
+    uint32_t GetSmfN11Teid () const;
+
+    /**
+     * \param teid the TEID of the session of the UE on the SMF side of N11
+     */
+    void SetSmfN11Teid (uint32_t teid);
+
+    /**
+     * \return the TEID of the session of the UE on the AMF side of N11
+     */
+    uint32_t GetAmfN11Teid () const;
+
+    /**
+     * \param teid the TEID of the session of the UE on the AMF side of N11
+     */
+    void SetAmfN11Teid (uint32_t teid);
+
+    /**
+     * \return the index of the UPF anchoring the session of the UE
+     */
+    uint32_t GetUpfIndex () const;
+
+    /**
+     * \param upfIndex the index of the UPF anchoring the session of the UE
+     */
+    void SetUpfIndex (uint32_t upfIndex);
+
 
   private:
+    /**
+     * Invalidate the cached classification of the flows of the UE
+     */
+    void FlushFlowCache ();
+
+    /// a downlink flow of the UE and the TEID of its bearer
+    struct FlowCacheEntry
+    {
+      NgcTftClassifier::FiveTuple tuple;
+      bool valid;
+      uint32_t teid;
+    };
+
+    /// number of entries of the direct mapped flow cache
+    static const uint32_t FLOW_CACHE_SIZE = 16;
+
     NgcTftClassifier m_tftClassifier;
+    FlowCacheEntry m_flowCache[FLOW_CACHE_SIZE];
     Ipv4Address m_enbAddr;
     Ipv4Address m_ueAddr;
+    uint32_t m_smfN11Teid;
+    uint32_t m_amfN11Teid;
+    uint32_t m_upfIndex;
     std::map<uint8_t, uint32_t> m_teidByBearerIdMap;
   };
 
+  /**
+   * Select the UPF of a new session
+   *
+   * \param cellId the cell of the UE
+   * \return the index of the UPF
+   */
+  uint32_t SelectUpf (uint16_t cellId);
+
+  /**
+   * \param source the address of a TUN device
+   * \return the index of the UPF of the TUN device
+   */
+  uint32_t GetUpfIndexByTunAddress (const Address &source) const;
+
+  /**
+   * \param socket a GTP-U socket
+   * \return the index of the UPF of the socket
+   */
+  uint32_t GetUpfIndexBySocket (Ptr<Socket> socket) const;
+
+  /**
+   * \param from the index of the sending UPF
+   * \param to the index of the receiving UPF
+   * \return the N9 address of the receiving UPF, as seen by the sending UPF
+   */
+  Ipv4Address GetN9Address (uint32_t from, uint32_t to) const;
+
+  /**
+   * Send a packet in a GTP-U tunnel
+   *
+   * \param upfIndex the index of the sending UPF
+   * \param packet the packet
+   * \param addr the address of the end of the tunnel, an eNB or a UPF
+   * \param teid the Tunnel Enpoint IDentifier
+   */
+  void SendGtpu (uint32_t upfIndex, Ptr<Packet> packet, Ipv4Address addr, uint32_t teid);
+
+  /**
+   * Release the N2-U TEID of a removed bearer
+   *
+   * \param teid the TEID
+   */
+  void ReleaseBearerTeid (uint32_t teid);
 
- /**
-  * UDP socket to send and receive GTP-U packets to and from the N2-U interface
-  */
-  Ptr<Socket> m_n2uSocket;
-  
   /**
-   * TUN VirtualNetDevice used for tunneling/detunneling IP packets
-   * from/to the internet over GTP-U/UDP/IP on the N2 interface 
+   * \param teid the TEID of a session on the SMF side of N11
+   * \return the UE of the session
    */
-  Ptr<VirtualNetDevice> m_tunDevice;
+  Ptr<UeInfo> GetUeInfoByN11Teid (uint32_t teid);
+
 
   /**
    * Map telling for each UE address the corresponding UE info 
@@ -252,7 +428,32 @@ public:
    */
   uint16_t m_gtpuUdpPort;
 
-  uint32_t m_teidCount;
+  /// a bearer, as found by its N2-U TEID
+  struct BearerRef
+  {
+    Ptr<UeInfo> ueInfo;
+    uint8_t bearerId;
+  };
+
+  /**
+   * Pool of the N2-U TEIDs of the bearers
+   */
+  NgcTeidAllocator m_teidAllocator;
+
+  /**
+   * Pool of the N11 TEIDs of the sessions on the SMF side
+   */
+  NgcTeidAllocator m_n11TeidAllocator;
+
+  /**
+   * Bearer (and UE) of each N2-U TEID
+   */
+  NgcTeidTable<BearerRef> m_bearerByTeid;
+
+  /**
+   * UE info of each N11 TEID on the SMF side
+   */
+  NgcTeidTable<Ptr<UeInfo> > m_ueInfoByN11Teid;
 
   /**
    * AMF side of the N11 SAP
@@ -272,7 +473,47 @@ public:
     Ipv4Address smfAddr;    
   };
 
-  std::map<uint16_t, EnbInfo> m_enbInfoByCellId;
+  /// a UPF controlled by the SMF
+  struct UpfInfo
+  {
+    /**
+     * TUN VirtualNetDevice used for tunneling/detunneling IP packets
+     * from/to the internet over GTP-U/UDP/IP on the N2 interface
+     */
+    Ptr<VirtualNetDevice> tunDevice;
+    /**
+     * UDP socket to send and receive GTP-U packets to and from the N2-U
+     * and N9 interfaces
+     */
+    Ptr<Socket> n2uSocket;
+    Ipv4Address n9Addr;        ///< address on the N9 link to UPF 0
+    Ipv4Address centralN9Addr; ///< address of UPF 0 on that link
+    uint32_t nSessions;        ///< sessions anchored at the UPF
+    std::map<uint16_t, EnbInfo> enbInfoByCellId; ///< the eNBs linked to the UPF
+  };
+
+  /**
+   * The UPFs, the central one first
+   */
+  std::vector<UpfInfo> m_upfs;
+
+  /**
+   * The N9 addresses of the UPFs, telling the packets forwarded by a UPF
+   * from those of the eNBs
+   */
+  std::set<Ipv4Address> m_n9Addrs;
+
+  /**
+   * The local UPF of each cell, for the LOCAL policy
+   */
+  std::map<uint16_t, uint32_t> m_localUpfByCellId;
+
+  UpfSelectionPolicy m_upfSelectionPolicy;
+
+  /**
+   * The next UPF of the ROUND_ROBIN policy
+   */
+  uint32_t m_nextUpf;
 };
 
 } //namespace ns3
@@ -0,0 +1,93 @@
+/* -*-  Mode: C++; c-file-style: "gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "ngc-teid-allocator.h"
+
+#include <ns3/log.h>
+#include <ns3/abort.h>
+
+namespace ns3 {
+
+NS_LOG_COMPONENT_DEFINE ("NgcTeidAllocator");
+
+NgcTeidAllocator::NgcTeidAllocator (uint32_t maxTeid)
+  : m_maxTeid (maxTeid),
+    m_next (1),
+    m_nAllocated (0)
+{
+  NS_ASSERT (maxTeid > 0 && maxTeid < 0xFFFFFFFF);
+}
+
+uint32_t
+NgcTeidAllocator::Allocate ()
+{
+  uint32_t teid;
+  if (!m_released.empty ())
+    {
+      teid = m_released.front ();
+      m_released.pop_front ();
+    }
+  else
+    {
+      NS_ABORT_MSG_IF (m_next > m_maxTeid,
+                       "no TEID left: " << m_nAllocated << " TEIDs in use");
+      teid = m_next++;
+      if (teid >= m_allocated.size ())
+        {
+          m_allocated.resize (teid + 1, false);
+        }
+    }
+  m_allocated[teid] = true;
+  m_nAllocated++;
+  NS_LOG_LOGIC ("allocated TEID " << teid);
+  return teid;
+}
+
+void
+NgcTeidAllocator::Release (uint32_t teid)
+{
+  NS_ASSERT_MSG (IsAllocated (teid), "TEID " << teid << " is not allocated");
+  NS_LOG_LOGIC ("released TEID " << teid);
+  m_allocated[teid] = false;
+  m_nAllocated--;
+  m_released.push_back (teid);
+}
+
+bool
+NgcTeidAllocator::IsAllocated (uint32_t teid) const
+{
+  return teid < m_allocated.size () && m_allocated[teid];
+}
+
+uint32_t
+NgcTeidAllocator::GetNAllocated () const
+{
+  return m_nAllocated;
+}
+
+uint32_t
+NgcTeidAllocator::GetHighWaterMark () const
+{
+  return m_next - 1;
+}
+
+uint64_t
+NgcTeidAllocator::GetMemoryUsage () const
+{
+  return m_allocated.capacity () / 8 + m_released.size () * sizeof (uint32_t);
+}
+
+} // namespace ns3
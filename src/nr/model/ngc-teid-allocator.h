@@ -0,0 +1,206 @@
+/* -*-  Mode: C++; c-file-style: "gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef NGC_TEID_ALLOCATOR_H
+#define NGC_TEID_ALLOCATOR_H
+
+#include <ns3/assert.h>
+
+#include <stdint.h>
+#include <deque>
+#include <map>
+#include <vector>
+
+namespace ns3 {
+
+/**
+ * \ingroup nr
+ *
+ * \brief A pool of Tunnel Endpoint IDentifiers.
+ *
+ * The TEIDs are handed out from 1 up, and the released TEIDs are reused
+ * in the order they were released, so that a TEID stays unused for as
+ * long as possible before it is reused (the packets still in flight on
+ * the old tunnel are then unlikely to reach the new one). The allocated
+ * TEIDs stay dense, whatever the number of sessions created over time,
+ * which is what NgcTeidTable relies on.
+ */
+class NgcTeidAllocator
+{
+public:
+  /**
+   * \param maxTeid the largest TEID of the pool, below 0xFFFFFFFF
+   */
+  NgcTeidAllocator (uint32_t maxTeid = 0xFFFFFFFE);
+
+  /**
+   * \return a TEID that is not in use. Aborts if the pool is exhausted.
+   */
+  uint32_t Allocate ();
+
+  /**
+   * Return a TEID to the pool
+   *
+   * \param teid a TEID allocated by this pool
+   */
+  void Release (uint32_t teid);
+
+  /**
+   * \param teid a TEID
+   * \return true if the TEID is allocated
+   */
+  bool IsAllocated (uint32_t teid) const;
+
+  /**
+   * \return the number of TEIDs in use
+   */
+  uint32_t GetNAllocated () const;
+
+  /**
+   * \return the largest TEID handed out so far
+   */
+  uint32_t GetHighWaterMark () const;
+
+  /**
+   * \return the approximate memory used by the pool, in bytes
+   */
+  uint64_t GetMemoryUsage () const;
+
+private:
+  uint32_t m_maxTeid;
+  uint32_t m_next;        ///< the next TEID never handed out
+  uint32_t m_nAllocated;
+  std::deque<uint32_t> m_released;
+  std::vector<bool> m_allocated;
+};
+
+
+/**
+ * \ingroup nr
+ *
+ * \brief A table indexed by TEID, with constant time lookups for the
+ *        TEIDs of an NgcTeidAllocator.
+ *
+ * The TEIDs up to a limit are stored in a vector indexed by TEID; any
+ * larger TEID, e.g. one allocated by a peer, goes to a map.
+ */
+template <class T>
+class NgcTeidTable
+{
+public:
+  /**
+   * \param maxDenseTeid the largest TEID stored in the vector
+   */
+  NgcTeidTable (uint32_t maxDenseTeid = (1 << 20))
+    : m_maxDenseTeid (maxDenseTeid),
+      m_size (0)
+  {
+  }
+
+  /**
+   * Add or replace the entry of a TEID
+   *
+   * \param teid the TEID
+   * \param value the entry
+   */
+  void Insert (uint32_t teid, const T &value)
+  {
+    if (teid > m_maxDenseTeid)
+      {
+        m_size -= m_sparse.size ();
+        m_sparse[teid] = value;
+        m_size += m_sparse.size ();
+        return;
+      }
+    if (teid >= m_dense.size ())
+      {
+        m_dense.resize (teid + 1);
+        m_used.resize (teid + 1, false);
+      }
+    if (!m_used[teid])
+      {
+        m_used[teid] = true;
+        m_size++;
+      }
+    m_dense[teid] = value;
+  }
+
+  /**
+   * \param teid the TEID
+   * \return the entry of the TEID, 0 if none
+   */
+  T * Find (uint32_t teid)
+  {
+    if (teid > m_maxDenseTeid)
+      {
+        typename std::map<uint32_t, T>::iterator it = m_sparse.find (teid);
+        return (it == m_sparse.end ()) ? 0 : &it->second;
+      }
+    if (teid < m_dense.size () && m_used[teid])
+      {
+        return &m_dense[teid];
+      }
+    return 0;
+  }
+
+  /**
+   * Remove the entry of a TEID, if any
+   *
+   * \param teid the TEID
+   */
+  void Erase (uint32_t teid)
+  {
+    if (teid > m_maxDenseTeid)
+      {
+        m_size -= m_sparse.erase (teid);
+        return;
+      }
+    if (teid < m_dense.size () && m_used[teid])
+      {
+        m_used[teid] = false;
+        m_dense[teid] = T ();
+        m_size--;
+      }
+  }
+
+  /**
+   * \return the number of entries
+   */
+  uint32_t GetSize () const
+  {
+    return m_size;
+  }
+
+  /**
+   * \return the approximate memory used by the table, in bytes
+   */
+  uint64_t GetMemoryUsage () const
+  {
+    return m_dense.capacity () * sizeof (T) + m_used.capacity () / 8
+      + m_sparse.size () * (sizeof (uint32_t) + sizeof (T) + 4 * sizeof (void *));
+  }
+
+private:
+  uint32_t m_maxDenseTeid;
+  uint32_t m_size;
+  std::vector<T> m_dense;
+  std::vector<bool> m_used;
+  std::map<uint32_t, T> m_sparse;
+};
+
+} // namespace ns3
+
+#endif // NGC_TEID_ALLOCATOR_H
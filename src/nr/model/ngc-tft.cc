@@ -191,5 +191,11 @@ NgcTft::Matches (Direction direction,
   return false;
 }
 
+std::list<NgcTft::PacketFilter>
+NgcTft::GetPacketFilters () const
+{
+  return m_filters;
+}
+
 
 } // namespace ns3
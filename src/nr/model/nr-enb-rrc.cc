@@ -1945,6 +1945,7 @@ UeManager::RecvRrcConnectionReconfigurationCompleted (NrRrcSap::RrcConnectionRec
             NgcEnbN2SapProvider::BearerToBeSwitched b;
             b.epsBearerId = it->second->m_epsBearerIdentity;
             b.teid =  it->second->m_gtpTeid;
+            b.transportLayerAddress = it->second->m_transportLayerAddress;
             params.bearersToBeSwitched.push_back (b);
           }
             m_rrc->m_n2SapProvider->PathSwitchRequest (params);
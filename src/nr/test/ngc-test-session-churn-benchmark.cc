@@ -0,0 +1,200 @@
+/* -*-  Mode: C++; c-file-style: "gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "ns3/test.h"
+#include "ns3/simulator.h"
+#include "ns3/node.h"
+#include "ns3/socket.h"
+#include "ns3/udp-socket-factory.h"
+#include "ns3/virtual-net-device.h"
+#include "ns3/internet-stack-helper.h"
+
+#include "ns3/ngc-smf-upf-application.h"
+
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+#include <vector>
+
+using namespace ns3;
+
+/**
+ * Stands for the AMF: keeps the last responses of the SMF
+ */
+class NgcSessionChurnTestAmf : public NgcN11SapAmf
+{
+public:
+  virtual void CreateSessionResponse (CreateSessionResponseMessage msg)
+  {
+    m_createSessionResponse = msg;
+  }
+  virtual void DeleteBearerRequest (DeleteBearerRequestMessage msg)
+  {
+    m_deleteBearerRequest = msg;
+  }
+  virtual void ModifyBearerResponse (ModifyBearerResponseMessage msg)
+  {
+  }
+
+  CreateSessionResponseMessage m_createSessionResponse;
+  DeleteBearerRequestMessage m_deleteBearerRequest;
+};
+
+/**
+ * Attach and detach UEs in turn on an NgcSmfUpfApplication, each session
+ * with a default and a dedicated bearer, and time the N11 procedures.
+ */
+class NgcSessionChurnBenchmarkTestCase : public TestCase
+{
+public:
+  NgcSessionChurnBenchmarkTestCase (uint32_t nUes, uint32_t nEvents);
+
+private:
+  virtual void DoRun (void);
+
+  uint32_t m_nUes;
+  uint32_t m_nEvents;
+};
+
+static const uint16_t CELL_ID = 1;
+static const uint32_t N_BEARERS = 2;
+
+NgcSessionChurnBenchmarkTestCase::NgcSessionChurnBenchmarkTestCase (uint32_t nUes, uint32_t nEvents)
+  : TestCase ("NGC session churn, " + std::to_string (nUes) + " UEs, " + std::to_string (nEvents) + " events"),
+    m_nUes (nUes),
+    m_nEvents (nEvents)
+{
+}
+
+void
+NgcSessionChurnBenchmarkTestCase::DoRun (void)
+{
+  Ptr<Node> node = CreateObject<Node> ();
+  InternetStackHelper internet;
+  internet.Install (node);
+  Ptr<Socket> socket = Socket::CreateSocket (node, UdpSocketFactory::GetTypeId ());
+  Ptr<NgcSmfUpfApplication> smf = CreateObject<NgcSmfUpfApplication> (CreateObject<VirtualNetDevice> (), socket);
+  NgcSessionChurnTestAmf amf;
+  smf->SetN11SapAmf (&amf);
+  NgcN11SapSmf *sap = smf->GetN11SapSmf ();
+  smf->AddEnb (CELL_ID, Ipv4Address ("10.0.0.2"), Ipv4Address ("10.0.0.1"));
+  for (uint64_t imsi = 1; imsi <= m_nUes; imsi++)
+    {
+      smf->AddUe (imsi);
+      smf->SetUeAddress (imsi, Ipv4Address (0x07000000 + imsi));
+    }
+
+  // the SMF N11 TEID of each attached UE, 0 if detached
+  std::vector<uint32_t> n11Teids (m_nUes + 1, 0);
+  uint32_t maxTeid = 0;
+  uint32_t nAttached = 0;
+  uint64_t createNs = 0;
+  uint64_t deleteNs = 0;
+  uint32_t nCreate = 0;
+  uint32_t nDelete = 0;
+  uint64_t memory = smf->GetTeidMemoryUsage ();
+  for (uint32_t event = 0; event < m_nEvents; event++)
+    {
+      // the UEs take turns: a UE attaches at its turn, and detaches at
+      // its next turn
+      uint64_t imsi = 1 + (event * 7919ULL) % m_nUes;
+      if (n11Teids[imsi] == 0)
+        {
+          NgcN11SapSmf::CreateSessionRequestMessage req;
+          req.teid = 0;
+          req.imsi = imsi;
+          req.uli.gci = CELL_ID;
+          req.senderCpFteid.teid = imsi;
+          for (uint8_t bid = 1; bid <= N_BEARERS; bid++)
+            {
+              NgcN11SapSmf::BearerContextToBeCreated bearer;
+              bearer.epsBearerId = bid;
+              bearer.tft = NgcTft::Default ();
+              req.bearerContextsToBeCreated.push_back (bearer);
+            }
+          std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now ();
+          sap->CreateSessionRequest (req);
+          createNs += std::chrono::duration_cast<std::chrono::nanoseconds> (std::chrono::steady_clock::now () - start).count ();
+          nCreate++;
+
+          NS_TEST_ASSERT_MSG_EQ (amf.m_createSessionResponse.teid, imsi, "N11 TEID of the AMF");
+          NS_TEST_ASSERT_MSG_EQ (amf.m_createSessionResponse.bearerContextsCreated.size (), N_BEARERS, "bearers created");
+          n11Teids[imsi] = amf.m_createSessionResponse.senderCpFteid.teid;
+          std::list<NgcN11SapAmf::BearerContextCreated>::iterator it;
+          for (it = amf.m_createSessionResponse.bearerContextsCreated.begin ();
+               it != amf.m_createSessionResponse.bearerContextsCreated.end (); ++it)
+            {
+              maxTeid = std::max (maxTeid, it->smfFteid.teid);
+            }
+          nAttached++;
+        }
+      else
+        {
+          NgcN11SapSmf::DeleteBearerCommandMessage cmd;
+          cmd.teid = n11Teids[imsi];
+          NgcN11SapSmf::DeleteBearerResponseMessage res;
+          res.teid = n11Teids[imsi];
+          for (uint8_t bid = 1; bid <= N_BEARERS; bid++)
+            {
+              NgcN11SapSmf::BearerContextToBeRemoved bearer;
+              bearer.epsBearerId = bid;
+              cmd.bearerContextsToBeRemoved.push_back (bearer);
+              NgcN11SapSmf::BearerContextRemovedSmfUpf removed;
+              removed.epsBearerId = bid;
+              res.bearerContextsRemoved.push_back (removed);
+            }
+          std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now ();
+          sap->DeleteBearerCommand (cmd);
+          sap->DeleteBearerResponse (res);
+          deleteNs += std::chrono::duration_cast<std::chrono::nanoseconds> (std::chrono::steady_clock::now () - start).count ();
+          nDelete++;
+
+          NS_TEST_ASSERT_MSG_EQ (amf.m_deleteBearerRequest.teid, imsi, "N11 TEID of the AMF");
+          n11Teids[imsi] = 0;
+          nAttached--;
+        }
+      memory = std::max (memory, smf->GetTeidMemoryUsage ());
+    }
+
+  NS_TEST_ASSERT_MSG_EQ (smf->GetNSessions (), nAttached, "sessions");
+  NS_TEST_ASSERT_MSG_EQ (smf->GetNBearers (), nAttached * N_BEARERS, "bearers");
+  // the TEIDs are recycled: they never go past the number of bearers
+  NS_TEST_ASSERT_MSG_LT_OR_EQ (maxTeid, m_nUes * N_BEARERS, "TEIDs not recycled");
+
+  std::cout << "NGC session churn, " << m_nUes << " UEs: " << nCreate << " creations, "
+            << createNs / std::max (nCreate, 1U) << " ns each, " << nDelete << " deletions, "
+            << deleteNs / std::max (nDelete, 1U) << " ns each, largest TEID " << maxTeid
+            << ", TEID state " << memory << " bytes at most" << std::endl;
+
+  smf->Dispose ();
+  Simulator::Destroy ();
+}
+
+class NgcSessionChurnBenchmarkTestSuite : public TestSuite
+{
+public:
+  NgcSessionChurnBenchmarkTestSuite ();
+};
+
+NgcSessionChurnBenchmarkTestSuite::NgcSessionChurnBenchmarkTestSuite ()
+  : TestSuite ("ngc-session-churn-benchmark", PERFORMANCE)
+{
+  AddTestCase (new NgcSessionChurnBenchmarkTestCase (1000, 200000), TestCase::QUICK);
+  AddTestCase (new NgcSessionChurnBenchmarkTestCase (10000, 2000000), TestCase::EXTENSIVE);
+  AddTestCase (new NgcSessionChurnBenchmarkTestCase (100000, 5000000), TestCase::EXTENSIVE);
+}
+
+static NgcSessionChurnBenchmarkTestSuite ngcSessionChurnBenchmarkTestSuite;
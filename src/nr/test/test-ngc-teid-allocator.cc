@@ -0,0 +1,128 @@
+/* -*-  Mode: C++; c-file-style: "gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "ns3/test.h"
+
+#include "ns3/ngc-teid-allocator.h"
+
+using namespace ns3;
+
+/**
+ * The TEIDs are handed out from 1 up and the released ones are reused
+ * first, oldest first
+ */
+class NgcTeidAllocatorTestCase : public TestCase
+{
+public:
+  NgcTeidAllocatorTestCase ();
+
+private:
+  virtual void DoRun (void);
+};
+
+NgcTeidAllocatorTestCase::NgcTeidAllocatorTestCase ()
+  : TestCase ("TEID pool")
+{
+}
+
+void
+NgcTeidAllocatorTestCase::DoRun (void)
+{
+  NgcTeidAllocator pool (10);
+  for (uint32_t teid = 1; teid <= 5; teid++)
+    {
+      NS_TEST_ASSERT_MSG_EQ (pool.Allocate (), teid, "new TEID");
+    }
+  pool.Release (4);
+  pool.Release (2);
+  NS_TEST_ASSERT_MSG_EQ (pool.IsAllocated (2), false, "released TEID");
+  NS_TEST_ASSERT_MSG_EQ (pool.IsAllocated (3), true, "allocated TEID");
+  NS_TEST_ASSERT_MSG_EQ (pool.GetNAllocated (), 3, "TEIDs in use");
+  NS_TEST_ASSERT_MSG_EQ (pool.Allocate (), 4, "the oldest released TEID first");
+  NS_TEST_ASSERT_MSG_EQ (pool.Allocate (), 2, "then the next released TEID");
+  NS_TEST_ASSERT_MSG_EQ (pool.Allocate (), 6, "then a new TEID");
+  NS_TEST_ASSERT_MSG_EQ (pool.GetHighWaterMark (), 6, "largest TEID handed out");
+
+  // churn on a full pool never grows it
+  for (uint32_t teid = 7; teid <= 10; teid++)
+    {
+      pool.Allocate ();
+    }
+  for (uint32_t i = 0; i < 1000; i++)
+    {
+      uint32_t teid = 1 + i % 10;
+      pool.Release (teid);
+      NS_TEST_ASSERT_MSG_EQ (pool.Allocate (), teid, "recycled TEID");
+    }
+  NS_TEST_ASSERT_MSG_EQ (pool.GetHighWaterMark (), 10, "largest TEID handed out");
+  NS_TEST_ASSERT_MSG_EQ (pool.GetNAllocated (), 10, "TEIDs in use");
+}
+
+/**
+ * Lookups of the dense and of the sparse TEIDs of an NgcTeidTable
+ */
+class NgcTeidTableTestCase : public TestCase
+{
+public:
+  NgcTeidTableTestCase ();
+
+private:
+  virtual void DoRun (void);
+};
+
+NgcTeidTableTestCase::NgcTeidTableTestCase ()
+  : TestCase ("TEID table")
+{
+}
+
+void
+NgcTeidTableTestCase::DoRun (void)
+{
+  NgcTeidTable<uint16_t> table (100);
+  NS_TEST_ASSERT_MSG_EQ ((table.Find (1) == 0), true, "empty table");
+  table.Insert (1, 11);
+  table.Insert (50, 12);
+  table.Insert (1000, 13);
+  table.Insert (50, 14);
+  NS_TEST_ASSERT_MSG_EQ (table.GetSize (), 3, "entries");
+  NS_TEST_ASSERT_MSG_EQ (*table.Find (1), 11, "dense entry");
+  NS_TEST_ASSERT_MSG_EQ (*table.Find (50), 14, "replaced entry");
+  NS_TEST_ASSERT_MSG_EQ (*table.Find (1000), 13, "sparse entry");
+  NS_TEST_ASSERT_MSG_EQ ((table.Find (2) == 0), true, "no entry");
+  NS_TEST_ASSERT_MSG_EQ ((table.Find (999) == 0), true, "no sparse entry");
+
+  table.Erase (50);
+  table.Erase (1000);
+  table.Erase (7);
+  NS_TEST_ASSERT_MSG_EQ (table.GetSize (), 1, "entries");
+  NS_TEST_ASSERT_MSG_EQ ((table.Find (50) == 0), true, "erased entry");
+  NS_TEST_ASSERT_MSG_EQ ((table.Find (1000) == 0), true, "erased sparse entry");
+}
+
+class NgcTeidAllocatorTestSuite : public TestSuite
+{
+public:
+  NgcTeidAllocatorTestSuite ();
+};
+
+NgcTeidAllocatorTestSuite::NgcTeidAllocatorTestSuite ()
+  : TestSuite ("ngc-teid-allocator", UNIT)
+{
+  AddTestCase (new NgcTeidAllocatorTestCase (), TestCase::QUICK);
+  AddTestCase (new NgcTeidTableTestCase (), TestCase::QUICK);
+}
+
+static NgcTeidAllocatorTestSuite ngcTeidAllocatorTestSuite;
@@ -0,0 +1,231 @@
+/* -*-  Mode: C++; c-file-style: "gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "ns3/test.h"
+#include "ns3/simulator.h"
+#include "ns3/node.h"
+#include "ns3/socket.h"
+#include "ns3/enum.h"
+#include "ns3/udp-socket-factory.h"
+#include "ns3/virtual-net-device.h"
+#include "ns3/internet-stack-helper.h"
+
+#include "ns3/ngc-smf-upf-application.h"
+
+using namespace ns3;
+
+/**
+ * Stands for the AMF: keeps the last session created by the SMF
+ */
+class NgcUpfSelectionTestAmf : public NgcN11SapAmf
+{
+public:
+  virtual void CreateSessionResponse (CreateSessionResponseMessage msg)
+  {
+    m_createSessionResponse = msg;
+  }
+  virtual void DeleteBearerRequest (DeleteBearerRequestMessage msg)
+  {
+  }
+  virtual void ModifyBearerResponse (ModifyBearerResponseMessage msg)
+  {
+  }
+
+  CreateSessionResponseMessage m_createSessionResponse;
+};
+
+/**
+ * Create sessions on an SMF with three UPFs and two cells, and check the
+ * UPF selected for each session, as told to the AMF by the address of
+ * the bearers.
+ */
+class NgcUpfSelectionTestCase : public TestCase
+{
+public:
+  NgcUpfSelectionTestCase (NgcSmfUpfApplication::UpfSelectionPolicy policy, std::string name);
+
+private:
+  virtual void DoRun (void);
+
+  /**
+   * \param imsi the UE
+   * \param cellId the cell of the UE
+   * \return the UPF of the new session of the UE
+   */
+  uint32_t CreateSession (uint64_t imsi, uint16_t cellId);
+
+  /**
+   * Remove the session of a UE
+   *
+   * \param n11Teid the N11 TEID of the session on the SMF side
+   */
+  void DeleteSession (uint32_t n11Teid);
+
+  NgcSmfUpfApplication::UpfSelectionPolicy m_policy;
+  Ptr<NgcSmfUpfApplication> m_smf;
+  NgcUpfSelectionTestAmf m_amf;
+};
+
+static const uint32_t N_UPFS = 3;
+static const uint16_t N_CELLS = 2;
+
+/**
+ * \param upfIndex the index of a UPF
+ * \param cellId the cell of an eNB
+ * \return the address of the UPF on its N2-U link with the eNB
+ */
+static Ipv4Address
+GetUpfAddress (uint32_t upfIndex, uint16_t cellId)
+{
+  return Ipv4Address (0x0a000001 + (upfIndex << 8) + (cellId << 2));
+}
+
+NgcUpfSelectionTestCase::NgcUpfSelectionTestCase (NgcSmfUpfApplication::UpfSelectionPolicy policy, std::string name)
+  : TestCase ("UPF selection, " + name),
+    m_policy (policy)
+{
+}
+
+uint32_t
+NgcUpfSelectionTestCase::CreateSession (uint64_t imsi, uint16_t cellId)
+{
+  NgcN11SapSmf::CreateSessionRequestMessage req;
+  req.teid = 0;
+  req.imsi = imsi;
+  req.uli.gci = cellId;
+  req.senderCpFteid.teid = imsi;
+  NgcN11SapSmf::BearerContextToBeCreated bearer;
+  bearer.epsBearerId = 1;
+  bearer.tft = NgcTft::Default ();
+  req.bearerContextsToBeCreated.push_back (bearer);
+  m_smf->GetN11SapSmf ()->CreateSessionRequest (req);
+
+  NS_ASSERT (m_amf.m_createSessionResponse.bearerContextsCreated.size () == 1);
+  Ipv4Address address = m_amf.m_createSessionResponse.bearerContextsCreated.front ().smfFteid.address;
+  for (uint32_t upfIndex = 0; upfIndex < N_UPFS; upfIndex++)
+    {
+      if (address == GetUpfAddress (upfIndex, cellId))
+        {
+          return upfIndex;
+        }
+    }
+  NS_TEST_EXPECT_MSG_EQ (true, false, "bearer address " << address << " of no UPF of cell " << cellId);
+  return N_UPFS;
+}
+
+void
+NgcUpfSelectionTestCase::DeleteSession (uint32_t n11Teid)
+{
+  NgcN11SapSmf::DeleteBearerResponseMessage res;
+  res.teid = n11Teid;
+  NgcN11SapSmf::BearerContextRemovedSmfUpf removed;
+  removed.epsBearerId = 1;
+  res.bearerContextsRemoved.push_back (removed);
+  m_smf->GetN11SapSmf ()->DeleteBearerResponse (res);
+}
+
+void
+NgcUpfSelectionTestCase::DoRun (void)
+{
+  Ptr<Node> node = CreateObject<Node> ();
+  InternetStackHelper internet;
+  internet.Install (node);
+  m_smf = CreateObject<NgcSmfUpfApplication> (CreateObject<VirtualNetDevice> (),
+                                              Socket::CreateSocket (node, UdpSocketFactory::GetTypeId ()));
+  m_smf->SetAttribute ("UpfSelectionPolicy", EnumValue (m_policy));
+  m_smf->SetN11SapAmf (&m_amf);
+  for (uint32_t upfIndex = 1; upfIndex < N_UPFS; upfIndex++)
+    {
+      uint32_t index = m_smf->AddUpf (CreateObject<VirtualNetDevice> (),
+                                      Socket::CreateSocket (node, UdpSocketFactory::GetTypeId ()),
+                                      Ipv4Address (0x0d000001 + (upfIndex << 2)),
+                                      Ipv4Address (0x0d000002 + (upfIndex << 2)));
+      NS_TEST_ASSERT_MSG_EQ (index, upfIndex, "UPF index");
+    }
+  NS_TEST_ASSERT_MSG_EQ (m_smf->GetNUpfs (), N_UPFS, "UPFs");
+  for (uint16_t cellId = 1; cellId <= N_CELLS; cellId++)
+    {
+      for (uint32_t upfIndex = 0; upfIndex < N_UPFS; upfIndex++)
+        {
+          Ipv4Address upfAddr = GetUpfAddress (upfIndex, cellId);
+          m_smf->AddEnb (cellId, Ipv4Address (upfAddr.Get () + 1), upfAddr, upfIndex);
+        }
+    }
+  m_smf->SetLocalUpf (2, 2);
+  for (uint64_t imsi = 1; imsi <= 8; imsi++)
+    {
+      m_smf->AddUe (imsi);
+      m_smf->SetUeAddress (imsi, Ipv4Address (0x07000001 + imsi));
+    }
+
+  switch (m_policy)
+    {
+    case NgcSmfUpfApplication::ROUND_ROBIN:
+      for (uint64_t imsi = 1; imsi <= 6; imsi++)
+        {
+          NS_TEST_ASSERT_MSG_EQ (CreateSession (imsi, 1 + imsi % N_CELLS), (imsi - 1) % N_UPFS, "UPFs in turn");
+        }
+      break;
+
+    case NgcSmfUpfApplication::LEAST_LOADED:
+      {
+        NS_TEST_ASSERT_MSG_EQ (CreateSession (1, 1), 0, "all UPFs idle");
+        uint32_t n11Teid = m_amf.m_createSessionResponse.senderCpFteid.teid;
+        NS_TEST_ASSERT_MSG_EQ (CreateSession (2, 1), 1, "UPF 0 loaded");
+        NS_TEST_ASSERT_MSG_EQ (CreateSession (3, 2), 2, "UPFs 0 and 1 loaded");
+        DeleteSession (n11Teid);
+        NS_TEST_ASSERT_MSG_EQ (m_smf->GetNSessions (0), 0, "session of UPF 0 deleted");
+        NS_TEST_ASSERT_MSG_EQ (CreateSession (4, 2), 0, "UPF 0 idle again");
+        NS_TEST_ASSERT_MSG_EQ (CreateSession (5, 2), 0, "all UPFs loaded alike");
+        // a session set up again keeps its UPF
+        NS_TEST_ASSERT_MSG_EQ (CreateSession (3, 2), 2, "UPF of an existing session");
+      }
+      break;
+
+    case NgcSmfUpfApplication::LOCAL:
+      NS_TEST_ASSERT_MSG_EQ (CreateSession (1, 1), 0, "cell without a local UPF");
+      NS_TEST_ASSERT_MSG_EQ (CreateSession (2, 2), 2, "local UPF");
+      NS_TEST_ASSERT_MSG_EQ (CreateSession (3, 2), 2, "local UPF");
+      break;
+    }
+
+  uint32_t nSessions = 0;
+  for (uint32_t upfIndex = 0; upfIndex < N_UPFS; upfIndex++)
+    {
+      nSessions += m_smf->GetNSessions (upfIndex);
+    }
+  NS_TEST_ASSERT_MSG_EQ (nSessions, m_smf->GetNSessions (), "sessions of the UPFs");
+
+  m_smf->Dispose ();
+  m_smf = 0;
+  Simulator::Destroy ();
+}
+
+class NgcUpfSelectionTestSuite : public TestSuite
+{
+public:
+  NgcUpfSelectionTestSuite ();
+};
+
+NgcUpfSelectionTestSuite::NgcUpfSelectionTestSuite ()
+  : TestSuite ("ngc-upf-selection", UNIT)
+{
+  AddTestCase (new NgcUpfSelectionTestCase (NgcSmfUpfApplication::ROUND_ROBIN, "round robin"), TestCase::QUICK);
+  AddTestCase (new NgcUpfSelectionTestCase (NgcSmfUpfApplication::LEAST_LOADED, "least loaded"), TestCase::QUICK);
+  AddTestCase (new NgcUpfSelectionTestCase (NgcSmfUpfApplication::LOCAL, "local"), TestCase::QUICK);
+}
+
+static NgcUpfSelectionTestSuite ngcUpfSelectionTestSuite;
@@ -0,0 +1,294 @@
+/* -*-  Mode: C++; c-file-style: "gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * A storm of UE attaches, each one installing the uplink and downlink rules
+ * of the UE on a switch, at evenly spaced times over the storm duration:
+ * - with a dpctl command per rule, and a barrier request per UE;
+ * - with the rules built as OFLib messages, and the UEs attaching within a
+ *   batch interval sent together by SendBatchToSwitch, with one barrier.
+ *
+ * For each, the wall clock time spent by the controller installing the
+ * rules, the TCP segments sent by the controller, and the flow setup
+ * latency of the UEs, from their attach to the barrier reply, are printed.
+ *
+ *                        Storm Controller
+ *                                |
+ *                       +-----------------+
+ *            Host 0 === | OpenFlow switch | === Host 1
+ *                       +-----------------+
+ */
+
+#include <ns3/core-module.h>
+#include <ns3/network-module.h>
+#include <ns3/csma-module.h>
+#include <ns3/internet-module.h>
+#include <ns3/ofswitch13-module.h>
+#include <algorithm>
+#include <chrono>
+#include <deque>
+#include <iostream>
+#include <sstream>
+
+using namespace ns3;
+
+class AttachStormController : public OFSwitch13Controller
+{
+public:
+  /**
+   * \param nUes The number of UEs attaching.
+   * \param start The start of the storm.
+   * \param duration The duration of the storm.
+   * \param batchInterval The interval of the UEs sent in a batch, negative
+   *        for a dpctl command per rule.
+   */
+  AttachStormController (uint32_t nUes, Time start, Time duration,
+                         Time batchInterval);
+
+  double m_cpuSeconds;              //!< Time spent installing the rules.
+  std::vector<double> m_latencies;  //!< Flow setup latency of each UE [s].
+
+protected:
+  // Inherited from OFSwitch13Controller
+  void HandshakeSuccessful (Ptr<const RemoteSwitch> swtch);
+
+private:
+  void Attach (uint32_t ue);
+  void SendBatch (void);
+  void BarrierReply (uint64_t dpId, Time delay);
+
+  uint32_t m_nUes;
+  Time m_start;
+  Time m_duration;
+  Time m_batchInterval;
+  Ptr<const RemoteSwitch> m_swtch;
+
+  std::vector<struct ofl_msg_header*> m_batch; //!< Rules of the next batch.
+  std::vector<Time> m_batchAttaches;           //!< Attaches of the next batch.
+  EventId m_batchEvent;
+
+  /** Attaches of each barrier request waiting for its reply */
+  std::deque<std::vector<Time> > m_barriers;
+};
+
+AttachStormController::AttachStormController (uint32_t nUes, Time start,
+                                              Time duration, Time batchInterval)
+  : m_cpuSeconds (0),
+    m_nUes (nUes),
+    m_start (start),
+    m_duration (duration),
+    m_batchInterval (batchInterval)
+{
+  TraceConnectWithoutContext (
+    "BarrierReply", MakeCallback (&AttachStormController::BarrierReply, this));
+}
+
+void
+AttachStormController::HandshakeSuccessful (Ptr<const RemoteSwitch> swtch)
+{
+  m_swtch = swtch;
+  for (uint32_t ue = 0; ue < m_nUes; ue++)
+    {
+      Simulator::Schedule (m_start + m_duration * ue / m_nUes - Simulator::Now (),
+                           &AttachStormController::Attach, this, ue);
+    }
+}
+
+static Ipv4Address
+UeAddress (uint32_t ue)
+{
+  return Ipv4Address (Ipv4Address ("7.0.0.2").Get () + ue);
+}
+
+/*
+ * The rule forwarding the packets from inPort whose IPv4 field oxm is the
+ * address to outPort
+ */
+static struct ofl_msg_header *
+CreateFlowMod (uint32_t inPort, uint32_t oxm, Ipv4Address address,
+               uint32_t outPort)
+{
+  struct ofl_match *match = (struct ofl_match*)xmalloc (sizeof (struct ofl_match));
+  ofl_structs_match_init (match);
+  ofl_structs_match_put32 (match, OXM_OF_IN_PORT, inPort);
+  ofl_structs_match_put16 (match, OXM_OF_ETH_TYPE, Ipv4L3Protocol::PROT_NUMBER);
+  ofl_structs_match_put32 (match, oxm, htonl (address.Get ()));
+
+  struct ofl_action_output *output =
+    (struct ofl_action_output*)xmalloc (sizeof (struct ofl_action_output));
+  output->header.type = OFPAT_OUTPUT;
+  output->port = outPort;
+  output->max_len = 0;
+
+  struct ofl_instruction_actions *apply =
+    (struct ofl_instruction_actions*)xmalloc (sizeof (struct ofl_instruction_actions));
+  apply->header.type = OFPIT_APPLY_ACTIONS;
+  apply->actions_num = 1;
+  apply->actions = (struct ofl_action_header**)xmalloc (sizeof (struct ofl_action_header*));
+  apply->actions[0] = &output->header;
+
+  struct ofl_msg_flow_mod *mod =
+    (struct ofl_msg_flow_mod*)xmalloc (sizeof (struct ofl_msg_flow_mod));
+  memset (mod, 0, sizeof (struct ofl_msg_flow_mod));
+  mod->header.type = OFPT_FLOW_MOD;
+  mod->command = OFPFC_ADD;
+  mod->priority = 1000;
+  mod->buffer_id = OFP_NO_BUFFER;
+  mod->out_port = OFPP_ANY;
+  mod->out_group = OFPG_ANY;
+  mod->match = (struct ofl_match_header*)match;
+  mod->instructions_num = 1;
+  mod->instructions = (struct ofl_instruction_header**)xmalloc (sizeof (struct ofl_instruction_header*));
+  mod->instructions[0] = &apply->header;
+  return &mod->header;
+}
+
+void
+AttachStormController::Attach (uint32_t ue)
+{
+  std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now ();
+  Ipv4Address address = UeAddress (ue);
+  if (m_batchInterval.IsNegative ())
+    {
+      std::ostringstream uplink, downlink;
+      uplink << "flow-mod cmd=add,table=0,prio=1000 in_port=1,eth_type=0x0800,ip_src="
+             << address << " apply:output=2";
+      downlink << "flow-mod cmd=add,table=0,prio=1000 in_port=2,eth_type=0x0800,ip_dst="
+               << address << " apply:output=1";
+      DpctlExecute (m_swtch, uplink.str ());
+      DpctlExecute (m_swtch, downlink.str ());
+      SendBarrierRequest (m_swtch);
+      m_barriers.push_back (std::vector<Time> (1, Simulator::Now ()));
+    }
+  else
+    {
+      m_batch.push_back (CreateFlowMod (1, OXM_OF_IPV4_SRC, address, 2));
+      m_batch.push_back (CreateFlowMod (2, OXM_OF_IPV4_DST, address, 1));
+      m_batchAttaches.push_back (Simulator::Now ());
+      if (!m_batchEvent.IsRunning ())
+        {
+          m_batchEvent = Simulator::Schedule (m_batchInterval,
+                                              &AttachStormController::SendBatch, this);
+        }
+    }
+  m_cpuSeconds += std::chrono::duration<double> (std::chrono::steady_clock::now () - start).count ();
+}
+
+void
+AttachStormController::SendBatch (void)
+{
+  std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now ();
+  SendBatchToSwitch (m_swtch, m_batch);
+  for (size_t i = 0; i < m_batch.size (); i++)
+    {
+      ofl_msg_free (m_batch[i], 0);
+    }
+  m_batch.clear ();
+  m_barriers.push_back (m_batchAttaches);
+  m_batchAttaches.clear ();
+  m_cpuSeconds += std::chrono::duration<double> (std::chrono::steady_clock::now () - start).count ();
+}
+
+void
+AttachStormController::BarrierReply (uint64_t dpId, Time delay)
+{
+  // the barrier of the handshake comes before the storm
+  if (m_barriers.empty ())
+    {
+      return;
+    }
+  const std::vector<Time> &attaches = m_barriers.front ();
+  for (size_t i = 0; i < attaches.size (); i++)
+    {
+      m_latencies.push_back ((Simulator::Now () - attaches[i]).GetSeconds ());
+    }
+  m_barriers.pop_front ();
+}
+
+static uint32_t g_segments;
+
+static void
+CountSegment (Ptr<const Packet> packet, Ptr<Ipv4> ipv4, uint32_t interface)
+{
+  g_segments++;
+}
+
+static void
+RunStorm (uint32_t nUes, Time duration, Time batchInterval, std::string name)
+{
+  NodeContainer hosts;
+  hosts.Create (2);
+  Ptr<Node> switchNode = CreateObject<Node> ();
+  Ptr<Node> controllerNode = CreateObject<Node> ();
+
+  CsmaHelper csmaHelper;
+  NetDeviceContainer switchPorts;
+  for (uint32_t i = 0; i < 2; i++)
+    {
+      NetDeviceContainer link = csmaHelper.Install (NodeContainer (hosts.Get (i), switchNode));
+      switchPorts.Add (link.Get (1));
+    }
+
+  Time start = Seconds (1);
+  Ptr<AttachStormController> controller =
+    CreateObject<AttachStormController> (nUes, start, duration, batchInterval);
+  Ptr<OFSwitch13InternalHelper> of13Helper = CreateObject<OFSwitch13InternalHelper> ();
+  of13Helper->InstallController (controllerNode, controller);
+  of13Helper->InstallSwitch (switchNode, switchPorts);
+  of13Helper->CreateOpenFlowChannels ();
+
+  g_segments = 0;
+  std::ostringstream txPath;
+  txPath << "/NodeList/" << controllerNode->GetId () << "/$ns3::Ipv4L3Protocol/Tx";
+  Config::ConnectWithoutContext (txPath.str (), MakeCallback (&CountSegment));
+
+  Simulator::Stop (start + duration + Seconds (10));
+  Simulator::Run ();
+
+  std::vector<double> &latencies = controller->m_latencies;
+  NS_ABORT_MSG_IF (latencies.size () != nUes, name << ": " << latencies.size ()
+                   << " of the " << nUes << " UEs with their rules installed");
+  std::sort (latencies.begin (), latencies.end ());
+  double sum = 0;
+  for (size_t i = 0; i < latencies.size (); i++)
+    {
+      sum += latencies[i];
+    }
+  std::cout << name << ": " << controller->m_cpuSeconds * 1000 << " ms installing, "
+            << g_segments << " segments, setup latency mean "
+            << sum / nUes * 1000 << " ms, median "
+            << latencies[nUes / 2] * 1000 << " ms, 99th "
+            << latencies[nUes * 99 / 100] * 1000 << " ms, max "
+            << latencies.back () * 1000 << " ms" << std::endl;
+  Simulator::Destroy ();
+}
+
+int
+main (int argc, char *argv[])
+{
+  uint32_t nUes = 10000;
+  double duration = 1;
+  double batchInterval = 1;
+
+  CommandLine cmd;
+  cmd.AddValue ("nUes", "Number of UEs attaching", nUes);
+  cmd.AddValue ("duration", "Duration of the storm [s]", duration);
+  cmd.AddValue ("batchInterval", "Interval of the UEs sent in a batch [ms]", batchInterval);
+  cmd.Parse (argc, argv);
+
+  std::cout << nUes << " UEs attaching over " << duration << " s, 2 rules each" << std::endl;
+  RunStorm (nUes, Seconds (duration), Seconds (-1), "dpctl per rule");
+  RunStorm (nUes, Seconds (duration), MilliSeconds (batchInterval), "batches");
+  return 0;
+}
@@ -0,0 +1,211 @@
+/* -*-  Mode: C++; c-file-style: "gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * The backhaul fabric of the OvsPointToPointEpcHelper, carrying the S1-U
+ * traffic between the SGW/PGW and the eNBs over OpenFlow switches, whose
+ * ARP and IP rules (and select groups, where several shortest paths exist)
+ * are installed by the FabricController. The fabric is built:
+ * - as a spine-leaf fabric, the SGW/PGW on the first leaf;
+ * - as a ring, the SGW/PGW on the first switch;
+ * - from the TopologyFile (ofswitch13-fabric-topology.txt by default).
+ *
+ * For each, one UE per eNB exchanges UDP traffic with the remote host in
+ * both directions. The packets received by each end are printed, and the
+ * example aborts if the traffic of any UE was not delivered end to end.
+ *
+ *                                   Fabric Controller
+ *                                           |
+ *   Remote host === SGW/PGW === +-----------------------+ === eNB ~~~ UE
+ *                               | OpenFlow switch       | === eNB ~~~ UE
+ *                               | fabric                |  ...
+ *                               +-----------------------+ === eNB ~~~ UE
+ */
+
+#include <ns3/core-module.h>
+#include <ns3/network-module.h>
+#include <ns3/internet-module.h>
+#include <ns3/mobility-module.h>
+#include <ns3/applications-module.h>
+#include <ns3/point-to-point-module.h>
+#include <ns3/lte-module.h>
+#include <ns3/ofswitch13-module.h>
+#include <ns3/ovs-point-to-point-epc-helper.h>
+#include <iostream>
+
+using namespace ns3;
+
+NS_LOG_COMPONENT_DEFINE ("Ofswitch13Fabric");
+
+static const uint16_t g_dlPort = 1234;
+static const uint16_t g_ulPort = 2000;
+
+/**
+ * Build the LTE network over the backhaul fabric configured on the EPC
+ * helper, run the UDP traffic of the UEs, and check its delivery
+ * \param name the name of the fabric, for the output
+ * \param epcHelper the EPC helper, with the attributes of its fabric set
+ * \param nEnbs the number of eNBs, each with a single UE
+ * \param simTime the simulation time
+ */
+void
+RunFabric (std::string name, Ptr<OvsPointToPointEpcHelper> epcHelper,
+           uint16_t nEnbs, Time simTime)
+{
+  Ptr<LteHelper> lteHelper = CreateObject<LteHelper> ();
+  lteHelper->SetEpcHelper (epcHelper);
+
+  Ptr<Node> pgw = epcHelper->GetPgwNode ();
+
+  // remote host, beyond the SGi interface of the PGW
+  Ptr<Node> remoteHost = CreateObject<Node> ();
+  InternetStackHelper internet;
+  internet.Install (remoteHost);
+
+  PointToPointHelper p2ph;
+  p2ph.SetDeviceAttribute ("DataRate", DataRateValue (DataRate ("100Gb/s")));
+  p2ph.SetDeviceAttribute ("Mtu", UintegerValue (1500));
+  p2ph.SetChannelAttribute ("Delay", TimeValue (MilliSeconds (10)));
+  NetDeviceContainer internetDevices = p2ph.Install (pgw, remoteHost);
+  Ipv4AddressHelper ipv4h;
+  ipv4h.SetBase ("1.0.0.0", "255.0.0.0");
+  Ipv4InterfaceContainer internetIpIfaces = ipv4h.Assign (internetDevices);
+  Ipv4Address remoteHostAddr = internetIpIfaces.GetAddress (1);
+
+  Ipv4StaticRoutingHelper ipv4RoutingHelper;
+  Ptr<Ipv4StaticRouting> remoteHostStaticRouting =
+    ipv4RoutingHelper.GetStaticRouting (remoteHost->GetObject<Ipv4> ());
+  remoteHostStaticRouting->AddNetworkRouteTo (Ipv4Address ("7.0.0.0"), Ipv4Mask ("255.0.0.0"), 1);
+
+  NodeContainer enbNodes;
+  NodeContainer ueNodes;
+  enbNodes.Create (nEnbs);
+  ueNodes.Create (nEnbs);
+
+  Ptr<ListPositionAllocator> positionAlloc = CreateObject<ListPositionAllocator> ();
+  for (uint16_t i = 0; i < nEnbs; i++)
+    {
+      positionAlloc->Add (Vector (60.0 * i, 0, 0));
+    }
+  MobilityHelper mobility;
+  mobility.SetMobilityModel ("ns3::ConstantPositionMobilityModel");
+  mobility.SetPositionAllocator (positionAlloc);
+  mobility.Install (enbNodes);
+  mobility.Install (ueNodes);
+
+  // the fabric is built, and the eNBs attached to it, here
+  NetDeviceContainer enbLteDevs = lteHelper->InstallEnbDevice (enbNodes);
+  NetDeviceContainer ueLteDevs = lteHelper->InstallUeDevice (ueNodes);
+
+  internet.Install (ueNodes);
+  Ipv4InterfaceContainer ueIpIfaces = epcHelper->AssignUeIpv4Address (ueLteDevs);
+  for (uint16_t i = 0; i < nEnbs; i++)
+    {
+      Ptr<Ipv4StaticRouting> ueStaticRouting =
+        ipv4RoutingHelper.GetStaticRouting (ueNodes.Get (i)->GetObject<Ipv4> ());
+      ueStaticRouting->SetDefaultRoute (epcHelper->GetUeDefaultGatewayAddress (), 1);
+      lteHelper->Attach (ueLteDevs.Get (i), enbLteDevs.Get (i));
+    }
+
+  // a downlink and an uplink flow per UE, the uplink ones on distinct ports
+  ApplicationContainer dlSinks;
+  ApplicationContainer ulSinks;
+  ApplicationContainer clients;
+  for (uint16_t i = 0; i < nEnbs; i++)
+    {
+      PacketSinkHelper dlSinkHelper ("ns3::UdpSocketFactory",
+                                     InetSocketAddress (Ipv4Address::GetAny (), g_dlPort));
+      dlSinks.Add (dlSinkHelper.Install (ueNodes.Get (i)));
+      PacketSinkHelper ulSinkHelper ("ns3::UdpSocketFactory",
+                                     InetSocketAddress (Ipv4Address::GetAny (), g_ulPort + i));
+      ulSinks.Add (ulSinkHelper.Install (remoteHost));
+
+      UdpClientHelper dlClient (ueIpIfaces.GetAddress (i), g_dlPort);
+      dlClient.SetAttribute ("Interval", TimeValue (MilliSeconds (10)));
+      dlClient.SetAttribute ("MaxPackets", UintegerValue (1000000));
+      clients.Add (dlClient.Install (remoteHost));
+      UdpClientHelper ulClient (remoteHostAddr, g_ulPort + i);
+      ulClient.SetAttribute ("Interval", TimeValue (MilliSeconds (10)));
+      ulClient.SetAttribute ("MaxPackets", UintegerValue (1000000));
+      clients.Add (ulClient.Install (ueNodes.Get (i)));
+    }
+  // after the attach of the UEs and the handshake of the fabric switches
+  dlSinks.Start (MilliSeconds (100));
+  ulSinks.Start (MilliSeconds (100));
+  clients.Start (MilliSeconds (500));
+
+  Simulator::Stop (simTime);
+  Simulator::Run ();
+
+  std::cout << name << " fabric of " << epcHelper->GetFabricSwitches ().GetN ()
+            << " switches:" << std::endl;
+  for (uint16_t i = 0; i < nEnbs; i++)
+    {
+      uint64_t dlRx = DynamicCast<PacketSink> (dlSinks.Get (i))->GetTotalRx ();
+      uint64_t ulRx = DynamicCast<PacketSink> (ulSinks.Get (i))->GetTotalRx ();
+      std::cout << "  UE " << ueIpIfaces.GetAddress (i) << ": downlink " << dlRx
+                << " bytes, uplink " << ulRx << " bytes" << std::endl;
+      NS_ABORT_MSG_IF (dlRx == 0, name << " fabric: no downlink traffic delivered to UE "
+                       << ueIpIfaces.GetAddress (i));
+      NS_ABORT_MSG_IF (ulRx == 0, name << " fabric: no uplink traffic delivered from UE "
+                       << ueIpIfaces.GetAddress (i));
+    }
+
+  Simulator::Destroy ();
+}
+
+int
+main (int argc, char *argv[])
+{
+  uint16_t numEnbs = 4;
+  uint32_t numSpines = 2;
+  uint32_t numLeaves = 4;
+  uint32_t numRingSwitches = 4;
+  std::string topologyFile = "src/ofswitch13/examples/ofswitch13-fabric-topology.txt";
+  double simTime = 2;
+  bool verbose = false;
+
+  CommandLine cmd;
+  cmd.AddValue ("numEnbs", "Number of eNBs, each with a single UE", numEnbs);
+  cmd.AddValue ("numSpines", "Number of spine switches of the spine-leaf fabric", numSpines);
+  cmd.AddValue ("numLeaves", "Number of leaf switches of the spine-leaf fabric", numLeaves);
+  cmd.AddValue ("numRingSwitches", "Number of switches of the ring fabric", numRingSwitches);
+  cmd.AddValue ("topologyFile", "Topology file of the third fabric", topologyFile);
+  cmd.AddValue ("simTime", "Simulation time of each fabric [s]", simTime);
+  cmd.AddValue ("verbose", "Enable verbose output", verbose);
+  cmd.Parse (argc, argv);
+
+  if (verbose)
+    {
+      LogComponentEnable ("OvsPointToPointEpcHelper", LOG_LEVEL_INFO);
+      LogComponentEnable ("FabricController", LOG_LEVEL_INFO);
+    }
+
+  Ptr<OvsPointToPointEpcHelper> epcHelper = CreateObject<OvsPointToPointEpcHelper> ();
+  epcHelper->SetAttribute ("FabricTopology", EnumValue (OvsPointToPointEpcHelper::SPINE_LEAF));
+  epcHelper->SetAttribute ("NumSpines", UintegerValue (numSpines));
+  epcHelper->SetAttribute ("NumLeaves", UintegerValue (numLeaves));
+  RunFabric ("Spine-leaf", epcHelper, numEnbs, Seconds (simTime));
+
+  epcHelper = CreateObject<OvsPointToPointEpcHelper> ();
+  epcHelper->SetAttribute ("FabricTopology", EnumValue (OvsPointToPointEpcHelper::RING));
+  epcHelper->SetAttribute ("NumRingSwitches", UintegerValue (numRingSwitches));
+  RunFabric ("Ring", epcHelper, numEnbs, Seconds (simTime));
+
+  epcHelper = CreateObject<OvsPointToPointEpcHelper> ();
+  epcHelper->SetAttribute ("TopologyFile", StringValue (topologyFile));
+  RunFabric ("Topology file", epcHelper, numEnbs, Seconds (simTime));
+
+  return 0;
+}
@@ -0,0 +1,304 @@
+/* -*-  Mode: C++; c-file-style: "gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * Lookups per second of an ofsoftswitch13 flow table of 100 to 100k
+ * entries, against the scan of the entries in priority order that the
+ * table used before the tuple lookup, which must find the same entries.
+ *
+ * Most of the entries match a 5-tuple exactly, at priorities 1000 to 1999.
+ * The others match the input port and a destination address or prefix, or
+ * the VLAN ID and TCP port (looked up one by one), at lower priorities, and
+ * a few match everything. Most packets belong to the flow of an entry.
+ */
+
+#include <ns3/core-module.h>
+#include <ns3/ofswitch13-module.h>
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+#include <vector>
+
+using namespace ns3;
+
+struct Rule
+{
+  uint16_t priority;
+  uint8_t kind;       // 0: 5-tuple, 1: input port and destination, 2: VLAN ID, 3: all
+  uint8_t proto;
+  uint32_t src;
+  uint32_t dst;
+  uint32_t mask;
+  uint16_t sport;
+  uint16_t dport;
+  uint32_t port;
+  uint16_t vid;
+
+  bool operator< (const Rule &other) const
+  {
+    return priority < other.priority;
+  }
+};
+
+static Ptr<UniformRandomVariable> g_rng;
+
+static uint32_t
+Rnd (uint32_t n)
+{
+  return g_rng->GetInteger (0, n - 1);
+}
+
+static Rule
+RandomRule (void)
+{
+  Rule r;
+  uint32_t draw = Rnd (100);
+  r.kind = draw < 90 ? 0 : draw < 97 ? 1 : draw < 99 ? 2 : 3;
+  r.proto = Rnd (2) ? 6 : 17;
+  r.src = 0x0a000000 | Rnd (1 << 16);
+  r.dst = 0x0a000000 | Rnd (1 << 16);
+  r.mask = Rnd (2) ? 0xffffff00 : 0xffffffff;
+  r.sport = 1024 + Rnd (60000);
+  r.dport = Rnd (1024);
+  r.port = 1 + Rnd (4);
+  r.vid = Rnd (2) ? OFPVID_NONE : (OFPVID_PRESENT | Rnd (3));
+  switch (r.kind)
+    {
+    case 0:
+      r.priority = 1000 + Rnd (1000);
+      break;
+    case 1:
+      r.priority = 100 + Rnd (900);
+      break;
+    case 2:
+      r.priority = 100 + Rnd (1900);
+      break;
+    default:
+      r.priority = Rnd (2) ? 0 : 100 * Rnd (20);
+    }
+  return r;
+}
+
+static struct ofl_match_header *
+RuleMatch (const Rule &r)
+{
+  struct ofl_match *m = (struct ofl_match*)xmalloc (sizeof (struct ofl_match));
+  ofl_structs_match_init (m);
+  switch (r.kind)
+    {
+    case 0:
+      ofl_structs_match_put16 (m, OXM_OF_ETH_TYPE, 0x0800);
+      ofl_structs_match_put8 (m, OXM_OF_IP_PROTO, r.proto);
+      ofl_structs_match_put32 (m, OXM_OF_IPV4_SRC, r.src);
+      ofl_structs_match_put32 (m, OXM_OF_IPV4_DST, r.dst);
+      ofl_structs_match_put16 (m, r.proto == 6 ? OXM_OF_TCP_SRC : OXM_OF_UDP_SRC, r.sport);
+      ofl_structs_match_put16 (m, r.proto == 6 ? OXM_OF_TCP_DST : OXM_OF_UDP_DST, r.dport);
+      break;
+    case 1:
+      ofl_structs_match_put32 (m, OXM_OF_IN_PORT, r.port);
+      ofl_structs_match_put16 (m, OXM_OF_ETH_TYPE, 0x0800);
+      ofl_structs_match_put32m (m, OXM_OF_IPV4_DST_W, r.dst & r.mask, r.mask);
+      break;
+    case 2:
+      ofl_structs_match_put16 (m, OXM_OF_VLAN_VID, r.vid);
+      ofl_structs_match_put16 (m, OXM_OF_TCP_DST, r.dport);
+      break;
+    }
+  return (struct ofl_match_header*)m;
+}
+
+static ofl_err
+FlowMod (struct flow_table *table, const Rule &r, enum ofp_flow_mod_command command)
+{
+  struct ofl_msg_flow_mod mod;
+  memset (&mod, 0, sizeof (mod));
+  mod.header.type = OFPT_FLOW_MOD;
+  mod.command = command;
+  mod.priority = r.priority;
+  mod.buffer_id = OFP_NO_BUFFER;
+  mod.out_port = OFPP_ANY;
+  mod.out_group = OFPG_ANY;
+  mod.match = RuleMatch (r);
+
+  bool matchKept = false;
+  bool instsKept = false;
+  ofl_err error = flow_table_flow_mod (table, &mod, &matchKept, &instsKept);
+  if (!matchKept)
+    {
+      ofl_structs_free_match (mod.match, 0);
+    }
+  return error;
+}
+
+static struct packet *
+RandomPacket (const std::vector<Rule> &rules, struct ofpbuf *buffer)
+{
+  struct packet_handle_std *handle =
+    (struct packet_handle_std*)xcalloc (1, sizeof (struct packet_handle_std));
+  struct packet *pkt = (struct packet*)xcalloc (1, sizeof (struct packet));
+  pkt->buffer = buffer;
+  pkt->handle_std = handle;
+  handle->pkt = pkt;
+  handle->valid = true;
+
+  struct ofl_match *m = &handle->match;
+  ofl_structs_match_init (m);
+  ofl_structs_match_put32 (m, OXM_OF_IN_PORT, 1 + Rnd (4));
+  if (Rnd (10) == 0)
+    {
+      ofl_structs_match_put16 (m, OXM_OF_VLAN_VID, Rnd (3));
+    }
+  if (Rnd (20) == 0)
+    {
+      ofl_structs_match_put16 (m, OXM_OF_ETH_TYPE, 0x0806);
+      return pkt;
+    }
+  Rule r = RandomRule ();
+  if (Rnd (5))
+    {
+      // the flow of an entry, if it is still there
+      r = rules[Rnd (rules.size ())];
+    }
+  ofl_structs_match_put16 (m, OXM_OF_ETH_TYPE, 0x0800);
+  ofl_structs_match_put8 (m, OXM_OF_IP_PROTO, r.proto);
+  ofl_structs_match_put32 (m, OXM_OF_IPV4_SRC, r.src);
+  ofl_structs_match_put32 (m, OXM_OF_IPV4_DST, r.dst);
+  ofl_structs_match_put16 (m, r.proto == 6 ? OXM_OF_TCP_SRC : OXM_OF_UDP_SRC, r.sport);
+  ofl_structs_match_put16 (m, r.proto == 6 ? OXM_OF_TCP_DST : OXM_OF_UDP_DST, r.dport);
+  return pkt;
+}
+
+// The first entry of the table in priority order matching the packet
+static struct flow_entry *
+ScanLookup (struct flow_table *table, struct packet *pkt)
+{
+  struct flow_entry *entry;
+  LIST_FOR_EACH (entry, struct flow_entry, match_node, &table->match_entries)
+    {
+      if (packet_handle_std_match (pkt->handle_std, (struct ofl_match*)entry->stats->match))
+        {
+          return entry;
+        }
+    }
+  return 0;
+}
+
+int
+main (int argc, char *argv[])
+{
+  uint32_t nPackets = 2000;
+  double seconds = 1;
+
+  CommandLine cmd;
+  cmd.AddValue ("nPackets", "Number of packets looked up", nPackets);
+  cmd.AddValue ("seconds", "Minimum time of each lookup measurement", seconds);
+  cmd.Parse (argc, argv);
+
+  RngSeedManager::SetSeed (1);
+  RngSeedManager::SetRun (1);
+  g_rng = CreateObject<UniformRandomVariable> ();
+
+  struct datapath *dp = (struct datapath*)xcalloc (1, sizeof (struct datapath));
+  struct ofpbuf buffer;
+  memset (&buffer, 0, sizeof (buffer));
+  buffer.size = 1024;
+
+  uint32_t sizes[] = {100, 1000, 10000, 100000};
+  for (uint32_t s = 0; s < sizeof (sizes) / sizeof (sizes[0]); s++)
+    {
+      uint32_t size = sizes[s];
+      struct flow_table *table = flow_table_create (dp, 0);
+      table->features->max_entries = size;
+
+      // inserted from the lowest priority, so that each insertion stops at
+      // the first entries of the table
+      std::vector<Rule> rules;
+      for (uint32_t i = 0; i < size; i++)
+        {
+          rules.push_back (RandomRule ());
+        }
+      std::stable_sort (rules.begin (), rules.end ());
+      for (uint32_t i = 0; i < size; i++)
+        {
+          NS_ABORT_MSG_IF (FlowMod (table, rules[i], OFPFC_ADD) != 0, "flow mod failed");
+        }
+      // replace and delete a few of them
+      for (uint32_t i = 0; i < 100; i++)
+        {
+          FlowMod (table, rules[Rnd (size)], OFPFC_ADD);
+          FlowMod (table, rules[Rnd (size)], OFPFC_DELETE_STRICT);
+        }
+
+      std::vector<struct packet*> packets;
+      for (uint32_t i = 0; i < nPackets; i++)
+        {
+          packets.push_back (RandomPacket (rules, &buffer));
+        }
+
+      uint32_t nMatched = 0;
+      for (uint32_t i = 0; i < nPackets; i++)
+        {
+          struct flow_entry *expected = ScanLookup (table, packets[i]);
+          NS_ABORT_MSG_IF (flow_table_lookup (table, packets[i]) != expected,
+                           "packet " << i << " matched another entry than the scan in "
+                           "priority order, with " << size << " entries");
+          nMatched += (expected != 0);
+        }
+
+      double lookupRates[2];
+      for (uint32_t scan = 0; scan < 2; scan++)
+        {
+          uint64_t nLookups = 0;
+          std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now ();
+          double elapsed = 0;
+          while (elapsed < seconds)
+            {
+              for (uint32_t i = 0; i < nPackets; i++)
+                {
+                  if (scan)
+                    {
+                      ScanLookup (table, packets[i]);
+                    }
+                  else
+                    {
+                      flow_table_lookup (table, packets[i]);
+                    }
+                }
+              nLookups += nPackets;
+              elapsed = std::chrono::duration<double> (std::chrono::steady_clock::now () - start).count ();
+            }
+          lookupRates[scan] = nLookups / elapsed;
+        }
+
+      uint32_t nTuples = 0;
+      struct flow_tuple *tuple;
+      LIST_FOR_EACH (tuple, struct flow_tuple, node, &table->tuples)
+        {
+          nTuples++;
+        }
+      std::cout << table->stats->active_count << " entries in " << nTuples << " tuples, "
+                << nMatched << " of " << nPackets << " packets matched: "
+                << lookupRates[0] << " lookups/s, "
+                << lookupRates[1] << " lookups/s scanning in priority order" << std::endl;
+
+      for (uint32_t i = 0; i < nPackets; i++)
+        {
+          packet_handle_std_destroy (packets[i]->handle_std);
+          free (packets[i]);
+        }
+      flow_table_destroy (table);
+    }
+  free (dp);
+  return 0;
+}
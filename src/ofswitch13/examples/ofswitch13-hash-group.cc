@@ -0,0 +1,265 @@
+/* -*-  Mode: C++; c-file-style: "gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * The spread of flows by a flow hashing select group (type=hash) of the
+ * datapath, over the buckets of ports 2 and 3 of a switch. Host 0 sends a
+ * single UDP packet for each of nFlows flows, three times:
+ * - with weights 10:10, where each port gets half of the flows;
+ * - with weights 10:5, where port 2 gets two thirds of the flows, and only
+ *   the sixth of the flows moving from port 3 to port 2 changes port;
+ * - with weights 10:10, by a group with the buckets in the reverse order,
+ *   where every flow takes the same port as the first time.
+ *
+ * The shares of the ports and the flows moved are printed, and the example
+ * aborts if they differ from the above by more than the tolerance.
+ *
+ *                         Hash Controller
+ *                                |
+ *                       +-----------------+ === Host 1 (port 2)
+ *            Host 0 === | OpenFlow switch |
+ *                       +-----------------+ === Host 2 (port 3)
+ */
+
+#include <ns3/core-module.h>
+#include <ns3/network-module.h>
+#include <ns3/csma-module.h>
+#include <ns3/internet-module.h>
+#include <ns3/ofswitch13-module.h>
+#include <cmath>
+#include <iostream>
+#include <sstream>
+
+using namespace ns3;
+
+// Ports of the switch, in the order of installation
+static const uint32_t g_host0Port = 1;
+static const uint32_t g_ports[2] = {2, 3};
+
+static const uint64_t g_switch = 1;
+static const uint32_t g_groupId = 1;
+static const uint32_t g_reversedGroupId = 2;
+
+// The flows: source address and port
+static const uint32_t g_flowsPerAddress = 60000;
+static const uint16_t g_firstSourcePort = 1024;
+static const Ipv4Address g_firstSource ("10.0.0.1");
+static const Ipv4Address g_destination ("10.0.1.1");
+// The phase of a packet, by its destination port
+static const uint16_t g_firstDestinationPort = 5000;
+static const uint32_t g_numPhases = 3;
+
+class HashController : public SelectGroupController
+{
+public:
+  /**
+   * Set the weights of the buckets of ports 2 and 3.
+   * \param weight2 The weight of port 2.
+   * \param weight3 The weight of port 3.
+   */
+  void SetPortWeights (uint16_t weight2, uint16_t weight3);
+
+  /**
+   * Send the flows of Host 0 to the group with the buckets in the reverse
+   * order, with the same weights as the first one.
+   */
+  void UseReversedGroup (void);
+
+protected:
+  // Inherited from OFSwitch13Controller
+  void HandshakeSuccessful (Ptr<const RemoteSwitch> swtch);
+};
+
+void
+HashController::SetPortWeights (uint16_t weight2, uint16_t weight3)
+{
+  std::vector<uint16_t> weights;
+  weights.push_back (weight2);
+  weights.push_back (weight3);
+  SetSelectGroupWeights (g_switch, g_groupId, weights);
+}
+
+void
+HashController::UseReversedGroup (void)
+{
+  std::ostringstream cmd;
+  cmd << "flow-mod cmd=add,table=0,prio=100 in_port=" << g_host0Port
+      << " apply:group=" << g_reversedGroupId;
+  DpctlExecute (g_switch, cmd.str ());
+}
+
+void
+HashController::HandshakeSuccessful (Ptr<const RemoteSwitch> swtch)
+{
+  std::vector<uint32_t> ports (g_ports, g_ports + 2);
+  AddSelectGroup (swtch, g_groupId, ports, std::vector<uint16_t> (2, 10));
+  std::vector<uint32_t> reversedPorts (ports.rbegin (), ports.rend ());
+  AddSelectGroup (swtch, g_reversedGroupId, reversedPorts, std::vector<uint16_t> (2, 10));
+
+  std::ostringstream cmd;
+  cmd << "flow-mod cmd=add,table=0,prio=100 in_port=" << g_host0Port
+      << " apply:group=" << g_groupId;
+  DpctlExecute (swtch, cmd.str ());
+}
+
+// The port (index in g_ports) each flow took in each phase, -1 if none
+static std::vector<int> g_flowPorts[g_numPhases];
+static uint32_t g_duplicates;
+
+static void
+SendFlow (Ptr<NetDevice> device, uint32_t phase, uint32_t flow)
+{
+  Ptr<Packet> packet = Create<Packet> (64);
+  UdpHeader udp;
+  udp.SetSourcePort (g_firstSourcePort + flow % g_flowsPerAddress);
+  udp.SetDestinationPort (g_firstDestinationPort + phase);
+  packet->AddHeader (udp);
+  Ipv4Header ip;
+  ip.SetSource (Ipv4Address (g_firstSource.Get () + flow / g_flowsPerAddress));
+  ip.SetDestination (g_destination);
+  ip.SetProtocol (UdpL4Protocol::PROT_NUMBER);
+  ip.SetPayloadSize (packet->GetSize ());
+  ip.SetTtl (64);
+  packet->AddHeader (ip);
+  device->Send (packet, Mac48Address::GetBroadcast (), Ipv4L3Protocol::PROT_NUMBER);
+}
+
+static void
+HostRx (int port, Ptr<const Packet> frame)
+{
+  Ptr<Packet> packet = frame->Copy ();
+  EthernetHeader ethernet (false);
+  packet->RemoveHeader (ethernet);
+  Ipv4Header ip;
+  packet->RemoveHeader (ip);
+  UdpHeader udp;
+  packet->RemoveHeader (udp);
+
+  uint32_t phase = udp.GetDestinationPort () - g_firstDestinationPort;
+  uint32_t flow = (ip.GetSource ().Get () - g_firstSource.Get ()) * g_flowsPerAddress
+    + udp.GetSourcePort () - g_firstSourcePort;
+  NS_ABORT_MSG_IF (phase >= g_numPhases || flow >= g_flowPorts[phase].size (),
+                   "Unexpected packet at port " << g_ports[port]);
+  if (g_flowPorts[phase][flow] != -1)
+    {
+      g_duplicates++;
+    }
+  g_flowPorts[phase][flow] = port;
+}
+
+int
+main (int argc, char *argv[])
+{
+  uint32_t nFlows = 20000;
+  double tolerance = 0.02;
+
+  CommandLine cmd;
+  cmd.AddValue ("nFlows", "Number of flows of Host 0", nFlows);
+  cmd.AddValue ("tolerance", "Largest difference of a share from its expected value", tolerance);
+  cmd.Parse (argc, argv);
+  NS_ABORT_MSG_IF (nFlows == 0 || nFlows > 1000000, "From 1 to 1000000 flows");
+
+  // Flows hashed over the buckets, whose weights are set by the example only
+  Config::SetDefault ("ns3::SelectGroupController::FlowHashing", BooleanValue (true));
+  Config::SetDefault ("ns3::SelectGroupController::RebalanceInterval", TimeValue (Seconds (0)));
+
+  NodeContainer hosts;
+  hosts.Create (3);
+  Ptr<Node> switchNode = CreateObject<Node> ();
+  Ptr<Node> controllerNode = CreateObject<Node> ();
+
+  CsmaHelper csmaHelper;
+  csmaHelper.SetChannelAttribute ("DataRate", DataRateValue (DataRate ("10Gbps")));
+  csmaHelper.SetChannelAttribute ("Delay", TimeValue (MicroSeconds (10)));
+
+  // The ports are numbered in the order the links are installed
+  NetDeviceContainer switchPorts, hostDevices;
+  for (uint32_t i = 0; i < hosts.GetN (); i++)
+    {
+      NetDeviceContainer link = csmaHelper.Install (NodeContainer (hosts.Get (i), switchNode));
+      hostDevices.Add (link.Get (0));
+      switchPorts.Add (link.Get (1));
+    }
+
+  Ptr<HashController> controller = CreateObject<HashController> ();
+  Ptr<OFSwitch13InternalHelper> of13Helper = CreateObject<OFSwitch13InternalHelper> ();
+  of13Helper->InstallController (controllerNode, controller);
+  of13Helper->InstallSwitch (switchNode, switchPorts);
+  of13Helper->CreateOpenFlowChannels ();
+
+  for (int port = 0; port < 2; port++)
+    {
+      hostDevices.Get (port + 1)->TraceConnectWithoutContext ("MacRx", MakeBoundCallback (&HostRx, port));
+    }
+
+  // A phase every 2 seconds, its flows evenly spaced over 1 second, and the
+  // weights or the group changed between the phases
+  Time interval = Seconds (1) / nFlows;
+  for (uint32_t phase = 0; phase < g_numPhases; phase++)
+    {
+      g_flowPorts[phase].assign (nFlows, -1);
+      Time start = Seconds (1 + 2 * phase);
+      for (uint32_t flow = 0; flow < nFlows; flow++)
+        {
+          Simulator::Schedule (start + interval * flow, &SendFlow, hostDevices.Get (0), phase, flow);
+        }
+    }
+  Simulator::Schedule (Seconds (2.5), &HashController::SetPortWeights, controller, 10, 5);
+  Simulator::Schedule (Seconds (4.5), &HashController::UseReversedGroup, controller);
+
+  Simulator::Stop (Seconds (1 + 2 * g_numPhases));
+  Simulator::Run ();
+
+  std::string phaseNames[g_numPhases] = {"10:10", "10:5", "10:10 reversed"};
+  double expectedShares[g_numPhases] = {0.5, 2.0 / 3, 0.5};
+  for (uint32_t phase = 0; phase < g_numPhases; phase++)
+    {
+      uint32_t port2Flows = 0;
+      for (uint32_t flow = 0; flow < nFlows; flow++)
+        {
+          NS_ABORT_MSG_IF (g_flowPorts[phase][flow] == -1,
+                           "Flow " << flow << " lost with weights " << phaseNames[phase]);
+          port2Flows += g_flowPorts[phase][flow] == 0;
+        }
+      double share = static_cast<double> (port2Flows) / nFlows;
+      std::cout << "Weights " << phaseNames[phase] << ": port 2 " << 100 * share
+                << " %, port 3 " << 100 * (1 - share) << " % of " << nFlows
+                << " flows" << std::endl;
+      NS_ABORT_MSG_IF (std::fabs (share - expectedShares[phase]) > tolerance,
+                       "Share of port 2 not in proportion to its weight with weights "
+                       << phaseNames[phase]);
+    }
+  NS_ABORT_MSG_IF (g_duplicates > 0, g_duplicates << " flows received twice in a phase");
+
+  // from 10:10 to 10:5, only flows of port 3 move, a sixth of all at least
+  uint32_t moved = 0;
+  uint32_t movedToPort3 = 0;
+  uint32_t movedByReversal = 0;
+  for (uint32_t flow = 0; flow < nFlows; flow++)
+    {
+      moved += g_flowPorts[1][flow] != g_flowPorts[0][flow];
+      movedToPort3 += g_flowPorts[1][flow] == 1 && g_flowPorts[0][flow] == 0;
+      movedByReversal += g_flowPorts[2][flow] != g_flowPorts[0][flow];
+    }
+  double movedShare = static_cast<double> (moved) / nFlows;
+  std::cout << "From 10:10 to 10:5: " << 100 * movedShare << " % of the flows moved ("
+            << 100.0 / 6 << " % at least), " << movedToPort3 << " to port 3" << std::endl;
+  std::cout << "Buckets reversed: " << movedByReversal << " flows moved" << std::endl;
+  NS_ABORT_MSG_IF (movedShare > 1.0 / 6 + tolerance, "More flows moved than the change of the weights");
+  NS_ABORT_MSG_IF (movedToPort3 > 0, "Flows moved to the port whose weight decreased");
+  NS_ABORT_MSG_IF (movedByReversal > 0, "Flows moved by the order of the buckets");
+
+  Simulator::Destroy ();
+  return 0;
+}
@@ -0,0 +1,292 @@
+/* -*-  Mode: C++; c-file-style: "gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * The rebalance of a select group by the SelectGroupController, over two
+ * paths of equal speed between two switches. The traffic of Host 0 is spread
+ * over both paths by a select group with equal weights, while the traffic of
+ * Host 2 takes path A only, so that path A is the more loaded one.
+ *
+ * The controller picks up the speeds of the ports from their descriptions,
+ * and every RebalanceInterval moves weight from path A to path B until the
+ * loads (utilizations) of the paths differ by no more than the
+ * RebalanceHysteresis. The port speeds, each rebalance and the final loads
+ * are printed, and the example aborts if the weights did not move towards
+ * path B or the loads did not end within the hysteresis.
+ *
+ *                           Rebalance Controller
+ *                                    |
+ *            Host 0 === +----------+   path A   +----------+
+ *                       | Switch 0 | ========== | Switch 1 | === Host 1
+ *            Host 2 === +----------+ ========== +----------+
+ *                                      path B
+ */
+
+#include <ns3/core-module.h>
+#include <ns3/network-module.h>
+#include <ns3/csma-module.h>
+#include <ns3/applications-module.h>
+#include <ns3/ofswitch13-module.h>
+#include <cmath>
+#include <iostream>
+#include <sstream>
+
+using namespace ns3;
+
+// Ports of switch 0, in the order of installation
+static const uint32_t g_host0Port = 1;
+static const uint32_t g_pathAPort = 2;
+static const uint32_t g_pathBPort = 3;
+static const uint32_t g_host2Port = 4;
+
+// Datapath IDs of the switches, in the order of installation
+static const uint64_t g_switch0 = 1;
+static const uint64_t g_switch1 = 2;
+
+static const uint32_t g_groupId = 1;
+
+class RebalanceController : public SelectGroupController
+{
+public:
+  /**
+   * \param weight The initial weight of each path in the group.
+   */
+  RebalanceController (uint16_t weight);
+
+  /**
+   * \return The weights of path A and path B in the group.
+   */
+  std::vector<uint16_t> GetPathWeights (void) const;
+
+  // Inherited from SelectGroupController
+  ofl_err HandleMultipartReply (struct ofl_msg_multipart_reply_header *msg,
+                                Ptr<const RemoteSwitch> swtch, uint32_t xid);
+
+protected:
+  // Inherited from OFSwitch13Controller
+  void HandshakeSuccessful (Ptr<const RemoteSwitch> swtch);
+
+private:
+  uint16_t m_weight;
+};
+
+RebalanceController::RebalanceController (uint16_t weight)
+  : m_weight (weight)
+{
+}
+
+std::vector<uint16_t>
+RebalanceController::GetPathWeights (void) const
+{
+  return GetSelectGroupWeights (g_switch0, g_groupId);
+}
+
+ofl_err
+RebalanceController::HandleMultipartReply (
+  struct ofl_msg_multipart_reply_header *msg, Ptr<const RemoteSwitch> swtch,
+  uint32_t xid)
+{
+  if (msg->type == OFPMP_PORT_DESC)
+    {
+      struct ofl_msg_multipart_reply_port_desc *desc =
+        (struct ofl_msg_multipart_reply_port_desc*)msg;
+      for (size_t i = 0; i < desc->stats_num; i++)
+        {
+          std::cout << Simulator::Now ().GetSeconds () << " s: switch "
+                    << swtch->GetDpId () << " port " << desc->stats[i]->port_no
+                    << " speed " << desc->stats[i]->curr_speed << " kbps"
+                    << std::endl;
+        }
+    }
+  return SelectGroupController::HandleMultipartReply (msg, swtch, xid);
+}
+
+void
+RebalanceController::HandshakeSuccessful (Ptr<const RemoteSwitch> swtch)
+{
+  if (swtch->GetDpId () == g_switch0)
+    {
+      std::vector<uint32_t> ports;
+      ports.push_back (g_pathAPort);
+      ports.push_back (g_pathBPort);
+      AddSelectGroup (swtch, g_groupId, ports, std::vector<uint16_t> (2, m_weight));
+
+      std::ostringstream host0Cmd, host2Cmd;
+      host0Cmd << "flow-mod cmd=add,table=0,prio=100 in_port=" << g_host0Port
+                << " apply:group=" << g_groupId;
+      host2Cmd << "flow-mod cmd=add,table=0,prio=100 in_port=" << g_host2Port
+               << " apply:output=" << g_pathAPort;
+      DpctlExecute (swtch, host0Cmd.str ());
+      DpctlExecute (swtch, host2Cmd.str ());
+    }
+  else if (swtch->GetDpId () == g_switch1)
+    {
+      // Both paths end on ports 1 and 2 of switch 1, Host 1 on port 3
+      DpctlExecute (swtch, "flow-mod cmd=add,table=0,prio=100 in_port=1 apply:output=3");
+      DpctlExecute (swtch, "flow-mod cmd=add,table=0,prio=100 in_port=2 apply:output=3");
+    }
+}
+
+static Ptr<RebalanceController> g_controller;
+static uint32_t g_rebalances;
+static bool g_towardsPathB = true;
+
+static void
+Rebalance (uint64_t dpId, uint32_t groupId, uint32_t fromPort, uint32_t toPort,
+           double fromLoad, double toLoad)
+{
+  std::vector<uint16_t> weights = g_controller->GetPathWeights ();
+  std::cout << Simulator::Now ().GetSeconds () << " s: switch " << dpId
+            << " group " << groupId << " port " << fromPort << " load "
+            << fromLoad << " -> port " << toPort << " load " << toLoad
+            << ", weights path A " << weights[0] << " path B " << weights[1]
+            << std::endl;
+  g_rebalances++;
+  g_towardsPathB = g_towardsPathB && fromPort == g_pathAPort && toPort == g_pathBPort;
+}
+
+static uint64_t g_pathBytes[2];
+static Time g_measureStart;
+
+static void
+PathTx (uint32_t path, Ptr<const Packet> packet)
+{
+  if (Simulator::Now () >= g_measureStart)
+    {
+      g_pathBytes[path] += packet->GetSize ();
+    }
+}
+
+int
+main (int argc, char *argv[])
+{
+  uint16_t weight = 10;
+  double hysteresis = 0.1;
+  double simTime = 20;
+  std::string linkRate = "100Mbps";
+  std::string host0Rate = "60Mbps";
+  std::string host2Rate = "30Mbps";
+
+  CommandLine cmd;
+  cmd.AddValue ("weight", "Initial weight of each path", weight);
+  cmd.AddValue ("hysteresis", "Load difference for a rebalance", hysteresis);
+  cmd.AddValue ("simTime", "Simulation time [s]", simTime);
+  cmd.AddValue ("linkRate", "Data rate of the links", linkRate);
+  cmd.AddValue ("host0Rate", "Traffic of Host 0 over both paths", host0Rate);
+  cmd.AddValue ("host2Rate", "Traffic of Host 2 over path A", host2Rate);
+  cmd.Parse (argc, argv);
+
+  // Packets are taken in turn by the buckets, in proportion to their
+  // weights: the traffic of a single host is a single flow
+  Config::SetDefault ("ns3::SelectGroupController::FlowHashing", BooleanValue (false));
+  Config::SetDefault ("ns3::SelectGroupController::RebalanceInterval", TimeValue (Seconds (1)));
+  Config::SetDefault ("ns3::SelectGroupController::RebalanceHysteresis", DoubleValue (hysteresis));
+  Config::SetDefault ("ns3::SelectGroupController::RebalanceStep", UintegerValue (1));
+
+  NodeContainer hosts;
+  hosts.Create (3);
+  NodeContainer switches;
+  switches.Create (2);
+  Ptr<Node> controllerNode = CreateObject<Node> ();
+
+  CsmaHelper csmaHelper;
+  csmaHelper.SetChannelAttribute ("DataRate", DataRateValue (DataRate (linkRate)));
+  csmaHelper.SetChannelAttribute ("Delay", TimeValue (MicroSeconds (10)));
+
+  // The ports are numbered in the order the links are installed
+  NetDeviceContainer switch0Ports, switch1Ports, hostDevices;
+  NetDeviceContainer link = csmaHelper.Install (NodeContainer (hosts.Get (0), switches.Get (0)));
+  hostDevices.Add (link.Get (0));
+  switch0Ports.Add (link.Get (1));
+  Ptr<NetDevice> pathDevices[2];
+  for (uint32_t path = 0; path < 2; path++)
+    {
+      link = csmaHelper.Install (NodeContainer (switches.Get (0), switches.Get (1)));
+      switch0Ports.Add (link.Get (0));
+      switch1Ports.Add (link.Get (1));
+      pathDevices[path] = link.Get (0);
+    }
+  link = csmaHelper.Install (NodeContainer (hosts.Get (2), switches.Get (0)));
+  hostDevices.Add (link.Get (0));
+  switch0Ports.Add (link.Get (1));
+  link = csmaHelper.Install (NodeContainer (hosts.Get (1), switches.Get (1)));
+  hostDevices.Add (link.Get (0));
+  switch1Ports.Add (link.Get (1));
+
+  g_controller = CreateObject<RebalanceController> (weight);
+  g_controller->TraceConnectWithoutContext ("Rebalance", MakeCallback (&Rebalance));
+  Ptr<OFSwitch13InternalHelper> of13Helper = CreateObject<OFSwitch13InternalHelper> ();
+  of13Helper->InstallController (controllerNode, g_controller);
+  of13Helper->InstallSwitch (switches.Get (0), switch0Ports);
+  of13Helper->InstallSwitch (switches.Get (1), switch1Ports);
+  of13Helper->CreateOpenFlowChannels ();
+
+  // Ethernet frames from Host 0 and Host 2 to Host 1, with no IP stack
+  PacketSocketHelper packetSocket;
+  packetSocket.Install (hosts);
+  PacketSocketAddress sinkAddress;
+  sinkAddress.SetSingleDevice (hostDevices.Get (2)->GetIfIndex ());
+  sinkAddress.SetPhysicalAddress (hostDevices.Get (2)->GetAddress ());
+  sinkAddress.SetProtocol (0x88b5);
+  PacketSinkHelper sinkHelper ("ns3::PacketSocketFactory", sinkAddress);
+  sinkHelper.Install (hosts.Get (1));
+
+  Time trafficStart = Seconds (1);
+  Time trafficStop = Seconds (simTime - 1);
+  std::string rates[2] = { host0Rate, host2Rate };
+  for (uint32_t i = 0; i < 2; i++)
+    {
+      PacketSocketAddress address = sinkAddress;
+      address.SetSingleDevice (hostDevices.Get (i)->GetIfIndex ());
+      OnOffHelper onOffHelper ("ns3::PacketSocketFactory", address);
+      onOffHelper.SetConstantRate (DataRate (rates[i]), 1000);
+      ApplicationContainer app = onOffHelper.Install (hosts.Get (i == 0 ? 0 : 2));
+      app.Start (trafficStart);
+      app.Stop (trafficStop);
+    }
+
+  // The loads of the paths over the last quarter of the traffic
+  g_measureStart = trafficStop - (trafficStop - trafficStart) / 4;
+  for (uint32_t path = 0; path < 2; path++)
+    {
+      pathDevices[path]->TraceConnectWithoutContext (
+        "PhyTxEnd", MakeBoundCallback (&PathTx, path));
+    }
+
+  std::cout << "Path A: " << host0Rate << " of Host 0 by the group, "
+            << host2Rate << " of Host 2; path B: " << host0Rate
+            << " of Host 0 by the group; links at " << linkRate << std::endl;
+  Simulator::Stop (Seconds (simTime));
+  Simulator::Run ();
+
+  std::vector<uint16_t> weights = g_controller->GetPathWeights ();
+  double seconds = (trafficStop - g_measureStart).GetSeconds ();
+  double speed = DataRate (linkRate).GetBitRate ();
+  double loadA = 8 * g_pathBytes[0] / seconds / speed;
+  double loadB = 8 * g_pathBytes[1] / seconds / speed;
+  std::cout << g_rebalances << " rebalances, final weights path A "
+            << weights[0] << " path B " << weights[1] << ", final loads path A "
+            << loadA << " path B " << loadB << std::endl;
+
+  NS_ABORT_MSG_IF (g_rebalances == 0 || weights[0] >= weight,
+                   "The weights did not move away from the more loaded path");
+  NS_ABORT_MSG_IF (!g_towardsPathB,
+                   "The weights moved towards the more loaded path");
+  NS_ABORT_MSG_IF (std::fabs (loadA - loadB) > hysteresis,
+                   "The loads of the paths differ by more than the hysteresis");
+
+  g_controller = 0;
+  Simulator::Destroy ();
+  return 0;
+}
@@ -0,0 +1,239 @@
+/* -*-  Mode: C++; c-file-style: "gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "fabric-controller.h"
+#include <ns3/log.h>
+#include <ns3/uinteger.h>
+#include <algorithm>
+#include <cmath>
+#include <deque>
+#include <sstream>
+
+namespace ns3 {
+
+NS_LOG_COMPONENT_DEFINE ("FabricController");
+NS_OBJECT_ENSURE_REGISTERED (FabricController);
+
+FabricController::FabricController ()
+{
+  NS_LOG_FUNCTION (this);
+}
+
+FabricController::~FabricController ()
+{
+  NS_LOG_FUNCTION (this);
+}
+
+void
+FabricController::DoDispose ()
+{
+  NS_LOG_FUNCTION (this);
+
+  m_hosts.clear ();
+  m_links.clear ();
+  m_hops.clear ();
+  SelectGroupController::DoDispose ();
+}
+
+TypeId
+FabricController::GetTypeId (void)
+{
+  static TypeId tid = TypeId ("ns3::FabricController")
+    .SetParent<SelectGroupController> ()
+    .SetGroupName ("OFSwitch13")
+    .AddConstructor<FabricController> ()
+    .AddAttribute ("PathWeight",
+                   "Weight of the path with the fastest link in the group "
+                   "of the shortest paths to a host. The other paths get "
+                   "weights in proportion to the rates of their links.",
+                   UintegerValue (10),
+                   MakeUintegerAccessor (&FabricController::m_pathWeight),
+                   MakeUintegerChecker<uint16_t> (1))
+  ;
+  return tid;
+}
+
+void
+FabricController::AddLink (uint64_t dpId1, uint32_t port1,
+                           uint64_t dpId2, uint32_t port2, DataRate rate)
+{
+  NS_LOG_FUNCTION (this << dpId1 << port1 << dpId2 << port2 << rate);
+
+  LinkEnd end1 = {port1, dpId2, rate.GetBitRate ()};
+  LinkEnd end2 = {port2, dpId1, rate.GetBitRate ()};
+  m_links[dpId1].push_back (end1);
+  m_links[dpId2].push_back (end2);
+  m_hops.clear ();
+}
+
+void
+FabricController::AddHost (Ipv4Address address, uint64_t dpId, uint32_t port)
+{
+  NS_LOG_FUNCTION (this << address << dpId << port);
+
+  Host host = {address, dpId, port};
+  m_hosts.push_back (host);
+  m_links[dpId];
+
+  LinkMap_t::const_iterator it;
+  for (it = m_links.begin (); it != m_links.end (); it++)
+    {
+      Ptr<const RemoteSwitch> swtch = GetRemoteSwitch (it->first);
+      if (swtch)
+        {
+          ConfigureHost (swtch, m_hosts.size () - 1);
+        }
+    }
+}
+
+void
+FabricController::HandshakeSuccessful (Ptr<const RemoteSwitch> swtch)
+{
+  NS_LOG_FUNCTION (this << swtch);
+
+  for (uint32_t i = 0; i < m_hosts.size (); i++)
+    {
+      ConfigureHost (swtch, i);
+    }
+}
+
+void
+FabricController::ConfigureHost (Ptr<const RemoteSwitch> swtch,
+                                 uint32_t hostIndex)
+{
+  NS_LOG_FUNCTION (this << swtch << hostIndex);
+
+  const Host &host = m_hosts[hostIndex];
+  std::vector<uint32_t> ports = GetNextPorts (swtch->GetDpId (), host);
+  if (ports.empty ())
+    {
+      NS_LOG_WARN ("No path from switch " << swtch->GetDpId () <<
+                   " to host " << host.address);
+      return;
+    }
+
+  std::ostringstream action;
+  if (ports.size () == 1)
+    {
+      action << "apply:output=" << ports[0];
+    }
+  else
+    {
+      // One group per host, over the shortest paths to it
+      uint32_t groupId = hostIndex + 1;
+      AddSelectGroup (swtch, groupId, ports,
+                      GetPathWeights (swtch->GetDpId (), ports));
+      action << "apply:group=" << groupId;
+    }
+
+  std::ostringstream ipCmd, arpCmd;
+  ipCmd << "flow-mod cmd=add,table=0,prio=100 eth_type=0x0800,ip_dst="
+        << host.address << " " << action.str ();
+  arpCmd << "flow-mod cmd=add,table=0,prio=100 eth_type=0x0806,arp_tpa="
+         << host.address << " " << action.str ();
+  DpctlExecute (swtch, ipCmd.str ());
+  DpctlExecute (swtch, arpCmd.str ());
+}
+
+std::vector<uint32_t>
+FabricController::GetNextPorts (uint64_t dpId, const Host &host)
+{
+  NS_LOG_FUNCTION (this << dpId << host.address);
+
+  std::vector<uint32_t> ports;
+  if (dpId == host.dpId)
+    {
+      ports.push_back (host.port);
+      return ports;
+    }
+
+  // Hop counts to the switch of the host, by a breadth-first search
+  HopsMap_t::iterator it = m_hops.find (host.dpId);
+  if (it == m_hops.end ())
+    {
+      it = m_hops.insert (std::make_pair (host.dpId, std::map<uint64_t, uint32_t> ())).first;
+      std::map<uint64_t, uint32_t> &hops = it->second;
+      std::deque<uint64_t> queue;
+      hops[host.dpId] = 0;
+      queue.push_back (host.dpId);
+      while (!queue.empty ())
+        {
+          uint64_t current = queue.front ();
+          queue.pop_front ();
+          const std::vector<LinkEnd> &ends = m_links[current];
+          for (uint32_t i = 0; i < ends.size (); i++)
+            {
+              if (hops.find (ends[i].peer) == hops.end ())
+                {
+                  hops[ends[i].peer] = hops[current] + 1;
+                  queue.push_back (ends[i].peer);
+                }
+            }
+        }
+    }
+
+  std::map<uint64_t, uint32_t> &hops = it->second;
+  std::map<uint64_t, uint32_t>::const_iterator own = hops.find (dpId);
+  if (own == hops.end ())
+    {
+      return ports;
+    }
+  const std::vector<LinkEnd> &ends = m_links[dpId];
+  for (uint32_t i = 0; i < ends.size (); i++)
+    {
+      if (hops[ends[i].peer] + 1 == own->second)
+        {
+          ports.push_back (ends[i].port);
+        }
+    }
+  return ports;
+}
+
+std::vector<uint16_t>
+FabricController::GetPathWeights (uint64_t dpId,
+                                  const std::vector<uint32_t> &ports)
+{
+  NS_LOG_FUNCTION (this << dpId);
+
+  const std::vector<LinkEnd> &ends = m_links[dpId];
+  std::vector<uint64_t> rates (ports.size (), 0);
+  uint64_t maxRate = 0;
+  for (uint32_t i = 0; i < ports.size (); i++)
+    {
+      for (uint32_t j = 0; j < ends.size (); j++)
+        {
+          if (ends[j].port == ports[i])
+            {
+              rates[i] = ends[j].rate;
+            }
+        }
+      maxRate = std::max (maxRate, rates[i]);
+    }
+
+  // A link of unknown rate is taken as fast as the fastest one
+  std::vector<uint16_t> weights (ports.size (), m_pathWeight);
+  for (uint32_t i = 0; i < ports.size (); i++)
+    {
+      if (rates[i] != 0)
+        {
+          double share = (double)rates[i] / maxRate;
+          weights[i] = std::max<uint16_t> (1, std::round (m_pathWeight * share));
+        }
+    }
+  return weights;
+}
+
+} // namespace ns3
@@ -0,0 +1,138 @@
+/* -*-  Mode: C++; c-file-style: "gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef FABRIC_CONTROLLER_H
+#define FABRIC_CONTROLLER_H
+
+#include <ns3/ofswitch13-module.h>
+#include <ns3/ipv4-address.h>
+#include <ns3/data-rate.h>
+#include "select-group-controller.h"
+#include <map>
+#include <vector>
+
+namespace ns3 {
+
+/**
+ * \ingroup ofswitch13
+ * \brief An OpenFlow 1.3 controller for a transport fabric of any topology
+ *
+ * The controller is told the links between the switches and the hosts
+ * attached to them, and forwards the IPv4 packets of each host, and the ARP
+ * packets for its address, along the shortest paths of the fabric: there is
+ * no flooding, so the topology may have loops. Where a switch has more than
+ * one shortest path to a host, the packets are spread over them by a select
+ * group, each path weighted by the rate of its link from the switch: the
+ * fastest one gets PathWeight, the others a proportional share of it, at
+ * least 1. The links further along the paths are not looked at. From then
+ * on, the weights follow the loads of the ports as SelectGroupController
+ * rebalances them.
+ */
+class FabricController : public SelectGroupController
+{
+public:
+  FabricController ();          //!< Default constructor.
+  virtual ~FabricController (); //!< Dummy destructor.
+
+  /** Destructor implementation */
+  virtual void DoDispose ();
+
+  /**
+   * Register this type.
+   * \return The object TypeId.
+   */
+  static TypeId GetTypeId (void);
+
+  /**
+   * Notify a link between two switches of the fabric.
+   * \param dpId1 The datapath ID of the first switch.
+   * \param port1 The port of the link on the first switch.
+   * \param dpId2 The datapath ID of the second switch.
+   * \param port2 The port of the link on the second switch.
+   * \param rate The data rate of the link.
+   */
+  void AddLink (uint64_t dpId1, uint32_t port1, uint64_t dpId2, uint32_t port2,
+                DataRate rate);
+
+  /**
+   * Notify a host attached to a switch of the fabric. The rules of the host
+   * are installed on the switches already connected to the controller, and on
+   * the others at the handshake.
+   * \param address The IPv4 address of the host.
+   * \param dpId The datapath ID of the switch.
+   * \param port The port of the host on the switch.
+   */
+  void AddHost (Ipv4Address address, uint64_t dpId, uint32_t port);
+
+protected:
+  // Inherited from OFSwitch13Controller
+  void HandshakeSuccessful (Ptr<const RemoteSwitch> swtch);
+
+private:
+  /** A host of the fabric */
+  struct Host
+  {
+    Ipv4Address address; //!< IPv4 address.
+    uint64_t    dpId;    //!< Switch of the host.
+    uint32_t    port;    //!< Port of the host on the switch.
+  };
+
+  /** The end of a link on a switch */
+  struct LinkEnd
+  {
+    uint32_t port;       //!< Port of the link on the switch.
+    uint64_t peer;       //!< Switch at the other end.
+    uint64_t rate;       //!< Data rate of the link [bps].
+  };
+
+  /**
+   * Install the rules of a host on a switch.
+   * \param swtch The switch information.
+   * \param hostIndex The index of the host in m_hosts.
+   */
+  void ConfigureHost (Ptr<const RemoteSwitch> swtch, uint32_t hostIndex);
+
+  /**
+   * \param dpId The datapath ID of a switch.
+   * \param host The host.
+   * \return The ports of the switch on the shortest paths to the host.
+   */
+  std::vector<uint32_t> GetNextPorts (uint64_t dpId, const Host &host);
+
+  /**
+   * \param dpId The datapath ID of a switch.
+   * \param ports The ports of the switch on the shortest paths to a host.
+   * \return The weights of the ports in the group of the host.
+   */
+  std::vector<uint16_t> GetPathWeights (uint64_t dpId,
+                                        const std::vector<uint32_t> &ports);
+
+  uint16_t m_pathWeight; //!< Weight of the fastest path of a group
+
+  /** Hosts, in the order they were added */
+  std::vector<Host> m_hosts;
+
+  /** Map saving <datapath ID / link ends on the switch> */
+  typedef std::map<uint64_t, std::vector<LinkEnd> > LinkMap_t;
+  LinkMap_t m_links;
+
+  /** Map saving <datapath ID / hops from that switch, per switch> */
+  typedef std::map<uint64_t, std::map<uint64_t, uint32_t> > HopsMap_t;
+  HopsMap_t m_hops;   //!< Hop counts of the switches of the hosts.
+};
+
+} // namespace ns3
+#endif /* FABRIC_CONTROLLER_H */
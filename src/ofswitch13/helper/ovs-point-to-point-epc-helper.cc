@@ -49,12 +49,15 @@
 #include <ns3/ofswitch13-module.h>
 #include <ns3/internet-apps-module.h>
 
-#include <ns3/qos-controller.h> // dhson
+#include <ns3/fabric-controller.h>
 
 //#include "../examples/ofswitch13-qos-controller/qos-controller.h"
 //#include "qos-controller.h"
 
 #include "iostream"
+#include <algorithm>
+#include <fstream>
+#include <sstream>
 
 using namespace std;
 
@@ -67,7 +70,9 @@ NS_OBJECT_ENSURE_REGISTERED (OvsPointToPointEpcHelper);
 int cnt_tmp=0;
 
 OvsPointToPointEpcHelper::OvsPointToPointEpcHelper () 
-  : m_gtpuUdpPort (2152)  // fixed by the standard
+  : m_gtpuUdpPort (2152),  // fixed by the standard
+    m_pgwSwitch (0),
+    m_nFabricEnbs (0)
 {
   NS_LOG_FUNCTION (this);
 
@@ -80,6 +85,9 @@ OvsPointToPointEpcHelper::OvsPointToPointEpcHelper ()
 
   m_x2Ipv4AddressHelper.SetBase ("12.0.0.0", "255.255.255.252");
 
+  // the SGW/PGW node and the eNBs share the network of the backhaul fabric
+  m_fabricIpv4AddressHelper.SetBase ("10.1.0.0", "255.255.0.0");
+
   // we use a /8 net for all UEs
   m_ueAddressHelper.SetBase ("7.0.0.0", "255.0.0.0");
   
@@ -165,6 +173,42 @@ OvsPointToPointEpcHelper::GetTypeId (void)
                    UintegerValue (3000),
                    MakeUintegerAccessor (&OvsPointToPointEpcHelper::m_x2LinkMtu),
                    MakeUintegerChecker<uint16_t> ())
+    .AddAttribute ("FabricTopology",
+                   "The topology of the backhaul fabric of the S1-U links, unless read from the TopologyFile",
+                   EnumValue (OvsPointToPointEpcHelper::SPINE_LEAF),
+                   MakeEnumAccessor (&OvsPointToPointEpcHelper::m_fabricTopology),
+                   MakeEnumChecker (OvsPointToPointEpcHelper::SPINE_LEAF, "SpineLeaf",
+                                    OvsPointToPointEpcHelper::RING, "Ring"))
+    .AddAttribute ("TopologyFile",
+                   "The file of the topology of the backhaul fabric, with lines 'link <switch> <switch> [<data rate> [<delay>]]', 'pgw <switch>' and 'enb <switch> ...'. If empty, the FabricTopology is built.",
+                   StringValue (""),
+                   MakeStringAccessor (&OvsPointToPointEpcHelper::m_topologyFile),
+                   MakeStringChecker ())
+    .AddAttribute ("NumSpines",
+                   "The number of spine switches of the spine-leaf fabric",
+                   UintegerValue (2),
+                   MakeUintegerAccessor (&OvsPointToPointEpcHelper::m_nSpines),
+                   MakeUintegerChecker<uint32_t> (1))
+    .AddAttribute ("NumLeaves",
+                   "The number of leaf switches of the spine-leaf fabric. The SGW/PGW is attached to the first one, and the eNBs to all of them in turn.",
+                   UintegerValue (4),
+                   MakeUintegerAccessor (&OvsPointToPointEpcHelper::m_nLeaves),
+                   MakeUintegerChecker<uint32_t> (1))
+    .AddAttribute ("NumRingSwitches",
+                   "The number of switches of the ring fabric. The SGW/PGW is attached to the first one, and the eNBs to all of them in turn.",
+                   UintegerValue (4),
+                   MakeUintegerAccessor (&OvsPointToPointEpcHelper::m_nRingSwitches),
+                   MakeUintegerChecker<uint32_t> (1))
+    .AddAttribute ("FabricLinkDataRate",
+                   "The data rate of the links between the switches of the fabric",
+                   DataRateValue (DataRate ("10Gb/s")),
+                   MakeDataRateAccessor (&OvsPointToPointEpcHelper::m_fabricLinkDataRate),
+                   MakeDataRateChecker ())
+    .AddAttribute ("FabricLinkDelay",
+                   "The delay of the links between the switches of the fabric",
+                   TimeValue (Seconds (0)),
+                   MakeTimeAccessor (&OvsPointToPointEpcHelper::m_fabricLinkDelay),
+                   MakeTimeChecker ())
   ;
   return tid;
 }
@@ -177,12 +221,187 @@ OvsPointToPointEpcHelper::DoDispose ()
   m_tunDevice = 0;
   m_sgwPgwApp = 0;  
   m_sgwPgw->Dispose ();
+  m_fabricController = 0;
+  m_ofHelper = 0;
+}
+
+uint32_t
+OvsPointToPointEpcHelper::ReadTopologyFile (std::vector<FabricLink> &links)
+{
+  NS_LOG_FUNCTION (this << m_topologyFile);
+
+  std::ifstream file (m_topologyFile.c_str ());
+  NS_ABORT_MSG_IF (!file.is_open (), "Topology file " << m_topologyFile << " not found");
+
+  uint32_t nSwitches = 0;
+  bool pgwRead = false;
+  std::string line;
+  for (uint32_t lineNo = 1; std::getline (file, line); lineNo++)
+    {
+      std::istringstream stream (line.substr (0, line.find ('#')));
+      std::string keyword;
+      if (!(stream >> keyword))
+        {
+          continue;
+        }
+      std::vector<uint32_t> switches;
+      if (keyword == "link")
+        {
+          FabricLink link;
+          link.dataRate = m_fabricLinkDataRate;
+          link.delay = m_fabricLinkDelay;
+          NS_ABORT_MSG_IF (!(stream >> link.switch1 >> link.switch2),
+                           m_topologyFile << ":" << lineNo << ": two switches expected");
+          std::string dataRate, delay;
+          if (stream >> dataRate)
+            {
+              link.dataRate = DataRate (dataRate);
+            }
+          if (stream >> delay)
+            {
+              link.delay = Time (delay);
+            }
+          links.push_back (link);
+          switches.push_back (link.switch1);
+          switches.push_back (link.switch2);
+        }
+      else if (keyword == "pgw")
+        {
+          NS_ABORT_MSG_IF (!(stream >> m_pgwSwitch), m_topologyFile << ":" << lineNo << ": a switch expected");
+          pgwRead = true;
+          switches.push_back (m_pgwSwitch);
+        }
+      else if (keyword == "enb")
+        {
+          uint32_t enbSwitch;
+          while (stream >> enbSwitch)
+            {
+              m_enbSwitches.push_back (enbSwitch);
+              switches.push_back (enbSwitch);
+            }
+          NS_ABORT_MSG_IF (switches.empty (), m_topologyFile << ":" << lineNo << ": a switch expected");
+        }
+      else
+        {
+          NS_FATAL_ERROR (m_topologyFile << ":" << lineNo << ": unknown keyword " << keyword);
+        }
+      for (uint32_t i = 0; i < switches.size (); i++)
+        {
+          nSwitches = std::max (nSwitches, switches[i] + 1);
+        }
+    }
+  NS_ABORT_MSG_IF (nSwitches == 0, "Topology file " << m_topologyFile << " without any switch");
+  if (!pgwRead)
+    {
+      m_pgwSwitch = 0;
+    }
+  if (m_enbSwitches.empty ())
+    {
+      for (uint32_t i = 0; i < nSwitches; i++)
+        {
+          m_enbSwitches.push_back (i);
+        }
+    }
+  return nSwitches;
+}
+
+void
+OvsPointToPointEpcHelper::CreateFabric ()
+{
+  NS_LOG_FUNCTION (this);
+
+  std::vector<FabricLink> links;
+  uint32_t nSwitches;
+  if (!m_topologyFile.empty ())
+    {
+      nSwitches = ReadTopologyFile (links);
+    }
+  else if (m_fabricTopology == SPINE_LEAF)
+    {
+      // spines first, then leaves
+      nSwitches = m_nSpines + m_nLeaves;
+      for (uint32_t leaf = m_nSpines; leaf < nSwitches; leaf++)
+        {
+          for (uint32_t spine = 0; spine < m_nSpines; spine++)
+            {
+              FabricLink link = {leaf, spine, m_fabricLinkDataRate, m_fabricLinkDelay};
+              links.push_back (link);
+            }
+          m_enbSwitches.push_back (leaf);
+        }
+      m_pgwSwitch = m_nSpines;
+    }
+  else
+    {
+      nSwitches = m_nRingSwitches;
+      for (uint32_t i = 0; i < nSwitches; i++)
+        {
+          // a ring of two switches is a single link
+          if (nSwitches > 2 || (nSwitches == 2 && i == 0))
+            {
+              FabricLink link = {i, (i + 1) % nSwitches, m_fabricLinkDataRate, m_fabricLinkDelay};
+              links.push_back (link);
+            }
+          m_enbSwitches.push_back (i);
+        }
+      m_pgwSwitch = 0;
+    }
+
+  m_fabricSwitches.Create (nSwitches);
+  std::vector<NetDeviceContainer> switchPorts (nSwitches);
+  std::vector<uint32_t> linkPorts;
+
+  CsmaHelper csmaHelper;
+  csmaHelper.SetDeviceAttribute ("Mtu", UintegerValue (m_s1uLinkMtu));
+  for (uint32_t i = 0; i < links.size (); i++)
+    {
+      const FabricLink &link = links[i];
+      NS_ABORT_MSG_IF (link.switch1 == link.switch2, "Link of switch " << link.switch1 << " to itself");
+      csmaHelper.SetChannelAttribute ("DataRate", DataRateValue (link.dataRate));
+      csmaHelper.SetChannelAttribute ("Delay", TimeValue (link.delay));
+      NetDeviceContainer devices = csmaHelper.Install (
+          NodeContainer (m_fabricSwitches.Get (link.switch1), m_fabricSwitches.Get (link.switch2)));
+      // the OpenFlow ports are numbered from 1 in the order of the devices
+      switchPorts[link.switch1].Add (devices.Get (0));
+      switchPorts[link.switch2].Add (devices.Get (1));
+      linkPorts.push_back (switchPorts[link.switch1].GetN ());
+      linkPorts.push_back (switchPorts[link.switch2].GetN ());
+    }
+
+  // S1-U link of the SGW/PGW node
+  csmaHelper.SetChannelAttribute ("DataRate", DataRateValue (m_s1uLinkDataRate));
+  csmaHelper.SetChannelAttribute ("Delay", TimeValue (m_s1uLinkDelay));
+  NetDeviceContainer sgwDevices = csmaHelper.Install (NodeContainer (m_sgwPgw, m_fabricSwitches.Get (m_pgwSwitch)));
+  switchPorts[m_pgwSwitch].Add (sgwDevices.Get (1));
+  uint32_t sgwPort = switchPorts[m_pgwSwitch].GetN ();
+
+  // a single controller for all the switches
+  m_ofHelper = CreateObject<OFSwitch13InternalHelper> ();
+  m_fabricController = CreateObject<FabricController> ();
+  m_ofHelper->InstallController (CreateObject<Node> (), m_fabricController);
+  for (uint32_t i = 0; i < nSwitches; i++)
+    {
+      m_fabricDevices.Add (m_ofHelper->InstallSwitch (m_fabricSwitches.Get (i), switchPorts[i]));
+    }
+  m_ofHelper->CreateOpenFlowChannels ();
+
+  for (uint32_t i = 0; i < links.size (); i++)
+    {
+      m_fabricController->AddLink (m_fabricDevices.Get (links[i].switch1)->GetDatapathId (), linkPorts[2 * i],
+                                   m_fabricDevices.Get (links[i].switch2)->GetDatapathId (), linkPorts[2 * i + 1],
+                                   links[i].dataRate);
+    }
+
+  m_sgwS1uAddress = m_fabricIpv4AddressHelper.Assign (NetDeviceContainer (sgwDevices.Get (0))).GetAddress (0);
+  m_fabricController->AddHost (m_sgwS1uAddress, m_fabricDevices.Get (m_pgwSwitch)->GetDatapathId (), sgwPort);
+  NS_LOG_INFO ("Backhaul fabric of " << nSwitches << " switches and " << links.size ()
+               << " links, SGW/PGW " << m_sgwS1uAddress << " on switch " << m_pgwSwitch);
 }
 
 
 //Input: enb(eNodeB), lteEnbNetDevice(Netdevice for eNodeB), cellId
 //Output: void
-//Explanation: This function places 3 SDN switches and 2 SDN controllers between eNodeB and sgw/pgw
+//Explanation: This function attaches the eNodeB to the SDN backhaul fabric shared with the sgw/pgw
 void
 OvsPointToPointEpcHelper::AddEnb (Ptr<Node> enb, Ptr<NetDevice> lteEnbNetDevice, uint16_t cellId)
 {
@@ -219,104 +438,26 @@ OvsPointToPointEpcHelper::AddEnb (Ptr<Node> enb, Ptr<NetDevice> lteEnbNetDevice,
   Ipv4Address enbAddress = enbSgwIpIfaces.GetAddress (0);
   Ipv4Address sgwAddress = enbSgwIpIfaces.GetAddress (1);
 */
-  NodeContainer switchNodes, controllerNodes;
-  switchNodes.Create(3);
-  controllerNodes.Create(2);
-  
-  NetDeviceContainer serverDevices, clientDevices;
-  NetDeviceContainer switch0Ports, switch1Ports, switch2Ports;
-  NetDeviceContainer link;
+  if (m_fabricSwitches.GetN () == 0)
+    {
+      CreateFabric ();
+    }
 
+  // attach the eNB to the next of its switches of the fabric
+  uint32_t enbSwitch = m_enbSwitches[m_nFabricEnbs++ % m_enbSwitches.size ()];
   CsmaHelper csmaHelper;
-  csmaHelper.SetChannelAttribute ("DataRate", DataRateValue (DataRate ("10Mbps")));
-
-  link = csmaHelper.Install (NodeContainer (switchNodes.Get(0), switchNodes.Get(1)));
-  switch0Ports.Add(link.Get(0));
-  switch1Ports.Add(link.Get(1));
-
-  link = csmaHelper.Install (NodeContainer (switchNodes.Get (0), switchNodes.Get (1)));
-  switch0Ports.Add (link.Get (0));
-  switch1Ports.Add (link.Get (1));
-
-  // Configure the CsmaHelper for 100Mbps connections
-  csmaHelper.SetChannelAttribute ("DataRate", DataRateValue (DataRate ("100Mbps")));
-
-  // Connect aggregation switch to client switch
-  link = csmaHelper.Install (NodeContainer (switchNodes.Get (1), switchNodes.Get (2)));
-  switch1Ports.Add (link.Get (0));
-  switch2Ports.Add (link.Get (1));
-
-  // Connect servers to border switch
-  link = csmaHelper.Install (NodeContainer (m_sgwPgw, switchNodes.Get (0)));
-  serverDevices.Add (link.Get (0));
-  switch0Ports.Add (link.Get (1));
-
-  // connect clients to aggregate switch
-  link = csmaHelper.Install (NodeContainer (enb, switchNodes.Get (2)));
-  clientDevices.Add (link.Get (0));
-  switch2Ports.Add (link.Get (1));
-  
-  // Configure OpenFlow QoS controller for border and aggregation switches
-  // (#0 and #1) into controller node 0.
-  Ptr<OFSwitch13InternalHelper> ofQosHelper =
-    CreateObject<OFSwitch13InternalHelper> ();
-  Ptr<QosController> qosCtrl = CreateObject<QosController> ();
-  ofQosHelper->InstallController (controllerNodes.Get (0), qosCtrl);
-
-  // Configure OpenFlow learning controller for client switch (#2) into controller node 1
-  Ptr<OFSwitch13InternalHelper> ofLearningHelper = CreateObject<OFSwitch13InternalHelper> ();
-  Ptr<OFSwitch13LearningController> learnCtrl = CreateObject<OFSwitch13LearningController> ();
-  ofLearningHelper->InstallController (controllerNodes.Get (1), learnCtrl);
-
-  // Install OpenFlow switches 0 and 1 with border controller
-  OFSwitch13DeviceContainer ofSwitchDevices;
-  ofSwitchDevices.Add (ofQosHelper->InstallSwitch (switchNodes.Get (0), switch0Ports));
-  ofSwitchDevices.Add (ofQosHelper->InstallSwitch (switchNodes.Get (1), switch1Ports));
-  ofQosHelper->CreateOpenFlowChannels ();
-
-  // Install OpenFlow switches 2 with learning controller
-  ofSwitchDevices.Add (ofLearningHelper->InstallSwitch (switchNodes.Get (2), switch2Ports));
-  ofLearningHelper->CreateOpenFlowChannels ();
- 
-  Ipv4AddressHelper ipv4switches;
-  Ipv4InterfaceContainer internetIpIfaces;
-  ipv4switches.SetBase ("10.1.0.0", "255.255.0.0", "0.0.1.2");
-  internetIpIfaces = ipv4switches.Assign (serverDevices);
-  Ipv4Address sgwAddress = internetIpIfaces.GetAddress(0);
-  ipv4switches.SetBase ("10.1.0.0", "255.255.0.0", "0.0.2.1");
-  internetIpIfaces = ipv4switches.Assign (clientDevices);
-  Ipv4Address enbAddress = internetIpIfaces.GetAddress(0);
-
-  Ipv4Address serverAddr ("10.1.1.1");
-
-  Ptr<NetDevice> enbDev = clientDevices.Get(0);
-  Ptr<NetDevice> sgwDev = serverDevices.Get(0); 
-
-
-  //cout<<"enbAddress: "<<enbAddress<<endl;
-  //cout<<"sgwAddress: "<<sgwAddress<<endl;
-/*
-  cout<<"---border switch---"<<endl;
-  for(uint32_t i=0; i<switch0Ports.GetN(); i++)
-  {
-    //cout<<"port"<<i<<": "<<switch0Ports.Get(i)->GetAddress()<<endl;
-  } 
- 
-  cout<<"---aggregation switch---"<<endl;
-  for(uint32_t i=0; i<switch1Ports.GetN(); i++)
-  {
-    cout<<"port"<<i<<": "<<switch1Ports.Get(i)->GetAddress()<<endl;
-  } 
- 
-
- 
-  cout<<"---client switch---"<<endl;
-   for(uint32_t i=0; i<switch2Ports.GetN(); i++)
-  {
-    cout<<"port"<<i<<": "<<switch2Ports.Get(i)->GetAddress()<<endl;
-  } 
-  
-*/
+  csmaHelper.SetDeviceAttribute ("Mtu", UintegerValue (m_s1uLinkMtu));
+  csmaHelper.SetChannelAttribute ("DataRate", DataRateValue (m_s1uLinkDataRate));
+  csmaHelper.SetChannelAttribute ("Delay", TimeValue (m_s1uLinkDelay));
+  NetDeviceContainer enbSwitchDevices = csmaHelper.Install (NodeContainer (enb, m_fabricSwitches.Get (enbSwitch)));
+  Ptr<OFSwitch13Device> switchDevice = m_fabricDevices.Get (enbSwitch);
+  Ptr<OFSwitch13Port> enbPort = switchDevice->AddSwitchPort (enbSwitchDevices.Get (1));
+
+  Ipv4Address enbAddress =
+    m_fabricIpv4AddressHelper.Assign (NetDeviceContainer (enbSwitchDevices.Get (0))).GetAddress (0);
+  Ipv4Address sgwAddress = m_sgwS1uAddress;
+  m_fabricController->AddHost (enbAddress, switchDevice->GetDatapathId (), enbPort->GetPortNo ());
+  NS_LOG_LOGIC ("eNB " << cellId << " " << enbAddress << " on switch " << enbSwitch);
 
   // create S1-U socket for the ENB
   Ptr<Socket> enbS1uSocket = Socket::CreateSocket (enb, TypeId::LookupByName ("ns3::UdpSocketFactory"));
@@ -346,7 +487,6 @@ OvsPointToPointEpcHelper::AddEnb (Ptr<Node> enb, Ptr<NetDevice> lteEnbNetDevice,
   NS_LOG_INFO ("create EpcEnbApplication");
  
   Ptr<EpcEnbApplication> enbApp = CreateObject<EpcEnbApplication> (enbLteSocket, enbS1uSocket, enbAddress, sgwAddress, cellId);
-  //Ptr<EpcEnbApplication> enbApp = CreateObject<EpcEnbApplication> (enbLteSocket, enbS1uSocket, enbAddress, serverAddr, cellId);
  
   enb->AddApplication (enbApp);
   NS_ASSERT (enb->GetNApplications () == 1);
@@ -360,8 +500,7 @@ OvsPointToPointEpcHelper::AddEnb (Ptr<Node> enb, Ptr<NetDevice> lteEnbNetDevice,
 
   NS_LOG_INFO ("connect S1-AP interface");
   m_mme->AddEnb (cellId, enbAddress, enbApp->GetS1apSapEnb ());
-//  m_sgwPgwApp->AddEnb (cellId, enbAddress, sgwAddress);
-  m_sgwPgwApp->AddEnb (cellId, enbAddress, serverAddr);
+  m_sgwPgwApp->AddEnb (cellId, enbAddress, sgwAddress);
 
   enbApp->SetS1apSapMme (m_mme->GetS1apSapMme ());
 
@@ -543,6 +682,58 @@ OvsPointToPointEpcHelper::GetPgwNode ()
   return m_sgwPgw;
 }
 
+Ptr<EpcSgwPgwApplication>
+OvsPointToPointEpcHelper::GetSgwPgwApplication ()
+{
+  return m_sgwPgwApp;
+}
+
+uint32_t
+OvsPointToPointEpcHelper::AddPgwInstance (DataRate processingRate, uint32_t maxQueueSize)
+{
+  NS_LOG_FUNCTION (this << processingRate << maxQueueSize);
+  return m_sgwPgwApp->AddWorker (processingRate, maxQueueSize);
+}
+
+void
+OvsPointToPointEpcHelper::SetPgwInstanceForwardingDelay (uint32_t instanceId, Time delay)
+{
+  NS_LOG_FUNCTION (this << instanceId << delay);
+  m_sgwPgwApp->SetWorkerForwardingDelay (instanceId, delay);
+}
+
+std::list<uint64_t>
+OvsPointToPointEpcHelper::RemovePgwInstance (uint32_t instanceId)
+{
+  NS_LOG_FUNCTION (this << instanceId);
+  return m_sgwPgwApp->RemoveWorker (instanceId);
+}
+
+std::list<uint64_t>
+OvsPointToPointEpcHelper::RebalancePgwInstances ()
+{
+  NS_LOG_FUNCTION (this);
+  return m_sgwPgwApp->RebalanceWorkers ();
+}
+
+uint32_t
+OvsPointToPointEpcHelper::GetNPgwInstances ()
+{
+  return m_sgwPgwApp->GetNWorkers ();
+}
+
+NodeContainer
+OvsPointToPointEpcHelper::GetFabricSwitches ()
+{
+  return m_fabricSwitches;
+}
+
+Ptr<FabricController>
+OvsPointToPointEpcHelper::GetFabricController ()
+{
+  return m_fabricController;
+}
+
 
 Ipv4InterfaceContainer 
 OvsPointToPointEpcHelper::AssignUeIpv4Address (NetDeviceContainer ueDevices)
@@ -29,6 +29,8 @@
 #include <ns3/epc-tft.h>
 #include <ns3/eps-bearer.h>
 #include <ns3/epc-helper.h>
+#include <ns3/node-container.h>
+#include <ns3/ofswitch13-device-container.h>
 
 //#include "qos-controller.h"
 
@@ -40,6 +42,8 @@ class VirtualNetDevice;
 class EpcSgwPgwApplication;
 class EpcX2;
 class EpcMme;
+class FabricController;
+class OFSwitch13InternalHelper;
 
 /**
  * \ingroup lte
@@ -47,8 +51,23 @@ class EpcMme;
  *
  * This Helper will create an EPC network topology comprising of a
  * single node that implements both the SGW and PGW functionality, and
- * an MME node. The S1-U, X2-U and X2-C interfaces are realized over
- * PointToPoint links. 
+ * an MME node. The X2-U and X2-C interfaces are realized over
+ * PointToPoint links.
+ *
+ * With AddEnb, the S1-U interfaces are realized over one OpenFlow backhaul
+ * fabric shared by all the eNBs and by the SGW/PGW node, whose switches are
+ * configured by a single FabricController. The fabric is built at the first
+ * AddEnb, either as a spine-leaf or as a ring, or from the TopologyFile, a
+ * text file of lines
+ *
+ *   link <switch> <switch> [<data rate> [<delay>]]
+ *   pgw <switch>
+ *   enb <switch> [<switch> ...]
+ *
+ * where the switches are numbered from 0 and '#' starts a comment. The
+ * SGW/PGW node is attached to the pgw switch (0 by default), and the eNBs in
+ * turn to the enb switches (all of them by default), over S1-U links. With
+ * AddEnbOvs, each eNB has its own PointToPoint link to the SGW/PGW node.
  */
 class OvsPointToPointEpcHelper : public EpcHelper
 {
@@ -63,6 +82,15 @@ public:
    * Destructor
    */  
   virtual ~OvsPointToPointEpcHelper ();
+
+  /**
+   * The built-in topologies of the backhaul fabric
+   */
+  enum FabricTopology
+  {
+    SPINE_LEAF, //!< Every leaf switch linked to every spine switch
+    RING        //!< Switches linked in a ring
+  };
   
   // inherited from Object
   /**
@@ -85,10 +113,90 @@ public:
   virtual Ipv4InterfaceContainer AssignUeIpv4Address (NetDeviceContainer ueDevices);
   virtual Ipv4Address GetUeDefaultGatewayAddress ();
 
+  /**
+   * \return the SGW/PGW application, e.g., to stall the data plane of
+   * UE contexts migrated by a scaling event of the virtualized core
+   */
+  Ptr<EpcSgwPgwApplication> GetSgwPgwApplication ();
+
+  /**
+   * Instantiate a new SGW/PGW worker instance (e.g., the PGW process
+   * running on a VM of the virtualized core)
+   *
+   * \param processingRate the packet processing rate of the instance
+   * \param maxQueueSize the size of the ingress queue of the instance [packets]
+   * \return the identifier of the instance
+   */
+  uint32_t AddPgwInstance (DataRate processingRate, uint32_t maxQueueSize);
 
+  /**
+   * Set the time the packets of a SGW/PGW worker instance take to reach
+   * it and come back (e.g., from the rack of the SGW/PGW links to the one
+   * of the VM of the instance)
+   *
+   * \param instanceId the identifier of the instance
+   * \param delay the forwarding delay of the instance
+   */
+  void SetPgwInstanceForwardingDelay (uint32_t instanceId, Time delay);
+
+  /**
+   * Remove a SGW/PGW worker instance, moving its UEs to the other ones
+   *
+   * \param instanceId the identifier of the instance
+   * \return the IMSIs of the UEs whose context moved to another instance
+   */
+  std::list<uint64_t> RemovePgwInstance (uint32_t instanceId);
+
+  /**
+   * Rebalance the UEs over the SGW/PGW worker instances
+   *
+   * \return the IMSIs of the UEs whose context moved to another instance
+   */
+  std::list<uint64_t> RebalancePgwInstances ();
+
+  /**
+   * \return the number of SGW/PGW worker instances
+   */
+  uint32_t GetNPgwInstances ();
+
+  /**
+   * \return the switches of the backhaul fabric, empty until the first AddEnb
+   */
+  NodeContainer GetFabricSwitches ();
+
+  /**
+   * \return the controller of the backhaul fabric, null until the first AddEnb
+   */
+  Ptr<FabricController> GetFabricController ();
 
 private:
 
+  /**
+   * Build the backhaul fabric, its controller, and the S1-U link of the
+   * SGW/PGW node
+   */
+  void CreateFabric ();
+
+  /**
+   * A link between two switches of the backhaul fabric
+   */
+  struct FabricLink
+  {
+    uint32_t switch1;   //!< index of the first switch
+    uint32_t switch2;   //!< index of the second switch
+    DataRate dataRate;  //!< data rate of the link
+    Time     delay;     //!< delay of the link
+  };
+
+  /**
+   * Read the links and the switches of the SGW/PGW and of the eNBs from the
+   * topology file
+   *
+   * \param links the links read
+   * \return the number of switches
+   */
+  uint32_t ReadTopologyFile (std::vector<FabricLink> &links);
+
   /** 
    * helper to assign addresses to UE devices as well as to the TUN device of the SGW/PGW
    */
@@ -174,6 +282,68 @@ private:
    */
   uint16_t m_x2LinkMtu;
 
+  /**
+   * The built-in topology of the backhaul fabric
+   */
+  FabricTopology m_fabricTopology;
+
+  /**
+   * The file of the topology of the backhaul fabric, if not empty
+   */
+  std::string m_topologyFile;
+
+  /**
+   * The number of spine and leaf switches of the spine-leaf topology
+   */
+  uint32_t m_nSpines;
+  uint32_t m_nLeaves;
+
+  /**
+   * The number of switches of the ring topology
+   */
+  uint32_t m_nRingSwitches;
+
+  /**
+   * The data rate of the links between the switches of the built-in topologies
+   */
+  DataRate m_fabricLinkDataRate;
+
+  /**
+   * The delay of the links between the switches of the built-in topologies
+   */
+  Time     m_fabricLinkDelay;
+
+  /**
+   * helper to assign the addresses of the SGW/PGW node and of the eNBs on the
+   * backhaul fabric, all on one network
+   */
+  Ipv4AddressHelper m_fabricIpv4AddressHelper;
+
+  /**
+   * The OpenFlow helper, controller and switches of the backhaul fabric
+   */
+  Ptr<OFSwitch13InternalHelper> m_ofHelper;
+  Ptr<FabricController> m_fabricController;
+  NodeContainer m_fabricSwitches;
+  OFSwitch13DeviceContainer m_fabricDevices;
+
+  /**
+   * The switch of the SGW/PGW node, and the switches the eNBs are attached
+   * to in turn
+   */
+  uint32_t m_pgwSwitch;
+  std::vector<uint32_t> m_enbSwitches;
+
+  /**
+   * The number of eNBs attached to the backhaul fabric
+   */
+  uint32_t m_nFabricEnbs;
+
+  /**
+   * The S1-U address of the SGW/PGW node on the backhaul fabric
+   */
+  Ipv4Address m_sgwS1uAddress;
+
 };
 
 
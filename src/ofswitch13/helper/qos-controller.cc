@@ -22,7 +22,7 @@
 #include <ns3/network-module.h>
 #include <ns3/internet-module.h>
 #include <iostream>
-#include <fstream>
+#include <algorithm>
 
 using namespace std;
 
@@ -46,7 +46,8 @@ QosController::DoDispose ()
   NS_LOG_FUNCTION (this);
 
   m_arpTable.clear ();
-  OFSwitch13Controller::DoDispose ();
+  m_linkWeights.clear ();
+  SelectGroupController::DoDispose ();
   Application::DoDispose ();
 }
 
@@ -54,7 +55,7 @@ TypeId
 QosController::GetTypeId (void)
 {
   static TypeId tid = TypeId ("ns3::QosController")
-    .SetParent<OFSwitch13Controller> ()
+    .SetParent<SelectGroupController> ()
     .SetGroupName ("OFSwitch13")
     .AddConstructor<QosController> ()
     .AddAttribute ("EnableMeter",
@@ -72,6 +73,16 @@ QosController::GetTypeId (void)
                    BooleanValue (true),
                    MakeBooleanAccessor (&QosController::m_linkAggregation),
                    MakeBooleanChecker ())
+    .AddAttribute ("Link1Weight",
+                   "Initial weight of link 1 in the link aggregation groups.",
+                   UintegerValue (10),
+                   MakeUintegerAccessor (&QosController::m_link1Weight),
+                   MakeUintegerChecker<uint16_t> ())
+    .AddAttribute ("Link2Weight",
+                   "Initial weight of link 2 in the link aggregation groups.",
+                   UintegerValue (10),
+                   MakeUintegerAccessor (&QosController::m_link2Weight),
+                   MakeUintegerChecker<uint16_t> ())
     .AddAttribute ("ServerIpAddr",
                    "Server IPv4 address.",
                    AddressValue (Address (Ipv4Address ("10.1.1.1"))),
@@ -165,29 +176,6 @@ QosController::ConfigureBorderSwitch (Ptr<const RemoteSwitch> swtch)
 
   //cout<<"border, m_linkAggregation:"<<m_linkAggregation<<endl;
 
-  ifstream openFile("ovs_weight.txt");
-
-  string tmp_weight[2];
-
-  if( openFile.is_open())
-  {
-    string line;
-    int tmp_cnt = 0;
-    while(getline(openFile, line))
-    {
-      tmp_weight[tmp_cnt] = string(line);
-      tmp_cnt++;
-    }
-    openFile.close();
-  }
-
-  string firstCommand = "weight=" + tmp_weight[0] + ",port=any,group=any output=1";
-  string secondCommand = "weight=" + tmp_weight[1] + ",port=any,group=any output=2";
-
-  //cout<<"command list"<<endl;
-  //cout <<firstCommand<<", "<<secondCommand<<endl;
-
-
   if (m_linkAggregation)
     {
       // original codes
@@ -205,10 +193,12 @@ QosController::ConfigureBorderSwitch (Ptr<const RemoteSwitch> swtch)
                     "weight=1,port=any,group=any output=2");
        */
 
-      DpctlExecute (swtch, "group-mod cmd=add,type=sel,group=3 "
-                    "weight="+tmp_weight[0]+",port=any,group=any output=1 "
-                    "weight="+tmp_weight[1]+",port=any,group=any output=2");
- 
+      std::vector<uint32_t> ports;
+      ports.push_back (1);
+      ports.push_back (2);
+      AddSelectGroup (swtch, GetLinkGroupId (swtch->GetDpId ()), ports,
+                      GetLinkWeights (swtch->GetDpId ()));
+      m_linkWeights.erase (swtch->GetDpId ());
 
     }
   else
@@ -272,9 +262,12 @@ QosController::ConfigureAggregationSwitch (Ptr<const RemoteSwitch> swtch)
   if (m_linkAggregation)
     {
       // Configure Group #1 for aggregating links 1 and 2
-      DpctlExecute (swtch, "group-mod cmd=add,type=sel,group=1 "
-                    "weight=1,port=any,group=any output=1 "
-                    "weight=1,port=any,group=any output=2");
+      std::vector<uint32_t> ports;
+      ports.push_back (1);
+      ports.push_back (2);
+      AddSelectGroup (swtch, GetLinkGroupId (swtch->GetDpId ()), ports,
+                      GetLinkWeights (swtch->GetDpId ()));
+      m_linkWeights.erase (swtch->GetDpId ());
     }
   else
     {
@@ -294,6 +287,58 @@ QosController::ConfigureAggregationSwitch (Ptr<const RemoteSwitch> swtch)
                 "in_port=3 write:group=1");
 }
 
+uint32_t
+QosController::GetLinkGroupId (uint64_t dpId)
+{
+  return dpId == 1 ? 3 : 1;
+}
+
+std::vector<uint16_t>
+QosController::GetLinkWeights (uint64_t dpId)
+{
+  std::vector<uint16_t> weights =
+    GetSelectGroupWeights (dpId, GetLinkGroupId (dpId));
+  if (weights.empty ())
+    {
+      std::map<uint64_t, std::vector<uint16_t> >::const_iterator it =
+        m_linkWeights.find (dpId);
+      if (it != m_linkWeights.end ())
+        {
+          return it->second;
+        }
+      weights.push_back (m_link1Weight);
+      weights.push_back (m_link2Weight);
+    }
+  return weights;
+}
+
+void
+QosController::SetLinkWeights (uint64_t dpId, uint16_t weight1,
+                               uint16_t weight2)
+{
+  NS_LOG_FUNCTION (this << dpId << weight1 << weight2);
+
+  NS_ASSERT_MSG (weight1 > 0 || weight2 > 0, "No weight on any link.");
+  std::vector<uint16_t> weights;
+  weights.push_back (weight1);
+  weights.push_back (weight2);
+  if (GetSelectGroupWeights (dpId, GetLinkGroupId (dpId)).empty ())
+    {
+      m_linkWeights[dpId] = weights;
+    }
+  else
+    {
+      SetSelectGroupWeights (dpId, GetLinkGroupId (dpId), weights);
+    }
+}
+
+uint16_t
+QosController::GetLinkWeight (uint64_t dpId, uint32_t link)
+{
+  NS_ASSERT_MSG (link == 1 || link == 2, "Invalid link " << link);
+  return GetLinkWeights (dpId)[link - 1];
+}
+
 ofl_err
 QosController::HandleArpPacketIn (
   struct ofl_msg_packet_in *msg, Ptr<const RemoteSwitch> swtch,
@@ -22,13 +22,18 @@
 #define QOS_CONTROLLER_H
 
 #include <ns3/ofswitch13-module.h>
+#include "select-group-controller.h"
 
 using namespace ns3;
 
 /**
  * \brief An border OpenFlow 1.3 controller
+ *
+ * With link aggregation, the border and aggregation switches spread their
+ * packets over links 1 and 2 by a select group, whose weights are
+ * rebalanced from the loads of the links as SelectGroupController does.
  */
-class QosController : public OFSwitch13Controller
+class QosController : public SelectGroupController
 {
 public:
   QosController ();          //!< Default constructor.
@@ -55,6 +60,22 @@ public:
     struct ofl_msg_packet_in *msg, Ptr<const RemoteSwitch> swtch,
     uint32_t xid);
 
+  /**
+   * Set the weights of the aggregated links in the select group of a switch,
+   * updating the group if the switch is already configured.
+   * \param dpId The border (1) or aggregation (2) switch datapath ID.
+   * \param weight1 The weight of link 1.
+   * \param weight2 The weight of link 2.
+   */
+  void SetLinkWeights (uint64_t dpId, uint16_t weight1, uint16_t weight2);
+
+  /**
+   * \param dpId The border (1) or aggregation (2) switch datapath ID.
+   * \param link The link, 1 or 2.
+   * \return The weight of the link in the select group of the switch.
+   */
+  uint16_t GetLinkWeight (uint64_t dpId, uint32_t link);
+
 protected:
   // Inherited from OFSwitch13Controller
   void HandshakeSuccessful (Ptr<const RemoteSwitch> swtch);
@@ -72,6 +93,19 @@ private:
    */
   void ConfigureAggregationSwitch (Ptr<const RemoteSwitch> swtch);
 
+  /**
+   * \param dpId The border (1) or aggregation (2) switch datapath ID.
+   * \return The ID of the link aggregation group of the switch.
+   */
+  static uint32_t GetLinkGroupId (uint64_t dpId);
+
+  /**
+   * \param dpId The border (1) or aggregation (2) switch datapath ID.
+   * \return The weights of links 1 and 2 in the group of the switch, or the
+   *         ones it will be configured with.
+   */
+  std::vector<uint16_t> GetLinkWeights (uint64_t dpId);
+
   /**
    * Handle ARP request messages.
    * \param msg The packet-in message.
@@ -143,6 +177,11 @@ private:
   bool      m_meterEnable;        //!< Enable per-flow mettering
   DataRate  m_meterRate;          //!< Per-flow meter rate
   bool      m_linkAggregation;    //!< Enable link aggregation
+  uint16_t  m_link1Weight;        //!< Initial weight of link 1
+  uint16_t  m_link2Weight;        //!< Initial weight of link 2
+
+  /** Weights set for the switches not configured yet, by datapath ID */
+  std::map<uint64_t, std::vector<uint16_t> > m_linkWeights;
 
   /** Map saving <IPv4 address / MAC address> */
   typedef std::map<Ipv4Address, Mac48Address> IpMacMap_t;
@@ -0,0 +1,342 @@
+/* -*-  Mode: C++; c-file-style: "gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "select-group-controller.h"
+#include <ns3/log.h>
+#include <ns3/boolean.h>
+#include <ns3/double.h>
+#include <ns3/uinteger.h>
+#include <ns3/simulator.h>
+#include <algorithm>
+#include <sstream>
+
+namespace ns3 {
+
+NS_LOG_COMPONENT_DEFINE ("SelectGroupController");
+NS_OBJECT_ENSURE_REGISTERED (SelectGroupController);
+
+SelectGroupController::SelectGroupController ()
+{
+  NS_LOG_FUNCTION (this);
+}
+
+SelectGroupController::~SelectGroupController ()
+{
+  NS_LOG_FUNCTION (this);
+}
+
+void
+SelectGroupController::DoDispose ()
+{
+  NS_LOG_FUNCTION (this);
+
+  m_groups.clear ();
+  m_ports.clear ();
+  Simulator::Cancel (m_pollEvent);
+  OFSwitch13Controller::DoDispose ();
+}
+
+TypeId
+SelectGroupController::GetTypeId (void)
+{
+  static TypeId tid = TypeId ("ns3::SelectGroupController")
+    .SetParent<OFSwitch13Controller> ()
+    .SetGroupName ("OFSwitch13")
+    .AddAttribute ("FlowHashing",
+                   "Keep the packets of a flow on one bucket of a select "
+                   "group, choosing the bucket from a hash of the flow in "
+                   "proportion to the bucket weights, instead of taking the "
+                   "buckets in turn for each packet.",
+                   BooleanValue (true),
+                   MakeBooleanAccessor (&SelectGroupController::m_flowHashing),
+                   MakeBooleanChecker ())
+    .AddAttribute ("RebalanceInterval",
+                   "Interval between the polls of the port statistics that "
+                   "rebalance the select groups. Zero keeps the weights as "
+                   "set.",
+                   TimeValue (Seconds (1)),
+                   MakeTimeAccessor (&SelectGroupController::m_rebalanceInterval),
+                   MakeTimeChecker ())
+    .AddAttribute ("RebalanceHysteresis",
+                   "Difference of the loads of the ports of a group over an "
+                   "interval above which the weights are rebalanced. The load "
+                   "of a port is its utilization when the speeds of all the "
+                   "ports of the group are known, its share of the traffic "
+                   "of the group otherwise.",
+                   DoubleValue (0.1),
+                   MakeDoubleAccessor (&SelectGroupController::m_rebalanceHysteresis),
+                   MakeDoubleChecker<double> (0, 1))
+    .AddAttribute ("RebalanceStep",
+                   "Weight moved from the most loaded port of a group to the "
+                   "least loaded one by a rebalance.",
+                   UintegerValue (1),
+                   MakeUintegerAccessor (&SelectGroupController::m_rebalanceStep),
+                   MakeUintegerChecker<uint16_t> (1))
+    .AddTraceSource ("Rebalance",
+                     "The weights of a select group were rebalanced.",
+                     MakeTraceSourceAccessor (&SelectGroupController::m_rebalanceTrace),
+                     "ns3::SelectGroupController::RebalanceTracedCallback")
+  ;
+  return tid;
+}
+
+std::string
+SelectGroupController::GetSelectGroupType (void) const
+{
+  // "hash" is the flow hashing select group of the datapath, an
+  // experimenter group type
+  return m_flowHashing ? "hash" : "sel";
+}
+
+void
+SelectGroupController::AddSelectGroup (Ptr<const RemoteSwitch> swtch,
+                                       uint32_t groupId,
+                                       const std::vector<uint32_t> &ports,
+                                       const std::vector<uint16_t> &weights)
+{
+  NS_LOG_FUNCTION (this << swtch << groupId);
+
+  NS_ASSERT_MSG (ports.size () == weights.size (), "One weight per port.");
+  uint64_t dpId = swtch->GetDpId ();
+  std::map<SwitchKey_t, PortStats>::const_iterator first =
+    m_ports.lower_bound (SwitchKey_t (dpId, 0));
+  bool newSwitch = first == m_ports.end () || first->first.first != dpId;
+
+  SelectGroup &group = m_groups[SwitchKey_t (dpId, groupId)];
+  group.ports = ports;
+  group.weights = weights;
+  for (uint32_t i = 0; i < ports.size (); i++)
+    {
+      m_ports[SwitchKey_t (dpId, ports[i])];
+    }
+  DpctlExecute (swtch, GetSelectGroupCommand ("add", groupId, group));
+
+  // Speeds of the ports, and periodic rebalance of the weights
+  if (newSwitch)
+    {
+      DpctlExecute (swtch, "port-desc");
+    }
+  if (!m_rebalanceInterval.IsZero () && !m_pollEvent.IsRunning ())
+    {
+      m_pollEvent = Simulator::Schedule (m_rebalanceInterval,
+                                         &SelectGroupController::PollPortStats, this);
+    }
+}
+
+void
+SelectGroupController::SetSelectGroupWeights (
+  uint64_t dpId, uint32_t groupId, const std::vector<uint16_t> &weights)
+{
+  NS_LOG_FUNCTION (this << dpId << groupId);
+
+  std::map<SwitchKey_t, SelectGroup>::iterator it =
+    m_groups.find (SwitchKey_t (dpId, groupId));
+  NS_ASSERT_MSG (it != m_groups.end (), "No group " << groupId <<
+                 " on switch " << dpId);
+  NS_ASSERT_MSG (weights.size () == it->second.ports.size (),
+                 "One weight per port.");
+  it->second.weights = weights;
+
+  Ptr<const RemoteSwitch> swtch = GetRemoteSwitch (dpId);
+  if (swtch)
+    {
+      DpctlExecute (swtch, GetSelectGroupCommand ("mod", groupId, it->second));
+    }
+}
+
+std::vector<uint16_t>
+SelectGroupController::GetSelectGroupWeights (uint64_t dpId,
+                                              uint32_t groupId) const
+{
+  std::map<SwitchKey_t, SelectGroup>::const_iterator it =
+    m_groups.find (SwitchKey_t (dpId, groupId));
+  if (it == m_groups.end ())
+    {
+      return std::vector<uint16_t> ();
+    }
+  return it->second.weights;
+}
+
+std::string
+SelectGroupController::GetSelectGroupCommand (std::string command,
+                                              uint32_t groupId,
+                                              const SelectGroup &group) const
+{
+  std::ostringstream cmd;
+  cmd << "group-mod cmd=" << command << ",type=" << GetSelectGroupType ()
+      << ",group=" << groupId;
+  for (uint32_t i = 0; i < group.ports.size (); i++)
+    {
+      cmd << " weight=" << group.weights[i]
+          << ",port=any,group=any output=" << group.ports[i];
+    }
+  return cmd.str ();
+}
+
+void
+SelectGroupController::PollPortStats (void)
+{
+  NS_LOG_FUNCTION (this);
+
+  uint64_t lastDpId = 0;
+  std::map<SwitchKey_t, PortStats>::const_iterator it;
+  for (it = m_ports.begin (); it != m_ports.end (); it++)
+    {
+      if (it->first.first == lastDpId)
+        {
+          continue;
+        }
+      lastDpId = it->first.first;
+      Ptr<const RemoteSwitch> swtch = GetRemoteSwitch (lastDpId);
+      if (swtch)
+        {
+          DpctlExecute (swtch, "stats-port");
+        }
+    }
+  m_pollEvent = Simulator::Schedule (m_rebalanceInterval,
+                                     &SelectGroupController::PollPortStats, this);
+}
+
+ofl_err
+SelectGroupController::HandleMultipartReply (
+  struct ofl_msg_multipart_reply_header *msg, Ptr<const RemoteSwitch> swtch,
+  uint32_t xid)
+{
+  NS_LOG_FUNCTION (this << swtch << xid);
+
+  uint64_t dpId = swtch->GetDpId ();
+  std::map<SwitchKey_t, PortStats>::iterator first =
+    m_ports.lower_bound (SwitchKey_t (dpId, 0));
+  if (first != m_ports.end () && first->first.first == dpId)
+    {
+      if (msg->type == OFPMP_PORT_DESC)
+        {
+          struct ofl_msg_multipart_reply_port_desc *desc =
+            (struct ofl_msg_multipart_reply_port_desc*)msg;
+          for (size_t i = 0; i < desc->stats_num; i++)
+            {
+              SwitchKey_t key (dpId, desc->stats[i]->port_no);
+              m_ports[key].speed = desc->stats[i]->curr_speed;
+            }
+        }
+      else if (msg->type == OFPMP_PORT_STATS)
+        {
+          RebalanceSelectGroups (swtch, (struct ofl_msg_multipart_reply_port*)msg);
+        }
+    }
+
+  // All handlers must free the message when everything is ok
+  ofl_msg_free ((struct ofl_msg_header*)msg, 0);
+  return 0;
+}
+
+void
+SelectGroupController::RebalanceSelectGroups (
+  Ptr<const RemoteSwitch> swtch, struct ofl_msg_multipart_reply_port *stats)
+{
+  NS_LOG_FUNCTION (this << swtch);
+
+  // Traffic offered to each port since the last poll, the dropped packets
+  // counted at the mean size of the transmitted ones
+  uint64_t dpId = swtch->GetDpId ();
+  for (size_t i = 0; i < stats->stats_num; i++)
+    {
+      struct ofl_port_stats *port = stats->stats[i];
+      std::map<SwitchKey_t, PortStats>::iterator it =
+        m_ports.find (SwitchKey_t (dpId, port->port_no));
+      if (it == m_ports.end ())
+        {
+          continue;
+        }
+      PortStats &counters = it->second;
+      uint64_t bytes = port->tx_bytes - counters.txBytes;
+      uint64_t packets = port->tx_packets - counters.txPackets;
+      uint64_t dropped = port->tx_dropped - counters.txDropped;
+      double seconds = (Simulator::Now () - counters.lastPoll).GetSeconds ();
+      counters.rate = 0;
+      if (counters.lastPoll.IsStrictlyPositive () && seconds > 0)
+        {
+          double offered = bytes + (packets ? dropped * (double)bytes / packets : 0);
+          counters.rate = 8 * offered / seconds;
+        }
+      counters.txBytes = port->tx_bytes;
+      counters.txPackets = port->tx_packets;
+      counters.txDropped = port->tx_dropped;
+      counters.lastPoll = Simulator::Now ();
+    }
+
+  std::map<SwitchKey_t, SelectGroup>::iterator it;
+  for (it = m_groups.lower_bound (SwitchKey_t (dpId, 0));
+       it != m_groups.end () && it->first.first == dpId; it++)
+    {
+      uint32_t groupId = it->first.second;
+      SelectGroup &group = it->second;
+      uint32_t nPorts = group.ports.size ();
+
+      std::vector<double> rates (nPorts);
+      double total = 0;
+      bool speedsKnown = true;
+      for (uint32_t i = 0; i < nPorts; i++)
+        {
+          const PortStats &counters = m_ports[SwitchKey_t (dpId, group.ports[i])];
+          rates[i] = counters.rate;
+          total += counters.rate;
+          speedsKnown = speedsKnown && counters.speed != 0;
+        }
+      if (total == 0)
+        {
+          continue;
+        }
+
+      // The most loaded port with weight to spare, and the least loaded one
+      std::vector<double> loads (nPorts);
+      uint32_t more = nPorts;
+      uint32_t less = 0;
+      for (uint32_t i = 0; i < nPorts; i++)
+        {
+          uint64_t speed = m_ports[SwitchKey_t (dpId, group.ports[i])].speed;
+          loads[i] = speedsKnown ? rates[i] / (1000.0 * speed) : rates[i] / total;
+          if (group.weights[i] > 1 && (more == nPorts || loads[i] > loads[more]))
+            {
+              more = i;
+            }
+          if (loads[i] < loads[less])
+            {
+              less = i;
+            }
+        }
+      if (more == nPorts || loads[more] - loads[less] <= m_rebalanceHysteresis)
+        {
+          continue;
+        }
+      NS_LOG_DEBUG ("Switch " << dpId << " group " << groupId << " port "
+                    << group.ports[more] << " load " << loads[more] << " port "
+                    << group.ports[less] << " load " << loads[less]);
+
+      uint16_t step = std::min<uint16_t> (m_rebalanceStep, group.weights[more] - 1);
+      std::vector<uint16_t> weights = group.weights;
+      weights[more] -= step;
+      weights[less] += step;
+      NS_LOG_INFO ("Switch " << dpId << " group " << groupId << " moved "
+                   << step << " of weight from port " << group.ports[more]
+                   << " to port " << group.ports[less]);
+      SetSelectGroupWeights (dpId, groupId, weights);
+      m_rebalanceTrace (dpId, groupId, group.ports[more], group.ports[less],
+                        loads[more], loads[less]);
+    }
+}
+
+} // namespace ns3
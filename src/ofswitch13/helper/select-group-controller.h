@@ -0,0 +1,183 @@
+/* -*-  Mode: C++; c-file-style: "gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef SELECT_GROUP_CONTROLLER_H
+#define SELECT_GROUP_CONTROLLER_H
+
+#include <ns3/ofswitch13-controller.h>
+#include <map>
+#include <string>
+#include <vector>
+
+namespace ns3 {
+
+/**
+ * \ingroup ofswitch13
+ * \brief Base of the OpenFlow 1.3 controllers spreading packets over several
+ * ports by select groups
+ *
+ * With FlowHashing, the groups keep the packets of a flow on one bucket,
+ * chosen from a hash of the flow in proportion to the bucket weights;
+ * otherwise the buckets are taken in turn for each packet.
+ *
+ * Every RebalanceInterval, the controller polls the port statistics of the
+ * switches with a group, and in each group moves RebalanceStep of weight
+ * from the bucket of the most loaded port to the bucket of the least loaded
+ * one when their loads differ by more than the RebalanceHysteresis. The load
+ * of a port counts all the packets it sends, from any group.
+ */
+class SelectGroupController : public OFSwitch13Controller
+{
+public:
+  SelectGroupController ();          //!< Default constructor.
+  virtual ~SelectGroupController (); //!< Dummy destructor.
+
+  /** Destructor implementation */
+  virtual void DoDispose ();
+
+  /**
+   * Register this type.
+   * \return The object TypeId.
+   */
+  static TypeId GetTypeId (void);
+
+  /**
+   * Handle a multipart reply message sent by the switch to this controller,
+   * with the port statistics and descriptions of the switches with a group.
+   * \note Inherited from OFSwitch13Controller.
+   * \param msg The OpenFlow received message.
+   * \param swtch The remote switch metadata.
+   * \param xid The transaction id from the request message.
+   * \return 0 if everything's ok, otherwise an error number.
+   */
+  virtual ofl_err HandleMultipartReply (
+    struct ofl_msg_multipart_reply_header *msg, Ptr<const RemoteSwitch> swtch,
+    uint32_t xid);
+
+  /**
+   * TracedCallback signature for the rebalance of the weights of a group.
+   * \param dpId The switch datapath ID.
+   * \param groupId The group ID.
+   * \param fromPort The port whose bucket lost weight.
+   * \param toPort The port whose bucket gained weight.
+   * \param fromLoad The load of fromPort over the last interval.
+   * \param toLoad The load of toPort over the last interval.
+   */
+  typedef void (*RebalanceTracedCallback)(
+    uint64_t dpId, uint32_t groupId, uint32_t fromPort, uint32_t toPort,
+    double fromLoad, double toLoad);
+
+protected:
+  /**
+   * \return The dpctl group type of the select groups.
+   */
+  std::string GetSelectGroupType (void) const;
+
+  /**
+   * Install a select group with an output bucket per port on a switch, and
+   * rebalance its weights from then on.
+   * \param swtch The switch information.
+   * \param groupId The group ID.
+   * \param ports The output ports of the buckets.
+   * \param weights The initial weights of the buckets.
+   */
+  void AddSelectGroup (Ptr<const RemoteSwitch> swtch, uint32_t groupId,
+                       const std::vector<uint32_t> &ports,
+                       const std::vector<uint16_t> &weights);
+
+  /**
+   * Set the weights of the buckets of an installed select group.
+   * \param dpId The switch datapath ID.
+   * \param groupId The group ID.
+   * \param weights The weights of the buckets, in the order of the ports.
+   */
+  void SetSelectGroupWeights (uint64_t dpId, uint32_t groupId,
+                              const std::vector<uint16_t> &weights);
+
+  /**
+   * \param dpId The switch datapath ID.
+   * \param groupId The group ID.
+   * \return The weights of the buckets of the group, empty if the group is
+   *         not installed.
+   */
+  std::vector<uint16_t> GetSelectGroupWeights (uint64_t dpId,
+                                               uint32_t groupId) const;
+
+private:
+  /** A select group of a switch */
+  struct SelectGroup
+  {
+    std::vector<uint32_t> ports;   //!< Output ports of the buckets.
+    std::vector<uint16_t> weights; //!< Weights of the buckets.
+  };
+
+  /** The counters of a port of a switch with a group */
+  struct PortStats
+  {
+    uint64_t speed;     //!< Port speed [kbps], 0 if unknown.
+    uint64_t txBytes;   //!< Port counter at the last poll.
+    uint64_t txPackets; //!< Port counter at the last poll.
+    uint64_t txDropped; //!< Port counter at the last poll.
+    Time     lastPoll;  //!< Time of the last poll, zero if none.
+    double   rate;      //!< Offered rate over the last interval [bps].
+  };
+
+  /** A group or port of a switch: <datapath ID / group or port number> */
+  typedef std::pair<uint64_t, uint32_t> SwitchKey_t;
+
+  /**
+   * \param command The dpctl group-mod command, add or mod.
+   * \param groupId The group ID.
+   * \param group The select group.
+   * \return The dpctl command of the group.
+   */
+  std::string GetSelectGroupCommand (std::string command, uint32_t groupId,
+                                     const SelectGroup &group) const;
+
+  /**
+   * Request the port statistics of the switches with a group, and schedule
+   * the next poll.
+   */
+  void PollPortStats (void);
+
+  /**
+   * Measure the load of the ports of a switch from new port statistics, and
+   * rebalance the weights of its groups.
+   * \param swtch The switch information.
+   * \param stats The port statistics reply.
+   */
+  void RebalanceSelectGroups (Ptr<const RemoteSwitch> swtch,
+                              struct ofl_msg_multipart_reply_port *stats);
+
+  bool      m_flowHashing;         //!< Hash the flows onto the buckets
+  Time      m_rebalanceInterval;   //!< Interval between rebalances
+  double    m_rebalanceHysteresis; //!< Load difference for a rebalance
+  uint16_t  m_rebalanceStep;       //!< Weight moved by a rebalance
+  EventId   m_pollEvent;           //!< Next poll of the port statistics
+
+  /** The select groups of the switches */
+  std::map<SwitchKey_t, SelectGroup> m_groups;
+
+  /** The counters of the ports of the groups */
+  std::map<SwitchKey_t, PortStats> m_ports;
+
+  /** Trace source fired when the weights of a group are rebalanced */
+  TracedCallback<uint64_t, uint32_t, uint32_t, uint32_t, double, double>
+  m_rebalanceTrace;
+};
+
+} // namespace ns3
+#endif /* SELECT_GROUP_CONTROLLER_H */
@@ -27,6 +27,14 @@ enum ofp_extension_commands { /* Queue configuration commands */
     OFP_EXT_COUNT
 };
 
+/* Experimenter group types, in the range [128, 255] reserved for them. */
+enum ofp_ext_group_type {
+    /* Select group which hashes the flow of the packet onto the buckets,
+     * in proportion to their weights, so that the packets of a flow all go
+     * through the same bucket. Buckets of weight 0 get no flows. */
+    OFPGT_EXT_SELECT_HASH = 128
+};
+
 struct ofp_extension_header {
     struct ofp_header header;
     uint32_t vendor;            /* OPENFLOW_VENDOR_ID. */
@@ -39,6 +39,7 @@
 #include "ofl-print.h"
 #include "oxm-match.h"
 #include "openflow/openflow.h"
+#include "openflow/openflow-ext.h"
 
 
 char *
@@ -771,6 +772,7 @@ ofl_group_type_print(FILE *stream, uint8_t type) {
         case (OFPGT_SELECT):   { fprintf(stream, "sel"); return; }
         case (OFPGT_INDIRECT): { fprintf(stream, "ind"); return; }
         case (OFPGT_FF):       { fprintf(stream, "ff"); return; }
+        case (OFPGT_EXT_SELECT_HASH): { fprintf(stream, "hash"); return; }
         default: {               fprintf(stream, "?(%u)", type); return; }
     }
 }
@@ -41,6 +41,7 @@
 #include "ofl-log.h"
 #include "oxm-match.h"
 #include "openflow/openflow.h"
+#include "openflow/openflow-ext.h"
 
 #define LOG_MODULE ofl_str_u
 OFL_LOG_INIT(LOG_MODULE)
@@ -442,7 +443,7 @@ ofl_structs_bucket_unpack(struct ofp_bucket *src, size_t *len, uint8_t gtype, st
         return ofl_error(OFPET_GROUP_MOD_FAILED, OFPGMFC_INVALID_GROUP);
     }
 
-    if (gtype != OFPGT_SELECT && ntohs(src->weight) > 0) {
+    if (gtype != OFPGT_SELECT && gtype != OFPGT_EXT_SELECT_HASH && ntohs(src->weight) > 0) {
         OFL_LOG_WARN(LOG_MODULE, "Received bucket has weight for non-SELECT group.");
         return ofl_error(OFPET_GROUP_MOD_FAILED, OFPGMFC_INVALID_GROUP);
     }
@@ -371,6 +371,11 @@ flow_entry_create(struct datapath *dp, struct flow_table *table, struct ofl_msg_
     list_init(&entry->match_node);
     list_init(&entry->idle_node);
     list_init(&entry->hard_node);
+    list_init(&entry->linear_node);
+    list_init(&entry->key_node);
+    entry->tuple        = NULL;
+    entry->tuple_key    = NULL;
+    entry->seq          = 0;
 
     list_init(&entry->group_refs);
     init_group_refs(entry);
@@ -390,6 +395,7 @@ flow_entry_destroy(struct flow_entry *entry) {
     ofl_structs_free_flow_stats(entry->stats, entry->dp->exp);
     // assumes it is a standard match
     //free(entry->match);
+    free(entry->tuple_key);
     free(entry);
 }
 
@@ -407,6 +413,7 @@ flow_entry_remove(struct flow_entry *entry, uint8_t reason) {
         }
     }
 
+    flow_table_unlink(entry->table, entry);
     list_remove(&entry->match_node);
     list_remove(&entry->hard_node);
     list_remove(&entry->idle_node);
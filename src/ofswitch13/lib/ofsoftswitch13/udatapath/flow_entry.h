@@ -35,6 +35,7 @@
 #include <stdbool.h>
 #include <sys/types.h>
 #include "datapath.h"
+#include "hmap.h"
 #include "list.h"
 #include "oflib/ofl-structs.h"
 #include "oflib/ofl-messages.h"
@@ -48,6 +49,16 @@ struct flow_entry {
     struct list              match_node;  /* list nodes in flow table lists. */
     struct list              hard_node;
     struct list              idle_node;
+    struct hmap_node         tuple_node;  /* hmap node in the tuple of the entry. */
+    struct list              key_node;    /* circular list of the entries of the
+                                             tuple with the same key, in lookup
+                                             order; only the first is in the hmap. */
+    struct list              linear_node; /* list node in the table linear entries. */
+    struct flow_tuple       *tuple;       /* tuple of the entry; NULL if it is
+                                             looked up linearly. */
+    uint8_t                 *tuple_key;   /* masked values of the tuple fields. */
+    uint64_t                 seq;         /* insertion order among the entries
+                                             of the same priority. */
 
     struct datapath         *dp;
     struct flow_table       *table;
@@ -34,6 +34,7 @@
 #include "datapath.h"
 #include "flow_table.h"
 #include "flow_entry.h"
+#include "hash.h"
 #include "oflib/ofl.h"
 #include "oflib/oxm-match.h"
 #include "time.h"
@@ -104,6 +105,280 @@ add_to_timeout_lists(struct flow_table *table, struct flow_entry *entry) {
     }
 }
 
+/* Returns true if entry a comes before entry b in the lookup order: of a
+ * higher priority, or of the same priority and inserted before. */
+static inline bool
+flow_entry_precedes(struct flow_entry *a, struct flow_entry *b) {
+    return a->stats->priority > b->stats->priority ||
+           (a->stats->priority == b->stats->priority && a->seq < b->seq);
+}
+
+/* Fills the tuple fields of a match, ordered by header, and their masked
+ * values in key. Returns false if the match has to be checked field by field
+ * instead. */
+static bool
+flow_tuple_fields(struct ofl_match_header *m, struct flow_tuple_field *fields,
+                  size_t *fields_num, uint8_t *key, size_t *key_len) {
+    struct ofl_match *match = (struct ofl_match *)m;
+    struct ofl_match_tlv *f;
+    uint8_t *values[FLOW_TUPLE_MAX_FIELDS];
+    size_t i, j, n = 0, len = 0;
+
+    if (m->type != OFPMT_OXM) {
+        return false;
+    }
+    if (m->length == 0) {
+        /* matches all the packets */
+        *fields_num = 0;
+        *key_len = 0;
+        return true;
+    }
+
+    HMAP_FOR_EACH(f, struct ofl_match_tlv, hmap_node, &match->match_fields) {
+        uint32_t header = f->header;
+        size_t field_len = OXM_LENGTH(header);
+        uint8_t *mask = NULL;
+
+        if (OXM_HASMASK(header)) {
+            field_len /= 2;
+            header &= 0xfffffe00;
+            header |= field_len;
+            mask = f->value + field_len;
+            /* A mask of all ones matches the field exactly */
+            for (j = 0; j < field_len && mask[j] == 0xff; j++);
+            if (j == field_len) {
+                mask = NULL;
+            }
+        }
+        /* The VLAN ID and IPv6 extension headers are not matched by
+         * equality, see packet_match */
+        if (header == OXM_OF_VLAN_VID || header == OXM_OF_IPV6_EXTHDR) {
+            return false;
+        }
+        switch (field_len) {
+            case 1: case 2: case 3: case 4: case 6: case 8: case 16:
+                break;
+            default:
+                return false;
+        }
+        if (n == FLOW_TUPLE_MAX_FIELDS || len + field_len > FLOW_TUPLE_MAX_KEY) {
+            return false;
+        }
+
+        for (i = n; i > 0 && fields[i - 1].header > header; i--) {
+            fields[i] = fields[i - 1];
+            values[i] = values[i - 1];
+        }
+        fields[i].header = header;
+        fields[i].mask = mask;
+        values[i] = f->value;
+        n++;
+        len += field_len;
+    }
+
+    len = 0;
+    for (i = 0; i < n; i++) {
+        size_t field_len = OXM_LENGTH(fields[i].header);
+        for (j = 0; j < field_len; j++) {
+            key[len + j] = fields[i].mask == NULL ? values[i][j]
+                                                  : values[i][j] & fields[i].mask[j];
+        }
+        len += field_len;
+    }
+    *fields_num = n;
+    *key_len = len;
+    return true;
+}
+
+/* Fills key with the masked values of the tuple fields in the packet.
+ * Returns false if the packet lacks one of the fields. */
+static inline bool
+flow_tuple_packet_key(struct flow_tuple *tuple, struct ofl_match *packet, uint8_t *key) {
+    size_t i, j, len = 0;
+
+    for (i = 0; i < tuple->fields_num; i++) {
+        struct flow_tuple_field *field = &tuple->fields[i];
+        size_t field_len = OXM_LENGTH(field->header);
+        struct ofl_match_tlv *f = oxm_match_lookup(field->header, packet);
+
+        if (f == NULL) {
+            return false;
+        }
+        if (field->mask == NULL) {
+            memcpy(key + len, f->value, field_len);
+        } else {
+            for (j = 0; j < field_len; j++) {
+                key[len + j] = f->value[j] & field->mask[j];
+            }
+        }
+        len += field_len;
+    }
+    return true;
+}
+
+/* Moves the tuple to its place in the lookup order of the table. */
+static void
+flow_tuple_sort(struct flow_table *table, struct flow_tuple *tuple) {
+    struct flow_tuple *t;
+
+    list_remove(&tuple->node);
+    LIST_FOR_EACH (t, struct flow_tuple, node, &table->tuples) {
+        if (t->max_priority < tuple->max_priority) {
+            break;
+        }
+    }
+    list_insert(&t->node, &tuple->node);
+}
+
+/* Returns the tuple of the table with the given fields, creating it if
+ * needed. */
+static struct flow_tuple *
+flow_tuple_get(struct flow_table *table, struct flow_tuple_field *fields,
+               size_t fields_num, size_t key_len, uint16_t priority) {
+    struct flow_tuple *tuple;
+    size_t i;
+
+    LIST_FOR_EACH (tuple, struct flow_tuple, node, &table->tuples) {
+        if (tuple->fields_num != fields_num) {
+            continue;
+        }
+        for (i = 0; i < fields_num; i++) {
+            struct flow_tuple_field *a = &tuple->fields[i];
+            struct flow_tuple_field *b = &fields[i];
+            if (a->header != b->header || (a->mask == NULL) != (b->mask == NULL) ||
+                (a->mask != NULL && memcmp(a->mask, b->mask, OXM_LENGTH(a->header)) != 0)) {
+                break;
+            }
+        }
+        if (i == fields_num) {
+            if (priority > tuple->max_priority) {
+                tuple->max_priority = priority;
+                flow_tuple_sort(table, tuple);
+            }
+            return tuple;
+        }
+    }
+
+    tuple = xmalloc(sizeof(struct flow_tuple));
+    tuple->fields_num = fields_num;
+    tuple->fields = xmalloc(sizeof(struct flow_tuple_field) * fields_num);
+    for (i = 0; i < fields_num; i++) {
+        tuple->fields[i].header = fields[i].header;
+        tuple->fields[i].mask = fields[i].mask == NULL ? NULL
+                              : xmemdup(fields[i].mask, OXM_LENGTH(fields[i].header));
+    }
+    tuple->key_len = key_len;
+    tuple->max_priority = priority;
+    hmap_init(&tuple->entries);
+    list_init(&tuple->node);
+    flow_tuple_sort(table, tuple);
+    return tuple;
+}
+
+/* Returns the first entry of the tuple with the given key, NULL if none. */
+static inline struct flow_entry *
+flow_tuple_find(struct flow_tuple *tuple, const uint8_t *key, uint32_t hash) {
+    struct hmap_node *node;
+
+    /* NOTE: HMAP_FOR_EACH_WITH_HASH relies on the hmap node being the first
+     * member of the struct, which tuple_node is not. */
+    for (node = hmap_first_with_hash(&tuple->entries, hash); node != NULL;
+         node = hmap_next_with_hash(node)) {
+        struct flow_entry *entry = CONTAINER_OF(node, struct flow_entry, tuple_node);
+        if (memcmp(entry->tuple_key, key, tuple->key_len) == 0) {
+            return entry;
+        }
+    }
+    return NULL;
+}
+
+static void
+flow_tuple_destroy(struct flow_tuple *tuple) {
+    size_t i;
+
+    list_remove(&tuple->node);
+    for (i = 0; i < tuple->fields_num; i++) {
+        free(tuple->fields[i].mask);
+    }
+    free(tuple->fields);
+    hmap_destroy(&tuple->entries);
+    free(tuple);
+}
+
+/* Adds a flow entry to the lookup structures of the table, after its
+ * insertion sequence is set. */
+static void
+flow_table_link(struct flow_table *table, struct flow_entry *entry) {
+    struct flow_tuple_field fields[FLOW_TUPLE_MAX_FIELDS];
+    uint8_t key[FLOW_TUPLE_MAX_KEY];
+    size_t fields_num, key_len;
+    struct ofl_match_header *m;
+
+    m = entry->match == NULL ? entry->stats->match : entry->match;
+
+    if (flow_tuple_fields(m, fields, &fields_num, key, &key_len)) {
+        struct flow_tuple *tuple;
+        struct flow_entry *first;
+        uint32_t hash = hash_bytes(key, key_len, 0);
+
+        tuple = flow_tuple_get(table, fields, fields_num, key_len, entry->stats->priority);
+        entry->tuple = tuple;
+        entry->tuple_key = xmemdup(key, key_len);
+
+        /* Entries of the same key differ in priority; keep the first one
+         * in the hmap, so that lookups do not go through the others */
+        first = flow_tuple_find(tuple, key, hash);
+        if (first == NULL) {
+            list_init(&entry->key_node);
+            hmap_insert(&tuple->entries, &entry->tuple_node, hash);
+        } else if (flow_entry_precedes(entry, first)) {
+            list_insert(&first->key_node, &entry->key_node);
+            hmap_remove(&tuple->entries, &first->tuple_node);
+            hmap_insert(&tuple->entries, &entry->tuple_node, hash);
+        } else {
+            struct flow_entry *e = first;
+
+            do {
+                e = CONTAINER_OF(e->key_node.next, struct flow_entry, key_node);
+            } while (e != first && !flow_entry_precedes(entry, e));
+            list_insert(&e->key_node, &entry->key_node);
+        }
+    } else {
+        struct flow_entry *e;
+
+        LIST_FOR_EACH (e, struct flow_entry, linear_node, &table->linear_entries) {
+            if (flow_entry_precedes(entry, e)) {
+                break;
+            }
+        }
+        list_insert(&e->linear_node, &entry->linear_node);
+    }
+}
+
+void
+flow_table_unlink(struct flow_table *table UNUSED, struct flow_entry *entry) {
+    struct flow_tuple *tuple = entry->tuple;
+    uint32_t hash;
+
+    if (tuple == NULL) {
+        list_remove(&entry->linear_node);
+        return;
+    }
+    hash = hash_bytes(entry->tuple_key, tuple->key_len, 0);
+    if (flow_tuple_find(tuple, entry->tuple_key, hash) == entry) {
+        hmap_remove(&tuple->entries, &entry->tuple_node);
+        if (!list_is_empty(&entry->key_node)) {
+            struct flow_entry *next = CONTAINER_OF(entry->key_node.next, struct flow_entry, key_node);
+            hmap_insert(&tuple->entries, &next->tuple_node, hash);
+        }
+    }
+    list_remove(&entry->key_node);
+    entry->tuple = NULL;
+    if (hmap_is_empty(&tuple->entries)) {
+        flow_tuple_destroy(tuple);
+    }
+}
+
 /* Handles flow mod messages with ADD command. */
 static ofl_err
 flow_table_add(struct flow_table *table, struct ofl_msg_flow_mod *mod, bool check_overlap, bool *match_kept, bool *insts_kept) {
@@ -122,6 +397,9 @@ flow_table_add(struct flow_table *table, struct ofl_msg_flow_mod *mod, bool chec
             *insts_kept = true;
 
             /* NOTE: no flow removed message should be generated according to spec. */
+            new_entry->seq = entry->seq;
+            flow_table_unlink(table, entry);
+            flow_table_link(table, new_entry);
             list_replace(&new_entry->match_node, &entry->match_node);
             list_remove(&entry->hard_node);
             list_remove(&entry->idle_node);
@@ -145,6 +423,8 @@ flow_table_add(struct flow_table *table, struct ofl_msg_flow_mod *mod, bool chec
     *insts_kept = true;
 
     list_insert(&entry->match_node, &new_entry->match_node);
+    new_entry->seq = table->entry_seq++;
+    flow_table_link(table, new_entry);
     add_to_timeout_lists(table, new_entry);
 
     return 0;
@@ -212,13 +492,38 @@ flow_table_flow_mod(struct flow_table *table, struct ofl_msg_flow_mod *mod, bool
 
 struct flow_entry *
 flow_table_lookup(struct flow_table *table, struct packet *pkt) {
-    struct flow_entry *entry;
+    struct flow_entry *entry, *found = NULL;
+    struct flow_tuple *tuple;
+    uint8_t key[FLOW_TUPLE_MAX_KEY];
 
     table->stats->lookup_count++;
 
-    LIST_FOR_EACH(entry, struct flow_entry, match_node, &table->match_entries) {
+    if (!pkt->handle_std->valid) {
+        packet_handle_std_validate(pkt->handle_std);
+    }
+    if (pkt->handle_std->valid) {
+        LIST_FOR_EACH (tuple, struct flow_tuple, node, &table->tuples) {
+            if (found != NULL && tuple->max_priority < found->stats->priority) {
+                /* neither this tuple nor the next ones come before */
+                break;
+            }
+            if (!flow_tuple_packet_key(tuple, &pkt->handle_std->match, key)) {
+                continue;
+            }
+            entry = flow_tuple_find(tuple, key, hash_bytes(key, tuple->key_len, 0));
+            if (entry != NULL && (found == NULL || flow_entry_precedes(entry, found))) {
+                found = entry;
+            }
+        }
+    }
+
+    LIST_FOR_EACH (entry, struct flow_entry, linear_node, &table->linear_entries) {
         struct ofl_match_header *m;
 
+        if (found != NULL && !flow_entry_precedes(entry, found)) {
+            break;
+        }
+
         m = entry->match == NULL ? entry->stats->match : entry->match;
 
         /* select appropriate handler, based on match type of flow entry. */
@@ -226,27 +531,30 @@ flow_table_lookup(struct flow_table *table, struct packet *pkt) {
             case (OFPMT_OXM): {
                if (packet_handle_std_match(pkt->handle_std,
                                             (struct ofl_match *)m)) {
-                    if (!entry->no_byt_count)                                            
-                        entry->stats->byte_count += pkt->buffer->size;
-                    if (!entry->no_pkt_count)
-                        entry->stats->packet_count++;
-                    entry->last_used = time_msec();
-
-                    table->stats->matched_count++;
-
-                    return entry;
+                    found = entry;
                 }
                 break;
-
-                break;
             }
             default: {
                 VLOG_WARN_RL(LOG_MODULE, &rl, "Trying to process flow entry with unknown match type (%u).", m->type);
             }
         }
+        if (found == entry) {
+            break;
+        }
     }
 
-    return NULL;
+    if (found != NULL) {
+        if (!found->no_byt_count)
+            found->stats->byte_count += pkt->buffer->size;
+        if (!found->no_pkt_count)
+            found->stats->packet_count++;
+        found->last_used = time_msec();
+
+        table->stats->matched_count++;
+    }
+
+    return found;
 }
 
 
@@ -404,6 +712,9 @@ flow_table_create(struct datapath *dp, uint8_t table_id) {
     list_init(&table->match_entries);
     list_init(&table->hard_entries);
     list_init(&table->idle_entries);
+    list_init(&table->tuples);
+    list_init(&table->linear_entries);
+    table->entry_seq = 0;
 
     return table;
 }
@@ -411,10 +722,14 @@ flow_table_create(struct datapath *dp, uint8_t table_id) {
 void
 flow_table_destroy(struct flow_table *table) {
     struct flow_entry *entry, *next;
+    struct flow_tuple *tuple, *next_tuple;
 
     LIST_FOR_EACH_SAFE (entry, next, struct flow_entry, match_node, &table->match_entries) {
         flow_entry_destroy(entry);
     }
+    LIST_FOR_EACH_SAFE (tuple, next_tuple, struct flow_tuple, node, &table->tuples) {
+        flow_tuple_destroy(tuple);
+    }
     free(table->features);
     free(table->stats);
     free(table);
@@ -30,6 +30,8 @@
 
 #ifndef FLOW_TABLE_H
 #define FLOW_TABLE_H 1
+#include "hmap.h"
+#include "list.h"
 #include "oflib/ofl.h"
 #include "oflib/ofl-messages.h"
 #include "oflib/ofl-structs.h"
@@ -43,8 +45,38 @@
 /****************************************************************************
  * Implementation of a flow table. The current implementation stores flow
  * entries in priority and then insertion order.
+ *
+ * For the lookups, the entries are also grouped in tuples: the entries of a
+ * tuple match the same fields, with the same masks, and are hashed by their
+ * masked field values. A packet is matched against all the entries of a
+ * tuple with a single hash lookup, and the tuples are probed in the order of
+ * the highest priority of their entries, until no tuple can hold an entry of
+ * higher priority than the one found. The entries matching the VLAN ID or
+ * the IPv6 extension headers, whose match is not an equality, are checked
+ * one by one after the tuples.
  ****************************************************************************/
 
+#define FLOW_TUPLE_MAX_FIELDS 64
+#define FLOW_TUPLE_MAX_KEY 512
+
+/* A field matched by the entries of a tuple. */
+struct flow_tuple_field {
+    uint32_t                   header;        /* header of the packet field. */
+    uint8_t                   *mask;          /* mask of the field; NULL if
+                                                 the field is matched exactly. */
+};
+
+struct flow_tuple {
+    struct list                node;          /* list node in the table, in the
+                                                 order of max_priority. */
+    size_t                     fields_num;
+    struct flow_tuple_field   *fields;        /* fields, ordered by header. */
+    size_t                     key_len;       /* length of the field values. */
+    uint16_t                   max_priority;  /* no entry has a higher priority;
+                                                 not lowered on removals. */
+    struct hmap                entries;       /* first entry of each key, by the
+                                                 hash of the masked field values. */
+};
 
 struct flow_table {
     struct datapath           *dp;
@@ -57,6 +89,13 @@ struct flow_table {
                                                 ordered by their timeout times. */
     struct list               idle_entries;   /* unordered list of entries with
                                                 idle timeout. */
+
+    struct list               tuples;         /* tuples of the entries, in
+                                                lookup order. */
+    struct list               linear_entries; /* entries looked up one by one,
+                                                in priority and insertion order. */
+    uint64_t                  entry_seq;      /* insertion sequence of the
+                                                next entry. */
 };
 
 extern uint32_t oxm_ids[];
@@ -74,6 +113,10 @@ flow_table_flow_mod(struct flow_table *table, struct ofl_msg_flow_mod *mod, bool
 struct flow_entry *
 flow_table_lookup(struct flow_table *table, struct packet *pkt);
 
+/* Removes a flow entry from the lookup structures of the table. */
+void
+flow_table_unlink(struct flow_table *table, struct flow_entry *entry);
+
 /* Orders the flow table to check the timeout its flows. */
 void
 flow_table_timeout(struct flow_table *table);
@@ -29,12 +29,16 @@
  */
 
 #include <stdbool.h>
+#include <math.h>
 #include "flow_entry.h"
 #include "group_entry.h"
 #include "group_table.h"
 #include "dp_actions.h"
 #include "datapath.h"
 #include "util.h"
+#include "hash.h"
+#include "packets.h"
+#include "openflow/openflow-ext.h"
 #include "oflib/ofl.h"
 #include "oflib/ofl-structs.h"
 #include "oflib/ofl-utils.h"
@@ -44,6 +48,9 @@
 
 static struct vlog_rate_limit rl = VLOG_RATE_LIMIT_INIT(60, 60);
 
+/* UDP port of GTP-U */
+#define GTPU_PORT 2152
+
 
 
 struct group_table;
@@ -75,6 +82,9 @@ init_select_group(struct group_entry *entry, struct ofl_msg_group_mod *mod);
 static size_t
 select_from_select_group(struct group_entry *entry);
 
+static size_t
+select_from_hash_group(struct group_entry *entry, struct packet *pkt);
+
 static size_t
 select_from_ff_group(struct group_entry *entry);
 
@@ -172,10 +182,11 @@ execute_all(struct group_entry *entry, struct packet *pkt) {
     packet_destroy(pkt);
 }
 
-/* Executes a group entry of type SELECT. */
+/* Executes a group entry of type SELECT or OFPGT_EXT_SELECT_HASH. */
 static void
 execute_select(struct group_entry *entry, struct packet *pkt) {
-    size_t b  = select_from_select_group(entry);
+    size_t b  = entry->desc->type == OFPGT_SELECT ? select_from_select_group(entry)
+                                                  : select_from_hash_group(entry, pkt);
 
     if (b != -1) {
         struct ofl_bucket *bucket = entry->desc->buckets[b];
@@ -287,7 +298,8 @@ group_entry_execute(struct group_entry *entry,
             execute_all(entry, packet);
             break;
         }
-        case (OFPGT_SELECT): {
+        case (OFPGT_SELECT):
+        case (OFPGT_EXT_SELECT_HASH): {
             execute_select(entry, packet);
             break;
         }
@@ -436,6 +448,121 @@ select_from_select_group(struct group_entry *entry) {
     return -1;
 }
 
+/* Returns the hash of the flow of the packet: the addresses, the IP
+ * protocol and the transport ports, the TEID for GTP-U traffic, and the
+ * tunnel ID set by the input port. */
+static uint32_t
+hash_packet_flow(struct packet *pkt) {
+    struct protocols_std *proto;
+    uint32_t words[12];
+    size_t n = 0;
+
+    packet_handle_std_validate(pkt->handle_std);
+    proto = pkt->handle_std->proto;
+
+    words[n++] = (uint32_t)pkt->tunnel_id;
+    words[n++] = (uint32_t)(pkt->tunnel_id >> 32);
+    if (proto->ipv4 != NULL) {
+        words[n++] = proto->ipv4->ip_src;
+        words[n++] = proto->ipv4->ip_dst;
+        words[n++] = proto->ipv4->ip_proto;
+    } else if (proto->ipv6 != NULL) {
+        memcpy(&words[n], &proto->ipv6->ipv6_src, sizeof(struct in6_addr));
+        memcpy(&words[n + 4], &proto->ipv6->ipv6_dst, sizeof(struct in6_addr));
+        n += 8;
+    } else {
+        /* No IP: the packets between two hosts are a flow */
+        if (proto->eth != NULL) {
+            memcpy(&words[n], proto->eth, 2 * ETH_ADDR_LEN);
+            n += 2 * ETH_ADDR_LEN / sizeof(uint32_t);
+        }
+        return hash_words(words, n, 0);
+    }
+
+    if (proto->tcp != NULL) {
+        words[n++] = (proto->tcp->tcp_src << 16) | proto->tcp->tcp_dst;
+    } else if (proto->udp != NULL) {
+        uint8_t *gtp = (uint8_t *)proto->udp + UDP_HEADER_LEN;
+
+        words[n++] = (proto->udp->udp_src << 16) | proto->udp->udp_dst;
+        /* GTPv1-U: the flows between two tunnel endpoints are told apart by the TEID */
+        if (proto->udp->udp_dst == htons(GTPU_PORT)
+            && gtp + 8 <= (uint8_t *)pkt->buffer->data + pkt->buffer->size
+            && (gtp[0] >> 5) == 1) {
+            memcpy(&words[n++], gtp + 4, sizeof(uint32_t));
+        }
+    } else if (proto->sctp != NULL) {
+        words[n++] = (proto->sctp->sctp_src << 16) | proto->sctp->sctp_dst;
+    }
+    return hash_words(words, n, 0);
+}
+
+/* Returns the identity of the bucket for the flow hashing: the first port
+ * or group it outputs to, else its watch port, else its index. Unlike the
+ * index, it does not change when other buckets are added, removed or
+ * reordered by a group modification. */
+static uint32_t
+bucket_identity(struct ofl_bucket *bucket, size_t index) {
+    size_t i;
+
+    for (i=0; i<bucket->actions_num; i++) {
+        struct ofl_action_header *action = bucket->actions[i];
+
+        if (action->type == OFPAT_OUTPUT) {
+            return hash_2words(OFPAT_OUTPUT, ((struct ofl_action_output *)action)->port);
+        }
+        if (action->type == OFPAT_GROUP) {
+            return hash_2words(OFPAT_GROUP, ((struct ofl_action_group *)action)->group_id);
+        }
+    }
+    if (bucket->watch_port != OFPP_ANY) {
+        return hash_2words(OFPAT_OUTPUT, bucket->watch_port);
+    }
+    return hash_2words(UINT16_MAX, index);
+}
+
+/* Selects a bucket from a hash select group, with weighted rendezvous
+ * hashing: each bucket scores the flow with a hash of the flow and of the
+ * bucket identity, scaled by the bucket weight, and the best score wins.
+ * When the weights or the buckets change, only the flows whose best bucket
+ * changes move, in proportion to the change of the weights. Buckets of the
+ * same identity score alike, and the first of them wins. */
+static size_t
+select_from_hash_group(struct group_entry *entry, struct packet *pkt) {
+    uint32_t flow;
+    double best_score = 0;
+    size_t best = -1;
+    size_t i;
+
+    if (entry->desc->buckets_num == 0) {
+        return -1;
+    }
+
+    flow = hash_packet_flow(pkt);
+    for (i=0; i<entry->desc->buckets_num; i++) {
+        struct ofl_bucket *bucket = entry->desc->buckets[i];
+        uint16_t weight = bucket->weight;
+        double u;
+        double score;
+
+        if (weight == 0) {
+            continue;
+        }
+        /* uniform in (0, 1), and -weight / ln(u) is distributed so that a
+         * bucket wins in proportion to its weight */
+        u = ((double)hash_2words(flow, bucket_identity(bucket, i)) + 0.5) / 4294967296.0;
+        score = -weight / log(u);
+        if (best == -1 || score > best_score) {
+            best = i;
+            best_score = score;
+        }
+    }
+    if (best == -1) {
+        VLOG_WARN_RL(LOG_MODULE, &rl, "Could not select from hash group: no bucket has weight.");
+    }
+    return best;
+}
+
 /* Selects the first live bucket from the failfast group. */
 static size_t
 select_from_ff_group(struct group_entry *entry) {
@@ -108,7 +108,8 @@ static struct names8 group_type_names[] = {
         {OFPGT_ALL,      "all"},
         {OFPGT_SELECT,   "sel"},
         {OFPGT_INDIRECT, "ind"},
-        {OFPGT_FF,       "ff"}
+        {OFPGT_FF,       "ff"},
+        {OFPGT_EXT_SELECT_HASH, "hash"}
 };
 
 static struct names16 group_mod_cmd_names[] = {
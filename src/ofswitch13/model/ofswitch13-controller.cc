@@ -20,6 +20,7 @@
 
 #include <wordexp.h>
 #include <ns3/uinteger.h>
+#include <ns3/trace-source-accessor.h>
 #include <ns3/tcp-socket-factory.h>
 #include "ofswitch13-controller.h"
 
@@ -53,6 +54,18 @@ OFSwitch13Controller::GetTypeId (void)
                    UintegerValue (6653),
                    MakeUintegerAccessor (&OFSwitch13Controller::m_port),
                    MakeUintegerChecker<uint16_t> ())
+    .AddAttribute ("MaxBatchSize",
+                   "Maximum number of bytes of messages packed into a write "
+                   "to the control channel by SendBatchToSwitch. It must not "
+                   "exceed the size of the TCP socket send buffer.",
+                   UintegerValue (32768),
+                   MakeUintegerAccessor (&OFSwitch13Controller::m_maxBatchSize),
+                   MakeUintegerChecker<uint32_t> (1))
+    .AddTraceSource ("BarrierReply",
+                     "A barrier reply was received from a switch.",
+                     MakeTraceSourceAccessor (
+                       &OFSwitch13Controller::m_barrierTrace),
+                     "ns3::OFSwitch13Controller::BarrierTracedCallback")
   ;
   return tid;
 }
@@ -85,17 +98,18 @@ OFSwitch13Controller::DpctlExecute (Ptr<const RemoteSwitch> swtch,
   argv = cmd.we_wordv;
   argc = cmd.we_wordc;
 
+  int error = 0;
   if (!strcmp (argv[0], "set-table-match") || !strcmp (argv[0], "ping"))
     {
       NS_LOG_ERROR ("Dpctl command currently not supported.");
     }
   else
     {
-      return dpctl_exec_ns3_command ((void*)PeekPointer (swtch), argc, argv);
+      error = dpctl_exec_ns3_command ((void*)PeekPointer (swtch), argc, argv);
     }
 
   wordfree (&cmd);
-  return 0;
+  return error;
 }
 
 int
@@ -209,10 +223,7 @@ OFSwitch13Controller::SendToSwitch (Ptr<const RemoteSwitch> swtch,
 {
   NS_LOG_FUNCTION (this << swtch);
 
-  char *msgStr = ofl_msg_to_string (msg, 0);
-  NS_LOG_DEBUG ("TX to switch " << swtch->GetIpv4 () <<
-                " [dp " << swtch->GetDpId () << "]: " << msgStr);
-  free (msgStr);
+  LogTxMessage (swtch, msg);
 
   // Set the transaction ID only for unknown values
   if (!xid)
@@ -263,6 +274,62 @@ OFSwitch13Controller::SendEchoRequest (Ptr<const RemoteSwitch> swtch,
     }
 }
 
+int
+OFSwitch13Controller::SendBatchToSwitch (
+  Ptr<const RemoteSwitch> swtch,
+  const std::vector<struct ofl_msg_header*> &msgs)
+{
+  NS_LOG_FUNCTION (this << swtch << msgs.size ());
+
+  // Pack the messages back to back, writing them to the control channel
+  // whenever the next one would overflow the batch.
+  std::vector<uint8_t> batch;
+  batch.reserve (m_maxBatchSize);
+  int error = 0;
+  for (size_t i = 0; i < msgs.size (); i++)
+    {
+      LogTxMessage (swtch, msgs[i]);
+
+      uint8_t *buf;
+      size_t bufSize;
+      error = ofl_msg_pack (msgs[i], GetNextXid (), &buf, &bufSize, 0);
+      if (error)
+        {
+          NS_LOG_ERROR ("Error packing message " << i << " of the batch.");
+          break;
+        }
+      if (!batch.empty () && batch.size () + bufSize > m_maxBatchSize)
+        {
+          swtch->m_handler->SendMessage (
+            Create<Packet> (&batch[0], batch.size ()));
+          batch.clear ();
+        }
+      batch.insert (batch.end (), buf, buf + bufSize);
+      free (buf);
+    }
+  if (!batch.empty ())
+    {
+      swtch->m_handler->SendMessage (Create<Packet> (&batch[0], batch.size ()));
+    }
+
+  SendBarrierRequest (swtch);
+  return error;
+}
+
+void
+OFSwitch13Controller::LogTxMessage (Ptr<const RemoteSwitch> swtch,
+                                    struct ofl_msg_header *msg) const
+{
+  // Printing the message costs more than sending it
+  if (g_log.IsEnabled (LOG_DEBUG))
+    {
+      char *msgStr = ofl_msg_to_string (msg, 0);
+      NS_LOG_DEBUG ("TX to switch " << swtch->GetIpv4 () <<
+                    " [dp " << swtch->GetDpId () << "]: " << msgStr);
+      free (msgStr);
+    }
+}
+
 void
 OFSwitch13Controller::SendBarrierRequest (Ptr<const RemoteSwitch> swtch)
 {
@@ -344,6 +411,7 @@ OFSwitch13Controller::HandleBarrierReply (
   else
     {
       NS_LOG_INFO ("Barrier reply from " << it->second.m_swtch->GetIpv4 ());
+      m_barrierTrace (swtch->GetDpId (), Simulator::Now () - it->second.m_send);
       m_barrierMap.erase (it);
     }
 
@@ -747,6 +815,7 @@ OFSwitch13Controller::EchoInfo::GetRtt (void) const
 
 OFSwitch13Controller::BarrierInfo::BarrierInfo (Ptr<const RemoteSwitch> swtch)
   : m_waiting (true),
+    m_send (Simulator::Now ()),
     m_swtch (swtch)
 {
 }
@@ -23,9 +23,11 @@
 
 #include <ns3/application.h>
 #include <ns3/socket.h>
+#include <ns3/traced-callback.h>
 #include "ofswitch13-interface.h"
 #include "ofswitch13-socket-handler.h"
 #include <string>
+#include <vector>
 
 namespace ns3 {
 
@@ -137,6 +139,7 @@ public:
 
 private:
     bool                    m_waiting;    //!< True when waiting for reply.
+    Time                    m_send;       //!< Send time.
     Ptr<const RemoteSwitch> m_swtch;      //!< Remote switch.
   };
 
@@ -192,6 +195,13 @@ public:
   static void DpctlSendAndPrint (struct vconn *vconn,
                                  struct ofl_msg_header *msg);
 
+  /**
+   * TracedCallback signature for barrier replies.
+   * \param dpId The OpenFlow datapath ID.
+   * \param delay The time since the barrier request was sent.
+   */
+  typedef void (*BarrierTracedCallback)(uint64_t dpId, Time delay);
+
 protected:
   // inherited from Application
   virtual void StartApplication (void);
@@ -228,6 +238,18 @@ protected:
   int SendToSwitch (Ptr<const RemoteSwitch> swtch, struct ofl_msg_header *msg,
                     uint32_t xid = 0);
 
+  /**
+   * Send a batch of OFLib messages to a registered switch, followed by a
+   * single barrier request. The messages are packed back to back, so that
+   * each write to the control channel carries up to MaxBatchSize bytes of
+   * them, instead of one message each. The messages are not freed.
+   * \param swtch The remote switch to receive the messages.
+   * \param msgs The OFLib messages to send, in order.
+   * \return 0 if everything's ok, otherwise an error number.
+   */
+  int SendBatchToSwitch (Ptr<const RemoteSwitch> swtch,
+                         const std::vector<struct ofl_msg_header*> &msgs);
+
   /**
    * Send an echo request message to switch, and wait for a non-blocking reply.
    * \param swtch The remote switch to receive the message.
@@ -332,6 +354,14 @@ private:
   ofl_err HandleSwitchMsg (struct ofl_msg_header *msg, Ptr<RemoteSwitch> swtch,
                            uint32_t xid);
 
+  /**
+   * Log an OpenFlow message sent to a switch, when debug logging is on.
+   * \param swtch The remote switch metadata.
+   * \param msg The OFLib message sent.
+   */
+  void LogTxMessage (Ptr<const RemoteSwitch> swtch,
+                     struct ofl_msg_header *msg) const;
+
   /**
    * Receive an OpenFlow packet from switch.
    * \param packet The packet with the OpenFlow message.
@@ -381,12 +411,16 @@ private:
 
   uint32_t        m_xid;              //!< Global transaction idx.
   uint16_t        m_port;             //!< Local controller tcp port.
+  uint32_t        m_maxBatchSize;     //!< Bytes of a batch write.
   Ptr<Socket>     m_serverSocket;     //!< Listening server socket.
 
   EchoMsgMap_t    m_echoMap;          //!< Metadata for echo requests.
   BarrierMsgMap_t m_barrierMap;       //!< Metadata for barrier requests.
   DpIdCmdMap_t    m_schedCommands;    //!< Scheduled commands for execution.
   SwitchsMap_t    m_switchesMap;      //!< Registered switches metadata's.
+
+  /** Trace source fired when a barrier reply is received. */
+  TracedCallback<uint64_t, Time> m_barrierTrace;
 };
 
 } // namespace ns3
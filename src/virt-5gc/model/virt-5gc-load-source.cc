@@ -0,0 +1,307 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include "ns3/log.h"
+#include "ns3/abort.h"
+#include "ns3/double.h"
+#include "ns3/string.h"
+
+#include "virt-5gc-load-source.h"
+
+namespace ns3 {
+
+	NS_LOG_COMPONENT_DEFINE("Virt5gcLoadSource");
+
+	static const char LOAD_TRACE_MAGIC[8] = {'V', '5', 'G', 'L', 'O', 'A', 'D', '1'};
+
+	NS_OBJECT_ENSURE_REGISTERED (Virt5gcLoadSource);
+
+	TypeId Virt5gcLoadSource::GetTypeId (void)
+	{
+		static TypeId tid = TypeId("ns3::Virt5gcLoadSource")
+			.SetParent<Object> ()
+			.SetGroupName("Virt5gc");
+		return tid;
+	}
+
+	Virt5gcLoadSource::Virt5gcLoadSource ()
+	{
+	}
+
+	Virt5gcLoadSource::~Virt5gcLoadSource ()
+	{
+	}
+
+	int64_t
+	Virt5gcLoadSource::AssignStreams (int64_t stream)
+	{
+		return 0;
+	}
+
+
+	NS_OBJECT_ENSURE_REGISTERED (Virt5gcRandomLoadSource);
+
+	TypeId Virt5gcRandomLoadSource::GetTypeId (void)
+	{
+		static TypeId tid = TypeId("ns3::Virt5gcRandomLoadSource")
+			.SetParent<Virt5gcLoadSource> ()
+			.SetGroupName("Virt5gc")
+			.AddConstructor<Virt5gcRandomLoadSource> ()
+			.AddAttribute ("Std",
+					"Standard deviation of the load change at each tick",
+					DoubleValue (10.0),
+					MakeDoubleAccessor (&Virt5gcRandomLoadSource::m_std),
+					MakeDoubleChecker<double> (0.0));
+		return tid;
+	}
+
+	Virt5gcRandomLoadSource::Virt5gcRandomLoadSource ()
+	{
+		m_normal = CreateObject<NormalRandomVariable> ();
+	}
+
+	Virt5gcRandomLoadSource::~Virt5gcRandomLoadSource ()
+	{
+	}
+
+	int64_t
+	Virt5gcRandomLoadSource::AssignStreams (int64_t stream)
+	{
+		m_normal->SetStream(stream);
+		return 1;
+	}
+
+	int
+	Virt5gcRandomLoadSource::Draw (int load)
+	{
+		if (m_std <= 0)
+			return load;
+
+		// a load never goes negative
+		double sample;
+		do {
+			sample = load + m_std * m_normal->GetValue(0.0, 1.0);
+		} while (sample < 0);
+		return sample;
+	}
+
+	void
+	Virt5gcRandomLoadSource::Update (Time now, int nodeId, int &cpuLoad, int &memLoad, int &diskLoad)
+	{
+		cpuLoad = Draw(cpuLoad);
+		memLoad = Draw(memLoad);
+		diskLoad = Draw(diskLoad);
+	}
+
+
+	NS_OBJECT_ENSURE_REGISTERED (Virt5gcTraceLoadSource);
+
+	TypeId Virt5gcTraceLoadSource::GetTypeId (void)
+	{
+		static TypeId tid = TypeId("ns3::Virt5gcTraceLoadSource")
+			.SetParent<Virt5gcLoadSource> ()
+			.SetGroupName("Virt5gc")
+			.AddConstructor<Virt5gcTraceLoadSource> ()
+			.AddAttribute ("FileName",
+					"CSV or binary load trace to replay",
+					StringValue (""),
+					MakeStringAccessor (&Virt5gcTraceLoadSource::SetFileName,
+						&Virt5gcTraceLoadSource::GetFileName),
+					MakeStringChecker ());
+		return tid;
+	}
+
+	Virt5gcTraceLoadSource::Virt5gcTraceLoadSource ()
+		: m_fd (-1),
+		  m_data (0),
+		  m_size (0),
+		  m_offset (0),
+		  m_binary (false),
+		  m_pending (false),
+		  m_lastTime (0)
+	{
+	}
+
+	Virt5gcTraceLoadSource::~Virt5gcTraceLoadSource ()
+	{
+		Close();
+	}
+
+	void
+	Virt5gcTraceLoadSource::DoDispose (void)
+	{
+		Close();
+		m_loads.clear();
+		Virt5gcLoadSource::DoDispose();
+	}
+
+	void
+	Virt5gcTraceLoadSource::SetFileName (std::string fileName)
+	{
+		Close();
+		m_fileName = fileName;
+		m_loads.clear();
+	}
+
+	std::string
+	Virt5gcTraceLoadSource::GetFileName (void) const
+	{
+		return m_fileName;
+	}
+
+	void
+	Virt5gcTraceLoadSource::Open (void)
+	{
+		m_offset = 0;
+		m_pending = false;
+		m_lastTime = 0;
+		if (m_fileName.empty())
+			return;
+
+		m_fd = open(m_fileName.c_str(), O_RDONLY);
+		NS_ABORT_MSG_IF(m_fd < 0, "Cannot open the Virt5gc load trace " << m_fileName);
+		struct stat st;
+		NS_ABORT_MSG_IF(fstat(m_fd, &st) != 0, "Cannot stat the Virt5gc load trace " << m_fileName);
+		m_size = st.st_size;
+		if (m_size == 0)
+			return;
+
+		void *data = mmap(0, m_size, PROT_READ, MAP_PRIVATE, m_fd, 0);
+		NS_ABORT_MSG_IF(data == MAP_FAILED, "Cannot map the Virt5gc load trace " << m_fileName);
+		m_data = static_cast<const char *> (data);
+		// the trace is read once, front to back
+		madvise(data, m_size, MADV_SEQUENTIAL);
+
+		m_binary = m_size >= sizeof(LOAD_TRACE_MAGIC) && memcmp(m_data, LOAD_TRACE_MAGIC, sizeof(LOAD_TRACE_MAGIC)) == 0;
+		if (m_binary) {
+			m_offset = sizeof(LOAD_TRACE_MAGIC);
+			NS_ABORT_MSG_IF((m_size - m_offset) % sizeof(Record) != 0, "Truncated Virt5gc load trace " << m_fileName);
+		}
+		NS_LOG_INFO("Replaying " << (m_binary ? "binary" : "CSV") << " load trace " << m_fileName << " (" << m_size << " bytes)");
+	}
+
+	void
+	Virt5gcTraceLoadSource::Close (void)
+	{
+		if (m_data != 0)
+			munmap(const_cast<char *> (m_data), m_size);
+		if (m_fd >= 0)
+			close(m_fd);
+		m_data = 0;
+		m_fd = -1;
+		m_size = 0;
+		m_offset = 0;
+	}
+
+	bool
+	Virt5gcTraceLoadSource::NextRecord (Record &record)
+	{
+		if (m_binary) {
+			if (m_offset + sizeof(Record) > m_size)
+				return false;
+			memcpy(&record, m_data + m_offset, sizeof(Record));
+			m_offset += sizeof(Record);
+			return true;
+		}
+
+		while (m_offset < m_size) {
+			const char *line = m_data + m_offset;
+			const char *end = static_cast<const char *> (memchr(line, '\n', m_size - m_offset));
+			uint64_t len = (end != 0) ? end - line : m_size - m_offset;
+			m_offset += len + 1;
+
+			// the mapping is not null terminated, parse a copy of the line
+			char buf[256];
+			if (len >= sizeof(buf))
+				len = sizeof(buf) - 1;
+			memcpy(buf, line, len);
+			buf[len] = '\0';
+
+			char *p = buf;
+			while (*p == ' ' || *p == '\t')
+				p++;
+			if (*p == '#' || *p == '\0' || *p == '\r')
+				continue;
+
+			for (char *q = p; *q != '\0'; q++)
+				if (*q == ',')
+					*q = ' ';
+			if (sscanf(p, "%lf %d %d %d %d", &record.time, &record.node, &record.cpu, &record.mem, &record.disk) == 5)
+				return true;
+			NS_LOG_WARN("Skipping a malformed load trace line: " << p);
+		}
+		return false;
+	}
+
+	void
+	Virt5gcTraceLoadSource::Advance (Time now)
+	{
+		double t = now.GetSeconds();
+		while (true) {
+			if (!m_pending) {
+				if (!NextRecord(m_next))
+					return;
+				NS_ABORT_MSG_IF(m_next.time < m_lastTime, "Virt5gc load trace " << m_fileName << " is not sorted by time");
+				m_lastTime = m_next.time;
+				m_pending = true;
+			}
+			if (m_next.time > t)
+				return;
+
+			Load &load = m_loads[m_next.node];
+			load.cpu = m_next.cpu;
+			load.mem = m_next.mem;
+			load.disk = m_next.disk;
+			m_pending = false;
+		}
+	}
+
+	void
+	Virt5gcTraceLoadSource::Update (Time now, int nodeId, int &cpuLoad, int &memLoad, int &diskLoad)
+	{
+		// without a trace the loads are left as they are
+		if (m_fileName.empty())
+			return;
+		if (m_fd < 0)
+			Open();
+		Advance(now);
+
+		std::unordered_map<int, Load>::const_iterator it = m_loads.find(nodeId);
+		if (it == m_loads.end())
+			return;
+		cpuLoad = it->second.cpu;
+		memLoad = it->second.mem;
+		diskLoad = it->second.disk;
+	}
+
+	uint64_t
+	Virt5gcTraceLoadSource::ConvertCsv (std::string csvFile, std::string binFile)
+	{
+		Ptr<Virt5gcTraceLoadSource> csv = CreateObject<Virt5gcTraceLoadSource> ();
+		csv->SetFileName(csvFile);
+		csv->Open();
+		NS_ABORT_MSG_IF(csv->m_binary, csvFile << " is not a CSV load trace");
+
+		FILE *out = fopen(binFile.c_str(), "wb");
+		NS_ABORT_MSG_IF(out == 0, "Cannot create " << binFile);
+		fwrite(LOAD_TRACE_MAGIC, sizeof(LOAD_TRACE_MAGIC), 1, out);
+
+		uint64_t n = 0;
+		Record record;
+		while (csv->NextRecord(record)) {
+			fwrite(&record, sizeof(Record), 1, out);
+			n++;
+		}
+		fclose(out);
+		csv->Dispose();
+		return n;
+	}
+
+};
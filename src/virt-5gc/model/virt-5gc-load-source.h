@@ -0,0 +1,111 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+#ifndef VIRT_5GC_LOAD_SOURCE_H
+#define VIRT_5GC_LOAD_SOURCE_H
+
+#include <stdint.h>
+#include <string>
+#include <unordered_map>
+
+#include "ns3/object.h"
+#include "ns3/nstime.h"
+#include "ns3/random-variable-stream.h"
+
+namespace ns3 {
+
+	/* Gives the cpu/memory/disk load of the MME and SGW/PGW nodes at each
+	 * Virt5gc load tick. Loads are in and out: a source that has nothing
+	 * for a node leaves its current load unchanged. */
+	class Virt5gcLoadSource : public Object
+	{
+		public:
+			static TypeId GetTypeId (void);
+			Virt5gcLoadSource ();
+			virtual ~Virt5gcLoadSource ();
+
+			virtual void Update (Time now, int nodeId, int &cpuLoad, int &memLoad, int &diskLoad) = 0;
+			/* Assign fixed random variable stream numbers, return the number of streams used */
+			virtual int64_t AssignStreams (int64_t stream);
+	};
+
+	/* Gaussian random walk around the current load, drawn from ns-3 random
+	 * variable streams so that runs depend only on RngSeed/RngRun */
+	class Virt5gcRandomLoadSource : public Virt5gcLoadSource
+	{
+		public:
+			static TypeId GetTypeId (void);
+			Virt5gcRandomLoadSource ();
+			virtual ~Virt5gcRandomLoadSource ();
+
+			virtual void Update (Time now, int nodeId, int &cpuLoad, int &memLoad, int &diskLoad);
+			virtual int64_t AssignStreams (int64_t stream);
+
+		private:
+			int Draw (int load);
+
+			double m_std;
+			Ptr<NormalRandomVariable> m_normal;
+	};
+
+	/* Replays a recorded load time series, holding the last sample of each
+	 * node until the next one. The file is memory-mapped and read forward
+	 * as the simulation time advances, so only the current load of each
+	 * node is kept in memory. Samples must be sorted by time.
+	 *
+	 * CSV: one "time,node,cpu,mem,disk" line per sample (time in seconds,
+	 * commas or blanks as separators, '#' starts a comment line).
+	 * Binary: the 8 bytes "V5GLOAD1", then Record's in host byte order
+	 * (see ConvertCsv). */
+	class Virt5gcTraceLoadSource : public Virt5gcLoadSource
+	{
+		public:
+			struct Record
+			{
+				double time;
+				int32_t node;
+				int32_t cpu;
+				int32_t mem;
+				int32_t disk;
+			};
+
+			static TypeId GetTypeId (void);
+			Virt5gcTraceLoadSource ();
+			virtual ~Virt5gcTraceLoadSource ();
+
+			void SetFileName (std::string fileName);
+			std::string GetFileName (void) const;
+			virtual void Update (Time now, int nodeId, int &cpuLoad, int &memLoad, int &diskLoad);
+
+			/* Write a CSV trace in the binary format, return the number of samples */
+			static uint64_t ConvertCsv (std::string csvFile, std::string binFile);
+
+		protected:
+			virtual void DoDispose (void);
+
+		private:
+			void Open (void);
+			void Close (void);
+			bool NextRecord (Record &record); // read the sample at the cursor
+			void Advance (Time now);
+
+			struct Load
+			{
+				int cpu;
+				int mem;
+				int disk;
+			};
+
+			std::string m_fileName;
+			int m_fd;
+			const char *m_data;
+			uint64_t m_size;
+			uint64_t m_offset; // cursor in the mapped file
+			bool m_binary;
+			bool m_pending; // m_next was read but is not due yet
+			Record m_next;
+			double m_lastTime;
+			std::unordered_map<int, Load> m_loads; // node ID -> last sample
+	};
+
+};
+
+#endif /* VIRT_5GC_LOAD_SOURCE_H */
@@ -0,0 +1,246 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+
+#include <algorithm>
+
+#include "ns3/log.h"
+#include "ns3/assert.h"
+#include "ns3/boolean.h"
+#include "ns3/integer.h"
+#include "ns3/nstime.h"
+
+#include "virt-5gc-placement.h"
+
+namespace ns3 {
+
+	NS_LOG_COMPONENT_DEFINE("Virt5gcPlacement");
+
+	NS_OBJECT_ENSURE_REGISTERED (Virt5gcPlacement);
+
+	TypeId Virt5gcPlacement::GetTypeId (void)
+	{
+		static TypeId tid = TypeId("ns3::Virt5gcPlacement")
+			.SetParent<Object> ()
+			.SetGroupName("Virt5gc")
+			.AddConstructor<Virt5gcPlacement> ()
+			.AddAttribute ("PmCpu",
+					"Cpu capacity of a PM, in the unit of the VM cpu size",
+					IntegerValue (1000),
+					MakeIntegerAccessor (&Virt5gcPlacement::m_pmCpu),
+					MakeIntegerChecker<int> (1))
+			.AddAttribute ("PmMemory",
+					"Memory capacity of a PM, in the unit of the VM memory size",
+					IntegerValue (4096),
+					MakeIntegerAccessor (&Virt5gcPlacement::m_pmMem),
+					MakeIntegerChecker<int> (1))
+			.AddAttribute ("PmDisk",
+					"Disk capacity of a PM, in the unit of the VM disk size",
+					IntegerValue (20000),
+					MakeIntegerAccessor (&Virt5gcPlacement::m_pmDisk),
+					MakeIntegerChecker<int> (1))
+			.AddAttribute ("IntraRackRate",
+					"Rate of a migration between two PMs of the same rack",
+					DataRateValue (DataRate ("10Gb/s")),
+					MakeDataRateAccessor (&Virt5gcPlacement::m_intraRackRate),
+					MakeDataRateChecker ())
+			.AddAttribute ("InterRackRate",
+					"Rate of a migration between two racks (through the aggregation switches)",
+					DataRateValue (DataRate ("1Gb/s")),
+					MakeDataRateAccessor (&Virt5gcPlacement::m_interRackRate),
+					MakeDataRateChecker ())
+			.AddAttribute ("InterRackDelay",
+					"Time for a packet to go to another rack (through the aggregation switches) and back",
+					TimeValue (MicroSeconds (20)),
+					MakeTimeAccessor (&Virt5gcPlacement::m_interRackDelay),
+					MakeTimeChecker ())
+			.AddAttribute ("Consolidation",
+					"Pack a VM alone on its PM onto another PM on scale-in",
+					BooleanValue (true),
+					MakeBooleanAccessor (&Virt5gcPlacement::m_consolidation),
+					MakeBooleanChecker ());
+		return tid;
+	}
+
+	Virt5gcPlacement::Virt5gcPlacement ()
+		: m_registry (0)
+	{
+	}
+
+	Virt5gcPlacement::~Virt5gcPlacement ()
+	{
+	}
+
+	void
+	Virt5gcPlacement::SetVmRegistry (Virt5gcVmRegistry *registry)
+	{
+		m_registry = registry;
+	}
+
+	void
+	Virt5gcPlacement::AddPm (int pm, int tor)
+	{
+		std::map<int, int>::iterator it = m_pmTor.find(pm);
+		if (it != m_pmTor.end() && it->second != tor)
+			NS_LOG_WARN ("PM " << pm << " is in ToR " << it->second << ", not " << tor);
+		else
+			m_pmTor[pm] = tor;
+	}
+
+	uint32_t
+	Virt5gcPlacement::GetNPms (void) const
+	{
+		return m_pmTor.size();
+	}
+
+	Virt5gcPlacement::PmLoad
+	Virt5gcPlacement::GetPmLoad (int pm) const
+	{
+		NS_ASSERT_MSG(m_registry != 0, "No VM registry");
+		PmLoad load = {0, 0, 0};
+		const std::vector<Virt5gcVmRegistry::Handle> &vms = m_registry->GetPmVms(pm);
+		for (uint32_t i = 0; i < vms.size(); i++) {
+			Virt5gcVm *vm = m_registry->Get(vms[i]);
+			load.cpu += vm->GetCpuInfo().first;
+			load.mem += vm->GetMemInfo().first;
+			load.disk += vm->GetDiskInfo().first;
+		}
+		return load;
+	}
+
+	double
+	Virt5gcPlacement::GetPmUsage (int pm) const
+	{
+		PmLoad load = GetPmLoad(pm);
+		return std::max(std::max(load.cpu / (double)m_pmCpu, load.mem / (double)m_pmMem), load.disk / (double)m_pmDisk);
+	}
+
+	bool
+	Virt5gcPlacement::Fits (const PmLoad &load, const Virt5gcVm &vm) const
+	{
+		return load.cpu + vm.GetCpuInfo().first <= m_pmCpu
+			&& load.mem + vm.GetMemInfo().first <= m_pmMem
+			&& load.disk + vm.GetDiskInfo().first <= m_pmDisk;
+	}
+
+	bool
+	Virt5gcPlacement::FindPm (const Virt5gcVm &vm, const std::map<int, bool> &racks, int skipPm, bool usedOnly, int &tor, int &pm) const
+	{
+		bool found = false;
+		double bestResidual = 0;
+		std::map<int, int>::const_iterator it;
+		for (it = m_pmTor.begin(); it != m_pmTor.end(); it++) {
+			if (it->first == skipPm || (!racks.empty() && racks.find(it->second) == racks.end()))
+				continue;
+			if (usedOnly && m_registry->GetPmVms(it->first).empty())
+				continue;
+			PmLoad load = GetPmLoad(it->first);
+			if (!Fits(load, vm))
+				continue;
+
+			// best fit: the least cpu left once the VM is in
+			double residual = m_pmCpu - load.cpu - vm.GetCpuInfo().first;
+			if (!found || residual < bestResidual) {
+				found = true;
+				bestResidual = residual;
+				pm = it->first;
+				tor = it->second;
+			}
+		}
+		return found;
+	}
+
+	bool
+	Virt5gcPlacement::PlaceVm (const Virt5gcVm &vm, const std::list<Virt5gcVm*> &nodeVms, int &tor, int &pm)
+	{
+		NS_ASSERT_MSG(!nodeVms.empty(), "A node has at least one VM");
+		std::map<int, bool> racks;
+		std::list<Virt5gcVm*>::const_iterator itor;
+		for (itor = nodeVms.begin(); itor != nodeVms.end(); itor++)
+			racks[(**itor).GetToRId()] = true;
+
+		if (FindPm(vm, racks, -1, false, tor, pm)) {
+			NS_LOG_LOGIC ("VM " << vm.GetVmId() << " placed in a rack of its node, PM " << pm);
+			return true;
+		}
+		racks.clear();
+		if (FindPm(vm, racks, -1, false, tor, pm)) {
+			NS_LOG_LOGIC ("VM " << vm.GetVmId() << " placed in a remote rack, PM " << pm << " ToR " << tor);
+			return true;
+		}
+
+		NS_LOG_WARN ("No PM has room for VM " << vm.GetVmId() << ", oversubscribing PM " << nodeVms.front()->GetPmId());
+		tor = nodeVms.front()->GetToRId();
+		pm = nodeVms.front()->GetPmId();
+		return false;
+	}
+
+	Virt5gcVm*
+	Virt5gcPlacement::SelectScaleInVm (const std::list<Virt5gcVm*> &nodeVms)
+	{
+		NS_ASSERT_MSG(!nodeVms.empty(), "A node has at least one VM");
+		// removing the VM of the least used PM is the most likely to free a PM
+		Virt5gcVm *victim = nodeVms.back();
+		double lowest = GetPmUsage(victim->GetPmId());
+		std::list<Virt5gcVm*>::const_reverse_iterator itor;
+		for (itor = nodeVms.rbegin(); itor != nodeVms.rend(); itor++) {
+			double usage = GetPmUsage((**itor).GetPmId());
+			if (usage < lowest) {
+				lowest = usage;
+				victim = *itor;
+			}
+		}
+		return victim;
+	}
+
+	Virt5gcVm*
+	Virt5gcPlacement::SelectConsolidation (const std::list<Virt5gcVm*> &nodeVms, int &tor, int &pm)
+	{
+		if (!m_consolidation)
+			return 0;
+
+		Virt5gcVm *best = 0;
+		double lowest = 0;
+		std::list<Virt5gcVm*>::const_iterator itor;
+		for (itor = nodeVms.begin(); itor != nodeVms.end(); itor++) {
+			int vmPm = (**itor).GetPmId();
+			if (m_registry->GetPmVms(vmPm).size() != 1)
+				continue;
+
+			// prefer another PM of the same rack
+			std::map<int, bool> racks;
+			racks[(**itor).GetToRId()] = true;
+			int candTor, candPm;
+			if (!FindPm(**itor, racks, vmPm, true, candTor, candPm)) {
+				racks.clear();
+				if (!FindPm(**itor, racks, vmPm, true, candTor, candPm))
+					continue;
+			}
+			double usage = GetPmUsage(vmPm);
+			if (best == 0 || usage < lowest) {
+				best = *itor;
+				lowest = usage;
+				tor = candTor;
+				pm = candPm;
+			}
+		}
+		return best;
+	}
+
+	DataRate
+	Virt5gcPlacement::GetLinkRate (int srcTor, int dstTor) const
+	{
+		return srcTor == dstTor ? m_intraRackRate : m_interRackRate;
+	}
+
+	double
+	Virt5gcPlacement::GetRackFactor (int srcTor, int dstTor) const
+	{
+		return GetLinkRate(srcTor, dstTor).GetBitRate() / (double)m_intraRackRate.GetBitRate();
+	}
+
+	Time
+	Virt5gcPlacement::GetForwardingDelay (int srcTor, int dstTor) const
+	{
+		return srcTor == dstTor ? Seconds(0) : m_interRackDelay;
+	}
+
+};
@@ -0,0 +1,78 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+#ifndef VIRT_5GC_PLACEMENT_H
+#define VIRT_5GC_PLACEMENT_H
+
+#include <list>
+#include <map>
+
+#include "ns3/object.h"
+#include "ns3/data-rate.h"
+#include "ns3/nstime.h"
+
+#include "virt-5gc-vm.h"
+#include "virt-5gc-vm-registry.h"
+
+namespace ns3 {
+
+	/* Places the VMs of the virtualized core on the PMs of the data center.
+	 * All PMs have the same cpu/memory/disk capacity, and the residual
+	 * capacity of a PM is what its VMs do not reserve (VM sizes, not loads).
+	 * A new VM goes to the best-fitting PM of a rack already hosting the
+	 * node, then of any rack. On scale-in the VM on the least used PM
+	 * leaves, and a VM alone on its PM may be packed onto another PM so
+	 * that the PM can be switched off. */
+	class Virt5gcPlacement : public Object
+	{
+		public:
+			static TypeId GetTypeId (void);
+			Virt5gcPlacement ();
+			virtual ~Virt5gcPlacement ();
+
+			void SetVmRegistry (Virt5gcVmRegistry *registry);
+			void AddPm (int pm, int tor); // register a PM and its rack
+
+			/* Pick the ToR/PM of a new VM of a node. Returns false (and the PM
+			 * of the first VM of the node) if no PM has room for it. */
+			bool PlaceVm (const Virt5gcVm &vm, const std::list<Virt5gcVm*> &nodeVms, int &tor, int &pm);
+			/* Pick the VM of a node to remove on scale-in */
+			Virt5gcVm* SelectScaleInVm (const std::list<Virt5gcVm*> &nodeVms);
+			/* Find a VM of the node alone on its PM that fits on another used
+			 * PM. Returns 0 if there is none or consolidation is disabled. */
+			Virt5gcVm* SelectConsolidation (const std::list<Virt5gcVm*> &nodeVms, int &tor, int &pm);
+
+			DataRate GetLinkRate (int srcTor, int dstTor) const;
+			/* Link rate between two racks relative to the rate inside a rack */
+			double GetRackFactor (int srcTor, int dstTor) const;
+			/* Time for a packet to go from one rack to the other and back */
+			Time GetForwardingDelay (int srcTor, int dstTor) const;
+			double GetPmUsage (int pm) const; // reserved share of the most used resource
+			uint32_t GetNPms (void) const;
+
+		private:
+			struct PmLoad
+			{
+				int cpu;
+				int mem;
+				int disk;
+			};
+
+			PmLoad GetPmLoad (int pm) const;
+			bool Fits (const PmLoad &load, const Virt5gcVm &vm) const;
+			/* Best-fitting PM for vm, in racks (all racks if empty), excluding
+			 * skipPm; usedOnly restricts the search to PMs hosting VMs */
+			bool FindPm (const Virt5gcVm &vm, const std::map<int, bool> &racks, int skipPm, bool usedOnly, int &tor, int &pm) const;
+
+			Virt5gcVmRegistry *m_registry;
+			std::map<int, int> m_pmTor; // PM ID -> ToR ID
+			int m_pmCpu;
+			int m_pmMem;
+			int m_pmDisk;
+			DataRate m_intraRackRate;
+			DataRate m_interRackRate;
+			Time m_interRackDelay;
+			bool m_consolidation;
+	};
+
+};
+
+#endif /* VIRT_5GC_PLACEMENT_H */
@@ -0,0 +1,251 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+
+#include <limits>
+
+#include "ns3/log.h"
+#include "ns3/double.h"
+
+#include "virt-5gc-scaling-policy.h"
+
+namespace ns3 {
+
+	NS_LOG_COMPONENT_DEFINE("Virt5gcScalingPolicy");
+
+	Virt5gcScalingInput::Virt5gcScalingInput ()
+		: nodeId (0),
+		  component (0),
+		  vmCount (0),
+		  cpuInfo (0, 0),
+		  memInfo (0, 0),
+		  diskInfo (0, 0),
+		  queueSamples (0)
+	{
+	}
+
+	NS_OBJECT_ENSURE_REGISTERED (Virt5gcScalingPolicy);
+
+	TypeId Virt5gcScalingPolicy::GetTypeId (void)
+	{
+		static TypeId tid = TypeId("ns3::Virt5gcScalingPolicy")
+			.SetParent<Object> ()
+			.SetGroupName("Virt5gc");
+		return tid;
+	}
+
+	Virt5gcScalingPolicy::Virt5gcScalingPolicy ()
+	{
+	}
+
+	Virt5gcScalingPolicy::~Virt5gcScalingPolicy ()
+	{
+	}
+
+	void
+	Virt5gcScalingPolicy::NotifyScaled (int nodeId, Decision decision, Time now)
+	{
+	}
+
+	double
+	Virt5gcScalingPolicy::GetUtilization (std::pair<int, int> info)
+	{
+		if (info.first <= 0)
+			return info.second > 0 ? std::numeric_limits<double>::infinity() : 0.0;
+		return info.second / (double)info.first;
+	}
+
+
+	NS_OBJECT_ENSURE_REGISTERED (Virt5gcThresholdScalingPolicy);
+
+	TypeId Virt5gcThresholdScalingPolicy::GetTypeId (void)
+	{
+		static TypeId tid = TypeId("ns3::Virt5gcThresholdScalingPolicy")
+			.SetParent<Virt5gcScalingPolicy> ()
+			.SetGroupName("Virt5gc")
+			.AddConstructor<Virt5gcThresholdScalingPolicy> ()
+			.AddAttribute ("ScaleOutThreshold",
+					"Utilization of any resource above which a node is scaled out",
+					DoubleValue (1.0),
+					MakeDoubleAccessor (&Virt5gcThresholdScalingPolicy::m_scaleOutThreshold),
+					MakeDoubleChecker<double> (0.0))
+			.AddAttribute ("ScaleInThreshold",
+					"Utilization that all resources must stay under with one VM less to scale a node in",
+					DoubleValue (1.0),
+					MakeDoubleAccessor (&Virt5gcThresholdScalingPolicy::m_scaleInThreshold),
+					MakeDoubleChecker<double> (0.0))
+			.AddAttribute ("Cooldown",
+					"Time after a scaling event during which the node is not scaled again",
+					TimeValue (Seconds (0)),
+					MakeTimeAccessor (&Virt5gcThresholdScalingPolicy::m_cooldown),
+					MakeTimeChecker ());
+		return tid;
+	}
+
+	Virt5gcThresholdScalingPolicy::Virt5gcThresholdScalingPolicy ()
+	{
+	}
+
+	Virt5gcThresholdScalingPolicy::~Virt5gcThresholdScalingPolicy ()
+	{
+	}
+
+	Virt5gcScalingPolicy::Decision
+	Virt5gcThresholdScalingPolicy::Decide (const Virt5gcScalingInput &input)
+	{
+		std::pair<int, int> info[3] = {input.cpuInfo, input.memInfo, input.diskInfo};
+		bool out = false;
+		bool in = input.vmCount > 1;
+
+		// estimate every resource, so that stateful estimators see each tick
+		for (int r = 0; r < 3; r++) {
+			double util = EstimateUtilization(input, r, GetUtilization(info[r]));
+			if (util > m_scaleOutThreshold)
+				out = true;
+			// the load of the node spread over one VM less
+			if (input.vmCount <= 1 || util * input.vmCount / (input.vmCount - 1) > m_scaleInThreshold)
+				in = false;
+		}
+
+		if (InCooldown(input.nodeId, input.now))
+			return NONE;
+		if (out)
+			return SCALE_OUT;
+		if (in)
+			return SCALE_IN;
+		return NONE;
+	}
+
+	void
+	Virt5gcThresholdScalingPolicy::NotifyScaled (int nodeId, Decision decision, Time now)
+	{
+		if (decision != NONE)
+			m_lastScaling[nodeId] = now;
+	}
+
+	bool
+	Virt5gcThresholdScalingPolicy::InCooldown (int nodeId, Time now) const
+	{
+		std::map<int, Time>::const_iterator it = m_lastScaling.find(nodeId);
+		return it != m_lastScaling.end() && now - it->second < m_cooldown;
+	}
+
+	double
+	Virt5gcThresholdScalingPolicy::EstimateUtilization (const Virt5gcScalingInput &input, int resource, double utilization)
+	{
+		return utilization;
+	}
+
+
+	NS_OBJECT_ENSURE_REGISTERED (Virt5gcEwmaScalingPolicy);
+
+	TypeId Virt5gcEwmaScalingPolicy::GetTypeId (void)
+	{
+		static TypeId tid = TypeId("ns3::Virt5gcEwmaScalingPolicy")
+			.SetParent<Virt5gcThresholdScalingPolicy> ()
+			.SetGroupName("Virt5gc")
+			.AddConstructor<Virt5gcEwmaScalingPolicy> ()
+			.AddAttribute ("Alpha",
+					"Smoothing factor of the utilization level",
+					DoubleValue (0.5),
+					MakeDoubleAccessor (&Virt5gcEwmaScalingPolicy::m_alpha),
+					MakeDoubleChecker<double> (0.0, 1.0))
+			.AddAttribute ("Beta",
+					"Smoothing factor of the utilization trend",
+					DoubleValue (0.3),
+					MakeDoubleAccessor (&Virt5gcEwmaScalingPolicy::m_beta),
+					MakeDoubleChecker<double> (0.0, 1.0))
+			.AddAttribute ("Horizon",
+					"How far ahead the utilization is forecast",
+					TimeValue (Seconds (2)),
+					MakeTimeAccessor (&Virt5gcEwmaScalingPolicy::m_horizon),
+					MakeTimeChecker ());
+		return tid;
+	}
+
+	Virt5gcEwmaScalingPolicy::Virt5gcEwmaScalingPolicy ()
+		: m_steps (0)
+	{
+	}
+
+	Virt5gcEwmaScalingPolicy::~Virt5gcEwmaScalingPolicy ()
+	{
+	}
+
+	Virt5gcScalingPolicy::Decision
+	Virt5gcEwmaScalingPolicy::Decide (const Virt5gcScalingInput &input)
+	{
+		Estimate &est = m_estimates[input.nodeId];
+		m_steps = 0;
+		if (est.init && input.now > est.last)
+			m_steps = m_horizon.GetSeconds() / (input.now - est.last).GetSeconds();
+
+		Decision decision = Virt5gcThresholdScalingPolicy::Decide(input);
+		est.last = input.now;
+		est.init = true;
+		return decision;
+	}
+
+	double
+	Virt5gcEwmaScalingPolicy::EstimateUtilization (const Virt5gcScalingInput &input, int resource, double utilization)
+	{
+		Estimate &est = m_estimates[input.nodeId];
+		if (!est.init) {
+			est.level[resource] = utilization;
+			est.trend[resource] = 0;
+			return utilization;
+		}
+
+		double level = m_alpha * utilization + (1 - m_alpha) * (est.level[resource] + est.trend[resource]);
+		est.trend[resource] = m_beta * (level - est.level[resource]) + (1 - m_beta) * est.trend[resource];
+		est.level[resource] = level;
+
+		double forecast = level + m_steps * est.trend[resource];
+		NS_LOG_LOGIC("node " << input.nodeId << " resource " << resource << " utilization " << utilization << " forecast " << forecast);
+		return forecast > 0 ? forecast : 0;
+	}
+
+
+	NS_OBJECT_ENSURE_REGISTERED (Virt5gcQueueDelayScalingPolicy);
+
+	TypeId Virt5gcQueueDelayScalingPolicy::GetTypeId (void)
+	{
+		static TypeId tid = TypeId("ns3::Virt5gcQueueDelayScalingPolicy")
+			.SetParent<Virt5gcThresholdScalingPolicy> ()
+			.SetGroupName("Virt5gc")
+			.AddConstructor<Virt5gcQueueDelayScalingPolicy> ()
+			.AddAttribute ("ScaleOutDelay",
+					"Mean queueing delay of the PGW instances above which the SGW/PGW is scaled out",
+					TimeValue (MilliSeconds (10)),
+					MakeTimeAccessor (&Virt5gcQueueDelayScalingPolicy::m_scaleOutDelay),
+					MakeTimeChecker ())
+			.AddAttribute ("ScaleInDelay",
+					"Mean queueing delay of the PGW instances under which the SGW/PGW is scaled in",
+					TimeValue (MilliSeconds (1)),
+					MakeTimeAccessor (&Virt5gcQueueDelayScalingPolicy::m_scaleInDelay),
+					MakeTimeChecker ());
+		return tid;
+	}
+
+	Virt5gcQueueDelayScalingPolicy::Virt5gcQueueDelayScalingPolicy ()
+	{
+	}
+
+	Virt5gcQueueDelayScalingPolicy::~Virt5gcQueueDelayScalingPolicy ()
+	{
+	}
+
+	Virt5gcScalingPolicy::Decision
+	Virt5gcQueueDelayScalingPolicy::Decide (const Virt5gcScalingInput &input)
+	{
+		if (input.component != 1 || input.queueSamples == 0)
+			return Virt5gcThresholdScalingPolicy::Decide(input);
+
+		if (InCooldown(input.nodeId, input.now))
+			return NONE;
+		if (input.queueDelay > m_scaleOutDelay)
+			return SCALE_OUT;
+		if (input.queueDelay < m_scaleInDelay && input.vmCount > 1)
+			return SCALE_IN;
+		return NONE;
+	}
+
+};
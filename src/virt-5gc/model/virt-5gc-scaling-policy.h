@@ -0,0 +1,130 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+#ifndef VIRT_5GC_SCALING_POLICY_H
+#define VIRT_5GC_SCALING_POLICY_H
+
+#include <map>
+#include <utility>
+
+#include "ns3/object.h"
+#include "ns3/nstime.h"
+
+namespace ns3 {
+
+	/* What a scaling policy sees of a MME or SGW/PGW node at a scaling tick.
+	 * Resources are (capacity, load) pairs summed over the VMs of the node. */
+	struct Virt5gcScalingInput
+	{
+		Virt5gcScalingInput ();
+
+		Time now;
+		int nodeId;
+		int component; // 0: MME, 1: SGW/PGW
+		int vmCount;
+		std::pair<int, int> cpuInfo;
+		std::pair<int, int> memInfo;
+		std::pair<int, int> diskInfo;
+		uint32_t queueSamples; // packets processed by the node's PGW instances since the last tick
+		Time queueDelay; // mean sojourn time of those packets
+	};
+
+	class Virt5gcScalingPolicy : public Object
+	{
+		public:
+			enum Decision
+			{
+				NONE = 0,
+				SCALE_OUT = 1,
+				SCALE_IN = 2
+			};
+
+			static TypeId GetTypeId (void);
+			Virt5gcScalingPolicy ();
+			virtual ~Virt5gcScalingPolicy ();
+
+			/* Decide what to do with a node. A node with a single VM is never scaled in. */
+			virtual Decision Decide (const Virt5gcScalingInput &input) = 0;
+			/* Tell the policy that a decision was carried out on a node */
+			virtual void NotifyScaled (int nodeId, Decision decision, Time now);
+
+			/* load / capacity of a (capacity, load) pair, 1.0 is full */
+			static double GetUtilization (std::pair<int, int> info);
+	};
+
+	/* Scale out when a resource goes over ScaleOutThreshold, scale in when
+	 * all resources would stay under ScaleInThreshold with one VM less.
+	 * Nothing is done on a node for Cooldown after it was scaled.
+	 * The defaults (1.0, 1.0, 0s) are the original Virt5gc rule. */
+	class Virt5gcThresholdScalingPolicy : public Virt5gcScalingPolicy
+	{
+		public:
+			static TypeId GetTypeId (void);
+			Virt5gcThresholdScalingPolicy ();
+			virtual ~Virt5gcThresholdScalingPolicy ();
+
+			virtual Decision Decide (const Virt5gcScalingInput &input);
+			virtual void NotifyScaled (int nodeId, Decision decision, Time now);
+
+		protected:
+			bool InCooldown (int nodeId, Time now) const;
+			/* Utilization the thresholds are compared with. resource is 0 (cpu), 1 (mem) or 2 (disk) */
+			virtual double EstimateUtilization (const Virt5gcScalingInput &input, int resource, double utilization);
+
+			double m_scaleOutThreshold;
+			double m_scaleInThreshold;
+			Time m_cooldown;
+
+		private:
+			std::map<int, Time> m_lastScaling; // node ID -> time of the last scaling
+	};
+
+	/* Threshold policy on a Holt (level + trend) EWMA forecast of the
+	 * utilization, Horizon ahead of the current tick */
+	class Virt5gcEwmaScalingPolicy : public Virt5gcThresholdScalingPolicy
+	{
+		public:
+			static TypeId GetTypeId (void);
+			Virt5gcEwmaScalingPolicy ();
+			virtual ~Virt5gcEwmaScalingPolicy ();
+
+			virtual Decision Decide (const Virt5gcScalingInput &input);
+
+		protected:
+			virtual double EstimateUtilization (const Virt5gcScalingInput &input, int resource, double utilization);
+
+		private:
+			struct Estimate
+			{
+				Estimate () : init (false) {}
+				double level[3];
+				double trend[3];
+				Time last;
+				bool init;
+			};
+
+			double m_alpha;
+			double m_beta;
+			Time m_horizon;
+			std::map<int, Estimate> m_estimates; // node ID -> forecast state
+			double m_steps; // number of ticks to Horizon, for the current decision
+	};
+
+	/* Scale the SGW/PGW on the queueing delay of its PGW instances:
+	 * out above ScaleOutDelay, in below ScaleInDelay. Nodes without
+	 * queue samples (MME, idle PGW) fall back to the threshold rule. */
+	class Virt5gcQueueDelayScalingPolicy : public Virt5gcThresholdScalingPolicy
+	{
+		public:
+			static TypeId GetTypeId (void);
+			Virt5gcQueueDelayScalingPolicy ();
+			virtual ~Virt5gcQueueDelayScalingPolicy ();
+
+			virtual Decision Decide (const Virt5gcScalingInput &input);
+
+		private:
+			Time m_scaleOutDelay;
+			Time m_scaleInDelay;
+	};
+
+};
+
+#endif /* VIRT_5GC_SCALING_POLICY_H */
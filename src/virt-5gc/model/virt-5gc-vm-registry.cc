@@ -0,0 +1,180 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+
+#include "ns3/log.h"
+#include "ns3/assert.h"
+
+#include "virt-5gc-vm-registry.h"
+
+namespace ns3 {
+
+	NS_LOG_COMPONENT_DEFINE("Virt5gcVmRegistry");
+
+	Virt5gcVmRegistry::Virt5gcVmRegistry()
+	{
+		m_n = 0;
+		m_maxVmId = 0;
+	}
+
+	Virt5gcVmRegistry::Handle
+	Virt5gcVmRegistry::Add (const Virt5gcVm &vm)
+	{
+		int vmId = vm.GetVmId();
+		NS_ASSERT_MSG(m_byId.find(vmId) == m_byId.end(), "VM " << vmId << " already registered");
+
+		Handle handle;
+		if (!m_freeSlots.empty()) {
+			handle = m_freeSlots.back();
+			m_freeSlots.pop_back();
+			m_vms[handle] = vm;
+			m_valid[handle] = true;
+		}
+		else {
+			handle = m_vms.size();
+			m_vms.push_back(vm);
+			m_valid.push_back(true);
+		}
+
+		m_byId[vmId] = handle;
+		IndexAdd(m_byToR, vm.GetToRId(), handle);
+		IndexAdd(m_byPm, vm.GetPmId(), handle);
+		if (m_n == 0 || vmId > m_maxVmId)
+			m_maxVmId = vmId;
+		m_n++;
+		NS_LOG_LOGIC("VM " << vmId << " registered in slot " << handle);
+		return handle;
+	}
+
+	void
+	Virt5gcVmRegistry::Remove (Handle handle)
+	{
+		NS_ASSERT_MSG(IsValid(handle), "Invalid VM handle " << handle);
+		Virt5gcVm &vm = m_vms[handle];
+		m_byId.erase(vm.GetVmId());
+		IndexRemove(m_byToR, vm.GetToRId(), handle);
+		IndexRemove(m_byPm, vm.GetPmId(), handle);
+		m_valid[handle] = false;
+		m_freeSlots.push_back(handle);
+		m_n--;
+	}
+
+	Virt5gcVmRegistry::Handle
+	Virt5gcVmRegistry::Lookup (int vmId) const
+	{
+		std::unordered_map<int, Handle>::const_iterator itor = m_byId.find(vmId);
+		if (itor == m_byId.end())
+			return INVALID_HANDLE;
+		return itor->second;
+	}
+
+	Virt5gcVm*
+	Virt5gcVmRegistry::Get (Handle handle)
+	{
+		NS_ASSERT_MSG(IsValid(handle), "Invalid VM handle " << handle);
+		return &m_vms[handle];
+	}
+
+	Virt5gcVm*
+	Virt5gcVmRegistry::Find (int vmId)
+	{
+		Handle handle = Lookup(vmId);
+		if (handle == INVALID_HANDLE)
+			return 0;
+		return &m_vms[handle];
+	}
+
+	bool
+	Virt5gcVmRegistry::IsValid (Handle handle) const
+	{
+		return handle < m_vms.size() && m_valid[handle];
+	}
+
+	void
+	Virt5gcVmRegistry::ChangeToR (Handle handle, int tor)
+	{
+		Virt5gcVm *vm = Get(handle);
+		IndexRemove(m_byToR, vm->GetToRId(), handle);
+		vm->ChangeToR(tor);
+		IndexAdd(m_byToR, tor, handle);
+	}
+
+	void
+	Virt5gcVmRegistry::ChangePm (Handle handle, int pm)
+	{
+		Virt5gcVm *vm = Get(handle);
+		IndexRemove(m_byPm, vm->GetPmId(), handle);
+		vm->ChangePm(pm);
+		IndexAdd(m_byPm, pm, handle);
+	}
+
+	const std::vector<Virt5gcVmRegistry::Handle>&
+	Virt5gcVmRegistry::GetToRVms (int tor) const
+	{
+		static const std::vector<Handle> empty;
+		std::unordered_map<int, std::vector<Handle> >::const_iterator itor = m_byToR.find(tor);
+		return itor == m_byToR.end() ? empty : itor->second;
+	}
+
+	const std::vector<Virt5gcVmRegistry::Handle>&
+	Virt5gcVmRegistry::GetPmVms (int pm) const
+	{
+		static const std::vector<Handle> empty;
+		std::unordered_map<int, std::vector<Handle> >::const_iterator itor = m_byPm.find(pm);
+		return itor == m_byPm.end() ? empty : itor->second;
+	}
+
+	uint32_t
+	Virt5gcVmRegistry::GetN (void) const
+	{
+		return m_n;
+	}
+
+	uint32_t
+	Virt5gcVmRegistry::GetNSlots (void) const
+	{
+		return m_vms.size();
+	}
+
+	int
+	Virt5gcVmRegistry::GetMaxVmId (void) const
+	{
+		return m_maxVmId;
+	}
+
+	void
+	Virt5gcVmRegistry::Clear (void)
+	{
+		m_vms.clear();
+		m_valid.clear();
+		m_freeSlots.clear();
+		m_byId.clear();
+		m_byToR.clear();
+		m_byPm.clear();
+		m_n = 0;
+		m_maxVmId = 0;
+	}
+
+	void
+	Virt5gcVmRegistry::IndexAdd (std::unordered_map<int, std::vector<Handle> > &index, int key, Handle handle)
+	{
+		index[key].push_back(handle);
+	}
+
+	/* swap-remove: the order of the VMs in a rack is not preserved */
+	void
+	Virt5gcVmRegistry::IndexRemove (std::unordered_map<int, std::vector<Handle> > &index, int key, Handle handle)
+	{
+		std::unordered_map<int, std::vector<Handle> >::iterator itor = index.find(key);
+		if (itor == index.end())
+			return;
+		std::vector<Handle> &handles = itor->second;
+		for (uint32_t i = 0; i < handles.size(); i++) {
+			if (handles[i] == handle) {
+				handles[i] = handles.back();
+				handles.pop_back();
+				break;
+			}
+		}
+		if (handles.empty())
+			index.erase(itor);
+	}
+}
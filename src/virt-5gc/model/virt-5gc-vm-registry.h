@@ -0,0 +1,58 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+#ifndef VIRT_5GC_VM_REGISTRY_H
+#define VIRT_5GC_VM_REGISTRY_H
+
+#include <stdint.h>
+#include <vector>
+#include <unordered_map>
+
+#include "virt-5gc-vm.h"
+
+namespace ns3 {
+
+	/* Contiguous store of the VMs of the virtualized core, indexed by VM ID
+	 * and by ToR/PM. A VM keeps the same handle (slot) for its whole life,
+	 * and the slot of a removed VM is reused by a later one. Pointers
+	 * returned by Get/Find stay valid until the next Add.
+	 * ToR/PM changes must go through the registry to keep the indexes valid. */
+	class Virt5gcVmRegistry
+	{
+		public:
+			typedef uint32_t Handle;
+			static const Handle INVALID_HANDLE = 0xffffffff;
+
+			Virt5gcVmRegistry ();
+
+			Handle Add (const Virt5gcVm &vm);
+			void Remove (Handle handle);
+			Handle Lookup (int vmId) const; // INVALID_HANDLE if unknown
+			Virt5gcVm* Get (Handle handle);
+			Virt5gcVm* Find (int vmId); // 0 if unknown
+			bool IsValid (Handle handle) const;
+
+			void ChangeToR (Handle handle, int tor);
+			void ChangePm (Handle handle, int pm);
+			const std::vector<Handle>& GetToRVms (int tor) const;
+			const std::vector<Handle>& GetPmVms (int pm) const;
+
+			uint32_t GetN (void) const;
+			uint32_t GetNSlots (void) const; // handles are in [0, GetNSlots ())
+			int GetMaxVmId (void) const; // largest VM ID ever registered
+			void Clear (void);
+
+		private:
+			void IndexAdd (std::unordered_map<int, std::vector<Handle> > &index, int key, Handle handle);
+			void IndexRemove (std::unordered_map<int, std::vector<Handle> > &index, int key, Handle handle);
+
+			std::vector<Virt5gcVm> m_vms;
+			std::vector<bool> m_valid;
+			std::vector<Handle> m_freeSlots;
+			std::unordered_map<int, Handle> m_byId;
+			std::unordered_map<int, std::vector<Handle> > m_byToR;
+			std::unordered_map<int, std::vector<Handle> > m_byPm;
+			uint32_t m_n;
+			int m_maxVmId;
+	};
+};
+
+#endif
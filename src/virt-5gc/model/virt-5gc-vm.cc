@@ -24,6 +24,11 @@ namespace ns3 {
 		id = vmId;
 		ToR = torId;
 		pm = pmId;
+		node = 0;
+		cpuSize = cpuUtil = 0;
+		memSize = memUtil = 0;
+		diskSize = diskUtil = 0;
+		bwSize = bwUtil = 0;
 		NS_LOG_FUNCTION (this);
 	}
 
@@ -43,7 +48,24 @@ namespace ns3 {
 		bwUtil = oldVm.bwUtil;
 	}
 
-	
+	Virt5gcVm&
+	Virt5gcVm::operator=(const Virt5gcVm& oldVm)
+	{
+		id = oldVm.id;
+		ToR = oldVm.ToR;
+		pm = oldVm.pm;
+		node = oldVm.node;
+		cpuSize = oldVm.cpuSize;
+		cpuUtil = oldVm.cpuUtil;
+		memSize = oldVm.memSize;
+		memUtil = oldVm.memUtil;
+		diskSize = oldVm.diskSize;
+		diskUtil = oldVm.diskUtil;
+		bwSize = oldVm.bwSize;
+		bwUtil = oldVm.bwUtil;
+		return *this;
+	}
+
 	bool
 	Virt5gcVm::operator==(const Virt5gcVm& rhs) const
 	{
@@ -121,52 +143,52 @@ namespace ns3 {
 	}
 
 	int
-	Virt5gcVm::GetVmId (void)
+	Virt5gcVm::GetVmId (void) const
 	{
 		return id;
 	}
 
 	int
-	Virt5gcVm::GetToRId (void)
+	Virt5gcVm::GetToRId (void) const
 	{
 		return ToR;
 	}
 
 	int
-	Virt5gcVm::GetPmId (void)
+	Virt5gcVm::GetPmId (void) const
 	{
 		return pm;
 	}
 
 	int
-	Virt5gcVm::GetNodeId (void)
+	Virt5gcVm::GetNodeId (void) const
 	{
 		return node;
 	}
 
 	std::pair<int, int>
-	Virt5gcVm::GetCpuInfo (void)
+	Virt5gcVm::GetCpuInfo (void) const
 	{
 		std::pair<int, int> info (cpuSize, cpuUtil);
 		return info;
 	}
 	
 	std::pair<int, int>
-	Virt5gcVm::GetMemInfo (void)
+	Virt5gcVm::GetMemInfo (void) const
 	{
 		std::pair<int, int> info (memSize, memUtil);
 		return info;
 	}
 	
 	std::pair<int, int>
-	Virt5gcVm::GetDiskInfo (void)
+	Virt5gcVm::GetDiskInfo (void) const
 	{
 		std::pair<int, int> info (diskSize, diskUtil);
 		return info;
 	}
 
 	std::pair<int, int>
-	Virt5gcVm::GetBwInfo (void)
+	Virt5gcVm::GetBwInfo (void) const
 	{
 		std::pair<int, int> info (bwSize, bwUtil);
 		return info;
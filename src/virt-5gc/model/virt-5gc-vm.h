@@ -11,6 +11,7 @@ namespace ns3 {
 			static TypeId GetTypeId (void);
 			Virt5gcVm (int vmId, int torId, int pmId);
 			Virt5gcVm (const Virt5gcVm&);
+			Virt5gcVm& operator=(const Virt5gcVm&); // copies the VM information only
 			//bool operator<(const Virt5gcVm& rhs) const; 
 			bool operator==(const Virt5gcVm& rhs) const;
 
@@ -28,14 +29,14 @@ namespace ns3 {
 			void ChangeToR (int tor);
 			void ChangePm (int pmId);
 	
-			int GetVmId (void);
-			int GetToRId (void);
-			int GetPmId (void);
-			int GetNodeId (void);
-			std::pair<int, int> GetCpuInfo (void);
-			std::pair<int, int> GetMemInfo (void);
-			std::pair<int, int> GetDiskInfo (void);
-			std::pair<int, int> GetBwInfo (void);
+			int GetVmId (void) const;
+			int GetToRId (void) const;
+			int GetPmId (void) const;
+			int GetNodeId (void) const;
+			std::pair<int, int> GetCpuInfo (void) const;
+			std::pair<int, int> GetMemInfo (void) const;
+			std::pair<int, int> GetDiskInfo (void) const;
+			std::pair<int, int> GetBwInfo (void) const;
 
 
 		private:
@@ -18,7 +18,43 @@ namespace ns3 {
 			.AddTraceSource ("ScalingDelay", 
 					"pass scaling delay", 
 					MakeTraceSourceAccessor (&Virt5gc::m_scalingTrace),
-					"ns3::TracedValueCallback::Uint32");
+					"ns3::TracedValueCallback::Uint32")
+			.AddAttribute ("PgwRatePerCpu",
+					"Packet processing rate of a SGW/PGW instance per unit of VM cpu size",
+					DataRateValue (DataRate ("5Mb/s")),
+					MakeDataRateAccessor (&Virt5gc::pgwRatePerCpu),
+					MakeDataRateChecker ())
+			.AddAttribute ("PgwQueueSize",
+					"Size of the ingress queue of a SGW/PGW instance [packets]",
+					UintegerValue (1000),
+					MakeUintegerAccessor (&Virt5gc::pgwQueueSize),
+					MakeUintegerChecker<uint32_t> ())
+			.AddAttribute ("VmBwUnit",
+					"Rate of one unit of the bandwidth of a VM, used to transfer UE contexts between SGW/PGW VMs",
+					DataRateValue (DataRate ("1Mb/s")),
+					MakeDataRateAccessor (&Virt5gc::vmBwUnit),
+					MakeDataRateChecker ())
+			.AddAttribute ("ScalingPolicy",
+					"The type of policy deciding when MME and SGW/PGW nodes are scaled",
+					StringValue ("ns3::Virt5gcThresholdScalingPolicy"),
+					MakeStringAccessor (&Virt5gc::SetScalingPolicyType,
+						&Virt5gc::GetScalingPolicyType),
+					MakeStringChecker ())
+			.AddAttribute ("LoadSource",
+					"The type of source giving the load of the MME and SGW/PGW nodes",
+					StringValue ("ns3::Virt5gcRandomLoadSource"),
+					MakeStringAccessor (&Virt5gc::SetLoadSourceType,
+						&Virt5gc::GetLoadSourceType),
+					MakeStringChecker ())
+			.AddAttribute ("LoadInterval",
+					"Time between two load updates (and scaling decisions)",
+					TimeValue (Seconds (1.0)),
+					MakeTimeAccessor (&Virt5gc::loadInterval),
+					MakeTimeChecker ())
+			.AddTraceSource ("ScalingDecision",
+					"A scaling policy decided on a node, with the inputs it used",
+					MakeTraceSourceAccessor (&Virt5gc::m_scalingDecisionTrace),
+					"ns3::Virt5gc::ScalingDecisionTracedCallback");
 		return tid;
 	}
 
@@ -43,6 +79,7 @@ namespace ns3 {
 		scaleOutRate = 0;
 		mmeVmN = 0;
 		pgwVmN = 0;
+		pgwTor = -1;
 	}
 
 
@@ -141,21 +178,66 @@ namespace ns3 {
 			lineBuffer >> bUtil;
 			tempVm.SetBwInfo(bSize, bUtil);
 	
-			// Set nodeID
-			std::list<Virt5gcNode>::iterator itor;
-			for (itor = nodeList.begin(); itor != nodeList.end(); itor++) {
-				if ((*itor).FindVm(vmId)) {
-					tempVm.SetNodeId((*itor).GetId());
-
-					(*itor).SetCpuInfo(cSize, cUtil);
-					(*itor).SetMemInfo(mSize, mUtil);
-					(*itor).SetDiskInfo(dSize, dUtil);
-					(*itor).SetBwInfo(bSize, bUtil);
-					break;
-				}
+			AddVm(tempVm);
+		}
+
+		if (!pgwInstances.empty()) {
+			epcHelper->RebalancePgwInstances();
+			ueMoves.clear();
+		}
+	}
+
+	void
+	Virt5gc::AddNode (Virt5gcNode node)
+	{
+		std::list<int> vms = node.GetVms();
+		std::list<int>::iterator itor;
+		for (itor = vms.begin(); itor != vms.end(); itor++)
+			vmNodeIndex[*itor] = nodeList.size();
+		nodeList.push_back(node);
+	}
+
+	void
+	Virt5gc::AddVm (Virt5gcVm vm)
+	{
+		int vmId = vm.GetVmId();
+		std::unordered_map<int, uint32_t>::iterator nodeIt = vmNodeIndex.find(vmId);
+		if (nodeIt != vmNodeIndex.end()) {
+			Virt5gcNode &node = nodeList[nodeIt->second];
+			vm.SetNodeId(node.GetId());
+
+			// a node offers the resources of all its VMs
+			std::pair<int, int> cpu = vm.GetCpuInfo();
+			std::pair<int, int> mem = vm.GetMemInfo();
+			std::pair<int, int> disk = vm.GetDiskInfo();
+			std::pair<int, int> bw = vm.GetBwInfo();
+			node.SetCpuInfo(node.GetCpuInfo().first + cpu.first, node.GetCpuInfo().second + cpu.second);
+			node.SetMemInfo(node.GetMemInfo().first + mem.first, node.GetMemInfo().second + mem.second);
+			node.SetDiskInfo(node.GetDiskInfo().first + disk.first, node.GetDiskInfo().second + disk.second);
+			node.SetBwInfo(node.GetBwInfo().first + bw.first, node.GetBwInfo().second + bw.second);
+
+			if (node.GetComponent() == 0) {
+				mmeVmN++;
 			}
-			vmList.push_back(tempVm);
+			else if (node.GetComponent() == 1) {
+				pgwVmN++;
+				// each VM of the SGW/PGW runs a PGW worker instance
+				if (epcHelper != 0)
+					AddPgwInstance(vmId, cpu.first, vm.GetToRId());
+			}
+		}
+		vmRegistry.Add(vm);
+		GetPlacement()->AddPm(vm.GetPmId(), vm.GetToRId());
+	}
+
+	Ptr<Virt5gcPlacement>
+	Virt5gc::GetPlacement (void)
+	{
+		if (placement == 0) {
+			placement = CreateObject<Virt5gcPlacement> ();
+			placement->SetVmRegistry(&vmRegistry);
 		}
+		return placement;
 	}
 
 	std::string
@@ -199,6 +281,8 @@ namespace ns3 {
 		lteHelper = CreateObject<LteHelper> ();
 		epcHelper = CreateObject<OvsPointToPointEpcHelper> ();
 		lteHelper->SetEpcHelper(epcHelper);
+		epcHelper->GetSgwPgwApplication()->TraceConnectWithoutContext("WorkerDelay", MakeCallback(&Virt5gc::PgwWorkerDelay, this));
+		epcHelper->GetSgwPgwApplication()->TraceConnectWithoutContext("WorkerChange", MakeCallback(&Virt5gc::PgwWorkerChange, this));
 
 		/* Generate Lte components (PGW/SGW, eNB, UE)
 		 * MME is not implemented yet
@@ -232,17 +316,15 @@ namespace ns3 {
 				tmpNode.SetVm(vm);
 			}
 
-			nodeList.push_back(tmpNode);
+			AddNode(tmpNode);
 
 			// categorization
 			if (component == 0) {
 				NS_LOG_INFO ("Create MME Node");
 				mmeN++;
-				mmeVmN++;
 			}
 			else if (component == 1) {
 				pgwN++;
-				pgwVmN++;
 			}
 			else if (component == 2) {
 				Ptr<Node> tmpNode = CreateObject<Node> ();
@@ -293,6 +375,9 @@ namespace ns3 {
 	Virt5gc::DynamicLoadInit (double std)
 	{
 		loadStd = std;
+		// std is the deviation of the default random load source
+		if (loadSource == 0 && loadSourceFactory.GetTypeId() == Virt5gcRandomLoadSource::GetTypeId())
+			loadSourceFactory.Set("Std", DoubleValue(std));
 
 		std::string m_loadFile = "Virt5gc-load.data";
 		AsciiTraceHelper ascii;
@@ -314,13 +399,12 @@ namespace ns3 {
 	void
 	Virt5gc::DynamicLoad (void)
 	{
-		unsigned seed = std::chrono::system_clock::now().time_since_epoch().count();
-		std::default_random_engine generator(seed);
+		Ptr<Virt5gcLoadSource> source = GetLoadSource();
 		Time time = Simulator::Now();
 
 		int cpuLoad, memLoad, diskLoad;
 		int comp;
-		std::list<Virt5gcNode>::iterator itor;
+		std::vector<Virt5gcNode>::iterator itor;
 		for (itor = nodeList.begin(); itor != nodeList.end(); itor++)
 		{
 			comp = (*itor).GetComponent();
@@ -329,30 +413,53 @@ namespace ns3 {
 				memLoad = ((*itor).GetMemInfo()).second;
 				diskLoad = ((*itor).GetDiskInfo()).second;
 
-				std::normal_distribution<double> distribution(cpuLoad, loadStd);
-				cpuLoad = distribution(generator);
-				while (cpuLoad < 0)
-					cpuLoad = distribution(generator);
+				source->Update(time, (*itor).GetId(), cpuLoad, memLoad, diskLoad);
 				(*itor).ChangeCpuLoad(cpuLoad);
-
-				std::normal_distribution<double> distribution2(memLoad, loadStd);
-				memLoad = distribution2(generator);
-				while (memLoad < 0)
-					memLoad = distribution(generator);
 				(*itor).ChangeMemLoad(memLoad);
-
-				std::normal_distribution<double> distribution3(diskLoad, loadStd);
-				diskLoad = distribution3(generator);
-				while (diskLoad < 0)
-					diskLoad = distribution(generator);
 				(*itor).ChangeDiskLoad(diskLoad);
 
-				*loadStream->GetStream() << time.GetSeconds() << " " << (*itor).GetId() << " " << cpuLoad << " " << memLoad << " " << diskLoad << std::endl;
+				if (loadStream != 0)
+					*loadStream->GetStream() << time.GetSeconds() << " " << (*itor).GetId() << " " << cpuLoad << " " << memLoad << " " << diskLoad << std::endl;
 			}
 		}
 
 		Scaling();
-		Simulator::Schedule(Seconds(1.0), &Virt5gc::DynamicLoad, this);
+		Simulator::Schedule(loadInterval, &Virt5gc::DynamicLoad, this);
+	}
+
+	void
+	Virt5gc::SetLoadSourceType (std::string type)
+	{
+		loadSourceFactory = ObjectFactory ();
+		loadSourceFactory.SetTypeId(type);
+		loadSource = 0;
+	}
+
+	std::string
+	Virt5gc::GetLoadSourceType (void) const
+	{
+		return loadSourceFactory.GetTypeId().GetName();
+	}
+
+	void
+	Virt5gc::SetLoadSourceAttribute (std::string n, const AttributeValue &v)
+	{
+		NS_ASSERT_MSG(loadSource == 0, "Load source already created");
+		loadSourceFactory.Set(n, v);
+	}
+
+	Ptr<Virt5gcLoadSource>
+	Virt5gc::GetLoadSource (void)
+	{
+		if (loadSource == 0)
+			loadSource = loadSourceFactory.Create<Virt5gcLoadSource> ();
+		return loadSource;
+	}
+
+	int64_t
+	Virt5gc::AssignStreams (int64_t stream)
+	{
+		return GetLoadSource()->AssignStreams(stream);
 	}
 
 	void
@@ -390,18 +497,110 @@ namespace ns3 {
 		return delay;
 	}
 
+	void
+	Virt5gc::AddPgwInstance (int vmId, int cpuSize, int tor)
+	{
+		uint32_t instance = epcHelper->AddPgwInstance(GetPgwInstanceRate(cpuSize), pgwQueueSize);
+		pgwInstances[vmId] = instance;
+		pgwInstanceVms[instance] = vmId;
+		// the links of the SGW/PGW stay on the rack of its first VM
+		if (pgwTor < 0)
+			pgwTor = tor;
+		SetPgwInstanceRack(instance, tor);
+	}
+
+	/* The packets of an instance on another rack than the links of the
+	 * SGW/PGW cross the aggregation switches on their way to it and back */
+	void
+	Virt5gc::SetPgwInstanceRack (uint32_t instance, int tor)
+	{
+		Time delay = GetPlacement()->GetForwardingDelay(pgwTor, tor);
+		NS_LOG_INFO ("PGW instance " << instance << " on ToR " << tor << ", forwarding delay " << delay.GetMicroSeconds() << "us");
+		epcHelper->SetPgwInstanceForwardingDelay(instance, delay);
+	}
+
+	void
+	Virt5gc::PgwWorkerChange (uint64_t imsi, uint32_t from, uint32_t to)
+	{
+		UeMove move;
+		move.imsi = imsi;
+		move.from = from;
+		move.to = to;
+		ueMoves.push_back(move);
+	}
+
+	/* Rate of the inter-VM link, limited by the free bandwidth of both VMs
+	 * and by the rack link between them */
+	DataRate
+	Virt5gc::GetVmLinkRate (int srcVm, int dstVm)
+	{
+		Virt5gcVm *src = vmRegistry.Find(srcVm);
+		Virt5gcVm *dst = vmRegistry.Find(dstVm);
+		NS_ASSERT_MSG(src != 0 && dst != 0, "Unknown VM " << srcVm << " or " << dstVm);
+
+		int bw = std::min(src->GetBwInfo().first - src->GetBwInfo().second, dst->GetBwInfo().first - dst->GetBwInfo().second);
+		if (bw <= 0) {
+			NS_LOG_WARN ("No free bandwidth between VM " << srcVm << " and VM " << dstVm);
+			bw = 1;
+		}
+		DataRate rate (vmBwUnit.GetBitRate() * bw);
+		DataRate link = GetPlacement()->GetLinkRate(src->GetToRId(), dst->GetToRId());
+		return link < rate ? link : rate;
+	}
+
+	/* Transfer the session state of the UEs moved to another PGW instance
+	 * by a scaling event, and stall their data plane until it arrived.
+	 * The contexts sharing a link are sent one after the other. Returns
+	 * the longest transfer time [s]. */
+	double
+	Virt5gc::MigrateUeContexts (void)
+	{
+		std::list<UeMove> moves;
+		moves.swap(ueMoves);
+		if (epcHelper == 0 || moves.empty())
+			return 0;
+
+		Ptr<EpcSgwPgwApplication> pgw = epcHelper->GetSgwPgwApplication();
+		std::map<std::pair<int, int>, Time> linkBusy;
+		Time longest;
+		uint64_t bytes = 0;
+		std::list<UeMove>::iterator itor;
+		for (itor = moves.begin(); itor != moves.end(); itor++) {
+			std::map<uint32_t, int>::iterator src = pgwInstanceVms.find((*itor).from);
+			std::map<uint32_t, int>::iterator dst = pgwInstanceVms.find((*itor).to);
+			// a UE without instance has no state on a VM
+			if (src == pgwInstanceVms.end() || dst == pgwInstanceVms.end())
+				continue;
+
+			uint32_t size = pgw->GetUeContextSize((*itor).imsi);
+			Time &busy = linkBusy[std::make_pair(src->second, dst->second)];
+			busy += GetVmLinkRate(src->second, dst->second).CalculateBytesTxTime(size);
+			pgw->StartMigration((*itor).imsi, busy);
+			if (busy > longest)
+				longest = busy;
+			bytes += size;
+		}
+
+		NS_LOG_INFO ("Migrated " << moves.size() << " UE contexts (" << bytes << " bytes) in " << longest.GetSeconds() << "s");
+		return longest.GetSeconds();
+	}
+
+	DataRate
+	Virt5gc::GetPgwInstanceRate (int cpuSize)
+	{
+		return DataRate(pgwRatePerCpu.GetBitRate() * cpuSize);
+	}
+
 	/* Find a VM list using VM IDs */
 	std::list<Virt5gcVm*>
 	Virt5gc::GetNodeVms(std::list<int> vms)
 	{
 		std::list<Virt5gcVm*> tempVms;
-		std::list<Virt5gcVm>::iterator itor;
-		std::list<int>::iterator itor2;
-		for (itor = vmList.begin(); itor != vmList.end(); itor++) {
-			for (itor2 = vms.begin(); itor2 != vms.end(); itor2++) {
-				if (*itor2 == (*itor).GetVmId())
-					tempVms.push_back(&(*itor));
-			}
+		std::list<int>::iterator itor;
+		for (itor = vms.begin(); itor != vms.end(); itor++) {
+			Virt5gcVm *vm = vmRegistry.Find(*itor);
+			if (vm != 0)
+				tempVms.push_back(vm);
 		}
 		return tempVms;
 	}
@@ -565,187 +764,218 @@ namespace ns3 {
 	static GlobalValue g_time = GlobalValue ("scalingTime", "scaling time", TimeValue(Time(0)), MakeTimeChecker());
 
 	void
-	Virt5gc::Scaling (void)
+	Virt5gc::SetScalingPolicyType (std::string type)
 	{
-		std::list<Virt5gcVm*>::iterator itor2;
-		std::list<Virt5gcVm>::iterator it;
-		it = vmList.end();
-		--it;
-		int lastVmId = (*it).GetVmId();
-
-		bool outFlag = false;
-		int inFlag, comp;
-		std::list<Virt5gcNode>::iterator itor;
-		double mme_delay = 0, pgw_delay = 0;
-
-		Time time = Simulator::Now();
-		for (itor = nodeList.begin(); itor != nodeList.end(); itor++) {
-			comp = (*itor).GetComponent();
-			//mme_delay = 0.0;
-			//pgw_delay = 0.0;
-			inFlag = 0;
-			outFlag = false;
-
-			// mme
-			if (comp == 0) {
-
-				std::pair<int, int> cpuInfo = (*itor).GetCpuInfo();
-				std::pair<int, int> diskInfo = (*itor).GetDiskInfo();
-				std::pair<int, int> memInfo = (*itor).GetMemInfo();
-
-				//std::cout << "mme " << cpuInfo.first << " " << cpuInfo.second << " " << diskInfo.first << " " << diskInfo.second << " " << memInfo.first << " " << memInfo.second << "\n";
-
-				// check scale out of memory or cpu or disk 
-				if ((memInfo.first < memInfo.second) || (cpuInfo.first < cpuInfo.second) || (diskInfo.first < diskInfo.second)) {
-					outFlag = true;
-				}
-				else {
-					if ((memInfo.first-memInfo.second) >= (memInfo.first/mmeVmN))
-						inFlag++;
-					if ((cpuInfo.first-cpuInfo.second) >= (cpuInfo.first/mmeVmN)) 
-						inFlag++;
-					if ((diskInfo.first-diskInfo.second) >= (diskInfo.first/mmeVmN))
-						inFlag++;
-				}
-				
-				// do scale out
-				if (outFlag) {
-					std::list<int> vms = (*itor).GetVms();
-					std::list<Virt5gcVm*> tempVms = GetNodeVms(vms);
-					itor2 = tempVms.begin();
-					Virt5gcVm newVm = **itor2;
-					newVm.SetId(++lastVmId);
-					tempVms.push_back(&newVm);
-					
-					mme_delay = scaleOut(&tempVms, cpuInfo, memInfo, diskInfo);
-
-					vmList.push_back(newVm);
-					
-					(*itor).SetVm(lastVmId);
-					(*itor).SetMemInfo(memInfo.first + (memInfo.first/mmeVmN), memInfo.second);
-					(*itor).SetCpuInfo(cpuInfo.first + (cpuInfo.first/mmeVmN), cpuInfo.second);
-					(*itor).SetDiskInfo(diskInfo.first + (diskInfo.first/mmeVmN), diskInfo.second);
-					mmeVmN++;
-
-					*scalingStream->GetStream() << time.GetSeconds() << ", " << (*itor).GetId() << ", 0, " << mme_delay << std::endl;
-
-				}
-				
-				// do scale in
-				if (inFlag == 3) {
-					std::list<int> vms = (*itor).GetVms();
-					std::list<Virt5gcVm*> tempVms = GetNodeVms(vms);
-					itor2 = tempVms.end();
-					--itor2;
-
-					(*itor).DeleteVm((**itor2).GetVmId());
-					vmList.remove(**itor2);
-					tempVms.remove(*itor2);
-
-					mme_delay = scaleIn(&tempVms, cpuInfo, memInfo, diskInfo);
-					//g_delay.SetValue(DoubleValue(mme_delay));
-					//g_time.SetValue(TimeValue(time));
+		scalingPolicyFactory = ObjectFactory ();
+		scalingPolicyFactory.SetTypeId(type);
+		scalingPolicy = 0;
+	}
 
-					(*itor).SetMemInfo(memInfo.first - (memInfo.first/mmeVmN), memInfo.second);
-					(*itor).SetCpuInfo(cpuInfo.first - (cpuInfo.first/mmeVmN), cpuInfo.second);
-					(*itor).SetDiskInfo(diskInfo.first - (diskInfo.first/mmeVmN), diskInfo.second);
+	std::string
+	Virt5gc::GetScalingPolicyType (void) const
+	{
+		return scalingPolicyFactory.GetTypeId().GetName();
+	}
 
-					mmeVmN--;
-					*scalingStream->GetStream() << time.GetSeconds() << ", " << (*itor).GetId() << ", 1, " << mme_delay << std::endl;
+	void
+	Virt5gc::SetScalingPolicyAttribute (std::string n, const AttributeValue &v)
+	{
+		NS_ASSERT_MSG(scalingPolicy == 0, "Scaling policy already created");
+		scalingPolicyFactory.Set(n, v);
+	}
 
-				}
+	Ptr<Virt5gcScalingPolicy>
+	Virt5gc::GetScalingPolicy (void)
+	{
+		if (scalingPolicy == 0)
+			scalingPolicy = scalingPolicyFactory.Create<Virt5gcScalingPolicy> ();
+		return scalingPolicy;
+	}
 
-/*
-				std::list<Virt5gcVm>::iterator it;
-				for (it = vmList.begin(); it != vmList.end(); it++)
-				{
-					std::cout << "MME! " << "ID: " << (*it).GetVmId() << ", ToR: " << (*it).GetToRId() << ", Pm: " << (*it).GetPmId() << ", NodeId: " << (*it).GetNodeId() << std::endl;
-					std::cout << "Cpu Cap: " << (*it).GetCpuInfo().first << ", load: " << (*it).GetCpuInfo().second << ", Mem Cap: " << (*it).GetMemInfo().first << ", load: " << (*it).GetMemInfo().second << ", Disk Cap: " << (*it).GetDiskInfo().first << ", load: " << (*it).GetDiskInfo().second << ", Bw Cap: " << (*it).GetBwInfo().first  << "\n" << std::endl;
-				}
-*/
+	void
+	Virt5gc::PgwWorkerDelay (uint32_t workerId, Time delay)
+	{
+		std::pair<uint32_t, Time> &acc = pgwDelays[workerId];
+		acc.first++;
+		acc.second += delay;
+	}
 
+	Virt5gcScalingInput
+	Virt5gc::GetScalingInput (Virt5gcNode &node)
+	{
+		Virt5gcScalingInput input;
+		input.now = Simulator::Now();
+		input.nodeId = node.GetId();
+		input.component = node.GetComponent();
+		std::list<int> vms = node.GetVms();
+		input.vmCount = vms.size();
+		input.cpuInfo = node.GetCpuInfo();
+		input.memInfo = node.GetMemInfo();
+		input.diskInfo = node.GetDiskInfo();
+
+		Time sum;
+		std::list<int>::iterator itor;
+		for (itor = vms.begin(); itor != vms.end(); itor++) {
+			std::map<int, uint32_t>::iterator instIt = pgwInstances.find(*itor);
+			if (instIt == pgwInstances.end())
+				continue;
+			std::map<uint32_t, std::pair<uint32_t, Time> >::iterator accIt = pgwDelays.find(instIt->second);
+			if (accIt != pgwDelays.end()) {
+				input.queueSamples += accIt->second.first;
+				sum += accIt->second.second;
 			}
+		}
+		if (input.queueSamples > 0)
+			input.queueDelay = sum / input.queueSamples;
+		return input;
+	}
 
-			// pgw/sgw
-			else if (comp == 1) {
-
-				std::pair<int, int> cpuInfo = (*itor).GetCpuInfo();
-				std::pair<int, int> diskInfo = (*itor).GetDiskInfo();
-				std::pair<int, int> memInfo = (*itor).GetMemInfo();
-
-				//std::cout << "pgw " << cpuInfo.first << " " << cpuInfo.second << " " << diskInfo.first << " " << diskInfo.second << " " << memInfo.first << " " << memInfo.second << "\n";
-
-				
-				if ((memInfo.first < memInfo.second) || (cpuInfo.first < cpuInfo.second) || (diskInfo.first < diskInfo.second)) {
-					outFlag = true;
-				}
-				else {
-					if ((memInfo.first-memInfo.second) >= (memInfo.first/mmeVmN))
-						inFlag++;
-					if ((cpuInfo.first-cpuInfo.second) >= (cpuInfo.first/mmeVmN)) 
-						inFlag++;
-					if ((diskInfo.first-diskInfo.second) >= (diskInfo.first/mmeVmN))
-						inFlag++;
-				}
-	
-				if (outFlag) {
-					std::list<int> vms = (*itor).GetVms();
-					std::list<Virt5gcVm*> tempVms = GetNodeVms(vms);
-					itor2 = tempVms.begin();
-
-					Virt5gcVm newVm = **itor2;
-					newVm.SetId(++lastVmId);
-					tempVms.push_back(&newVm);
-					
-					pgw_delay = scaleOut(&tempVms, cpuInfo, memInfo, diskInfo);
-
-					vmList.push_back(newVm);
-					(*itor).SetVm(lastVmId);
-					(*itor).SetMemInfo(memInfo.first + (memInfo.first/pgwVmN), memInfo.second);
-					(*itor).SetCpuInfo(cpuInfo.first + (cpuInfo.first/pgwVmN), cpuInfo.second);
-					(*itor).SetDiskInfo(diskInfo.first + (diskInfo.first/pgwVmN), diskInfo.second);
-					pgwVmN++;
-
-					*scalingStream->GetStream() << time.GetSeconds() << ", " << (*itor).GetId() << ", 0, " << pgw_delay << std::endl;
-				}
-
-				// do scale in
-				if (inFlag == 3) {
-					std::list<int> vms = (*itor).GetVms();
-					std::list<Virt5gcVm*> tempVms = GetNodeVms(vms);
-					itor2 = tempVms.end();
-					--itor2;
+	double
+	Virt5gc::ScaleOutNode (uint32_t nodeIndex)
+	{
+		Virt5gcNode &node = nodeList[nodeIndex];
+		std::pair<int, int> cpuInfo = node.GetCpuInfo();
+		std::pair<int, int> diskInfo = node.GetDiskInfo();
+		std::pair<int, int> memInfo = node.GetMemInfo();
+		int vmN = node.GetVms().size();
+		int lastVmId = vmRegistry.GetMaxVmId();
+
+		// the new VM is a copy of the first VM of the node, on the PM
+		// picked by the placement
+		std::list<Virt5gcVm*> tempVms = GetNodeVms(node.GetVms());
+		Virt5gcVm newVm = *tempVms.front();
+		newVm.SetId(++lastVmId);
+		int tor, pm;
+		GetPlacement()->PlaceVm(newVm, tempVms, tor, pm);
+		newVm.ChangeToR(tor);
+		newVm.ChangePm(pm);
+		int srcTor = tempVms.front()->GetToRId();
+		tempVms.push_back(&newVm);
+
+		double delay = scaleOut(&tempVms, cpuInfo, memInfo, diskInfo);
+		// the load reaches a VM of a remote rack more slowly
+		delay = allocDelay + (delay - allocDelay) / GetPlacement()->GetRackFactor(srcTor, tor);
+
+		vmRegistry.Add(newVm);
+		vmNodeIndex[lastVmId] = nodeIndex;
+		if (node.GetComponent() == 1 && epcHelper != 0) {
+			// the SGW/PGW scaling time is the VM allocation plus the transfer
+			// of the UE contexts moved to the new instance
+			AddPgwInstance(lastVmId, newVm.GetCpuInfo().first, tor);
+			ueMoves.clear();
+			epcHelper->RebalancePgwInstances();
+			delay = allocDelay + MigrateUeContexts();
+		}
 
-					(*itor).DeleteVm((**itor2).GetVmId());
-					vmList.remove(**itor2);
-					tempVms.remove(*itor2);
+		node.SetVm(lastVmId);
+		node.SetMemInfo(memInfo.first + (memInfo.first/vmN), memInfo.second);
+		node.SetCpuInfo(cpuInfo.first + (cpuInfo.first/vmN), cpuInfo.second);
+		node.SetDiskInfo(diskInfo.first + (diskInfo.first/vmN), diskInfo.second);
+		if (node.GetComponent() == 0)
+			mmeVmN++;
+		else
+			pgwVmN++;
+		return delay;
+	}
 
-					pgw_delay = scaleIn(&tempVms, cpuInfo, memInfo, diskInfo);
-					//g_delay.SetValue(DoubleValue(pgw_delay));
-					//g_time.SetValue(TimeValue(time));
+	double
+	Virt5gc::ScaleInNode (uint32_t nodeIndex)
+	{
+		Virt5gcNode &node = nodeList[nodeIndex];
+		std::pair<int, int> cpuInfo = node.GetCpuInfo();
+		std::pair<int, int> diskInfo = node.GetDiskInfo();
+		std::pair<int, int> memInfo = node.GetMemInfo();
+		int vmN = node.GetVms().size();
+
+		// the placement picks the VM to remove
+		std::list<Virt5gcVm*> tempVms = GetNodeVms(node.GetVms());
+		Virt5gcVm *victim = GetPlacement()->SelectScaleInVm(tempVms);
+		int removedVmId = victim->GetVmId();
+		int victimTor = victim->GetToRId();
+		tempVms.remove(victim);
+
+		double delay = scaleIn(&tempVms, cpuInfo, memInfo, diskInfo);
+		delay /= GetPlacement()->GetRackFactor(victimTor, tempVms.back()->GetToRId());
+
+		// the UE contexts leave the VM before it is released
+		std::map<int, uint32_t>::iterator instIt = pgwInstances.find(removedVmId);
+		if (instIt != pgwInstances.end() && epcHelper != 0) {
+			ueMoves.clear();
+			epcHelper->RemovePgwInstance(instIt->second);
+			delay = MigrateUeContexts();
+			pgwInstanceVms.erase(instIt->second);
+			pgwInstances.erase(instIt);
+		}
 
-					(*itor).SetMemInfo(memInfo.first - (memInfo.first/pgwVmN), memInfo.second);
-					(*itor).SetCpuInfo(cpuInfo.first - (cpuInfo.first/pgwVmN), cpuInfo.second);
-					(*itor).SetDiskInfo(diskInfo.first - (diskInfo.first/pgwVmN), diskInfo.second);
+		node.DeleteVm(removedVmId);
+		vmRegistry.Remove(vmRegistry.Lookup(removedVmId));
+		vmNodeIndex.erase(removedVmId);
+
+		// pack a VM left alone on its PM onto another PM (memory size in MB)
+		int tor, pm;
+		Virt5gcVm *packed = GetPlacement()->SelectConsolidation(tempVms, tor, pm);
+		if (packed != 0) {
+			double memBits = packed->GetMemInfo().first * 8e6;
+			Time copy = Seconds(memBits / GetPlacement()->GetLinkRate(packed->GetToRId(), tor).GetBitRate());
+			NS_LOG_INFO ("VM " << packed->GetVmId() << " moved from PM " << packed->GetPmId() << " to PM " << pm << " in " << copy.GetSeconds() << "s");
+			Virt5gcVmRegistry::Handle handle = vmRegistry.Lookup(packed->GetVmId());
+			vmRegistry.ChangeToR(handle, tor);
+			vmRegistry.ChangePm(handle, pm);
+			delay += copy.GetSeconds();
+			std::map<int, uint32_t>::iterator packedIt = pgwInstances.find(packed->GetVmId());
+			if (packedIt != pgwInstances.end() && epcHelper != 0)
+				SetPgwInstanceRack(packedIt->second, tor);
+		}
 
-					pgwVmN--;
+		node.SetMemInfo(memInfo.first - (memInfo.first/vmN), memInfo.second);
+		node.SetCpuInfo(cpuInfo.first - (cpuInfo.first/vmN), cpuInfo.second);
+		node.SetDiskInfo(diskInfo.first - (diskInfo.first/vmN), diskInfo.second);
+		if (node.GetComponent() == 0)
+			mmeVmN--;
+		else
+			pgwVmN--;
+		return delay;
+	}
 
-					*scalingStream->GetStream() << time.GetSeconds() << ", " << (*itor).GetId() << ", 1, " << pgw_delay << std::endl;	
-				}
+	void
+	Virt5gc::Scaling (void)
+	{
+		Ptr<Virt5gcScalingPolicy> policy = GetScalingPolicy();
+		double mme_delay = 0, pgw_delay = 0;
+		Time time = Simulator::Now();
 
-				
-							/*
-				std::list<Virt5gcVm>::iterator it;
-				for (it = vmList.begin(); it != vmList.end(); it++)
-				{
-					std::cout << "ID: " << (*it).GetVmId() << ", ToR: " << (*it).GetToRId() << ", Pm: " << (*it).GetPmId() << ", NodeId: " << (*it).GetNodeId() << std::endl;
-					std::cout << "Cpu Cap: " << (*it).GetCpuInfo().first << ", load: " << (*it).GetCpuInfo().second << ", Mem Cap: " << (*it).GetMemInfo().first << ", load: " << (*it).GetMemInfo().second << ", Disk Cap: " << (*it).GetDiskInfo().first << ", load: " << (*it).GetDiskInfo().second << ", Bw Cap: " << (*it).GetBwInfo().first << "\n" << std::endl;
-				}
-*/				
-			}
+		for (uint32_t i = 0; i < nodeList.size(); i++) {
+			int comp = nodeList[i].GetComponent();
+			if (comp != 0 && comp != 1)
+				continue;
+
+			Virt5gcScalingInput input = GetScalingInput(nodeList[i]);
+			Virt5gcScalingPolicy::Decision decision = policy->Decide(input);
+			// the last VM of a node is never removed
+			if (decision == Virt5gcScalingPolicy::SCALE_IN && input.vmCount <= 1)
+				decision = Virt5gcScalingPolicy::NONE;
+			m_scalingDecisionTrace(input, decision);
+			if (decision == Virt5gcScalingPolicy::NONE)
+				continue;
+
+			NS_LOG_INFO ("Node " << input.nodeId << (decision == Virt5gcScalingPolicy::SCALE_OUT ? " scale out" : " scale in"));
+			double delay;
+			if (decision == Virt5gcScalingPolicy::SCALE_OUT)
+				delay = ScaleOutNode(i);
+			else
+				delay = ScaleInNode(i);
+			policy->NotifyScaled(input.nodeId, decision, time);
+
+			if (comp == 0)
+				mme_delay = delay;
+			else
+				pgw_delay = delay;
+
+			if (scalingStream != 0)
+				*scalingStream->GetStream() << time.GetSeconds() << ", " << input.nodeId << ", " << (decision == Virt5gcScalingPolicy::SCALE_IN) << ", " << delay << std::endl;
 		}
+		pgwDelays.clear();
 
-		
 		if (mme_delay > pgw_delay) {
 			g_delay.SetValue(DoubleValue(mme_delay));
 			g_time.SetValue(TimeValue(time));
@@ -831,7 +1061,18 @@ namespace ns3 {
 	std::list<Virt5gcVm>
 	Virt5gc::GetVmList (void)
 	{
-		return vmList; 
+		std::list<Virt5gcVm> vms;
+		for (uint32_t i = 0; i < vmRegistry.GetNSlots(); i++) {
+			if (vmRegistry.IsValid(i))
+				vms.push_back(*vmRegistry.Get(i));
+		}
+		return vms;
+	}
+
+	Virt5gcVmRegistry&
+	Virt5gc::GetVmRegistry (void)
+	{
+		return vmRegistry;
 	}
 
 	std::istream&
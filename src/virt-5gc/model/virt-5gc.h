@@ -3,6 +3,9 @@
 #define VIRT_5GC_H
 
 #include <list>
+#include <map>
+#include <vector>
+#include <unordered_map>
 
 #include "ns3/object.h"
 #include "ns3/node-container.h"
@@ -19,11 +22,13 @@
 
 #include <math.h>
 #include <iostream>
-#include <chrono>
-#include <random>
 
 #include "virt-5gc-node.h"
 #include "virt-5gc-vm.h"
+#include "virt-5gc-vm-registry.h"
+#include "virt-5gc-scaling-policy.h"
+#include "virt-5gc-load-source.h"
+#include "virt-5gc-placement.h"
 
 namespace ns3 {
 
@@ -53,24 +58,60 @@ namespace ns3 {
 			NetDeviceContainer GetEnbDevs (void);
 			NetDeviceContainer GetUeDevs (void);
 			std::list<Virt5gcVm> GetVmList (void);
+			Virt5gcVmRegistry& GetVmRegistry (void);
+			Ptr<Virt5gcPlacement> GetPlacement (void);
+			void AddNode (Virt5gcNode node); // register a node of the topology
+			void AddVm (Virt5gcVm vm); // register a VM and attach it to its node
 
 			void DynamicLoadInit (double std);
 			void DynamicLoad (void);
+			void SetLoadSourceType (std::string type);
+			std::string GetLoadSourceType (void) const;
+			void SetLoadSourceAttribute (std::string n, const AttributeValue &v);
+			Ptr<Virt5gcLoadSource> GetLoadSource (void);
+			int64_t AssignStreams (int64_t stream);
 			void SetMigrationRate (double scaleIn, double scaleOut);
 			void SetAllocationDelay (double delay);
 			void Scaling (void);
+			void SetScalingPolicyType (std::string type);
+			std::string GetScalingPolicyType (void) const;
+			void SetScalingPolicyAttribute (std::string n, const AttributeValue &v);
+			Ptr<Virt5gcScalingPolicy> GetScalingPolicy (void);
 			double scaleIn(std::list<Virt5gcVm*> *vms, std::pair<int, int> cpuInfo, std::pair<int, int> memInfo, std::pair<int, int> diskInfo);
 			double scaleOut(std::list<Virt5gcVm*> *vms, std::pair<int, int> cpuInfo, std::pair<int, int> memInfo, std::pair<int, int> diskInfo);	
 			//double memMigration(std::list<Virt5gcVm*> *vms, int capa, int load, bool in);
 			double ScalingDelay (bool in, int migratedLoad, int bw, int mem);
 			std::list<Virt5gcVm*> GetNodeVms(std::list<int> vms);
+			double MigrateUeContexts (void);
+			DataRate GetVmLinkRate (int srcVm, int dstVm);
+			DataRate GetPgwInstanceRate (int cpuSize);
 
 			TracedCallback<uint32_t> m_scalingTrace;
+
+			typedef void (* ScalingDecisionTracedCallback)
+				(const Virt5gcScalingInput &input, Virt5gcScalingPolicy::Decision decision);
+
 		private:
+			Virt5gcScalingInput GetScalingInput (Virt5gcNode &node);
+			double ScaleOutNode (uint32_t nodeIndex);
+			double ScaleInNode (uint32_t nodeIndex);
+			void PgwWorkerDelay (uint32_t workerId, Time delay);
+			void PgwWorkerChange (uint64_t imsi, uint32_t from, uint32_t to);
+			void AddPgwInstance (int vmId, int cpuSize, int tor);
+			void SetPgwInstanceRack (uint32_t instance, int tor);
+
+			struct UeMove
+			{
+				uint64_t imsi;
+				uint32_t from; // PGW instances
+				uint32_t to;
+			};
+
 			std::string m_inputFile;
 			std::string m_topoFile;
 
-			std::list<Virt5gcNode> nodeList;
+			std::vector<Virt5gcNode> nodeList;
+			std::unordered_map<int, uint32_t> vmNodeIndex; // VM ID -> index in nodeList
 			std::list<std::pair<int, int>> nodeMapping;
 			NodeContainer enbNodes;
 			NodeContainer ueNodes;
@@ -79,8 +120,21 @@ namespace ns3 {
 			Ptr<LteHelper> lteHelper;
 			//Ptr<PointToPointEpcHelper> epcHelper;
 			Ptr<OvsPointToPointEpcHelper> epcHelper;
-			std::list<Virt5gcVm> vmList;
+			Virt5gcVmRegistry vmRegistry;
+			Ptr<Virt5gcPlacement> placement;
 			std::list<std::pair<int, int>> vm_nodeList;
+			std::map<int, uint32_t> pgwInstances; // VM ID -> SGW/PGW worker instance
+			std::map<uint32_t, int> pgwInstanceVms; // SGW/PGW worker instance -> VM ID
+			int pgwTor; // rack of the S1-U and SGi links of the SGW/PGW, -1 until its first VM
+			std::list<UeMove> ueMoves; // UEs moved by the current scaling event
+			DataRate vmBwUnit;
+			DataRate pgwRatePerCpu;
+			uint32_t pgwQueueSize;
+			std::map<uint32_t, std::pair<uint32_t, Time> > pgwDelays; // PGW instance -> packets, summed delay since the last tick
+
+			ObjectFactory scalingPolicyFactory;
+			Ptr<Virt5gcScalingPolicy> scalingPolicy;
+			TracedCallback<const Virt5gcScalingInput &, Virt5gcScalingPolicy::Decision> m_scalingDecisionTrace;
 
 			int pgwN;
 			int mmeN;
@@ -88,6 +142,9 @@ namespace ns3 {
 			int ueN;
 			int totAttr;
 			int loadStd;
+			Time loadInterval;
+			ObjectFactory loadSourceFactory;
+			Ptr<Virt5gcLoadSource> loadSource;
 			int mmeVmN;
 			int pgwVmN;
 
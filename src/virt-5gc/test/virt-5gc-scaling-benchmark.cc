@@ -0,0 +1,92 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+
+#include "ns3/virt-5gc.h"
+#include "ns3/simulator.h"
+#include "ns3/test.h"
+
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+
+using namespace ns3;
+
+// Time the periodic load update and scaling decision of Virt5gc over a
+// virtualized core of a given number of VMs (10 VMs per MME/PGW node,
+// 8 VMs per PM, 40 VMs per ToR)
+class Virt5gcScalingBenchmarkTestCase : public TestCase
+{
+public:
+  Virt5gcScalingBenchmarkTestCase (uint32_t nVms, uint32_t nTicks);
+
+private:
+  virtual void DoRun (void);
+
+  uint32_t m_nVms;
+  uint32_t m_nTicks;
+};
+
+Virt5gcScalingBenchmarkTestCase::Virt5gcScalingBenchmarkTestCase (uint32_t nVms, uint32_t nTicks)
+  : TestCase ("Virt5gc DynamicLoad + Scaling with " + std::to_string (nVms) + " VMs"),
+    m_nVms (nVms),
+    m_nTicks (nTicks)
+{
+}
+
+void
+Virt5gcScalingBenchmarkTestCase::DoRun (void)
+{
+  Ptr<Virt5gc> virt5gc = CreateObject<Virt5gc> ();
+
+  uint32_t nNodes = std::max<uint32_t> (2, m_nVms / 10);
+  for (uint32_t n = 0; n < nNodes; n++)
+    {
+      Virt5gcNode node (n + 1, 0, 0, n % 2);
+      for (uint32_t v = n; v < m_nVms; v += nNodes)
+        {
+          node.SetVm (v + 1);
+        }
+      virt5gc->AddNode (node);
+    }
+  for (uint32_t v = 0; v < m_nVms; v++)
+    {
+      Virt5gcVm vm (v + 1, v / 40, v / 8);
+      // mix of overloaded and underloaded VMs to trigger both scaling directions
+      vm.SetCpuInfo (200, 60 + (v % 7) * 30);
+      vm.SetMemInfo (512, 500);
+      vm.SetDiskInfo (3000, 1900);
+      vm.SetBwInfo (10000, 9500);
+      virt5gc->AddVm (vm);
+    }
+  NS_TEST_ASSERT_MSG_EQ (virt5gc->GetVmRegistry ().GetN (), m_nVms, "VMs not registered");
+
+  Simulator::Schedule (Seconds (1.0), &Virt5gc::DynamicLoad, virt5gc);
+  Simulator::Stop (Seconds (m_nTicks + 0.5));
+
+  std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now ();
+  Simulator::Run ();
+  std::chrono::steady_clock::time_point end = std::chrono::steady_clock::now ();
+  double elapsedUs = std::chrono::duration_cast<std::chrono::microseconds> (end - start).count ();
+
+  std::cout << "Virt5gc DynamicLoad+Scaling: " << m_nVms << " VMs, "
+            << m_nTicks << " ticks, " << elapsedUs / m_nTicks << " us/tick, "
+            << virt5gc->GetVmRegistry ().GetN () << " VMs at the end" << std::endl;
+
+  Simulator::Destroy ();
+}
+
+class Virt5gcScalingBenchmarkTestSuite : public TestSuite
+{
+public:
+  Virt5gcScalingBenchmarkTestSuite ();
+};
+
+Virt5gcScalingBenchmarkTestSuite::Virt5gcScalingBenchmarkTestSuite ()
+  : TestSuite ("virt-5gc-scaling-benchmark", PERFORMANCE)
+{
+  AddTestCase (new Virt5gcScalingBenchmarkTestCase (10, 100), TestCase::QUICK);
+  AddTestCase (new Virt5gcScalingBenchmarkTestCase (100, 100), TestCase::QUICK);
+  AddTestCase (new Virt5gcScalingBenchmarkTestCase (1000, 100), TestCase::EXTENSIVE);
+  AddTestCase (new Virt5gcScalingBenchmarkTestCase (10000, 20), TestCase::EXTENSIVE);
+}
+
+static Virt5gcScalingBenchmarkTestSuite virt5gcScalingBenchmarkTestSuite;
@@ -6,6 +6,8 @@
 // An essential include is test.h
 #include "ns3/test.h"
 
+#include <fstream>
+
 // Do not put your test classes in namespace ns3.  You may find it useful
 // to use the using directive to access the ns3 namespace directly
 using namespace ns3;
@@ -46,6 +48,249 @@ Virt5gcTestCase1::DoRun (void)
   NS_TEST_ASSERT_MSG_EQ_TOL (0.01, 0.01, 0.001, "Numbers are not equal within tolerance");
 }
 
+// Check the ID and ToR/PM indexes of the VM registry, and that handles
+// stay stable (and slots are reused) across removals
+class Virt5gcVmRegistryTestCase : public TestCase
+{
+public:
+  Virt5gcVmRegistryTestCase ();
+
+private:
+  virtual void DoRun (void);
+};
+
+Virt5gcVmRegistryTestCase::Virt5gcVmRegistryTestCase ()
+  : TestCase ("Virt5gc VM registry lookups and indexes")
+{
+}
+
+void
+Virt5gcVmRegistryTestCase::DoRun (void)
+{
+  Virt5gcVmRegistry registry;
+  std::vector<Virt5gcVmRegistry::Handle> handles;
+  for (int i = 0; i < 100; i++)
+    {
+      Virt5gcVm vm (i + 1, i / 10, i / 5);
+      vm.SetCpuInfo (200, i);
+      handles.push_back (registry.Add (vm));
+    }
+  NS_TEST_ASSERT_MSG_EQ (registry.GetN (), 100, "wrong number of VMs");
+  NS_TEST_ASSERT_MSG_EQ (registry.GetMaxVmId (), 100, "wrong max VM ID");
+  NS_TEST_ASSERT_MSG_EQ (registry.Find (42)->GetCpuInfo ().second, 41, "wrong VM found");
+  NS_TEST_ASSERT_MSG_EQ (registry.GetToRVms (3).size (), 10, "wrong ToR index");
+  NS_TEST_ASSERT_MSG_EQ (registry.GetPmVms (3).size (), 5, "wrong PM index");
+
+  registry.Remove (registry.Lookup (42));
+  NS_TEST_ASSERT_MSG_EQ (registry.Find (42), 0, "removed VM still found");
+  NS_TEST_ASSERT_MSG_EQ (registry.GetToRVms (4).size (), 9, "ToR index not updated");
+  NS_TEST_ASSERT_MSG_EQ (registry.Lookup (43), handles[42], "handle changed after a removal");
+
+  Virt5gcVm vm (101, 0, 0);
+  NS_TEST_ASSERT_MSG_EQ (registry.Add (vm), handles[41], "free slot not reused");
+  registry.ChangeToR (registry.Lookup (101), 7);
+  NS_TEST_ASSERT_MSG_EQ (registry.GetToRVms (0).size (), 10, "ToR index not updated");
+  NS_TEST_ASSERT_MSG_EQ (registry.GetToRVms (7).size (), 11, "ToR index not updated");
+  NS_TEST_ASSERT_MSG_EQ (registry.Find (101)->GetToRId (), 7, "ToR not changed");
+}
+
+// Check the decisions of the built-in scaling policies on hand-made inputs
+class Virt5gcScalingPolicyTestCase : public TestCase
+{
+public:
+  Virt5gcScalingPolicyTestCase ();
+
+private:
+  virtual void DoRun (void);
+  static Virt5gcScalingInput MakeInput (double time, int vmCount, int cpuLoad);
+};
+
+Virt5gcScalingPolicyTestCase::Virt5gcScalingPolicyTestCase ()
+  : TestCase ("Virt5gc threshold, EWMA and queue-delay scaling policies")
+{
+}
+
+Virt5gcScalingInput
+Virt5gcScalingPolicyTestCase::MakeInput (double time, int vmCount, int cpuLoad)
+{
+  Virt5gcScalingInput input;
+  input.now = Seconds (time);
+  input.nodeId = 1;
+  input.component = 1;
+  input.vmCount = vmCount;
+  input.cpuInfo = std::make_pair (100 * vmCount, cpuLoad);
+  input.memInfo = std::make_pair (100 * vmCount, 0);
+  input.diskInfo = std::make_pair (100 * vmCount, 0);
+  return input;
+}
+
+void
+Virt5gcScalingPolicyTestCase::DoRun (void)
+{
+  // default threshold policy: the original rule
+  Ptr<Virt5gcScalingPolicy> policy = CreateObject<Virt5gcThresholdScalingPolicy> ();
+  NS_TEST_ASSERT_MSG_EQ (policy->Decide (MakeInput (1, 2, 201)), Virt5gcScalingPolicy::SCALE_OUT, "over capacity not scaled out");
+  NS_TEST_ASSERT_MSG_EQ (policy->Decide (MakeInput (1, 2, 150)), Virt5gcScalingPolicy::NONE, "one VM less would overload");
+  NS_TEST_ASSERT_MSG_EQ (policy->Decide (MakeInput (1, 2, 100)), Virt5gcScalingPolicy::SCALE_IN, "idle VM not scaled in");
+  NS_TEST_ASSERT_MSG_EQ (policy->Decide (MakeInput (1, 1, 0)), Virt5gcScalingPolicy::NONE, "last VM scaled in");
+
+  // hysteresis and cooldown
+  policy->SetAttribute ("ScaleInThreshold", DoubleValue (0.8));
+  policy->SetAttribute ("Cooldown", TimeValue (Seconds (5)));
+  NS_TEST_ASSERT_MSG_EQ (policy->Decide (MakeInput (1, 2, 100)), Virt5gcScalingPolicy::NONE, "scaled in inside the hysteresis band");
+  NS_TEST_ASSERT_MSG_EQ (policy->Decide (MakeInput (1, 2, 80)), Virt5gcScalingPolicy::SCALE_IN, "not scaled in under the band");
+  policy->NotifyScaled (1, Virt5gcScalingPolicy::SCALE_IN, Seconds (1));
+  NS_TEST_ASSERT_MSG_EQ (policy->Decide (MakeInput (3, 1, 300)), Virt5gcScalingPolicy::NONE, "scaled during cooldown");
+  NS_TEST_ASSERT_MSG_EQ (policy->Decide (MakeInput (6, 1, 300)), Virt5gcScalingPolicy::SCALE_OUT, "not scaled after cooldown");
+
+  // a rising load is scaled out before it goes over capacity
+  policy = CreateObject<Virt5gcEwmaScalingPolicy> ();
+  NS_TEST_ASSERT_MSG_EQ (policy->Decide (MakeInput (1, 1, 50)), Virt5gcScalingPolicy::NONE, "scaled on the first sample");
+  NS_TEST_ASSERT_MSG_EQ (policy->Decide (MakeInput (2, 1, 70)), Virt5gcScalingPolicy::NONE, "scaled too early");
+  NS_TEST_ASSERT_MSG_EQ (policy->Decide (MakeInput (3, 1, 90)), Virt5gcScalingPolicy::NONE, "scaled too early");
+  NS_TEST_ASSERT_MSG_EQ (policy->Decide (MakeInput (4, 1, 100)), Virt5gcScalingPolicy::SCALE_OUT, "trend not forecast");
+
+  // queue delay drives the SGW/PGW, resources the MME
+  policy = CreateObject<Virt5gcQueueDelayScalingPolicy> ();
+  Virt5gcScalingInput input = MakeInput (1, 2, 0);
+  input.queueSamples = 10;
+  input.queueDelay = MilliSeconds (20);
+  NS_TEST_ASSERT_MSG_EQ (policy->Decide (input), Virt5gcScalingPolicy::SCALE_OUT, "queue delay not scaled out");
+  input.queueDelay = MicroSeconds (100);
+  NS_TEST_ASSERT_MSG_EQ (policy->Decide (input), Virt5gcScalingPolicy::SCALE_IN, "queue delay not scaled in");
+  input.component = 0;
+  input.cpuInfo.second = 250;
+  NS_TEST_ASSERT_MSG_EQ (policy->Decide (input), Virt5gcScalingPolicy::SCALE_OUT, "no fallback to resources");
+}
+
+// Replay a CSV load trace and its binary conversion, and check that the
+// random load source only depends on its stream
+class Virt5gcLoadSourceTestCase : public TestCase
+{
+public:
+  Virt5gcLoadSourceTestCase ();
+
+private:
+  virtual void DoRun (void);
+  void CheckReplay (std::string fileName);
+};
+
+Virt5gcLoadSourceTestCase::Virt5gcLoadSourceTestCase ()
+  : TestCase ("Virt5gc load trace replay and random load streams")
+{
+}
+
+void
+Virt5gcLoadSourceTestCase::CheckReplay (std::string fileName)
+{
+  Ptr<Virt5gcTraceLoadSource> source = CreateObject<Virt5gcTraceLoadSource> ();
+  source->SetFileName (fileName);
+  int cpu = 1, mem = 2, disk = 3;
+  source->Update (Seconds (0.5), 7, cpu, mem, disk);
+  NS_TEST_ASSERT_MSG_EQ (cpu, 1, "load changed before the first sample");
+  source->Update (Seconds (1.0), 7, cpu, mem, disk);
+  NS_TEST_ASSERT_MSG_EQ (cpu, 10, "first sample not replayed");
+  NS_TEST_ASSERT_MSG_EQ (disk, 30, "first sample not replayed");
+  source->Update (Seconds (2.5), 7, cpu, mem, disk);
+  NS_TEST_ASSERT_MSG_EQ (mem, 21, "second sample not replayed");
+  source->Update (Seconds (2.5), 8, cpu, mem, disk);
+  NS_TEST_ASSERT_MSG_EQ (cpu, 40, "other node not replayed");
+  source->Update (Seconds (100), 7, cpu, mem, disk);
+  NS_TEST_ASSERT_MSG_EQ (cpu, 12, "last sample not held");
+  source->Dispose ();
+}
+
+void
+Virt5gcLoadSourceTestCase::DoRun (void)
+{
+  std::string csvFile = CreateTempDirFilename ("virt-5gc-load.csv");
+  std::ofstream csv (csvFile.c_str ());
+  csv << "# time, node, cpu, mem, disk" << std::endl;
+  csv << "1.0, 7, 10, 20, 30" << std::endl;
+  csv << "2.0, 7, 11, 21, 31" << std::endl;
+  csv << "2.5 8 40 50 60" << std::endl;
+  csv << "3.0, 7, 12, 22, 32";
+  csv.close ();
+  CheckReplay (csvFile);
+
+  std::string binFile = CreateTempDirFilename ("virt-5gc-load.bin");
+  NS_TEST_ASSERT_MSG_EQ (Virt5gcTraceLoadSource::ConvertCsv (csvFile, binFile), 4, "wrong number of samples converted");
+  CheckReplay (binFile);
+
+  Ptr<Virt5gcLoadSource> a = CreateObject<Virt5gcRandomLoadSource> ();
+  Ptr<Virt5gcLoadSource> b = CreateObject<Virt5gcRandomLoadSource> ();
+  a->AssignStreams (5);
+  b->AssignStreams (5);
+  int cpuA = 100, memA = 100, diskA = 100;
+  int cpuB = 100, memB = 100, diskB = 100;
+  for (int i = 0; i < 50; i++)
+    {
+      a->Update (Seconds (i), 1, cpuA, memA, diskA);
+      b->Update (Seconds (i), 1, cpuB, memB, diskB);
+      NS_TEST_ASSERT_MSG_EQ (cpuA, cpuB, "same stream gave different loads");
+      NS_TEST_ASSERT_MSG_GT_OR_EQ (diskA, 0, "negative load");
+    }
+}
+
+// Check rack-local best-fit placement, the choice of the VM removed on
+// scale-in and the consolidation of a VM alone on its PM
+class Virt5gcPlacementTestCase : public TestCase
+{
+public:
+  Virt5gcPlacementTestCase ();
+
+private:
+  virtual void DoRun (void);
+};
+
+Virt5gcPlacementTestCase::Virt5gcPlacementTestCase ()
+  : TestCase ("Virt5gc VM placement and consolidation")
+{
+}
+
+void
+Virt5gcPlacementTestCase::DoRun (void)
+{
+  // ToR 1: PMs 10 and 11, ToR 2: PM 20; PMs hold 1000 cpu
+  Virt5gcVmRegistry registry;
+  Ptr<Virt5gcPlacement> placement = CreateObject<Virt5gcPlacement> ();
+  placement->SetVmRegistry (&registry);
+  placement->AddPm (10, 1);
+  placement->AddPm (11, 1);
+  placement->AddPm (20, 2);
+
+  Virt5gcVm vm1 (1, 1, 10);
+  vm1.SetCpuInfo (600, 0);
+  Virt5gcVm vm2 (2, 1, 11);
+  vm2.SetCpuInfo (300, 0);
+  registry.Add (vm1);
+  registry.Add (vm2);
+  std::list<Virt5gcVm*> nodeVms;
+  nodeVms.push_back (registry.Find (1));
+  nodeVms.push_back (registry.Find (2));
+
+  int tor, pm;
+  Virt5gcVm vm3 (3, 0, 0);
+  vm3.SetCpuInfo (400, 0);
+  NS_TEST_ASSERT_MSG_EQ (placement->PlaceVm (vm3, nodeVms, tor, pm), true, "VM not placed");
+  NS_TEST_ASSERT_MSG_EQ (pm, 10, "not the best-fitting PM of the rack");
+  vm3.SetCpuInfo (800, 0);
+  NS_TEST_ASSERT_MSG_EQ (placement->PlaceVm (vm3, nodeVms, tor, pm), true, "VM not placed");
+  NS_TEST_ASSERT_MSG_EQ (tor, 2, "not placed in the remote rack");
+  vm3.SetCpuInfo (1200, 0);
+  NS_TEST_ASSERT_MSG_EQ (placement->PlaceVm (vm3, nodeVms, tor, pm), false, "oversized VM placed");
+  NS_TEST_ASSERT_MSG_EQ (pm, 10, "oversized VM not on the PM of the node");
+  NS_TEST_ASSERT_MSG_GT (placement->GetRackFactor (1, 1), placement->GetRackFactor (1, 2), "inter-rack link not slower");
+
+  NS_TEST_ASSERT_MSG_EQ (placement->SelectScaleInVm (nodeVms)->GetVmId (), 2, "not the VM of the least used PM");
+  Virt5gcVm *packed = placement->SelectConsolidation (nodeVms, tor, pm);
+  NS_TEST_ASSERT_MSG_NE (packed, 0, "nothing consolidated");
+  NS_TEST_ASSERT_MSG_EQ (packed->GetVmId (), 2, "wrong VM consolidated");
+  NS_TEST_ASSERT_MSG_EQ (pm, 10, "VM not packed onto the used PM");
+  placement->SetAttribute ("Consolidation", BooleanValue (false));
+  NS_TEST_ASSERT_MSG_EQ (placement->SelectConsolidation (nodeVms, tor, pm), 0, "consolidated while disabled");
+}
+
 // The TestSuite class names the TestSuite, identifies what type of TestSuite,
 // and enables the TestCases to be run.  Typically, only the constructor for
 // this class must be defined
@@ -61,6 +306,10 @@ Virt5gcTestSuite::Virt5gcTestSuite ()
 {
   // TestDuration for TestCase can be QUICK, EXTENSIVE or TAKES_FOREVER
   AddTestCase (new Virt5gcTestCase1, TestCase::QUICK);
+  AddTestCase (new Virt5gcVmRegistryTestCase, TestCase::QUICK);
+  AddTestCase (new Virt5gcScalingPolicyTestCase, TestCase::QUICK);
+  AddTestCase (new Virt5gcLoadSourceTestCase, TestCase::QUICK);
+  AddTestCase (new Virt5gcPlacementTestCase, TestCase::QUICK);
 }
 
 // Do not forget to allocate an instance of this TestSuite